@@ -183,6 +183,27 @@ unapply_acl_vec(u32 lc_index, u32 *acls)
     hash_acl_unapply(am, lc_index, acls[i-1]);
 }
 
+/*
+ * The data-plane walks the ACL vector of a lookup context without
+ * any locking, so a replaced vector is freed only once all the workers
+ * have passed a quiescent state.
+ */
+static void
+acl_free_acl_vec (void *arg)
+{
+  u32 *acls = arg;
+  void *oldheap = acl_plugin_set_heap ();
+  vec_free(acls);
+  clib_mem_set_heap (oldheap);
+}
+
+static void
+acl_release_acl_vec (u32 *acls)
+{
+  if (acls)
+    vlib_rcu_call(acl_free_acl_vec, acls);
+}
+
 /*
  * Release the lookup context index and destroy
  * any associated data structures.
@@ -206,7 +227,8 @@ static void acl_plugin_put_lookup_context_index (u32 lc_index)
   vec_del1(am->acl_users[acontext->context_user_id].lookup_contexts, index);
   unapply_acl_vec(lc_index, acontext->acl_indices);
   unlock_acl_vec(lc_index, acontext->acl_indices);
-  vec_free(acontext->acl_indices);
+  acl_release_acl_vec(acontext->acl_indices);
+  acontext->acl_indices = 0;
   pool_put(am->acl_lookup_contexts, acontext);
   clib_mem_set_heap (oldheap);
 }
@@ -256,14 +278,17 @@ static int acl_plugin_set_acl_vec_for_context (u32 lc_index, u32 *acl_list)
 
   acontext = pool_elt_at_index(am->acl_lookup_contexts, lc_index);
   u32 *old_acl_vector = acontext->acl_indices;
-  acontext->acl_indices = vec_dup(acl_list);
+  u32 *new_acl_vector = vec_dup(acl_list);
+  /* publish the fully built vector */
+  CLIB_MEMORY_STORE_BARRIER ();
+  acontext->acl_indices = new_acl_vector;
 
   unapply_acl_vec(lc_index, old_acl_vector);
   unlock_acl_vec(lc_index, old_acl_vector);
   lock_acl_vec(lc_index, acontext->acl_indices);
   apply_acl_vec(lc_index, acontext->acl_indices);
 
-  vec_free(old_acl_vector);
+  acl_release_acl_vec(old_acl_vector);
 
 done:
   clib_bitmap_free (seen_acl_bitmap);
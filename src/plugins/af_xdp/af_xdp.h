@@ -0,0 +1,192 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _AF_XDP_H_
+#define _AF_XDP_H_
+
+#include <linux/if_xdp.h>
+#include <vlib/log.h>
+#include <vnet/interface.h>
+#include <vnet/ethernet/mac_address.h>
+
+#define foreach_af_xdp_device_flags \
+  _(0, ERROR, "error") \
+  _(1, ADMIN_UP, "admin-up") \
+  _(2, LINK_UP, "link-up") \
+  _(3, ZEROCOPY, "zero-copy")
+
+enum
+{
+#define _(a, b, c) AF_XDP_DEVICE_F_##b = (1 << a),
+  foreach_af_xdp_device_flags
+#undef _
+};
+
+/*
+ * UMEM chunks are vlib buffers: the address the kernel sees is the offset
+ * of the vlib_buffer_t from the start of the buffer memory, ie. the buffer
+ * index shifted by the cache line size. The kernel writes the packet data
+ * after a headroom of sizeof (vlib_buffer_t) + XDP_PACKET_HEADROOM and, in
+ * unaligned chunk mode, returns that data offset in the upper address bits.
+ */
+#define AF_XDP_UMEM_HEADROOM	sizeof (vlib_buffer_t)
+
+static_always_inline u64
+af_xdp_bi_to_addr (u32 bi)
+{
+  return (u64) bi << CLIB_LOG2_CACHE_LINE_BYTES;
+}
+
+static_always_inline u32
+af_xdp_addr_to_bi (u64 addr)
+{
+  return (addr & XSK_UNALIGNED_BUF_ADDR_MASK) >> CLIB_LOG2_CACHE_LINE_BYTES;
+}
+
+static_always_inline i16
+af_xdp_addr_to_current_data (u64 addr)
+{
+  return (addr >> XSK_UNALIGNED_BUF_OFFSET_SHIFT) - AF_XDP_UMEM_HEADROOM;
+}
+
+/* single producer / single consumer ring shared with the kernel */
+typedef struct
+{
+  u32 *producer;
+  u32 *consumer;
+  u32 *flags;
+  void *desc;
+  u32 mask;
+  u32 size;
+  void *map;			/* mmap()ed area, for cleanup */
+  uword map_size;
+} af_xdp_ring_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  af_xdp_ring_t rx;		/* struct xdp_desc */
+  af_xdp_ring_t fill;		/* u64 */
+  int fd;			/* AF_XDP socket, shared with txq */
+  u32 file_index;
+  u32 queue_index;
+} af_xdp_rxq_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  clib_spinlock_t lock;
+  af_xdp_ring_t tx;		/* struct xdp_desc */
+  af_xdp_ring_t completion;	/* u64 */
+  int fd;
+} af_xdp_txq_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* following fields are accessed in datapath */
+  af_xdp_rxq_t *rxqs;
+  af_xdp_txq_t *txqs;
+  u32 flags;
+  u32 per_interface_next_index;
+  u32 sw_if_index;
+  u32 hw_if_index;
+  u8 pool;			/* buffer pool index */
+
+  /* fields below are not accessed in datapath */
+  u8 *name;
+  u8 *linux_ifname;
+  int linux_ifindex;
+  mac_address_t hwaddr;
+  u32 dev_instance;
+  int xsk_map_fd;
+  int xdp_prog_fd;
+  u32 xdp_flags;
+
+  clib_error_t *error;
+} af_xdp_device_t;
+
+typedef struct
+{
+  af_xdp_device_t *devices;
+  vlib_log_class_t log_class;
+  u16 msg_id_base;
+} af_xdp_main_t;
+
+extern af_xdp_main_t af_xdp_main;
+
+typedef enum
+{
+  AF_XDP_MODE_AUTO = 0,
+  AF_XDP_MODE_COPY,
+  AF_XDP_MODE_ZERO_COPY,
+} af_xdp_mode_t;
+
+typedef struct
+{
+  u8 *linux_ifname;
+  u8 *name;
+  u32 rxq_size;
+  u32 txq_size;
+  u32 rxq_num;
+  af_xdp_mode_t mode;
+
+  /* return */
+  int rv;
+  u32 sw_if_index;
+  clib_error_t *error;
+} af_xdp_create_if_args_t;
+
+void af_xdp_create_if (vlib_main_t * vm, af_xdp_create_if_args_t * args);
+void af_xdp_delete_if (vlib_main_t * vm, af_xdp_device_t * ad);
+
+extern vlib_node_registration_t af_xdp_input_node;
+extern vnet_device_class_t af_xdp_device_class;
+
+format_function_t format_af_xdp_device;
+format_function_t format_af_xdp_device_name;
+format_function_t format_af_xdp_input_trace;
+unformat_function_t unformat_af_xdp_create_if_args;
+
+typedef struct
+{
+  u32 next_index;
+  u32 hw_if_index;
+} af_xdp_input_trace_t;
+
+#define foreach_af_xdp_tx_func_error	       \
+_(NO_FREE_SLOTS, "no free tx slots")           \
+_(CHAIN_TOO_LONG, "chained buffer linearization failed")
+
+typedef enum
+{
+#define _(f,s) AF_XDP_TX_ERROR_##f,
+  foreach_af_xdp_tx_func_error
+#undef _
+    AF_XDP_TX_N_ERROR,
+} af_xdp_tx_func_error_t;
+
+#endif /* _AF_XDP_H_ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
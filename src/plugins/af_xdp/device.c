@@ -0,0 +1,685 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+
+#include <vppinfra/linux/sysfs.h>
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/devices/netlink.h>
+
+#include <af_xdp/af_xdp.h>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+af_xdp_main_t af_xdp_main;
+
+#define af_xdp_log__(lvl, dev, f, ...) \
+  do { \
+      vlib_log((lvl), af_xdp_main.log_class, "%v: " f, \
+               (dev)->name, ##__VA_ARGS__); \
+  } while (0)
+
+#define af_xdp_log(lvl, dev, f, ...) \
+   af_xdp_log__((lvl), (dev), "%s (%d): " f, strerror(errno), errno, ##__VA_ARGS__)
+
+/*
+ * Default XDP program: redirect every packet to the AF_XDP socket bound to
+ * the receive queue, or let it through to the kernel stack if there is none.
+ *
+ *   r2 = ctx->rx_queue_index
+ *   r1 = &xsks_map
+ *   r3 = XDP_PASS
+ *   return bpf_redirect_map (r1, r2, r3)
+ */
+static int
+af_xdp_bpf (int cmd, union bpf_attr *attr)
+{
+  return syscall (__NR_bpf, cmd, attr, sizeof (*attr));
+}
+
+static clib_error_t *
+af_xdp_load_program (af_xdp_device_t * ad, u32 n_queues)
+{
+  union bpf_attr attr;
+  clib_error_t *err;
+  struct bpf_insn prog[] = {
+    {.code = BPF_LDX | BPF_W | BPF_MEM,.dst_reg = BPF_REG_2,
+     .src_reg = BPF_REG_1,.off = STRUCT_OFFSET_OF (struct xdp_md,
+						  rx_queue_index)},
+    {.code = BPF_LD | BPF_DW | BPF_IMM,.dst_reg = BPF_REG_1,
+     .src_reg = BPF_PSEUDO_MAP_FD,.imm = 0 /* map fd, set below */ },
+    {.code = 0},
+    {.code = BPF_ALU64 | BPF_MOV | BPF_K,.dst_reg = BPF_REG_3,
+     .imm = XDP_PASS},
+    {.code = BPF_JMP | BPF_CALL,.imm = BPF_FUNC_redirect_map},
+    {.code = BPF_JMP | BPF_EXIT},
+  };
+
+  clib_memset (&attr, 0, sizeof (attr));
+  attr.map_type = BPF_MAP_TYPE_XSKMAP;
+  attr.key_size = sizeof (u32);
+  attr.value_size = sizeof (int);
+  attr.max_entries = n_queues;
+  strncpy (attr.map_name, "xsks_map", sizeof (attr.map_name) - 1);
+  if ((ad->xsk_map_fd = af_xdp_bpf (BPF_MAP_CREATE, &attr)) < 0)
+    return clib_error_return_unix (0, "bpf(BPF_MAP_CREATE) failed");
+
+  prog[1].imm = ad->xsk_map_fd;
+
+  clib_memset (&attr, 0, sizeof (attr));
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.insns = pointer_to_uword (prog);
+  attr.insn_cnt = ARRAY_LEN (prog);
+  attr.license = pointer_to_uword ("Apache-2.0");
+  strncpy (attr.prog_name, "vpp_af_xdp", sizeof (attr.prog_name) - 1);
+  if ((ad->xdp_prog_fd = af_xdp_bpf (BPF_PROG_LOAD, &attr)) < 0)
+    return clib_error_return_unix (0, "bpf(BPF_PROG_LOAD) failed");
+
+  /* do not replace a program somebody else attached to the netdev */
+  ad->xdp_flags = XDP_FLAGS_UPDATE_IF_NOEXIST;
+  if ((err = vnet_netlink_set_link_xdp_fd (ad->linux_ifindex,
+					   ad->xdp_prog_fd, ad->xdp_flags)))
+    {
+      ad->xdp_flags = 0;
+      return clib_error_return (err, "cannot attach XDP program to %v "
+				"(is another program already attached?)",
+				ad->linux_ifname);
+    }
+
+  return 0;
+}
+
+static void
+af_xdp_unload_program (af_xdp_device_t * ad)
+{
+  clib_error_t *err;
+
+  if (ad->xdp_flags)
+    {
+      err = vnet_netlink_set_link_xdp_fd (ad->linux_ifindex, -1, 0);
+      if (err)
+	{
+	  af_xdp_log__ (VLIB_LOG_LEVEL_ERR, ad, "XDP program detach: %U",
+			format_clib_error, err);
+	  clib_error_free (err);
+	}
+      ad->xdp_flags = 0;
+    }
+
+  if (ad->xdp_prog_fd >= 0)
+    close (ad->xdp_prog_fd);
+  if (ad->xsk_map_fd >= 0)
+    close (ad->xsk_map_fd);
+  ad->xdp_prog_fd = ad->xsk_map_fd = -1;
+}
+
+static clib_error_t *
+af_xdp_ring_init (int fd, af_xdp_ring_t * ring,
+		  const struct xdp_ring_offset *off, u64 pgoff, u32 size,
+		  u32 desc_size)
+{
+  ring->map_size = off->desc + size * desc_size;
+  ring->map = mmap (0, ring->map_size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, fd, pgoff);
+  if (ring->map == MAP_FAILED)
+    {
+      ring->map = 0;
+      return clib_error_return_unix (0, "mmap() ring failed");
+    }
+
+  ring->producer = ring->map + off->producer;
+  ring->consumer = ring->map + off->consumer;
+  ring->flags = ring->map + off->flags;
+  ring->desc = ring->map + off->desc;
+  ring->size = size;
+  ring->mask = size - 1;
+  return 0;
+}
+
+static void
+af_xdp_ring_free (af_xdp_ring_t * ring)
+{
+  if (ring->map)
+    munmap (ring->map, ring->map_size);
+  clib_memset (ring, 0, sizeof (*ring));
+}
+
+static clib_error_t *
+af_xdp_socket_init (vlib_main_t * vm, af_xdp_device_t * ad, u16 qid,
+		    u32 rxq_size, u32 txq_size, af_xdp_mode_t mode)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  af_xdp_rxq_t *rxq;
+  af_xdp_txq_t *txq;
+  struct xdp_umem_reg umem = { 0 };
+  struct xdp_mmap_offsets off;
+  struct xdp_options opt;
+  struct sockaddr_xdp sxdp = { 0 };
+  socklen_t optlen;
+  clib_error_t *err;
+  int fd;
+
+  vec_validate_aligned (ad->rxqs, qid, CLIB_CACHE_LINE_BYTES);
+  vec_validate_aligned (ad->txqs, qid, CLIB_CACHE_LINE_BYTES);
+  rxq = vec_elt_at_index (ad->rxqs, qid);
+  txq = vec_elt_at_index (ad->txqs, qid);
+  rxq->fd = txq->fd = -1;
+  rxq->file_index = ~0;
+  rxq->queue_index = qid;
+
+  if ((fd = socket (AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0)) < 0)
+    return clib_error_return_unix (0, "socket(AF_XDP) failed");
+  rxq->fd = txq->fd = fd;
+
+  /*
+   * Register the whole vlib buffer memory as UMEM, once per device: it is
+   * pinned and charged to RLIMIT_MEMLOCK on each registration. Chunks are
+   * not aligned on their size (vlib buffers are sizeof (vlib_buffer_t) +
+   * data size apart) so we need the unaligned chunk mode (Linux >= 5.4).
+   * The other queues share it, each with its own fill and completion
+   * rings (Linux >= 5.10).
+   */
+  if (qid == 0)
+    {
+      umem.addr = bm->buffer_mem_start;
+      umem.len = bm->buffer_mem_size;
+      umem.chunk_size =
+	AF_XDP_UMEM_HEADROOM + vlib_buffer_get_default_data_size (vm);
+      umem.headroom = AF_XDP_UMEM_HEADROOM;
+      umem.flags = XDP_UMEM_UNALIGNED_CHUNK_FLAG;
+      if (setsockopt (fd, SOL_XDP, XDP_UMEM_REG, &umem, sizeof (umem)) < 0)
+	return clib_error_return_unix (0, "setsockopt(XDP_UMEM_REG) failed");
+    }
+
+#define _(opt, val) \
+  if (setsockopt (fd, SOL_XDP, opt, &val, sizeof (val)) < 0) \
+    return clib_error_return_unix (0, "setsockopt(" #opt ") failed");
+  _(XDP_UMEM_FILL_RING, rxq_size);
+  _(XDP_UMEM_COMPLETION_RING, txq_size);
+  _(XDP_RX_RING, rxq_size);
+  _(XDP_TX_RING, txq_size);
+#undef _
+
+  optlen = sizeof (off);
+  if (getsockopt (fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0)
+    return clib_error_return_unix (0, "getsockopt(XDP_MMAP_OFFSETS) failed");
+
+  if ((err = af_xdp_ring_init (fd, &rxq->rx, &off.rx, XDP_PGOFF_RX_RING,
+			       rxq_size, sizeof (struct xdp_desc))))
+    return err;
+  if ((err = af_xdp_ring_init (fd, &rxq->fill, &off.fr,
+			       XDP_UMEM_PGOFF_FILL_RING, rxq_size,
+			       sizeof (u64))))
+    return err;
+  if ((err = af_xdp_ring_init (fd, &txq->tx, &off.tx, XDP_PGOFF_TX_RING,
+			       txq_size, sizeof (struct xdp_desc))))
+    return err;
+  if ((err = af_xdp_ring_init (fd, &txq->completion, &off.cr,
+			       XDP_UMEM_PGOFF_COMPLETION_RING, txq_size,
+			       sizeof (u64))))
+    return err;
+
+  sxdp.sxdp_family = AF_XDP;
+  sxdp.sxdp_ifindex = ad->linux_ifindex;
+  sxdp.sxdp_queue_id = qid;
+  if (qid)
+    {
+      /* the mode and wakeup flags come with the UMEM */
+      sxdp.sxdp_flags = XDP_SHARED_UMEM;
+      sxdp.sxdp_shared_umem_fd = vec_elt (ad->rxqs, 0).fd;
+    }
+  else
+    {
+      sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+      switch (mode)
+	{
+	case AF_XDP_MODE_AUTO:
+	  break;
+	case AF_XDP_MODE_COPY:
+	  sxdp.sxdp_flags |= XDP_COPY;
+	  break;
+	case AF_XDP_MODE_ZERO_COPY:
+	  sxdp.sxdp_flags |= XDP_ZEROCOPY;
+	  break;
+	}
+    }
+  if (bind (fd, (struct sockaddr *) &sxdp, sizeof (sxdp)) < 0)
+    return clib_error_return_unix (0, "bind() queue %u failed", qid);
+
+  optlen = sizeof (opt);
+  if (getsockopt (fd, SOL_XDP, XDP_OPTIONS, &opt, &optlen) == 0
+      && (opt.flags & XDP_OPTIONS_ZEROCOPY))
+    ad->flags |= AF_XDP_DEVICE_F_ZEROCOPY;
+  else
+    ad->flags &= ~AF_XDP_DEVICE_F_ZEROCOPY;
+
+  {
+    union bpf_attr attr;
+    u32 key = qid;
+
+    clib_memset (&attr, 0, sizeof (attr));
+    attr.map_fd = ad->xsk_map_fd;
+    attr.key = pointer_to_uword (&key);
+    attr.value = pointer_to_uword (&fd);
+    if (af_xdp_bpf (BPF_MAP_UPDATE_ELEM, &attr) < 0)
+      return clib_error_return_unix (0, "cannot add queue %u to xsks_map",
+				     qid);
+  }
+
+  return 0;
+}
+
+/*
+ * Give back the buffers the kernel did not return. The input and tx paths
+ * never have more buffers outstanding than the fill and tx rings hold, and
+ * the kernel returns them in order, so every buffer posted and not seen
+ * back yet still has its address in its fill or tx ring slot, whether the
+ * kernel took it or not.
+ */
+static void
+af_xdp_rxq_free_bufs (vlib_main_t * vm, af_xdp_rxq_t * rxq)
+{
+  u32 bi[VLIB_FRAME_SIZE], n = 0, cons, prod;
+  const u64 *addr = rxq->fill.desc;
+
+  if (!rxq->fill.map || !rxq->rx.map)
+    return;
+
+  cons = *rxq->rx.consumer;
+  prod = *rxq->fill.producer;
+  for (; cons != prod; cons++)
+    {
+      bi[n++] = af_xdp_addr_to_bi (addr[cons & rxq->fill.mask]);
+      if (n == VLIB_FRAME_SIZE)
+	{
+	  vlib_buffer_free (vm, bi, n);
+	  n = 0;
+	}
+    }
+
+  vlib_buffer_free (vm, bi, n);
+}
+
+static void
+af_xdp_txq_free_bufs (vlib_main_t * vm, af_xdp_txq_t * txq)
+{
+  u32 bi[VLIB_FRAME_SIZE], n = 0, cons, prod;
+  const struct xdp_desc *desc = txq->tx.desc;
+
+  if (!txq->tx.map || !txq->completion.map)
+    return;
+
+  cons = *txq->completion.consumer;
+  prod = *txq->tx.producer;
+  for (; cons != prod; cons++)
+    {
+      bi[n++] = af_xdp_addr_to_bi (desc[cons & txq->tx.mask].addr);
+      if (n == VLIB_FRAME_SIZE)
+	{
+	  vlib_buffer_free (vm, bi, n);
+	  n = 0;
+	}
+    }
+
+  vlib_buffer_free (vm, bi, n);
+}
+
+static clib_error_t *
+af_xdp_rxq_read_ready (clib_file_t * f)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  af_xdp_main_t *am = &af_xdp_main;
+  u16 qid = f->private_data & 0xffff;
+  af_xdp_device_t *ad =
+    pool_elt_at_index (am->devices, f->private_data >> 16);
+
+  vnet_device_input_set_interrupt_pending (vnm, ad->hw_if_index, qid);
+  return 0;
+}
+
+static clib_error_t *
+af_xdp_rxq_interrupt_enable (af_xdp_device_t * ad, af_xdp_rxq_t * rxq)
+{
+  clib_file_t t = { 0 };
+  int fd;
+
+  if (~0 != rxq->file_index)
+    return 0;
+
+  /* the file gets closed when removed, so poll on a duplicate */
+  if ((fd = dup (rxq->fd)) < 0)
+    return clib_error_return_unix (0, "dup() failed");
+
+  t.read_function = af_xdp_rxq_read_ready;
+  t.file_descriptor = fd;
+  t.private_data = (ad->dev_instance << 16) | rxq->queue_index;
+  t.description = format (0, "%v rx %u", ad->name, rxq->queue_index);
+  rxq->file_index = clib_file_add (&file_main, &t);
+  return 0;
+}
+
+static void
+af_xdp_rxq_interrupt_disable (af_xdp_rxq_t * rxq)
+{
+  if (~0 == rxq->file_index)
+    return;
+  clib_file_del_by_index (&file_main, rxq->file_index);
+  rxq->file_index = ~0;
+}
+
+static clib_error_t *
+af_xdp_interface_rx_mode_change (vnet_main_t * vnm, u32 hw_if_index,
+				 u32 qid, vnet_hw_interface_rx_mode mode)
+{
+  af_xdp_main_t *am = &af_xdp_main;
+  vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, hw_if_index);
+  af_xdp_device_t *ad = pool_elt_at_index (am->devices, hw->dev_instance);
+  af_xdp_rxq_t *rxq = vec_elt_at_index (ad->rxqs, qid);
+
+  clib_error_t *err;
+
+  if (mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
+    {
+      af_xdp_rxq_interrupt_disable (rxq);
+      return 0;
+    }
+
+  if ((err = af_xdp_rxq_interrupt_enable (ad, rxq)))
+    return err;
+
+  /* run input once so the fill ring gets populated */
+  vnet_device_input_set_interrupt_pending (vnm, hw_if_index, qid);
+  return 0;
+}
+
+static clib_error_t *
+af_xdp_register_interface (vnet_main_t * vnm, af_xdp_device_t * ad)
+{
+  return ethernet_register_interface (vnm, af_xdp_device_class.index,
+				      ad->dev_instance, ad->hwaddr.bytes,
+				      &ad->hw_if_index, 0);
+}
+
+static void
+af_xdp_unregister_interface (vnet_main_t * vnm, af_xdp_device_t * ad)
+{
+  vnet_hw_interface_set_flags (vnm, ad->hw_if_index, 0);
+  vnet_hw_interface_unassign_rx_thread (vnm, ad->hw_if_index, 0);
+  ethernet_delete_interface (vnm, ad->hw_if_index);
+}
+
+static void
+af_xdp_dev_cleanup (vlib_main_t * vm, af_xdp_device_t * ad)
+{
+  af_xdp_main_t *am = &af_xdp_main;
+  af_xdp_rxq_t *rxq;
+  af_xdp_txq_t *txq;
+
+  /* stop redirecting packets to the sockets first */
+  af_xdp_unload_program (ad);
+
+  vec_foreach (rxq, ad->rxqs)
+  {
+    af_xdp_rxq_interrupt_disable (rxq);
+    if (rxq->fd >= 0)
+      close (rxq->fd);
+    af_xdp_rxq_free_bufs (vm, rxq);
+    af_xdp_ring_free (&rxq->rx);
+    af_xdp_ring_free (&rxq->fill);
+  }
+  vec_foreach (txq, ad->txqs)
+  {
+    af_xdp_txq_free_bufs (vm, txq);
+    af_xdp_ring_free (&txq->tx);
+    af_xdp_ring_free (&txq->completion);
+    clib_spinlock_free (&txq->lock);
+  }
+
+  clib_error_free (ad->error);
+
+  vec_free (ad->rxqs);
+  vec_free (ad->txqs);
+  vec_free (ad->name);
+  vec_free (ad->linux_ifname);
+  pool_put (am->devices, ad);
+}
+
+static clib_error_t *
+af_xdp_dev_init (vlib_main_t * vm, af_xdp_device_t * ad, u32 rxq_size,
+		 u32 txq_size, u32 rxq_num, af_xdp_mode_t mode)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  clib_error_t *err;
+  u32 i;
+
+  ethernet_mac_address_generate (ad->hwaddr.bytes);
+
+  if ((err = af_xdp_load_program (ad, rxq_num)))
+    return err;
+
+  /* one socket per queue pair, tx queues are shared by threads if needed */
+  for (i = 0; i < rxq_num; i++)
+    if ((err = af_xdp_socket_init (vm, ad, i, rxq_size, txq_size, mode)))
+      return clib_error_return (err, "queue %u", i);
+
+  if (rxq_num < tm->n_vlib_mains)
+    for (i = 0; i < rxq_num; i++)
+      clib_spinlock_init (&vec_elt (ad->txqs, i).lock);
+
+  return 0;
+}
+
+void
+af_xdp_create_if (vlib_main_t * vm, af_xdp_create_if_args_t * args)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  af_xdp_main_t *am = &af_xdp_main;
+  af_xdp_device_t *ad;
+  vnet_sw_interface_t *sw;
+  vnet_hw_interface_t *hw;
+  int ifindex, numa_node = 0;
+  u8 *s = 0;
+  u16 qid;
+
+  args->rxq_size = args->rxq_size ? args->rxq_size : 1024;
+  args->txq_size = args->txq_size ? args->txq_size : 1024;
+  args->rxq_num = args->rxq_num ? args->rxq_num : 1;
+
+  if (args->rxq_size < VLIB_FRAME_SIZE || args->txq_size < VLIB_FRAME_SIZE ||
+      !is_pow2 (args->rxq_size) || !is_pow2 (args->txq_size))
+    {
+      args->rv = VNET_API_ERROR_INVALID_VALUE;
+      args->error =
+	clib_error_return (0, "queue size must be a power of two >= %i",
+			   VLIB_FRAME_SIZE);
+      goto err0;
+    }
+
+  if (args->rxq_num > 0xffff)
+    {
+      args->rv = VNET_API_ERROR_INVALID_VALUE;
+      args->error = clib_error_return (0, "too many rx queues");
+      goto err0;
+    }
+
+  if (0 == (ifindex = if_nametoindex ((char *) args->linux_ifname)))
+    {
+      args->rv = VNET_API_ERROR_INVALID_INTERFACE;
+      args->error = clib_error_return_unix (0, "unknown host interface %s",
+					    args->linux_ifname);
+      goto err0;
+    }
+
+  pool_get_zero (am->devices, ad);
+  ad->dev_instance = ad - am->devices;
+  ad->per_interface_next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+  ad->linux_ifname = format (0, "%s", args->linux_ifname);
+  ad->linux_ifindex = ifindex;
+  ad->xsk_map_fd = ad->xdp_prog_fd = -1;
+
+  if (!args->name || 0 == args->name[0])
+    ad->name = format (0, "%s/%d", args->linux_ifname, ad->dev_instance);
+  else
+    ad->name = format (0, "%s", args->name);
+
+  /* virtual devices (eg. veth) have no NUMA node, default to 0 */
+  s = format (0, "/sys/class/net/%s/device/numa_node%c",
+	      args->linux_ifname, 0);
+  if ((args->error = clib_sysfs_read ((char *) s, "%d", &numa_node)))
+    {
+      clib_error_free (args->error);
+      numa_node = 0;
+    }
+  if (numa_node < 0)
+    numa_node = 0;
+  ad->pool = vlib_buffer_pool_get_default_for_numa (vm, numa_node);
+
+  if ((args->error = af_xdp_dev_init (vm, ad, args->rxq_size,
+				      args->txq_size, args->rxq_num,
+				      args->mode)))
+    goto err1;
+
+  if ((args->error = af_xdp_register_interface (vnm, ad)))
+    goto err1;
+
+  sw = vnet_get_hw_sw_interface (vnm, ad->hw_if_index);
+  hw = vnet_get_hw_interface (vnm, ad->hw_if_index);
+  args->sw_if_index = ad->sw_if_index = sw->sw_if_index;
+  hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  vnet_hw_interface_set_input_node (vnm, ad->hw_if_index,
+				    af_xdp_input_node.index);
+  vec_foreach_index (qid, ad->rxqs)
+  {
+    vnet_hw_interface_assign_rx_thread (vnm, ad->hw_if_index, qid, ~0);
+    if (vnet_hw_interface_set_rx_mode (vnm, ad->hw_if_index, qid,
+				       VNET_HW_INTERFACE_RX_MODE_DEFAULT))
+      af_xdp_log__ (VLIB_LOG_LEVEL_WARNING, ad,
+		    "unable to set rx mode for queue %u", qid);
+  }
+
+  vec_free (s);
+  return;
+
+err1:
+  af_xdp_dev_cleanup (vm, ad);
+  args->rv = args->rv ? args->rv : VNET_API_ERROR_INVALID_INTERFACE;
+err0:
+  vec_free (s);
+  vlib_log_err (am->log_class, "%U", format_clib_error, args->error);
+}
+
+void
+af_xdp_delete_if (vlib_main_t * vm, af_xdp_device_t * ad)
+{
+  af_xdp_unregister_interface (vnet_get_main (), ad);
+  af_xdp_dev_cleanup (vm, ad);
+}
+
+static clib_error_t *
+af_xdp_interface_admin_up_down (vnet_main_t * vnm, u32 hw_if_index,
+				u32 flags)
+{
+  vnet_hw_interface_t *hi = vnet_get_hw_interface (vnm, hw_if_index);
+  af_xdp_main_t *am = &af_xdp_main;
+  af_xdp_device_t *ad = pool_elt_at_index (am->devices, hi->dev_instance);
+  uword is_up = (flags & VNET_SW_INTERFACE_FLAG_ADMIN_UP) != 0;
+
+  if (ad->flags & AF_XDP_DEVICE_F_ERROR)
+    return clib_error_return (0, "device is in error state");
+
+  if (is_up)
+    {
+      vnet_hw_interface_set_flags (vnm, ad->hw_if_index,
+				   VNET_HW_INTERFACE_FLAG_LINK_UP);
+      ad->flags |= AF_XDP_DEVICE_F_ADMIN_UP | AF_XDP_DEVICE_F_LINK_UP;
+    }
+  else
+    {
+      vnet_hw_interface_set_flags (vnm, ad->hw_if_index, 0);
+      ad->flags &= ~(AF_XDP_DEVICE_F_ADMIN_UP | AF_XDP_DEVICE_F_LINK_UP);
+    }
+  return 0;
+}
+
+static void
+af_xdp_set_interface_next_node (vnet_main_t * vnm, u32 hw_if_index,
+				u32 node_index)
+{
+  af_xdp_main_t *am = &af_xdp_main;
+  vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, hw_if_index);
+  af_xdp_device_t *ad = pool_elt_at_index (am->devices, hw->dev_instance);
+  ad->per_interface_next_index =
+    ~0 ==
+    node_index ? VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT :
+    vlib_node_add_next (vlib_get_main (), af_xdp_input_node.index,
+			node_index);
+}
+
+static char *af_xdp_tx_func_error_strings[] = {
+#define _(n,s) s,
+  foreach_af_xdp_tx_func_error
+#undef _
+};
+
+/* *INDENT-OFF* */
+VNET_DEVICE_CLASS (af_xdp_device_class) =
+{
+  .name = "AF_XDP interface",
+  .format_device = format_af_xdp_device,
+  .format_device_name = format_af_xdp_device_name,
+  .admin_up_down_function = af_xdp_interface_admin_up_down,
+  .rx_redirect_to_node = af_xdp_set_interface_next_node,
+  .rx_mode_change_function = af_xdp_interface_rx_mode_change,
+  .tx_function_n_errors = AF_XDP_TX_N_ERROR,
+  .tx_function_error_strings = af_xdp_tx_func_error_strings,
+};
+/* *INDENT-ON* */
+
+clib_error_t *
+af_xdp_init (vlib_main_t * vm)
+{
+  af_xdp_main_t *am = &af_xdp_main;
+
+  am->log_class = vlib_log_register_class ("af_xdp", 0);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (af_xdp_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,356 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <sys/socket.h>
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/devices/devices.h>
+
+#include <af_xdp/af_xdp.h>
+
+#define foreach_af_xdp_input_error \
+  _(BUFFER_ALLOC, "buffer alloc error") \
+  _(SYSCALL_FAILURES, "syscall (recvfrom) failures")
+
+typedef enum
+{
+#define _(f,s) AF_XDP_INPUT_ERROR_##f,
+  foreach_af_xdp_input_error
+#undef _
+    AF_XDP_INPUT_N_ERROR,
+} af_xdp_input_error_t;
+
+static __clib_unused char *af_xdp_input_error_strings[] = {
+#define _(n,s) s,
+  foreach_af_xdp_input_error
+#undef _
+};
+
+static_always_inline void
+af_xdp_device_input_refill (vlib_main_t * vm, vlib_node_runtime_t * node,
+			    const af_xdp_device_t * ad, af_xdp_rxq_t * rxq)
+{
+  af_xdp_ring_t *fill = &rxq->fill;
+  u32 bis[VLIB_FRAME_SIZE], *bi = bis;
+  u64 *addr = fill->desc;
+  u32 n_alloc, n, prod, slot;
+
+refill:
+  bi = bis;
+  prod = *fill->producer;
+  /* no more buffers out than the fill ring holds, including the ones the
+     kernel took, so that they can be reclaimed from it on delete */
+  n_alloc = fill->size - (prod - *rxq->rx.consumer);
+  n_alloc = clib_min (VLIB_FRAME_SIZE, n_alloc);
+
+  /* do not bother to allocate if too small */
+  if (n_alloc < 16)
+    goto kick;
+
+  n = vlib_buffer_alloc_from_pool (vm, bis, n_alloc, ad->pool);
+  if (PREDICT_FALSE (n < n_alloc))
+    {
+      vlib_error_count (vm, node->node_index,
+			AF_XDP_INPUT_ERROR_BUFFER_ALLOC, n_alloc - n);
+      if (0 == n)
+	goto kick;
+    }
+  n_alloc = n;
+
+  slot = prod & fill->mask;
+  while (n >= 4 && slot + 4 <= fill->size)
+    {
+      addr[slot + 0] = af_xdp_bi_to_addr (bi[0]);
+      addr[slot + 1] = af_xdp_bi_to_addr (bi[1]);
+      addr[slot + 2] = af_xdp_bi_to_addr (bi[2]);
+      addr[slot + 3] = af_xdp_bi_to_addr (bi[3]);
+      slot += 4;
+      bi += 4;
+      n -= 4;
+    }
+
+  while (n >= 1)
+    {
+      addr[slot & fill->mask] = af_xdp_bi_to_addr (bi[0]);
+      slot += 1;
+      bi += 1;
+      n -= 1;
+    }
+
+  __atomic_store_n (fill->producer, prod + n_alloc, __ATOMIC_RELEASE);
+
+  /* keep going until the ring is full, eg. on the first poll */
+  if (n_alloc == VLIB_FRAME_SIZE)
+    goto refill;
+
+kick:
+  /* the driver stopped waiting for buffers, kick it */
+  if (PREDICT_FALSE (*fill->flags & XDP_RING_NEED_WAKEUP))
+    if (recvfrom (rxq->fd, 0, 0, MSG_DONTWAIT, 0, 0) < 0
+	&& errno != EAGAIN && errno != EBUSY && errno != ENOBUFS)
+      vlib_error_count (vm, node->node_index,
+			AF_XDP_INPUT_ERROR_SYSCALL_FAILURES, 1);
+}
+
+static_always_inline void
+af_xdp_device_input_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
+			   const af_xdp_device_t * ad, u32 n_left,
+			   const u32 * bi, u32 next_index)
+{
+  u32 n_trace;
+
+  if (PREDICT_TRUE (0 == (n_trace = vlib_get_trace_count (vm, node))))
+    return;
+
+  while (n_trace && n_left)
+    {
+      vlib_buffer_t *b;
+      af_xdp_input_trace_t *tr;
+      b = vlib_get_buffer (vm, bi[0]);
+      vlib_trace_buffer (vm, node, next_index, b,
+			 /* follow_chain */ 0);
+      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+      tr->next_index = next_index;
+      tr->hw_if_index = ad->hw_if_index;
+
+      /* next */
+      n_trace--;
+      n_left--;
+      bi++;
+    }
+  vlib_set_trace_count (vm, node, n_trace);
+}
+
+static_always_inline void
+af_xdp_device_input_ethernet (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      const af_xdp_device_t * ad, u32 next_index)
+{
+  vlib_next_frame_t *nf;
+  vlib_frame_t *f;
+  ethernet_input_frame_t *ef;
+
+  if (PREDICT_FALSE (VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT != next_index))
+    return;
+
+  nf =
+    vlib_node_runtime_get_next_frame (vm, node,
+				      VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT);
+  f = vlib_get_frame (vm, nf->frame);
+  f->flags = ETH_INPUT_FRAME_F_SINGLE_SW_IF_IDX;
+
+  ef = vlib_frame_scalar_args (f);
+  ef->sw_if_index = ad->sw_if_index;
+  ef->hw_if_index = ad->hw_if_index;
+}
+
+/*
+ * Received descriptors point into vlib buffers we posted on the fill ring,
+ * so there is nothing to copy: recover the buffer index and data offset
+ * from the UMEM address and fill in the buffer metadata.
+ */
+static_always_inline u32
+af_xdp_device_input_bufs (vlib_main_t * vm, u32 * to_next,
+			  const struct xdp_desc *desc, u32 n_left_from,
+			  vlib_buffer_t * bt)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 n_rx_bytes[4] = { 0 };
+  u32 n = n_left_from, *bi = to_next;
+
+  while (n >= 4)
+    {
+      bi[0] = af_xdp_addr_to_bi (desc[0].addr);
+      bi[1] = af_xdp_addr_to_bi (desc[1].addr);
+      bi[2] = af_xdp_addr_to_bi (desc[2].addr);
+      bi[3] = af_xdp_addr_to_bi (desc[3].addr);
+      bi += 4;
+      desc += 4;
+      n -= 4;
+    }
+  while (n >= 1)
+    {
+      bi[0] = af_xdp_addr_to_bi (desc[0].addr);
+      bi += 1;
+      desc += 1;
+      n -= 1;
+    }
+
+  desc -= n_left_from;
+  vlib_get_buffers (vm, to_next, bufs, n_left_from);
+
+  while (n_left_from >= 4)
+    {
+      if (PREDICT_TRUE (n_left_from >= 8))
+	{
+	  vlib_prefetch_buffer_header (b[4 + 0], STORE);
+	  vlib_prefetch_buffer_header (b[4 + 1], STORE);
+	  vlib_prefetch_buffer_header (b[4 + 2], STORE);
+	  vlib_prefetch_buffer_header (b[4 + 3], STORE);
+	}
+
+      vlib_buffer_copy_template (b[0], bt);
+      vlib_buffer_copy_template (b[1], bt);
+      vlib_buffer_copy_template (b[2], bt);
+      vlib_buffer_copy_template (b[3], bt);
+
+      b[0]->current_data = af_xdp_addr_to_current_data (desc[0].addr);
+      b[1]->current_data = af_xdp_addr_to_current_data (desc[1].addr);
+      b[2]->current_data = af_xdp_addr_to_current_data (desc[2].addr);
+      b[3]->current_data = af_xdp_addr_to_current_data (desc[3].addr);
+
+      b[0]->current_length = desc[0].len;
+      b[1]->current_length = desc[1].len;
+      b[2]->current_length = desc[2].len;
+      b[3]->current_length = desc[3].len;
+
+      n_rx_bytes[0] += desc[0].len;
+      n_rx_bytes[1] += desc[1].len;
+      n_rx_bytes[2] += desc[2].len;
+      n_rx_bytes[3] += desc[3].len;
+
+      b += 4;
+      desc += 4;
+      n_left_from -= 4;
+    }
+
+  while (n_left_from >= 1)
+    {
+      vlib_buffer_copy_template (b[0], bt);
+      b[0]->current_data = af_xdp_addr_to_current_data (desc[0].addr);
+      b[0]->current_length = desc[0].len;
+      n_rx_bytes[0] += desc[0].len;
+
+      b += 1;
+      desc += 1;
+      n_left_from -= 1;
+    }
+
+  return n_rx_bytes[0] + n_rx_bytes[1] + n_rx_bytes[2] + n_rx_bytes[3];
+}
+
+static_always_inline uword
+af_xdp_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			    vlib_frame_t * frame, af_xdp_device_t * ad,
+			    u16 qid)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  af_xdp_rxq_t *rxq = vec_elt_at_index (ad->rxqs, qid);
+  af_xdp_ring_t *rx = &rxq->rx;
+  const struct xdp_desc *desc = rx->desc;
+  vlib_buffer_t bt;
+  u32 next_index, *to_next, n_left_to_next;
+  u32 n_rx_packets, n_rx_bytes;
+  u32 cons, slot, n_tail;
+
+  cons = *rx->consumer;
+  /* pairs with the kernel release store of the producer */
+  n_rx_packets = __atomic_load_n (rx->producer, __ATOMIC_ACQUIRE) - cons;
+  n_rx_packets = clib_min (n_rx_packets, VLIB_FRAME_SIZE);
+
+  if (PREDICT_FALSE (0 == n_rx_packets))
+    {
+      af_xdp_device_input_refill (vm, node, ad, rxq);
+      return 0;
+    }
+
+  /* init buffer template */
+  clib_memset_u64 (&bt, 0,
+		   STRUCT_OFFSET_OF (vlib_buffer_t,
+				     template_end) / sizeof (u64));
+  vnet_buffer (&bt)->sw_if_index[VLIB_RX] = ad->sw_if_index;
+  vnet_buffer (&bt)->sw_if_index[VLIB_TX] = ~0;
+  bt.buffer_pool_index = ad->pool;
+  bt.ref_count = 1;
+
+  /* update buffer template for input feature arcs if any */
+  next_index = ad->per_interface_next_index;
+  if (PREDICT_FALSE (vnet_device_input_have_features (ad->sw_if_index)))
+    vnet_feature_start_device_input_x1 (ad->sw_if_index, &next_index, &bt);
+
+  vlib_get_new_next_frame (vm, node, next_index, to_next, n_left_to_next);
+  ASSERT (n_rx_packets <= n_left_to_next);
+
+  /* avoid wrap-around logic in core loop */
+  slot = cons & rx->mask;
+  n_tail = clib_min (n_rx_packets, rx->size - slot);
+  n_rx_bytes =
+    af_xdp_device_input_bufs (vm, &to_next[0], &desc[slot], n_tail, &bt);
+  if (n_tail < n_rx_packets)
+    n_rx_bytes +=
+      af_xdp_device_input_bufs (vm, &to_next[n_tail], &desc[0],
+				n_rx_packets - n_tail, &bt);
+
+  /* descriptors are consumed, give the slots back to the kernel */
+  __atomic_store_n (rx->consumer, cons + n_rx_packets, __ATOMIC_RELEASE);
+
+  af_xdp_device_input_ethernet (vm, node, ad, next_index);
+
+  vlib_put_next_frame (vm, node, next_index, n_left_to_next - n_rx_packets);
+
+  af_xdp_device_input_trace (vm, node, ad, n_rx_packets, to_next,
+			     next_index);
+
+  vlib_increment_combined_counter
+    (vnm->interface_main.combined_sw_if_counters +
+     VNET_INTERFACE_COUNTER_RX, vm->thread_index,
+     ad->hw_if_index, n_rx_packets, n_rx_bytes);
+
+  af_xdp_device_input_refill (vm, node, ad, rxq);
+
+  return n_rx_packets;
+}
+
+VLIB_NODE_FN (af_xdp_input_node) (vlib_main_t * vm,
+				  vlib_node_runtime_t * node,
+				  vlib_frame_t * frame)
+{
+  u32 n_rx = 0;
+  af_xdp_main_t *am = &af_xdp_main;
+  vnet_device_input_runtime_t *rt = (void *) node->runtime_data;
+  vnet_device_and_queue_t *dq;
+
+  foreach_device_and_queue (dq, rt->devices_and_queues)
+  {
+    af_xdp_device_t *ad;
+    ad = pool_elt_at_index (am->devices, dq->dev_instance);
+    if (PREDICT_TRUE (ad->flags & AF_XDP_DEVICE_F_ADMIN_UP))
+      n_rx += af_xdp_device_input_inline (vm, node, frame, ad, dq->queue_id);
+  }
+  return n_rx;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (af_xdp_input_node) = {
+  .name = "af_xdp-input",
+  .flags = VLIB_NODE_FLAG_TRACE_SUPPORTED,
+  .sibling_of = "device-input",
+  .format_trace = format_af_xdp_input_trace,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+  .n_errors = AF_XDP_INPUT_N_ERROR,
+  .error_strings = af_xdp_input_error_strings,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
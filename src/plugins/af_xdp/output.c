@@ -0,0 +1,204 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <sys/socket.h>
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/devices/devices.h>
+
+#include <af_xdp/af_xdp.h>
+
+static_always_inline void
+af_xdp_device_output_free (vlib_main_t * vm, af_xdp_txq_t * txq)
+{
+  af_xdp_ring_t *cr = &txq->completion;
+  const u64 *addr = cr->desc;
+  u32 bis[VLIB_FRAME_SIZE], *bi = bis;
+  u32 cons, n_free, n, slot;
+
+  cons = *cr->consumer;
+  /* pairs with the kernel release store of the producer */
+  n_free = __atomic_load_n (cr->producer, __ATOMIC_ACQUIRE) - cons;
+  n = n_free = clib_min (n_free, VLIB_FRAME_SIZE);
+
+  if (0 == n_free)
+    return;
+
+  slot = cons & cr->mask;
+  while (n >= 4 && slot + 4 <= cr->size)
+    {
+      bi[0] = af_xdp_addr_to_bi (addr[slot + 0]);
+      bi[1] = af_xdp_addr_to_bi (addr[slot + 1]);
+      bi[2] = af_xdp_addr_to_bi (addr[slot + 2]);
+      bi[3] = af_xdp_addr_to_bi (addr[slot + 3]);
+      slot += 4;
+      bi += 4;
+      n -= 4;
+    }
+
+  while (n >= 1)
+    {
+      bi[0] = af_xdp_addr_to_bi (addr[slot & cr->mask]);
+      slot += 1;
+      bi += 1;
+      n -= 1;
+    }
+
+  __atomic_store_n (cr->consumer, cons + n_free, __ATOMIC_RELEASE);
+  vlib_buffer_free (vm, bis, n_free);
+}
+
+/*
+ * Buffers are handed to the kernel as they are: the descriptor address is
+ * the UMEM offset of the vlib_buffer_t with the offset of the current data
+ * in the upper bits (unaligned chunk mode), the buffer is freed once it
+ * shows up on the completion ring.
+ */
+static_always_inline u32
+af_xdp_device_output_tx (vlib_main_t * vm, vlib_node_runtime_t * node,
+			 af_xdp_txq_t * txq, u32 n_left_from, u32 * bi)
+{
+  af_xdp_ring_t *tx = &txq->tx;
+  struct xdp_desc *desc = tx->desc;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 prod, slot, n, n_tx = 0;
+
+  prod = *tx->producer;
+  /* do not enqueue more packets than the ring holds until they complete,
+     so that they can be reclaimed from it on delete */
+  n_left_from = clib_min (n_left_from, tx->size -
+			  (prod - *txq->completion.consumer));
+
+  /* if ring is full, do nothing */
+  if (PREDICT_FALSE (0 == n_left_from))
+    return 0;
+
+  vlib_get_buffers (vm, bi, bufs, n_left_from);
+  n = n_left_from;
+  slot = prod & tx->mask;
+
+  while (n >= 1)
+    {
+      if (PREDICT_TRUE (n >= 5))
+	vlib_prefetch_buffer_header (b[4], LOAD);
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_NEXT_PRESENT))
+	{
+	  /* the kernel only takes single descriptor packets */
+	  if (!vlib_buffer_chain_linearize (vm, b[0])
+	      || (b[0]->flags & VLIB_BUFFER_NEXT_PRESENT))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				AF_XDP_TX_ERROR_CHAIN_TOO_LONG, 1);
+	      vlib_buffer_free_one (vm, bi[0]);
+	      goto next;
+	    }
+	}
+
+      desc[slot & tx->mask].addr = af_xdp_bi_to_addr (bi[0]) |
+	((u64) (AF_XDP_UMEM_HEADROOM + b[0]->current_data) <<
+	 XSK_UNALIGNED_BUF_OFFSET_SHIFT);
+      desc[slot & tx->mask].len = b[0]->current_length;
+      desc[slot & tx->mask].options = 0;
+      slot += 1;
+      n_tx += 1;
+
+    next:
+      b += 1;
+      bi += 1;
+      n -= 1;
+    }
+
+  __atomic_store_n (tx->producer, prod + n_tx, __ATOMIC_RELEASE);
+
+  return n_left_from;
+}
+
+/*
+ * Copy mode and some drivers need a syscall to start sending. In copy mode
+ * the kernel sends a batch of descriptors per call (32 as of Linux 5.4),
+ * so keep kicking while some are pending, a frame's worth at most.
+ */
+static_always_inline void
+af_xdp_device_output_kick (af_xdp_txq_t * txq)
+{
+  af_xdp_ring_t *tx = &txq->tx;
+  int i;
+
+  for (i = 0; i < VLIB_FRAME_SIZE / 32; i++)
+    {
+      if (!(*tx->flags & XDP_RING_NEED_WAKEUP)
+	  || __atomic_load_n (tx->consumer, __ATOMIC_ACQUIRE) == *tx->producer)
+	return;
+      if (sendto (txq->fd, 0, 0, MSG_DONTWAIT, 0, 0) < 0
+	  && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS)
+	return;
+    }
+}
+
+VNET_DEVICE_CLASS_TX_FN (af_xdp_device_class) (vlib_main_t * vm,
+					       vlib_node_runtime_t * node,
+					       vlib_frame_t * frame)
+{
+  af_xdp_main_t *am = &af_xdp_main;
+  vnet_interface_output_runtime_t *ord = (void *) node->runtime_data;
+  af_xdp_device_t *ad = pool_elt_at_index (am->devices, ord->dev_instance);
+  u32 thread_index = vm->thread_index;
+  af_xdp_txq_t *txq =
+    vec_elt_at_index (ad->txqs, thread_index % vec_len (ad->txqs));
+  u32 *from;
+  u32 n_left_from;
+  int i;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+
+  clib_spinlock_lock_if_init (&txq->lock);
+
+  for (i = 0; i < 5 && n_left_from > 0; i++)
+    {
+      u32 n_enq;
+      af_xdp_device_output_free (vm, txq);
+      n_enq = af_xdp_device_output_tx (vm, node, txq, n_left_from, from);
+      af_xdp_device_output_kick (txq);
+      n_left_from -= n_enq;
+      from += n_enq;
+    }
+
+  /* reclaim what the kernel is done with while we hold the lock */
+  af_xdp_device_output_free (vm, txq);
+
+  clib_spinlock_unlock_if_init (&txq->lock);
+
+  if (PREDICT_FALSE (n_left_from))
+    {
+      vlib_buffer_free (vm, from, n_left_from);
+      vlib_error_count (vm, node->node_index,
+			AF_XDP_TX_ERROR_NO_FREE_SLOTS, n_left_from);
+    }
+
+  return frame->n_vectors - n_left_from;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,97 @@
+import unittest
+
+from framework import VppTestRunner
+from vpp_papi import VppEnum
+from template_veth import TestVethHost, veth_access
+
+VPP_IF = "vpp-xdp0"
+HOST_IF = "host-xdp0"
+
+
+@unittest.skipUnless(veth_access(VPP_IF, HOST_IF), "Requires root and veth")
+class TestAfXdp(TestVethHost):
+    """ AF_XDP Test Case """
+
+    vpp_if = VPP_IF
+    host_if = HOST_IF
+    vpp_ip4 = "10.99.99.1"
+    host_ip4 = "10.99.99.2"
+
+    def create_af_xdp(self, **kwargs):
+        rv = self.vapi.af_xdp_create(host_if=VPP_IF, name="xdp0", **kwargs)
+        self.assertEqual(rv.retval, 0)
+        self.created.append(rv.sw_if_index)
+        return rv.sw_if_index
+
+    def delete_interface(self, sw_if_index):
+        self.vapi.af_xdp_delete(sw_if_index=sw_if_index)
+
+    def delete_af_xdp(self, sw_if_index):
+        self.delete_interface(sw_if_index)
+        self.created.remove(sw_if_index)
+
+    def test_af_xdp_create_delete(self):
+        """ AF_XDP create/delete """
+        sw_if_index = self.create_af_xdp(rxq_num=1)
+        self.assertIn("xdp0", self.vapi.cli("show interface"))
+        self.assertIn(VPP_IF, self.vapi.cli("show hardware-interfaces xdp0"))
+        self.delete_af_xdp(sw_if_index)
+        self.assertNotIn("xdp0", self.vapi.cli("show interface"))
+
+        # the XDP program must have been detached: create again
+        self.delete_af_xdp(self.create_af_xdp())
+
+    def test_af_xdp_copy_mode(self):
+        """ AF_XDP copy mode on a driver without zero-copy """
+        mode = VppEnum.vl_api_af_xdp_mode_t
+
+        # veth has no zero-copy support, the socket cannot be bound
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.af_xdp_create(host_if=VPP_IF, name="xdp0",
+                                    mode=mode.AF_XDP_API_MODE_ZERO_COPY)
+        self.assertNotIn("xdp0", self.vapi.cli("show interface"))
+
+        # and auto falls back to copying into the UMEM
+        self.create_af_xdp(mode=mode.AF_XDP_API_MODE_AUTO)
+        self.assertNotIn("zero-copy",
+                         self.vapi.cli("show hardware-interfaces xdp0"))
+
+    def _ping_host(self, rx_mode):
+        """ route pings from pg0 to the Linux end of the veth """
+        self.create_af_xdp(rxq_size=256, txq_size=256)
+        self.assertIn("rx ring 256, tx ring 256",
+                      self.vapi.cli("show hardware-interfaces xdp0"))
+        self.config_host_route("xdp0", rx_mode)
+
+        # bursts the rings hold, more packets in total than the rings do:
+        # the UMEM buffers cycle through the fill, rx, tx and completion
+        # rings
+        for i in range(8):
+            self.ping_host(64)
+
+    def test_af_xdp_ping_polling(self):
+        """ AF_XDP ping in polling mode """
+        self._ping_host("polling")
+
+    def test_af_xdp_ping_interrupt(self):
+        """ AF_XDP ping in interrupt mode """
+        self._ping_host("interrupt")
+
+    def test_af_xdp_umem_reclaim(self):
+        """ AF_XDP UMEM buffers given back on delete """
+        n_used = self.get_buffers_used()
+
+        # the fill ring is stocked on the first poll
+        sw_if_index = self.create_af_xdp(rxq_size=256, txq_size=256)
+        self.config_host_route("xdp0", "polling")
+        self.ping_host(64)
+        self.assertGreaterEqual(self.get_buffers_used(), n_used + 256 - 16)
+
+        # including the ones the kernel holds
+        self.vapi.cli("set interface state xdp0 down")
+        self.delete_af_xdp(sw_if_index)
+        self.assertEqual(self.get_buffers_used(), n_used)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -21,6 +21,7 @@
 #include <avf/virtchnl.h>
 
 #include <vlib/log.h>
+#include <vnet/flow/flow.h>
 
 #define AVF_AQ_ENQ_SUSPEND_TIME		50e-6
 #define AVF_AQ_ENQ_MAX_WAIT_TIME	250e-3
@@ -34,6 +35,7 @@
 #define AVF_RXD_STATUS(x)		(1ULL << x)
 #define AVF_RXD_STATUS_DD		AVF_RXD_STATUS(0)
 #define AVF_RXD_STATUS_EOP		AVF_RXD_STATUS(1)
+#define AVF_RXD_STATUS_FLM		AVF_RXD_STATUS(11)
 #define AVF_RXD_ERROR_SHIFT		19
 #define AVF_RXD_PTYPE_SHIFT		30
 #define AVF_RXD_LEN_SHIFT		38
@@ -42,6 +44,11 @@
 #define AVF_RXD_ERROR_IPE		(1ULL << (AVF_RXD_ERROR_SHIFT + 3))
 #define AVF_RXD_ERROR_L4E		(1ULL << (AVF_RXD_ERROR_SHIFT + 4))
 
+/* qword 2 extended status, qword 3 holds the flow director id */
+#define AVF_RXD_EXT_STATUS_FLEXBH_SHIFT	4
+#define AVF_RXD_EXT_STATUS_FLEXBH_MASK	3
+#define AVF_RXD_EXT_STATUS_FLEXBH_FD_ID	1
+
 #define AVF_TXD_CMD(x)			(1 << (x + 4))
 #define AVF_TXD_CMD_EOP			AVF_TXD_CMD(0)
 #define AVF_TXD_CMD_RS			AVF_TXD_CMD(1)
@@ -69,7 +76,8 @@
   _(3, VA_DMA, "vaddr-dma") \
   _(4, LINK_UP, "link-up") \
   _(5, SHARED_TXQ_LOCK, "shared-txq-lock") \
-  _(6, ELOG, "elog")
+  _(6, ELOG, "elog") \
+  _(7, RX_FLOW_OFFLOAD, "rx-flow-offload")
 
 enum
 {
@@ -143,6 +151,33 @@ typedef struct
 } avf_txq_t;
 
 typedef struct
+{
+  u32 flow_index;
+  u32 mark;
+  /* flow director rule id, returned by the PF */
+  u32 fdir_flow_id;
+} avf_flow_entry_t;
+
+typedef struct
+{
+  u32 flow_id;
+  u16 next_index;
+  i16 buffer_advance;
+} avf_flow_lookup_entry_t;
+
+struct avf_device;
+
+typedef struct
+{
+  clib_error_t *(*add_fdir_filter) (vlib_main_t * vm,
+				    struct avf_device * ad,
+				    virtchnl_fdir_add_t * fa);
+  clib_error_t *(*del_fdir_filter) (vlib_main_t * vm,
+				    struct avf_device * ad,
+				    virtchnl_fdir_del_t * fd);
+} avf_flow_backend_t;
+
+typedef struct avf_device
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u32 flags;
@@ -162,6 +197,13 @@ typedef struct
   u16 n_tx_queues;
   u16 n_rx_queues;
 
+  /* flow offload, lookup entries are indexed by the packet mark */
+  avf_flow_lookup_entry_t *flow_lookup_entries;
+  avf_flow_entry_t *flow_entries;
+  u32 *parked_lookup_indexes;
+  u64 parked_loop_count;
+  const avf_flow_backend_t *flow_backend;
+
   /* Admin queues */
   avf_aq_desc_t *atq;
   avf_aq_desc_t *arq;
@@ -214,6 +256,11 @@ typedef struct
   u64 qw1s[AVF_RX_VECTOR_SZ];
   avf_rx_tail_t tails[AVF_RX_VECTOR_SZ];
   vlib_buffer_t buffer_template;
+
+  /* flow offload */
+  u32 buffers[AVF_RX_VECTOR_SZ];
+  u16 next[AVF_RX_VECTOR_SZ];
+  u32 flow_ids[AVF_RX_VECTOR_SZ];
 } avf_per_thread_data_t;
 
 typedef struct
@@ -247,6 +294,14 @@ void avf_delete_if (vlib_main_t * vm, avf_device_t * ad);
 
 extern vlib_node_registration_t avf_input_node;
 extern vnet_device_class_t avf_device_class;
+extern const avf_flow_backend_t avf_flow_backend_virtchnl;
+
+/* flow.c */
+int avf_flow_add (vlib_main_t * vm, avf_device_t * ad, vnet_flow_t * f,
+		  uword * private_data);
+int avf_flow_del (vlib_main_t * vm, avf_device_t * ad, uword private_data);
+vnet_flow_dev_ops_function_t avf_flow_ops_fn;
+format_function_t format_avf_flow;
 
 /* format.c */
 format_function_t format_avf_device;
@@ -324,6 +379,20 @@ avf_rxd_is_not_dd (avf_rx_desc_t * d)
   return (d->qword[1] & AVF_RXD_STATUS_DD) == 0;
 }
 
+/* flow director id (the mark) of a matching packet, 0 otherwise */
+static_always_inline u32
+avf_rxd_fdir_id (avf_rx_desc_t * d)
+{
+  u32 flexbh = (d->qword[2] >> AVF_RXD_EXT_STATUS_FLEXBH_SHIFT) &
+    AVF_RXD_EXT_STATUS_FLEXBH_MASK;
+
+  if ((d->qword[1] & AVF_RXD_STATUS_FLM) == 0 ||
+      flexbh != AVF_RXD_EXT_STATUS_FLEXBH_FD_ID)
+    return 0;
+
+  return d->qword[3] >> 32;
+}
+
 typedef struct
 {
   u16 qid;
@@ -24,7 +24,9 @@
 #include <avf/avf.h>
 
 #define AVF_MBOX_LEN 64
-#define AVF_MBOX_BUF_SZ 512
+#define AVF_MBOX_BUF_SZ 4096
+/* buffers over 512 bytes need the large buffer flag */
+#define AVF_MBOX_LARGE_BUF 512
 #define AVF_RXQ_SZ 512
 #define AVF_TXQ_SZ 512
 #define AVF_ITR_INT 32
@@ -131,6 +133,8 @@ avf_aq_desc_enq (vlib_main_t * vm, avf_device_t * ad, avf_aq_desc_t * dt,
       clib_memcpy_fast (ad->atq_bufs + ad->atq_next_slot * AVF_MBOX_BUF_SZ,
 			data, len);
       d->flags |= AVF_AQ_F_BUF;
+      if (len > AVF_MBOX_LARGE_BUF)
+	d->flags |= AVF_AQ_F_LB;
     }
 
   if (ad->flags & AVF_DEVICE_F_ELOG)
@@ -331,7 +335,7 @@ avf_arq_slot_init (avf_device_t * ad, u16 slot)
   u64 pa = ad->arq_bufs_pa + slot * AVF_MBOX_BUF_SZ;
   d = &ad->arq[slot];
   clib_memset (d, 0, sizeof (avf_aq_desc_t));
-  d->flags = AVF_AQ_F_BUF;
+  d->flags = AVF_AQ_F_BUF | AVF_AQ_F_LB;
   d->datalen = AVF_MBOX_BUF_SZ;
   d->addr_hi = (u32) (pa >> 32);
   d->addr_lo = (u32) pa;
@@ -527,7 +531,8 @@ avf_op_get_vf_resources (vlib_main_t * vm, avf_device_t * ad,
   clib_error_t *err = 0;
   u32 bitmap = (VIRTCHNL_VF_OFFLOAD_L2 | VIRTCHNL_VF_OFFLOAD_RSS_PF |
 		VIRTCHNL_VF_OFFLOAD_WB_ON_ITR | VIRTCHNL_VF_OFFLOAD_VLAN |
-		VIRTCHNL_VF_OFFLOAD_RX_POLLING);
+		VIRTCHNL_VF_OFFLOAD_RX_POLLING |
+		VIRTCHNL_VF_OFFLOAD_FDIR_PF);
 
   avf_log_debug (ad, "get_vf_reqources: bitmap 0x%x", bitmap);
   err = avf_send_to_pf (vm, ad, VIRTCHNL_OP_GET_VF_RESOURCES, &bitmap,
@@ -604,6 +609,36 @@ avf_op_config_rss_key (vlib_main_t * vm, avf_device_t * ad)
 			 0);
 }
 
+static clib_error_t *
+avf_op_add_fdir_filter (vlib_main_t * vm, avf_device_t * ad,
+			virtchnl_fdir_add_t * fa)
+{
+  avf_log_debug (ad, "add_fdir_filter: vsi_id %u n_hdrs %u n_actions %u",
+		 fa->vsi_id, fa->rule_cfg.proto_hdrs.count,
+		 fa->rule_cfg.action_set.count);
+
+  return avf_send_to_pf (vm, ad, VIRTCHNL_OP_ADD_FDIR_FILTER, fa,
+			 sizeof (virtchnl_fdir_add_t), fa,
+			 sizeof (virtchnl_fdir_add_t));
+}
+
+static clib_error_t *
+avf_op_del_fdir_filter (vlib_main_t * vm, avf_device_t * ad,
+			virtchnl_fdir_del_t * fd)
+{
+  avf_log_debug (ad, "del_fdir_filter: vsi_id %u flow_id %u", fd->vsi_id,
+		 fd->flow_id);
+
+  return avf_send_to_pf (vm, ad, VIRTCHNL_OP_DEL_FDIR_FILTER, fd,
+			 sizeof (virtchnl_fdir_del_t), fd,
+			 sizeof (virtchnl_fdir_del_t));
+}
+
+const avf_flow_backend_t avf_flow_backend_virtchnl = {
+  .add_fdir_filter = avf_op_add_fdir_filter,
+  .del_fdir_filter = avf_op_del_fdir_filter,
+};
+
 clib_error_t *
 avf_op_disable_vlan_stripping (vlib_main_t * vm, avf_device_t * ad)
 {
@@ -1313,6 +1348,10 @@ avf_delete_if (vlib_main_t * vm, avf_device_t * ad)
   vec_free (ad->txqs);
   vec_free (ad->name);
 
+  pool_free (ad->flow_entries);
+  pool_free (ad->flow_lookup_entries);
+  vec_free (ad->parked_lookup_indexes);
+
   clib_error_free (ad->error);
   clib_memset (ad, 0, sizeof (*ad));
   pool_put (am->devices, ad);
@@ -1345,6 +1384,7 @@ avf_create_if (vlib_main_t * vm, avf_create_if_args_t * args)
   ad->dev_instance = ad - am->devices;
   ad->per_interface_next_index = ~0;
   ad->name = vec_dup (args->name);
+  ad->flow_backend = &avf_flow_backend_virtchnl;
 
   if (args->enable_elog)
     ad->flags |= AVF_DEVICE_F_ELOG;
@@ -1564,6 +1604,8 @@ VNET_DEVICE_CLASS (avf_device_class,) =
   .rx_redirect_to_node = avf_set_interface_next_node,
   .tx_function_n_errors = AVF_TX_N_ERROR,
   .tx_function_error_strings = avf_tx_func_error_strings,
+  .flow_ops_function = avf_flow_ops_fn,
+  .format_flow = format_avf_flow,
 };
 /* *INDENT-ON* */
 
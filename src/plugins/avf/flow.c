@@ -0,0 +1,498 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/pci/pci.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip.h>
+#include <vnet/udp/udp_packet.h>
+
+#include <avf/avf.h>
+
+#define AVF_FLOW_SUPPORTED_ACTIONS \
+  (VNET_FLOW_ACTION_MARK | VNET_FLOW_ACTION_REDIRECT_TO_NODE | \
+   VNET_FLOW_ACTION_BUFFER_ADVANCE | VNET_FLOW_ACTION_REDIRECT_TO_QUEUE | \
+   VNET_FLOW_ACTION_RSS | VNET_FLOW_ACTION_DROP)
+
+/* flow director rules are exact match, a field is matched or ignored */
+static_always_inline int
+avf_fdir_ip4_mask_is_valid (ip4_address_t * mask)
+{
+  return mask->as_u32 == 0 || mask->as_u32 == ~0;
+}
+
+static_always_inline int
+avf_fdir_ip6_mask_is_valid (ip6_address_t * mask)
+{
+  return (mask->as_u64[0] == 0 && mask->as_u64[1] == 0) ||
+    (mask->as_u64[0] == ~0ULL && mask->as_u64[1] == ~0ULL);
+}
+
+static virtchnl_proto_hdr_t *
+avf_fdir_hdr_add (virtchnl_proto_hdrs_t * hdrs,
+		  virtchnl_proto_hdr_type_t type)
+{
+  virtchnl_proto_hdr_t *hdr = hdrs->proto_hdr + hdrs->count++;
+  hdr->type = type;
+  return hdr;
+}
+
+static int
+avf_fdir_ip4 (virtchnl_proto_hdrs_t * hdrs, ip4_address_and_mask_t * src,
+	      ip4_address_and_mask_t * dst)
+{
+  virtchnl_proto_hdr_t *hdr;
+  ip4_header_t *ip4;
+
+  if (!avf_fdir_ip4_mask_is_valid (&src->mask) ||
+      !avf_fdir_ip4_mask_is_valid (&dst->mask))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  hdr = avf_fdir_hdr_add (hdrs, VIRTCHNL_PROTO_HDR_IPV4);
+  ip4 = (ip4_header_t *) hdr->buffer;
+
+  if (src->mask.as_u32)
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_IPV4_SRC;
+      ip4->src_address = src->addr;
+    }
+
+  if (dst->mask.as_u32)
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_IPV4_DST;
+      ip4->dst_address = dst->addr;
+    }
+
+  return 0;
+}
+
+static int
+avf_fdir_ip6 (virtchnl_proto_hdrs_t * hdrs, ip6_address_and_mask_t * src,
+	      ip6_address_and_mask_t * dst)
+{
+  virtchnl_proto_hdr_t *hdr;
+  ip6_header_t *ip6;
+
+  if (!avf_fdir_ip6_mask_is_valid (&src->mask) ||
+      !avf_fdir_ip6_mask_is_valid (&dst->mask))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  hdr = avf_fdir_hdr_add (hdrs, VIRTCHNL_PROTO_HDR_IPV6);
+  ip6 = (ip6_header_t *) hdr->buffer;
+
+  if (src->mask.as_u64[0])
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_IPV6_SRC;
+      ip6->src_address = src->addr;
+    }
+
+  if (dst->mask.as_u64[0])
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_IPV6_DST;
+      ip6->dst_address = dst->addr;
+    }
+
+  return 0;
+}
+
+static int
+avf_fdir_l4 (virtchnl_proto_hdrs_t * hdrs, ip_protocol_t protocol,
+	     ip_port_and_mask_t * src, ip_port_and_mask_t * dst)
+{
+  virtchnl_proto_hdr_t *hdr;
+  /* tcp ports are at the same offsets */
+  udp_header_t *udp;
+
+  if (protocol != IP_PROTOCOL_UDP && protocol != IP_PROTOCOL_TCP)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  if ((src->mask != 0 && src->mask != 0xffff) ||
+      (dst->mask != 0 && dst->mask != 0xffff))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  hdr = avf_fdir_hdr_add (hdrs, protocol == IP_PROTOCOL_UDP ?
+			  VIRTCHNL_PROTO_HDR_UDP : VIRTCHNL_PROTO_HDR_TCP);
+  udp = (udp_header_t *) hdr->buffer;
+
+  if (src->mask)
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_L4_SRC_PORT;
+      udp->src_port = clib_host_to_net_u16 (src->port);
+    }
+
+  if (dst->mask)
+    {
+      hdr->field_selector |= VIRTCHNL_PROTO_HDR_L4_DST_PORT;
+      udp->dst_port = clib_host_to_net_u16 (dst->port);
+    }
+
+  return 0;
+}
+
+static void
+avf_fdir_gtpu (virtchnl_proto_hdrs_t * hdrs, u32 teid)
+{
+  virtchnl_proto_hdr_t *hdr;
+
+  hdr = avf_fdir_hdr_add (hdrs, VIRTCHNL_PROTO_HDR_GTPU_IP);
+  hdr->field_selector = VIRTCHNL_PROTO_HDR_GTPU_IP_TEID;
+  /* flags, type and length precede the teid */
+  *(u32 *) (hdr->buffer + 4) = clib_host_to_net_u32 (teid);
+}
+
+static virtchnl_filter_action_t *
+avf_fdir_action_add (virtchnl_filter_action_set_t * as,
+		     virtchnl_action_t type)
+{
+  virtchnl_filter_action_t *a = as->actions + as->count++;
+  a->type = type;
+  return a;
+}
+
+/*
+ * Translate a vnet flow into a flow director rule, mark is the id reported
+ * in the rx descriptors of matching packets, 0 for none
+ */
+static int
+avf_fdir_rule_init (avf_device_t * ad, vnet_flow_t * f, u32 mark,
+		    virtchnl_fdir_rule_t * rule)
+{
+  virtchnl_proto_hdrs_t *hdrs = &rule->proto_hdrs;
+  virtchnl_filter_action_set_t *as = &rule->action_set;
+  virtchnl_filter_action_t *a;
+  virtchnl_proto_hdr_t *hdr;
+  int rv, n_fates = 0;
+
+  clib_memset (rule, 0, sizeof (*rule));
+
+  if (f->actions & ~AVF_FLOW_SUPPORTED_ACTIONS)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  /* pattern */
+  hdr = avf_fdir_hdr_add (hdrs, VIRTCHNL_PROTO_HDR_ETH);
+
+  switch (f->type)
+    {
+    case VNET_FLOW_TYPE_ETHERNET:
+      {
+	ethernet_header_t *match = &f->ethernet.eth_hdr;
+	ethernet_header_t *eth = (ethernet_header_t *) hdr->buffer;
+
+	if (!ethernet_mac_address_is_zero (match->dst_address))
+	  {
+	    hdr->field_selector |= VIRTCHNL_PROTO_HDR_ETH_DST;
+	    clib_memcpy_fast (eth->dst_address, match->dst_address, 6);
+	  }
+	if (!ethernet_mac_address_is_zero (match->src_address))
+	  {
+	    hdr->field_selector |= VIRTCHNL_PROTO_HDR_ETH_SRC;
+	    clib_memcpy_fast (eth->src_address, match->src_address, 6);
+	  }
+	if (match->type)
+	  {
+	    hdr->field_selector |= VIRTCHNL_PROTO_HDR_ETH_ETHERTYPE;
+	    eth->type = clib_host_to_net_u16 (match->type);
+	  }
+	if (hdr->field_selector == 0)
+	  return VNET_FLOW_ERROR_NOT_SUPPORTED;
+      }
+      break;
+
+    case VNET_FLOW_TYPE_IP4_N_TUPLE:
+    case VNET_FLOW_TYPE_IP4_GTPU:
+      {
+	vnet_flow_ip4_n_tuple_t *t4 = &f->ip4_n_tuple;
+
+	if ((rv = avf_fdir_ip4 (hdrs, &t4->src_addr, &t4->dst_addr)))
+	  return rv;
+	if ((rv = avf_fdir_l4 (hdrs, t4->protocol, &t4->src_port,
+			       &t4->dst_port)))
+	  return rv;
+	if (f->type == VNET_FLOW_TYPE_IP4_GTPU)
+	  {
+	    if (t4->protocol != IP_PROTOCOL_UDP)
+	      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+	    avf_fdir_gtpu (hdrs, f->ip4_gtpu.teid);
+	  }
+      }
+      break;
+
+    case VNET_FLOW_TYPE_IP6_N_TUPLE:
+    case VNET_FLOW_TYPE_IP6_GTPU:
+      {
+	vnet_flow_ip6_n_tuple_t *t6 = &f->ip6_n_tuple;
+
+	if ((rv = avf_fdir_ip6 (hdrs, &t6->src_addr, &t6->dst_addr)))
+	  return rv;
+	if ((rv = avf_fdir_l4 (hdrs, t6->protocol, &t6->src_port,
+			       &t6->dst_port)))
+	  return rv;
+	if (f->type == VNET_FLOW_TYPE_IP6_GTPU)
+	  {
+	    if (t6->protocol != IP_PROTOCOL_UDP)
+	      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+	    avf_fdir_gtpu (hdrs, f->ip6_gtpu.teid);
+	  }
+      }
+      break;
+
+    default:
+      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+    }
+
+  /* actions, only one fate */
+  if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_QUEUE)
+    {
+      if (f->redirect_queue >= ad->n_rx_queues)
+	return VNET_FLOW_ERROR_NOT_SUPPORTED;
+      a = avf_fdir_action_add (as, VIRTCHNL_ACTION_QUEUE);
+      a->act_conf.queue.index = f->redirect_queue;
+      n_fates++;
+    }
+
+  if (f->actions & VNET_FLOW_ACTION_RSS)
+    {
+      if (!is_pow2 (f->queue_num) ||
+	  f->queue_index + f->queue_num > ad->n_rx_queues)
+	return VNET_FLOW_ERROR_NOT_SUPPORTED;
+      a = avf_fdir_action_add (as, VIRTCHNL_ACTION_Q_REGION);
+      a->act_conf.queue.index = f->queue_index;
+      a->act_conf.queue.region = min_log2 (f->queue_num);
+      n_fates++;
+    }
+
+  if (f->actions & VNET_FLOW_ACTION_DROP)
+    {
+      avf_fdir_action_add (as, VIRTCHNL_ACTION_DROP);
+      n_fates++;
+    }
+
+  if (n_fates > 1)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  if (n_fates == 0)
+    avf_fdir_action_add (as, VIRTCHNL_ACTION_PASSTHRU);
+
+  if (mark)
+    {
+      a = avf_fdir_action_add (as, VIRTCHNL_ACTION_MARK);
+      a->act_conf.mark_id = mark;
+    }
+
+  return 0;
+}
+
+static void
+avf_flow_update_rx_offload (avf_device_t * ad)
+{
+  avf_flow_entry_t *fe;
+
+  /* the input node only looks marks up when some flow sets them */
+  ad->flags &= ~AVF_DEVICE_F_RX_FLOW_OFFLOAD;
+
+  /* *INDENT-OFF* */
+  pool_foreach (fe, ad->flow_entries, ({
+    if (fe->mark)
+      ad->flags |= AVF_DEVICE_F_RX_FLOW_OFFLOAD;
+  }));
+  /* *INDENT-ON* */
+}
+
+int
+avf_flow_add (vlib_main_t * vm, avf_device_t * ad, vnet_flow_t * f,
+	      uword * private_data)
+{
+  avf_flow_lookup_entry_t *fle = 0;
+  avf_flow_entry_t *fe;
+  virtchnl_fdir_add_t fa = { 0 };
+  clib_error_t *err;
+  int rv;
+
+  if ((ad->feature_bitmap & VIRTCHNL_VF_OFFLOAD_FDIR_PF) == 0)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  /* recycle old flow lookup entries only after the main loop counter
+     increases - i.e. previously DMA'ed packets were handled */
+  if (vec_len (ad->parked_lookup_indexes) > 0 &&
+      ad->parked_loop_count != vm->main_loop_count)
+    {
+      u32 *fl_index;
+
+      vec_foreach (fl_index, ad->parked_lookup_indexes)
+	pool_put_index (ad->flow_lookup_entries, *fl_index);
+      vec_reset_length (ad->parked_lookup_indexes);
+    }
+
+  pool_get_zero (ad->flow_entries, fe);
+  fe->flow_index = f->index;
+
+  /* if we need to mark packets, assign one mark */
+  if (f->actions & (VNET_FLOW_ACTION_MARK |
+		    VNET_FLOW_ACTION_REDIRECT_TO_NODE |
+		    VNET_FLOW_ACTION_BUFFER_ADVANCE))
+    {
+      /* reserve slot 0, mark 0 means no match */
+      if (ad->flow_lookup_entries == 0)
+	pool_get_aligned (ad->flow_lookup_entries, fle,
+			  CLIB_CACHE_LINE_BYTES);
+      pool_get_aligned (ad->flow_lookup_entries, fle, CLIB_CACHE_LINE_BYTES);
+      fe->mark = fle - ad->flow_lookup_entries;
+
+      /* install entry in the lookup table */
+      clib_memset (fle, -1, sizeof (*fle));
+      if (f->actions & VNET_FLOW_ACTION_MARK)
+	fle->flow_id = f->mark_flow_id;
+      if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_NODE)
+	fle->next_index = f->redirect_device_input_next_index;
+      if (f->actions & VNET_FLOW_ACTION_BUFFER_ADVANCE)
+	fle->buffer_advance = f->buffer_advance;
+    }
+
+  fa.vsi_id = ad->vsi_id;
+  if ((rv = avf_fdir_rule_init (ad, f, fe->mark, &fa.rule_cfg)))
+    goto done;
+
+  if ((err = ad->flow_backend->add_fdir_filter (vm, ad, &fa)))
+    {
+      avf_log_err (ad, "add_fdir_filter: %U", format_clib_error, err);
+      clib_error_free (err);
+      rv = VNET_FLOW_ERROR_INTERNAL;
+      goto done;
+    }
+
+  switch (fa.status)
+    {
+    case VIRTCHNL_FDIR_SUCCESS:
+      break;
+    case VIRTCHNL_FDIR_FAILURE_RULE_EXIST:
+      rv = VNET_FLOW_ERROR_ALREADY_EXISTS;
+      goto done;
+    case VIRTCHNL_FDIR_FAILURE_RULE_CONFLICT:
+    case VIRTCHNL_FDIR_FAILURE_RULE_INVALID:
+      rv = VNET_FLOW_ERROR_NOT_SUPPORTED;
+      goto done;
+    default:
+      rv = VNET_FLOW_ERROR_INTERNAL;
+      goto done;
+    }
+
+  fe->fdir_flow_id = fa.flow_id;
+  *private_data = fe - ad->flow_entries;
+
+done:
+  if (rv)
+    {
+      if (fle)
+	{
+	  clib_memset (fle, -1, sizeof (*fle));
+	  pool_put (ad->flow_lookup_entries, fle);
+	}
+      pool_put (ad->flow_entries, fe);
+    }
+
+  avf_flow_update_rx_offload (ad);
+  return rv;
+}
+
+int
+avf_flow_del (vlib_main_t * vm, avf_device_t * ad, uword private_data)
+{
+  avf_flow_entry_t *fe = pool_elt_at_index (ad->flow_entries, private_data);
+  virtchnl_fdir_del_t fd = { 0 };
+  avf_flow_lookup_entry_t *fle;
+  clib_error_t *err;
+
+  fd.vsi_id = ad->vsi_id;
+  fd.flow_id = fe->fdir_flow_id;
+
+  if ((err = ad->flow_backend->del_fdir_filter (vm, ad, &fd)))
+    {
+      avf_log_err (ad, "del_fdir_filter: %U", format_clib_error, err);
+      clib_error_free (err);
+      return VNET_FLOW_ERROR_INTERNAL;
+    }
+
+  if (fd.status != VIRTCHNL_FDIR_SUCCESS)
+    return VNET_FLOW_ERROR_INTERNAL;
+
+  if (fe->mark)
+    {
+      /* make sure no action is taken for in-flight (marked) packets */
+      fle = pool_elt_at_index (ad->flow_lookup_entries, fe->mark);
+      clib_memset (fle, -1, sizeof (*fle));
+      vec_add1 (ad->parked_lookup_indexes, fe->mark);
+      ad->parked_loop_count = vm->main_loop_count;
+    }
+
+  pool_put (ad->flow_entries, fe);
+  avf_flow_update_rx_offload (ad);
+  return 0;
+}
+
+int
+avf_flow_ops_fn (vnet_main_t * vnm, vnet_flow_dev_op_t op, u32 dev_instance,
+		 u32 flow_index, uword * private_data)
+{
+  avf_main_t *am = &avf_main;
+  avf_device_t *ad = pool_elt_at_index (am->devices, dev_instance);
+  vlib_main_t *vm = vlib_get_main ();
+
+  if (op == VNET_FLOW_DEV_OP_ADD_FLOW)
+    return avf_flow_add (vm, ad, vnet_get_flow (flow_index), private_data);
+
+  if (op == VNET_FLOW_DEV_OP_DEL_FLOW)
+    return avf_flow_del (vm, ad, *private_data);
+
+  return VNET_FLOW_ERROR_NOT_SUPPORTED;
+}
+
+u8 *
+format_avf_flow (u8 * s, va_list * args)
+{
+  u32 dev_instance = va_arg (*args, u32);
+  u32 flow_index = va_arg (*args, u32);
+  uword private_data = va_arg (*args, uword);
+  avf_main_t *am = &avf_main;
+  avf_device_t *ad = pool_elt_at_index (am->devices, dev_instance);
+  avf_flow_entry_t *fe;
+
+  if (flow_index == ~0)
+    {
+      s = format (s, "%-25s: %U\n", "supported flow actions",
+		  format_flow_actions,
+		  ad->feature_bitmap & VIRTCHNL_VF_OFFLOAD_FDIR_PF ?
+		  AVF_FLOW_SUPPORTED_ACTIONS : 0);
+      s = format (s, "%-25s: %u\n", "flow director rules",
+		  pool_elts (ad->flow_entries));
+      return s;
+    }
+
+  if (pool_is_free_index (ad->flow_entries, private_data))
+    return format (s, "unknown flow");
+
+  fe = pool_elt_at_index (ad->flow_entries, private_data);
+  s = format (s, "fdir rule %u mark %u", fe->fdir_flow_id, fe->mark);
+  return s;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
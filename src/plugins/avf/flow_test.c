@@ -0,0 +1,307 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Flow offload unit tests: flows are programmed on a fake device through
+ * a mock backend standing for the PF, which records the virtchnl messages
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/pci/pci.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip.h>
+#include <vnet/udp/udp_packet.h>
+
+#include <avf/avf.h>
+
+typedef struct
+{
+  virtchnl_fdir_add_t last_add;
+  virtchnl_fdir_del_t last_del;
+  /* status returned by the next add */
+  virtchnl_fdir_status_t status;
+  u32 *rules;
+  u32 next_flow_id;
+  u32 n_adds;
+} avf_flow_mock_t;
+
+static avf_flow_mock_t avf_flow_mock;
+
+static clib_error_t *
+avf_flow_mock_add_fdir_filter (vlib_main_t * vm, avf_device_t * ad,
+			       virtchnl_fdir_add_t * fa)
+{
+  avf_flow_mock_t *mock = &avf_flow_mock;
+
+  mock->n_adds++;
+  clib_memcpy_fast (&mock->last_add, fa, sizeof (*fa));
+  fa->status = mock->status;
+  if (fa->status == VIRTCHNL_FDIR_SUCCESS)
+    {
+      fa->flow_id = ++mock->next_flow_id;
+      vec_add1 (mock->rules, fa->flow_id);
+    }
+  return 0;
+}
+
+static clib_error_t *
+avf_flow_mock_del_fdir_filter (vlib_main_t * vm, avf_device_t * ad,
+			       virtchnl_fdir_del_t * fd)
+{
+  avf_flow_mock_t *mock = &avf_flow_mock;
+  u32 i;
+
+  clib_memcpy_fast (&mock->last_del, fd, sizeof (*fd));
+  fd->status = VIRTCHNL_FDIR_FAILURE_RULE_NONEXIST;
+  vec_foreach_index (i, mock->rules)
+    if (mock->rules[i] == fd->flow_id)
+    {
+      vec_del1 (mock->rules, i);
+      fd->status = VIRTCHNL_FDIR_SUCCESS;
+      break;
+    }
+  return 0;
+}
+
+static const avf_flow_backend_t avf_flow_backend_mock = {
+  .add_fdir_filter = avf_flow_mock_add_fdir_filter,
+  .del_fdir_filter = avf_flow_mock_del_fdir_filter,
+};
+
+#define AVF_FLOW_TEST(_cond, _comment, _args...)			\
+  do {									\
+    if (!(_cond))							\
+      {									\
+	vlib_cli_output (vm, "FAIL:%d: " _comment, __LINE__, ##_args);	\
+	n_fails++;							\
+      }									\
+  } while (0)
+
+static void
+avf_flow_test_ip4 (vnet_flow_t * f, vnet_flow_type_t type, u32 index)
+{
+  clib_memset (f, 0, sizeof (*f));
+  f->type = type;
+  f->index = index;
+  f->ip4_n_tuple.src_addr.addr.as_u32 = clib_host_to_net_u32 (0x0a000001);
+  f->ip4_n_tuple.src_addr.mask.as_u32 = ~0;
+  f->ip4_n_tuple.dst_addr.addr.as_u32 = clib_host_to_net_u32 (0x0a000002);
+  f->ip4_n_tuple.dst_addr.mask.as_u32 = ~0;
+  f->ip4_n_tuple.dst_port.port = 2152;
+  f->ip4_n_tuple.dst_port.mask = 0xffff;
+  f->ip4_n_tuple.protocol = IP_PROTOCOL_UDP;
+}
+
+static clib_error_t *
+avf_flow_test_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			  vlib_cli_command_t * cmd)
+{
+  avf_flow_mock_t *mock = &avf_flow_mock;
+  virtchnl_fdir_rule_t *rule = &mock->last_add.rule_cfg;
+  virtchnl_proto_hdr_t *hdr;
+  virtchnl_filter_action_t *a;
+  avf_flow_lookup_entry_t *fle;
+  avf_device_t *ad;
+  vnet_flow_t f;
+  uword queue_flow, marked_flow, ip6_flow;
+  u32 n_adds, n_fails = 0;
+  int rv;
+
+  clib_memset (mock, 0, sizeof (*mock));
+  ad = clib_mem_alloc_aligned (sizeof (*ad), CLIB_CACHE_LINE_BYTES);
+  clib_memset (ad, 0, sizeof (*ad));
+  ad->vsi_id = 3;
+  ad->n_rx_queues = 8;
+  ad->feature_bitmap = VIRTCHNL_VF_OFFLOAD_FDIR_PF;
+  ad->flow_backend = &avf_flow_backend_mock;
+
+  /* 5-tuple to a queue */
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_N_TUPLE, 0);
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 3;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == 0, "ip4 to queue: %U", format_flow_error, rv);
+  AVF_FLOW_TEST (mock->last_add.vsi_id == 3, "vsi id");
+  AVF_FLOW_TEST (rule->proto_hdrs.count == 3, "ip4 headers: %d",
+		 rule->proto_hdrs.count);
+  hdr = rule->proto_hdrs.proto_hdr;
+  AVF_FLOW_TEST (hdr[0].type == VIRTCHNL_PROTO_HDR_ETH &&
+		 hdr[0].field_selector == 0, "ip4 ethernet header");
+  AVF_FLOW_TEST (hdr[1].type == VIRTCHNL_PROTO_HDR_IPV4 &&
+		 hdr[1].field_selector == (VIRTCHNL_PROTO_HDR_IPV4_SRC |
+					   VIRTCHNL_PROTO_HDR_IPV4_DST),
+		 "ip4 header");
+  AVF_FLOW_TEST (((ip4_header_t *) hdr[1].buffer)->dst_address.as_u32 ==
+		 clib_host_to_net_u32 (0x0a000002), "ip4 dst address");
+  AVF_FLOW_TEST (hdr[2].type == VIRTCHNL_PROTO_HDR_UDP &&
+		 hdr[2].field_selector == VIRTCHNL_PROTO_HDR_L4_DST_PORT,
+		 "udp header");
+  AVF_FLOW_TEST (((udp_header_t *) hdr[2].buffer)->dst_port ==
+		 clib_host_to_net_u16 (2152), "udp dst port");
+  a = rule->action_set.actions;
+  AVF_FLOW_TEST (rule->action_set.count == 1 &&
+		 a[0].type == VIRTCHNL_ACTION_QUEUE &&
+		 a[0].act_conf.queue.index == 3, "queue action");
+  AVF_FLOW_TEST ((ad->flags & AVF_DEVICE_F_RX_FLOW_OFFLOAD) == 0,
+		 "no mark, no rx flow offload");
+
+  /* gtpu to a queue group, marked */
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_GTPU, 1);
+  f.ip4_gtpu.teid = 0x1234;
+  f.actions = VNET_FLOW_ACTION_RSS | VNET_FLOW_ACTION_MARK;
+  f.queue_index = 4;
+  f.queue_num = 4;
+  f.mark_flow_id = 10;
+  rv = avf_flow_add (vm, ad, &f, &marked_flow);
+  AVF_FLOW_TEST (rv == 0, "gtpu to queue group: %U", format_flow_error, rv);
+  hdr = rule->proto_hdrs.proto_hdr;
+  AVF_FLOW_TEST (rule->proto_hdrs.count == 4 &&
+		 hdr[3].type == VIRTCHNL_PROTO_HDR_GTPU_IP &&
+		 *(u32 *) (hdr[3].buffer + 4) ==
+		 clib_host_to_net_u32 (0x1234), "gtpu header");
+  a = rule->action_set.actions;
+  AVF_FLOW_TEST (rule->action_set.count == 2 &&
+		 a[0].type == VIRTCHNL_ACTION_Q_REGION &&
+		 a[0].act_conf.queue.index == 4 &&
+		 a[0].act_conf.queue.region == 2, "queue region action");
+  AVF_FLOW_TEST (a[1].type == VIRTCHNL_ACTION_MARK &&
+		 a[1].act_conf.mark_id == 1, "mark action");
+  fle = vec_elt_at_index (ad->flow_lookup_entries, a[1].act_conf.mark_id);
+  AVF_FLOW_TEST (fle->flow_id == 10 && fle->next_index == (u16) ~ 0,
+		 "lookup entry");
+  AVF_FLOW_TEST (ad->flags & AVF_DEVICE_F_RX_FLOW_OFFLOAD,
+		 "mark enables rx flow offload");
+
+  /* ip6 drop */
+  clib_memset (&f, 0, sizeof (f));
+  f.type = VNET_FLOW_TYPE_IP6_N_TUPLE;
+  f.index = 2;
+  clib_memset (&f.ip6_n_tuple.src_addr.mask, 0xff, sizeof (ip6_address_t));
+  f.ip6_n_tuple.src_addr.addr.as_u8[15] = 1;
+  f.ip6_n_tuple.src_port.port = 179;
+  f.ip6_n_tuple.src_port.mask = 0xffff;
+  f.ip6_n_tuple.protocol = IP_PROTOCOL_TCP;
+  f.actions = VNET_FLOW_ACTION_DROP;
+  rv = avf_flow_add (vm, ad, &f, &ip6_flow);
+  AVF_FLOW_TEST (rv == 0, "ip6 drop: %U", format_flow_error, rv);
+  hdr = rule->proto_hdrs.proto_hdr;
+  AVF_FLOW_TEST (hdr[1].type == VIRTCHNL_PROTO_HDR_IPV6 &&
+		 hdr[1].field_selector == VIRTCHNL_PROTO_HDR_IPV6_SRC,
+		 "ip6 header");
+  AVF_FLOW_TEST (hdr[2].type == VIRTCHNL_PROTO_HDR_TCP &&
+		 hdr[2].field_selector == VIRTCHNL_PROTO_HDR_L4_SRC_PORT,
+		 "tcp header");
+  AVF_FLOW_TEST (rule->action_set.count == 1 &&
+		 rule->action_set.actions[0].type == VIRTCHNL_ACTION_DROP,
+		 "drop action");
+
+  /* rejected before reaching the PF */
+  n_adds = mock->n_adds;
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_N_TUPLE, 3);
+  f.ip4_n_tuple.src_addr.mask.as_u32 = clib_host_to_net_u32 (0xffffff00);
+  f.actions = VNET_FLOW_ACTION_DROP;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "prefix match");
+
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_N_TUPLE, 3);
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 8;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "invalid queue");
+
+  f.actions = VNET_FLOW_ACTION_RSS;
+  f.queue_index = 0;
+  f.queue_num = 3;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "invalid queue group");
+
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE | VNET_FLOW_ACTION_DROP;
+  f.redirect_queue = 0;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "two fates");
+
+  f.actions = VNET_FLOW_ACTION_COUNT;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "count action");
+
+  f.type = VNET_FLOW_TYPE_IP4_VXLAN;
+  f.actions = VNET_FLOW_ACTION_DROP;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "vxlan");
+  AVF_FLOW_TEST (mock->n_adds == n_adds, "no rule sent to the PF");
+
+  /* rejected by the PF, the mark is released */
+  mock->status = VIRTCHNL_FDIR_FAILURE_RULE_EXIST;
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_N_TUPLE, 3);
+  f.actions = VNET_FLOW_ACTION_MARK;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_ALREADY_EXISTS, "rule exists: %U",
+		 format_flow_error, rv);
+  AVF_FLOW_TEST (pool_elts (ad->flow_lookup_entries) == 2,
+		 "lookup entry released");
+  AVF_FLOW_TEST (pool_elts (ad->flow_entries) == 3, "flow entry released");
+  mock->status = VIRTCHNL_FDIR_SUCCESS;
+
+  /* delete */
+  rv = avf_flow_del (vm, ad, marked_flow);
+  AVF_FLOW_TEST (rv == 0, "delete marked flow: %U", format_flow_error, rv);
+  AVF_FLOW_TEST (mock->last_del.vsi_id == 3 && mock->last_del.flow_id == 2,
+		 "delete rule id");
+  AVF_FLOW_TEST (vec_len (ad->parked_lookup_indexes) == 1,
+		 "lookup entry parked");
+  AVF_FLOW_TEST ((ad->flags & AVF_DEVICE_F_RX_FLOW_OFFLOAD) == 0,
+		 "no more marks, rx flow offload disabled");
+  rv = avf_flow_del (vm, ad, ip6_flow);
+  AVF_FLOW_TEST (rv == 0, "delete ip6 flow: %U", format_flow_error, rv);
+  AVF_FLOW_TEST (vec_len (mock->rules) == 1, "rules left: %u",
+		 vec_len (mock->rules));
+
+  /* no flow director on the PF */
+  ad->feature_bitmap = 0;
+  avf_flow_test_ip4 (&f, VNET_FLOW_TYPE_IP4_N_TUPLE, 4);
+  f.actions = VNET_FLOW_ACTION_DROP;
+  rv = avf_flow_add (vm, ad, &f, &queue_flow);
+  AVF_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "no fdir capability");
+
+  pool_free (ad->flow_entries);
+  pool_free (ad->flow_lookup_entries);
+  vec_free (ad->parked_lookup_indexes);
+  clib_mem_free (ad);
+  vec_free (mock->rules);
+
+  if (n_fails)
+    return clib_error_return (0, "%u avf flow test(s) failed", n_fails);
+
+  vlib_cli_output (vm, "avf flow tests passed");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (avf_flow_test_command, static) = {
+  .path = "test avf flow",
+  .short_help = "test avf flow",
+  .function = avf_flow_test_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -231,9 +231,37 @@ avf_process_rx_burst (vlib_main_t * vm, vlib_node_runtime_t * node,
   return n_rx_bytes;
 }
 
+static_always_inline void
+avf_process_flow_offload (avf_device_t * ad, avf_per_thread_data_t * ptd,
+			  u32 n_rx_packets)
+{
+  avf_flow_lookup_entry_t *fle;
+  u32 n;
+
+  for (n = 0; n < n_rx_packets; n++)
+    {
+      u32 mark = ptd->flow_ids[n];
+
+      if (mark == 0 || mark >= vec_len (ad->flow_lookup_entries))
+	continue;
+
+      fle = vec_elt_at_index (ad->flow_lookup_entries, mark);
+
+      if (fle->next_index != (u16) ~ 0)
+	ptd->next[n] = fle->next_index;
+
+      if (fle->flow_id != ~0)
+	ptd->bufs[n]->flow_id = fle->flow_id;
+
+      if (fle->buffer_advance != ~0)
+	vlib_buffer_advance (ptd->bufs[n], fle->buffer_advance);
+    }
+}
+
 static_always_inline uword
 avf_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
-			 vlib_frame_t * frame, avf_device_t * ad, u16 qid)
+			 vlib_frame_t * frame, avf_device_t * ad, u16 qid,
+			 int with_flows)
 {
   avf_main_t *am = &avf_main;
   vnet_main_t *vnm = vnet_get_main ();
@@ -244,7 +272,7 @@ avf_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 n_trace, n_rx_packets = 0, n_rx_bytes = 0;
   u16 n_tail_desc = 0;
   u64 or_qw1 = 0;
-  u32 *bi, *to_next, n_left_to_next;
+  u32 *bi, *to_next, *buffers, n_left_to_next;
   vlib_buffer_t *bt = &ptd->buffer_template;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
   u16 next = rxq->next;
@@ -267,11 +295,19 @@ avf_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (PREDICT_FALSE (vnet_device_input_have_features (ad->sw_if_index)))
     vnet_feature_start_device_input_x1 (ad->sw_if_index, &next_index, bt);
 
-  vlib_get_new_next_frame (vm, node, next_index, to_next, n_left_to_next);
+  /* with flow offload, packets may go to different nexts */
+  if (with_flows)
+    buffers = ptd->buffers;
+  else
+    {
+      vlib_get_new_next_frame (vm, node, next_index, to_next,
+			       n_left_to_next);
+      buffers = to_next;
+    }
 
   /* fetch up to AVF_RX_VECTOR_SZ from the rx ring, unflatten them and
      copy needed data from descriptor to rx vector */
-  bi = to_next;
+  bi = buffers;
 
   while (n_rx_packets < AVF_RX_VECTOR_SZ)
     {
@@ -303,6 +339,14 @@ avf_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       u64x4_store_unaligned (q1x4, ptd->qw1s + n_rx_packets);
       vlib_buffer_copy_indices (bi, rxq->bufs + next, 4);
 
+      if (with_flows)
+	{
+	  ptd->flow_ids[n_rx_packets + 0] = avf_rxd_fdir_id (d + 0);
+	  ptd->flow_ids[n_rx_packets + 1] = avf_rxd_fdir_id (d + 1);
+	  ptd->flow_ids[n_rx_packets + 2] = avf_rxd_fdir_id (d + 2);
+	  ptd->flow_ids[n_rx_packets + 3] = avf_rxd_fdir_id (d + 3);
+	}
+
       /* next */
       next = (next + 4) & mask;
       d = fd + next;
@@ -342,7 +386,13 @@ avf_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  while (avf_rxd_is_not_eop (td));
 	  next = tail_next;
 	  n_tail_desc += tail_desc;
+
+	  /* the flow director id is reported in the last descriptor */
+	  if (with_flows)
+	    ptd->flow_ids[n_rx_packets] = avf_rxd_fdir_id (td);
 	}
+      else if (with_flows)
+	ptd->flow_ids[n_rx_packets] = avf_rxd_fdir_id (d);
 
       or_qw1 |= ptd->qw1s[n_rx_packets] = d[0].qword[1];
 
@@ -370,7 +420,7 @@ no_more_desc:
   else
     avf_rxq_refill (vm, node, rxq, 0 /* use_va_dma */ );
 
-  vlib_get_buffers (vm, to_next, ptd->bufs, n_rx_packets);
+  vlib_get_buffers (vm, buffers, ptd->bufs, n_rx_packets);
 
   vnet_buffer (bt)->sw_if_index[VLIB_RX] = ad->sw_if_index;
   vnet_buffer (bt)->sw_if_index[VLIB_TX] = ~0;
@@ -382,20 +432,27 @@ no_more_desc:
   else
     n_rx_bytes = avf_process_rx_burst (vm, node, ptd, n_rx_packets, 0);
 
+  if (with_flows)
+    {
+      clib_memset_u16 (ptd->next, next_index, n_rx_packets);
+      avf_process_flow_offload (ad, ptd, n_rx_packets);
+    }
+
   /* packet trace if enabled */
   if (PREDICT_FALSE ((n_trace = vlib_get_trace_count (vm, node))))
     {
       u32 n_left = n_rx_packets, i = 0, j;
-      bi = to_next;
+      bi = buffers;
 
       while (n_trace && n_left)
 	{
 	  vlib_buffer_t *b;
 	  avf_input_trace_t *tr;
+	  u16 next0 = with_flows ? ptd->next[i] : next_index;
 	  b = vlib_get_buffer (vm, bi[0]);
-	  vlib_trace_buffer (vm, node, next_index, b, /* follow_chain */ 0);
+	  vlib_trace_buffer (vm, node, next0, b, /* follow_chain */ 0);
 	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-	  tr->next_index = next_index;
+	  tr->next_index = next0;
 	  tr->qid = qid;
 	  tr->hw_if_index = ad->hw_if_index;
 	  tr->qw1s[0] = ptd->qw1s[i];
@@ -411,6 +468,13 @@ no_more_desc:
       vlib_set_trace_count (vm, node, n_trace);
     }
 
+  if (with_flows)
+    {
+      vlib_buffer_enqueue_to_next (vm, node, buffers, ptd->next,
+				   n_rx_packets);
+      goto increment_counters;
+    }
+
   if (PREDICT_TRUE (next_index == VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT))
     {
       vlib_next_frame_t *nf;
@@ -432,6 +496,7 @@ no_more_desc:
   n_left_to_next -= n_rx_packets;
   vlib_put_next_frame (vm, node, next_index, n_left_to_next);
 
+increment_counters:
   vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
 				   + VNET_INTERFACE_COUNTER_RX, thr_idx,
 				   ad->hw_if_index, n_rx_packets, n_rx_bytes);
@@ -454,7 +519,12 @@ VLIB_NODE_FN (avf_input_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
     ad = vec_elt_at_index (am->devices, dq->dev_instance);
     if ((ad->flags & AVF_DEVICE_F_ADMIN_UP) == 0)
       continue;
-    n_rx += avf_device_input_inline (vm, node, frame, ad, dq->queue_id);
+    if (PREDICT_FALSE (ad->flags & AVF_DEVICE_F_RX_FLOW_OFFLOAD))
+      n_rx += avf_device_input_inline (vm, node, frame, ad, dq->queue_id,
+				       /* with_flows */ 1);
+    else
+      n_rx += avf_device_input_inline (vm, node, frame, ad, dq->queue_id,
+				       /* with_flows */ 0);
   }
   return n_rx;
 }
@@ -131,6 +131,52 @@ avf_tx_enqueue (vlib_main_t * vm, avf_txq_t * txq, u32 * buffers,
   return n_packets - n_packets_left;
 }
 
+/* completed buffers are only reclaimed when the ring fills up past this
+   point, so they are freed in few large batches instead of a small chunk
+   on every call */
+#define AVF_TX_RECLAIM_THRESHOLD(txq) ((txq)->size / 2)
+
+static_always_inline void
+avf_tx_reclaim (vlib_main_t * vm, avf_txq_t * txq)
+{
+  u16 *slot, complete_slot, first, n_free;
+  u16 mask = txq->size - 1;
+
+  if ((slot = clib_ring_get_last (txq->rs_slots)) == 0)
+    return;
+
+  /* descriptors complete in order: if the last RS descriptor is done,
+     everything in flight is */
+  if (avf_tx_desc_get_dtyp (txq->descs + slot[0]) == 0x0F)
+    {
+      complete_slot = slot[0];
+      while (clib_ring_deq (txq->rs_slots))
+	;
+    }
+  else
+    {
+      slot = clib_ring_get_first (txq->rs_slots);
+      if (avf_tx_desc_get_dtyp (txq->descs + slot[0]) != 0x0F)
+	return;
+
+      /* the last one may have completed meanwhile, so the ring can
+	 drain here */
+      do
+	{
+	  complete_slot = slot[0];
+	  clib_ring_deq (txq->rs_slots);
+	}
+      while ((slot = clib_ring_get_first (txq->rs_slots)) != 0 &&
+	     avf_tx_desc_get_dtyp (txq->descs + slot[0]) == 0x0F);
+    }
+
+  first = (txq->next - txq->n_enqueued) & mask;
+  n_free = (complete_slot + 1 - first) & mask;
+
+  txq->n_enqueued -= n_free;
+  vlib_buffer_free_from_ring (vm, txq->bufs, first, txq->size, n_free);
+}
+
 VNET_DEVICE_CLASS_TX_FN (avf_device_class) (vlib_main_t * vm,
 					    vlib_node_runtime_t * node,
 					    vlib_frame_t * frame)
@@ -150,37 +196,9 @@ VNET_DEVICE_CLASS_TX_FN (avf_device_class) (vlib_main_t * vm,
   n_left = frame->n_vectors;
 
 retry:
-  /* release consumed bufs */
-  if (txq->n_enqueued)
-    {
-      i32 complete_slot = -1;
-      while (1)
-	{
-	  u16 *slot = clib_ring_get_first (txq->rs_slots);
-
-	  if (slot == 0)
-	    break;
-
-	  if (avf_tx_desc_get_dtyp (txq->descs + slot[0]) != 0x0F)
-	    break;
-
-	  complete_slot = slot[0];
-
-	  clib_ring_deq (txq->rs_slots);
-	}
-
-      if (complete_slot >= 0)
-	{
-	  u16 first, mask, n_free;
-	  mask = txq->size - 1;
-	  first = (txq->next - txq->n_enqueued) & mask;
-	  n_free = (complete_slot + 1 - first) & mask;
-
-	  txq->n_enqueued -= n_free;
-	  vlib_buffer_free_from_ring (vm, txq->bufs, first, txq->size,
-				      n_free);
-	}
-    }
+  /* release consumed bufs, in batches */
+  if (txq->n_enqueued + n_left > AVF_TX_RECLAIM_THRESHOLD (txq))
+    avf_tx_reclaim (vm, txq);
 
   if (ad->flags & AVF_DEVICE_F_VA_DMA)
     n_enq = avf_tx_enqueue (vm, txq, buffers, n_left, 1);
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestAvfFlow(VppTestCase):
+    """ AVF Flow Offload Unit Tests """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestAvfFlow, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestAvfFlow, cls).tearDownClass()
+
+    def test_avf_flow(self):
+        """ Flow director rules """
+        error = self.vapi.cli("test avf flow")
+
+        if error:
+            self.logger.critical(error)
+        self.assertNotIn("failed", error)
+        self.assertIn("passed", error)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -97,7 +97,9 @@ enum
   _(30, ENABLE_CHANNELS)			\
   _(31, DISABLE_CHANNELS)			\
   _(32, ADD_CLOUD_FILTER)			\
-  _(33, DEL_CLOUD_FILTER)
+  _(33, DEL_CLOUD_FILTER)			\
+  _(47, ADD_FDIR_FILTER)			\
+  _(48, DEL_FDIR_FILTER)
 
 
 typedef enum
@@ -136,7 +138,8 @@ typedef enum
   _(20, OFFLOAD_ENCAP, "encap") \
   _(21, OFFLOAD_ENCAP_CSUM, "encap-csum") \
   _(22, OFFLOAD_RX_ENCAP_CSUM, "rx-encap-csum") \
-  _(23, OFFLOAD_ADQ, "offload-adq")
+  _(23, OFFLOAD_ADQ, "offload-adq") \
+  _(28, OFFLOAD_FDIR_PF, "fdir-pf")
 
 typedef enum
 {
@@ -399,6 +402,150 @@ typedef struct
   u16 num_queue_pairs;
 } virtchnl_vf_res_request_t;
 
+/* VIRTCHNL_OP_ADD_FDIR_FILTER, VIRTCHNL_OP_DEL_FDIR_FILTER */
+#define VIRTCHNL_MAX_NUM_PROTO_HDRS	32
+#define VIRTCHNL_MAX_NUM_ACTIONS	8
+
+typedef enum
+{
+  VIRTCHNL_PROTO_HDR_NONE,
+  VIRTCHNL_PROTO_HDR_ETH,
+  VIRTCHNL_PROTO_HDR_S_VLAN,
+  VIRTCHNL_PROTO_HDR_C_VLAN,
+  VIRTCHNL_PROTO_HDR_IPV4,
+  VIRTCHNL_PROTO_HDR_IPV6,
+  VIRTCHNL_PROTO_HDR_TCP,
+  VIRTCHNL_PROTO_HDR_UDP,
+  VIRTCHNL_PROTO_HDR_SCTP,
+  VIRTCHNL_PROTO_HDR_GTPU_IP,
+} virtchnl_proto_hdr_type_t;
+
+/* bits of virtchnl_proto_hdr_t field_selector, per header type */
+#define VIRTCHNL_PROTO_HDR_ETH_SRC		(1 << 0)
+#define VIRTCHNL_PROTO_HDR_ETH_DST		(1 << 1)
+#define VIRTCHNL_PROTO_HDR_ETH_ETHERTYPE	(1 << 2)
+#define VIRTCHNL_PROTO_HDR_IPV4_SRC		(1 << 0)
+#define VIRTCHNL_PROTO_HDR_IPV4_DST		(1 << 1)
+#define VIRTCHNL_PROTO_HDR_IPV4_PROT		(1 << 4)
+#define VIRTCHNL_PROTO_HDR_IPV6_SRC		(1 << 0)
+#define VIRTCHNL_PROTO_HDR_IPV6_DST		(1 << 1)
+#define VIRTCHNL_PROTO_HDR_IPV6_PROT		(1 << 4)
+#define VIRTCHNL_PROTO_HDR_L4_SRC_PORT		(1 << 0)
+#define VIRTCHNL_PROTO_HDR_L4_DST_PORT		(1 << 1)
+#define VIRTCHNL_PROTO_HDR_GTPU_IP_TEID		(1 << 0)
+
+typedef struct
+{
+  virtchnl_proto_hdr_type_t type;
+  u32 field_selector;
+  /* header in network byte order */
+  u8 buffer[64];
+} virtchnl_proto_hdr_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_proto_hdr_t, 72);
+
+typedef struct
+{
+  u8 tunnel_level;
+  int count;
+  virtchnl_proto_hdr_t proto_hdr[VIRTCHNL_MAX_NUM_PROTO_HDRS];
+} virtchnl_proto_hdrs_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_proto_hdrs_t, 2312);
+
+typedef enum
+{
+  VIRTCHNL_ACTION_DROP = 0,
+  VIRTCHNL_ACTION_TC_REDIRECT,
+  VIRTCHNL_ACTION_PASSTHRU,
+  VIRTCHNL_ACTION_QUEUE,
+  VIRTCHNL_ACTION_Q_REGION,
+  VIRTCHNL_ACTION_MARK,
+  VIRTCHNL_ACTION_COUNT,
+} virtchnl_action_t;
+
+typedef struct
+{
+  virtchnl_action_t type;
+  union
+  {
+    /* VIRTCHNL_ACTION_QUEUE, VIRTCHNL_ACTION_Q_REGION */
+    struct
+    {
+      u16 index;
+      /* log2 of the number of queues */
+      u8 region;
+    } queue;
+    /* VIRTCHNL_ACTION_COUNT */
+    struct
+    {
+      u8 shared;
+      u32 id;
+    } count;
+    /* VIRTCHNL_ACTION_MARK */
+    u32 mark_id;
+    u8 reserve[32];
+  } act_conf;
+} virtchnl_filter_action_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_filter_action_t, 36);
+
+typedef struct
+{
+  int count;
+  virtchnl_filter_action_t actions[VIRTCHNL_MAX_NUM_ACTIONS];
+} virtchnl_filter_action_set_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_filter_action_set_t, 292);
+
+typedef struct
+{
+  virtchnl_proto_hdrs_t proto_hdrs;
+  virtchnl_filter_action_set_t action_set;
+} virtchnl_fdir_rule_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_fdir_rule_t, 2604);
+
+#define foreach_virtchnl_fdir_status \
+  _(0, SUCCESS, "success") \
+  _(1, FAILURE_RULE_NORESOURCE, "no resource") \
+  _(2, FAILURE_RULE_EXIST, "rule exists") \
+  _(3, FAILURE_RULE_CONFLICT, "rule conflict") \
+  _(4, FAILURE_RULE_NONEXIST, "no such rule") \
+  _(5, FAILURE_RULE_INVALID, "invalid rule") \
+  _(6, FAILURE_RULE_TIMEOUT, "timeout") \
+  _(7, FAILURE_QUERY_INVALID, "invalid query")
+
+typedef enum
+{
+#define _(a,b,c) VIRTCHNL_FDIR_##b = (a),
+  foreach_virtchnl_fdir_status
+#undef _
+} virtchnl_fdir_status_t;
+
+typedef struct
+{
+  u16 vsi_id;
+  /* 1 to only validate the rule */
+  u16 validate_only;
+  /* returned by the PF */
+  u32 flow_id;
+  virtchnl_fdir_rule_t rule_cfg;
+  virtchnl_fdir_status_t status;
+} virtchnl_fdir_add_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_fdir_add_t, 2616);
+
+typedef struct
+{
+  u16 vsi_id;
+  u16 pad;
+  u32 flow_id;
+  virtchnl_fdir_status_t status;
+} virtchnl_fdir_del_t;
+
+STATIC_ASSERT_SIZEOF (virtchnl_fdir_del_t, 12);
+
 #endif /* AVF_VIRTCHNL_H */
 
 /*
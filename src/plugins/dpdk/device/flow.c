@@ -489,6 +489,13 @@ pattern_end:
   item->type = RTE_FLOW_ITEM_TYPE_END;
 
   /* Actions */
+  /* queue groups are not mapped to rte_flow yet */
+  if (f->actions & VNET_FLOW_ACTION_RSS)
+    {
+      rv = VNET_FLOW_ERROR_NOT_SUPPORTED;
+      goto done;
+    }
+
   /* Only one 'fate' can be assigned */
   if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_QUEUE)
     {
@@ -0,0 +1,567 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+
+#include <hqos/hqos.h>
+
+/* rate in bits per second, stored in bytes per second */
+static uword
+unformat_hqos_rate (unformat_input_t * input, va_list * args)
+{
+  f64 *rate = va_arg (*args, f64 *);
+  f64 r;
+
+  if (unformat (input, "%f gbps", &r))
+    r *= 1e9;
+  else if (unformat (input, "%f mbps", &r))
+    r *= 1e6;
+  else if (unformat (input, "%f kbps", &r))
+    r *= 1e3;
+  else if (unformat (input, "%f bps", &r) || unformat (input, "%f", &r))
+    ;
+  else
+    return 0;
+
+  *rate = r / 8;
+  return 1;
+}
+
+static clib_error_t *
+hqos_rv_to_error (int rv, char *what)
+{
+  switch (rv)
+    {
+    case 0:
+      return 0;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      return clib_error_return (0, "hqos not enabled on interface");
+    case VNET_API_ERROR_INVALID_SW_IF_INDEX:
+      return clib_error_return (0, "not a hardware interface");
+    case VNET_API_ERROR_ENTRY_ALREADY_EXISTS:
+      return clib_error_return (0, "hqos already enabled on interface");
+    case VNET_API_ERROR_INVALID_WORKER:
+      return clib_error_return (0, "invalid worker");
+    case VNET_API_ERROR_INVALID_VALUE:
+      return clib_error_return (0, "invalid %s", what);
+    default:
+      return clib_error_return (0, "hqos returned %d", rv);
+    }
+}
+
+static clib_error_t *
+hqos_interface_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  hqos_port_args_t args = {
+    .frame_overhead = HQOS_DEFAULT_FRAME_OVERHEAD,
+    .thread_index = ~0,
+  };
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, worker = ~0;
+  clib_error_t *error = 0;
+  int disable = 0, rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "rate %U", unformat_hqos_rate,
+			 &args.rate))
+	;
+      else if (unformat (line_input, "subports %u", &args.n_subports))
+	;
+      else if (unformat (line_input, "pipes %u", &args.n_pipes))
+	;
+      else if (unformat (line_input, "queue-size %u", &args.queue_size))
+	;
+      else if (unformat (line_input, "frame-overhead %u",
+			 &args.frame_overhead))
+	;
+      else if (unformat (line_input, "worker %u", &worker))
+	;
+      else if (unformat (line_input, "disable"))
+	disable = 1;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0)
+    {
+      error = clib_error_return (0, "interface required");
+      goto done;
+    }
+
+  if (disable)
+    {
+      rv = hqos_port_delete (vm, sw_if_index);
+      error = hqos_rv_to_error (rv, "value");
+      goto done;
+    }
+
+  if (args.rate == 0)
+    {
+      error = clib_error_return (0, "rate required");
+      goto done;
+    }
+
+  if (worker != ~0)
+    args.thread_index = worker + 1;
+
+  rv = hqos_port_create (vm, sw_if_index, &args);
+  error = hqos_rv_to_error (rv, "rate, subports, pipes or queue size");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Enable the hierarchical scheduler on the output of a hardware
+ * interface. Packets are queued per subport, pipe, traffic class and
+ * queue and sent to the device at the port '<em>rate</em>'. With workers
+ * the scheduler of a port runs on one worker, packets sent by other
+ * threads are handed off to it.
+ *
+ * @cliexpar
+ * @cliexcmd{set hqos interface GigabitEthernet0/8/0 rate 9 gbps pipes 1024}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_interface_command, static) = {
+  .path = "set hqos interface",
+  .short_help = "set hqos interface <interface> rate <n> [gbps|mbps|kbps] "
+    "[subports <n>] [pipes <n>] [queue-size <n>] [frame-overhead <bytes>] "
+    "[worker <n>] [disable]",
+  .function = hqos_interface_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_subport_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, subport = ~0, burst = 0;
+  clib_error_t *error = 0;
+  f64 rate = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "subport %u", &subport))
+	;
+      else if (unformat (line_input, "rate %U", unformat_hqos_rate, &rate))
+	;
+      else if (unformat (line_input, "burst %u", &burst))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || subport == ~0 || rate == 0)
+    {
+      error = clib_error_return (0, "interface, subport and rate required");
+      goto done;
+    }
+
+  rv = hqos_subport_config (vm, sw_if_index, subport, rate, burst);
+  error = hqos_rv_to_error (rv, "subport or rate");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Shape a subport of the port. Subports start at the port rate.
+ *
+ * @cliexpar
+ * @cliexcmd{set hqos subport GigabitEthernet0/8/0 subport 0 rate 1 gbps}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_subport_command, static) = {
+  .path = "set hqos subport",
+  .short_help = "set hqos subport <interface> subport <n> rate <n> "
+    "[gbps|mbps|kbps] [burst <bytes>]",
+  .function = hqos_subport_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_pipe_profile_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, profile = ~0, burst = 0, tc, w[4];
+  hqos_pipe_profile_t pp = { 0 };
+  clib_error_t *error = 0;
+  int i, rv;
+  f64 rate;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "profile %u", &profile))
+	;
+      else if (unformat (line_input, "tc %u rate %U", &tc,
+			 unformat_hqos_rate, &rate))
+	{
+	  if (tc >= HQOS_N_TRAFFIC_CLASSES)
+	    {
+	      error = clib_error_return (0, "invalid tc %u", tc);
+	      goto done;
+	    }
+	  pp.tc_rate[tc] = rate;
+	}
+      else if (unformat (line_input, "tc %u weights %u %u %u %u", &tc,
+			 w, w + 1, w + 2, w + 3))
+	{
+	  if (tc >= HQOS_N_TRAFFIC_CLASSES)
+	    {
+	      error = clib_error_return (0, "invalid tc %u", tc);
+	      goto done;
+	    }
+	  for (i = 0; i < HQOS_N_QUEUES_PER_TC; i++)
+	    pp.weights[tc * HQOS_N_QUEUES_PER_TC + i] =
+	      clib_min (w[i], 255);
+	}
+      else if (unformat (line_input, "rate %U", unformat_hqos_rate,
+			 &pp.rate))
+	;
+      else if (unformat (line_input, "burst %u", &burst))
+	pp.burst = burst;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || profile == ~0 || pp.rate == 0)
+    {
+      error = clib_error_return (0, "interface, profile and rate required");
+      goto done;
+    }
+
+  rv = hqos_pipe_profile_config (vm, sw_if_index, profile, &pp);
+  error = hqos_rv_to_error (rv, "profile or rate");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Add or change a pipe profile. Traffic classes are capped at the pipe
+ * rate unless a lower '<em>tc</em>' rate is given, the queues of a traffic
+ * class share it by '<em>weights</em>', 1 by default. Profiles are added
+ * in order, profile 0 exists and is used by all pipes initially.
+ *
+ * @cliexpar
+ * @cliexcmd{set hqos pipe-profile GigabitEthernet0/8/0 profile 1 rate 10 mbps tc 0 rate 2 mbps}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_pipe_profile_command, static) = {
+  .path = "set hqos pipe-profile",
+  .short_help = "set hqos pipe-profile <interface> profile <n> rate <n> "
+    "[gbps|mbps|kbps] [burst <bytes>] [tc <n> rate <n>] "
+    "[tc <n> weights <w0> <w1> <w2> <w3>]",
+  .function = hqos_pipe_profile_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_pipe_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		      vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, subport = 0, first = ~0, last = ~0, profile = ~0;
+  clib_error_t *error = 0;
+  int rv = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "subport %u", &subport))
+	;
+      else if (unformat (line_input, "pipe %u - %u", &first, &last))
+	;
+      else if (unformat (line_input, "pipe %u", &first))
+	last = first;
+      else if (unformat (line_input, "profile %u", &profile))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || first == ~0 || profile == ~0 || first > last)
+    {
+      error = clib_error_return (0, "interface, pipe and profile required");
+      goto done;
+    }
+
+  for (; first <= last && rv == 0; first++)
+    rv = hqos_pipe_config (vm, sw_if_index, subport, first, profile);
+  error = hqos_rv_to_error (rv, "subport, pipe or profile");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Assign a pipe profile to a pipe or a range of pipes of a subport.
+ *
+ * @cliexpar
+ * @cliexcmd{set hqos pipe GigabitEthernet0/8/0 subport 0 pipe 0 - 63 profile 1}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_pipe_command, static) = {
+  .path = "set hqos pipe",
+  .short_help = "set hqos pipe <interface> [subport <n>] pipe <n> [- <n>] "
+    "profile <n>",
+  .function = hqos_pipe_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_classify_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			  vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, offset = 0;
+  clib_error_t *error = 0;
+  int is_pipe = -1, rv;
+  u64 mask = 0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "subport"))
+	is_pipe = 0;
+      else if (unformat (line_input, "pipe"))
+	is_pipe = 1;
+      else if (unformat (line_input, "offset %u", &offset))
+	;
+      else if (unformat (line_input, "mask 0x%llx", &mask))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || is_pipe == -1 || offset > 0xffff)
+    {
+      error = clib_error_return (0, "interface and subport|pipe required");
+      goto done;
+    }
+
+  rv = hqos_classify_config (vm, sw_if_index, is_pipe, offset, mask);
+  error = hqos_rv_to_error (rv, "mask, selects more subports or pipes "
+			    "than configured");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Select the subport or the pipe of a packet from its headers: the
+ * 8 bytes at '<em>offset</em>' from the start of the packet, taken in
+ * network order and masked. Packets too short for the field go to
+ * subport or pipe 0.
+ *
+ * @cliexpar
+ * Pipe from the VLAN id of a tagged ethernet frame:
+ * @cliexcmd{set hqos classify GigabitEthernet0/8/0 pipe offset 12 mask 0x00000fff00000000}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_classify_command, static) = {
+  .path = "set hqos classify",
+  .short_help = "set hqos classify <interface> subport|pipe offset <n> "
+    "mask 0x<hex>",
+  .function = hqos_classify_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_tc_map_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, bits = ~0, tc = ~0, queue = 0;
+  clib_error_t *error = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "qos-bits %u", &bits))
+	;
+      else if (unformat (line_input, "tc %u", &tc))
+	;
+      else if (unformat (line_input, "queue %u", &queue))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || bits > 255 || tc == ~0)
+    {
+      error = clib_error_return (0, "interface, qos-bits and tc required");
+      goto done;
+    }
+
+  rv = hqos_tc_map_config (vm, sw_if_index, bits, clib_min (tc, 255),
+			   clib_min (queue, 255));
+  error = hqos_rv_to_error (rv, "tc or queue");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Map the QoS bits recorded on the packet, see '<em>qos record</em>', to
+ * a traffic class and a queue of the pipe. By default the bits are taken
+ * as the IP TOS, the DSCP class selector gives the traffic class, CS6 and
+ * CS7 going to traffic class 0. Packets without recorded bits go to
+ * traffic class 3, queue 0.
+ *
+ * @cliexpar
+ * @cliexcmd{set hqos tc-map GigabitEthernet0/8/0 qos-bits 184 tc 0 queue 0}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_tc_map_command, static) = {
+  .path = "set hqos tc-map",
+  .short_help = "set hqos tc-map <interface> qos-bits <n> tc <n> "
+    "[queue <n>]",
+  .function = hqos_tc_map_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+hqos_show_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		      vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  hqos_main_t *hm = &hqos_main;
+  u32 sw_if_index = ~0;
+  hqos_port_t *port;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index != ~0)
+    {
+      if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+	return clib_error_return (0, "hqos not enabled on interface");
+      vlib_cli_output (vm, "%U", format_hqos_port, port, verbose);
+      return 0;
+    }
+
+  /* *INDENT-OFF* */
+  pool_foreach (port, hm->ports,
+    ({
+      vlib_cli_output (vm, "%U", format_hqos_port, port, verbose);
+    }));
+  /* *INDENT-ON* */
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (hqos_show_command, static) = {
+  .path = "show hqos",
+  .short_help = "show hqos [<interface>] [verbose]",
+  .function = hqos_show_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,476 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/plugin/plugin.h>
+#include <vpp/app/version.h>
+
+#include <hqos/hqos.h>
+
+#define hqos_log_debug(p, f, ...)					\
+  vlib_log (VLIB_LOG_LEVEL_DEBUG, hqos_main.log_class, "%U: " f,	\
+	    format_vnet_sw_if_index_name, vnet_get_main (),		\
+	    (p)->sw_if_index, ##__VA_ARGS__)
+
+hqos_main_t hqos_main;
+
+static f64
+hqos_default_burst (f64 rate)
+{
+  /* 10ms worth of traffic, at least a few jumbo frames */
+  return clib_max (rate / 100, 16 << 10);
+}
+
+static void
+hqos_pipe_init (hqos_port_t * port, hqos_pipe_t * pipe, u32 profile,
+		f64 now)
+{
+  hqos_pipe_profile_t *pp = vec_elt_at_index (port->pipe_profiles, profile);
+  int i;
+
+  pipe->profile = profile;
+  hqos_token_bucket_init (&pipe->tb, pp->rate, pp->burst, now);
+  for (i = 0; i < HQOS_N_TRAFFIC_CLASSES; i++)
+    hqos_token_bucket_init (&pipe->tc_tb[i], pp->tc_rate[i], pp->burst, now);
+}
+
+static void
+hqos_profile_defaults (hqos_pipe_profile_t * pp)
+{
+  int i;
+
+  if (pp->burst == 0)
+    pp->burst = hqos_default_burst (pp->rate);
+  for (i = 0; i < HQOS_N_TRAFFIC_CLASSES; i++)
+    if (pp->tc_rate[i] == 0)
+      pp->tc_rate[i] = pp->rate;
+  for (i = 0; i < HQOS_N_QUEUES_PER_PIPE; i++)
+    if (pp->weights[i] == 0)
+      pp->weights[i] = 1;
+}
+
+int
+hqos_port_create (vlib_main_t * vm, u32 sw_if_index,
+		  hqos_port_args_t * args)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  hqos_main_t *hm = &hqos_main;
+  u32 n_threads = vec_len (vlib_mains);
+  hqos_pipe_profile_t *pp;
+  vnet_sw_interface_t *sw;
+  vnet_hw_interface_t *hw;
+  hqos_subport_t *sp;
+  hqos_pipe_t *pipe;
+  hqos_port_t *port;
+  f64 now = vlib_time_now (vm);
+  uword n_buffers;
+  u32 i;
+
+  if (pool_is_free_index (vnm->interface_main.sw_interfaces, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  /* the scheduler transmits directly to the device tx node */
+  sw = vnet_get_sw_interface (vnm, sw_if_index);
+  if (sw->type != VNET_SW_INTERFACE_TYPE_HARDWARE)
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  if (hqos_port_get_by_sw_if_index (sw_if_index))
+    return VNET_API_ERROR_ENTRY_ALREADY_EXISTS;
+
+  if (args->n_subports == 0)
+    args->n_subports = HQOS_DEFAULT_N_SUBPORTS;
+  if (args->n_pipes == 0)
+    args->n_pipes = HQOS_DEFAULT_N_PIPES;
+  if (args->queue_size == 0)
+    args->queue_size = HQOS_DEFAULT_QUEUE_SIZE;
+
+  if (args->rate <= 0 || !is_pow2 (args->queue_size) ||
+      args->queue_size > HQOS_MAX_QUEUE_SIZE ||
+      args->n_subports > 256 || args->n_pipes > (1 << 20))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* with workers the main thread does not poll handoff queues */
+  if (args->thread_index != ~0 &&
+      (args->thread_index >= n_threads ||
+       (args->thread_index == 0 && n_threads > 1)))
+    return VNET_API_ERROR_INVALID_WORKER;
+
+  if (n_threads > 1 && hm->frame_queue_index == ~0)
+    hm->frame_queue_index =
+      vlib_frame_queue_main_init (hqos_handoff_node.index, 0);
+
+  hw = vnet_get_sup_hw_interface (vnm, sw_if_index);
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  pool_get_zero (hm->ports, port);
+  port->index = port - hm->ports;
+  port->sw_if_index = sw_if_index;
+  port->hw_if_index = hw->hw_if_index;
+  port->n_pipes = args->n_pipes;
+  port->queue_size = args->queue_size;
+  port->frame_overhead = args->frame_overhead;
+  port->tx_next_index = vlib_node_add_next (vm, hqos_sched_node.index,
+					    hw->tx_node_index);
+
+  /* spread ports over workers, main thread only without workers */
+  if (args->thread_index != ~0)
+    port->thread_index = args->thread_index;
+  else if (n_threads > 1)
+    port->thread_index = 1 + port->index % (n_threads - 1);
+
+  hqos_token_bucket_init (&port->tb, args->rate,
+			  hqos_default_burst (args->rate), now);
+
+  /* profile 0, every pipe may use the whole port */
+  vec_add2 (port->pipe_profiles, pp, 1);
+  pp->rate = args->rate;
+  hqos_profile_defaults (pp);
+
+  vec_validate (port->subports, args->n_subports - 1);
+  clib_bitmap_validate (port->active_subports, args->n_subports);
+  vec_foreach (sp, port->subports)
+  {
+    hqos_token_bucket_init (&sp->tb, args->rate,
+			    hqos_default_burst (args->rate), now);
+    vec_validate (sp->pipes, args->n_pipes - 1);
+    clib_bitmap_validate (sp->active_pipes, args->n_pipes);
+    vec_foreach (pipe, sp->pipes) hqos_pipe_init (port, pipe, 0, now);
+  }
+
+  n_buffers = (uword) args->n_subports * args->n_pipes *
+    HQOS_N_QUEUES_PER_PIPE * args->queue_size;
+  vec_validate_aligned (port->buffers, n_buffers - 1, CLIB_CACHE_LINE_BYTES);
+
+  /* by default the qos bits are taken as the ip tos, as recorded by
+     qos-record, the dscp class selector picks the traffic class, inverted
+     so that cs6 and cs7 get tc 0 */
+  for (i = 0; i < ARRAY_LEN (port->tc_map); i++)
+    port->tc_map[i] = hqos_tc_map_entry (HQOS_N_TRAFFIC_CLASSES - 1 -
+					 (i >> 6), (i >> 4) & 3);
+
+  vec_validate_init_empty (hm->port_index_by_sw_if_index, sw_if_index, ~0);
+  hm->port_index_by_sw_if_index[sw_if_index] = port->index;
+  vec_validate (hm->port_indices_by_thread, n_threads - 1);
+  vec_add1 (hm->port_indices_by_thread[port->thread_index], port->index);
+  vlib_node_set_state (vlib_mains[port->thread_index],
+		       hqos_sched_node.index, VLIB_NODE_STATE_POLLING);
+
+  vlib_worker_thread_barrier_release (vm);
+
+  vnet_feature_enable_disable ("interface-output", "hqos-output",
+			       sw_if_index, 1, 0, 0);
+
+  hqos_log_debug (port, "created, thread %u, %u subports, %u pipes",
+		  port->thread_index, args->n_subports, args->n_pipes);
+  return 0;
+}
+
+int
+hqos_port_delete (vlib_main_t * vm, u32 sw_if_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  u32 **indices, mask, si, pi, qi;
+  hqos_subport_t *sp;
+  hqos_pipe_t *pipe;
+  hqos_port_t *port;
+  hqos_queue_t *q;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  vnet_feature_enable_disable ("interface-output", "hqos-output",
+			       sw_if_index, 0, 0, 0);
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  indices = vec_elt_at_index (hm->port_indices_by_thread, port->thread_index);
+  vec_del1 (indices[0], vec_search (indices[0], port->index));
+  if (vec_len (indices[0]) == 0)
+    vlib_node_set_state (vlib_mains[port->thread_index],
+			 hqos_sched_node.index, VLIB_NODE_STATE_DISABLED);
+  hm->port_index_by_sw_if_index[sw_if_index] = ~0;
+
+  /* packets still queued */
+  mask = port->queue_size - 1;
+  vec_foreach_index (si, port->subports)
+  {
+    sp = vec_elt_at_index (port->subports, si);
+    /* *INDENT-OFF* */
+    clib_bitmap_foreach (pi, sp->active_pipes,
+      ({
+	pipe = vec_elt_at_index (sp->pipes, pi);
+	for (qi = 0; qi < HQOS_N_QUEUES_PER_PIPE; qi++)
+	  {
+	    q = pipe->queues + qi;
+	    if (q->tail != q->head)
+	      vlib_buffer_free_from_ring (vm,
+					  hqos_queue_buffers (port, si, pi,
+							      qi),
+					  q->head & mask, port->queue_size,
+					  (u16) (q->tail - q->head));
+	  }
+      }));
+    /* *INDENT-ON* */
+    vec_free (sp->pipes);
+    clib_bitmap_free (sp->active_pipes);
+  }
+
+  hqos_log_debug (port, "deleted");
+
+  vec_free (port->subports);
+  clib_bitmap_free (port->active_subports);
+  vec_free (port->pipe_profiles);
+  vec_free (port->buffers);
+  pool_put (hm->ports, port);
+
+  vlib_worker_thread_barrier_release (vm);
+  return 0;
+}
+
+int
+hqos_subport_config (vlib_main_t * vm, u32 sw_if_index, u32 subport,
+		     f64 rate, f64 burst)
+{
+  hqos_port_t *port;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  if (subport >= vec_len (port->subports) || rate <= 0 || burst < 0)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (burst == 0)
+    burst = hqos_default_burst (rate);
+  hqos_token_bucket_init (&port->subports[subport].tb, rate, burst,
+			  vlib_time_now (vm));
+  return 0;
+}
+
+int
+hqos_pipe_profile_config (vlib_main_t * vm, u32 sw_if_index, u32 profile,
+			  hqos_pipe_profile_t * pp)
+{
+  f64 now = vlib_time_now (vm);
+  hqos_subport_t *sp;
+  hqos_pipe_t *pipe;
+  hqos_port_t *port;
+  int i;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  /* existing profile or the next one */
+  if (profile > vec_len (port->pipe_profiles) || profile > 0xffff)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (pp->rate <= 0 || pp->burst < 0)
+    return VNET_API_ERROR_INVALID_VALUE;
+  for (i = 0; i < HQOS_N_TRAFFIC_CLASSES; i++)
+    if (pp->tc_rate[i] < 0)
+      return VNET_API_ERROR_INVALID_VALUE;
+
+  vec_validate (port->pipe_profiles, profile);
+  port->pipe_profiles[profile] = pp[0];
+  hqos_profile_defaults (port->pipe_profiles + profile);
+
+  vec_foreach (sp, port->subports)
+    vec_foreach (pipe, sp->pipes)
+      if (pipe->profile == profile)
+        hqos_pipe_init (port, pipe, profile, now);
+
+  return 0;
+}
+
+int
+hqos_pipe_config (vlib_main_t * vm, u32 sw_if_index, u32 subport, u32 pipe,
+		  u32 profile)
+{
+  hqos_port_t *port;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  if (subport >= vec_len (port->subports) || pipe >= port->n_pipes ||
+      profile >= vec_len (port->pipe_profiles))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  hqos_pipe_init (port, port->subports[subport].pipes + pipe, profile,
+		  vlib_time_now (vm));
+  return 0;
+}
+
+int
+hqos_classify_config (vlib_main_t * vm, u32 sw_if_index, int is_pipe,
+		      u16 offset, u64 mask)
+{
+  hqos_pkt_field_t *f;
+  hqos_port_t *port;
+  u32 n, shift;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  f = is_pipe ? &port->pipe_field : &port->subport_field;
+  n = is_pipe ? port->n_pipes : vec_len (port->subports);
+
+  /* a zero mask puts everything into subport or pipe 0 */
+  shift = mask ? count_trailing_zeros (mask) : 0;
+  if ((mask >> shift) >= n)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  f->offset = offset;
+  f->mask = mask;
+  f->shift = shift;
+  return 0;
+}
+
+int
+hqos_tc_map_config (vlib_main_t * vm, u32 sw_if_index, u8 qos_bits, u8 tc,
+		    u8 queue)
+{
+  hqos_port_t *port;
+
+  if (!(port = hqos_port_get_by_sw_if_index (sw_if_index)))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  if (tc >= HQOS_N_TRAFFIC_CLASSES || queue >= HQOS_N_QUEUES_PER_TC)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  port->tc_map[qos_bits] = hqos_tc_map_entry (tc, queue);
+  return 0;
+}
+
+static u8 *
+format_hqos_rate (u8 * s, va_list * args)
+{
+  f64 bps = va_arg (*args, f64) * 8;
+
+  if (bps >= 1e9)
+    return format (s, "%.2fGbps", bps / 1e9);
+  if (bps >= 1e6)
+    return format (s, "%.2fMbps", bps / 1e6);
+  if (bps >= 1e3)
+    return format (s, "%.2fKbps", bps / 1e3);
+  return format (s, "%.0fbps", bps);
+}
+
+u8 *
+format_hqos_port (u8 * s, va_list * args)
+{
+  hqos_port_t *port = va_arg (*args, hqos_port_t *);
+  int verbose = va_arg (*args, int);
+  u32 indent = format_get_indent (s);
+  hqos_pipe_profile_t *pp;
+  hqos_tc_counters_t *c;
+  hqos_subport_t *sp;
+  u32 n_active = 0;
+  int i;
+
+  vec_foreach (sp, port->subports) n_active += sp->n_active_pipes;
+
+  s = format (s, "%U: rate %U thread %u subports %u pipes %u queue-size %u "
+	      "frame-overhead %u",
+	      format_vnet_sw_if_index_name, vnet_get_main (),
+	      port->sw_if_index, format_hqos_rate, port->tb.rate,
+	      port->thread_index, vec_len (port->subports), port->n_pipes,
+	      port->queue_size, port->frame_overhead);
+
+  s = format (s, "\n%Uactive pipes %u", format_white_space, indent + 2,
+	      n_active);
+
+  if (port->subport_field.mask)
+    s = format (s, "\n%Usubport classify offset %u mask 0x%llx",
+		format_white_space, indent + 2, port->subport_field.offset,
+		port->subport_field.mask);
+  if (port->pipe_field.mask)
+    s = format (s, "\n%Upipe classify offset %u mask 0x%llx",
+		format_white_space, indent + 2, port->pipe_field.offset,
+		port->pipe_field.mask);
+
+  vec_foreach (sp, port->subports)
+  {
+    s = format (s, "\n%Usubport %u: rate %U burst %.0f active pipes %u",
+		format_white_space, indent + 2, sp - port->subports,
+		format_hqos_rate, sp->tb.rate, sp->tb.size,
+		sp->n_active_pipes);
+  }
+
+  vec_foreach (pp, port->pipe_profiles)
+  {
+    s = format (s, "\n%Uprofile %u: rate %U burst %.0f",
+		format_white_space, indent + 2, pp - port->pipe_profiles,
+		format_hqos_rate, pp->rate, pp->burst);
+    if (!verbose)
+      continue;
+    for (i = 0; i < HQOS_N_TRAFFIC_CLASSES; i++)
+      s = format (s, "\n%Utc %u: rate %U weights %u %u %u %u",
+		  format_white_space, indent + 4, i, format_hqos_rate,
+		  pp->tc_rate[i], pp->weights[i * HQOS_N_QUEUES_PER_TC],
+		  pp->weights[i * HQOS_N_QUEUES_PER_TC + 1],
+		  pp->weights[i * HQOS_N_QUEUES_PER_TC + 2],
+		  pp->weights[i * HQOS_N_QUEUES_PER_TC + 3]);
+  }
+
+  for (i = 0; i < HQOS_N_TRAFFIC_CLASSES; i++)
+    {
+      c = port->counters + i;
+      s = format (s, "\n%Utc %u: enqueued %lu transmitted %lu bytes %lu "
+		  "dropped %lu", format_white_space, indent + 2, i,
+		  c->enqueued, c->transmitted, c->transmitted_bytes,
+		  c->dropped);
+    }
+
+  return s;
+}
+
+static clib_error_t *
+hqos_init (vlib_main_t * vm)
+{
+  hqos_main_t *hm = &hqos_main;
+
+  hm->frame_queue_index = ~0;
+  hm->log_class = vlib_log_register_class ("hqos", 0);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (hqos_init);
+
+/* *INDENT-OFF* */
+VNET_FEATURE_INIT (hqos_output, static) = {
+  .arc_name = "interface-output",
+  .node_name = "hqos-output",
+  /* packets leave the arc here, straight to the device */
+  .runs_after = VNET_FEATURES ("span-output", "ipsec-if-output"),
+  .runs_before = VNET_FEATURES ("interface-tx"),
+};
+
+VLIB_PLUGIN_REGISTER () = {
+  .version = VPP_BUILD_VER,
+  .description = "Hierarchical QoS scheduler",
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,239 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _HQOS_H_
+#define _HQOS_H_
+
+#include <vnet/vnet.h>
+
+/*
+ * Hierarchical scheduler: port / subport / pipe / traffic class / queue.
+ *
+ * Port, subports and pipes are shaped by token buckets, each pipe traffic
+ * class may be capped by its own token bucket. Within a pipe traffic
+ * classes are served in strict priority, 0 first, and the queues of a
+ * traffic class by deficit weighted round robin. Active pipes of a
+ * subport and active subports of a port are served round robin.
+ */
+
+#define HQOS_N_TRAFFIC_CLASSES	4
+#define HQOS_N_QUEUES_PER_TC	4
+#define HQOS_N_QUEUES_PER_PIPE	(HQOS_N_TRAFFIC_CLASSES * HQOS_N_QUEUES_PER_TC)
+
+/* deficit round robin quantum of a queue of weight 1 */
+#define HQOS_WRR_QUANTUM	1536
+
+#define HQOS_DEFAULT_N_SUBPORTS		1
+#define HQOS_DEFAULT_N_PIPES		4096
+#define HQOS_DEFAULT_QUEUE_SIZE		64
+#define HQOS_MAX_QUEUE_SIZE		4096
+/* preamble, inter frame gap and fcs */
+#define HQOS_DEFAULT_FRAME_OVERHEAD	24
+
+typedef struct
+{
+  /* bytes per second */
+  f64 rate;
+  /* bucket depth, bytes */
+  f64 size;
+  f64 tokens;
+  f64 last_update;
+} hqos_token_bucket_t;
+
+typedef struct
+{
+  u64 mask;
+  u16 offset;
+  u8 shift;
+} hqos_pkt_field_t;
+
+typedef struct
+{
+  /* pipe shaper, bytes per second */
+  f64 rate;
+  f64 burst;
+  /* traffic class ceilings, bytes per second */
+  f64 tc_rate[HQOS_N_TRAFFIC_CLASSES];
+  /* round robin weights of the queues, by traffic class */
+  u8 weights[HQOS_N_QUEUES_PER_PIPE];
+} hqos_pipe_profile_t;
+
+typedef struct
+{
+  u16 head;
+  u16 tail;
+  i32 deficit;
+} hqos_queue_t;
+
+typedef struct
+{
+  hqos_token_bucket_t tb;
+  hqos_token_bucket_t tc_tb[HQOS_N_TRAFFIC_CLASSES];
+  /* bitmap of non-empty queues */
+  u16 active_queues;
+  u16 profile;
+  /* current queue of each traffic class */
+  u8 wrr_queue[HQOS_N_TRAFFIC_CLASSES];
+  hqos_queue_t queues[HQOS_N_QUEUES_PER_PIPE];
+} hqos_pipe_t;
+
+typedef struct
+{
+  hqos_token_bucket_t tb;
+  hqos_pipe_t *pipes;
+  /* pipes with queued packets */
+  uword *active_pipes;
+  u32 n_active_pipes;
+  /* round robin position */
+  u32 next_pipe;
+} hqos_subport_t;
+
+typedef struct
+{
+  u64 enqueued;
+  u64 transmitted;
+  u64 transmitted_bytes;
+  u64 dropped;
+} hqos_tc_counters_t;
+
+typedef struct
+{
+  u32 index;
+  u32 sw_if_index;
+  u32 hw_if_index;
+  /* thread running the scheduler, packets are handed off to it */
+  u32 thread_index;
+  /* next of hqos-sched to the interface tx node */
+  u32 tx_next_index;
+
+  hqos_token_bucket_t tb;
+  u32 frame_overhead;
+  u32 n_pipes;
+  u16 queue_size;
+
+  hqos_subport_t *subports;
+  uword *active_subports;
+  u32 next_subport;
+  hqos_pipe_profile_t *pipe_profiles;
+
+  /* buffer indices of all queues, queue_size per queue */
+  u32 *buffers;
+
+  /* classification: subport and pipe from packet fields, traffic class
+     and queue from the qos bits recorded on ingress */
+  hqos_pkt_field_t subport_field;
+  hqos_pkt_field_t pipe_field;
+  u8 tc_map[256];
+
+  hqos_tc_counters_t counters[HQOS_N_TRAFFIC_CLASSES];
+} hqos_port_t;
+
+typedef struct
+{
+  hqos_port_t *ports;
+  u32 *port_index_by_sw_if_index;
+  /* ports scheduled by each thread */
+  u32 **port_indices_by_thread;
+  u32 frame_queue_index;
+
+  vlib_log_class_t log_class;
+} hqos_main_t;
+
+extern hqos_main_t hqos_main;
+extern vlib_node_registration_t hqos_output_node;
+extern vlib_node_registration_t hqos_handoff_node;
+extern vlib_node_registration_t hqos_sched_node;
+
+typedef struct
+{
+  f64 rate;
+  u32 n_subports;
+  u32 n_pipes;
+  u32 queue_size;
+  u32 frame_overhead;
+  /* ~0 to pick one */
+  u32 thread_index;
+} hqos_port_args_t;
+
+int hqos_port_create (vlib_main_t * vm, u32 sw_if_index,
+		      hqos_port_args_t * args);
+int hqos_port_delete (vlib_main_t * vm, u32 sw_if_index);
+int hqos_subport_config (vlib_main_t * vm, u32 sw_if_index, u32 subport,
+			 f64 rate, f64 burst);
+int hqos_pipe_profile_config (vlib_main_t * vm, u32 sw_if_index,
+			      u32 profile, hqos_pipe_profile_t * pp);
+int hqos_pipe_config (vlib_main_t * vm, u32 sw_if_index, u32 subport,
+		      u32 pipe, u32 profile);
+int hqos_classify_config (vlib_main_t * vm, u32 sw_if_index, int is_pipe,
+			  u16 offset, u64 mask);
+int hqos_tc_map_config (vlib_main_t * vm, u32 sw_if_index, u8 qos_bits,
+			u8 tc, u8 queue);
+
+format_function_t format_hqos_port;
+
+static_always_inline hqos_port_t *
+hqos_port_get_by_sw_if_index (u32 sw_if_index)
+{
+  hqos_main_t *hm = &hqos_main;
+  u32 *pi;
+
+  if (sw_if_index >= vec_len (hm->port_index_by_sw_if_index))
+    return 0;
+  pi = vec_elt_at_index (hm->port_index_by_sw_if_index, sw_if_index);
+  return *pi == ~0 ? 0 : pool_elt_at_index (hm->ports, *pi);
+}
+
+static_always_inline void
+hqos_token_bucket_init (hqos_token_bucket_t * tb, f64 rate, f64 size,
+			f64 now)
+{
+  tb->rate = rate;
+  tb->size = size;
+  tb->tokens = size;
+  tb->last_update = now;
+}
+
+static_always_inline void
+hqos_token_bucket_update (hqos_token_bucket_t * tb, f64 now)
+{
+  tb->tokens += (now - tb->last_update) * tb->rate;
+  tb->tokens = clib_min (tb->tokens, tb->size);
+  tb->last_update = now;
+}
+
+static_always_inline u32 *
+hqos_queue_buffers (hqos_port_t * port, u32 subport, u32 pipe, u32 queue)
+{
+  uword q = ((uword) subport * port->n_pipes + pipe) *
+    HQOS_N_QUEUES_PER_PIPE + queue;
+  return port->buffers + q * port->queue_size;
+}
+
+/* tc_map entries */
+#define hqos_tc_map_entry(tc, queue)	((tc) << 2 | (queue))
+#define hqos_tc_map_tc(e)		((e) >> 2)
+#define hqos_tc_map_queue(e)		((e) & 3)
+
+#endif /* _HQOS_H_ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,521 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+#include <hqos/hqos.h>
+
+#define foreach_hqos_error					\
+  _(NOT_SCHEDULED, "interface not scheduled")			\
+  _(INVALID_PIPE, "invalid subport or pipe")			\
+  _(QUEUE_FULL, "queue full")					\
+  _(CONGESTION_DROP, "handoff congestion drop")			\
+  _(TRANSMITTED, "transmitted")
+
+typedef enum
+{
+  HQOS_ERROR_NONE,
+#define _(f,s) HQOS_ERROR_##f,
+  foreach_hqos_error
+#undef _
+    HQOS_N_ERROR,
+} hqos_error_t;
+
+static char *hqos_error_strings[] = {
+  "no error",
+#define _(n,s) s,
+  foreach_hqos_error
+#undef _
+};
+
+typedef enum
+{
+  HQOS_NEXT_DROP,
+  HQOS_N_NEXT,
+} hqos_next_t;
+
+/* packets sent by a pipe in one visit, before moving to the next pipe */
+#define HQOS_PIPE_BURST 8
+
+typedef struct
+{
+  u32 sw_if_index;
+  u32 subport;
+  u32 pipe;
+  u8 tc;
+  u8 queue;
+  u8 error;
+  u8 handoff;
+  u32 thread_index;
+} hqos_trace_t;
+
+static u8 *
+format_hqos_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  hqos_trace_t *t = va_arg (*args, hqos_trace_t *);
+
+  s = format (s, "hqos: sw_if_index %u", t->sw_if_index);
+  if (t->handoff)
+    return format (s, " handoff to thread %u", t->thread_index);
+  if (t->error == HQOS_ERROR_TRANSMITTED)
+    return format (s, " scheduled");
+  s = format (s, " subport %u pipe %u tc %u queue %u", t->subport, t->pipe,
+	      t->tc, t->queue);
+  if (t->error != HQOS_ERROR_NONE)
+    s = format (s, " %s", hqos_error_strings[t->error]);
+  return s;
+}
+
+static_always_inline u32
+hqos_pkt_field_get (vlib_buffer_t * b, hqos_pkt_field_t * f)
+{
+  u8 *p = vlib_buffer_get_current (b) + f->offset;
+
+  if (f->mask == 0 || f->offset + sizeof (u64) > b->current_length)
+    return 0;
+
+  return (clib_net_to_host_u64 (clib_mem_unaligned (p, u64)) & f->mask) >>
+    f->shift;
+}
+
+static_always_inline hqos_error_t
+hqos_enqueue_one (hqos_port_t * port, u32 bi, vlib_buffer_t * b,
+		  hqos_trace_t * t)
+{
+  u32 subport, pipe, tc, queue, qi;
+  hqos_subport_t *sp;
+  hqos_pipe_t *pp;
+  hqos_queue_t *q;
+  u8 e;
+
+  subport = hqos_pkt_field_get (b, &port->subport_field);
+  pipe = hqos_pkt_field_get (b, &port->pipe_field);
+
+  /* unmarked traffic is best effort */
+  if (b->flags & VNET_BUFFER_F_QOS_DATA_VALID)
+    e = port->tc_map[vnet_buffer2 (b)->qos.bits];
+  else
+    e = hqos_tc_map_entry (HQOS_N_TRAFFIC_CLASSES - 1, 0);
+  tc = hqos_tc_map_tc (e);
+  queue = hqos_tc_map_queue (e);
+
+  t->subport = subport;
+  t->pipe = pipe;
+  t->tc = tc;
+  t->queue = queue;
+
+  /* field masks are checked on config, not if the port shrinks under a
+     stale classify config */
+  if (PREDICT_FALSE (subport >= vec_len (port->subports) ||
+		     pipe >= port->n_pipes))
+    return HQOS_ERROR_INVALID_PIPE;
+
+  sp = port->subports + subport;
+  pp = sp->pipes + pipe;
+  qi = tc * HQOS_N_QUEUES_PER_TC + queue;
+  q = pp->queues + qi;
+
+  /* tail drop */
+  if (PREDICT_FALSE ((u16) (q->tail - q->head) >= port->queue_size))
+    {
+      port->counters[tc].dropped++;
+      return HQOS_ERROR_QUEUE_FULL;
+    }
+
+  hqos_queue_buffers (port, subport, pipe, qi)[q->tail &
+					       (port->queue_size - 1)] = bi;
+  q->tail++;
+  port->counters[tc].enqueued++;
+
+  if (pp->active_queues == 0)
+    {
+      if (sp->n_active_pipes++ == 0)
+	clib_bitmap_set_no_check (port->active_subports, subport, 1);
+      clib_bitmap_set_no_check (sp->active_pipes, pipe, 1);
+    }
+  pp->active_queues |= 1 << qi;
+  return HQOS_ERROR_NONE;
+}
+
+static_always_inline uword
+hqos_enqueue_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+		     vlib_frame_t * frame, int is_handoff)
+{
+  hqos_main_t *hm = &hqos_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 drops[VLIB_FRAME_SIZE], handoff[VLIB_FRAME_SIZE];
+  u16 thread_indices[VLIB_FRAME_SIZE];
+  u32 n_drop = 0, n_handoff = 0, n_left, *from;
+  u32 thread_index = vm->thread_index;
+  u32 last_sw_if_index = ~0;
+  hqos_port_t *port = 0;
+  hqos_error_t error;
+  hqos_trace_t t;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left)
+    {
+      u32 sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_TX];
+
+      if (PREDICT_FALSE (sw_if_index != last_sw_if_index))
+	{
+	  port = hqos_port_get_by_sw_if_index (sw_if_index);
+	  last_sw_if_index = sw_if_index;
+	}
+
+      clib_memset (&t, 0, sizeof (t));
+      t.sw_if_index = sw_if_index;
+
+      if (PREDICT_FALSE (port == 0))
+	error = HQOS_ERROR_NOT_SCHEDULED;
+      else if (!is_handoff && port->thread_index != thread_index)
+	{
+	  /* the owner thread is the only one touching the queues */
+	  handoff[n_handoff] = from[0];
+	  thread_indices[n_handoff++] = port->thread_index;
+	  t.handoff = 1;
+	  t.thread_index = port->thread_index;
+	  error = HQOS_ERROR_NONE;
+	}
+      else
+	error = hqos_enqueue_one (port, from[0], b[0], &t);
+
+      if (PREDICT_FALSE (error != HQOS_ERROR_NONE))
+	{
+	  b[0]->error = node->errors[error];
+	  drops[n_drop++] = from[0];
+	}
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  hqos_trace_t *tr = vlib_add_trace (vm, node, b[0], sizeof (*tr));
+	  t.error = error;
+	  *tr = t;
+	}
+
+      from++;
+      b++;
+      n_left--;
+    }
+
+  if (n_handoff)
+    {
+      u32 n_enq = vlib_buffer_enqueue_to_thread (vm, hm->frame_queue_index,
+						 handoff, thread_indices,
+						 n_handoff, 1);
+      if (n_enq < n_handoff)
+	vlib_node_increment_counter (vm, node->node_index,
+				     HQOS_ERROR_CONGESTION_DROP,
+				     n_handoff - n_enq);
+    }
+
+  if (n_drop)
+    vlib_buffer_enqueue_to_single_next (vm, node, drops, HQOS_NEXT_DROP,
+					n_drop);
+
+  return frame->n_vectors;
+}
+
+VLIB_NODE_FN (hqos_output_node) (vlib_main_t * vm,
+				 vlib_node_runtime_t * node,
+				 vlib_frame_t * frame)
+{
+  return hqos_enqueue_inline (vm, node, frame, /* is_handoff */ 0);
+}
+
+VLIB_NODE_FN (hqos_handoff_node) (vlib_main_t * vm,
+				  vlib_node_runtime_t * node,
+				  vlib_frame_t * frame)
+{
+  return hqos_enqueue_inline (vm, node, frame, /* is_handoff */ 1);
+}
+
+/* pick the queue of a traffic class by deficit round robin, a queue gets
+   its quantum each time the round moves to it */
+static_always_inline u32
+hqos_wrr_select (vlib_main_t * vm, hqos_port_t * port, u32 subport,
+		 u32 pipe, hqos_pipe_t * pp, u32 tc, u32 * len)
+{
+  u8 *weights = port->pipe_profiles[pp->profile].weights;
+  u32 q = pp->wrr_queue[tc], qi, bi;
+  hqos_queue_t *queue;
+
+  while (1)
+    {
+      qi = tc * HQOS_N_QUEUES_PER_TC + q;
+      queue = pp->queues + qi;
+      if (pp->active_queues & (1 << qi))
+	{
+	  bi = hqos_queue_buffers (port, subport, pipe, qi)
+	    [queue->head & (port->queue_size - 1)];
+	  *len = vlib_buffer_length_in_chain (vm, vlib_get_buffer (vm, bi)) +
+	    port->frame_overhead;
+	  if (queue->deficit >= (i32) * len)
+	    break;
+	}
+      else
+	queue->deficit = 0;
+
+      q = (q + 1) % HQOS_N_QUEUES_PER_TC;
+      qi = tc * HQOS_N_QUEUES_PER_TC + q;
+      if (pp->active_queues & (1 << qi))
+	pp->queues[qi].deficit += weights[qi] * HQOS_WRR_QUANTUM;
+    }
+
+  pp->wrr_queue[tc] = q;
+  return qi;
+}
+
+/* the pipe may not send, stop for this pipe / subport / port */
+#define HQOS_BLOCKED_PIPE	1
+#define HQOS_BLOCKED_SUBPORT	2
+#define HQOS_BLOCKED_PORT	3
+
+static_always_inline u32
+hqos_pipe_dequeue (vlib_main_t * vm, hqos_port_t * port, u32 subport,
+		   u32 pipe, f64 now, u32 * to, u32 n_max, int *blocked)
+{
+  hqos_subport_t *sp = port->subports + subport;
+  hqos_pipe_t *pp = sp->pipes + pipe;
+  u32 n = 0, tc = 0, tc_updated = 0, qi, len;
+  hqos_queue_t *q;
+  u32 *buffers;
+
+  hqos_token_bucket_update (&pp->tb, now);
+
+  while (tc < HQOS_N_TRAFFIC_CLASSES && n < n_max)
+    {
+      u32 tc_mask = pow2_mask (HQOS_N_QUEUES_PER_TC) <<
+	(tc * HQOS_N_QUEUES_PER_TC);
+
+      if ((pp->active_queues & tc_mask) == 0)
+	{
+	  tc++;
+	  continue;
+	}
+
+      if ((tc_updated & (1 << tc)) == 0)
+	{
+	  hqos_token_bucket_update (&pp->tc_tb[tc], now);
+	  tc_updated |= 1 << tc;
+	}
+
+      qi = hqos_wrr_select (vm, port, subport, pipe, pp, tc, &len);
+
+      if (port->tb.tokens < len)
+	{
+	  *blocked = HQOS_BLOCKED_PORT;
+	  break;
+	}
+      if (sp->tb.tokens < len)
+	{
+	  *blocked = HQOS_BLOCKED_SUBPORT;
+	  break;
+	}
+      if (pp->tb.tokens < len)
+	break;
+
+      /* traffic class over its ceiling, lower priorities may still go */
+      if (pp->tc_tb[tc].tokens < len)
+	{
+	  tc++;
+	  continue;
+	}
+
+      port->tb.tokens -= len;
+      sp->tb.tokens -= len;
+      pp->tb.tokens -= len;
+      pp->tc_tb[tc].tokens -= len;
+
+      q = pp->queues + qi;
+      q->deficit -= len;
+      buffers = hqos_queue_buffers (port, subport, pipe, qi);
+      to[n++] = buffers[q->head & (port->queue_size - 1)];
+      q->head++;
+
+      port->counters[tc].transmitted++;
+      port->counters[tc].transmitted_bytes += len - port->frame_overhead;
+
+      if (q->head == q->tail)
+	{
+	  pp->active_queues &= ~(1 << qi);
+	  q->deficit = 0;
+	}
+    }
+
+  if (pp->active_queues == 0)
+    {
+      clib_bitmap_set_no_check (sp->active_pipes, pipe, 0);
+      if (--sp->n_active_pipes == 0)
+	clib_bitmap_set_no_check (port->active_subports, subport, 0);
+    }
+
+  return n;
+}
+
+static_always_inline u32
+hqos_subport_dequeue (vlib_main_t * vm, hqos_port_t * port, u32 subport,
+		      f64 now, u32 * to, u32 n_max, int *blocked)
+{
+  hqos_subport_t *sp = port->subports + subport;
+  u32 n = 0, n_pipes = sp->n_active_pipes, pipe;
+
+  hqos_token_bucket_update (&sp->tb, now);
+
+  /* each active pipe visited at most once per round */
+  while (n_pipes-- && n < n_max && *blocked < HQOS_BLOCKED_SUBPORT)
+    {
+      pipe = clib_bitmap_next_set (sp->active_pipes, sp->next_pipe);
+      if (pipe == ~0)
+	pipe = clib_bitmap_first_set (sp->active_pipes);
+      if (pipe == ~0)
+	break;
+
+      sp->next_pipe = pipe + 1;
+      *blocked = 0;
+      n += hqos_pipe_dequeue (vm, port, subport, pipe, now, to + n,
+			      clib_min (n_max - n, HQOS_PIPE_BURST), blocked);
+    }
+
+  return n;
+}
+
+static_always_inline u32
+hqos_port_dequeue (vlib_main_t * vm, vlib_node_runtime_t * node,
+		   hqos_port_t * port, f64 now)
+{
+  u32 to[VLIB_FRAME_SIZE], n = 0, n_round, n_subports, subport, i;
+  int blocked = 0;
+
+  if (clib_bitmap_is_zero (port->active_subports))
+    return 0;
+
+  hqos_token_bucket_update (&port->tb, now);
+  n_subports = vec_len (port->subports);
+
+  /* rounds over the active subports until the frame is full, the port
+     runs out of credit or nothing may be sent */
+  do
+    {
+      n_round = n;
+      for (i = 0; i < n_subports && n < VLIB_FRAME_SIZE; i++)
+	{
+	  subport = (port->next_subport + i) % n_subports;
+	  if (!clib_bitmap_get_no_check (port->active_subports, subport))
+	    continue;
+	  blocked = 0;
+	  n += hqos_subport_dequeue (vm, port, subport, now, to + n,
+				     VLIB_FRAME_SIZE - n, &blocked);
+	  if (blocked == HQOS_BLOCKED_PORT)
+	    break;
+	}
+      port->next_subport = (port->next_subport + i + 1) % n_subports;
+    }
+  while (n > n_round && n < VLIB_FRAME_SIZE && blocked != HQOS_BLOCKED_PORT);
+
+  if (n == 0)
+    return 0;
+
+  if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+    {
+      for (i = 0; i < n; i++)
+	{
+	  vlib_buffer_t *b = vlib_get_buffer (vm, to[i]);
+	  if (b->flags & VLIB_BUFFER_IS_TRACED)
+	    {
+	      hqos_trace_t *t = vlib_add_trace (vm, node, b, sizeof (*t));
+	      clib_memset (t, 0, sizeof (*t));
+	      t->sw_if_index = port->sw_if_index;
+	      t->error = HQOS_ERROR_TRANSMITTED;
+	    }
+	}
+    }
+
+  vlib_buffer_enqueue_to_single_next (vm, node, to, port->tx_next_index, n);
+  vlib_node_increment_counter (vm, node->node_index, HQOS_ERROR_TRANSMITTED,
+			       n);
+  return n;
+}
+
+VLIB_NODE_FN (hqos_sched_node) (vlib_main_t * vm,
+				vlib_node_runtime_t * node,
+				vlib_frame_t * frame)
+{
+  hqos_main_t *hm = &hqos_main;
+  f64 now = vlib_time_now (vm);
+  u32 *pi, n = 0;
+
+  if (vm->thread_index >= vec_len (hm->port_indices_by_thread))
+    return 0;
+
+  vec_foreach (pi, hm->port_indices_by_thread[vm->thread_index])
+    n += hqos_port_dequeue (vm, node, pool_elt_at_index (hm->ports, *pi),
+			    now);
+
+  return n;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (hqos_output_node) = {
+  .name = "hqos-output",
+  .vector_size = sizeof (u32),
+  .format_trace = format_hqos_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = HQOS_N_ERROR,
+  .error_strings = hqos_error_strings,
+  .n_next_nodes = HQOS_N_NEXT,
+  .next_nodes = {
+    [HQOS_NEXT_DROP] = "error-drop",
+  },
+};
+
+VLIB_REGISTER_NODE (hqos_handoff_node) = {
+  .name = "hqos-handoff",
+  .vector_size = sizeof (u32),
+  .format_trace = format_hqos_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = HQOS_N_ERROR,
+  .error_strings = hqos_error_strings,
+  .sibling_of = "hqos-output",
+};
+
+/* polls the queues of the ports owned by the thread, enabled on threads
+   owning at least one port */
+VLIB_REGISTER_NODE (hqos_sched_node) = {
+  .name = "hqos-sched",
+  .format_trace = format_hqos_trace,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+  .n_errors = HQOS_N_ERROR,
+  .error_strings = hqos_error_strings,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
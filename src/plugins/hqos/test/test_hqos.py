@@ -0,0 +1,153 @@
+import re
+import unittest
+
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, ICMP
+
+from framework import VppTestCase, VppTestRunner
+from vpp_papi_provider import CliFailedCommandError
+
+
+class TestHqos(VppTestCase):
+    """ Hierarchical QoS Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestHqos, cls).setUpClass()
+        cls.create_pg_interfaces(range(2))
+        for pg in cls.pg_interfaces:
+            pg.admin_up()
+            pg.config_ip4()
+            pg.resolve_arp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for pg in cls.pg_interfaces:
+            pg.unconfig_ip4()
+            pg.admin_down()
+        super(TestHqos, cls).tearDownClass()
+
+    def tearDown(self):
+        self.vapi.cli_return_response("set hqos interface pg1 disable")
+        super(TestHqos, self).tearDown()
+
+    def send_pings(self, tos_list):
+        pkts = [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4,
+                    tos=tos) /
+                 ICMP(id=1, seq=i)) for i, tos in enumerate(tos_list)]
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+    def err_counter(self, node, reason):
+        return self.statistics.get_err_counter("/err/%s/%s" % (node, reason))
+
+    def tc_counters(self, tc):
+        out = self.vapi.cli("show hqos pg1")
+        m = re.search(r"tc %d: enqueued (\d+) transmitted (\d+) bytes \d+ "
+                      r"dropped (\d+)" % tc, out)
+        self.assertIsNotNone(m, out)
+        return [int(x) for x in m.groups()]
+
+    def test_hqos_forward(self):
+        """ HQoS forwarding """
+        self.vapi.cli("set hqos interface pg1 rate 10 gbps pipes 16")
+        self.assertIn("pipes 16", self.vapi.cli("show hqos"))
+
+        n_pkts = 64
+        n_tx = self.err_counter("hqos-sched", "transmitted")
+        self.send_pings([0] * n_pkts)
+        rx = self.pg1.get_capture(n_pkts)
+        self.assertEqual(sorted(p[ICMP].seq for p in rx),
+                         list(range(n_pkts)))
+
+        # packets without recorded qos bits are best effort
+        self.assertEqual(self.tc_counters(3), [n_pkts, n_pkts, 0])
+        n_tx += n_pkts
+        self.assertEqual(self.err_counter("hqos-sched", "transmitted"), n_tx)
+
+        # not scheduled anymore once disabled
+        self.vapi.cli("set hqos interface pg1 disable")
+        self.assertNotIn("pg1", self.vapi.cli("show hqos"))
+        self.send_pings([0] * n_pkts)
+        self.pg1.get_capture(n_pkts)
+        self.assertEqual(self.err_counter("hqos-sched", "transmitted"), n_tx)
+
+    def test_hqos_tail_drop(self):
+        """ HQoS pipe shaping and tail drop """
+        self.vapi.cli("set hqos interface pg1 rate 10 gbps pipes 16 "
+                      "queue-size 16")
+        self.vapi.cli("set hqos pipe-profile pg1 profile 1 rate 8 kbps "
+                      "burst 200")
+        self.vapi.cli("set hqos pipe pg1 pipe 0 profile 1")
+
+        n_pkts = 64
+        n_used = self.get_buffers_used()
+        n_drop = self.err_counter("hqos-output", "queue full")
+        self.send_pings([0] * n_pkts)
+        self.sleep(0.1, "wait for the scheduler")
+
+        enqueued, transmitted, dropped = self.tc_counters(3)
+        self.assertEqual(enqueued, 16)
+        self.assertEqual(dropped, n_pkts - 16)
+        self.assertLess(transmitted, enqueued)
+        self.assertEqual(self.err_counter("hqos-output", "queue full"),
+                         n_drop + n_pkts - 16)
+        self.assertGreater(self.get_buffers_used(), n_used)
+
+        # the queued packets are freed on disable
+        self.vapi.cli("set hqos interface pg1 disable")
+        self.assertEqual(self.get_buffers_used(), n_used)
+
+    def test_hqos_strict_priority(self):
+        """ HQoS strict priority traffic classes """
+        self.vapi.cli("qos record ip pg0")
+        self.vapi.cli("set hqos interface pg1 rate 10 gbps pipes 16 "
+                      "queue-size 16")
+        self.vapi.cli("set hqos tc-map pg1 qos-bits 184 tc 0 queue 0")
+        # a few packets a second, tc 0 takes seconds to drain
+        self.vapi.cli("set hqos pipe-profile pg1 profile 1 rate 800 bps "
+                      "burst 200")
+        self.vapi.cli("set hqos pipe pg1 pipe 0 profile 1")
+
+        # best effort and expedited forwarding, interleaved
+        self.send_pings([0, 184] * 16)
+        for i in range(50):
+            enqueued, transmitted, dropped = self.tc_counters(0)
+            if transmitted:
+                break
+            self.sleep(0.1, "wait for the scheduler")
+
+        # nothing of tc 3 goes before tc 0 is drained
+        self.assertEqual(enqueued, 16)
+        self.assertGreater(transmitted, 0)
+        self.assertLess(transmitted, enqueued)
+        self.assertEqual(self.tc_counters(3), [16, 0, 0])
+
+        self.vapi.cli("qos record ip pg0 disable")
+
+    def test_hqos_config_errors(self):
+        """ HQoS invalid configs """
+        for cmd in ["set hqos interface pg1 rate 1 gbps queue-size 100",
+                    "set hqos interface pg1 rate 1 gbps worker 100",
+                    "set hqos interface pg1",
+                    "set hqos interface pg1 disable",
+                    "set hqos pipe pg1 pipe 0 profile 0"]:
+            with self.assertRaises(CliFailedCommandError):
+                self.vapi.cli(cmd)
+
+        self.vapi.cli("set hqos interface pg1 rate 1 gbps pipes 16")
+        for cmd in ["set hqos interface pg1 rate 1 gbps",
+                    "set hqos pipe pg1 pipe 16 profile 0",
+                    "set hqos pipe pg1 pipe 0 profile 1",
+                    "set hqos pipe-profile pg1 profile 2 rate 1 mbps",
+                    "set hqos classify pg1 pipe offset 0 mask 0x1f",
+                    "set hqos tc-map pg1 qos-bits 0 tc 4"]:
+            with self.assertRaises(CliFailedCommandError):
+                self.vapi.cli(cmd)
+        self.vapi.cli("set hqos classify pg1 pipe offset 0 mask 0xf0")
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -113,6 +113,10 @@ vl_api_lb_add_del_vip_t_handler
             type = LB_VIP_TYPE_IP4_L3DSR;
         else if (mp->encap == LB_API_ENCAP_TYPE_NAT4)
             type = LB_VIP_TYPE_IP4_NAT4;
+        else if (mp->encap == LB_API_ENCAP_TYPE_GUE4)
+            type = LB_VIP_TYPE_IP4_GUE4;
+        else if (mp->encap == LB_API_ENCAP_TYPE_GUE6)
+            type = LB_VIP_TYPE_IP4_GUE6;
     } else {
         if (mp->encap == LB_API_ENCAP_TYPE_GRE4)
             type = LB_VIP_TYPE_IP6_GRE4;
@@ -120,6 +124,10 @@ vl_api_lb_add_del_vip_t_handler
             type = LB_VIP_TYPE_IP6_GRE6;
         else if (mp->encap == LB_API_ENCAP_TYPE_NAT6)
             type = LB_VIP_TYPE_IP6_NAT6;
+        else if (mp->encap == LB_API_ENCAP_TYPE_GUE4)
+            type = LB_VIP_TYPE_IP6_GUE4;
+        else if (mp->encap == LB_API_ENCAP_TYPE_GUE6)
+            type = LB_VIP_TYPE_IP6_GUE6;
     }
 
     args.plen = mp->pfx.len;
@@ -136,6 +144,10 @@ vl_api_lb_add_del_vip_t_handler
         args.encap_args.srv_type = mp->type;
         args.encap_args.target_port = ntohs(mp->target_port);
       }
+    else if ((mp->encap == LB_API_ENCAP_TYPE_GUE4)
+            ||(mp->encap == LB_API_ENCAP_TYPE_GUE6)) {
+        args.encap_args.target_port = ntohs(mp->target_port);
+      }
 
     rv = lb_vip_add(args, &vip_index);
   }
@@ -154,6 +166,8 @@ static void *vl_api_lb_add_del_vip_t_print
               : (mp->encap == LB_API_ENCAP_TYPE_GRE6)? "gre6"
               : (mp->encap == LB_API_ENCAP_TYPE_NAT4)? "nat4"
               : (mp->encap == LB_API_ENCAP_TYPE_NAT6)? "nat6"
+              : (mp->encap == LB_API_ENCAP_TYPE_GUE4)? "gue4"
+              : (mp->encap == LB_API_ENCAP_TYPE_GUE6)? "gue6"
               : "l3dsr");
 
   if (mp->encap==LB_API_ENCAP_TYPE_L3DSR)
@@ -169,6 +183,12 @@ static void *vl_api_lb_add_del_vip_t_print
       s = format (s, "target_port %u ", mp->target_port);
     }
 
+  if ((mp->encap==LB_API_ENCAP_TYPE_GUE4)
+      || (mp->encap==LB_API_ENCAP_TYPE_GUE6))
+    {
+      s = format (s, "gue_port %u ", mp->target_port);
+    }
+
   s = format (s, "%u ", mp->new_flows_table_length);
   s = format (s, "%s ", mp->is_del?"del":"add");
   FINISH;
@@ -29,6 +29,7 @@ lb_vip_command_fn (vlib_main_t * vm,
   u32 dscp = ~0;
   u32 srv_type = LB_SRV_TYPE_CLUSTERIP;
   u32 target_port = 0;
+  u32 gue_port = 0;
   clib_error_t *error = 0;
 
   args.new_length = 1024;
@@ -69,6 +70,12 @@ lb_vip_command_fn (vlib_main_t * vm,
       encap = LB_ENCAP_TYPE_NAT4;
     else if (unformat(line_input, "encap nat6"))
       encap = LB_ENCAP_TYPE_NAT6;
+    else if (unformat(line_input, "encap gue4"))
+      encap = LB_ENCAP_TYPE_GUE4;
+    else if (unformat(line_input, "encap gue6"))
+      encap = LB_ENCAP_TYPE_GUE6;
+    else if (unformat(line_input, "gue_port %d", &gue_port))
+      ;
     else if (unformat(line_input, "dscp %d", &dscp))
       ;
     else if (unformat(line_input, "type clusterip"))
@@ -109,6 +116,21 @@ lb_vip_command_fn (vlib_main_t * vm,
       goto done;
     }
 
+  if ((encap != LB_ENCAP_TYPE_GUE4) && (encap != LB_ENCAP_TYPE_GUE6)
+      && (gue_port != 0))
+    {
+      error = clib_error_return(0, "lb_vip_add error: "
+                                "should not configure gue_port for none GUE.");
+      goto done;
+    }
+
+  if (gue_port > 0xffff)
+    {
+      error = clib_error_return(0, "lb_vip_add error: "
+                                "invalid gue_port %u.", gue_port);
+      goto done;
+    }
+
   if (ip46_prefix_is_ip4(&(args.prefix), (args.plen)))
     {
       if (encap == LB_ENCAP_TYPE_GRE4)
@@ -119,6 +141,10 @@ lb_vip_command_fn (vlib_main_t * vm,
         args.type = LB_VIP_TYPE_IP4_L3DSR;
       else if (encap == LB_ENCAP_TYPE_NAT4)
         args.type = LB_VIP_TYPE_IP4_NAT4;
+      else if (encap == LB_ENCAP_TYPE_GUE4)
+        args.type = LB_VIP_TYPE_IP4_GUE4;
+      else if (encap == LB_ENCAP_TYPE_GUE6)
+        args.type = LB_VIP_TYPE_IP4_GUE6;
       else if (encap == LB_ENCAP_TYPE_NAT6)
         {
           error = clib_error_return(0, "currently does not support NAT46");
@@ -133,6 +159,10 @@ lb_vip_command_fn (vlib_main_t * vm,
         args.type = LB_VIP_TYPE_IP6_GRE6;
       else if (encap == LB_ENCAP_TYPE_NAT6)
         args.type = LB_VIP_TYPE_IP6_NAT6;
+      else if (encap == LB_ENCAP_TYPE_GUE4)
+        args.type = LB_VIP_TYPE_IP6_GUE4;
+      else if (encap == LB_ENCAP_TYPE_GUE6)
+        args.type = LB_VIP_TYPE_IP6_GUE6;
       else if (encap == LB_ENCAP_TYPE_NAT4)
         {
           error = clib_error_return(0, "currently does not support NAT64");
@@ -153,6 +183,11 @@ lb_vip_command_fn (vlib_main_t * vm,
           args.encap_args.srv_type = (u8) srv_type;
           args.encap_args.target_port = (u16) target_port;
         }
+      else if ((encap == LB_ENCAP_TYPE_GUE4)
+               || (encap == LB_ENCAP_TYPE_GUE6))
+        {
+          args.encap_args.target_port = (u16) gue_port;
+        }
 
     if ((ret = lb_vip_add(args, &index))) {
       error = clib_error_return (0, "lb_vip_add error %d", ret);
@@ -182,7 +217,8 @@ VLIB_CLI_COMMAND (lb_vip_command, static) =
   .path = "lb vip",
   .short_help = "lb vip <prefix> "
       "[protocol (tcp|udp) port <n>] "
-      "[encap (gre6|gre4|l3dsr|nat4|nat6)] "
+      "[encap (gre6|gre4|l3dsr|nat4|nat6|gue6|gue4)] "
+      "[gue_port <n>] "
       "[dscp <n>] "
       "[type (nodeport|clusterip) target_port <n>] "
       "[new_len <n>] [del]",
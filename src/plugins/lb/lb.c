@@ -93,6 +93,37 @@ const static char* const * const lb_dpo_nat6_port_nodes[DPO_PROTO_NUM] =
         [DPO_PROTO_IP6]  = lb_dpo_nat6_ip6_port,
     };
 
+const static char * const lb_dpo_gue4_ip4[] = { "lb4-gue4" , NULL };
+const static char * const lb_dpo_gue4_ip6[] = { "lb6-gue4" , NULL };
+const static char* const * const lb_dpo_gue4_nodes[DPO_PROTO_NUM] =
+    {
+        [DPO_PROTO_IP4]  = lb_dpo_gue4_ip4,
+        [DPO_PROTO_IP6]  = lb_dpo_gue4_ip6,
+    };
+
+const static char * const lb_dpo_gue6_ip4[] = { "lb4-gue6" , NULL };
+const static char * const lb_dpo_gue6_ip6[] = { "lb6-gue6" , NULL };
+const static char* const * const lb_dpo_gue6_nodes[DPO_PROTO_NUM] =
+    {
+        [DPO_PROTO_IP4]  = lb_dpo_gue6_ip4,
+        [DPO_PROTO_IP6]  = lb_dpo_gue6_ip6,
+    };
+
+const static char * const lb_dpo_gue4_ip4_port[] = { "lb4-gue4-port" , NULL };
+const static char * const lb_dpo_gue4_ip6_port[] = { "lb6-gue4-port" , NULL };
+const static char* const * const lb_dpo_gue4_port_nodes[DPO_PROTO_NUM] =
+    {
+        [DPO_PROTO_IP4]  = lb_dpo_gue4_ip4_port,
+        [DPO_PROTO_IP6]  = lb_dpo_gue4_ip6_port,
+    };
+
+const static char * const lb_dpo_gue6_ip4_port[] = { "lb4-gue6-port" , NULL };
+const static char * const lb_dpo_gue6_ip6_port[] = { "lb6-gue6-port" , NULL };
+const static char* const * const lb_dpo_gue6_port_nodes[DPO_PROTO_NUM] =
+    {
+        [DPO_PROTO_IP4]  = lb_dpo_gue6_ip4_port,
+        [DPO_PROTO_IP6]  = lb_dpo_gue6_ip6_port,
+    };
 u32 lb_hash_time_now(vlib_main_t * vm)
 {
   return (u32) (vlib_time_now(vm) + 10000);
@@ -129,6 +160,10 @@ static char *lb_vip_type_strings[] = {
     [LB_VIP_TYPE_IP4_L3DSR] = "ip4-l3dsr",
     [LB_VIP_TYPE_IP4_NAT4] = "ip4-nat4",
     [LB_VIP_TYPE_IP6_NAT6] = "ip6-nat6",
+    [LB_VIP_TYPE_IP6_GUE6] = "ip6-gue6",
+    [LB_VIP_TYPE_IP6_GUE4] = "ip6-gue4",
+    [LB_VIP_TYPE_IP4_GUE6] = "ip4-gue6",
+    [LB_VIP_TYPE_IP4_GUE4] = "ip4-gue4",
 };
 
 u8 *format_lb_vip_type (u8 * s, va_list * args)
@@ -156,10 +191,11 @@ uword unformat_lb_vip_type (unformat_input_t * input, va_list * args)
 u8 *format_lb_vip (u8 * s, va_list * args)
 {
   lb_vip_t *vip = va_arg (*args, lb_vip_t *);
-  s = format(s, "%U %U new_size:%u #as:%u%s",
+  s = format(s, "%U %U new_size:%u%s #as:%u%s",
              format_lb_vip_type, vip->type,
              format_ip46_prefix, &vip->prefix, vip->plen, IP46_TYPE_ANY,
              vip->new_flow_table_mask + 1,
+             (vip->flags & LB_VIP_FLAGS_MAGLEV)?" maglev":"",
              pool_elts(vip->as_indexes),
              (vip->flags & LB_VIP_FLAGS_USED)?"":" removed");
 
@@ -180,6 +216,10 @@ u8 *format_lb_vip (u8 * s, va_list * args)
              "nodeport",
          ntohs(vip->port), ntohs(vip->encap_args.target_port));
     }
+  else if (lb_vip_is_gue(vip->type))
+    {
+      s = format (s, " gue_port:%u", ntohs(vip->encap_args.target_port));
+    }
 
   return s;
 }
@@ -199,14 +239,15 @@ u8 *format_lb_vip_detailed (u8 * s, va_list * args)
   u32 indent = format_get_indent (s);
 
   s = format(s, "%U %U [%lu] %U%s\n"
-                   "%U  new_size:%u\n",
+                   "%U  new_size:%u%s\n",
                   format_white_space, indent,
                   format_lb_vip_type, vip->type,
                   vip - lbm->vips,
                   format_ip46_prefix, &vip->prefix, (u32) vip->plen, IP46_TYPE_ANY,
                   (vip->flags & LB_VIP_FLAGS_USED)?"":" removed",
                   format_white_space, indent,
-                  vip->new_flow_table_mask + 1);
+                  vip->new_flow_table_mask + 1,
+                  (vip->flags & LB_VIP_FLAGS_MAGLEV)?" (maglev)":"");
 
   if (vip->port != 0)
     {
@@ -230,6 +271,12 @@ u8 *format_lb_vip_detailed (u8 * s, va_list * args)
              "nodeport",
          ntohs(vip->port), ntohs(vip->encap_args.target_port));
     }
+  else if (lb_vip_is_gue(vip->type))
+    {
+      s = format (s, "%U  gue_port:%u\n",
+         format_white_space, indent,
+         ntohs(vip->encap_args.target_port));
+    }
 
   //Print counters
   s = format(s, "%U  counters:\n",
@@ -276,6 +323,25 @@ typedef struct {
   u32 skip;
 } lb_pseudorand_t;
 
+/**
+ * Maglev tables are prime sized. Table lengths are configuration time
+ * values, so trial division is fast enough.
+ */
+static int lb_is_prime(u32 n)
+{
+  u32 i;
+  if (n < 2)
+    return 0;
+  if (n < 4)
+    return 1;
+  if (!(n & 1))
+    return 0;
+  for (i = 3; i <= n / i; i += 2)
+    if (n % i == 0)
+      return 0;
+  return 1;
+}
+
 static int lb_pseudorand_compare(void *a, void *b)
 {
   lb_as_t *asa, *asb;
@@ -432,12 +498,25 @@ out:
 
     u64 seed = clib_xxhash(as->address.as_u64[0] ^
                            as->address.as_u64[1]);
+    if (vip->flags & LB_VIP_FLAGS_MAGLEV) {
+      /* We have M buckets, M prime.
+       * Any skip in [1, M-1] is prime with M, so every AS permutation
+       * visits all the buckets. The permutation only depends on the AS
+       * address, so all the LB instances build the same table and
+       * adding or removing an AS only moves a minimal share of buckets.
+       */
+      u32 m = vip->new_flow_table_mask + 1;
+      pr->skip = (m > 1) ? ((seed & 0xffffffff) % (m - 1)) + 1 : 1;
+      pr->last = (seed >> 32) % m;
+      continue;
+    }
     /* We have 2^n buckets.
      * skip must be prime with 2^n.
      * So skip must be odd.
      * MagLev actually state that M should be prime,
      * but this has a big computation cost (% operation).
      * Using 2^n is more better (& operation).
+     * Prime sized tables are available with LB_VIP_FLAGS_MAGLEV.
      */
     pr->skip = ((seed & 0xffffffff) | 1) & vip->new_flow_table_mask;
     pr->last = (seed >> 32) & vip->new_flow_table_mask;
@@ -453,7 +532,10 @@ out:
     vec_foreach(pr, sort_arr) {
       while (1) {
         u32 last = pr->last;
-        pr->last = (pr->last + pr->skip) & vip->new_flow_table_mask;
+        if (vip->flags & LB_VIP_FLAGS_MAGLEV)
+          pr->last = (pr->last + pr->skip) % vec_len(new_flow_table);
+        else
+          pr->last = (pr->last + pr->skip) & vip->new_flow_table_mask;
         if (new_flow_table[last].as_index == 0) {
           new_flow_table[last].as_index = pr->as_index;
           break;
@@ -947,6 +1029,14 @@ static void lb_vip_add_adjacency(lb_main_t *lbm, lb_vip_t *vip,
     dpo_type = lbm->dpo_nat4_port_type;
   else if (lb_vip_is_nat6_port(vip))
     dpo_type = lbm->dpo_nat6_port_type;
+  else if (lb_vip_is_gue4(vip))
+    dpo_type = lbm->dpo_gue4_type;
+  else if (lb_vip_is_gue6(vip))
+    dpo_type = lbm->dpo_gue6_type;
+  else if (lb_vip_is_gue4_port(vip))
+    dpo_type = lbm->dpo_gue4_port_type;
+  else if (lb_vip_is_gue6_port(vip))
+    dpo_type = lbm->dpo_gue6_port_type;
 
   dpo_set(&dpo, dpo_type, proto, *vip_prefix_index);
   fib_table_entry_special_dpo_add(0,
@@ -1091,7 +1181,7 @@ int lb_vip_add(lb_vip_add_args_t args, u32 *vip_index)
       return VNET_API_ERROR_INVALID_ARGUMENT;
     }
 
-  if (!is_pow2(args.new_length)) {
+  if (!is_pow2(args.new_length) && !lb_is_prime(args.new_length)) {
     lb_put_writer_lock();
     return VNET_API_ERROR_INVALID_MEMORY_SIZE;
   }
@@ -1143,8 +1233,16 @@ int lb_vip_add(lb_vip_add_args_t args, u32 *vip_index)
       vip->encap_args.target_port =
           clib_host_to_net_u16(args.encap_args.target_port);
     }
+  else if (lb_vip_is_gue(args.type)) {
+      vip->encap_args.target_port =
+          clib_host_to_net_u16(args.encap_args.target_port ?
+                               args.encap_args.target_port :
+                               LB_GUE_DEFAULT_PORT);
+    }
 
   vip->flags = LB_VIP_FLAGS_USED;
+  if (!is_pow2(args.new_length))
+    vip->flags |= LB_VIP_FLAGS_MAGLEV;
   vip->as_indexes = 0;
 
   //Validate counters
@@ -1309,6 +1407,14 @@ lb_as_stack (lb_as_t *as)
     dpo_type = lbm->dpo_nat4_port_type;
   else if (lb_vip_is_nat6_port(vip))
     dpo_type = lbm->dpo_nat6_port_type;
+  else if (lb_vip_is_gue4(vip))
+    dpo_type = lbm->dpo_gue4_type;
+  else if (lb_vip_is_gue6(vip))
+    dpo_type = lbm->dpo_gue6_type;
+  else if (lb_vip_is_gue4_port(vip))
+    dpo_type = lbm->dpo_gue4_port_type;
+  else if (lb_vip_is_gue6_port(vip))
+    dpo_type = lbm->dpo_gue6_port_type;
 
   dpo_stack(dpo_type,
             lb_vip_is_ip4(vip->type)?DPO_PROTO_IP4:DPO_PROTO_IP6,
@@ -1410,6 +1516,12 @@ lb_init (vlib_main_t * vm)
                                                   lb_dpo_nat4_port_nodes);
   lbm->dpo_nat6_port_type = dpo_register_new_type(&lb_vft,
                                                   lb_dpo_nat6_port_nodes);
+  lbm->dpo_gue4_type = dpo_register_new_type(&lb_vft, lb_dpo_gue4_nodes);
+  lbm->dpo_gue6_type = dpo_register_new_type(&lb_vft, lb_dpo_gue6_nodes);
+  lbm->dpo_gue4_port_type = dpo_register_new_type(&lb_vft,
+                                                  lb_dpo_gue4_port_nodes);
+  lbm->dpo_gue6_port_type = dpo_register_new_type(&lb_vft,
+                                                  lb_dpo_gue6_port_nodes);
   lbm->fib_node_type = fib_node_register_new_type(&lb_fib_node_vft);
 
   //Init AS reference counters
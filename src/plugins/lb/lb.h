@@ -51,6 +51,9 @@
 #define LB_VIP_PER_PORT_BUCKETS  1024
 #define LB_VIP_PER_PORT_MEMORY_SIZE  64<<20
 
+/* Default GUE destination port (IANA 'gue') */
+#define LB_GUE_DEFAULT_PORT 6080
+
 typedef enum {
   LB_NEXT_DROP,
   LB_N_NEXT,
@@ -187,6 +190,8 @@ typedef enum {
   LB_ENCAP_TYPE_L3DSR,
   LB_ENCAP_TYPE_NAT4,
   LB_ENCAP_TYPE_NAT6,
+  LB_ENCAP_TYPE_GUE4,
+  LB_ENCAP_TYPE_GUE6,
   LB_ENCAP_N_TYPES,
 } lb_encap_type_t;
 
@@ -203,7 +208,8 @@ typedef enum {
 
 /**
  * The load balancer supports IPv4 and IPv6 traffic
- * and GRE4, GRE6, L3DSR and NAT4, NAT6 encap.
+ * and GRE4, GRE6, L3DSR, NAT4, NAT6 and GUE4, GUE6 encap.
+ * GUE encap is GUE variant 1 (i.e. IP directly over UDP, same as FOU).
  */
 typedef enum {
   LB_VIP_TYPE_IP6_GRE6,
@@ -213,6 +219,10 @@ typedef enum {
   LB_VIP_TYPE_IP4_L3DSR,
   LB_VIP_TYPE_IP4_NAT4,
   LB_VIP_TYPE_IP6_NAT6,
+  LB_VIP_TYPE_IP6_GUE6,
+  LB_VIP_TYPE_IP6_GUE4,
+  LB_VIP_TYPE_IP4_GUE6,
+  LB_VIP_TYPE_IP4_GUE4,
   LB_VIP_N_TYPES,
 } lb_vip_type_t;
 
@@ -229,7 +239,8 @@ typedef struct {
       /* Service type. clusterip or nodeport */
       u8 srv_type;
 
-      /* Pod's port corresponding to specific service. network byte order */
+      /* Pod's port corresponding to specific service, or
+       * GUE destination port. network byte order */
       u16 target_port;
     };
     /* DSCP bits for L3DSR */
@@ -266,12 +277,13 @@ typedef struct {
   /**
    * Vector mapping (flow-hash & new_connect_table_mask) to AS index.
    * This is used for new flows.
+   * See lb_vip_new_flow_index().
    */
   lb_new_flow_entry_t *new_flow_table;
 
   /**
    * New flows table length - 1
-   * (length MUST be a power of 2)
+   * (length MUST be a power of 2, or a prime for a Maglev table)
    */
   u32 new_flow_table_mask;
 
@@ -321,9 +333,12 @@ typedef struct {
    * When it is not set, the VIP in the process of being removed.
    * We cannot immediately remove a VIP because the VIP index still may be stored
    * in the adjacency index.
+   * LB_VIP_FLAGS_MAGLEV means the new flows table has a prime length and
+   * is filled using Maglev permutations (see lb_vip_new_flow_index()).
    */
   u8 flags;
 #define LB_VIP_FLAGS_USED 0x1
+#define LB_VIP_FLAGS_MAGLEV 0x2
 
   /**
    * Pool of AS indexes used for this VIP.
@@ -335,17 +350,27 @@ typedef struct {
 #define lb_vip_is_ip4(type) (type == LB_VIP_TYPE_IP4_GRE6 \
                             || type == LB_VIP_TYPE_IP4_GRE4 \
                             || type == LB_VIP_TYPE_IP4_L3DSR \
-                            || type == LB_VIP_TYPE_IP4_NAT4 )
+                            || type == LB_VIP_TYPE_IP4_NAT4 \
+                            || type == LB_VIP_TYPE_IP4_GUE6 \
+                            || type == LB_VIP_TYPE_IP4_GUE4 )
 
 #define lb_vip_is_ip6(type) (type == LB_VIP_TYPE_IP6_GRE6 \
                             || type == LB_VIP_TYPE_IP6_GRE4 \
-                            || type == LB_VIP_TYPE_IP6_NAT6 )
+                            || type == LB_VIP_TYPE_IP6_NAT6 \
+                            || type == LB_VIP_TYPE_IP6_GUE6 \
+                            || type == LB_VIP_TYPE_IP6_GUE4 )
 
 #define lb_encap_is_ip4(vip) ((vip)->type == LB_VIP_TYPE_IP6_GRE4 \
                              || (vip)->type == LB_VIP_TYPE_IP4_GRE4 \
                              || (vip)->type == LB_VIP_TYPE_IP4_L3DSR \
-                             || (vip)->type == LB_VIP_TYPE_IP4_NAT4 )
-
+                             || (vip)->type == LB_VIP_TYPE_IP4_NAT4 \
+                             || (vip)->type == LB_VIP_TYPE_IP6_GUE4 \
+                             || (vip)->type == LB_VIP_TYPE_IP4_GUE4 )
+
+#define lb_vip_is_gue(type) (type == LB_VIP_TYPE_IP6_GUE6 \
+                            || type == LB_VIP_TYPE_IP6_GUE4 \
+                            || type == LB_VIP_TYPE_IP4_GUE6 \
+                            || type == LB_VIP_TYPE_IP4_GUE4 )
 #define lb_vip_is_gre4(vip) (((vip)->type == LB_VIP_TYPE_IP6_GRE4 \
                             || (vip)->type == LB_VIP_TYPE_IP4_GRE4) \
                             && ((vip)->port == 0))
@@ -363,6 +388,21 @@ typedef struct {
                                  || (vip)->type == LB_VIP_TYPE_IP4_GRE6) \
                                  && ((vip)->port != 0))
 
+#define lb_vip_is_gue4(vip) (((vip)->type == LB_VIP_TYPE_IP6_GUE4 \
+                            || (vip)->type == LB_VIP_TYPE_IP4_GUE4) \
+                            && ((vip)->port == 0))
+
+#define lb_vip_is_gue6(vip) (((vip)->type == LB_VIP_TYPE_IP6_GUE6 \
+                            || (vip)->type == LB_VIP_TYPE_IP4_GUE6) \
+                            && ((vip)->port == 0))
+
+#define lb_vip_is_gue4_port(vip) (((vip)->type == LB_VIP_TYPE_IP6_GUE4 \
+                                 || (vip)->type == LB_VIP_TYPE_IP4_GUE4) \
+                                 && ((vip)->port != 0))
+
+#define lb_vip_is_gue6_port(vip) (((vip)->type == LB_VIP_TYPE_IP6_GUE6 \
+                                 || (vip)->type == LB_VIP_TYPE_IP4_GUE6) \
+                                 && ((vip)->port != 0))
 always_inline bool
 lb_vip_is_l3dsr(const lb_vip_t *vip)
 {
@@ -385,6 +425,20 @@ lb_vip_is_nat6_port(const lb_vip_t *vip)
   return (vip->type == LB_VIP_TYPE_IP6_NAT6 && vip->port !=0);
 }
 
+/**
+ * Index in the VIP new flows table for a given flow hash.
+ * Power of 2 tables are indexed using the low bits of the hash.
+ * Maglev tables have a prime length, the 32 bits hash is scaled to
+ * the table length with a multiply and shift instead of a modulo.
+ */
+always_inline u32
+lb_vip_new_flow_index(const lb_vip_t *vip, u32 hash)
+{
+  if (vip->flags & LB_VIP_FLAGS_MAGLEV)
+    return ((u64) hash * (vip->new_flow_table_mask + 1)) >> 32;
+  return hash & vip->new_flow_table_mask;
+}
+
 format_function_t format_lb_vip;
 format_function_t format_lb_vip_detailed;
 
@@ -542,6 +596,10 @@ typedef struct {
   dpo_type_t dpo_l3dsr_port_type;
   dpo_type_t dpo_nat4_port_type;
   dpo_type_t dpo_nat6_port_type;
+  dpo_type_t dpo_gue4_type;
+  dpo_type_t dpo_gue6_type;
+  dpo_type_t dpo_gue4_port_type;
+  dpo_type_t dpo_gue6_port_type;
   /**
    * Node type for registering to fib changes.
    */
@@ -163,6 +163,12 @@ static int api_lb_add_del_vip (vat_main_t * vam)
       encap = LB_ENCAP_TYPE_NAT4;
     else if (unformat(line_input, "encap nat6"))
       encap = LB_ENCAP_TYPE_NAT6;
+    else if (unformat(line_input, "encap gue4"))
+      encap = LB_ENCAP_TYPE_GUE4;
+    else if (unformat(line_input, "encap gue6"))
+      encap = LB_ENCAP_TYPE_GUE6;
+    else if (unformat(line_input, "gue_port %d", &target_port))
+      ;
     else if (unformat(line_input, "dscp %d", &dscp))
       ;
     else if (unformat(line_input, "type clusterip"))
@@ -173,6 +173,19 @@ lb_node_get_other_ports6 (ip6_header_t *ip60)
   return 0;
 }
 
+/**
+ * GUE outer UDP source port, carrying the flow entropy so that the
+ * application servers can spread the LB traffic over their RSS queues.
+ * The flow hash low bits also index the new flows table, i.e. they are
+ * correlated with the AS selection, hence the multiplicative mixing.
+ * The port is taken from the ephemeral range (49152-65535).
+ */
+static_always_inline u16
+lb_node_gue_src_port (u32 hash)
+{
+  return clib_host_to_net_u16 (0xc000 | ((hash * 0x9e3779b1) >> 18));
+}
+
 static_always_inline void
 lb_node_get_hash (lb_main_t *lbm, vlib_buffer_t *p, u8 is_input_v4,
                   u32 *hash, u32 *vip_idx, u8 per_port_vip)
@@ -256,7 +269,7 @@ lb_node_fn (vlib_main_t * vm,
             vlib_node_runtime_t * node,
             vlib_frame_t * frame,
             u8 is_input_v4, //Compile-time parameter stating that is input is v4 (or v6)
-            lb_encap_type_t encap_type, //Compile-time parameter is GRE4/GRE6/L3DSR/NAT4/NAT6
+            lb_encap_type_t encap_type, //Compile-time parameter is GRE4/GRE6/L3DSR/NAT4/NAT6/GUE4/GUE6
             u8 per_port_vip) //Compile-time parameter stating that is per_port_vip or not
 {
   lb_main_t *lbm = &lb_main;
@@ -352,7 +365,7 @@ lb_node_fn (vlib_main_t * vm,
             {
               //There is an available slot for a new flow
               asindex0 =
-                  vip0->new_flow_table[hash0 & vip0->new_flow_table_mask].as_index;
+                  vip0->new_flow_table[lb_vip_new_flow_index (vip0, hash0)].as_index;
               counter = LB_VIP_COUNTER_FIRST_PACKET;
               counter = (asindex0 == 0) ? LB_VIP_COUNTER_NO_SERVER : counter;
 
@@ -377,7 +390,7 @@ lb_node_fn (vlib_main_t * vm,
             {
               //Could not store new entry in the table
               asindex0 =
-                  vip0->new_flow_table[hash0 & vip0->new_flow_table_mask].as_index;
+                  vip0->new_flow_table[lb_vip_new_flow_index (vip0, hash0)].as_index;
               counter = LB_VIP_COUNTER_UNTRACKED_PACKET;
             }
 
@@ -432,6 +445,65 @@ lb_node_fn (vlib_main_t * vm,
                       clib_host_to_net_u16 (0x0800) :
                       clib_host_to_net_u16 (0x86DD);
             }
+          else if ((encap_type == LB_ENCAP_TYPE_GUE4)
+              || (encap_type == LB_ENCAP_TYPE_GUE6))
+            {
+              udp_header_t *udp0;
+              if (encap_type == LB_ENCAP_TYPE_GUE4) /* encap GUE4*/
+                {
+                  ip4_header_t *ip40;
+                  vlib_buffer_advance (
+                      p0, -sizeof(ip4_header_t) - sizeof(udp_header_t));
+                  ip40 = vlib_buffer_get_current (p0);
+                  udp0 = (udp_header_t *) (ip40 + 1);
+                  ip40->src_address = lbm->ip4_src_address;
+                  ip40->dst_address = lbm->ass[asindex0].address.ip4;
+                  ip40->ip_version_and_header_length = 0x45;
+                  ip40->tos = 0;
+                  ip40->ttl = 128;
+                  ip40->fragment_id = 0;
+                  ip40->flags_and_fragment_offset = 0;
+                  ip40->length = clib_host_to_net_u16 (
+                      len0 + sizeof(udp_header_t) + sizeof(ip4_header_t));
+                  ip40->protocol = IP_PROTOCOL_UDP;
+                  ip40->checksum = ip4_header_checksum (ip40);
+                  /* The inner packet carries its own checksums,
+                   * a zero UDP checksum is allowed over IPv4. */
+                  udp0->checksum = 0;
+                }
+              else /* encap GUE6*/
+                {
+                  ip6_header_t *ip60;
+                  vlib_buffer_advance (
+                      p0, -sizeof(ip6_header_t) - sizeof(udp_header_t));
+                  ip60 = vlib_buffer_get_current (p0);
+                  udp0 = (udp_header_t *) (ip60 + 1);
+                  ip60->dst_address = lbm->ass[asindex0].address.ip6;
+                  ip60->src_address = lbm->ip6_src_address;
+                  ip60->hop_limit = 128;
+                  ip60->ip_version_traffic_class_and_flow_label =
+                      clib_host_to_net_u32 (0x6 << 28);
+                  ip60->payload_length = clib_host_to_net_u16 (
+                      len0 + sizeof(udp_header_t));
+                  ip60->protocol = IP_PROTOCOL_UDP;
+                  /* The UDP checksum is mandatory over IPv6.
+                   * Leave it to the NIC, or to interface-output when
+                   * the TX interface does not offload checksums. */
+                  udp0->checksum = 0;
+                  vnet_buffer (p0)->l3_hdr_offset = (u8 *) ip60 - p0->data;
+                  vnet_buffer (p0)->l4_hdr_offset = (u8 *) udp0 - p0->data;
+                  p0->flags &= ~VNET_BUFFER_F_IS_IP4;
+                  p0->flags |= VNET_BUFFER_F_IS_IP6 |
+                      VNET_BUFFER_F_L3_HDR_OFFSET_VALID |
+                      VNET_BUFFER_F_L4_HDR_OFFSET_VALID |
+                      VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+                }
+
+              udp0->src_port = lb_node_gue_src_port (hash0);
+              udp0->dst_port = vip0->encap_args.target_port;
+              udp0->length = clib_host_to_net_u16 (
+                  len0 + sizeof(udp_header_t));
+            }
           else if (encap_type == LB_ENCAP_TYPE_L3DSR) /* encap L3DSR*/
             {
               ip4_header_t *ip40;
@@ -1017,6 +1089,62 @@ lb4_nat4_port_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   return lb_node_fn (vm, node, frame, 1, LB_ENCAP_TYPE_NAT4, 1);
 }
 
+static uword
+lb6_gue6_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                  vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 0, LB_ENCAP_TYPE_GUE6, 0);
+}
+
+static uword
+lb6_gue4_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                  vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 0, LB_ENCAP_TYPE_GUE4, 0);
+}
+
+static uword
+lb4_gue6_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                  vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 1, LB_ENCAP_TYPE_GUE6, 0);
+}
+
+static uword
+lb4_gue4_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                  vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 1, LB_ENCAP_TYPE_GUE4, 0);
+}
+
+static uword
+lb6_gue6_port_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                       vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 0, LB_ENCAP_TYPE_GUE6, 1);
+}
+
+static uword
+lb6_gue4_port_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                       vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 0, LB_ENCAP_TYPE_GUE4, 1);
+}
+
+static uword
+lb4_gue6_port_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                       vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 1, LB_ENCAP_TYPE_GUE6, 1);
+}
+
+static uword
+lb4_gue4_port_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                       vlib_frame_t * frame)
+{
+  return lb_node_fn (vm, node, frame, 1, LB_ENCAP_TYPE_GUE4, 1);
+}
+
 static uword
 lb_nat4_in2out_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
                         vlib_frame_t * frame)
@@ -1187,6 +1315,110 @@ VLIB_REGISTER_NODE (lb4_nat4_port_node) =
         { [LB_NEXT_DROP] = "error-drop" },
   };
 
+VLIB_REGISTER_NODE (lb6_gue6_node) =
+  {
+    .function = lb6_gue6_node_fn,
+    .name = "lb6-gue6",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb6_gue4_node) =
+  {
+    .function = lb6_gue4_node_fn,
+    .name = "lb6-gue4",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb4_gue6_node) =
+  {
+    .function = lb4_gue6_node_fn,
+    .name = "lb4-gue6",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb4_gue4_node) =
+  {
+    .function = lb4_gue4_node_fn,
+    .name = "lb4-gue4",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb6_gue6_port_node) =
+  {
+    .function = lb6_gue6_port_node_fn,
+    .name = "lb6-gue6-port",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb6_gue4_port_node) =
+  {
+    .function = lb6_gue4_port_node_fn,
+    .name = "lb6-gue4-port",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb4_gue6_port_node) =
+  {
+    .function = lb4_gue6_port_node_fn,
+    .name = "lb4-gue6-port",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
+VLIB_REGISTER_NODE (lb4_gue4_port_node) =
+  {
+    .function = lb4_gue4_port_node_fn,
+    .name = "lb4-gue4-port",
+    .vector_size = sizeof(u32),
+    .format_trace = format_lb_trace,
+    .n_errors = LB_N_ERROR,
+    .error_strings = lb_error_strings,
+    .n_next_nodes = LB_N_NEXT,
+    .next_nodes =
+        { [LB_NEXT_DROP] = "error-drop" },
+  };
+
 static uword
 lb4_nodeport_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
                       vlib_frame_t * frame)
@@ -103,6 +103,33 @@ class TestLB(VppTestCase):
             pkts.append(packet)
         return pkts
 
+    def getFlowMapping(self, n_flows):
+        """ AS each of n_flows IP4 flows is sent to by the new flow table """
+        pkts = [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 self.getIPv4Flow(flow) /
+                 Raw(b'\xa5' * 64)) for flow in range(n_flows)]
+        # nothing sticks to an AS from a previous round
+        self.vapi.cli("test lb flowtable flush")
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        mapping = {}
+        for p in self.pg1.get_capture(n_flows):
+            inner = IP(scapy.compat.raw(p[GRE].payload))
+            mapping[inner.src] = int(p[IP].dst.split(".")[3])
+        return mapping
+
+    def checkInnerGue(self, udp, isv4):
+        IPver = IP if isv4 else IPv6
+        self.assertEqual(udp.dport, 6080)
+        self.assertGreaterEqual(udp.sport, 0xc000)
+        inner = IPver(scapy.compat.raw(udp.payload))
+        payload_info = self.payload_to_info(inner[Raw])
+        self.info = self.packet_infos[payload_info.index]
+        self.assertEqual(payload_info.src, self.pg0.sw_if_index)
+        self.assertEqual(scapy.compat.raw(inner),
+                         scapy.compat.raw(self.info.data[IPver]))
+
     def checkInner(self, gre, isv4):
         IPver = IP if isv4 else IPv6
         self.assertEqual(gre.proto, 0x0800 if isv4 else 0x86DD)
@@ -120,6 +147,7 @@ class TestLB(VppTestCase):
         out = self.pg1.get_capture(len(self.packets))
 
         load = [0] * len(self.ass)
+        sports = set()
         self.info = None
         for p in out:
             try:
@@ -153,6 +181,36 @@ class TestLB(VppTestCase):
                     # self.assertEqual(len(ip.options), 0)
                     gre = GRE(scapy.compat.raw(p[IPv6].payload))
                     self.checkInner(gre, isv4)
+                elif (encap == 'gue4'):
+                    ip = p[IP]
+                    asid = int(ip.dst.split(".")[3])
+                    self.assertEqual(ip.version, 4)
+                    self.assertEqual(ip.flags, 0)
+                    self.assertEqual(ip.src, "39.40.41.42")
+                    self.assertEqual(ip.dst, "10.0.0.%u" % asid)
+                    self.assertEqual(ip.proto, 17)
+                    self.assertEqual(len(ip.options), 0)
+                    self.assert_ip_checksum_valid(p)
+                    udp = UDP(scapy.compat.raw(ip.payload))
+                    self.assertEqual(udp.chksum, 0)
+                    sports.add(udp.sport)
+                    self.checkInnerGue(udp, isv4)
+                elif (encap == 'gue6'):
+                    ip = p[IPv6]
+                    asid = ip.dst.split(":")
+                    asid = asid[len(asid) - 1]
+                    asid = 0 if asid == "" else int(asid)
+                    self.assertEqual(ip.version, 6)
+                    self.assertEqual(ip.src, "2004::1")
+                    self.assertEqual(
+                        socket.inet_pton(socket.AF_INET6, ip.dst),
+                        socket.inet_pton(socket.AF_INET6, "2002::%u" % asid)
+                    )
+                    self.assertEqual(ip.nh, 17)
+                    self.assert_udp_checksum_valid(p)
+                    udp = UDP(scapy.compat.raw(ip.payload))
+                    sports.add(udp.sport)
+                    self.checkInnerGue(udp, isv4)
                 elif (encap == 'l3dsr'):
                     ip = p[IP]
                     asid = int(ip.dst.split(".")[3])
@@ -205,6 +263,10 @@ class TestLB(VppTestCase):
                     "ASS is not balanced: load[%d] = %d" % (asid, load[asid]))
                 raise Exception("Load Balancer algorithm is biased")
 
+        # GUE source port carries the flow entropy
+        if encap in ('gue4', 'gue6'):
+            self.assertGreater(len(sports), len(self.ass))
+
     def test_lb_ip4_gre4(self):
         """ Load Balancer IP4 GRE4 on vip case """
         try:
@@ -229,6 +291,97 @@ class TestLB(VppTestCase):
                 "lb vip 90.0.0.0/8 encap gre4 del")
             self.vapi.cli("test lb flowtable flush")
 
+    def test_lb_ip4_gre4_maglev(self):
+        """ Load Balancer IP4 GRE4 on vip with maglev table case """
+        try:
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gre4 new_len 1021")
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u"
+                    % (asid))
+
+            self.assertIn("maglev", self.vapi.cli("show lb vips"))
+            self.pg0.add_stream(self.generatePackets(self.pg0, isv4=True))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.checkCapture(encap='gre4', isv4=True)
+
+            n_flows = 256
+            before = self.getFlowMapping(n_flows)
+            self.assertEqual(set(before.values()), set(self.ass))
+
+            # removing an AS moves its flows, and only a few others
+            removed = self.ass[-1]
+            self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % removed)
+            after = self.getFlowMapping(n_flows)
+            moved = [f for f in before
+                     if before[f] != removed and after[f] != before[f]]
+            self.assertNotIn(removed, after.values())
+            self.assertLessEqual(len(moved), n_flows // 20)
+
+            # the table only depends on the set of ASs, not on the order
+            # they were added in, so all instances build the same one
+            self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % removed)
+            self.assertEqual(self.getFlowMapping(n_flows), before)
+
+        finally:
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u del"
+                    % (asid))
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+
+    def test_lb_ip4_gue4(self):
+        """ Load Balancer IP4 GUE4 on vip case """
+        try:
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gue4")
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u"
+                    % (asid))
+
+            self.pg0.add_stream(self.generatePackets(self.pg0, isv4=True))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.checkCapture(encap='gue4', isv4=True)
+
+        finally:
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 90.0.0.0/8 10.0.0.%u del"
+                    % (asid))
+            self.vapi.cli(
+                "lb vip 90.0.0.0/8 encap gue4 del")
+            self.vapi.cli("test lb flowtable flush")
+
+    def test_lb_ip6_gue6(self):
+        """ Load Balancer IP6 GUE6 on vip case """
+        try:
+            self.vapi.cli(
+                "lb vip 2001::/16 encap gue6")
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 2001::/16 2002::%u"
+                    % (asid))
+
+            self.pg0.add_stream(self.generatePackets(self.pg0, isv4=False))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+
+            self.checkCapture(encap='gue6', isv4=False)
+        finally:
+            for asid in self.ass:
+                self.vapi.cli(
+                    "lb as 2001::/16 2002::%u del"
+                    % (asid))
+            self.vapi.cli(
+                "lb vip 2001::/16 encap gue6 del")
+            self.vapi.cli("test lb flowtable flush")
+
     def test_lb_ip6_gre4(self):
         """ Load Balancer IP6 GRE4 on vip case """
 
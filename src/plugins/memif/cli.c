@@ -360,6 +360,10 @@ format_memif_queue (u8 * s, va_list * args)
 		mq->ring->head, mq->ring->tail, mq->ring->flags,
 		mq->int_count);
 
+  if (mq->n_adaptive_polls)
+    s = format (s, "%Uadaptive-polls %lu\n", format_white_space, indent + 4,
+		mq->n_adaptive_polls);
+
   return s;
 }
 
@@ -229,10 +229,23 @@ no_free_slots:
   co = ptd->copy_ops;
   while (n_copy_op >= 8)
     {
-      CLIB_PREFETCH (co[4].data, CLIB_CACHE_LINE_BYTES, LOAD);
-      CLIB_PREFETCH (co[5].data, CLIB_CACHE_LINE_BYTES, LOAD);
-      CLIB_PREFETCH (co[6].data, CLIB_CACHE_LINE_BYTES, LOAD);
-      CLIB_PREFETCH (co[7].data, CLIB_CACHE_LINE_BYTES, LOAD);
+      CLIB_PREFETCH (co[4].data, CLIB_CACHE_LINE_BYTES, STORE);
+      CLIB_PREFETCH (co[5].data, CLIB_CACHE_LINE_BYTES, STORE);
+      CLIB_PREFETCH (co[6].data, CLIB_CACHE_LINE_BYTES, STORE);
+      CLIB_PREFETCH (co[7].data, CLIB_CACHE_LINE_BYTES, STORE);
+
+      b0 = vlib_get_buffer (vm, ptd->buffers[co[4].buffer_vec_index]);
+      b1 = vlib_get_buffer (vm, ptd->buffers[co[5].buffer_vec_index]);
+      b2 = vlib_get_buffer (vm, ptd->buffers[co[6].buffer_vec_index]);
+      b3 = vlib_get_buffer (vm, ptd->buffers[co[7].buffer_vec_index]);
+      CLIB_PREFETCH (b0->data + co[4].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     LOAD);
+      CLIB_PREFETCH (b1->data + co[5].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     LOAD);
+      CLIB_PREFETCH (b2->data + co[6].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     LOAD);
+      CLIB_PREFETCH (b3->data + co[7].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     LOAD);
 
       b0 = vlib_get_buffer (vm, ptd->buffers[co[0].buffer_vec_index]);
       b1 = vlib_get_buffer (vm, ptd->buffers[co[1].buffer_vec_index]);
@@ -280,6 +293,9 @@ no_free_slots:
 			n_left);
     }
 
+  /* order the ring update before reading the peer interrupt mask, a peer
+     in adaptive mode re-checks the ring after unmasking */
+  CLIB_MEMORY_BARRIER ();
   if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0 && mq->int_fd > -1)
     {
       u64 b = 1;
@@ -390,6 +406,9 @@ no_free_slots:
       vlib_buffer_free (vm, buffers, n_left);
     }
 
+  /* order the ring update before reading the peer interrupt mask, a peer
+     in adaptive mode re-checks the ring after unmasking */
+  CLIB_MEMORY_BARRIER ();
   if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0 && mq->int_fd > -1)
     {
       u64 b = 1;
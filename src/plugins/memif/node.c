@@ -85,25 +85,6 @@ memif_next_from_ip_hdr (vlib_node_runtime_t * node, vlib_buffer_t * b)
   return VNET_DEVICE_INPUT_NEXT_DROP;
 }
 
-static_always_inline void
-memif_trace_buffer (vlib_main_t * vm, vlib_node_runtime_t * node,
-		    memif_if_t * mif, vlib_buffer_t * b, u32 next, u16 qid,
-		    uword * n_tracep)
-{
-  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b);
-
-  if (PREDICT_TRUE (b != 0))
-    {
-      memif_input_trace_t *tr;
-      vlib_trace_buffer (vm, node, next, b, /* follow_chain */ 0);
-      vlib_set_trace_count (vm, node, --(*n_tracep));
-      tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-      tr->next_index = next;
-      tr->hw_if_index = mif->hw_if_index;
-      tr->ring = qid;
-    }
-}
-
 static_always_inline void
 memif_add_copy_op (memif_per_thread_data_t * ptd, void *data, u32 len,
 		   u16 buffer_offset, u16 buffer_vec_index)
@@ -170,18 +151,125 @@ memif_desc_is_invalid (memif_if_t * mif, memif_desc_t * d, u32 buffer_length)
   return 0;
 }
 
+/* pick the next node for the whole vector, in ethernet mode all packets go
+   to the same next frame which is flagged single sw_if_index */
+static_always_inline u32 *
+memif_input_get_next_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
+			    memif_if_t * mif, memif_interface_mode_t mode,
+			    vlib_buffer_t * bt, u32 * next_indexp,
+			    u32 * n_left_to_nextp, u32 * bufs)
+{
+  u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+  u32 *to_next_bufs = bufs;
+
+  if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
+    {
+      if (mif->per_interface_next_index != ~0)
+	next_index = mif->per_interface_next_index;
+      else
+	vnet_feature_start_device_input_x1 (mif->sw_if_index, &next_index,
+					    bt);
+
+      vlib_get_new_next_frame (vm, node, next_index, to_next_bufs,
+			       *n_left_to_nextp);
+      if (PREDICT_TRUE (next_index == VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT))
+	{
+	  vlib_next_frame_t *nf;
+	  vlib_frame_t *f;
+	  ethernet_input_frame_t *ef;
+	  nf = vlib_node_runtime_get_next_frame (vm, node, next_index);
+	  f = vlib_get_frame (vm, nf->frame);
+	  f->flags = ETH_INPUT_FRAME_F_SINGLE_SW_IF_IDX;
+
+	  ef = vlib_frame_scalar_args (f);
+	  ef->sw_if_index = mif->sw_if_index;
+	  ef->hw_if_index = mif->hw_if_index;
+	  vlib_frame_no_append (f);
+	}
+    }
+
+  *next_indexp = next_index;
+  return to_next_bufs;
+}
+
+static_always_inline void
+memif_input_enqueue (vlib_main_t * vm, vlib_node_runtime_t * node,
+		     memif_if_t * mif, memif_interface_mode_t mode, u16 qid,
+		     u32 next_index, u32 n_left_to_next, u32 * to_next_bufs,
+		     u16 * nexts, u32 n_rx_packets, u32 n_rx_bytes)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  uword n_trace;
+
+  /* packet trace if enabled */
+  if (PREDICT_FALSE ((n_trace = vlib_get_trace_count (vm, node))))
+    {
+      u32 n_left = n_rx_packets;
+      u32 *bi = to_next_bufs;
+      u16 *next = nexts;
+      u32 ni = next_index;
+      while (n_trace && n_left)
+	{
+	  vlib_buffer_t *b;
+	  memif_input_trace_t *tr;
+	  if (mode != MEMIF_INTERFACE_MODE_ETHERNET)
+	    ni = next[0];
+	  b = vlib_get_buffer (vm, bi[0]);
+	  vlib_trace_buffer (vm, node, ni, b, /* follow_chain */ 0);
+	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
+	  tr->next_index = ni;
+	  tr->hw_if_index = mif->hw_if_index;
+	  tr->ring = qid;
+
+	  /* next */
+	  n_trace--;
+	  n_left--;
+	  bi++;
+	  next++;
+	}
+      vlib_set_trace_count (vm, node, n_trace);
+    }
+
+  if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
+    {
+      n_left_to_next -= n_rx_packets;
+      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+    }
+  else
+    vlib_buffer_enqueue_to_next (vm, node, to_next_bufs, nexts, n_rx_packets);
+
+  vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
+				   + VNET_INTERFACE_COUNTER_RX,
+				   vm->thread_index, mif->hw_if_index,
+				   n_rx_packets, n_rx_bytes);
+}
+
+static_always_inline void
+memif_input_buffer_template (memif_per_thread_data_t * ptd,
+			     memif_if_t * mif, memif_queue_t * mq,
+			     i16 start_offset)
+{
+  vlib_buffer_t *bt = &ptd->buffer_template;
+
+  vnet_buffer (bt)->sw_if_index[VLIB_RX] = mif->sw_if_index;
+  vnet_buffer (bt)->sw_if_index[VLIB_TX] = ~0;
+  vnet_buffer (bt)->feature_arc_index = 0;
+  bt->current_data = start_offset;
+  bt->current_config_index = 0;
+  bt->buffer_pool_index = mq->buffer_pool_index;
+  bt->ref_count = 1;
+}
+
 static_always_inline uword
 memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   vlib_frame_t * frame, memif_if_t * mif,
 			   memif_ring_type_t type, u16 qid,
 			   memif_interface_mode_t mode)
 {
-  vnet_main_t *vnm = vnet_get_main ();
   memif_main_t *mm = &memif_main;
   memif_ring_t *ring;
   memif_queue_t *mq;
   u16 buffer_size = vlib_buffer_get_default_data_size (vm);
-  uword n_trace = vlib_get_trace_count (vm, node);
   u16 nexts[MEMIF_RX_VECTOR_SZ], *next = nexts;
   u32 _to_next_bufs[MEMIF_RX_VECTOR_SZ], *to_next_bufs = _to_next_bufs, *bi;
   u32 n_rx_packets = 0, n_rx_bytes = 0;
@@ -199,6 +287,7 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   memif_packet_op_t *po;
   memif_region_index_t last_region = ~0;
   void *last_region_shm = 0;
+  u32 max_single_len;
 
   mq = vec_elt_at_index (mif->rx_queues, qid);
   ring = mq->ring;
@@ -208,6 +297,7 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   /* asume that somebody will want to add ethernet header on the packet
      so start with IP header at offset 14 */
   start_offset = (mode == MEMIF_INTERFACE_MODE_IP) ? 14 : 0;
+  max_single_len = buffer_size - start_offset;
 
   /* for S2M rings, we are consumers of packet buffers, and for M2S rings we
      are producers of empty buffers */
@@ -224,6 +314,72 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       u16 s0;
       memif_desc_t *d0;
       void *mb0;
+
+      /* fast path, four descriptors at a time as long as each one holds a
+         whole packet fitting in a single buffer; payload of the next four
+         is prefetched while these are processed */
+      while (n_slots >= 8 && n_rx_packets + 4 <= MEMIF_RX_VECTOR_SZ)
+	{
+	  memif_desc_t *d1, *d2, *d3;
+	  u32 max_len;
+
+	  d0 = &ring->desc[cur_slot & mask];
+	  d1 = &ring->desc[(cur_slot + 1) & mask];
+	  d2 = &ring->desc[(cur_slot + 2) & mask];
+	  d3 = &ring->desc[(cur_slot + 3) & mask];
+
+	  max_len = clib_max (clib_max (d0->length, d1->length),
+			      clib_max (d2->length, d3->length));
+	  if ((d0->flags | d1->flags | d2->flags | d3->flags) &
+	      MEMIF_DESC_FLAG_NEXT || max_len > max_single_len)
+	    break;
+
+	  CLIB_PREFETCH (&ring->desc[(cur_slot + 12) & mask],
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (memif_get_buffer (mif, ring, (cur_slot + 4) & mask),
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (memif_get_buffer (mif, ring, (cur_slot + 5) & mask),
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (memif_get_buffer (mif, ring, (cur_slot + 6) & mask),
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (memif_get_buffer (mif, ring, (cur_slot + 7) & mask),
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+
+	  vec_add2_aligned (ptd->copy_ops, co, 4, CLIB_CACHE_LINE_BYTES);
+	  po = ptd->packet_ops + n_rx_packets;
+
+	  co[0].data = mif->regions[d0->region].shm + d0->offset;
+	  co[1].data = mif->regions[d1->region].shm + d1->offset;
+	  co[2].data = mif->regions[d2->region].shm + d2->offset;
+	  co[3].data = mif->regions[d3->region].shm + d3->offset;
+	  co[0].data_len = po[0].packet_len = d0->length;
+	  co[1].data_len = po[1].packet_len = d1->length;
+	  co[2].data_len = po[2].packet_len = d2->length;
+	  co[3].data_len = po[3].packet_len = d3->length;
+	  co[0].buffer_offset = co[1].buffer_offset = start_offset;
+	  co[2].buffer_offset = co[3].buffer_offset = start_offset;
+	  co[0].buffer_vec_index = po[0].first_buffer_vec_index = n_buffers;
+	  co[1].buffer_vec_index = po[1].first_buffer_vec_index =
+	    n_buffers + 1;
+	  co[2].buffer_vec_index = po[2].first_buffer_vec_index =
+	    n_buffers + 2;
+	  co[3].buffer_vec_index = po[3].first_buffer_vec_index =
+	    n_buffers + 3;
+
+	  /* slave resets buffer length */
+	  if (type == MEMIF_RING_M2S)
+	    d0->length = d1->length = d2->length = d3->length =
+	      mif->run.buffer_size;
+
+	  n_buffers += 4;
+	  n_rx_packets += 4;
+	  cur_slot += 4;
+	  n_slots -= 4;
+	}
+
+      if (n_slots == 0 || n_rx_packets == MEMIF_RX_VECTOR_SZ)
+	break;
+
       po = ptd->packet_ops + n_rx_packets;
       n_rx_packets++;
       po->first_buffer_vec_index = n_buffers++;
@@ -302,6 +458,19 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       CLIB_PREFETCH (co[6].data, CLIB_CACHE_LINE_BYTES, LOAD);
       CLIB_PREFETCH (co[7].data, CLIB_CACHE_LINE_BYTES, LOAD);
 
+      b0 = vlib_get_buffer (vm, ptd->buffers[co[4].buffer_vec_index]);
+      b1 = vlib_get_buffer (vm, ptd->buffers[co[5].buffer_vec_index]);
+      b2 = vlib_get_buffer (vm, ptd->buffers[co[6].buffer_vec_index]);
+      b3 = vlib_get_buffer (vm, ptd->buffers[co[7].buffer_vec_index]);
+      CLIB_PREFETCH (b0->data + co[4].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     STORE);
+      CLIB_PREFETCH (b1->data + co[5].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     STORE);
+      CLIB_PREFETCH (b2->data + co[6].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     STORE);
+      CLIB_PREFETCH (b3->data + co[7].buffer_offset, CLIB_CACHE_LINE_BYTES,
+		     STORE);
+
       b0 = vlib_get_buffer (vm, ptd->buffers[co[0].buffer_vec_index]);
       b1 = vlib_get_buffer (vm, ptd->buffers[co[1].buffer_vec_index]);
       b2 = vlib_get_buffer (vm, ptd->buffers[co[2].buffer_vec_index]);
@@ -340,40 +509,11 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 
   /* prepare buffer template and next indices */
-  vnet_buffer (&ptd->buffer_template)->sw_if_index[VLIB_RX] =
-    mif->sw_if_index;
-  vnet_buffer (&ptd->buffer_template)->feature_arc_index = 0;
-  ptd->buffer_template.current_data = start_offset;
-  ptd->buffer_template.current_config_index = 0;
-  ptd->buffer_template.buffer_pool_index = mq->buffer_pool_index;
-  ptd->buffer_template.ref_count = 1;
-
-  if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
-    {
-      next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-      if (mif->per_interface_next_index != ~0)
-	next_index = mif->per_interface_next_index;
-      else
-	vnet_feature_start_device_input_x1 (mif->sw_if_index, &next_index,
-					    &ptd->buffer_template);
-
-      vlib_get_new_next_frame (vm, node, next_index, to_next_bufs,
-			       n_left_to_next);
-      if (PREDICT_TRUE (next_index == VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT))
-	{
-	  vlib_next_frame_t *nf;
-	  vlib_frame_t *f;
-	  ethernet_input_frame_t *ef;
-	  nf = vlib_node_runtime_get_next_frame (vm, node, next_index);
-	  f = vlib_get_frame (vm, nf->frame);
-	  f->flags = ETH_INPUT_FRAME_F_SINGLE_SW_IF_IDX;
-
-	  ef = vlib_frame_scalar_args (f);
-	  ef->sw_if_index = mif->sw_if_index;
-	  ef->hw_if_index = mif->hw_if_index;
-	  vlib_frame_no_append (f);
-	}
-    }
+  memif_input_buffer_template (ptd, mif, mq, start_offset);
+  to_next_bufs = memif_input_get_next_frame (vm, node, mif, mode,
+					     &ptd->buffer_template,
+					     &next_index, &n_left_to_next,
+					     to_next_bufs);
 
   /* process buffer metadata */
   u32 n_from = n_rx_packets;
@@ -470,47 +610,8 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       next += 1;
     }
 
-  /* packet trace if enabled */
-  if (PREDICT_FALSE ((n_trace = vlib_get_trace_count (vm, node))))
-    {
-      u32 n_left = n_rx_packets;
-      bi = to_next_bufs;
-      next = nexts;
-      u32 ni = next_index;
-      while (n_trace && n_left)
-	{
-	  vlib_buffer_t *b;
-	  memif_input_trace_t *tr;
-	  if (mode != MEMIF_INTERFACE_MODE_ETHERNET)
-	    ni = next[0];
-	  b = vlib_get_buffer (vm, bi[0]);
-	  vlib_trace_buffer (vm, node, ni, b, /* follow_chain */ 0);
-	  tr = vlib_add_trace (vm, node, b, sizeof (*tr));
-	  tr->next_index = ni;
-	  tr->hw_if_index = mif->hw_if_index;
-	  tr->ring = qid;
-
-	  /* next */
-	  n_trace--;
-	  n_left--;
-	  bi++;
-	  next++;
-	}
-      vlib_set_trace_count (vm, node, n_trace);
-    }
-
-  if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
-    {
-      n_left_to_next -= n_rx_packets;
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-    }
-  else
-    vlib_buffer_enqueue_to_next (vm, node, to_next_bufs, nexts, n_rx_packets);
-
-  vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
-				   + VNET_INTERFACE_COUNTER_RX, thread_index,
-				   mif->hw_if_index, n_rx_packets,
-				   n_rx_bytes);
+  memif_input_enqueue (vm, node, mif, mode, qid, next_index, n_left_to_next,
+		       to_next_bufs, nexts, n_rx_packets, n_rx_bytes);
 
   /* refill ring with empty buffers */
 refill:
@@ -541,14 +642,13 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			      vlib_frame_t * frame, memif_if_t * mif,
 			      u16 qid, memif_interface_mode_t mode)
 {
-  vnet_main_t *vnm = vnet_get_main ();
   memif_main_t *mm = &memif_main;
   memif_ring_t *ring;
   memif_queue_t *mq;
-  u32 next_index;
-  uword n_trace = vlib_get_trace_count (vm, node);
+  u16 nexts[MEMIF_RX_VECTOR_SZ], *next = nexts;
+  u32 _to_next_bufs[MEMIF_RX_VECTOR_SZ], *to_next_bufs = _to_next_bufs;
+  u32 next_index, n_left_to_next = 0;
   u32 n_rx_packets = 0, n_rx_bytes = 0;
-  u32 *to_next = 0, *buffers;
   u32 bi0, bi1, bi2, bi3;
   u16 s0, s1, s2, s3;
   memif_desc_t *d0, *d1, *d2, *d3;
@@ -556,19 +656,17 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 thread_index = vm->thread_index;
   memif_per_thread_data_t *ptd = vec_elt_at_index (mm->per_thread_data,
 						   thread_index);
+  vlib_buffer_t bt;
   u16 cur_slot, last_slot, ring_size, n_slots, mask, head;
   i16 start_offset;
   u32 buffer_length;
-  u16 n_alloc, n_from;
+  u16 n_alloc;
 
   mq = vec_elt_at_index (mif->rx_queues, qid);
   ring = mq->ring;
   ring_size = 1 << mq->log2_ring_size;
   mask = ring_size - 1;
 
-  next_index = (mode == MEMIF_INTERFACE_MODE_IP) ?
-    VNET_DEVICE_INPUT_NEXT_IP6_INPUT : VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-
   /* asume that somebody will want to add ethernet header on the packet
      so start with IP header at offset 14 */
   start_offset = (mode == MEMIF_INTERFACE_MODE_IP) ? 14 : 0;
@@ -580,23 +678,34 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     goto refill;
   n_slots = last_slot - cur_slot;
 
-  /* process ring slots */
-  vec_validate_aligned (ptd->buffers, MEMIF_RX_VECTOR_SZ,
-			CLIB_CACHE_LINE_BYTES);
+  /* prepare buffer template and next frame, buffers are already filled by
+     the peer so metadata is written straight into the next frame */
+  memif_input_buffer_template (ptd, mif, mq, start_offset);
+  to_next_bufs = memif_input_get_next_frame (vm, node, mif, mode,
+					     &ptd->buffer_template,
+					     &next_index, &n_left_to_next,
+					     to_next_bufs);
+  vlib_buffer_copy_template (&bt, &ptd->buffer_template);
+
+  /* process ring slots, a packet may span several descriptors, each one
+     backed by its own buffer which becomes the next segment of the chain */
   while (n_slots && n_rx_packets < MEMIF_RX_VECTOR_SZ)
     {
       vlib_buffer_t *hb;
 
-      s0 = cur_slot & mask;
-      bi0 = mq->buffers[s0];
-      ptd->buffers[n_rx_packets++] = bi0;
-
+      vlib_prefetch_buffer_with_index (vm, mq->buffers[(cur_slot + 4) & mask],
+				       STORE);
       CLIB_PREFETCH (&ring->desc[(cur_slot + 8) & mask],
 		     CLIB_CACHE_LINE_BYTES, LOAD);
+
+      s0 = cur_slot & mask;
       d0 = &ring->desc[s0];
+      bi0 = mq->buffers[s0];
+      to_next_bufs[n_rx_packets++] = bi0;
       hb = b0 = vlib_get_buffer (vm, bi0);
-      b0->current_data = start_offset;
-      b0->current_length = start_offset + d0->length;
+      vlib_buffer_copy_template (b0, &bt);
+      hb->total_length_not_including_first_buffer = 0;
+      b0->current_length = d0->length;
       n_rx_bytes += d0->length;
 
       if (0 && memif_desc_is_invalid (mif, d0, buffer_length))
@@ -604,10 +713,8 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       cur_slot++;
       n_slots--;
-      if (PREDICT_FALSE ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots))
+      while (PREDICT_FALSE ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots))
 	{
-	  hb->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
-	next_slot:
 	  s0 = cur_slot & mask;
 	  d0 = &ring->desc[s0];
 	  bi0 = mq->buffers[s0];
@@ -618,167 +725,28 @@ memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  /* current buffer */
 	  b0 = vlib_get_buffer (vm, bi0);
-	  b0->current_data = start_offset;
-	  b0->current_length = start_offset + d0->length;
+	  vlib_buffer_copy_template (b0, &bt);
+	  b0->current_length = d0->length;
 	  hb->total_length_not_including_first_buffer += d0->length;
+	  hb->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
 	  n_rx_bytes += d0->length;
 
 	  cur_slot++;
 	  n_slots--;
-	  if ((d0->flags & MEMIF_DESC_FLAG_NEXT) && n_slots)
-	    goto next_slot;
 	}
+
+      if (mode == MEMIF_INTERFACE_MODE_IP)
+	next++[0] = memif_next_from_ip_hdr (node, hb);
     }
 
   /* release slots from the ring */
   mq->last_tail = cur_slot;
 
-  n_from = n_rx_packets;
-  buffers = ptd->buffers;
-
-  while (n_from)
-    {
-      u32 n_left_to_next;
-      u32 next0, next1, next2, next3;
-
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while (n_from >= 8 && n_left_to_next >= 4)
-	{
-	  b0 = vlib_get_buffer (vm, buffers[4]);
-	  b1 = vlib_get_buffer (vm, buffers[5]);
-	  b2 = vlib_get_buffer (vm, buffers[6]);
-	  b3 = vlib_get_buffer (vm, buffers[7]);
-	  vlib_prefetch_buffer_header (b0, STORE);
-	  vlib_prefetch_buffer_header (b1, STORE);
-	  vlib_prefetch_buffer_header (b2, STORE);
-	  vlib_prefetch_buffer_header (b3, STORE);
-
-	  /* enqueue buffer */
-	  to_next[0] = bi0 = buffers[0];
-	  to_next[1] = bi1 = buffers[1];
-	  to_next[2] = bi2 = buffers[2];
-	  to_next[3] = bi3 = buffers[3];
-	  to_next += 4;
-	  n_left_to_next -= 4;
-	  buffers += 4;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
-	  b2 = vlib_get_buffer (vm, bi2);
-	  b3 = vlib_get_buffer (vm, bi3);
-
-	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = mif->sw_if_index;
-	  vnet_buffer (b0)->sw_if_index[VLIB_TX] = ~0;
-	  vnet_buffer (b1)->sw_if_index[VLIB_RX] = mif->sw_if_index;
-	  vnet_buffer (b1)->sw_if_index[VLIB_TX] = ~0;
-	  vnet_buffer (b2)->sw_if_index[VLIB_RX] = mif->sw_if_index;
-	  vnet_buffer (b2)->sw_if_index[VLIB_TX] = ~0;
-	  vnet_buffer (b3)->sw_if_index[VLIB_RX] = mif->sw_if_index;
-	  vnet_buffer (b3)->sw_if_index[VLIB_TX] = ~0;
-
-	  if (mode == MEMIF_INTERFACE_MODE_IP)
-	    {
-	      next0 = memif_next_from_ip_hdr (node, b0);
-	      next1 = memif_next_from_ip_hdr (node, b1);
-	      next2 = memif_next_from_ip_hdr (node, b2);
-	      next3 = memif_next_from_ip_hdr (node, b3);
-	    }
-	  else if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
-	    {
-	      if (PREDICT_FALSE (mif->per_interface_next_index != ~0))
-		{
-		  next0 = mif->per_interface_next_index;
-		  next1 = mif->per_interface_next_index;
-		  next2 = mif->per_interface_next_index;
-		  next3 = mif->per_interface_next_index;
-		}
-	      else
-		{
-		  next0 = next1 = next2 = next3 = next_index;
-		  /* redirect if feature path enabled */
-		  vnet_feature_start_device_input_x1 (mif->sw_if_index,
-						      &next0, b0);
-		  vnet_feature_start_device_input_x1 (mif->sw_if_index,
-						      &next1, b1);
-		  vnet_feature_start_device_input_x1 (mif->sw_if_index,
-						      &next2, b2);
-		  vnet_feature_start_device_input_x1 (mif->sw_if_index,
-						      &next3, b3);
-		}
-	    }
-
-	  /* trace */
-	  if (PREDICT_FALSE (n_trace > 0))
-	    {
-	      memif_trace_buffer (vm, node, mif, b0, next0, qid, &n_trace);
-	      if (PREDICT_FALSE (n_trace > 0))
-		memif_trace_buffer (vm, node, mif, b1, next1, qid, &n_trace);
-	      if (PREDICT_FALSE (n_trace > 0))
-		memif_trace_buffer (vm, node, mif, b2, next2, qid, &n_trace);
-	      if (PREDICT_FALSE (n_trace > 0))
-		memif_trace_buffer (vm, node, mif, b3, next3, qid, &n_trace);
-	    }
-
-	  /* enqueue */
-	  vlib_validate_buffer_enqueue_x4 (vm, node, next_index, to_next,
-					   n_left_to_next, bi0, bi1, bi2, bi3,
-					   next0, next1, next2, next3);
-
-	  /* next */
-	  n_from -= 4;
-	}
-      while (n_from && n_left_to_next)
-	{
-	  /* enqueue buffer */
-	  to_next[0] = bi0 = buffers[0];
-	  to_next += 1;
-	  n_left_to_next--;
-	  buffers += 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = mif->sw_if_index;
-	  vnet_buffer (b0)->sw_if_index[VLIB_TX] = ~0;
-
-	  if (mode == MEMIF_INTERFACE_MODE_IP)
-	    {
-	      next0 = memif_next_from_ip_hdr (node, b0);
-	    }
-	  else if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
-	    {
-	      if (PREDICT_FALSE (mif->per_interface_next_index != ~0))
-		next0 = mif->per_interface_next_index;
-	      else
-		{
-		  next0 = next_index;
-		  /* redirect if feature path enabled */
-		  vnet_feature_start_device_input_x1 (mif->sw_if_index,
-						      &next0, b0);
-		}
-	    }
-
-	  /* trace */
-	  if (PREDICT_FALSE (n_trace > 0))
-	    memif_trace_buffer (vm, node, mif, b0, next0, qid, &n_trace);
-
-	  /* enqueue */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
-					   n_left_to_next, bi0, next0);
-
-	  /* next */
-	  n_from--;
-	}
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-    }
-
-  vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
-				   + VNET_INTERFACE_COUNTER_RX, thread_index,
-				   mif->hw_if_index, n_rx_packets,
-				   n_rx_bytes);
+  memif_input_enqueue (vm, node, mif, mode, qid, next_index, n_left_to_next,
+		       to_next_bufs, nexts, n_rx_packets, n_rx_bytes);
 
   /* refill ring with empty buffers */
 refill:
-  vec_reset_length (ptd->buffers);
-
   head = ring->head;
   n_slots = ring_size - head + mq->last_tail;
 
@@ -867,6 +835,47 @@ done:
 }
 
 
+/* in interrupt and adaptive modes the queue is only looked at again when
+   the peer signals it; make sure nothing is left behind in the ring */
+static_always_inline void
+memif_input_rearm (vlib_main_t * vm, vlib_node_runtime_t * node,
+		   memif_if_t * mif, vnet_device_and_queue_t * dq, u32 n_rx)
+{
+  memif_queue_t *mq = vec_elt_at_index (mif->rx_queues, dq->queue_id);
+  memif_ring_t *ring = mq->ring;
+  u16 last = (mif->flags & MEMIF_IF_FLAG_IS_SLAVE) ? mq->last_tail :
+    mq->last_head;
+
+  /* adaptive mode coalesces interrupts: while the queue keeps delivering
+     large bursts the peer is asked not to signal it and the queue is polled
+     from the next main loop iterations instead */
+  if (dq->mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE &&
+      n_rx >= MEMIF_RX_ADAPTIVE_POLL_THRESHOLD)
+    {
+      ring->flags |= MEMIF_RING_FLAG_MASK_INT;
+      mq->n_adaptive_polls++;
+      goto poll;
+    }
+
+  /* unmask in any other case, also when the queue left adaptive mode
+     while masked, or it would never be signalled again */
+  if (ring->flags & MEMIF_RING_FLAG_MASK_INT)
+    {
+      ring->flags &= ~MEMIF_RING_FLAG_MASK_INT;
+      /* peer may have seen the mask and skipped the interrupt for slots
+	 enqueued since our last look */
+      CLIB_MEMORY_BARRIER ();
+    }
+
+  if (((mif->flags & MEMIF_IF_FLAG_IS_SLAVE) ? ring->tail : ring->head) ==
+      last)
+    return;
+
+poll:
+  clib_atomic_store_rel_n (&dq->interrupt_pending, 1);
+  vlib_node_set_interrupt_pending (vm, node->node_index);
+}
+
 VLIB_NODE_FN (memif_input_node) (vlib_main_t * vm,
 				 vlib_node_runtime_t * node,
 				 vlib_frame_t * frame)
@@ -881,6 +890,7 @@ VLIB_NODE_FN (memif_input_node) (vlib_main_t * vm,
   foreach_device_and_queue (dq, rt->devices_and_queues)
   {
     memif_if_t *mif;
+    u32 n = 0;
     mif = vec_elt_at_index (mm->interfaces, dq->dev_instance);
     if ((mif->flags & MEMIF_IF_FLAG_ADMIN_UP) &&
 	(mif->flags & MEMIF_IF_FLAG_CONNECTED))
@@ -888,34 +898,38 @@ VLIB_NODE_FN (memif_input_node) (vlib_main_t * vm,
 	if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
-	      n_rx += memif_device_input_zc_inline (vm, node, frame, mif,
-						    dq->queue_id, mode_ip);
+	      n = memif_device_input_zc_inline (vm, node, frame, mif,
+						dq->queue_id, mode_ip);
 	    else
-	      n_rx += memif_device_input_zc_inline (vm, node, frame, mif,
-						    dq->queue_id, mode_eth);
+	      n = memif_device_input_zc_inline (vm, node, frame, mif,
+						dq->queue_id, mode_eth);
 	  }
 	else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
-	      n_rx += memif_device_input_inline (vm, node, frame, mif,
-						 MEMIF_RING_M2S, dq->queue_id,
-						 mode_ip);
+	      n = memif_device_input_inline (vm, node, frame, mif,
+					     MEMIF_RING_M2S, dq->queue_id,
+					     mode_ip);
 	    else
-	      n_rx += memif_device_input_inline (vm, node, frame, mif,
-						 MEMIF_RING_M2S, dq->queue_id,
-						 mode_eth);
+	      n = memif_device_input_inline (vm, node, frame, mif,
+					     MEMIF_RING_M2S, dq->queue_id,
+					     mode_eth);
 	  }
 	else
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
-	      n_rx += memif_device_input_inline (vm, node, frame, mif,
-						 MEMIF_RING_S2M, dq->queue_id,
-						 mode_ip);
+	      n = memif_device_input_inline (vm, node, frame, mif,
+					     MEMIF_RING_S2M, dq->queue_id,
+					     mode_ip);
 	    else
-	      n_rx += memif_device_input_inline (vm, node, frame, mif,
-						 MEMIF_RING_S2M, dq->queue_id,
-						 mode_eth);
+	      n = memif_device_input_inline (vm, node, frame, mif,
+					     MEMIF_RING_S2M, dq->queue_id,
+					     mode_eth);
 	  }
+
+	if (dq->mode != VNET_HW_INTERFACE_RX_MODE_POLLING)
+	  memif_input_rearm (vm, node, mif, dq, n);
+	n_rx += n;
       }
   }
 
@@ -129,6 +129,7 @@ typedef struct
   int int_fd;
   uword int_clib_file_index;
   u64 int_count;
+  u64 n_adaptive_polls;
 
   /* queue type */
   memif_ring_type_t type;
@@ -216,6 +217,10 @@ typedef struct
 
 #define MEMIF_RX_VECTOR_SZ VLIB_FRAME_SIZE
 
+/* adaptive rx mode keeps polling a queue instead of waiting for the peer
+   interrupt as long as it delivers at least this many packets per call */
+#define MEMIF_RX_ADAPTIVE_POLL_THRESHOLD 32
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
@@ -217,17 +217,18 @@ class TestMemif(VppTestCase):
 
         self._connect_test_interface_pair(memif, remote_memif)
 
-    def _create_icmp(self, pg, memif, num):
+    def _create_icmp(self, pg, memif, num, payload_len=0):
         pkts = []
         for i in range(num):
             pkt = (Ether(dst=pg.local_mac, src=pg.remote_mac) /
                    IP(src=pg.remote_ip4,
                       dst=str(memif.ip_prefix.network_address)) /
-                   ICMP(id=memif.if_id, type='echo-request', seq=i))
+                   ICMP(id=memif.if_id, type='echo-request', seq=i) /
+                   (b'\xa5' * payload_len))
             pkts.append(pkt)
         return pkts
 
-    def _verify_icmp(self, pg, memif, rx, seq):
+    def _verify_icmp(self, pg, memif, rx, seq, payload_len=0):
         ip = rx[IP]
         self.assertEqual(ip.src, str(memif.ip_prefix.network_address))
         self.assertEqual(ip.dst, pg.remote_ip4)
@@ -236,10 +237,9 @@ class TestMemif(VppTestCase):
         self.assertEqual(icmp.type, 0)  # echo-reply
         self.assertEqual(icmp.id, memif.if_id)
         self.assertEqual(icmp.seq, seq)
+        self.assertEqual(len(icmp.payload), payload_len)
 
-    def test_memif_ping(self):
-        """ Memif ping """
-
+    def _ping(self, packet_num=10, payload_len=0, rx_mode=None):
         memif = VppMemif(
             self,
             VppEnum.vl_api_memif_role_t.MEMIF_ROLE_API_SLAVE,
@@ -266,6 +266,11 @@ class TestMemif(VppTestCase):
         self.assertTrue(memif.wait_for_link_up(5))
         self.assertTrue(remote_memif.wait_for_link_up(5))
 
+        if rx_mode is not None:
+            for m in (memif, remote_memif):
+                m._test.vapi.sw_interface_set_rx_mode(
+                    sw_if_index=m.sw_if_index, mode=rx_mode)
+
         # add routing to remote vpp
         route = VppIpRoute(self.remote_test, self.pg0._local_ip4_subnet, 24,
                            [VppRoutePath(memif.ip_prefix.network_address,
@@ -275,8 +280,8 @@ class TestMemif(VppTestCase):
         route.add_vpp_config()
 
         # create ICMP echo-request from local pg to remote memif
-        packet_num = 10
-        pkts = self._create_icmp(self.pg0, remote_memif, packet_num)
+        pkts = self._create_icmp(self.pg0, remote_memif, packet_num,
+                                 payload_len)
 
         self.pg0.add_stream(pkts)
         self.pg_enable_capture(self.pg_interfaces)
@@ -284,11 +289,22 @@ class TestMemif(VppTestCase):
         capture = self.pg0.get_capture(packet_num, timeout=2)
         seq = 0
         for c in capture:
-            self._verify_icmp(self.pg0, remote_memif, c, seq)
+            self._verify_icmp(self.pg0, remote_memif, c, seq, payload_len)
             seq += 1
 
         route.remove_vpp_config()
 
+    def test_memif_ping(self):
+        """ Memif ping """
+        self._ping()
+
+    def test_memif_ping_chained_adaptive(self):
+        """ Memif ping, multi-descriptor packets in adaptive rx mode """
+        # packets don't fit in a single buffer, they are received as buffer
+        # chains by the zero-copy slave and sent back from them
+        self._ping(packet_num=100, payload_len=3000,
+                   rx_mode=VppEnum.vl_api_rx_mode_t.RX_MODE_API_ADAPTIVE)
+
 
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -387,7 +387,7 @@ nat_ha_failover_command_fn (vlib_main_t * vm, unformat_input_t * input,
 {
   unformat_input_t _line_input, *line_input = &_line_input;
   ip4_address_t addr;
-  u32 port, session_refresh_interval = 10;
+  u32 port, session_refresh_interval = 10, flush_interval = 0;
   int rv;
   clib_error_t *error = 0;
 
@@ -403,6 +403,8 @@ nat_ha_failover_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	if (unformat
 	    (line_input, "refresh-interval %u", &session_refresh_interval))
 	;
+      else if (unformat (line_input, "flush-interval %u", &flush_interval))
+	;
       else
 	{
 	  error = clib_error_return (0, "unknown input '%U'",
@@ -411,6 +413,16 @@ nat_ha_failover_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	}
     }
 
+  if (flush_interval)
+    {
+      rv = nat_ha_set_flush_interval (flush_interval);
+      if (rv)
+	{
+	  error = clib_error_return (0, "set HA flush interval failed");
+	  goto done;
+	}
+    }
+
   rv = nat_ha_set_failover (&addr, (u16) port, session_refresh_interval);
   if (rv)
     error = clib_error_return (0, "set HA failover failed");
@@ -482,9 +494,10 @@ nat_show_ha_command_fn (vlib_main_t * vm, unformat_input_t * input,
   nat_ha_get_failover (&addr, &port, &session_refresh_interval);
   vlib_cli_output (vm, "FAILOVER:\n");
   if (port)
-    vlib_cli_output (vm, "  %U:%u refresh-interval %usec\n",
+    vlib_cli_output (vm, "  %U:%u refresh-interval %usec "
+		     "flush-interval %umsec\n",
 		     format_ip4_address, &addr, port,
-		     session_refresh_interval);
+		     session_refresh_interval, nat_ha_get_flush_interval ());
   else
     vlib_cli_output (vm, "  NA\n");
 
@@ -2070,7 +2083,7 @@ VLIB_CLI_COMMAND (nat_show_mss_clamping_command, static) = {
 ?*/
 VLIB_CLI_COMMAND (nat_ha_failover_command, static) = {
     .path = "nat ha failover",
-    .short_help = "nat ha failover <ip4-address>:<port> [refresh-interval <sec>]",
+    .short_help = "nat ha failover <ip4-address>:<port> [refresh-interval <sec>] [flush-interval <msec>]",
     .function = nat_ha_failover_command_fn,
 };
 
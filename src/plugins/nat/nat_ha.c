@@ -21,6 +21,12 @@
 /* number of retries */
 #define NAT_HA_RETRIES 3
 
+/* default interval between flushes of HA data under construction */
+#define NAT_HA_FLUSH_INTERVAL_DEFAULT 1.0
+
+/* max number of sessions walked per resync dispatch of the worker node */
+#define NAT_HA_RESYNC_SESSIONS_PER_RUN 1024
+
 #define foreach_nat_ha_counter           \
 _(RECV_ADD, "add-event-recv", 0)         \
 _(RECV_DEL, "del-event-recv", 1)         \
@@ -115,10 +121,18 @@ typedef struct
   vlib_frame_t *state_sync_frame;
   /* number of events */
   u16 state_sync_count;
+  /* 1 if buffer under construction carries resync events */
+  u8 state_sync_is_resync;
   /* next event offset */
   u32 state_sync_next_event_offset;
   /* data waiting for ACK */
   nat_ha_resend_entry_t *resend_queue;
+  /* resend queue index by sequence number */
+  uword *resend_queue_by_seq;
+  /* 1 if session table snapshot (resync) in progress */
+  u8 resync_walk;
+  /* next session pool index to send during resync */
+  u32 resync_walk_index;
 } nat_ha_per_thread_data_t;
 
 /* NAT HA settings */
@@ -134,6 +148,8 @@ typedef struct nat_ha_main_s
   u32 state_sync_path_mtu;
   /* number of seconds after which to send session counters refresh */
   u32 session_refresh_interval;
+  /* number of seconds after which to flush HA data under construction */
+  f64 flush_interval;
   /* counters */
   vlib_simple_counter_main_t counters[NAT_HA_N_COUNTERS];
   vlib_main_t *vlib_main;
@@ -145,6 +161,8 @@ typedef struct nat_ha_main_s
   u32 resync_ack_count;
   /* number of missed ACK for resync */
   u32 resync_ack_missed;
+  /* number of threads still walking their session tables for resync */
+  u32 resync_threads_pending;
   /* resync data */
   nat_ha_resync_event_cb_t event_callback;
   u32 client_index;
@@ -171,11 +189,14 @@ nat_ha_resync_fin (void)
 {
   nat_ha_main_t *ha = &nat_ha_main;
 
-  /* if no more resync ACK remainig we are done */
-  if (ha->resync_ack_count)
+  /* if no more resync ACK remainig and all sessions sent we are done */
+  if (clib_atomic_load_acq_n (&ha->resync_ack_count) ||
+      clib_atomic_load_acq_n (&ha->resync_threads_pending))
+    return;
+
+  if (!clib_atomic_bool_cmp_and_swap (&ha->in_resync, 1, 0))
     return;
 
-  ha->in_resync = 0;
   if (ha->resync_ack_missed)
     {
       nat_elog_info ("resync completed with result FAILED");
@@ -204,37 +225,49 @@ nat_ha_resend_queue_add (u32 seq, u8 * data, u8 data_len, u8 is_resync,
   entry->seq = seq;
   entry->is_resync = is_resync;
   vec_add (entry->data, data, data_len);
+  hash_set (td->resend_queue_by_seq, seq, entry - td->resend_queue);
 
   return 0;
 }
 
+/* remove HA NAT data from resend queue */
+static void
+nat_ha_resend_queue_del (nat_ha_per_thread_data_t * td, u32 i)
+{
+  nat_ha_resend_entry_t *last;
+
+  hash_unset (td->resend_queue_by_seq, td->resend_queue[i].seq);
+  vec_free (td->resend_queue[i].data);
+  last = vec_end (td->resend_queue) - 1;
+  if (last != td->resend_queue + i)
+    hash_set (td->resend_queue_by_seq, last->seq, i);
+  vec_del1 (td->resend_queue, i);
+}
+
 static_always_inline void
 nat_ha_ack_recv (u32 seq, u32 thread_index)
 {
   nat_ha_main_t *ha = &nat_ha_main;
   nat_ha_per_thread_data_t *td = &ha->per_thread_data[thread_index];
+  uword *p;
   u32 i;
 
-  vec_foreach_index (i, td->resend_queue)
-  {
-    if (td->resend_queue[i].seq != seq)
-      continue;
-
-    vlib_increment_simple_counter (&ha->counters[NAT_HA_COUNTER_RECV_ACK],
-				   thread_index, 0, 1);
-    /* ACK received remove cached data */
-    if (td->resend_queue[i].is_resync)
-      {
-	clib_atomic_fetch_sub (&ha->resync_ack_count, 1);
-	nat_ha_resync_fin ();
-      }
-    vec_free (td->resend_queue[i].data);
-    vec_del1 (td->resend_queue, i);
-    nat_elog_debug_X1 ("ACK for seq %d received", "i4",
-		       clib_net_to_host_u32 (seq));
-
+  p = hash_get (td->resend_queue_by_seq, seq);
+  if (!p)
     return;
-  }
+  i = p[0];
+
+  vlib_increment_simple_counter (&ha->counters[NAT_HA_COUNTER_RECV_ACK],
+				 thread_index, 0, 1);
+  /* ACK received remove cached data */
+  if (td->resend_queue[i].is_resync)
+    {
+      clib_atomic_fetch_sub (&ha->resync_ack_count, 1);
+      nat_ha_resync_fin ();
+    }
+  nat_ha_resend_queue_del (td, i);
+  nat_elog_debug_X1 ("ACK for seq %d received", "i4",
+		     clib_net_to_host_u32 (seq));
 }
 
 /* scan non-ACKed HA NAT for retry */
@@ -301,11 +334,9 @@ nat_ha_resend_scan (f64 now, u32 thread_index)
     td->resend_queue[i].retry_timer = now + 2.0;
   }
 
-  vec_foreach (del, to_delete)
-  {
-    vec_free (td->resend_queue[*del].data);
-    vec_del1 (td->resend_queue, *del);
-  }
+  /* delete from the end, vec_del1 moves the last element into the hole */
+  vec_foreach_backwards (del, to_delete)
+    nat_ha_resend_queue_del (td, *del);
   vec_free (to_delete);
 }
 
@@ -325,6 +356,8 @@ nat_ha_init (vlib_main_t * vm, nat_ha_sadd_cb_t sadd_cb,
   ha->in_resync = 0;
   ha->resync_ack_count = 0;
   ha->resync_ack_missed = 0;
+  ha->resync_threads_pending = 0;
+  ha->flush_interval = NAT_HA_FLUSH_INTERVAL_DEFAULT;
   ha->vlib_main = vm;
   ha->sadd_cb = sadd_cb;
   ha->sdel_cb = sdel_cb;
@@ -417,6 +450,32 @@ nat_ha_get_failover (ip4_address_t * addr, u16 * port,
   *session_refresh_interval = ha->session_refresh_interval;
 }
 
+int
+nat_ha_set_flush_interval (u32 flush_interval_ms)
+{
+  nat_ha_main_t *ha = &nat_ha_main;
+
+  if (!flush_interval_ms)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  ha->flush_interval = flush_interval_ms / 1e3;
+
+  /* wake up HA process to pick up the new interval */
+  if (ha->dst_port)
+    vlib_process_signal_event (ha->vlib_main, nat_ha_process_node.index, 1,
+			       0);
+
+  return 0;
+}
+
+u32
+nat_ha_get_flush_interval (void)
+{
+  nat_ha_main_t *ha = &nat_ha_main;
+
+  return ha->flush_interval * 1e3;
+}
+
 static_always_inline void
 nat_ha_recv_add (nat_ha_event_t * event, f64 now, u32 thread_index)
 {
@@ -629,6 +688,7 @@ nat_ha_event_add (nat_ha_event_t * event, u8 do_flush, u32 thread_index,
       clib_memcpy_fast (b->data + offset, event, sizeof (*event));
       offset += sizeof (*event);
       td->state_sync_count++;
+      td->state_sync_is_resync |= is_resync;
       b->current_length += sizeof (*event);
 
       switch (event->event_type)
@@ -656,10 +716,13 @@ nat_ha_event_add (nat_ha_event_t * event, u8 do_flush, u32 thread_index,
   if (PREDICT_FALSE
       (do_flush || offset + (sizeof (*event)) > ha->state_sync_path_mtu))
     {
+      /* resync and delta events share the buffer under construction */
+      is_resync = td->state_sync_is_resync;
       nat_ha_send (f, b, is_resync, thread_index);
       td->state_sync_buffer = 0;
       td->state_sync_frame = 0;
       td->state_sync_count = 0;
+      td->state_sync_is_resync = 0;
       offset = 0;
       if (is_resync)
 	{
@@ -757,12 +820,66 @@ nat_ha_sref (ip4_address_t * out_addr, u16 out_port, ip4_address_t * eh_addr,
   nat_ha_event_add (&event, 0, thread_index, 0);
 }
 
+/* send next chunk of thread session table, return 1 if walk completed */
+static int
+nat_ha_resync_walk (u32 thread_index)
+{
+  nat_ha_main_t *ha = &nat_ha_main;
+  nat_ha_per_thread_data_t *td = &ha->per_thread_data[thread_index];
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  snat_session_t *s;
+  u32 i, n_sent = 0;
+
+  if (thread_index < vec_len (sm->per_thread_data))
+    {
+      tsm = &sm->per_thread_data[thread_index];
+      for (i = td->resync_walk_index; i < vec_len (tsm->sessions); i++)
+	{
+	  if (n_sent >= NAT_HA_RESYNC_SESSIONS_PER_RUN)
+	    {
+	      td->resync_walk_index = i;
+	      return 0;
+	    }
+	  if (pool_is_free_index (tsm->sessions, i))
+	    continue;
+	  s = pool_elt_at_index (tsm->sessions, i);
+	  nat_ha_sadd (&s->in2out.addr, s->in2out.port, &s->out2in.addr,
+		       s->out2in.port, &s->ext_host_addr, s->ext_host_port,
+		       &s->ext_host_nat_addr, s->ext_host_nat_port,
+		       s->in2out.protocol, s->in2out.fib_index, s->flags,
+		       thread_index, 1);
+	  n_sent++;
+	}
+    }
+
+  /* send the tail of the snapshot right away */
+  nat_ha_event_add (0, 1, thread_index, 1);
+  td->resync_walk = 0;
+  td->resync_walk_index = 0;
+  clib_atomic_fetch_sub (&ha->resync_threads_pending, 1);
+  nat_ha_resync_fin ();
+
+  return 1;
+}
+
 /* per thread process waiting for interrupt */
 static uword
 nat_ha_worker_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
 		  vlib_frame_t * f)
 {
+  nat_ha_main_t *ha = &nat_ha_main;
   u32 thread_index = vm->thread_index;
+  nat_ha_per_thread_data_t *td = &ha->per_thread_data[thread_index];
+
+  /* session table snapshot fills HA packets up to path MTU, keep walking
+     without flushing partial packets until the whole table is sent */
+  if (PREDICT_FALSE (td->resync_walk) && !nat_ha_resync_walk (thread_index))
+    {
+      vlib_node_set_interrupt_pending (vm, nat_ha_worker_node.index);
+      return 0;
+    }
+
   /* flush HA NAT data under construction */
   nat_ha_event_add (0, 1, thread_index, 0);
   /* scan if we need to resend some non-ACKed data */
@@ -796,7 +913,7 @@ nat_ha_process (vlib_main_t * vm, vlib_node_runtime_t * rt, vlib_frame_t * f)
 
   while (1)
     {
-      vlib_process_wait_for_event_or_clock (vm, 1.0);
+      vlib_process_wait_for_event_or_clock (vm, ha->flush_interval);
       event_type = vlib_process_get_events (vm, &event_data);
       vec_reset_length (event_data);
       for (ti = 0; ti < vec_len (vlib_mains); ti++)
@@ -820,6 +937,39 @@ VLIB_REGISTER_NODE (nat_ha_process_node) = {
 };
 /* *INDENT-ON* */
 
+int
+nat_ha_resync (u32 client_index, u32 pid,
+	       nat_ha_resync_event_cb_t event_callback)
+{
+  nat_ha_main_t *ha = &nat_ha_main;
+  nat_ha_per_thread_data_t *td;
+  u32 ti;
+
+  if (ha->in_resync)
+    return VNET_API_ERROR_IN_PROGRESS;
+
+  ha->resync_ack_count = 0;
+  ha->resync_ack_missed = 0;
+  ha->event_callback = event_callback;
+  ha->client_index = client_index;
+  ha->pid = pid;
+  ha->resync_threads_pending = vec_len (ha->per_thread_data);
+  ha->in_resync = 1;
+
+  /* each thread sends snapshot of its own session table, so the failover
+     installs sessions on the same thread without cross-thread access */
+  vec_foreach_index (ti, ha->per_thread_data)
+  {
+    td = &ha->per_thread_data[ti];
+    td->resync_walk_index = 0;
+    td->resync_walk = 1;
+    vlib_node_set_interrupt_pending (vlib_mains[ti],
+				     nat_ha_worker_node.index);
+  }
+
+  return 0;
+}
+
 void
 nat_ha_get_resync_status (u8 * in_resync, u32 * resync_ack_missed)
 {
@@ -79,6 +79,23 @@ int nat_ha_set_failover (ip4_address_t * addr, u16 port,
 void nat_ha_get_failover (ip4_address_t * addr, u16 * port,
 			  u32 * session_refresh_interval);
 
+/**
+ * @brief Set HA flush interval
+ *
+ * Session events are batched per thread up to the path MTU, data under
+ * construction is sent at latest after flush interval.
+ *
+ * @param flush_interval_ms number of milliseconds after which to flush
+ *
+ * @returns 0 on success, non-zero value otherwise.
+ */
+int nat_ha_set_flush_interval (u32 flush_interval_ms);
+
+/**
+ * @brief Get HA flush interval in milliseconds
+ */
+u32 nat_ha_get_flush_interval (void);
+
 /**
  * @brief Create session add HA event
  *
@@ -147,6 +164,9 @@ typedef void (*nat_ha_resync_event_cb_t) (u32 client_index, u32 pid,
 
 /**
  * @brief Resync HA (resend existing sessions to new failover)
+ *
+ * Each thread sends a snapshot of its session table in MTU sized messages,
+ * the walk is done in chunks so data path is not stalled.
  */
 int nat_ha_resync (u32 client_index, u32 pid,
 		   nat_ha_resync_event_cb_t event_callback);
@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 
+import os
 import socket
 import unittest
 import struct
@@ -4023,6 +4024,77 @@ class TestNAT44(MethodHolder):
         stats = self.statistics.get_counter('/nat44/ha/ack-recv')
         self.assertEqual(stats[0][0], 2)
 
+    @unittest.skipUnless(running_extended_tests, "part of extended tests")
+    def test_ha_resync(self):
+        """ Resync HA session table to new failover (active) """
+        self.nat44_add_address(self.nat_addr)
+        flags = self.config_flags.NAT_IS_INSIDE
+        self.vapi.nat44_interface_add_del_feature(
+            sw_if_index=self.pg0.sw_if_index,
+            flags=flags, is_add=1)
+        self.vapi.nat44_interface_add_del_feature(
+            sw_if_index=self.pg1.sw_if_index,
+            is_add=1)
+        self.vapi.nat_ha_set_listener(ip_address=self.pg3.local_ip4,
+                                      port=12345,
+                                      path_mtu=512)
+        self.vapi.cli("nat ha failover %s:12346 flush-interval 100" %
+                      self.pg3.remote_ip4)
+        bind_layers(UDP, HANATStateSync, sport=12345)
+
+        # create sessions
+        pkts = self.create_stream_in(self.pg0, self.pg1)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        capture = self.pg1.get_capture(len(pkts))
+        self.verify_capture_out(capture)
+
+        # session events flushed after flush interval, ACK them
+        capture = self.pg3.get_capture(1)
+        seq = capture[0][HANATStateSync].sequence_number
+        ack = (Ether(dst=self.pg3.local_mac, src=self.pg3.remote_mac) /
+               IP(src=self.pg3.remote_ip4, dst=self.pg3.local_ip4) /
+               UDP(sport=12346, dport=12345) /
+               HANATStateSync(sequence_number=seq, flags='ACK'))
+        self.pg3.add_stream(ack)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        # resend whole session table
+        self.vapi.nat_ha_resync(want_resync_event=1, pid=os.getpid())
+        capture = self.pg3.get_capture(1)
+        p = capture[0]
+        self.assert_packet_checksums_valid(p)
+        try:
+            hanat = p[HANATStateSync]
+        except IndexError:
+            self.logger.error(ppp("Invalid packet:", p))
+            raise
+        else:
+            self.assertEqual(hanat.version, 1)
+            self.assertEqual(hanat.thread_index, 0)
+            self.assertEqual(hanat.count, 3)
+            self.assertGreater(hanat.sequence_number, seq)
+            for event in hanat.events:
+                self.assertEqual(event.event_type, 1)
+                self.assertEqual(event.in_addr, self.pg0.remote_ip4)
+                self.assertEqual(event.out_addr, self.nat_addr)
+                self.assertEqual(event.fib_index, 0)
+        stats = self.statistics.get_counter('/nat44/ha/add-event-send')
+        self.assertEqual(stats[0][0], 6)
+
+        # resync completed when all messages ACKed
+        ack = (Ether(dst=self.pg3.local_mac, src=self.pg3.remote_mac) /
+               IP(src=self.pg3.remote_ip4, dst=self.pg3.local_ip4) /
+               UDP(sport=12346, dport=12345) /
+               HANATStateSync(sequence_number=hanat.sequence_number,
+                              flags='ACK'))
+        self.pg3.add_stream(ack)
+        self.pg_start()
+        ev = self.vapi.wait_for_event(2, "nat_ha_resync_completed_event")
+        self.assertEqual(ev.missed_count, 0)
+
     def test_ha_recv(self):
         """ Receive HA session synchronization events (passive) """
         self.nat44_add_address(self.nat_addr)
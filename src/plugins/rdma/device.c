@@ -70,6 +70,8 @@ rdma_rxq_init_flow (const rdma_device_t * rd, struct ibv_qp *qp,
   fa.attr.num_of_specs = 1;
   fa.attr.port = 1;
   fa.attr.flags = flags;
+  /* lower than offloaded flows, see rdma_flow_add () */
+  fa.attr.priority = 1;
   fa.spec_eth.type = IBV_FLOW_SPEC_ETH;
   fa.spec_eth.size = sizeof (struct ibv_flow_spec_eth);
 
@@ -356,6 +358,8 @@ static void
 rdma_dev_cleanup (rdma_device_t * rd)
 {
   rdma_main_t *rm = &rdma_main;
+  rdma_flow_entry_t *fe;
+  rdma_queue_group_t *qg;
   rdma_rxq_t *rxq;
   rdma_txq_t *txq;
 
@@ -368,6 +372,17 @@ rdma_dev_cleanup (rdma_device_t * rd)
 
   _(ibv_destroy_flow, rd->flow_mcast);
   _(ibv_destroy_flow, rd->flow_ucast);
+  /* *INDENT-OFF* */
+  pool_foreach (fe, rd->flow_entries,
+  ({
+    _(ibv_destroy_flow, fe->flow);
+  }));
+  pool_foreach (qg, rd->queue_groups,
+  ({
+    _(ibv_destroy_qp, qg->qp);
+    _(ibv_destroy_rwq_ind_table, qg->ind_tbl);
+  }));
+  /* *INDENT-ON* */
   _(ibv_dereg_mr, rd->mr);
   vec_foreach (txq, rd->txqs)
   {
@@ -387,6 +402,8 @@ rdma_dev_cleanup (rdma_device_t * rd)
 
   clib_error_free (rd->error);
 
+  pool_free (rd->flow_entries);
+  pool_free (rd->queue_groups);
   vec_free (rd->rxqs);
   vec_free (rd->txqs);
   vec_free (rd->name);
@@ -428,25 +445,27 @@ rdma_rxq_init (vlib_main_t * vm, rdma_device_t * rd, u16 qid, u32 n_desc)
 }
 
 static clib_error_t *
-rdma_rxq_finalize (vlib_main_t * vm, rdma_device_t * rd)
+rdma_rss_qp_create (rdma_device_t * rd, u32 queue_index, u32 queue_num,
+		    struct ibv_rwq_ind_table **ind_tbl_ret,
+		    struct ibv_qp **qp_ret)
 {
   struct ibv_rwq_ind_table_init_attr rwqia;
   struct ibv_qp_init_attr_ex qpia;
   struct ibv_wq **ind_tbl;
   u32 i;
 
-  ASSERT (is_pow2 (vec_len (rd->rxqs))
-	  && "rxq number should be a power of 2");
+  ASSERT (is_pow2 (queue_num) && "rxq number should be a power of 2");
 
-  ind_tbl = vec_new (struct ibv_wq *, vec_len (rd->rxqs));
-  vec_foreach_index (i, rd->rxqs)
-    ind_tbl[i] = vec_elt_at_index (rd->rxqs, i)->wq;
+  ind_tbl = vec_new (struct ibv_wq *, queue_num);
+  for (i = 0; i < queue_num; i++)
+    ind_tbl[i] = vec_elt_at_index (rd->rxqs, queue_index + i)->wq;
   memset (&rwqia, 0, sizeof (rwqia));
   rwqia.log_ind_tbl_size = min_log2 (vec_len (ind_tbl));
   rwqia.ind_tbl = ind_tbl;
-  if ((rd->rx_rwq_ind_tbl = ibv_create_rwq_ind_table (rd->ctx, &rwqia)) == 0)
-    return clib_error_return_unix (0, "RWQ indirection table create failed");
+  *ind_tbl_ret = ibv_create_rwq_ind_table (rd->ctx, &rwqia);
   vec_free (ind_tbl);
+  if (*ind_tbl_ret == 0)
+    return clib_error_return_unix (0, "RWQ indirection table create failed");
 
   memset (&qpia, 0, sizeof (qpia));
   qpia.qp_type = IBV_QPT_RAW_PACKET;
@@ -454,16 +473,28 @@ rdma_rxq_finalize (vlib_main_t * vm, rdma_device_t * rd)
     IBV_QP_INIT_ATTR_PD | IBV_QP_INIT_ATTR_IND_TABLE |
     IBV_QP_INIT_ATTR_RX_HASH;
   qpia.pd = rd->pd;
-  qpia.rwq_ind_tbl = rd->rx_rwq_ind_tbl;
+  qpia.rwq_ind_tbl = *ind_tbl_ret;
   STATIC_ASSERT_SIZEOF (rdma_rss_hash_key, 40);
   qpia.rx_hash_conf.rx_hash_key_len = sizeof (rdma_rss_hash_key);
   qpia.rx_hash_conf.rx_hash_key = rdma_rss_hash_key;
   qpia.rx_hash_conf.rx_hash_function = IBV_RX_HASH_FUNC_TOEPLITZ;
   qpia.rx_hash_conf.rx_hash_fields_mask =
     IBV_RX_HASH_SRC_IPV4 | IBV_RX_HASH_DST_IPV4;
-  if ((rd->rx_qp = ibv_create_qp_ex (rd->ctx, &qpia)) == 0)
+  if ((*qp_ret = ibv_create_qp_ex (rd->ctx, &qpia)) == 0)
     return clib_error_return_unix (0, "Queue Pair create failed");
 
+  return 0;
+}
+
+static clib_error_t *
+rdma_rxq_finalize (vlib_main_t * vm, rdma_device_t * rd)
+{
+  clib_error_t *err;
+
+  if ((err = rdma_rss_qp_create (rd, 0, vec_len (rd->rxqs),
+				 &rd->rx_rwq_ind_tbl, &rd->rx_qp)))
+    return err;
+
   if (rdma_dev_set_ucast (rd))
     return clib_error_return_unix (0, "Set unicast mode failed");
 
@@ -645,6 +676,7 @@ rdma_create_if (vlib_main_t * vm, rdma_create_if_args_t * args)
   pool_get_zero (rm->devices, rd);
   rd->dev_instance = rd - rm->devices;
   rd->per_interface_next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+  rd->flow_backend = &rdma_flow_backend_ibv;
   rd->linux_ifname = format (0, "%s", args->ifname);
 
   if (!args->name || 0 == args->name[0])
@@ -772,6 +804,58 @@ rdma_set_interface_next_node (vnet_main_t * vnm, u32 hw_if_index,
     vlib_node_add_next (vlib_get_main (), rdma_input_node.index, node_index);
 }
 
+static struct ibv_flow *
+rdma_flow_create_ibv (rdma_device_t * rd, struct ibv_qp *qp,
+		      rdma_flow_attr_t * fa)
+{
+  struct ibv_flow *flow;
+
+  if ((flow = ibv_create_flow (qp, &fa->attr)) == 0)
+    rdma_log (VLIB_LOG_LEVEL_ERR, rd, "ibv_create_flow() failed");
+  return flow;
+}
+
+static int
+rdma_flow_destroy_ibv (rdma_device_t * rd, struct ibv_flow *flow)
+{
+  int rv;
+
+  if ((rv = ibv_destroy_flow (flow)))
+    rdma_log (VLIB_LOG_LEVEL_ERR, rd, "ibv_destroy_flow() failed");
+  return rv;
+}
+
+static clib_error_t *
+rdma_queue_group_create_ibv (rdma_device_t * rd, rdma_queue_group_t * qg)
+{
+  clib_error_t *err;
+
+  err = rdma_rss_qp_create (rd, qg->queue_index, qg->queue_num,
+			    &qg->ind_tbl, &qg->qp);
+  if (err && qg->ind_tbl)
+    {
+      ibv_destroy_rwq_ind_table (qg->ind_tbl);
+      qg->ind_tbl = 0;
+    }
+  return err;
+}
+
+static void
+rdma_queue_group_destroy_ibv (rdma_device_t * rd, rdma_queue_group_t * qg)
+{
+  if (ibv_destroy_qp (qg->qp))
+    rdma_log (VLIB_LOG_LEVEL_ERR, rd, "ibv_destroy_qp() failed");
+  if (ibv_destroy_rwq_ind_table (qg->ind_tbl))
+    rdma_log (VLIB_LOG_LEVEL_ERR, rd, "ibv_destroy_rwq_ind_table() failed");
+}
+
+const rdma_flow_backend_t rdma_flow_backend_ibv = {
+  .create_flow = rdma_flow_create_ibv,
+  .destroy_flow = rdma_flow_destroy_ibv,
+  .create_queue_group = rdma_queue_group_create_ibv,
+  .destroy_queue_group = rdma_queue_group_destroy_ibv,
+};
+
 static char *rdma_tx_func_error_strings[] = {
 #define _(n,s) s,
   foreach_rdma_tx_func_error
@@ -789,6 +873,8 @@ VNET_DEVICE_CLASS (rdma_device_class) =
   .tx_function_n_errors = RDMA_TX_N_ERROR,
   .tx_function_error_strings = rdma_tx_func_error_strings,
   .mac_addr_change_function = rdma_mac_change,
+  .flow_ops_function = rdma_flow_ops_fn,
+  .format_flow = format_rdma_flow,
 };
 /* *INDENT-ON* */
 
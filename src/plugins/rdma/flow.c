@@ -0,0 +1,378 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip.h>
+
+#include <rdma/rdma.h>
+
+/* the flow tag is not reported by the ibv completion path rdma-input
+   uses, so packets cannot be marked */
+#define RDMA_FLOW_SUPPORTED_ACTIONS \
+  (VNET_FLOW_ACTION_REDIRECT_TO_QUEUE | VNET_FLOW_ACTION_RSS | \
+   VNET_FLOW_ACTION_DROP)
+
+#define RDMA_FLOW_FATE_ACTIONS RDMA_FLOW_SUPPORTED_ACTIONS
+
+static void *
+rdma_flow_spec_add (rdma_flow_attr_t * fa, u8 ** next,
+		    enum ibv_flow_spec_type type, u16 size)
+{
+  struct ibv_flow_spec *spec = (struct ibv_flow_spec *) (*next);
+
+  ASSERT (*next + size <= fa->specs + sizeof (fa->specs));
+  spec->hdr.type = type;
+  spec->hdr.size = size;
+  fa->attr.num_of_specs++;
+  *next += size;
+  return spec;
+}
+
+static void
+rdma_flow_eth (rdma_flow_attr_t * fa, u8 ** next, ethernet_header_t * eth)
+{
+  struct ibv_flow_spec_eth *spec;
+  const u8 zero_mac[6] = { 0 };
+
+  spec = rdma_flow_spec_add (fa, next, IBV_FLOW_SPEC_ETH, sizeof (*spec));
+  if (eth == 0)
+    return;
+
+  if (memcmp (eth->dst_address, zero_mac, sizeof (zero_mac)))
+    {
+      clib_memcpy_fast (spec->val.dst_mac, eth->dst_address, 6);
+      clib_memset (spec->mask.dst_mac, 0xff, 6);
+    }
+  if (memcmp (eth->src_address, zero_mac, sizeof (zero_mac)))
+    {
+      clib_memcpy_fast (spec->val.src_mac, eth->src_address, 6);
+      clib_memset (spec->mask.src_mac, 0xff, 6);
+    }
+  if (eth->type)
+    {
+      spec->val.ether_type = clib_host_to_net_u16 (eth->type);
+      spec->mask.ether_type = 0xffff;
+    }
+}
+
+static void
+rdma_flow_ip4 (rdma_flow_attr_t * fa, u8 ** next,
+	       ip4_address_and_mask_t * src, ip4_address_and_mask_t * dst)
+{
+  struct ibv_flow_spec_ipv4 *spec;
+
+  spec = rdma_flow_spec_add (fa, next, IBV_FLOW_SPEC_IPV4, sizeof (*spec));
+  spec->val.src_ip = src->addr.as_u32 & src->mask.as_u32;
+  spec->mask.src_ip = src->mask.as_u32;
+  spec->val.dst_ip = dst->addr.as_u32 & dst->mask.as_u32;
+  spec->mask.dst_ip = dst->mask.as_u32;
+}
+
+static void
+rdma_flow_ip6 (rdma_flow_attr_t * fa, u8 ** next,
+	       ip6_address_and_mask_t * src, ip6_address_and_mask_t * dst)
+{
+  struct ibv_flow_spec_ipv6 *spec;
+  int i;
+
+  spec = rdma_flow_spec_add (fa, next, IBV_FLOW_SPEC_IPV6, sizeof (*spec));
+  for (i = 0; i < 16; i++)
+    {
+      spec->val.src_ip[i] = src->addr.as_u8[i] & src->mask.as_u8[i];
+      spec->mask.src_ip[i] = src->mask.as_u8[i];
+      spec->val.dst_ip[i] = dst->addr.as_u8[i] & dst->mask.as_u8[i];
+      spec->mask.dst_ip[i] = dst->mask.as_u8[i];
+    }
+}
+
+static int
+rdma_flow_l4 (rdma_flow_attr_t * fa, u8 ** next, ip_protocol_t protocol,
+	      ip_port_and_mask_t * src, ip_port_and_mask_t * dst)
+{
+  struct ibv_flow_spec_tcp_udp *spec;
+
+  if (protocol != IP_PROTOCOL_UDP && protocol != IP_PROTOCOL_TCP)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  spec = rdma_flow_spec_add (fa, next, protocol == IP_PROTOCOL_UDP ?
+			     IBV_FLOW_SPEC_UDP : IBV_FLOW_SPEC_TCP,
+			     sizeof (*spec));
+  spec->val.src_port = clib_host_to_net_u16 (src->port & src->mask);
+  spec->mask.src_port = clib_host_to_net_u16 (src->mask);
+  spec->val.dst_port = clib_host_to_net_u16 (dst->port & dst->mask);
+  spec->mask.dst_port = clib_host_to_net_u16 (dst->mask);
+  return 0;
+}
+
+static void
+rdma_flow_vxlan (rdma_flow_attr_t * fa, u8 ** next, u16 dst_port, u32 vni)
+{
+  struct ibv_flow_spec_tcp_udp *udp;
+  struct ibv_flow_spec_tunnel *tunnel;
+
+  udp = rdma_flow_spec_add (fa, next, IBV_FLOW_SPEC_UDP, sizeof (*udp));
+  udp->val.dst_port = clib_host_to_net_u16 (dst_port);
+  udp->mask.dst_port = 0xffff;
+
+  /* 24-bit vni in the 3 last bytes */
+  tunnel = rdma_flow_spec_add (fa, next, IBV_FLOW_SPEC_VXLAN_TUNNEL,
+			       sizeof (*tunnel));
+  tunnel->val.tunnel_id = clib_host_to_net_u32 (vni);
+  tunnel->mask.tunnel_id = clib_host_to_net_u32 (0xffffff);
+}
+
+static int
+rdma_flow_attr_init (rdma_device_t * rd, vnet_flow_t * f,
+		     rdma_flow_attr_t * fa)
+{
+  u8 *next = fa->specs;
+  int rv = 0;
+
+  clib_memset (fa, 0, sizeof (*fa));
+  fa->attr.type = IBV_FLOW_ATTR_NORMAL;
+  fa->attr.port = 1;
+  /* ahead of the mac filter flows */
+  fa->attr.priority = 0;
+
+  switch (f->type)
+    {
+    case VNET_FLOW_TYPE_ETHERNET:
+      rdma_flow_eth (fa, &next, &f->ethernet.eth_hdr);
+      break;
+
+    case VNET_FLOW_TYPE_IP4_N_TUPLE:
+      rdma_flow_eth (fa, &next, 0);
+      rdma_flow_ip4 (fa, &next, &f->ip4_n_tuple.src_addr,
+		     &f->ip4_n_tuple.dst_addr);
+      rv = rdma_flow_l4 (fa, &next, f->ip4_n_tuple.protocol,
+			 &f->ip4_n_tuple.src_port, &f->ip4_n_tuple.dst_port);
+      break;
+
+    case VNET_FLOW_TYPE_IP6_N_TUPLE:
+      rdma_flow_eth (fa, &next, 0);
+      rdma_flow_ip6 (fa, &next, &f->ip6_n_tuple.src_addr,
+		     &f->ip6_n_tuple.dst_addr);
+      rv = rdma_flow_l4 (fa, &next, f->ip6_n_tuple.protocol,
+			 &f->ip6_n_tuple.src_port, &f->ip6_n_tuple.dst_port);
+      break;
+
+    case VNET_FLOW_TYPE_IP4_VXLAN:
+      {
+	ip4_address_and_mask_t src = {.addr = f->ip4_vxlan.src_addr };
+	ip4_address_and_mask_t dst = {.addr = f->ip4_vxlan.dst_addr };
+
+	src.mask.as_u32 = src.addr.as_u32 ? ~0 : 0;
+	dst.mask.as_u32 = dst.addr.as_u32 ? ~0 : 0;
+	rdma_flow_eth (fa, &next, 0);
+	rdma_flow_ip4 (fa, &next, &src, &dst);
+	rdma_flow_vxlan (fa, &next, f->ip4_vxlan.dst_port, f->ip4_vxlan.vni);
+      }
+      break;
+
+    default:
+      return VNET_FLOW_ERROR_NOT_SUPPORTED;
+    }
+
+  if (rv == 0 && (f->actions & VNET_FLOW_ACTION_DROP))
+    rdma_flow_spec_add (fa, &next, IBV_FLOW_SPEC_ACTION_DROP,
+			sizeof (struct ibv_flow_spec_action_drop));
+
+  return rv;
+}
+
+static int
+rdma_queue_group_get (rdma_device_t * rd, u32 queue_index, u32 queue_num,
+		      u32 * queue_group_index)
+{
+  rdma_queue_group_t *qg;
+  clib_error_t *err;
+
+  if (queue_num == 0 || !is_pow2 (queue_num) ||
+      queue_index + queue_num > vec_len (rd->rxqs))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  /* *INDENT-OFF* */
+  pool_foreach (qg, rd->queue_groups,
+  ({
+    if (qg->queue_index == queue_index && qg->queue_num == queue_num)
+      {
+	qg->refcnt++;
+	*queue_group_index = qg - rd->queue_groups;
+	return 0;
+      }
+  }));
+  /* *INDENT-ON* */
+
+  pool_get_zero (rd->queue_groups, qg);
+  qg->queue_index = queue_index;
+  qg->queue_num = queue_num;
+
+  if ((err = rd->flow_backend->create_queue_group (rd, qg)))
+    {
+      vlib_log_err (rdma_main.log_class, "%v: %U", rd->name,
+		    format_clib_error, err);
+      clib_error_free (err);
+      pool_put (rd->queue_groups, qg);
+      return VNET_FLOW_ERROR_INTERNAL;
+    }
+
+  qg->refcnt = 1;
+  *queue_group_index = qg - rd->queue_groups;
+  return 0;
+}
+
+static void
+rdma_queue_group_put (rdma_device_t * rd, u32 queue_group_index)
+{
+  rdma_queue_group_t *qg;
+
+  if (queue_group_index == ~0)
+    return;
+
+  qg = pool_elt_at_index (rd->queue_groups, queue_group_index);
+  if (--qg->refcnt)
+    return;
+
+  rd->flow_backend->destroy_queue_group (rd, qg);
+  pool_put (rd->queue_groups, qg);
+}
+
+int
+rdma_flow_add (vlib_main_t * vm, rdma_device_t * rd, vnet_flow_t * f,
+	       uword * private_data)
+{
+  rdma_flow_entry_t *fe;
+  rdma_flow_attr_t fa;
+  struct ibv_qp *qp = rd->rx_qp;
+  u32 fate = f->actions & RDMA_FLOW_FATE_ACTIONS;
+  int rv;
+
+  if (f->actions & ~RDMA_FLOW_SUPPORTED_ACTIONS)
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  /* one fate per flow */
+  if (fate & (fate - 1))
+    return VNET_FLOW_ERROR_NOT_SUPPORTED;
+
+  if ((rv = rdma_flow_attr_init (rd, f, &fa)))
+    return rv;
+
+  pool_get_zero (rd->flow_entries, fe);
+  fe->flow_index = f->index;
+  fe->queue_group_index = ~0;
+
+  if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_QUEUE)
+    rv = rdma_queue_group_get (rd, f->redirect_queue, 1,
+			       &fe->queue_group_index);
+  else if (f->actions & VNET_FLOW_ACTION_RSS)
+    rv = rdma_queue_group_get (rd, f->queue_index, f->queue_num,
+			       &fe->queue_group_index);
+  if (rv)
+    goto done;
+
+  if (fe->queue_group_index != ~0)
+    qp = pool_elt_at_index (rd->queue_groups, fe->queue_group_index)->qp;
+
+  if ((fe->flow = rd->flow_backend->create_flow (rd, qp, &fa)) == 0)
+    {
+      rv = VNET_FLOW_ERROR_INTERNAL;
+      goto done;
+    }
+
+  *private_data = fe - rd->flow_entries;
+
+done:
+  if (rv)
+    {
+      rdma_queue_group_put (rd, fe->queue_group_index);
+      pool_put (rd->flow_entries, fe);
+    }
+  return rv;
+}
+
+int
+rdma_flow_del (vlib_main_t * vm, rdma_device_t * rd, uword private_data)
+{
+  rdma_flow_entry_t *fe = pool_elt_at_index (rd->flow_entries, private_data);
+
+  if (rd->flow_backend->destroy_flow (rd, fe->flow))
+    return VNET_FLOW_ERROR_INTERNAL;
+
+  rdma_queue_group_put (rd, fe->queue_group_index);
+  pool_put (rd->flow_entries, fe);
+  return 0;
+}
+
+int
+rdma_flow_ops_fn (vnet_main_t * vnm, vnet_flow_dev_op_t op, u32 dev_instance,
+		  u32 flow_index, uword * private_data)
+{
+  rdma_main_t *rm = &rdma_main;
+  rdma_device_t *rd = pool_elt_at_index (rm->devices, dev_instance);
+  vlib_main_t *vm = vlib_get_main ();
+
+  if (op == VNET_FLOW_DEV_OP_ADD_FLOW)
+    return rdma_flow_add (vm, rd, vnet_get_flow (flow_index), private_data);
+
+  if (op == VNET_FLOW_DEV_OP_DEL_FLOW)
+    return rdma_flow_del (vm, rd, *private_data);
+
+  return VNET_FLOW_ERROR_NOT_SUPPORTED;
+}
+
+u8 *
+format_rdma_flow (u8 * s, va_list * args)
+{
+  u32 dev_instance = va_arg (*args, u32);
+  u32 flow_index = va_arg (*args, u32);
+  uword private_data = va_arg (*args, uword);
+  rdma_main_t *rm = &rdma_main;
+  rdma_device_t *rd = pool_elt_at_index (rm->devices, dev_instance);
+  rdma_flow_entry_t *fe;
+  rdma_queue_group_t *qg;
+
+  if (flow_index == ~0)
+    {
+      s = format (s, "%-25s: %U\n", "supported flow actions",
+		  format_flow_actions, RDMA_FLOW_SUPPORTED_ACTIONS);
+      s = format (s, "%-25s: %u\n", "offloaded flows",
+		  pool_elts (rd->flow_entries));
+      s = format (s, "%-25s: %u\n", "queue groups",
+		  pool_elts (rd->queue_groups));
+      return s;
+    }
+
+  if (pool_is_free_index (rd->flow_entries, private_data))
+    return format (s, "unknown flow");
+
+  fe = pool_elt_at_index (rd->flow_entries, private_data);
+  if (fe->queue_group_index == ~0)
+    return format (s, "default queues");
+
+  qg = pool_elt_at_index (rd->queue_groups, fe->queue_group_index);
+  return format (s, "queues %u to %u", qg->queue_index,
+		 qg->queue_index + qg->queue_num - 1);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
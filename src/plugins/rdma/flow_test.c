@@ -0,0 +1,302 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Flow offload unit tests: flows are programmed on a fake device through
+ * a mock backend, which records the ibv flow specs instead of creating
+ * flows and queue pairs
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/ip/ip.h>
+
+#include <rdma/rdma.h>
+
+typedef struct
+{
+  rdma_flow_attr_t last_attr;
+  struct ibv_qp *last_qp;
+  /* fail the next flow creation */
+  int fail;
+  u32 n_flows;
+  u32 n_queue_groups;
+  u32 next_id;
+} rdma_flow_mock_t;
+
+static rdma_flow_mock_t rdma_flow_mock;
+
+static struct ibv_flow *
+rdma_flow_mock_create_flow (rdma_device_t * rd, struct ibv_qp *qp,
+			    rdma_flow_attr_t * fa)
+{
+  rdma_flow_mock_t *mock = &rdma_flow_mock;
+
+  clib_memcpy_fast (&mock->last_attr, fa, sizeof (*fa));
+  mock->last_qp = qp;
+  if (mock->fail)
+    return 0;
+  mock->n_flows++;
+  return uword_to_pointer (++mock->next_id, struct ibv_flow *);
+}
+
+static int
+rdma_flow_mock_destroy_flow (rdma_device_t * rd, struct ibv_flow *flow)
+{
+  rdma_flow_mock.n_flows--;
+  return 0;
+}
+
+static clib_error_t *
+rdma_flow_mock_create_queue_group (rdma_device_t * rd,
+				   rdma_queue_group_t * qg)
+{
+  rdma_flow_mock_t *mock = &rdma_flow_mock;
+
+  mock->n_queue_groups++;
+  qg->qp = uword_to_pointer (++mock->next_id, struct ibv_qp *);
+  return 0;
+}
+
+static void
+rdma_flow_mock_destroy_queue_group (rdma_device_t * rd,
+				    rdma_queue_group_t * qg)
+{
+  rdma_flow_mock.n_queue_groups--;
+}
+
+static const rdma_flow_backend_t rdma_flow_backend_mock = {
+  .create_flow = rdma_flow_mock_create_flow,
+  .destroy_flow = rdma_flow_mock_destroy_flow,
+  .create_queue_group = rdma_flow_mock_create_queue_group,
+  .destroy_queue_group = rdma_flow_mock_destroy_queue_group,
+};
+
+#define RDMA_FLOW_TEST(_cond, _comment, _args...)			\
+  do {									\
+    if (!(_cond))							\
+      {									\
+	vlib_cli_output (vm, "FAIL:%d: " _comment, __LINE__, ##_args);	\
+	n_fails++;							\
+      }									\
+  } while (0)
+
+/* n-th spec of the last flow */
+static struct ibv_flow_spec *
+rdma_flow_test_spec (u32 n)
+{
+  u8 *p = rdma_flow_mock.last_attr.specs;
+
+  while (n--)
+    p += ((struct ibv_flow_spec *) p)->hdr.size;
+  return (struct ibv_flow_spec *) p;
+}
+
+static void
+rdma_flow_test_ip4 (vnet_flow_t * f, u32 index)
+{
+  clib_memset (f, 0, sizeof (*f));
+  f->type = VNET_FLOW_TYPE_IP4_N_TUPLE;
+  f->index = index;
+  f->ip4_n_tuple.src_addr.addr.as_u32 = clib_host_to_net_u32 (0x0a000001);
+  f->ip4_n_tuple.src_addr.mask.as_u32 = clib_host_to_net_u32 (0xffffff00);
+  f->ip4_n_tuple.dst_port.port = 53;
+  f->ip4_n_tuple.dst_port.mask = 0xffff;
+  f->ip4_n_tuple.protocol = IP_PROTOCOL_UDP;
+}
+
+static clib_error_t *
+rdma_flow_test_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  rdma_flow_mock_t *mock = &rdma_flow_mock;
+  struct ibv_flow_attr *attr = &mock->last_attr.attr;
+  struct ibv_qp *rx_qp, *queue_qp;
+  struct ibv_flow_spec *spec;
+  rdma_queue_group_t *qg;
+  rdma_device_t *rd;
+  vnet_flow_t f;
+  uword flow[5];
+  u32 n_fails = 0;
+  int rv;
+
+  clib_memset (mock, 0, sizeof (*mock));
+  rd = clib_mem_alloc_aligned (sizeof (*rd), CLIB_CACHE_LINE_BYTES);
+  clib_memset (rd, 0, sizeof (*rd));
+  rd->name = format (0, "rdma-test");
+  vec_validate_aligned (rd->rxqs, 3, CLIB_CACHE_LINE_BYTES);
+  rx_qp = rd->rx_qp = uword_to_pointer (~0, struct ibv_qp *);
+  rd->flow_backend = &rdma_flow_backend_mock;
+
+  /* 5-tuple, default queues */
+  rdma_flow_test_ip4 (&f, 0);
+  rv = rdma_flow_add (vm, rd, &f, &flow[0]);
+  RDMA_FLOW_TEST (rv == 0, "ip4 flow: %U", format_flow_error, rv);
+  RDMA_FLOW_TEST (mock->last_qp == rx_qp, "ip4 flow on the device qp");
+  RDMA_FLOW_TEST (attr->num_of_specs == 3 && attr->priority == 0,
+		  "ip4 flow attr");
+  spec = rdma_flow_test_spec (0);
+  RDMA_FLOW_TEST (spec->hdr.type == IBV_FLOW_SPEC_ETH, "eth spec");
+  spec = rdma_flow_test_spec (1);
+  RDMA_FLOW_TEST (spec->hdr.type == IBV_FLOW_SPEC_IPV4 &&
+		  spec->ipv4.val.src_ip == clib_host_to_net_u32 (0x0a000000)
+		  && spec->ipv4.mask.src_ip ==
+		  clib_host_to_net_u32 (0xffffff00) &&
+		  spec->ipv4.mask.dst_ip == 0, "ipv4 spec");
+  spec = rdma_flow_test_spec (2);
+  RDMA_FLOW_TEST (spec->hdr.type == IBV_FLOW_SPEC_UDP &&
+		  spec->tcp_udp.val.dst_port == clib_host_to_net_u16 (53) &&
+		  spec->tcp_udp.mask.src_port == 0, "udp spec");
+
+  /* vxlan to a queue */
+  clib_memset (&f, 0, sizeof (f));
+  f.type = VNET_FLOW_TYPE_IP4_VXLAN;
+  f.index = 1;
+  f.ip4_vxlan.dst_addr.as_u32 = clib_host_to_net_u32 (0x0a000002);
+  f.ip4_vxlan.dst_port = 4789;
+  f.ip4_vxlan.vni = 100;
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 2;
+  rv = rdma_flow_add (vm, rd, &f, &flow[1]);
+  RDMA_FLOW_TEST (rv == 0, "vxlan flow: %U", format_flow_error, rv);
+  RDMA_FLOW_TEST (attr->num_of_specs == 4, "vxlan specs: %u",
+		  attr->num_of_specs);
+  spec = rdma_flow_test_spec (3);
+  RDMA_FLOW_TEST (spec->hdr.type == IBV_FLOW_SPEC_VXLAN_TUNNEL &&
+		  spec->tunnel.val.tunnel_id == clib_host_to_net_u32 (100) &&
+		  spec->tunnel.mask.tunnel_id ==
+		  clib_host_to_net_u32 (0xffffff), "vxlan spec");
+  RDMA_FLOW_TEST (pool_elts (rd->queue_groups) == 1, "one queue group");
+  qg = pool_elt_at_index (rd->queue_groups, 0);
+  RDMA_FLOW_TEST (qg->queue_index == 2 && qg->queue_num == 1 &&
+		  qg->refcnt == 1, "queue group 2/1");
+  queue_qp = qg->qp;
+  RDMA_FLOW_TEST (mock->last_qp == queue_qp, "vxlan flow on the queue qp");
+
+  /* same queue, shared group */
+  rdma_flow_test_ip4 (&f, 2);
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 2;
+  rv = rdma_flow_add (vm, rd, &f, &flow[2]);
+  RDMA_FLOW_TEST (rv == 0 && mock->last_qp == queue_qp &&
+		  qg->refcnt == 2 && mock->n_queue_groups == 1,
+		  "queue group shared");
+
+  /* ip6 drop */
+  clib_memset (&f, 0, sizeof (f));
+  f.type = VNET_FLOW_TYPE_IP6_N_TUPLE;
+  f.index = 3;
+  f.ip6_n_tuple.src_port.port = 179;
+  f.ip6_n_tuple.src_port.mask = 0xffff;
+  f.ip6_n_tuple.protocol = IP_PROTOCOL_TCP;
+  f.actions = VNET_FLOW_ACTION_DROP;
+  rv = rdma_flow_add (vm, rd, &f, &flow[3]);
+  RDMA_FLOW_TEST (rv == 0, "ip6 drop: %U", format_flow_error, rv);
+  RDMA_FLOW_TEST (rdma_flow_test_spec (1)->hdr.type == IBV_FLOW_SPEC_IPV6 &&
+		  rdma_flow_test_spec (2)->hdr.type == IBV_FLOW_SPEC_TCP &&
+		  rdma_flow_test_spec (3)->hdr.type ==
+		  IBV_FLOW_SPEC_ACTION_DROP, "ip6 drop specs");
+  RDMA_FLOW_TEST (mock->last_qp == rx_qp, "drop flow on the device qp");
+
+  /* rss over a queue group */
+  rdma_flow_test_ip4 (&f, 4);
+  f.actions = VNET_FLOW_ACTION_RSS;
+  f.queue_index = 0;
+  f.queue_num = 4;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == 0 && mock->n_queue_groups == 2 &&
+		  mock->last_qp != queue_qp && mock->last_qp != rx_qp,
+		  "rss queue group: %U", format_flow_error, rv);
+
+  /* not supported */
+  f.queue_num = 3;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "queue group size");
+  f.queue_index = 2;
+  f.queue_num = 4;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "queue group range");
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 4;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "invalid queue");
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE | VNET_FLOW_ACTION_DROP;
+  f.redirect_queue = 0;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "two fates");
+  f.actions = VNET_FLOW_ACTION_MARK;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "mark");
+  f.actions = 0;
+  f.ip4_n_tuple.protocol = IP_PROTOCOL_ICMP;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_NOT_SUPPORTED, "icmp");
+  RDMA_FLOW_TEST (mock->n_flows == 5 && mock->n_queue_groups == 2 &&
+		  pool_elts (rd->flow_entries) == 5, "nothing leaked");
+
+  /* flow creation failure releases the queue group */
+  mock->fail = 1;
+  rdma_flow_test_ip4 (&f, 5);
+  f.actions = VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
+  f.redirect_queue = 3;
+  rv = rdma_flow_add (vm, rd, &f, &flow[4]);
+  RDMA_FLOW_TEST (rv == VNET_FLOW_ERROR_INTERNAL, "flow creation failure");
+  RDMA_FLOW_TEST (mock->n_queue_groups == 2 &&
+		  pool_elts (rd->queue_groups) == 2, "queue group released");
+  mock->fail = 0;
+
+  /* delete */
+  rv = rdma_flow_del (vm, rd, flow[1]);
+  RDMA_FLOW_TEST (rv == 0 && qg->refcnt == 1 && mock->n_queue_groups == 2,
+		  "delete first queue flow");
+  rv = rdma_flow_del (vm, rd, flow[2]);
+  RDMA_FLOW_TEST (rv == 0 && mock->n_queue_groups == 1,
+		  "delete last queue flow");
+  rdma_flow_del (vm, rd, flow[0]);
+  rdma_flow_del (vm, rd, flow[3]);
+  rdma_flow_del (vm, rd, flow[4]);
+  RDMA_FLOW_TEST (mock->n_flows == 0 && mock->n_queue_groups == 0 &&
+		  pool_elts (rd->flow_entries) == 0 &&
+		  pool_elts (rd->queue_groups) == 0, "all flows deleted");
+
+  pool_free (rd->flow_entries);
+  pool_free (rd->queue_groups);
+  vec_free (rd->rxqs);
+  vec_free (rd->name);
+  clib_mem_free (rd);
+
+  if (n_fails)
+    return clib_error_return (0, "%u rdma flow test(s) failed", n_fails);
+
+  vlib_cli_output (vm, "rdma flow tests passed");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rdma_flow_test_command, static) = {
+  .path = "test rdma flow",
+  .short_help = "test rdma flow",
+  .function = rdma_flow_test_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
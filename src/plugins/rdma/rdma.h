@@ -23,6 +23,7 @@
 #include <vlib/pci/pci.h>
 #include <vnet/interface.h>
 #include <vnet/ethernet/mac_address.h>
+#include <vnet/flow/flow.h>
 
 #define foreach_rdma_device_flags \
   _(0, ERROR, "error") \
@@ -60,7 +61,45 @@ typedef struct
   u32 tail;
 } rdma_txq_t;
 
+/* hash QP spreading packets over a contiguous range of rx queues */
 typedef struct
+{
+  struct ibv_rwq_ind_table *ind_tbl;
+  struct ibv_qp *qp;
+  u32 queue_index;
+  u32 queue_num;
+  u32 refcnt;
+} rdma_queue_group_t;
+
+typedef struct
+{
+  u32 flow_index;
+  struct ibv_flow *flow;
+  /* ~0 if the flow steers to the device rx QP */
+  u32 queue_group_index;
+} rdma_flow_entry_t;
+
+/* offloaded flow specs, at most eth, l3, l4, tunnel and one action */
+typedef struct
+{
+  struct ibv_flow_attr attr;
+  u8 specs[256];
+} __attribute__ ((packed)) rdma_flow_attr_t;
+
+struct rdma_device;
+
+typedef struct
+{
+  struct ibv_flow *(*create_flow) (struct rdma_device * rd,
+				   struct ibv_qp * qp, rdma_flow_attr_t * fa);
+  int (*destroy_flow) (struct rdma_device * rd, struct ibv_flow * flow);
+  clib_error_t *(*create_queue_group) (struct rdma_device * rd,
+				       rdma_queue_group_t * qg);
+  void (*destroy_queue_group) (struct rdma_device * rd,
+			       rdma_queue_group_t * qg);
+} rdma_flow_backend_t;
+
+typedef struct rdma_device
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
 
@@ -90,6 +129,11 @@ typedef struct
   struct ibv_flow *flow_ucast;
   struct ibv_flow *flow_mcast;
 
+  /* offloaded flows */
+  rdma_flow_entry_t *flow_entries;
+  rdma_queue_group_t *queue_groups;
+  const rdma_flow_backend_t *flow_backend;
+
   clib_error_t *error;
 } rdma_device_t;
 
@@ -127,12 +171,20 @@ typedef struct
 void rdma_create_if (vlib_main_t * vm, rdma_create_if_args_t * args);
 void rdma_delete_if (vlib_main_t * vm, rdma_device_t * rd);
 
+int rdma_flow_add (vlib_main_t * vm, rdma_device_t * rd, vnet_flow_t * f,
+		   uword * private_data);
+int rdma_flow_del (vlib_main_t * vm, rdma_device_t * rd, uword private_data);
+vnet_flow_dev_ops_function_t rdma_flow_ops_fn;
+
+extern const rdma_flow_backend_t rdma_flow_backend_ibv;
+
 extern vlib_node_registration_t rdma_input_node;
 extern vnet_device_class_t rdma_device_class;
 
 format_function_t format_rdma_device;
 format_function_t format_rdma_device_name;
 format_function_t format_rdma_input_trace;
+format_function_t format_rdma_flow;
 unformat_function_t unformat_rdma_create_if_args;
 
 typedef struct
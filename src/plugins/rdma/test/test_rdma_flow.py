@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestRdmaFlow(VppTestCase):
+    """ RDMA Flow Offload Unit Tests """
+
+    @classmethod
+    def setUpConstants(cls):
+        super(TestRdmaFlow, cls).setUpConstants()
+        # disabled by the framework, these tests need no device
+        i = cls.vpp_cmdline.index("rdma_plugin.so")
+        cls.vpp_cmdline[i + 2] = "enable"
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestRdmaFlow, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestRdmaFlow, cls).tearDownClass()
+
+    def test_rdma_flow(self):
+        """ Flow specs and queue groups """
+        # the plugin is only built when ibverbs is available
+        if "rdma_plugin.so" not in self.vapi.cli("show plugins"):
+            self.skipTest("rdma plugin not loaded")
+
+        error = self.vapi.cli("test rdma flow")
+        if error:
+            self.logger.critical(error)
+        self.assertNotIn("failed", error)
+        self.assertIn("passed", error)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
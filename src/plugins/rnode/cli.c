@@ -0,0 +1,311 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/vnet.h>
+
+#include <rnode/private.h>
+
+static clib_error_t *
+rnode_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  rnode_create_args_t args = { 0 };
+  clib_error_t *error = 0;
+  u32 ring_size = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "socket %s", &args.socket_filename))
+	;
+      else if (unformat (line_input, "ring-size %u", &ring_size))
+	;
+      else if (unformat (line_input, "fail-close"))
+	args.fail_close = 1;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (args.socket_filename)
+    vec_add1 (args.socket_filename, 0);
+
+  if (ring_size)
+    {
+      if (!is_pow2 (ring_size))
+	{
+	  error = clib_error_return (0, "ring size must be a power of 2");
+	  goto done;
+	}
+      args.log2_ring_size = min_log2 (ring_size);
+    }
+
+  rv = rnode_create (vm, &args);
+  switch (rv)
+    {
+    case 0:
+      vlib_cli_output (vm, "rnode%u", args.rnode_index);
+      break;
+    case VNET_API_ERROR_INVALID_ARGUMENT:
+      error = clib_error_return (0, "missing socket filename");
+      break;
+    case VNET_API_ERROR_INVALID_VALUE:
+      error = clib_error_return (0, "ring size must be between %u and %u",
+				 1 << RNODE_MIN_LOG2_RING_SIZE,
+				 1 << RNODE_MAX_LOG2_RING_SIZE);
+      break;
+    case VNET_API_ERROR_ENTRY_ALREADY_EXISTS:
+      error = clib_error_return (0, "socket filename already in use");
+      break;
+    default:
+      error = clib_error_return (0, "rnode_create returned %d", rv);
+    }
+
+done:
+  vec_free (args.socket_filename);
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Create a remote node instance: an external process connecting to
+ * the instance socket receives the packets of the interfaces the instance
+ * is enabled on, and returns them with a per packet verdict. Relative
+ * socket filenames are in the VPP runtime directory. Packets bypass the
+ * instance while no remote is connected, unless '<em>fail-close</em>' is
+ * given.
+ *
+ * @cliexpar
+ * @cliexstart{create rnode socket dpi.sock ring-size 2048}
+ * rnode0
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rnode_create_command, static) = {
+  .path = "create rnode",
+  .short_help = "create rnode socket <filename> [ring-size <size>] "
+    "[fail-close]",
+  .function = rnode_create_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+rnode_delete_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			 vlib_cli_command_t * cmd)
+{
+  u32 rnode_index;
+  int rv;
+
+  if (!unformat (input, "%u", &rnode_index))
+    return clib_error_return (0, "missing instance index");
+
+  rv = rnode_delete (vm, rnode_index);
+  switch (rv)
+    {
+    case 0:
+      return 0;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      return clib_error_return (0, "no such instance");
+    case VNET_API_ERROR_INSTANCE_IN_USE:
+      return clib_error_return (0, "instance enabled on interfaces");
+    default:
+      return clib_error_return (0, "rnode_delete returned %d", rv);
+    }
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rnode_delete_command, static) = {
+  .path = "delete rnode",
+  .short_help = "delete rnode <index>",
+  .function = rnode_delete_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+rnode_add_next_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  clib_error_t *error = 0;
+  u8 *node_name = 0;
+  u32 rnode_index;
+  u16 verdict;
+  int rv;
+
+  if (!unformat (input, "%u %s", &rnode_index, &node_name))
+    return clib_error_return (0, "unknown input `%U'",
+			      format_unformat_error, input);
+
+  vec_add1 (node_name, 0);
+  rv = rnode_add_next (vm, rnode_index, node_name, &verdict);
+  switch (rv)
+    {
+    case 0:
+      vlib_cli_output (vm, "verdict %u", verdict);
+      break;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      error = clib_error_return (0, "no such instance");
+      break;
+    case VNET_API_ERROR_NO_SUCH_NODE:
+      error = clib_error_return (0, "no such graph node `%s'", node_name);
+      break;
+    default:
+      error = clib_error_return (0, "rnode_add_next returned %d", rv);
+    }
+
+  vec_free (node_name);
+  return error;
+}
+
+/*?
+ * Add a graph node the remote can send packets to. The command prints
+ * the verdict value selecting the node, verdicts 0 and 1 drop the packet
+ * and resume the feature arc.
+ *
+ * @cliexpar
+ * @cliexstart{rnode add-next 0 ip4-lookup}
+ * verdict 2
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rnode_add_next_command, static) = {
+  .path = "rnode add-next",
+  .short_help = "rnode add-next <index> <node-name>",
+  .function = rnode_add_next_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+rnode_enable_disable_command_fn (vlib_main_t * vm, unformat_input_t * input,
+				 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, rnode_index = ~0;
+  clib_error_t *error = 0;
+  u8 is_ip6 = 0;
+  int enable = 1;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "ip6"))
+	is_ip6 = 1;
+      else if (unformat (line_input, "ip4"))
+	is_ip6 = 0;
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else if (unformat (line_input, "%u", &rnode_index))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (sw_if_index == ~0 || rnode_index == ~0)
+    {
+      error = clib_error_return (0, "interface and instance index required");
+      goto done;
+    }
+
+  rv = rnode_enable_disable (vm, rnode_index, sw_if_index, is_ip6, enable);
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_NO_SUCH_ENTRY:
+      error = clib_error_return (0, enable ? "no such instance" :
+				 "instance not enabled on the interface");
+      break;
+    case VNET_API_ERROR_ENTRY_ALREADY_EXISTS:
+      error = clib_error_return (0, "an instance is already enabled on "
+				 "the interface");
+      break;
+    default:
+      error = clib_error_return (0, "rnode_enable_disable returned %d", rv);
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Send the IPv4 (default) or IPv6 packets received on an interface to a
+ * remote node instance, before the FIB lookup.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface rnode GigabitEthernet2/0/0 0 ip6}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rnode_enable_disable_command, static) = {
+  .path = "set interface rnode",
+  .short_help = "set interface rnode <interface> <index> [ip4|ip6] "
+    "[disable]",
+  .function = rnode_enable_disable_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+rnode_show_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		       vlib_cli_command_t * cmd)
+{
+  rnode_main_t *rm = &rnode_main;
+  rnode_t *r;
+
+  /* *INDENT-OFF* */
+  pool_foreach (r, rm->instances,
+    ({
+      vlib_cli_output (vm, "%U", format_rnode, r);
+    }));
+  /* *INDENT-ON* */
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (rnode_show_command, static) = {
+  .path = "show rnode",
+  .short_help = "show rnode",
+  .function = rnode_show_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
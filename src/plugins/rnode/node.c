@@ -0,0 +1,397 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <unistd.h>
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+#include <rnode/private.h>
+
+#define foreach_rnode_error					\
+  _(NOT_CONNECTED, "remote not connected (fail-close)")		\
+  _(RING_FULL, "remote ring full")				\
+  _(REMOTE_DROP, "dropped by remote")				\
+  _(BAD_VERDICT, "invalid verdict from remote")
+
+typedef enum
+{
+#define _(f,s) RNODE_ERROR_##f,
+  foreach_rnode_error
+#undef _
+    RNODE_N_ERROR,
+} rnode_error_t;
+
+static char *rnode_error_strings[] = {
+#define _(n,s) s,
+  foreach_rnode_error
+#undef _
+};
+
+typedef enum
+{
+  RNODE_NEXT_DROP,
+  RNODE_N_NEXT,
+} rnode_next_t;
+
+typedef struct
+{
+  u32 rnode_index;
+  u32 next_index;
+  u16 verdict;
+  u16 slot;
+  u8 offloaded;
+} rnode_trace_t;
+
+static u8 *
+format_rnode_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  rnode_trace_t *t = va_arg (*args, rnode_trace_t *);
+
+  s = format (s, "rnode%u: ", t->rnode_index);
+  if (t->offloaded)
+    s = format (s, "to remote, slot %u", t->slot);
+  else
+    s = format (s, "bypass, next-index %u", t->next_index);
+  return s;
+}
+
+static u8 *
+format_rnode_input_trace (u8 * s, va_list * args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  rnode_trace_t *t = va_arg (*args, rnode_trace_t *);
+
+  return format (s, "rnode%u: from remote, slot %u verdict %u next-index %u",
+		 t->rnode_index, t->slot, t->verdict, t->next_index);
+}
+
+/* publish the descriptors posted since the last call and kick the remote,
+   unless it polls the ring */
+static_always_inline void
+rnode_queue_flush (rnode_queue_t * q)
+{
+  rnode_ring_t *ring = q->ring;
+  u64 b = 1;
+
+  if (ring->head == q->head)
+    return;
+
+  q->n_tx_packets += (u16) (q->head - ring->head);
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->head = q->head;
+
+  /* the remote reads head after unmasking */
+  CLIB_MEMORY_BARRIER ();
+  if (ring->flags & RNODE_RING_FLAG_MASK_INT)
+    return;
+
+  CLIB_UNUSED (int r) = write (q->kick_fd, &b, sizeof (b));
+  q->n_kicks++;
+}
+
+static_always_inline uword
+rnode_feature_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+		      vlib_frame_t * frame)
+{
+  rnode_main_t *rm = &rnode_main;
+  u32 thread_index = vm->thread_index;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u32 to_next[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  u32 *from, n_left, n_to_next = 0;
+  u32 last_rnode_index = ~0;
+  rnode_t *r = 0;
+  rnode_queue_t *q = 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left)
+    {
+      vlib_buffer_pool_t *bp;
+      rnode_desc_t *d;
+      u32 *rnode_index, next0;
+      u16 mask, slot = 0;
+      u8 offloaded = 0;
+
+      if (n_left > 2)
+	vlib_prefetch_buffer_header (b[2], LOAD);
+
+      rnode_index = vnet_feature_next_with_data (&next0, b[0],
+						 sizeof (u32));
+
+      if (PREDICT_FALSE (rnode_index[0] != last_rnode_index))
+	{
+	  if (q)
+	    rnode_queue_flush (q);
+	  last_rnode_index = rnode_index[0];
+	  r = pool_elt_at_index (rm->instances, last_rnode_index);
+	  q = 0;
+	  if (r->flags & RNODE_F_CONNECTED)
+	    q = vec_elt_at_index (r->queues, thread_index);
+	}
+
+      if (PREDICT_FALSE (q == 0))
+	{
+	  /* no remote: fail-open unless told otherwise */
+	  if (r->flags & RNODE_F_FAIL_CLOSE)
+	    {
+	      next0 = RNODE_NEXT_DROP;
+	      b[0]->error = node->errors[RNODE_ERROR_NOT_CONNECTED];
+	    }
+	  goto enqueue;
+	}
+
+      mask = pow2_mask (q->log2_ring_size);
+      if (PREDICT_FALSE ((u16) (q->head - q->last_tail) > mask))
+	{
+	  next0 = RNODE_NEXT_DROP;
+	  b[0]->error = node->errors[RNODE_ERROR_RING_FULL];
+	  goto enqueue;
+	}
+
+      /* hand the buffer over, the remote sees its data only */
+      slot = q->head++ & mask;
+      bp = vlib_get_buffer_pool (vm, b[0]->buffer_pool_index);
+      d = q->ring->desc + slot;
+      d->flags = b[0]->flags & VLIB_BUFFER_NEXT_PRESENT ?
+	RNODE_DESC_FLAG_CHAINED : 0;
+      d->region = b[0]->buffer_pool_index + 1;
+      d->next = RNODE_VERDICT_CONTINUE;
+      d->offset = (u8 *) vlib_buffer_get_current (b[0]) - (u8 *) bp->start;
+      d->length = b[0]->current_length;
+      q->buffers[slot] = from[0];
+      q->feature_nexts[slot] = next0;
+      offloaded = 1;
+      goto trace;
+
+    enqueue:
+      to_next[n_to_next] = from[0];
+      nexts[n_to_next] = next0;
+      n_to_next++;
+
+    trace:
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  rnode_trace_t *t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->rnode_index = last_rnode_index;
+	  t->next_index = next0;
+	  t->verdict = 0;
+	  t->slot = slot;
+	  t->offloaded = offloaded;
+	}
+
+      from += 1;
+      b += 1;
+      n_left -= 1;
+    }
+
+  if (q)
+    rnode_queue_flush (q);
+
+  if (n_to_next)
+    vlib_buffer_enqueue_to_next (vm, node, to_next, nexts, n_to_next);
+
+  return frame->n_vectors;
+}
+
+VLIB_NODE_FN (rnode_ip4_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
+			       vlib_frame_t * frame)
+{
+  return rnode_feature_inline (vm, node, frame);
+}
+
+VLIB_NODE_FN (rnode_ip6_node) (vlib_main_t * vm, vlib_node_runtime_t * node,
+			       vlib_frame_t * frame)
+{
+  return rnode_feature_inline (vm, node, frame);
+}
+
+/* dequeue the descriptors returned by the remote, at most n_max */
+static_always_inline u32
+rnode_input_queue (vlib_main_t * vm, vlib_node_runtime_t * node,
+		   rnode_t * r, rnode_queue_t * q, u32 * buffers,
+		   u16 * nexts, u32 n_max, int *more)
+{
+  u16 mask = pow2_mask (q->log2_ring_size);
+  u16 n_in_flight = q->head - q->last_tail;
+  u16 n_ready = q->ring->tail - q->last_tail;
+  u32 i;
+
+  /* never trust the remote further than what was given to it */
+  if (PREDICT_FALSE (n_ready > n_in_flight))
+    n_ready = n_in_flight;
+
+  if (n_ready > n_max)
+    {
+      n_ready = n_max;
+      *more = 1;
+    }
+
+  if (n_ready == 0)
+    return 0;
+
+  /* read the verdicts after the tail */
+  CLIB_MEMORY_BARRIER ();
+
+  for (i = 0; i < n_ready; i++)
+    {
+      u16 slot = (q->last_tail + i) & mask;
+      u16 verdict = q->ring->desc[slot].next;
+      vlib_buffer_t *b0;
+      u32 next0;
+
+      buffers[i] = q->buffers[slot];
+
+      if (PREDICT_TRUE (verdict == RNODE_VERDICT_CONTINUE))
+	next0 = q->feature_nexts[slot];
+      else if (verdict >= RNODE_VERDICT_FIRST_NEXT &&
+	       verdict - RNODE_VERDICT_FIRST_NEXT < vec_len (r->nexts))
+	next0 = r->nexts[verdict - RNODE_VERDICT_FIRST_NEXT];
+      else
+	{
+	  b0 = vlib_get_buffer (vm, buffers[i]);
+	  next0 = RNODE_NEXT_DROP;
+	  if (verdict == RNODE_VERDICT_DROP)
+	    b0->error = node->errors[RNODE_ERROR_REMOTE_DROP];
+	  else
+	    b0->error = node->errors[RNODE_ERROR_BAD_VERDICT];
+	}
+      nexts[i] = next0;
+
+      b0 = vlib_get_buffer (vm, buffers[i]);
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  rnode_trace_t *t = vlib_add_trace (vm, node, b0, sizeof (*t));
+	  t->rnode_index = r->index;
+	  t->next_index = next0;
+	  t->verdict = verdict;
+	  t->slot = slot;
+	  t->offloaded = 0;
+	}
+    }
+
+  q->last_tail += n_ready;
+  q->n_rx_packets += n_ready;
+  return n_ready;
+}
+
+VLIB_NODE_FN (rnode_input_node) (vlib_main_t * vm,
+				 vlib_node_runtime_t * node,
+				 vlib_frame_t * frame)
+{
+  rnode_main_t *rm = &rnode_main;
+  u32 thread_index = vm->thread_index;
+  u32 buffers[VLIB_FRAME_SIZE];
+  u16 nexts[VLIB_FRAME_SIZE];
+  u32 n_rx = 0;
+  int more = 0;
+  rnode_t *r;
+
+  /* *INDENT-OFF* */
+  pool_foreach (r, rm->instances,
+    ({
+      rnode_queue_t *q;
+
+      if ((r->flags & RNODE_F_CONNECTED) == 0)
+	continue;
+
+      if (n_rx == VLIB_FRAME_SIZE)
+	{
+	  more = 1;
+	  break;
+	}
+
+      q = vec_elt_at_index (r->queues, thread_index);
+      n_rx += rnode_input_queue (vm, node, r, q, buffers + n_rx,
+				 nexts + n_rx, VLIB_FRAME_SIZE - n_rx, &more);
+    }));
+  /* *INDENT-ON* */
+
+  if (n_rx)
+    vlib_buffer_enqueue_to_next (vm, node, buffers, nexts, n_rx);
+
+  /* the remote kicks once per batch, come back for the rest */
+  if (more)
+    vlib_node_set_interrupt_pending (vm, node->node_index);
+
+  return n_rx;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (rnode_ip4_node) = {
+  .name = "rnode-ip4",
+  .vector_size = sizeof (u32),
+  .format_trace = format_rnode_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = RNODE_N_ERROR,
+  .error_strings = rnode_error_strings,
+  .n_next_nodes = RNODE_N_NEXT,
+  .next_nodes = {
+    [RNODE_NEXT_DROP] = "error-drop",
+  },
+};
+
+/* the feature nodes and rnode-input are siblings: a continue verdict
+   resumes the feature arc with the next index computed by the feature
+   node, and nexts added to rnode-input are valid for all of them */
+VLIB_REGISTER_NODE (rnode_ip6_node) = {
+  .name = "rnode-ip6",
+  .vector_size = sizeof (u32),
+  .format_trace = format_rnode_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = RNODE_N_ERROR,
+  .error_strings = rnode_error_strings,
+  .sibling_of = "rnode-ip4",
+};
+
+VLIB_REGISTER_NODE (rnode_input_node) = {
+  .name = "rnode-input",
+  .format_trace = format_rnode_input_trace,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .n_errors = RNODE_N_ERROR,
+  .error_strings = rnode_error_strings,
+  .sibling_of = "rnode-ip4",
+};
+
+VNET_FEATURE_INIT (rnode_ip4_feat, static) = {
+  .arc_name = "ip4-unicast",
+  .node_name = "rnode-ip4",
+  .runs_before = VNET_FEATURES ("ip4-lookup"),
+};
+
+VNET_FEATURE_INIT (rnode_ip6_feat, static) = {
+  .arc_name = "ip6-unicast",
+  .node_name = "rnode-ip6",
+  .runs_before = VNET_FEATURES ("ip6-lookup"),
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
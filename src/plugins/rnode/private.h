@@ -0,0 +1,138 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _RNODE_PRIVATE_H_
+#define _RNODE_PRIVATE_H_
+
+#include <vppinfra/socket.h>
+#include <rnode/rnode.h>
+
+#define RNODE_DEFAULT_LOG2_RING_SIZE	10
+#define RNODE_MIN_LOG2_RING_SIZE	4
+/* head and tail are free running u16 */
+#define RNODE_MAX_LOG2_RING_SIZE	14
+
+#define rnode_log_debug(r, f, ...)					\
+  vlib_log (VLIB_LOG_LEVEL_DEBUG, rnode_main.log_class, "rnode%u: " f,	\
+	    (r)->index, ##__VA_ARGS__)
+
+#define rnode_log_err(r, f, ...)					\
+  vlib_log (VLIB_LOG_LEVEL_ERR, rnode_main.log_class, "rnode%u: " f,	\
+	    (r)->index, ##__VA_ARGS__)
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  rnode_ring_t *ring;
+  u8 log2_ring_size;
+  /* private copy of the ring head, published once per frame */
+  u16 head;
+  /* first slot not yet returned to the graph */
+  u16 last_tail;
+  /* in-flight buffer indices and feature arc nexts, by ring slot: the
+     remote only ever sees buffer data, never buffer indices */
+  u32 *buffers;
+  u16 *feature_nexts;
+  int kick_fd;
+  int int_fd;
+  u32 int_clib_file_index;
+
+  /* counters */
+  u64 n_kicks;
+  u64 n_interrupts;
+  u64 n_tx_packets;
+  u64 n_rx_packets;
+} rnode_queue_t;
+
+typedef enum
+{
+  RNODE_F_CONNECTED = (1 << 0),
+  RNODE_F_FAIL_CLOSE = (1 << 1),
+} rnode_flags_t;
+
+typedef struct
+{
+  u32 index;
+  u32 flags;
+  u8 *socket_filename;
+  u8 log2_ring_size;
+
+  /* listener, and the connected remote */
+  clib_socket_t *sock;
+  clib_socket_t *client;
+
+  /* rnode-input next indices of verdicts RNODE_VERDICT_FIRST_NEXT+ */
+  u32 *nexts;
+
+  /* ring region, rings are allocated on connection */
+  void *ring_shm;
+  uword ring_shm_size;
+  int ring_fd;
+
+  /* one queue per thread */
+  rnode_queue_t *queues;
+
+  /* number of interfaces the instance is enabled on */
+  u32 n_interfaces;
+} rnode_t;
+
+typedef struct
+{
+  rnode_t *instances;
+
+  /* instance enabled on an interface, per address family */
+  u32 *instance_by_sw_if_index[2];
+
+  vlib_log_class_t log_class;
+
+  /* API message ID base */
+  u16 msg_id_base;
+} rnode_main_t;
+
+extern rnode_main_t rnode_main;
+extern vlib_node_registration_t rnode_ip4_node;
+extern vlib_node_registration_t rnode_ip6_node;
+extern vlib_node_registration_t rnode_input_node;
+
+typedef struct
+{
+  u8 *socket_filename;
+  u8 log2_ring_size;
+  u8 fail_close;
+
+  /* return */
+  u32 rnode_index;
+} rnode_create_args_t;
+
+int rnode_create (vlib_main_t * vm, rnode_create_args_t * args);
+int rnode_delete (vlib_main_t * vm, u32 rnode_index);
+int rnode_add_next (vlib_main_t * vm, u32 rnode_index, u8 * node_name,
+		    u16 * verdict);
+int rnode_enable_disable (vlib_main_t * vm, u32 rnode_index,
+			  u32 sw_if_index, u8 is_ip6, int enable);
+
+format_function_t format_rnode;
+
+#endif /* _RNODE_PRIVATE_H_ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,535 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vppinfra/file.h>
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+#include <vnet/plugin/plugin.h>
+#include <vpp/app/version.h>
+
+#include <rnode/private.h>
+
+rnode_main_t rnode_main;
+
+static uword
+rnode_ring_size (rnode_t * r)
+{
+  return round_pow2 (sizeof (rnode_ring_t) +
+		     sizeof (rnode_desc_t) * (1 << r->log2_ring_size),
+		     CLIB_CACHE_LINE_BYTES);
+}
+
+static clib_error_t *
+rnode_send_msg (rnode_t * r, rnode_msg_t * msg, int fds[], int n_fds)
+{
+  msg->version = RNODE_VERSION;
+  return clib_socket_sendmsg (r->client, msg, sizeof (rnode_msg_t), fds,
+			      n_fds);
+}
+
+static void
+rnode_disconnect (rnode_t * r)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  rnode_queue_t *q;
+  u32 *to_free = 0;
+
+  /* workers must not touch the rings while they go away */
+  vlib_worker_thread_barrier_sync (vm);
+
+  r->flags &= ~RNODE_F_CONNECTED;
+
+  vec_foreach (q, r->queues)
+  {
+    if (q->ring)
+      {
+	u16 mask = pow2_mask (q->log2_ring_size);
+
+	/* the remote is gone with the packets it did not return */
+	while (q->last_tail != q->head)
+	  vec_add1 (to_free, q->buffers[q->last_tail++ & mask]);
+	q->ring = 0;
+      }
+    if (q->int_clib_file_index != ~0)
+      {
+	clib_file_del_by_index (&file_main, q->int_clib_file_index);
+	q->int_clib_file_index = ~0;
+	q->int_fd = -1;
+      }
+    if (q->int_fd > -1)
+      close (q->int_fd);
+    if (q->kick_fd > -1)
+      close (q->kick_fd);
+    q->int_fd = q->kick_fd = -1;
+  }
+
+  vlib_worker_thread_barrier_release (vm);
+
+  if (vec_len (to_free))
+    vlib_buffer_free (vm, to_free, vec_len (to_free));
+  vec_free (to_free);
+
+  if (r->ring_shm)
+    {
+      if (munmap (r->ring_shm, r->ring_shm_size))
+	rnode_log_err (r, "munmap failed");
+      r->ring_shm = 0;
+    }
+  if (r->ring_fd > -1)
+    close (r->ring_fd);
+  r->ring_fd = -1;
+
+  if (r->client)
+    {
+      /* closes the socket */
+      clib_file_del_by_index (&file_main, r->client->private_data);
+      clib_mem_free (r->client);
+      r->client = 0;
+      rnode_log_debug (r, "remote disconnected");
+    }
+}
+
+static clib_error_t *
+rnode_int_fd_read_ready (clib_file_t * uf)
+{
+  rnode_main_t *rm = &rnode_main;
+  u16 thread_index = uf->private_data & 0xFFFF;
+  rnode_t *r = pool_elt_at_index (rm->instances, uf->private_data >> 16);
+  rnode_queue_t *q = vec_elt_at_index (r->queues, thread_index);
+  u64 b;
+
+  if (read (uf->file_descriptor, &b, sizeof (b)) < 0)
+    return 0;
+
+  vlib_node_set_interrupt_pending (vlib_mains[thread_index],
+				   rnode_input_node.index);
+  q->n_interrupts++;
+  return 0;
+}
+
+static clib_error_t *
+rnode_conn_read_ready (clib_file_t * uf)
+{
+  rnode_main_t *rm = &rnode_main;
+  rnode_t *r = pool_elt_at_index (rm->instances, uf->private_data);
+  u8 buf[sizeof (rnode_msg_t)];
+
+  /* the remote has nothing to say, only the connection state matters */
+  if (recv (uf->file_descriptor, buf, sizeof (buf), MSG_DONTWAIT) <= 0)
+    rnode_disconnect (r);
+  return 0;
+}
+
+static clib_error_t *
+rnode_conn_error (clib_file_t * uf)
+{
+  rnode_main_t *rm = &rnode_main;
+  rnode_t *r = pool_elt_at_index (rm->instances, uf->private_data);
+
+  rnode_disconnect (r);
+  return 0;
+}
+
+static clib_error_t *
+rnode_connect (rnode_t * r)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp;
+  clib_mem_vm_alloc_t alloc = { 0 };
+  clib_file_t template = { 0 };
+  rnode_msg_t msg;
+  rnode_queue_t *q;
+  uword ring_size = rnode_ring_size (r);
+  clib_error_t *err;
+
+  alloc.name = "rnode rings";
+  alloc.size = ring_size * vec_len (r->queues);
+  alloc.flags = CLIB_MEM_VM_F_SHARED;
+
+  if ((err = clib_mem_vm_ext_alloc (&alloc)))
+    return err;
+
+  r->ring_fd = alloc.fd;
+  r->ring_shm = alloc.addr;
+  r->ring_shm_size = alloc.size;
+
+  vec_foreach (q, r->queues)
+  {
+    q->ring = r->ring_shm + ring_size * (q - r->queues);
+    q->ring->cookie = RNODE_COOKIE;
+    q->ring->flags = 0;
+    q->ring->head = q->ring->tail = 0;
+    q->head = q->last_tail = 0;
+    q->kick_fd = eventfd (0, EFD_NONBLOCK);
+    q->int_fd = eventfd (0, EFD_NONBLOCK);
+    if (q->kick_fd < 0 || q->int_fd < 0)
+      return clib_error_return_unix (0, "eventfd");
+  }
+
+  template.read_function = rnode_conn_read_ready;
+  template.error_function = rnode_conn_error;
+  template.file_descriptor = r->client->fd;
+  template.private_data = r->index;
+  template.description = format (0, "rnode%u remote", r->index);
+  r->client->private_data = clib_file_add (&file_main, &template);
+
+  clib_memset (&msg, 0, sizeof (msg));
+  msg.type = RNODE_MSG_TYPE_ADD_REGION;
+  msg.size = r->ring_shm_size;
+  if ((err = rnode_send_msg (r, &msg, &r->ring_fd, 1)))
+    return err;
+
+  /* *INDENT-OFF* */
+  vec_foreach (bp, vm->buffer_main->buffer_pools)
+    {
+      vlib_physmem_map_t *pm;
+
+      pm = vlib_physmem_get_map (vm, bp->physmem_map_index);
+      msg.index = bp->index + 1;
+      msg.size = (u64) pm->n_pages << pm->log2_page_size;
+      if ((err = rnode_send_msg (r, &msg, &pm->fd, 1)))
+	return err;
+    }
+  /* *INDENT-ON* */
+
+  clib_memset (&msg, 0, sizeof (msg));
+  msg.type = RNODE_MSG_TYPE_ADD_RING;
+  msg.log2_ring_size = r->log2_ring_size;
+  template.read_function = rnode_int_fd_read_ready;
+  template.error_function = 0;
+  vec_foreach (q, r->queues)
+  {
+    int fds[2] = { q->kick_fd, q->int_fd };
+    u16 thread_index = q - r->queues;
+
+    msg.index = thread_index;
+    msg.offset = (u8 *) q->ring - (u8 *) r->ring_shm;
+    if ((err = rnode_send_msg (r, &msg, fds, 2)))
+      return err;
+
+    template.file_descriptor = q->int_fd;
+    template.private_data = (r->index << 16) | thread_index;
+    template.description = format (0, "rnode%u ring %u interrupt",
+				   r->index, thread_index);
+    q->int_clib_file_index = clib_file_add (&file_main, &template);
+  }
+
+  clib_memset (&msg, 0, sizeof (msg));
+  msg.type = RNODE_MSG_TYPE_CONNECTED;
+  msg.index = vec_len (r->queues);
+  if ((err = rnode_send_msg (r, &msg, 0, 0)))
+    return err;
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  r->flags |= RNODE_F_CONNECTED;
+  rnode_log_debug (r, "remote connected");
+  return 0;
+}
+
+static clib_error_t *
+rnode_conn_accept_ready (clib_file_t * uf)
+{
+  rnode_main_t *rm = &rnode_main;
+  rnode_t *r = pool_elt_at_index (rm->instances, uf->private_data);
+  clib_socket_t *client;
+  clib_error_t *err;
+
+  client = clib_mem_alloc (sizeof (clib_socket_t));
+  clib_memset (client, 0, sizeof (clib_socket_t));
+  if ((err = clib_socket_accept (r->sock, client)))
+    {
+      clib_mem_free (client);
+      return err;
+    }
+
+  if (r->client)
+    {
+      rnode_log_err (r, "remote already connected, connection refused");
+      err = clib_socket_close (client);
+      clib_error_free (err);
+      clib_mem_free (client);
+      return 0;
+    }
+
+  r->client = client;
+  client->private_data = ~0;
+  if ((err = rnode_connect (r)))
+    {
+      rnode_log_err (r, "%U", format_clib_error, err);
+      clib_error_free (err);
+      if (client->private_data == ~0)
+	{
+	  /* not registered with the file main yet */
+	  err = clib_socket_close (client);
+	  clib_error_free (err);
+	  clib_mem_free (client);
+	  r->client = 0;
+	}
+      rnode_disconnect (r);
+    }
+  return 0;
+}
+
+int
+rnode_create (vlib_main_t * vm, rnode_create_args_t * args)
+{
+  rnode_main_t *rm = &rnode_main;
+  clib_file_t template = { 0 };
+  rnode_queue_t *q;
+  u8 *filename;
+  rnode_t *r;
+  clib_error_t *err;
+
+  if (args->socket_filename == 0 || args->socket_filename[0] == 0)
+    return VNET_API_ERROR_INVALID_ARGUMENT;
+
+  if (args->log2_ring_size == 0)
+    args->log2_ring_size = RNODE_DEFAULT_LOG2_RING_SIZE;
+  if (args->log2_ring_size < RNODE_MIN_LOG2_RING_SIZE ||
+      args->log2_ring_size > RNODE_MAX_LOG2_RING_SIZE)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (args->socket_filename[0] != '/')
+    filename = format (0, "%s/%s%c", vlib_unix_get_runtime_dir (),
+		       args->socket_filename, 0);
+  else
+    filename = format (0, "%s%c", args->socket_filename, 0);
+
+  /* *INDENT-OFF* */
+  pool_foreach (r, rm->instances,
+    ({
+      if (strcmp ((char *) r->socket_filename, (char *) filename) == 0)
+	{
+	  vec_free (filename);
+	  return VNET_API_ERROR_ENTRY_ALREADY_EXISTS;
+	}
+    }));
+  /* *INDENT-ON* */
+
+  pool_get_zero (rm->instances, r);
+  r->index = r - rm->instances;
+  r->socket_filename = filename;
+  r->log2_ring_size = args->log2_ring_size;
+  r->ring_fd = -1;
+  if (args->fail_close)
+    r->flags |= RNODE_F_FAIL_CLOSE;
+
+  vec_validate_aligned (r->queues, vec_len (vlib_mains) - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (q, r->queues)
+  {
+    q->log2_ring_size = r->log2_ring_size;
+    q->kick_fd = q->int_fd = -1;
+    q->int_clib_file_index = ~0;
+    vec_validate_aligned (q->buffers, pow2_mask (r->log2_ring_size),
+			  CLIB_CACHE_LINE_BYTES);
+    vec_validate_aligned (q->feature_nexts, pow2_mask (r->log2_ring_size),
+			  CLIB_CACHE_LINE_BYTES);
+  }
+
+  r->sock = clib_mem_alloc (sizeof (clib_socket_t));
+  clib_memset (r->sock, 0, sizeof (clib_socket_t));
+  r->sock->config = (char *) r->socket_filename;
+  r->sock->flags = CLIB_SOCKET_F_IS_SERVER |
+    CLIB_SOCKET_F_ALLOW_GROUP_WRITE | CLIB_SOCKET_F_SEQPACKET;
+
+  if ((err = clib_socket_init (r->sock)))
+    {
+      rnode_log_err (r, "%U", format_clib_error, err);
+      clib_error_free (err);
+      clib_mem_free (r->sock);
+      r->sock = 0;
+      rnode_delete (vm, r->index);
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
+    }
+
+  template.read_function = rnode_conn_accept_ready;
+  template.file_descriptor = r->sock->fd;
+  template.private_data = r->index;
+  template.description = format (0, "rnode%u listener %s", r->index,
+				 r->socket_filename);
+  r->sock->private_data = clib_file_add (&file_main, &template);
+
+  args->rnode_index = r->index;
+  return 0;
+}
+
+int
+rnode_delete (vlib_main_t * vm, u32 rnode_index)
+{
+  rnode_main_t *rm = &rnode_main;
+  rnode_queue_t *q;
+  rnode_t *r;
+
+  if (pool_is_free_index (rm->instances, rnode_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  r = pool_elt_at_index (rm->instances, rnode_index);
+  if (r->n_interfaces)
+    return VNET_API_ERROR_INSTANCE_IN_USE;
+
+  rnode_disconnect (r);
+
+  if (r->sock)
+    {
+      clib_file_del_by_index (&file_main, r->sock->private_data);
+      clib_mem_free (r->sock);
+      unlink ((char *) r->socket_filename);
+    }
+
+  vec_foreach (q, r->queues)
+  {
+    vec_free (q->buffers);
+    vec_free (q->feature_nexts);
+  }
+  vec_free (r->queues);
+  vec_free (r->nexts);
+  vec_free (r->socket_filename);
+  pool_put (rm->instances, r);
+  return 0;
+}
+
+int
+rnode_add_next (vlib_main_t * vm, u32 rnode_index, u8 * node_name,
+		u16 * verdict)
+{
+  rnode_main_t *rm = &rnode_main;
+  vlib_node_t *n;
+  rnode_t *r;
+
+  if (pool_is_free_index (rm->instances, rnode_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  r = pool_elt_at_index (rm->instances, rnode_index);
+  if (vec_len (r->nexts) + RNODE_VERDICT_FIRST_NEXT > 0xFFFF)
+    return VNET_API_ERROR_TABLE_TOO_BIG;
+
+  n = vlib_get_node_by_name (vm, node_name);
+  if (n == 0)
+    return VNET_API_ERROR_NO_SUCH_NODE;
+
+  /* rnode-input and the feature nodes are siblings, all share the next */
+  vec_add1 (r->nexts, vlib_node_add_next (vm, rnode_input_node.index,
+					   n->index));
+  *verdict = RNODE_VERDICT_FIRST_NEXT + vec_len (r->nexts) - 1;
+  return 0;
+}
+
+int
+rnode_enable_disable (vlib_main_t * vm, u32 rnode_index, u32 sw_if_index,
+		      u8 is_ip6, int enable)
+{
+  rnode_main_t *rm = &rnode_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 **by_sw_if_index = &rm->instance_by_sw_if_index[is_ip6 != 0];
+  rnode_t *r;
+
+  if (pool_is_free_index (rm->instances, rnode_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  if (!vnet_sw_interface_is_valid (vnm, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  r = pool_elt_at_index (rm->instances, rnode_index);
+  vec_validate_init_empty (*by_sw_if_index, sw_if_index, ~0);
+
+  if (enable)
+    {
+      if (by_sw_if_index[0][sw_if_index] != ~0)
+	return VNET_API_ERROR_ENTRY_ALREADY_EXISTS;
+      by_sw_if_index[0][sw_if_index] = rnode_index;
+      r->n_interfaces++;
+    }
+  else
+    {
+      if (by_sw_if_index[0][sw_if_index] != rnode_index)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+      by_sw_if_index[0][sw_if_index] = ~0;
+      r->n_interfaces--;
+    }
+
+  if (is_ip6)
+    vnet_feature_enable_disable ("ip6-unicast", "rnode-ip6", sw_if_index,
+				 enable, &rnode_index, sizeof (rnode_index));
+  else
+    vnet_feature_enable_disable ("ip4-unicast", "rnode-ip4", sw_if_index,
+				 enable, &rnode_index, sizeof (rnode_index));
+  return 0;
+}
+
+u8 *
+format_rnode (u8 * s, va_list * args)
+{
+  rnode_t *r = va_arg (*args, rnode_t *);
+  u32 indent = format_get_indent (s);
+  rnode_queue_t *q;
+  u32 i;
+
+  s = format (s, "rnode%u: socket %s ring-size %u %s %s", r->index,
+	      r->socket_filename, 1 << r->log2_ring_size,
+	      r->flags & RNODE_F_FAIL_CLOSE ? "fail-close" : "fail-open",
+	      r->flags & RNODE_F_CONNECTED ? "connected" : "not-connected");
+
+  for (i = 0; i < vec_len (r->nexts); i++)
+    s = format (s, "\n%Uverdict %u: %U", format_white_space, indent + 2,
+		RNODE_VERDICT_FIRST_NEXT + i, format_vlib_next_node_name,
+		vlib_get_main (), rnode_input_node.index, r->nexts[i]);
+
+  vec_foreach (q, r->queues)
+  {
+    s = format (s, "\n%Uthread %u: in-flight %u sent %lu returned %lu "
+		"kicks %lu interrupts %lu", format_white_space, indent + 2,
+		q - r->queues, (u16) (q->head - q->last_tail),
+		q->n_tx_packets, q->n_rx_packets, q->n_kicks,
+		q->n_interrupts);
+  }
+  return s;
+}
+
+static clib_error_t *
+rnode_init (vlib_main_t * vm)
+{
+  rnode_main_t *rm = &rnode_main;
+
+  rm->log_class = vlib_log_register_class ("rnode", 0);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (rnode_init);
+
+/* *INDENT-OFF* */
+VLIB_PLUGIN_REGISTER () = {
+  .version = VPP_BUILD_VER,
+  .description = "Remote graph node over shared memory rings",
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
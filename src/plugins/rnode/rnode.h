@@ -0,0 +1,124 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Remote node protocol
+ *
+ * VPP listens on a unix SEQPACKET socket per remote node instance and
+ * accepts a single remote process at a time. On connection VPP sends:
+ *
+ *  - one ADD_REGION message per shared memory region, carrying the region
+ *    fd: region 0 holds the rings, region N > 0 is the memory of vlib
+ *    buffer pool N - 1, packets are never copied
+ *  - one ADD_RING message per VPP thread, carrying two eventfds: VPP kicks
+ *    the first one when it posts descriptors (unless the remote masked it),
+ *    the remote must kick the second one after it advanced the ring tail
+ *  - a CONNECTED message
+ *
+ * VPP posts descriptors at the ring head. The remote processes them in
+ * order, writes its verdict in the descriptor next field and advances the
+ * ring tail. The remote may rewrite packet data in place but not resize
+ * packets; only the first buffer of a chain is exposed. Closing the socket
+ * disconnects the remote, in-flight packets are dropped.
+ */
+
+#ifndef _RNODE_H_
+#define _RNODE_H_
+
+#ifndef RNODE_CACHELINE_SIZE
+#define RNODE_CACHELINE_SIZE 64
+#endif
+
+#define RNODE_COOKIE		0x3E6F6E72
+#define RNODE_VERSION		1
+
+typedef enum rnode_msg_type
+{
+  RNODE_MSG_TYPE_NONE = 0,
+  RNODE_MSG_TYPE_ADD_REGION = 1,
+  RNODE_MSG_TYPE_ADD_RING = 2,
+  RNODE_MSG_TYPE_CONNECTED = 3,
+} rnode_msg_type_t;
+
+typedef struct __attribute__ ((packed))
+{
+  uint16_t type;
+  uint16_t version;
+  /* ADD_REGION, ADD_RING: region or ring index, CONNECTED: number of rings */
+  uint16_t index;
+  /* ADD_RING: region holding the ring and offset of the ring in it */
+  uint16_t region;
+  uint32_t offset;
+  uint8_t log2_ring_size;
+  uint8_t reserved[3];
+  /* ADD_REGION: region size */
+  uint64_t size;
+  uint64_t reserved2;
+} rnode_msg_t;
+
+_Static_assert (sizeof (rnode_msg_t) == 32,
+		"Size of rnode_msg_t must be 32");
+
+/* verdicts, values from RNODE_VERDICT_FIRST_NEXT on select the nexts
+   configured on the instance, in configuration order */
+#define RNODE_VERDICT_DROP		0
+#define RNODE_VERDICT_CONTINUE		1
+#define RNODE_VERDICT_FIRST_NEXT	2
+
+typedef struct __attribute__ ((packed))
+{
+  uint16_t flags;
+#define RNODE_DESC_FLAG_CHAINED (1 << 0)
+  uint16_t region;
+  /* verdict, written by the remote, RNODE_VERDICT_CONTINUE by default */
+  uint16_t next;
+  uint16_t reserved;
+  uint32_t offset;
+  uint32_t length;
+} rnode_desc_t;
+
+_Static_assert (sizeof (rnode_desc_t) == 16,
+		"Size of rnode_desc_t must be 16 bytes");
+
+#define RNODE_CACHELINE_ALIGN_MARK(mark) \
+  uint8_t mark[0] __attribute__((aligned(RNODE_CACHELINE_SIZE)))
+
+typedef struct
+{
+  RNODE_CACHELINE_ALIGN_MARK (cacheline0);
+  uint32_t cookie;
+  /* written by the remote */
+  uint16_t flags;
+#define RNODE_RING_FLAG_MASK_INT 1
+  /* written by VPP */
+  volatile uint16_t head;
+    RNODE_CACHELINE_ALIGN_MARK (cacheline1);
+  /* written by the remote */
+  volatile uint16_t tail;
+    RNODE_CACHELINE_ALIGN_MARK (cacheline2);
+  rnode_desc_t desc[0];
+} rnode_ring_t;
+
+#endif /* _RNODE_H_ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,125 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+
+#include <rnode/private.h>
+
+#include <vlibapi/api.h>
+#include <vlibmemory/api.h>
+
+/* define message IDs */
+#include <rnode/rnode.api_enum.h>
+#include <rnode/rnode.api_types.h>
+
+#define REPLY_MSG_ID_BASE rnode_main.msg_id_base
+#include <vlibapi/api_helper_macros.h>
+
+static void
+vl_api_rnode_create_t_handler (vl_api_rnode_create_t * mp)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vl_api_rnode_create_reply_t *rmp;
+  rnode_create_args_t args;
+  int rv;
+
+  clib_memset (&args, 0, sizeof (args));
+  args.socket_filename = format (0, "%s%c", mp->socket_filename, 0);
+  args.log2_ring_size = mp->log2_ring_size;
+  args.fail_close = mp->fail_close;
+
+  rv = rnode_create (vm, &args);
+  vec_free (args.socket_filename);
+
+  /* *INDENT-OFF* */
+  REPLY_MACRO2 (VL_API_RNODE_CREATE_REPLY,
+    ({
+      rmp->rnode_index = htonl (args.rnode_index);
+    }));
+  /* *INDENT-ON* */
+}
+
+static void
+vl_api_rnode_delete_t_handler (vl_api_rnode_delete_t * mp)
+{
+  vl_api_rnode_delete_reply_t *rmp;
+  int rv;
+
+  rv = rnode_delete (vlib_get_main (), ntohl (mp->rnode_index));
+
+  REPLY_MACRO (VL_API_RNODE_DELETE_REPLY);
+}
+
+static void
+vl_api_rnode_add_next_t_handler (vl_api_rnode_add_next_t * mp)
+{
+  vl_api_rnode_add_next_reply_t *rmp;
+  u16 verdict = 0;
+  u8 *name;
+  int rv;
+
+  name = format (0, "%s%c", mp->node_name, 0);
+  rv = rnode_add_next (vlib_get_main (), ntohl (mp->rnode_index), name,
+		       &verdict);
+  vec_free (name);
+
+  /* *INDENT-OFF* */
+  REPLY_MACRO2 (VL_API_RNODE_ADD_NEXT_REPLY,
+    ({
+      rmp->verdict = htons (verdict);
+    }));
+  /* *INDENT-ON* */
+}
+
+static void
+vl_api_rnode_enable_disable_t_handler (vl_api_rnode_enable_disable_t * mp)
+{
+  vl_api_rnode_enable_disable_reply_t *rmp;
+  int rv;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  rv = rnode_enable_disable (vlib_get_main (), ntohl (mp->rnode_index),
+			     ntohl (mp->sw_if_index), mp->is_ip6,
+			     mp->enable);
+
+  BAD_SW_IF_INDEX_LABEL;
+  REPLY_MACRO (VL_API_RNODE_ENABLE_DISABLE_REPLY);
+}
+
+/* set up the API message handling tables */
+#include <rnode/rnode.api.c>
+static clib_error_t *
+rnode_api_hookup (vlib_main_t * vm)
+{
+  rnode_main_t *rm = &rnode_main;
+
+  /* ask for a correctly-sized block of API message decode slots */
+  rm->msg_id_base = setup_message_id_table ();
+  return 0;
+}
+
+VLIB_API_INIT_FUNCTION (rnode_api_hookup);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
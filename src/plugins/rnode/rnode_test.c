@@ -0,0 +1,229 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/vnet.h>
+
+#include <vat/vat.h>
+#include <vlibapi/api.h>
+#include <vlibmemory/api.h>
+
+#include <vppinfra/error.h>
+
+uword unformat_sw_if_index (unformat_input_t * input, va_list * args);
+
+#define __plugin_msg_base rnode_test_main.msg_id_base
+#include <vlibapi/vat_helper_macros.h>
+
+/* declare message IDs */
+#include <rnode/rnode.api_enum.h>
+#include <rnode/rnode.api_types.h>
+
+typedef struct
+{
+  /* API message ID base */
+  u16 msg_id_base;
+  vat_main_t *vat_main;
+} rnode_test_main_t;
+
+rnode_test_main_t rnode_test_main;
+
+static int
+api_rnode_create (vat_main_t * vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_rnode_create_t *mp;
+  u8 *socket_filename = 0;
+  u32 ring_size = 1 << 10;
+  u8 fail_close = 0;
+  int ret;
+
+  while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (i, "socket %s", &socket_filename))
+	;
+      else if (unformat (i, "ring-size %u", &ring_size))
+	;
+      else if (unformat (i, "fail-close"))
+	fail_close = 1;
+      else
+	{
+	  clib_warning ("unknown input '%U'", format_unformat_error, i);
+	  return -99;
+	}
+    }
+
+  if (!socket_filename)
+    {
+      errmsg ("missing socket filename\n");
+      return -99;
+    }
+
+  if (!is_pow2 (ring_size))
+    {
+      errmsg ("ring size must be a power of 2\n");
+      vec_free (socket_filename);
+      return -99;
+    }
+
+  M (RNODE_CREATE, mp);
+
+  clib_memcpy (mp->socket_filename, socket_filename,
+	       clib_min (vec_len (socket_filename),
+			 sizeof (mp->socket_filename) - 1));
+  mp->log2_ring_size = min_log2 (ring_size);
+  mp->fail_close = fail_close;
+  vec_free (socket_filename);
+
+  S (mp);
+  W (ret);
+
+  return ret;
+}
+
+static void
+vl_api_rnode_create_reply_t_handler (vl_api_rnode_create_reply_t * mp)
+{
+  vat_main_t *vam = rnode_test_main.vat_main;
+  i32 retval = ntohl (mp->retval);
+
+  if (retval == 0)
+    fformat (vam->ofp, "created rnode%u\n", ntohl (mp->rnode_index));
+
+  vam->retval = retval;
+  vam->result_ready = 1;
+}
+
+static int
+api_rnode_delete (vat_main_t * vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_rnode_delete_t *mp;
+  u32 rnode_index;
+  int ret;
+
+  if (!unformat (i, "%u", &rnode_index))
+    {
+      errmsg ("missing instance index\n");
+      return -99;
+    }
+
+  M (RNODE_DELETE, mp);
+  mp->rnode_index = htonl (rnode_index);
+
+  S (mp);
+  W (ret);
+
+  return ret;
+}
+
+static int
+api_rnode_add_next (vat_main_t * vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_rnode_add_next_t *mp;
+  u8 *node_name = 0;
+  u32 rnode_index;
+  int ret;
+
+  if (!unformat (i, "%u %s", &rnode_index, &node_name))
+    {
+      errmsg ("missing instance index or node name\n");
+      return -99;
+    }
+
+  M (RNODE_ADD_NEXT, mp);
+  mp->rnode_index = htonl (rnode_index);
+  clib_memcpy (mp->node_name, node_name,
+	       clib_min (vec_len (node_name), sizeof (mp->node_name) - 1));
+  vec_free (node_name);
+
+  S (mp);
+  W (ret);
+
+  return ret;
+}
+
+static void
+vl_api_rnode_add_next_reply_t_handler (vl_api_rnode_add_next_reply_t * mp)
+{
+  vat_main_t *vam = rnode_test_main.vat_main;
+  i32 retval = ntohl (mp->retval);
+
+  if (retval == 0)
+    fformat (vam->ofp, "verdict %u\n", ntohs (mp->verdict));
+
+  vam->retval = retval;
+  vam->result_ready = 1;
+}
+
+static int
+api_rnode_enable_disable (vat_main_t * vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_rnode_enable_disable_t *mp;
+  u32 sw_if_index = ~0, rnode_index = ~0;
+  u8 is_ip6 = 0, enable = 1;
+  int ret;
+
+  while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (i, "%U", unformat_sw_if_index, vam, &sw_if_index))
+	;
+      else if (unformat (i, "sw_if_index %u", &sw_if_index))
+	;
+      else if (unformat (i, "ip6"))
+	is_ip6 = 1;
+      else if (unformat (i, "disable"))
+	enable = 0;
+      else if (unformat (i, "%u", &rnode_index))
+	;
+      else
+	{
+	  clib_warning ("unknown input '%U'", format_unformat_error, i);
+	  return -99;
+	}
+    }
+
+  if (sw_if_index == ~0 || rnode_index == ~0)
+    {
+      errmsg ("interface and instance index required\n");
+      return -99;
+    }
+
+  M (RNODE_ENABLE_DISABLE, mp);
+  mp->rnode_index = htonl (rnode_index);
+  mp->sw_if_index = htonl (sw_if_index);
+  mp->is_ip6 = is_ip6;
+  mp->enable = enable;
+
+  S (mp);
+  W (ret);
+
+  return ret;
+}
+
+#include <rnode/rnode.api_test.c>
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
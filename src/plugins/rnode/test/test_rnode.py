@@ -0,0 +1,223 @@
+import array
+import mmap
+import os
+import socket
+import struct
+import threading
+import time
+import unittest
+
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, ICMP
+
+from framework import VppTestCase, VppTestRunner
+
+# see rnode.h
+RNODE_MSG_TYPE_ADD_REGION = 1
+RNODE_MSG_TYPE_ADD_RING = 2
+RNODE_MSG_TYPE_CONNECTED = 3
+RNODE_RING_FLAG_MASK_INT = 1
+RNODE_VERDICT_DROP = 0
+RNODE_VERDICT_CONTINUE = 1
+
+MSG = struct.Struct("=HHHHIB3xQQ")
+DESC = struct.Struct("=HHHHII")
+RING_FLAGS = 4
+RING_HEAD = 6
+RING_TAIL = 64
+RING_DESC = 128
+
+
+class RemoteNode(object):
+    """ remote node process stand-in, polling its rings from a thread """
+
+    def __init__(self, path, verdict):
+        self.verdict = verdict
+        self.paused = False
+        self.regions = {}
+        self.rings = []
+        self.stop = threading.Event()
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        self.sock.connect(path)
+        while self.recv_msg() != RNODE_MSG_TYPE_CONNECTED:
+            pass
+        self.thread = threading.Thread(target=self.run)
+        self.thread.start()
+
+    def recv_msg(self):
+        fds = array.array("i")
+        msg, ancdata, flags, addr = self.sock.recvmsg(
+            MSG.size, socket.CMSG_LEN(2 * fds.itemsize))
+        for level, type, data in ancdata:
+            if level == socket.SOL_SOCKET and type == socket.SCM_RIGHTS:
+                fds.frombytes(data[:len(data) - (len(data) % fds.itemsize)])
+        (type, version, index, region, offset, log2_ring_size,
+         size, _) = MSG.unpack(msg)
+        if type == RNODE_MSG_TYPE_ADD_REGION:
+            self.regions[index] = mmap.mmap(fds[0], size)
+            os.close(fds[0])
+        elif type == RNODE_MSG_TYPE_ADD_RING:
+            # VPP must not kick us, we poll
+            shm = self.regions[region]
+            struct.pack_into("=H", shm, offset + RING_FLAGS,
+                             RNODE_RING_FLAG_MASK_INT)
+            self.rings.append((shm, offset, (1 << log2_ring_size) - 1,
+                               fds[0], fds[1]))
+        return type
+
+    def poll(self, shm, offset, mask, int_fd):
+        head, = struct.unpack_from("=H", shm, offset + RING_HEAD)
+        tail, = struct.unpack_from("=H", shm, offset + RING_TAIL)
+        if head == tail:
+            return
+        while tail != head:
+            desc = offset + RING_DESC + (tail & mask) * DESC.size
+            flags, region, next, _, data, length = DESC.unpack_from(shm, desc)
+            pkt = self.regions[region][data:data + length]
+            struct.pack_into("=H", shm, desc + 4, self.verdict(pkt))
+            tail = (tail + 1) & 0xffff
+        struct.pack_into("=H", shm, offset + RING_TAIL, tail)
+        os.write(int_fd, struct.pack("=Q", 1))
+
+    def run(self):
+        while not self.stop.is_set():
+            for shm, offset, mask, kick_fd, int_fd in self.rings:
+                if not self.paused:
+                    self.poll(shm, offset, mask, int_fd)
+            time.sleep(0.001)
+
+    def close(self):
+        self.stop.set()
+        self.thread.join()
+        self.sock.close()
+        for shm, offset, mask, kick_fd, int_fd in self.rings:
+            os.close(kick_fd)
+            os.close(int_fd)
+        for shm in self.regions.values():
+            shm.close()
+
+
+def icmp_seq(pkt):
+    # the feature runs on ip4-unicast, data starts at the IPv4 header
+    ihl = (pkt[0] & 0xf) * 4
+    return struct.unpack_from("!H", pkt, ihl + 6)[0]
+
+
+class TestRnode(VppTestCase):
+    """ Remote node Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestRnode, cls).setUpClass()
+        cls.create_pg_interfaces(range(2))
+        for pg in cls.pg_interfaces:
+            pg.admin_up()
+            pg.config_ip4()
+            pg.resolve_arp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for pg in cls.pg_interfaces:
+            pg.unconfig_ip4()
+            pg.admin_down()
+        super(TestRnode, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestRnode, self).setUp()
+        self.socket_filename = os.path.join(self.tempdir, "rnode.sock")
+        self.remote = None
+
+    def tearDown(self):
+        if self.remote:
+            self.remote.close()
+        super(TestRnode, self).tearDown()
+
+    def create_rnode(self, fail_close=False):
+        rv = self.vapi.rnode_create(socket_filename=self.socket_filename,
+                                    fail_close=fail_close)
+        self.assertEqual(rv.retval, 0)
+        self.vapi.rnode_enable_disable(rnode_index=rv.rnode_index,
+                                       sw_if_index=self.pg0.sw_if_index,
+                                       enable=True)
+        return rv.rnode_index
+
+    def delete_rnode(self, rnode_index):
+        self.vapi.rnode_enable_disable(rnode_index=rnode_index,
+                                       sw_if_index=self.pg0.sw_if_index,
+                                       enable=False)
+        self.vapi.rnode_delete(rnode_index=rnode_index)
+
+    def send_pings(self, n_pkts, n_expected):
+        pkts = [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+                 ICMP(id=1, seq=i)) for i in range(n_pkts)]
+
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        if n_expected:
+            return self.pg1.get_capture(n_expected, timeout=2)
+        self.pg1.assert_nothing_captured(remark="rnode drops everything")
+        return []
+
+    def test_rnode_verdicts(self):
+        """ Remote node verdicts """
+        rnode_index = self.create_rnode()
+        rv = self.vapi.rnode_add_next(rnode_index=rnode_index,
+                                      node_name="ip4-drop")
+        self.assertEqual(rv.retval, 0)
+        drop_verdict = rv.verdict
+
+        def verdict(pkt):
+            seq = icmp_seq(pkt)
+            if seq % 2:
+                return RNODE_VERDICT_DROP
+            if seq % 4 == 2:
+                return drop_verdict
+            if seq == 8:
+                return 0xffff
+            return RNODE_VERDICT_CONTINUE
+
+        self.remote = RemoteNode(self.socket_filename, verdict)
+        self.assertIn(" connected", self.vapi.cli("show rnode"))
+
+        n_pkts = 64
+        rx = self.send_pings(n_pkts, n_pkts // 4 - 1)
+        for p in rx:
+            self.assertEqual(p[ICMP].seq % 4, 0)
+            self.assertNotEqual(p[ICMP].seq, 8)
+
+        self.assert_error_counter_equal("/err/rnode-input/dropped by remote",
+                                        n_pkts // 2)
+        self.assert_error_counter_equal(
+            "/err/rnode-input/invalid verdict from remote", 1)
+        self.assertIn("sent %d returned %d" % (n_pkts, n_pkts),
+                      self.vapi.cli("show rnode"))
+
+        # in-flight packets are freed when the remote goes away
+        n_used = self.get_buffers_used()
+        self.remote.paused = True
+        self.send_pings(8, 0)
+        self.assertIn("in-flight 8", self.vapi.cli("show rnode"))
+        self.remote.close()
+        self.remote = None
+        self.sleep(0.1, "wait for the disconnection")
+        self.assertIn("not-connected", self.vapi.cli("show rnode"))
+        self.assertEqual(self.get_buffers_used(), n_used)
+        self.delete_rnode(rnode_index)
+
+    def test_rnode_not_connected(self):
+        """ Remote node fail-open and fail-close """
+        rnode_index = self.create_rnode()
+        self.send_pings(8, 8)
+        self.delete_rnode(rnode_index)
+
+        rnode_index = self.create_rnode(fail_close=True)
+        self.send_pings(8, 0)
+        self.assert_error_counter_equal(
+            "/err/rnode-ip4/remote not connected (fail-close)", 8)
+        self.delete_rnode(rnode_index)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -7478,6 +7478,7 @@ static const fib_node_vft_t fib_test_child_vft = {
 f64 fib_walk_process_queues(vlib_main_t * vm,
                             const f64 quota);
 u32 fib_walk_queue_get_size(fib_walk_priority_t prio);
+u64 fib_walk_convergence_get_n_walks(void);
 
 static int
 fib_test_walk (void)
@@ -7485,6 +7486,7 @@ fib_test_walk (void)
     fib_node_back_walk_ctx_t high_ctx = {}, low_ctx = {};
     fib_node_test_t *tc;
     vlib_main_t *vm;
+    u64 n_walks;
     u32 ii, res;
 
     res = 0;
@@ -7522,7 +7524,10 @@ fib_test_walk (void)
     /*
      * give the walk a large amount of time so it gets to the end
      */
+    n_walks = fib_walk_convergence_get_n_walks();
     fib_walk_process_queues(vm, 1);
+    FIB_TEST(n_walks + 1 == fib_walk_convergence_get_n_walks(),
+             "Walk reaching its last child converged");
 
     FOR_EACH_TEST_CHILD(tc)
     {
@@ -7542,6 +7547,8 @@ fib_test_walk (void)
      * the walk will have terminated.
      */
     fib_walk_process_queues(vm, 1);
+    FIB_TEST(n_walks + 1 == fib_walk_convergence_get_n_walks(),
+             "No convergence without walks");
 
     FOR_EACH_TEST_CHILD(tc)
     {
@@ -10520,11 +10527,215 @@ fib_test_sticky (void)
     return 0;
 }
 
+/*
+ * Prefix independent convergence; hierarchical forwarding.
+ * n_routes BGP-like routes, each recursive via two host constrained
+ * next-hops, lose one of those next-hops.
+ */
+static int
+fib_test_pic (vlib_main_t * vm, u32 n_routes)
+{
+    dpo_id_t via_1_dpo = DPO_INVALID, via_2_dpo = DPO_INVALID;
+    const dpo_id_t *dpo;
+    fib_route_path_t *r_paths = NULL;
+    test_main_t *tm = &test_main;
+    fib_node_index_t fei;
+    u32 fib_index = 0;
+    u32 ii, lb_count, pl_count, n_buckets;
+    index_t shared_lbi;
+    fib_prefix_t pfx;
+    f64 t0, t_repair, t_converged;
+    int hierarchical, res = 0;
+
+    lb_count = pool_elts(load_balance_pool);
+    pl_count = fib_path_list_pool_size();
+
+    fib_prefix_t pfx_via_1 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+        },
+    };
+    fib_prefix_t pfx_via_2 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010102),
+        },
+    };
+    ip46_address_t nh_10_10_10_1 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    ip46_address_t nh_10_10_10_2 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02),
+    };
+
+    for (ii = 0; ii < 2; ii++)
+    {
+        fib_route_path_t r_path = {
+            .frp_proto = DPO_PROTO_IP4,
+            .frp_addr = (ii ? pfx_via_2.fp_addr : pfx_via_1.fp_addr),
+            .frp_sw_if_index = ~0,
+            .frp_fib_index = fib_index,
+            .frp_weight = 1,
+            .frp_flags = FIB_ROUTE_PATH_RESOLVE_VIA_HOST,
+        };
+        vec_add1(r_paths, r_path);
+    }
+
+    pfx.fp_len = 32;
+    pfx.fp_proto = FIB_PROTOCOL_IP4;
+
+    fib_walk_process_disable();
+
+    /*
+     * once flat, then hierarchical, so the benchmark has a baseline
+     */
+    for (hierarchical = 0; hierarchical <= 1; hierarchical++)
+    {
+        fib_path_list_set_hierarchical(hierarchical);
+
+        fib_table_entry_path_add(fib_index, &pfx_via_1,
+                                 FIB_SOURCE_API, FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP4, &nh_10_10_10_1,
+                                 tm->hw[0]->sw_if_index, ~0, 1, NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+        fib_table_entry_path_add(fib_index, &pfx_via_2,
+                                 FIB_SOURCE_API, FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP4, &nh_10_10_10_2,
+                                 tm->hw[0]->sw_if_index, ~0, 1, NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+        /*
+         * copies, the entry pool grows as the routes are added
+         */
+        dpo_copy(&via_1_dpo, fib_entry_contribute_ip_forwarding(
+                     fib_table_lookup_exact_match(fib_index, &pfx_via_1)));
+        dpo_copy(&via_2_dpo, fib_entry_contribute_ip_forwarding(
+                     fib_table_lookup_exact_match(fib_index, &pfx_via_2)));
+
+        for (ii = 0; ii < n_routes; ii++)
+        {
+            pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+            fib_table_entry_update(fib_index, &pfx,
+                                   FIB_SOURCE_API, FIB_ENTRY_FLAG_NONE,
+                                   r_paths);
+        }
+
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000);
+        fei = fib_table_lookup_exact_match(fib_index, &pfx);
+        dpo = fib_entry_contribute_ip_forwarding(fei);
+
+        if (hierarchical)
+        {
+            /*
+             * all routes link through one bucket to the same shared LB,
+             * which chooses between the next-hops
+             */
+            FIB_TEST((1 == load_balance_n_buckets(dpo->dpoi_index)),
+                     "route has one bucket");
+            FIB_TEST((DPO_LOAD_BALANCE ==
+                      load_balance_get_bucket(dpo->dpoi_index, 0)->dpoi_type),
+                     "route links to a load-balance");
+            shared_lbi = load_balance_get_bucket(dpo->dpoi_index, 0)->dpoi_index;
+
+            for (ii = 1; ii < n_routes; ii++)
+            {
+                pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+                dpo = fib_entry_contribute_ip_forwarding(
+                    fib_table_lookup_exact_match(fib_index, &pfx));
+                if (shared_lbi !=
+                    load_balance_get_bucket(dpo->dpoi_index, 0)->dpoi_index)
+                    break;
+            }
+            FIB_TEST((ii == n_routes), "all routes share LB:%d", shared_lbi);
+        }
+        else
+        {
+            FIB_TEST((2 == load_balance_n_buckets(dpo->dpoi_index)),
+                     "route has two buckets");
+            shared_lbi = dpo->dpoi_index;
+        }
+        FIB_TEST(!dpo_cmp(&via_1_dpo, load_balance_get_bucket(shared_lbi, 0)),
+                 "bucket 0 via 1.1.1.1");
+        FIB_TEST(!dpo_cmp(&via_2_dpo, load_balance_get_bucket(shared_lbi, 1)),
+                 "bucket 1 via 1.1.1.2");
+
+        /*
+         * lose next-hop 1.1.1.1. Measure the time until the data-plane is
+         * repaired for all routes and until the control-plane converges.
+         */
+        t0 = vlib_time_now(vm);
+        fib_table_entry_delete(fib_index, &pfx_via_1, FIB_SOURCE_API);
+        t_repair = vlib_time_now(vm) - t0;
+
+        if (hierarchical)
+        {
+            n_buckets = load_balance_n_buckets(shared_lbi);
+            for (ii = 0; ii < n_buckets; ii++)
+            {
+                FIB_TEST(!dpo_cmp(&via_2_dpo,
+                                  load_balance_get_bucket(shared_lbi, ii)),
+                         "shared LB bucket %d repaired via 1.1.1.2 "
+                         "before the walk", ii);
+            }
+        }
+
+        while (0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_HIGH) ||
+               0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_LOW))
+        {
+            fib_walk_process_queues(vm, 1);
+        }
+        t_converged = vlib_time_now(vm) - t0;
+
+        for (ii = 0; ii < n_routes; ii++)
+        {
+            pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+            dpo = fib_entry_contribute_ip_forwarding(
+                fib_table_lookup_exact_match(fib_index, &pfx));
+            if (hierarchical)
+                dpo = load_balance_get_bucket(dpo->dpoi_index, 0);
+            if (dpo_cmp(&via_2_dpo, load_balance_get_bucket(dpo->dpoi_index, 0)))
+                break;
+        }
+        FIB_TEST((ii == n_routes), "all routes converged via 1.1.1.2");
+
+        vlib_cli_output(vm, "%s: %d routes, next-hop delete %.2fusec, "
+                        "converged in %.2fusec",
+                        (hierarchical ? "hierarchical" : "flat"), n_routes,
+                        t_repair * 1e6, t_converged * 1e6);
+
+        for (ii = 0; ii < n_routes; ii++)
+        {
+            pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x14000000 + ii);
+            fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+        }
+        fib_table_entry_delete(fib_index, &pfx_via_2, FIB_SOURCE_API);
+        dpo_reset(&via_1_dpo);
+        dpo_reset(&via_2_dpo);
+    }
+
+    fib_path_list_set_hierarchical(0);
+    while (0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_HIGH) ||
+           0 != fib_walk_queue_get_size(FIB_WALK_PRIORITY_LOW))
+    {
+        fib_walk_process_queues(vm, 1);
+    }
+    fib_walk_process_enable();
+    vec_free(r_paths);
+
+    FIB_TEST(lb_count == pool_elts(load_balance_pool), "no leaked LBs");
+    FIB_TEST(pl_count == fib_path_list_pool_size(), "no leaked PLs");
+
+    return (res);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm,
           unformat_input_t * input,
           vlib_cli_command_t * cmd_arg)
 {
+    u32 n_routes = 1024;
     int res;
 
     res = 0;
@@ -10581,6 +10792,11 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_sticky();
     }
+    else if (unformat (input, "pic"))
+    {
+        unformat (input, "routes %d", &n_routes);
+        res += fib_test_pic(vm, n_routes);
+    }
     else
     {
         res += fib_test_v4();
@@ -10590,6 +10806,7 @@ fib_test (vlib_main_t * vm,
         res += fib_test_pref();
         res += fib_test_label();
         res += fib_test_inherit();
+        res += fib_test_pic(vm, n_routes);
         res += lfib_test();
 
         /*
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ip/ip4_packet.h>
+#include <vnet/policer/policer.h>
+#include <vnet/policer/police_inlines.h>
+
+/* Two threads sharing a 1R2C policer through their token caches */
+static clib_error_t *
+test_policer_cache (vlib_main_t * vm)
+{
+  policer_read_response_type_st pol = { 0 };
+  policer_thread_cache_t caches[2] = { {0} };
+  u32 n_conform = 0, len = 500;
+  u64 t;
+
+  pol.single_rate = 1;
+  pol.cir_tokens_per_period = 100;
+  pol.current_limit = pol.current_bucket = 32000;
+  pol.parent_index = ~0;
+
+  /* thread 0 takes a quantum and goes idle with half of it cached */
+  t = 1;
+  if (vnet_police_packet_cached (&pol, &caches[0], len, POLICE_CONFORM, t)
+      != POLICE_CONFORM)
+    return clib_error_return (0, "FAILED: first packet not conform");
+
+  /* long after, the shared bucket is full again: the tokens thread 0
+     held on to go back to it within its limit, and thread 1 drains it,
+     one quantum at a time */
+  t += 10 * POLICER_CACHE_MAX_AGE;
+  n_conform += vnet_police_packet_cached (&pol, &caches[0], len,
+					  POLICE_CONFORM, t) ==
+    POLICE_CONFORM;
+  while (vnet_police_packet_cached (&pol, &caches[1], len, POLICE_CONFORM,
+				    t) == POLICE_CONFORM)
+    n_conform++;
+  n_conform += vnet_police_packet_cached (&pol, &caches[0], len,
+					  POLICE_CONFORM, t) ==
+    POLICE_CONFORM;
+
+  if (n_conform != pol.current_limit / len)
+    return clib_error_return (0, "FAILED: %u conform, burst is %u",
+			      n_conform, pol.current_limit / len);
+
+  /* a starved thread gets the tokens at the committed rate */
+  while (vnet_police_packet_cached (&pol, &caches[1], len, POLICE_CONFORM,
+				    ++t) != POLICE_CONFORM)
+    ;
+  if (t != 1 + 10 * POLICER_CACHE_MAX_AGE + len / pol.cir_tokens_per_period)
+    return clib_error_return (0, "FAILED: conform again after %llu periods",
+			      t - 1 - 10 * POLICER_CACHE_MAX_AGE);
+
+  /* tokens expiring in an idle thread are not lost to the others */
+  t += 10 * POLICER_CACHE_MAX_AGE;
+  pol.current_bucket = 1000;
+  pol.last_update_time = t;
+  caches[0].current_tokens = caches[1].current_tokens = 0;
+  if (vnet_police_packet_cached (&pol, &caches[0], len, POLICE_CONFORM, t)
+      != POLICE_CONFORM)
+    return clib_error_return (0, "FAILED: packet before idle not conform");
+  t += POLICER_CACHE_MAX_AGE + 1;
+  if (vnet_police_packet_cached (&pol, &caches[0], len, POLICE_CONFORM, t)
+      != POLICE_CONFORM)
+    return clib_error_return (0, "FAILED: packet after idle not conform");
+  if (pol.current_bucket + caches[0].current_tokens !=
+      (POLICER_CACHE_MAX_AGE + 1) * pol.cir_tokens_per_period)
+    return clib_error_return (0, "FAILED: %u tokens left after idle, "
+			      "expected %u",
+			      pol.current_bucket + caches[0].current_tokens,
+			      (POLICER_CACHE_MAX_AGE + 1) *
+			      pol.cir_tokens_per_period);
+
+  vlib_cli_output (vm, "policer cache: %u packets in burst", n_conform);
+  return 0;
+}
+
+static u32
+test_policer_create (vlib_main_t * vm, char *name, u8 exceed_dscp)
+{
+  sse2_qos_pol_cfg_params_st c;
+  clib_error_t *error;
+  u32 pi;
+
+  clib_memset (&c, 0, sizeof (c));
+  c.rfc = SSE2_QOS_POLICER_TYPE_1R3C_RFC_2697;
+  c.rate_type = SSE2_QOS_RATE_KBPS;
+  c.rnd_type = SSE2_QOS_ROUND_TO_CLOSEST;
+  c.rb.kbps.cir_kbps = 1000;
+  c.rb.kbps.cb_bytes = 10000;
+  c.rb.kbps.eb_bytes = 10000;
+  c.conform_action.action_type = SSE2_QOS_ACTION_TRANSMIT;
+  c.exceed_action.action_type = SSE2_QOS_ACTION_MARK_AND_TRANSMIT;
+  c.exceed_action.dscp = exceed_dscp;
+  c.violate_action.action_type = SSE2_QOS_ACTION_DROP;
+
+  error = policer_add_del (vm, format (0, "%s%c", name, 0), &c, &pi, 1);
+  if (error)
+    {
+      clib_error_report (error);
+      return ~0;
+    }
+  return pi;
+}
+
+static void
+test_policer_delete (vlib_main_t * vm, char *name)
+{
+  sse2_qos_pol_cfg_params_st c;
+  clib_error_t *error;
+  u32 pi;
+
+  clib_memset (&c, 0, sizeof (c));
+  error = policer_add_del (vm, format (0, "%s%c", name, 0), &c, &pi, 0);
+  clib_error_free (error);
+}
+
+static void
+test_policer_set_buckets (u32 pi, u32 current, u32 extended, u64 time)
+{
+  policer_read_response_type_st *pol = &vnet_policer_main.policers[pi];
+
+  pol->scale = 0;
+  pol->current_bucket = current;
+  pol->extended_bucket = extended;
+  pol->last_update_time = time;
+}
+
+/* Child policer with a color-aware parent, the worst color wins */
+static clib_error_t *
+test_policer_hierarchy (vlib_main_t * vm)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *parent;
+  clib_error_t *error = 0;
+  ethernet_header_t *eh;
+  ip4_header_t *ip4;
+  vlib_buffer_t *b;
+  u32 bi, child_pi, parent_pi, len = 100;
+  u64 t = 1000;
+  u8 act;
+
+  parent_pi = test_policer_create (vm, "test-policer-parent", 18);
+  child_pi = test_policer_create (vm, "test-policer-child", 10);
+  if (parent_pi == ~0 || child_pi == ~0)
+    return clib_error_return (0, "FAILED: policer create");
+
+  parent = &pm->policers[parent_pi];
+  parent->color_aware = 1;
+  if ((error = policer_set_parent (child_pi, parent_pi)))
+    goto done;
+  if (policer_set_parent (parent_pi, child_pi) == 0)
+    {
+      error = clib_error_return (0, "FAILED: hierarchy loop accepted");
+      goto done;
+    }
+
+  if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+    {
+      error = clib_error_return (0, "FAILED: buffer alloc");
+      goto done;
+    }
+  b = vlib_get_buffer (vm, bi);
+  b->current_data = 0;
+  b->current_length = len;
+  clib_memset (b->data, 0, len);
+  eh = (ethernet_header_t *) b->data;
+  eh->type = clib_host_to_net_u16 (ETHERNET_TYPE_IP4);
+  ip4 = (ip4_header_t *) (eh + 1);
+  ip4->ip_version_and_header_length = 0x45;
+
+#define _(cc, ce, pc, pe, a, dscp, what)				\
+  test_policer_set_buckets (child_pi, cc, ce, t);			\
+  test_policer_set_buckets (parent_pi, pc, pe, t);			\
+  ip4->tos = 0;								\
+  act = vnet_policer_police (vm, b, child_pi, t, POLICE_CONFORM);	\
+  if (act != a || ip4->tos >> 2 != dscp)				\
+    {									\
+      error = clib_error_return (0, "FAILED: %s: action %u dscp %u",	\
+				 what, act, ip4->tos >> 2);		\
+      goto free;							\
+    }
+
+  _(1000, 1000, 1000, 1000, SSE2_QOS_ACTION_TRANSMIT, 0,
+    "both conform");
+  if (parent->current_bucket != 1000 - len)
+    {
+      error = clib_error_return (0, "FAILED: parent not charged");
+      goto free;
+    }
+  _(1000, 1000, 0, 1000, SSE2_QOS_ACTION_MARK_AND_TRANSMIT, 18,
+    "parent exceeds");
+  _(1000, 1000, 0, 0, SSE2_QOS_ACTION_DROP, 0, "parent violates");
+  _(0, 1000, 1000, 1000, SSE2_QOS_ACTION_MARK_AND_TRANSMIT, 10,
+    "child exceeds");
+  if (parent->current_bucket != 1000 || parent->extended_bucket != 1000 - len)
+    {
+      error = clib_error_return (0, "FAILED: parent not color-aware");
+      goto free;
+    }
+  _(0, 0, 1000, 1000, SSE2_QOS_ACTION_DROP, 0, "child violates");
+  if (parent->extended_bucket != 1000)
+    {
+      error = clib_error_return (0, "FAILED: dropped packet charged");
+      goto free;
+    }
+#undef _
+
+  vlib_cli_output (vm, "policer hierarchy: ok");
+
+free:
+  vlib_buffer_free (vm, &bi, 1);
+done:
+  test_policer_delete (vm, "test-policer-child");
+  test_policer_delete (vm, "test-policer-parent");
+  return error;
+}
+
+static clib_error_t *
+test_vnet_policer_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  clib_error_t *error;
+
+  if ((error = test_policer_cache (vm)))
+    return error;
+  return test_policer_hierarchy (vm);
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_vnet_policer_command, static) =
+{
+  .path = "test vnet policer",
+  .short_help = "test vnet policer",
+  .function = test_vnet_policer_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
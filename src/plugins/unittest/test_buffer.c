@@ -82,6 +82,73 @@ VLIB_CLI_COMMAND (test_linearize_command, static) =
 };
 /* *INDENT-ON* */
 
+static u32
+buffer_pool_n_free (vlib_buffer_pool_t * bp)
+{
+  vlib_buffer_pool_thread_t *bpt;
+  u32 n = bp->n_avail + bp->n_full_magazines * VLIB_BUFFER_POOL_MAGAZINE_SZ;
+
+  /* *INDENT-OFF* */
+  vec_foreach (bpt, bp->threads)
+    n += bpt->n_cached;
+  /* *INDENT-ON* */
+
+  return n;
+}
+
+/* allocate and free more buffers than fit into the thread cache and
+ * verify that they travel through the magazine depot without loss */
+static int
+buffer_pool_magazines (vlib_main_t * vm)
+{
+  u8 bpi = vlib_buffer_pool_get_default_for_numa (vm, vm->numa_node);
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, bpi);
+  vlib_buffer_pool_thread_t *bpt = vec_elt_at_index (bp->threads,
+						     vm->thread_index);
+  u32 n_free, n_alloc, *bi = 0;
+  u64 n_gets, n_puts;
+  u32 n = 2 * VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ + 37;
+
+  TEST (bp->n_buffers > 2 * n, "pool big enough");
+
+  n_free = buffer_pool_n_free (bp);
+  n_gets = bpt->n_magazine_gets;
+  n_puts = bpt->n_magazine_puts;
+
+  vec_validate (bi, n - 1);
+  n_alloc = vlib_buffer_alloc (vm, bi, n);
+  TEST (n_alloc == n, "alloc %u buffers", n);
+  TEST (buffer_pool_n_free (bp) == n_free - n, "free count after alloc");
+  TEST (bpt->n_magazine_gets > n_gets, "magazines taken from depot");
+
+  vlib_buffer_free (vm, bi, n);
+  TEST (buffer_pool_n_free (bp) == n_free, "free count after free");
+  TEST (bpt->n_magazine_puts > n_puts, "magazines returned to depot");
+  TEST (bp->n_full_magazines <= bp->n_magazines, "depot consistent");
+
+  vec_free (bi);
+  return 0;
+}
+
+static clib_error_t *
+test_buffer_pool_magazines_fn (vlib_main_t * vm, unformat_input_t * input,
+			       vlib_cli_command_t * cmd)
+{
+  if (buffer_pool_magazines (vm))
+    return clib_error_return (0, "buffer_pool_magazines failed");
+
+  return (NULL);
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_buffer_pool_magazines_command, static) =
+{
+  .path = "test buffer-pool-magazines",
+  .short_help = "test buffer-pool-magazines",
+  .function = test_buffer_pool_magazines_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2020 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/eventfd.h>
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vnet/vnet.h>
+#include <vnet/devices/devices.h>
+#include <vnet/devices/virtio/vhost_user.h>
+#include <vnet/devices/virtio/vhost_user_inline.h>
+
+static clib_error_t *
+test_vhost_user_callfd_read (clib_file_t * uf)
+{
+  u64 x;
+
+  if (read (uf->file_descriptor, &x, sizeof (x)) < 0)
+    return clib_error_return_unix (0, "read");
+  return 0;
+}
+
+/* Guest calls of a vring of 256 descriptors, in fixed then adaptive mode */
+static clib_error_t *
+test_vhost_user_coalesce (vlib_main_t * vm)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  clib_file_t template = { 0 };
+  vhost_user_vring_t *vq;
+  clib_error_t *error = 0;
+  u32 coalesce_frames = vum->coalesce_frames;
+  u32 coalesce_frames_max = vum->coalesce_frames_max;
+  f64 coalesce_time = vum->coalesce_time;
+  u8 coalesce_adaptive = vum->coalesce_adaptive;
+  f64 now = 100.0;
+  int fd;
+
+  fd = eventfd (0, EFD_NONBLOCK);
+  if (fd < 0)
+    return clib_error_return_unix (0, "eventfd");
+
+  vq = clib_mem_alloc (sizeof (*vq));
+  clib_memset (vq, 0, sizeof (*vq));
+  template.read_function = test_vhost_user_callfd_read;
+  template.file_descriptor = fd;
+  template.description = format (0, "vhost-user test callfd");
+  vq->callfd_idx = clib_file_add (&file_main, &template);
+  vq->qsz_mask = 255;
+
+  vum->coalesce_frames = 32;
+  vum->coalesce_frames_max = 256;
+  vum->coalesce_time = 1e-3;
+  vq->int_threshold = vum->coalesce_frames;
+
+#define _(n, calls, frames, what)					\
+  vhost_user_vring_coalesce_call (vm, vq, n, now);			\
+  if (vq->n_calls != calls || vq->int_threshold != frames)		\
+    {									\
+      error = clib_error_return (0, "FAILED: %s: calls %llu frames %u",	\
+				 what, vq->n_calls, vq->int_threshold);	\
+      goto done;							\
+    }
+
+  /* fixed: a call every coalesce-frames, the rest is left to the timer */
+  vum->coalesce_adaptive = 0;
+  _(32, 0, 32, "fixed below threshold");
+  _(1, 1, 32, "fixed above threshold");
+  now += 10 * vum->coalesce_time;
+  _(1, 1, 32, "fixed idle vring");
+
+  /* adaptive: a vring idle for the coalesce time is called right away */
+  vum->coalesce_adaptive = 1;
+  _(1, 2, 32, "adaptive idle vring");
+
+  /* calls ahead of time double the threshold, up to half the ring */
+  _(33, 3, 64, "adaptive busy vring");
+  _(65, 4, 128, "adaptive busy vring");
+  _(129, 5, 128, "adaptive busy vring at half the ring");
+
+  /* calls from the coalesce time halve it */
+  now += vum->coalesce_time;
+  _(1, 6, 64, "adaptive quiet vring");
+#undef _
+
+  vlib_cli_output (vm, "vhost-user coalesce: ok");
+
+done:
+  vum->coalesce_frames = coalesce_frames;
+  vum->coalesce_frames_max = coalesce_frames_max;
+  vum->coalesce_time = coalesce_time;
+  vum->coalesce_adaptive = coalesce_adaptive;
+  clib_file_del_by_index (&file_main, vq->callfd_idx);
+  clib_mem_free (vq);
+  return error;
+}
+
+static u32
+test_vhost_user_n_queues (u32 thread_index)
+{
+  vnet_device_input_runtime_t *rt;
+
+  rt = vlib_node_get_runtime_data (vlib_mains[thread_index],
+				   vhost_user_input_node.index);
+  return vec_len (rt->devices_and_queues);
+}
+
+/* The selected worker is numa local, if any worker is, and polls the
+   fewest vhost-user queues among the candidates */
+static clib_error_t *
+test_vhost_user_check_placement (vhost_user_intf_t * vui, u32 * selected)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  u32 ti, min_n_queues = ~0;
+  int numa_local = 0;
+
+  for (ti = 1; ti < tm->n_vlib_mains; ti++)
+    if (vlib_mains[ti]->numa_node == vui->numa_node)
+      numa_local = 1;
+  for (ti = 1; ti < tm->n_vlib_mains; ti++)
+    if (!numa_local || vlib_mains[ti]->numa_node == vui->numa_node)
+      min_n_queues = clib_min (min_n_queues,
+			       test_vhost_user_n_queues (ti));
+
+  ti = vhost_user_rx_thread_select (vui);
+  if (ti == ~0 || ti == 0 || ti >= tm->n_vlib_mains)
+    return clib_error_return (0, "FAILED: numa %u: thread %d",
+			      vui->numa_node, ti);
+  if (numa_local && vlib_mains[ti]->numa_node != vui->numa_node)
+    return clib_error_return (0, "FAILED: numa %u: remote thread %u",
+			      vui->numa_node, ti);
+  if (test_vhost_user_n_queues (ti) != min_n_queues)
+    return clib_error_return (0, "FAILED: numa %u: thread %u polls %u "
+			      "queues, least loaded %u", vui->numa_node, ti,
+			      test_vhost_user_n_queues (ti), min_n_queues);
+  *selected = ti;
+  return 0;
+}
+
+static clib_error_t *
+test_vhost_user_placement (vlib_main_t * vm)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vnet_device_input_runtime_t *rt;
+  vnet_device_and_queue_t *dq;
+  vhost_user_intf_t *vui;
+  clib_error_t *error = 0;
+  u8 round_robin_placement = vum->round_robin_placement;
+  u32 i, ti, n_queued = 0;
+
+  vui = clib_mem_alloc (sizeof (*vui));
+  clib_memset (vui, 0, sizeof (*vui));
+  vui->numa_node = vm->numa_node;
+
+  if (tm->n_vlib_mains == 1)
+    {
+      if (vhost_user_rx_thread_select (vui) != ~0)
+	error = clib_error_return (0, "FAILED: worker picked without "
+				   "workers");
+      else
+	vlib_cli_output (vm, "vhost-user placement: no workers");
+      goto done;
+    }
+
+  vum->round_robin_placement = 1;
+  if (vhost_user_rx_thread_select (vui) != ~0)
+    {
+      error = clib_error_return (0, "FAILED: round-robin placement ignored");
+      goto done;
+    }
+  vum->round_robin_placement = 0;
+
+  /* place as many queues as there are workers; each one goes to a least
+     loaded worker, queued here on its vhost-user-input runtime */
+  for (n_queued = 0; n_queued < tm->n_vlib_mains - 1; n_queued++)
+    {
+      if ((error = test_vhost_user_check_placement (vui, &ti)))
+	goto unqueue;
+      rt = vlib_node_get_runtime_data (vlib_mains[ti],
+				       vhost_user_input_node.index);
+      vec_add2 (rt->devices_and_queues, dq, 1);
+      dq->hw_if_index = ~0;
+      dq->dev_instance = ~0;
+      dq->queue_id = n_queued;
+    }
+
+  /* guest memory on a node without workers */
+  vui->numa_node = 0xffff;
+  if ((error = test_vhost_user_check_placement (vui, &ti)))
+    goto unqueue;
+
+  vlib_cli_output (vm, "vhost-user placement: ok");
+
+unqueue:
+  for (ti = 1; ti < tm->n_vlib_mains; ti++)
+    {
+      rt = vlib_node_get_runtime_data (vlib_mains[ti],
+				       vhost_user_input_node.index);
+      for (i = vec_len (rt->devices_and_queues); i > 0; i--)
+	if (rt->devices_and_queues[i - 1].hw_if_index == ~0)
+	  vec_del1 (rt->devices_and_queues, i - 1);
+    }
+done:
+  vum->round_robin_placement = round_robin_placement;
+  clib_mem_free (vui);
+  return error;
+}
+
+static clib_error_t *
+test_vhost_user_command_fn (vlib_main_t * vm,
+			    unformat_input_t * input,
+			    vlib_cli_command_t * cmd)
+{
+  clib_error_t *error;
+  int coalesce = 0, placement = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "coalesce"))
+	coalesce = 1;
+      else if (unformat (input, "placement"))
+	placement = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (!coalesce && !placement)
+    coalesce = placement = 1;
+
+  if (coalesce && (error = test_vhost_user_coalesce (vm)))
+    return error;
+  if (placement)
+    return test_vhost_user_placement (vm);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_vhost_user_command, static) =
+{
+  .path = "test vhost-user",
+  .short_help = "test vhost-user [coalesce] [placement]",
+  .function = test_vhost_user_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
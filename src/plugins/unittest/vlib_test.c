@@ -228,6 +228,195 @@ VLIB_CLI_COMMAND (test_vlib2_command, static) =
 
 
 
+typedef struct
+{
+  u32 n_callbacks;
+  u32 n_called;
+  u32 n_early;
+  int running;
+  u8 *result;
+} test_rcu_t;
+
+static test_rcu_t test_rcu;
+
+static void
+test_rcu_callback (void *arg)
+{
+  u64 epoch = pointer_to_uword (arg);
+  int i;
+
+  test_rcu.n_called++;
+
+  /* every worker must have reported a quiescent state since the call */
+  if (vlib_worker_threads->recursion_level)
+    return;
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    if (vlib_mains[i]->rcu_quiescent_epoch < epoch)
+      {
+	test_rcu.n_early++;
+	break;
+      }
+}
+
+static void
+test_rcu_call (u32 n_callbacks)
+{
+  u32 i;
+
+  /* the next grace period is the one the callbacks wait for */
+  for (i = 0; i < n_callbacks; i++)
+    vlib_rcu_call (test_rcu_callback,
+		   uword_to_pointer (vlib_rcu_main.epoch + 1, void *));
+}
+
+static clib_error_t *
+test_vlib_rcu (vlib_main_t * vm, u32 n_callbacks)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u32 n_workers = vlib_num_workers ();
+  u64 epoch;
+  int i;
+
+  test_rcu.n_called = test_rcu.n_early = 0;
+
+  /* with workers running, nothing runs before a grace period */
+  test_rcu_call (n_callbacks);
+  if (n_workers && test_rcu.n_called)
+    return clib_error_return (0, "FAILED: %u callbacks ran early",
+			      test_rcu.n_called);
+
+  epoch = rm->epoch;
+  vlib_rcu_synchronize (vm);
+
+  if (n_workers)
+    {
+      if (rm->epoch <= epoch)
+	return clib_error_return (0, "FAILED: epoch did not advance");
+      for (i = 1; i < vec_len (vlib_mains); i++)
+	if (vlib_mains[i]->rcu_quiescent_epoch < rm->epoch)
+	  return clib_error_return (0, "FAILED: worker %u not quiescent", i);
+    }
+
+  /* the grace period has elapsed, so all of them run now */
+  vlib_rcu_poll (vm);
+  if (test_rcu.n_called != n_callbacks)
+    return clib_error_return (0, "FAILED: %u of %u callbacks ran",
+			      test_rcu.n_called, n_callbacks);
+
+  /* left to the main loop, which opens the grace period itself */
+  test_rcu_call (n_callbacks);
+  for (i = 0; i < 100 && test_rcu.n_called < 2 * n_callbacks; i++)
+    vlib_process_suspend (vm, 1e-3);
+  if (test_rcu.n_called != 2 * n_callbacks)
+    return clib_error_return (0, "FAILED: %u of %u callbacks ran",
+			      test_rcu.n_called - n_callbacks, n_callbacks);
+
+  if (test_rcu.n_early)
+    return clib_error_return (0, "FAILED: %u callbacks ran before a "
+			      "grace period", test_rcu.n_early);
+
+  /* parked workers hold no references, no need to defer */
+  vlib_worker_thread_barrier_sync (vm);
+  test_rcu_call (1);
+  vlib_worker_thread_barrier_release (vm);
+  if (test_rcu.n_called != 2 * n_callbacks + 1)
+    return clib_error_return (0, "FAILED: callback deferred under barrier");
+
+  return 0;
+}
+
+static uword
+test_vlib_rcu_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		       vlib_frame_t * f)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  clib_error_t *error;
+  u64 n_deferred;
+
+  while (1)
+    {
+      vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      n_deferred = rm->n_deferred_callbacks;
+      error = test_vlib_rcu (vm, test_rcu.n_callbacks);
+
+      vec_reset_length (test_rcu.result);
+      if (error)
+	{
+	  test_rcu.result = format (test_rcu.result, "%U",
+				    format_clib_error, error);
+	  clib_error_free (error);
+	}
+      else
+	test_rcu.result = format (test_rcu.result,
+				  "RCU test: %u callbacks, %llu deferred, "
+				  "epoch %llu", test_rcu.n_called,
+				  rm->n_deferred_callbacks - n_deferred,
+				  rm->epoch);
+      test_rcu.running = 0;
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (test_vlib_rcu_process_node, static) =
+{
+  .function = test_vlib_rcu_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "test-vlib-rcu-process",
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+test_vlib_rcu_command_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  u32 n_callbacks = 100;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "callbacks %u", &n_callbacks))
+	;
+      else if (unformat (input, "result"))
+	{
+	  if (test_rcu.running)
+	    vlib_cli_output (vm, "RCU test: running");
+	  else
+	    vlib_cli_output (vm, "%v", test_rcu.result);
+	  return 0;
+	}
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (test_rcu.running)
+    return clib_error_return (0, "RCU test already running");
+
+  test_rcu.n_callbacks = n_callbacks;
+  test_rcu.running = 1;
+  vlib_process_signal_event (vm, test_vlib_rcu_process_node.index, 0, 0);
+  vlib_cli_output (vm, "RCU test: started");
+  return 0;
+}
+
+/*?
+ * Test the RCU publish/quiesce facility. The test runs in its own
+ * process, outside of the barrier the API holds while running a command:
+ * with the barrier held every grace period would trivially elapse.
+ * '<em>result</em>' reports the outcome of the last run.
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_vlib_rcu_command, static) =
+{
+  .path = "test vlib rcu",
+  .short_help = "test vlib rcu [callbacks <n>] [result]",
+  .function = test_vlib_rcu_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
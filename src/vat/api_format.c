@@ -883,6 +883,35 @@ static void vl_api_af_packet_create_reply_t_handler_json
   vam->result_ready = 1;
 }
 
+static void vl_api_af_packet_create_v2_reply_t_handler
+  (vl_api_af_packet_create_v2_reply_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+  i32 retval = ntohl (mp->retval);
+
+  vam->retval = retval;
+  vam->regenerate_interface_table = 1;
+  vam->sw_if_index = ntohl (mp->sw_if_index);
+  vam->result_ready = 1;
+}
+
+static void vl_api_af_packet_create_v2_reply_t_handler_json
+  (vl_api_af_packet_create_v2_reply_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+  vat_json_node_t node;
+
+  vat_json_init_object (&node);
+  vat_json_object_add_int (&node, "retval", ntohl (mp->retval));
+  vat_json_object_add_uint (&node, "sw_if_index", ntohl (mp->sw_if_index));
+
+  vat_json_print (vam->ofp, &node);
+  vat_json_free (&node);
+
+  vam->retval = ntohl (mp->retval);
+  vam->result_ready = 1;
+}
+
 static void vl_api_create_vlan_subif_reply_t_handler
   (vl_api_create_vlan_subif_reply_t * mp)
 {
@@ -2671,6 +2700,45 @@ static void vl_api_get_first_msg_id_reply_t_handler_json
   vam->result_ready = 1;
 }
 
+static void vl_api_msg_batch_reply_t_handler
+  (vl_api_msg_batch_reply_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+  i32 retval = ntohl (mp->retval);
+  u32 n_msgs = ntohl (mp->n_msgs);
+  u32 i;
+
+  if (vam->async_mode)
+    {
+      if (n_msgs == 0)
+	vam->async_errors += (retval < 0);
+      for (i = 0; i < n_msgs; i++)
+	vam->async_errors += ((i32) ntohl (mp->retvals[i]) < 0);
+    }
+  else
+    {
+      vam->retval = retval;
+      vam->result_ready = 1;
+    }
+}
+
+static void vl_api_msg_batch_reply_t_handler_json
+  (vl_api_msg_batch_reply_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+  vat_json_node_t node;
+
+  vat_json_init_object (&node);
+  vat_json_object_add_int (&node, "retval", ntohl (mp->retval));
+  vat_json_object_add_uint (&node, "n_processed", ntohl (mp->n_processed));
+
+  vat_json_print (vam->ofp, &node);
+  vat_json_free (&node);
+
+  vam->retval = ntohl (mp->retval);
+  vam->result_ready = 1;
+}
+
 static void vl_api_get_node_graph_reply_t_handler
   (vl_api_get_node_graph_reply_t * mp)
 {
@@ -5298,6 +5366,7 @@ _(BD_IP_MAC_FLUSH_REPLY, bd_ip_mac_flush_reply)                         \
 _(BD_IP_MAC_DETAILS, bd_ip_mac_details)                                 \
 _(WANT_INTERFACE_EVENTS_REPLY, want_interface_events_reply)             \
 _(GET_FIRST_MSG_ID_REPLY, get_first_msg_id_reply)    			\
+_(MSG_BATCH_REPLY, msg_batch_reply)					\
 _(COP_INTERFACE_ENABLE_DISABLE_REPLY, cop_interface_enable_disable_reply) \
 _(COP_WHITELIST_ENABLE_DISABLE_REPLY, cop_whitelist_enable_disable_reply) \
 _(GET_NODE_GRAPH_REPLY, get_node_graph_reply)                           \
@@ -5380,6 +5449,7 @@ _(SHOW_ONE_MAP_REGISTER_TTL_REPLY, show_one_map_register_ttl_reply)     \
 _(SHOW_ONE_MAP_REGISTER_FALLBACK_THRESHOLD_REPLY,                       \
   show_one_map_register_fallback_threshold_reply)                       \
 _(AF_PACKET_CREATE_REPLY, af_packet_create_reply)                       \
+_(AF_PACKET_CREATE_V2_REPLY, af_packet_create_v2_reply)                 \
 _(AF_PACKET_DELETE_REPLY, af_packet_delete_reply)                       \
 _(AF_PACKET_DETAILS, af_packet_details)					\
 _(POLICER_ADD_DEL_REPLY, policer_add_del_reply)                         \
@@ -7991,6 +8061,21 @@ unformat_fib_path (unformat_input_t * input, va_list * args)
   return (1);
 }
 
+/* Send n_msgs length-prefixed messages as one msg_batch */
+static void
+api_msg_batch_send (vat_main_t * vam, u8 * data, u32 n_msgs)
+{
+  vl_api_msg_batch_t *mp;
+
+  M2 (MSG_BATCH, mp, vec_len (data));
+
+  mp->n_msgs = htonl (n_msgs);
+  mp->data_len = htonl (vec_len (data));
+  clib_memcpy (mp->data, data, vec_len (data));
+
+  S (mp);
+}
+
 static int
 api_ip_route_add_del (vat_main_t * vam)
 {
@@ -8009,6 +8094,10 @@ api_ip_route_add_del (vat_main_t * vam)
   u32 random_add_del = 0;
   u32 *random_vector = 0;
   u32 random_seed = 0xdeaddabe;
+  u32 batch_size = 0;
+  u32 n_batched = 0;
+  u8 *batch = 0;
+  u8 *data;
 
   /* Parse args required to build the message */
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
@@ -8023,6 +8112,8 @@ api_ip_route_add_del (vat_main_t * vam)
 	;
       else if (unformat (i, "count %d", &count))
 	;
+      else if (unformat (i, "batch %u", &batch_size))
+	;
       else if (unformat (i, "random"))
 	random_add_del = 1;
       else if (unformat (i, "multipath"))
@@ -8095,7 +8186,18 @@ api_ip_route_add_del (vat_main_t * vam)
   for (j = 0; j < count; j++)
     {
       /* Construct the API message */
-      M2 (IP_ROUTE_ADD_DEL, mp, sizeof (vl_api_fib_path_t) * path_count);
+      if (batch_size)
+	{
+	  u32 msg_size = sizeof (*mp) + sizeof (vl_api_fib_path_t) * path_count;
+
+	  vec_add2 (batch, data, sizeof (u32) + msg_size);
+	  *(u32 *) data = htonl (msg_size);
+	  mp = (vl_api_ip_route_add_del_t *) (data + sizeof (u32));
+	  clib_memset (mp, 0, msg_size);
+	  mp->_vl_msg_id = ntohs (VL_API_IP_ROUTE_ADD_DEL);
+	}
+      else
+	M2 (IP_ROUTE_ADD_DEL, mp, sizeof (vl_api_fib_path_t) * path_count);
 
       mp->is_add = is_add;
       mp->is_multipath = is_multipath;
@@ -8110,13 +8212,27 @@ api_ip_route_add_del (vat_main_t * vam)
 	set_ip4_address (&pfx.address, random_vector[j + 1]);
       else
 	increment_address (&pfx.address);
-      /* send it... */
-      S (mp);
+      /* send it, or queue it up in the batch... */
+      if (batch_size)
+	{
+	  if (++n_batched == batch_size)
+	    {
+	      api_msg_batch_send (vam, batch, n_batched);
+	      vec_reset_length (batch);
+	      n_batched = 0;
+	    }
+	}
+      else
+	S (mp);
       /* If we receive SIGTERM, stop now... */
       if (vam->do_exit)
 	break;
     }
 
+  if (n_batched)
+    api_msg_batch_send (vam, batch, n_batched);
+  vec_free (batch);
+
   /* When testing multiple add/del ops, use a control-ping to sync */
   if (count > 1)
     {
@@ -12405,6 +12521,7 @@ api_create_vhost_user_if (vat_main_t * vam)
   u8 disable_indirect_desc = 0;
   u8 *tag = 0;
   u8 enable_gso = 0;
+  u8 enable_packed = 0;
   int ret;
 
   /* Shut up coverity */
@@ -12428,6 +12545,8 @@ api_create_vhost_user_if (vat_main_t * vam)
 	disable_indirect_desc = 1;
       else if (unformat (i, "gso"))
 	enable_gso = 1;
+      else if (unformat (i, "packed"))
+	enable_packed = 1;
       else if (unformat (i, "tag %s", &tag))
 	;
       else
@@ -12453,6 +12572,7 @@ api_create_vhost_user_if (vat_main_t * vam)
   mp->disable_mrg_rxbuf = disable_mrg_rxbuf;
   mp->disable_indirect_desc = disable_indirect_desc;
   mp->enable_gso = enable_gso;
+  mp->enable_packed = enable_packed;
   clib_memcpy (mp->sock_filename, file_name, vec_len (file_name));
   vec_free (file_name);
   if (custom_dev_instance != ~0)
@@ -12484,6 +12604,7 @@ api_modify_vhost_user_if (vat_main_t * vam)
   u8 sw_if_index_set = 0;
   u32 sw_if_index = (u32) ~ 0;
   u8 enable_gso = 0;
+  u8 enable_packed = 0;
   int ret;
 
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
@@ -12502,6 +12623,8 @@ api_modify_vhost_user_if (vat_main_t * vam)
 	is_server = 1;
       else if (unformat (i, "gso"))
 	enable_gso = 1;
+      else if (unformat (i, "packed"))
+	enable_packed = 1;
       else
 	break;
     }
@@ -12530,6 +12653,7 @@ api_modify_vhost_user_if (vat_main_t * vam)
   mp->sw_if_index = ntohl (sw_if_index);
   mp->is_server = is_server;
   mp->enable_gso = enable_gso;
+  mp->enable_packed = enable_packed;
   clib_memcpy (mp->sock_filename, file_name, vec_len (file_name));
   vec_free (file_name);
   if (custom_dev_instance != ~0)
@@ -17206,6 +17330,70 @@ api_af_packet_create (vat_main_t * vam)
   return ret;
 }
 
+static int
+api_af_packet_create_v2 (vat_main_t * vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_af_packet_create_v2_t *mp;
+  u8 *host_if_name = 0;
+  u8 hw_addr[6];
+  u8 random_hw_addr = 1;
+  u32 num_queues = 1;
+  u32 flags = AF_PACKET_API_FLAG_QDISC_BYPASS;
+  int ret;
+
+  clib_memset (hw_addr, 0, sizeof (hw_addr));
+
+  while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (i, "name %s", &host_if_name))
+	vec_add1 (host_if_name, 0);
+      else if (unformat (i, "hw_addr %U", unformat_ethernet_address, hw_addr))
+	random_hw_addr = 0;
+      else if (unformat (i, "num_queues %u", &num_queues))
+	;
+      else if (unformat (i, "qdisc_bypass_disable"))
+	flags &= ~AF_PACKET_API_FLAG_QDISC_BYPASS;
+      else if (unformat (i, "cksum_gso"))
+	flags |= AF_PACKET_API_FLAG_CKSUM_GSO;
+      else
+	break;
+    }
+
+  if (!vec_len (host_if_name))
+    {
+      errmsg ("host-interface name must be specified");
+      return -99;
+    }
+
+  if (vec_len (host_if_name) > 64)
+    {
+      errmsg ("host-interface name too long");
+      return -99;
+    }
+
+  M (AF_PACKET_CREATE_V2, mp);
+
+  clib_memcpy (mp->host_if_name, host_if_name, vec_len (host_if_name));
+  clib_memcpy (mp->hw_addr, hw_addr, 6);
+  mp->use_random_hw_addr = random_hw_addr;
+  mp->num_queues = htons (num_queues);
+  mp->flags = htonl (flags);
+  vec_free (host_if_name);
+
+  S (mp);
+
+  /* *INDENT-OFF* */
+  W2 (ret,
+      ({
+        if (ret == 0)
+          fprintf (vam->ofp ? vam->ofp : stderr,
+                   " new sw_if_index = %d\n", vam->sw_if_index);
+      }));
+  /* *INDENT-ON* */
+  return ret;
+}
+
 static int
 api_af_packet_delete (vat_main_t * vam)
 {
@@ -20752,7 +20940,7 @@ _(ip_route_add_del,                                                     \
   "<addr>/<mask> via <<addr>|<intfc>|sw_if_index <id>|via-label <n>>\n" \
   "[table-id <n>] [<intfc> | sw_if_index <id>] [resolve-attempts <n>]\n"\
   "[weight <n>] [drop] [local] [classify <n>]  [out-label <n>]\n"       \
-  "[multipath] [count <n>] [del]")                                      \
+  "[multipath] [count <n>] [batch <n>] [del]")                          \
 _(ip_mroute_add_del,                                                    \
   "<src> <grp>/<mask> [table-id <n>]\n"                                 \
   "[<intfc> | sw_if_index <id>] [local] [del]")                         \
@@ -20855,11 +21043,11 @@ _(l2_interface_vlan_tag_rewrite,                                        \
   "[translate-2-[1|2]] [push_dot1q 0] tag1 <nn> tag2 <nn>")             \
 _(create_vhost_user_if,                                                 \
         "socket <filename> [server] [renumber <dev_instance>] "         \
-        "[disable_mrg_rxbuf] [disable_indirect_desc] [gso] "            \
+        "[disable_mrg_rxbuf] [disable_indirect_desc] [gso] [packed] "   \
         "[mac <mac_address>]")                                          \
 _(modify_vhost_user_if,                                                 \
         "<intfc> | sw_if_index <nn> socket <filename>\n"                \
-        "[server] [renumber <dev_instance>] [gso]")                     \
+        "[server] [renumber <dev_instance>] [gso] [packed]")            \
 _(delete_vhost_user_if, "<intfc> | sw_if_index <nn>")                   \
 _(sw_interface_vhost_user_dump, "")                                     \
 _(show_version, "")                                                     \
@@ -21032,6 +21220,8 @@ _(show_lisp_pitr, "")                                                   \
 _(show_lisp_use_petr, "")                                               \
 _(show_lisp_map_request_mode, "")                                       \
 _(af_packet_create, "name <host interface name> [hw_addr <mac>]")       \
+_(af_packet_create_v2, "name <host interface name> [hw_addr <mac>] "    \
+  "[num_queues <n>] [qdisc_bypass_disable] [cksum_gso]")                \
 _(af_packet_delete, "name <host interface name>")                       \
 _(af_packet_dump, "")							\
 _(policer_add_del, "name <policer name> <params> [del]")                \
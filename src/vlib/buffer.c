@@ -74,6 +74,12 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
 static void
 buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index);
 
+#define foreach_vlib_buffer_pool_depot_counter \
+  _(magazine_gets)				\
+  _(magazine_puts)				\
+  _(cas_retries)				\
+  _(lock_fallbacks)
+
 uword
 vlib_buffer_length_in_chain_slow_path (vlib_main_t * vm,
 				       vlib_buffer_t * b_first)
@@ -587,16 +593,85 @@ vlib_buffer_pool_create (vlib_main_t * vm, char *name, u32 data_size,
 	vlib_get_buffer (vm, bi);
       }
 
+  /* move buffers into full magazines, one spare magazine is enough to
+     guarantee that a thread returning a full magazine finds an empty one */
+  bp->n_magazines = bp->n_buffers / VLIB_BUFFER_POOL_MAGAZINE_SZ + 1;
+  bp->magazines = clib_mem_alloc_aligned (bp->n_magazines *
+					  sizeof (bp->magazines[0]),
+					  CLIB_CACHE_LINE_BYTES);
+  bp->full_magazines = VLIB_BUFFER_POOL_MAGAZINE_NONE;
+  bp->empty_magazines = VLIB_BUFFER_POOL_MAGAZINE_NONE;
+
+  for (i = 0; i < bp->n_magazines; i++)
+    {
+      vlib_buffer_pool_magazine_t *m = bp->magazines + i;
+      u64 *head = &bp->empty_magazines;
+
+      if (bp->n_avail >= VLIB_BUFFER_POOL_MAGAZINE_SZ)
+	{
+	  bp->n_avail -= VLIB_BUFFER_POOL_MAGAZINE_SZ;
+	  clib_memcpy_fast (m->buffers, bp->buffers + bp->n_avail,
+			    sizeof (m->buffers));
+	  head = &bp->full_magazines;
+	  bp->n_full_magazines++;
+	}
+
+      m->next = (u32) head[0];
+      head[0] = i;
+    }
+
   return bp->index;
 }
 
+static u32
+buffer_get_available (vlib_buffer_pool_t * bp)
+{
+  return bp->n_avail + bp->n_full_magazines * VLIB_BUFFER_POOL_MAGAZINE_SZ;
+}
+
+static u64
+buffer_get_thread_counter (vlib_buffer_pool_t * bp, uword offset)
+{
+  vlib_buffer_pool_thread_t *bpt;
+  u64 sum = 0;
+
+  /* *INDENT-OFF* */
+  vec_foreach (bpt, bp->threads)
+    sum += *(u64 *) ((u8 *) bpt + offset);
+  /* *INDENT-ON* */
+
+  return sum;
+}
+
+#define buffer_sum_thread_counter(bp, f) \
+  buffer_get_thread_counter (bp, STRUCT_OFFSET_OF (vlib_buffer_pool_thread_t, f))
+
+static u8 *
+format_vlib_buffer_pool_depot (u8 * s, va_list * va)
+{
+  vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
+
+  if (!bp)
+    return format (s, "%-20s%=10s%=10s%=14s%=14s%=14s%=14s",
+		   "Pool Name", "Full", "Empty", "Mag Gets", "Mag Puts",
+		   "CAS Retries", "Lock Fallback");
+
+  return format (s, "%-20s%=10u%=10u%=14lu%=14lu%=14lu%=14lu", bp->name,
+		bp->n_full_magazines,
+		bp->n_magazines - bp->n_full_magazines,
+		buffer_sum_thread_counter (bp, n_magazine_gets),
+		buffer_sum_thread_counter (bp, n_magazine_puts),
+		buffer_sum_thread_counter (bp, n_cas_retries),
+		buffer_sum_thread_counter (bp, n_lock_fallbacks));
+}
+
 static u8 *
 format_vlib_buffer_pool (u8 * s, va_list * va)
 {
   vlib_main_t *vm = va_arg (*va, vlib_main_t *);
   vlib_buffer_pool_t *bp = va_arg (*va, vlib_buffer_pool_t *);
   vlib_buffer_pool_thread_t *bpt;
-  u32 cached = 0;
+  u32 cached = 0, avail;
 
   if (!bp)
     return format (s, "%-20s%=6s%=6s%=6s%=11s%=6s%=8s%=8s%=8s",
@@ -608,11 +683,13 @@ format_vlib_buffer_pool (u8 * s, va_list * va)
     cached += bpt->n_cached;
   /* *INDENT-ON* */
 
+  avail = buffer_get_available (bp);
+
   s = format (s, "%-20s%=6d%=6d%=6u%=11u%=6u%=8u%=8u%=8u",
 	      bp->name, bp->index, bp->numa_node, bp->data_size +
 	      sizeof (vlib_buffer_t) + vm->buffer_main->ext_hdr_size,
-	      bp->data_size, bp->n_buffers, bp->n_avail, cached,
-	      bp->n_buffers - bp->n_avail - cached);
+	      bp->data_size, bp->n_buffers, avail, cached,
+	      bp->n_buffers - avail - cached);
 
   return s;
 }
@@ -623,6 +700,10 @@ show_buffers (vlib_main_t * vm,
 {
   vlib_buffer_main_t *bm = vm->buffer_main;
   vlib_buffer_pool_t *bp;
+  int verbose = 0;
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
 
   vlib_cli_output (vm, "%U", format_vlib_buffer_pool, vm, 0);
 
@@ -631,13 +712,23 @@ show_buffers (vlib_main_t * vm,
     vlib_cli_output (vm, "%U", format_vlib_buffer_pool, vm, bp);
   /* *INDENT-ON* */
 
+  if (!verbose)
+    return 0;
+
+  vlib_cli_output (vm, "\n%U", format_vlib_buffer_pool_depot, 0);
+
+  /* *INDENT-OFF* */
+  vec_foreach (bp, bm->buffer_pools)
+    vlib_cli_output (vm, "%U", format_vlib_buffer_pool_depot, bp);
+  /* *INDENT-ON* */
+
   return 0;
 }
 
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (show_buffers_command, static) = {
   .path = "show buffers",
-  .short_help = "Show packet buffer allocation",
+  .short_help = "show buffers [verbose]",
   .function = show_buffers,
 };
 /* *INDENT-ON* */
@@ -774,7 +865,8 @@ buffer_gauges_update_used_fn (stat_segment_directory_entry_t * e, u32 index)
   if (!bp)
     return;
 
-  e->value = bp->n_buffers - bp->n_avail - buffer_get_cached (bp);
+  e->value = bp->n_buffers - buffer_get_available (bp) -
+    buffer_get_cached (bp);
 }
 
 static void
@@ -786,7 +878,7 @@ buffer_gauges_update_available_fn (stat_segment_directory_entry_t * e,
   if (!bp)
     return;
 
-  e->value = bp->n_avail;
+  e->value = buffer_get_available (bp);
 }
 
 static void
@@ -800,6 +892,21 @@ buffer_gauges_update_cached_fn (stat_segment_directory_entry_t * e, u32 index)
   e->value = buffer_get_cached (bp);
 }
 
+#define _(f)								\
+static void								\
+buffer_gauges_update_##f##_fn (stat_segment_directory_entry_t * e,	\
+			       u32 index)				\
+{									\
+  vlib_main_t *vm = vlib_get_main ();					\
+  vlib_buffer_pool_t *bp = buffer_get_by_index (vm->buffer_main, index);\
+  if (!bp)								\
+    return;								\
+									\
+  e->value = buffer_sum_thread_counter (bp, n_##f);			\
+}
+foreach_vlib_buffer_pool_depot_counter
+#undef _
+
 clib_error_t *
 vlib_buffer_main_init (struct vlib_main_t * vm)
 {
@@ -888,6 +995,14 @@ vlib_buffer_main_init (struct vlib_main_t * vm)
     name = format (name, "/buffer-pools/%s/available%c", bp->name, 0);
     stat_segment_register_gauge (name, buffer_gauges_update_available_fn,
 				 bp - bm->buffer_pools);
+
+#define _(f)								\
+    vec_reset_length (name);						\
+    name = format (name, "/buffer-pools/%s/" #f "%c", bp->name, 0);	\
+    stat_segment_register_gauge (name, buffer_gauges_update_##f##_fn,	\
+				 bp - bm->buffer_pools);
+    foreach_vlib_buffer_pool_depot_counter
+#undef _
   }
 
 done:
@@ -412,11 +412,36 @@ struct vlib_main_t;
 
 #define VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ 512
 
+/* Buffers move between per-thread caches and the global pool in
+   fixed-size magazines. Full and empty magazines are kept on two
+   lock-free stacks (the depot), so only the fallback path takes
+   the pool lock. */
+#define VLIB_BUFFER_POOL_MAGAZINE_SZ 64
+#define VLIB_BUFFER_POOL_MAGAZINE_NONE ((u32) ~0)
+
+STATIC_ASSERT ((VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ %
+		VLIB_BUFFER_POOL_MAGAZINE_SZ) == 0,
+	       "thread cache size must be multiple of magazine size");
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 buffers[VLIB_BUFFER_POOL_MAGAZINE_SZ];
+  /* next magazine on the depot stack */
+  u32 next;
+} vlib_buffer_pool_magazine_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   u32 cached_buffers[VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ];
   u32 n_cached;
+
+  /* depot counters, summed over threads by show buffers and stats */
+  u64 n_magazine_gets;
+  u64 n_magazine_puts;
+  u64 n_cas_retries;
+  u64 n_lock_fallbacks;
 } vlib_buffer_pool_thread_t;
 
 typedef struct
@@ -438,6 +463,14 @@ typedef struct
   /* per-thread data */
   vlib_buffer_pool_thread_t *threads;
 
+  /* magazine depot, stack heads are (tag << 32) | magazine index */
+  vlib_buffer_pool_magazine_t *magazines;
+  u32 n_magazines;
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  u64 full_magazines;
+  u64 empty_magazines;
+  u32 n_full_magazines;
+
   /* buffer metadata template */
   vlib_buffer_t buffer_template;
 } vlib_buffer_pool_t;
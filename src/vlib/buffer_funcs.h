@@ -488,11 +488,59 @@ vlib_get_buffer_pool (vlib_main_t * vm, u8 buffer_pool_index)
   return vec_elt_at_index (bm->buffer_pools, buffer_pool_index);
 }
 
-static_always_inline uword
-vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
-		      u32 n_buffers)
+static_always_inline u32
+vlib_buffer_pool_magazine_pop (vlib_buffer_pool_t * bp, u64 * head,
+			       vlib_buffer_pool_thread_t * bpt)
+{
+  vlib_buffer_pool_magazine_t *m;
+  u64 old, new, prev;
+  u32 mi;
+
+  old = clib_atomic_load_acq_n (head);
+  while (1)
+    {
+      mi = (u32) old;
+      if (mi == VLIB_BUFFER_POOL_MAGAZINE_NONE)
+	return mi;
+
+      /* magazines are never freed, so reading next of a magazine which
+         was popped meanwhile is harmless - the tag makes the swap fail */
+      m = bp->magazines + mi;
+      new = ((old >> 32) + 1) << 32 | clib_atomic_load_relax_n (&m->next);
+      prev = clib_atomic_cmp_and_swap (head, old, new);
+      if (prev == old)
+	return mi;
+
+      old = prev;
+      bpt->n_cas_retries++;
+    }
+}
+
+static_always_inline void
+vlib_buffer_pool_magazine_push (vlib_buffer_pool_t * bp, u64 * head, u32 mi,
+				vlib_buffer_pool_thread_t * bpt)
+{
+  vlib_buffer_pool_magazine_t *m = bp->magazines + mi;
+  u64 old, new, prev;
+
+  old = clib_atomic_load_relax_n (head);
+  while (1)
+    {
+      clib_atomic_store_rel_n (&m->next, (u32) old);
+      new = ((old >> 32) + 1) << 32 | mi;
+      prev = clib_atomic_cmp_and_swap (head, old, new);
+      if (prev == old)
+	return;
+
+      old = prev;
+      bpt->n_cas_retries++;
+    }
+}
+
+static_always_inline u32
+vlib_buffer_pool_get_locked (vlib_buffer_pool_t * bp, u32 * buffers,
+			     u32 n_buffers)
 {
-  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
   u32 len;
 
   ASSERT (bp->buffers);
@@ -516,6 +564,69 @@ vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
     }
 }
 
+static_always_inline void
+vlib_buffer_pool_put_locked (vlib_buffer_pool_t * bp, u32 * buffers,
+			     u32 n_buffers)
+{
+  clib_spinlock_lock (&bp->lock);
+  vlib_buffer_copy_indices (bp->buffers + bp->n_avail, buffers, n_buffers);
+  bp->n_avail += n_buffers;
+  clib_spinlock_unlock (&bp->lock);
+}
+
+static_always_inline uword
+vlib_buffer_pool_get (vlib_main_t * vm, u8 buffer_pool_index, u32 * buffers,
+		      u32 n_buffers)
+{
+  vlib_buffer_pool_t *bp = vlib_get_buffer_pool (vm, buffer_pool_index);
+  vlib_buffer_pool_thread_t *bpt = vec_elt_at_index (bp->threads,
+						     vm->thread_index);
+  vlib_buffer_pool_magazine_t *m;
+  u32 mi, n, n_left = n_buffers;
+
+  /* take full magazines from the depot */
+  while (n_left >= VLIB_BUFFER_POOL_MAGAZINE_SZ)
+    {
+      mi = vlib_buffer_pool_magazine_pop (bp, &bp->full_magazines, bpt);
+      if (mi == VLIB_BUFFER_POOL_MAGAZINE_NONE)
+	break;
+
+      m = bp->magazines + mi;
+      vlib_buffer_copy_indices (buffers, m->buffers,
+				VLIB_BUFFER_POOL_MAGAZINE_SZ);
+      vlib_buffer_pool_magazine_push (bp, &bp->empty_magazines, mi, bpt);
+      clib_atomic_fetch_sub_rel (&bp->n_full_magazines, 1);
+      bpt->n_magazine_gets++;
+      buffers += VLIB_BUFFER_POOL_MAGAZINE_SZ;
+      n_left -= VLIB_BUFFER_POOL_MAGAZINE_SZ;
+    }
+
+  if (PREDICT_TRUE (n_left == 0))
+    return n_buffers;
+
+  bpt->n_lock_fallbacks++;
+  n = vlib_buffer_pool_get_locked (bp, buffers, n_left);
+  buffers += n;
+  n_left -= n;
+
+  /* partial magazine needed, return the rest of it to the locked pool */
+  if (n_left && n_left < VLIB_BUFFER_POOL_MAGAZINE_SZ &&
+      (mi = vlib_buffer_pool_magazine_pop (bp, &bp->full_magazines, bpt))
+      != VLIB_BUFFER_POOL_MAGAZINE_NONE)
+    {
+      m = bp->magazines + mi;
+      vlib_buffer_copy_indices (buffers, m->buffers, n_left);
+      vlib_buffer_pool_put_locked (bp, m->buffers + n_left,
+				   VLIB_BUFFER_POOL_MAGAZINE_SZ - n_left);
+      vlib_buffer_pool_magazine_push (bp, &bp->empty_magazines, mi, bpt);
+      clib_atomic_fetch_sub_rel (&bp->n_full_magazines, 1);
+      bpt->n_magazine_gets++;
+      n_left = 0;
+    }
+
+  return n_buffers - n_left;
+}
+
 
 /** \brief Allocate buffers from specific pool into supplied array
 
@@ -576,7 +687,7 @@ vlib_buffer_alloc_from_pool (vlib_main_t * vm, u32 * buffers, u32 n_buffers,
       n_left -= len;
     }
 
-  len = round_pow2 (n_left, 32);
+  len = round_pow2 (n_left, VLIB_BUFFER_POOL_MAGAZINE_SZ);
   len = vlib_buffer_pool_get (vm, buffer_pool_index, bpt->cached_buffers,
 			      len);
   bpt->n_cached = len;
@@ -720,12 +831,47 @@ vlib_buffer_pool_put (vlib_main_t * vm, u8 buffer_pool_index,
   vlib_buffer_copy_indices (bpt->cached_buffers + n_cached,
 			    buffers + n_buffers - n_empty, n_empty);
   bpt->n_cached = VLIB_BUFFER_POOL_PER_THREAD_CACHE_SZ;
+  n_buffers -= n_empty;
 
-  clib_spinlock_lock (&bp->lock);
-  vlib_buffer_copy_indices (bp->buffers + bp->n_avail, buffers,
-			    n_buffers - n_empty);
-  bp->n_avail += n_buffers - n_empty;
-  clib_spinlock_unlock (&bp->lock);
+  /* return the excess to the depot in full magazines, last one is topped
+     up from the (now full) thread cache */
+  while (n_buffers)
+    {
+      vlib_buffer_pool_magazine_t *m;
+      u32 mi;
+
+      mi = vlib_buffer_pool_magazine_pop (bp, &bp->empty_magazines, bpt);
+      if (mi == VLIB_BUFFER_POOL_MAGAZINE_NONE)
+	break;
+
+      m = bp->magazines + mi;
+      if (n_buffers >= VLIB_BUFFER_POOL_MAGAZINE_SZ)
+	{
+	  n_buffers -= VLIB_BUFFER_POOL_MAGAZINE_SZ;
+	  vlib_buffer_copy_indices (m->buffers, buffers + n_buffers,
+				    VLIB_BUFFER_POOL_MAGAZINE_SZ);
+	}
+      else
+	{
+	  u32 n_top = VLIB_BUFFER_POOL_MAGAZINE_SZ - n_buffers;
+	  vlib_buffer_copy_indices (m->buffers, buffers, n_buffers);
+	  bpt->n_cached -= n_top;
+	  vlib_buffer_copy_indices (m->buffers + n_buffers,
+				    bpt->cached_buffers + bpt->n_cached,
+				    n_top);
+	  n_buffers = 0;
+	}
+
+      vlib_buffer_pool_magazine_push (bp, &bp->full_magazines, mi, bpt);
+      clib_atomic_fetch_add_rel (&bp->n_full_magazines, 1);
+      bpt->n_magazine_puts++;
+    }
+
+  if (PREDICT_TRUE (n_buffers == 0))
+    return;
+
+  bpt->n_lock_fallbacks++;
+  vlib_buffer_pool_put_locked (bp, buffers, n_buffers);
 }
 
 static_always_inline void
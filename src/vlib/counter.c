@@ -105,6 +105,36 @@ vlib_validate_combined_counter (vlib_combined_counter_main_t * cm, u32 index)
 		       3 /*STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED */ );
 }
 
+int
+vlib_validate_combined_counter_will_expand
+  (vlib_combined_counter_main_t * cm, u32 index)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap = clib_mem_get_heap ();
+  int i, rv = 0;
+
+  if (PREDICT_FALSE (vec_len (cm->counters) < tm->n_vlib_mains))
+    return 1;
+
+  /* the counter vectors live on the stats heap; only look, don't pop */
+  vlib_stats_push_heap (cm->counters);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      if (index < vec_len (cm->counters[i]))
+	continue;
+      if (_vec_resize_will_expand (cm->counters[i],
+				   index + 1 - vec_len (cm->counters[i]),
+				   (index + 1) * sizeof (cm->counters[i][0]),
+				   0, CLIB_CACHE_LINE_BYTES))
+	{
+	  rv = 1;
+	  break;
+	}
+    }
+  clib_mem_set_heap (oldheap);
+  return rv;
+}
+
 u32
 vlib_combined_counter_n_counters (const vlib_combined_counter_main_t * cm)
 {
@@ -617,6 +617,24 @@ vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n)
   }
 }
 
+always_inline void
+vlib_node_histogram_update (vlib_node_main_t * nm, u32 node_index,
+			    uword n_clocks, uword n_vectors)
+{
+  vlib_node_histogram_t *h;
+  uword b;
+
+  /* Nodes registered after the histograms were enabled are skipped */
+  if (PREDICT_FALSE (node_index >= vec_len (nm->histograms)))
+    return;
+
+  h = vec_elt_at_index (nm->histograms, node_index);
+  b = n_clocks ? min_log2 (n_clocks) : 0;
+  h->clocks[clib_min (b, VLIB_NODE_HIST_N_CLOCK_BUCKETS - 1)]++;
+  b = min_log2 (n_vectors);
+  h->vectors[clib_min (b, VLIB_NODE_HIST_N_VECTOR_BUCKETS - 1)]++;
+}
+
 always_inline u32
 vlib_node_runtime_update_stats (vlib_main_t * vm,
 				vlib_node_runtime_t * node,
@@ -740,6 +758,7 @@ elog_save_buffer (vlib_main_t * vm,
 		   elog_buffer_capacity (em), chroot_file);
 
   vlib_worker_thread_barrier_sync (vm);
+  elog_merge_thread_rings (em, 1 /* flush */ );
   error = elog_write_file (em, chroot_file, 1 /* flush ring */ );
   vlib_worker_thread_barrier_release (vm);
   vec_free (chroot_file);
@@ -757,6 +776,7 @@ elog_post_mortem_dump (void)
   if (!vm->elog_post_mortem_dump)
     return;
 
+  elog_merge_thread_rings (em, 1 /* flush */ );
   filename = format (0, "/tmp/elog_post_mortem.%d%c", getpid (), 0);
   error = elog_write_file (em, (char *) filename, 1 /* flush ring */ );
   if (error)
@@ -842,6 +862,221 @@ VLIB_CLI_COMMAND (elog_resize_cli, static) = {
 };
 /* *INDENT-ON* */
 
+static void
+elog_stream_write_chunk (vlib_main_t * vm)
+{
+  elog_main_t *em = &vm->elog_main;
+  clib_error_t *error;
+  u8 *file;
+  u32 seq = vm->elog_stream_seq++;
+
+  if (vm->elog_stream_n_files)
+    seq %= vm->elog_stream_n_files;
+
+  file = format (0, "/tmp/%s.%u%c", vm->elog_stream_file, seq, 0);
+  if (em->thread_rings)
+    {
+      /* Only this process writes the main ring, workers keep going */
+      error = elog_write_file_and_reset (em, (char *) file);
+    }
+  else
+    {
+      /* Workers log straight into the main ring */
+      vlib_worker_thread_barrier_sync (vm);
+      error = elog_write_file_and_reset (em, (char *) file);
+      vlib_worker_thread_barrier_release (vm);
+    }
+  if (error)
+    clib_error_report (error);
+  vec_free (file);
+}
+
+/*
+ * Drain per-thread event rings into the main ring and, when streaming,
+ * write the main ring out in chunks. Each chunk is a complete event log.
+ */
+static uword
+elog_merge_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		    vlib_frame_t * f)
+{
+  elog_main_t *em = &vm->elog_main;
+  f64 now, next_chunk = 0;
+  uword *event_data = 0;
+
+  if (vm->elog_thread_ring_size)
+    {
+      vlib_worker_thread_barrier_sync (vm);
+      elog_enable_thread_rings (em, vec_len (vlib_worker_threads),
+				vm->elog_thread_ring_size);
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+  while (1)
+    {
+      if (em->thread_rings || vm->elog_stream_file)
+	vlib_process_wait_for_event_or_clock (vm, 10e-3);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      elog_merge_thread_rings (em, 0);
+
+      now = vlib_time_now (vm);
+      if (vm->elog_stream_file && now >= next_chunk)
+	{
+	  if (next_chunk != 0)
+	    elog_stream_write_chunk (vm);
+	  next_chunk = now + vm->elog_stream_interval;
+	}
+      else if (vm->elog_stream_file == 0)
+	next_chunk = 0;
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (elog_merge_process_node, static) = {
+  .function = elog_merge_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "elog-merge-process",
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+elog_per_thread (vlib_main_t * vm,
+		 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  elog_main_t *em = &vm->elog_main;
+  u32 size = 16 << 10;
+  int enable = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "off") || unformat (input, "disable"))
+	enable = 0;
+      else
+	return unformat_parse_error (input);
+    }
+
+  if (enable && size == 0)
+    return clib_error_return (0, "ring size must be non-zero");
+
+  vlib_worker_thread_barrier_sync (vm);
+  if (enable)
+    elog_enable_thread_rings (em, vec_len (vlib_worker_threads), size);
+  else
+    elog_disable_thread_rings (em);
+  vlib_worker_thread_barrier_release (vm);
+
+  vm->elog_thread_ring_size = enable ? em->thread_ring_size : 0;
+  vlib_process_signal_event (vm, elog_merge_process_node.index, 0, 0);
+  return 0;
+}
+
+/*?
+ * Log events into a ring per thread instead of the shared ring.
+ * Logging then costs no atomic operation on a shared cache line.
+ * Per-thread rings are merged into the main ring in timestamp order
+ * every 10ms, so the main ring, 'show event-logger' and
+ * 'event-logger save' work as before.
+ *
+ * @cliexpar
+ * @cliexcmd{event-logger per-thread size 65536}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (elog_per_thread_cli, static) = {
+  .path = "event-logger per-thread",
+  .short_help = "event-logger per-thread [size <nnn>] [off]",
+  .function = elog_per_thread,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+elog_stream (vlib_main_t * vm,
+	     unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  char *file = 0;
+  f64 interval = 1.0;
+  u32 n_files = 0;
+  int disable = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "off") || unformat (input, "disable"))
+	disable = 1;
+      else if (unformat (input, "interval %f", &interval))
+	;
+      else if (unformat (input, "files %u", &n_files))
+	;
+      else if (!file && unformat (input, "%s", &file))
+	;
+      else
+	{
+	  vec_free (file);
+	  return unformat_parse_error (input);
+	}
+    }
+
+  if (disable)
+    {
+      vec_free (file);
+      if (vm->elog_stream_file)
+	elog_stream_write_chunk (vm);
+      vec_free (vm->elog_stream_file);
+      return 0;
+    }
+
+  if (!file)
+    return clib_error_return (0, "expected file name");
+  vec_add1 (file, 0);
+
+  /* Same restriction as event-logger save */
+  if (strstr (file, "..") || index (file, '/'))
+    {
+      vec_free (file);
+      return clib_error_return (0, "illegal characters in filename");
+    }
+
+  if (interval < 10e-3)
+    {
+      vec_free (file);
+      return clib_error_return (0, "interval must be at least 10ms");
+    }
+
+  vec_free (vm->elog_stream_file);
+  vm->elog_stream_file = (u8 *) file;
+  vm->elog_stream_interval = interval;
+  vm->elog_stream_n_files = n_files;
+  vm->elog_stream_seq = 0;
+
+  vlib_cli_output (vm, "Streaming event log to /tmp/%s.<n> every %.2fs",
+		   file, interval);
+  vlib_process_signal_event (vm, elog_merge_process_node.index, 0, 0);
+  return 0;
+}
+
+/*?
+ * Continuously export the event log. Every interval the main ring is
+ * written to /tmp/<file>.<n> and emptied. Each chunk is a complete log
+ * in the 'event-logger save' format, readable by g2 and c2cpel.
+ * With 'files <n>' chunk names wrap after n files.
+ *
+ * @cliexpar
+ * @cliexcmd{event-logger stream elog interval 1 files 60}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (elog_stream_cli, static) = {
+  .path = "event-logger stream",
+  .short_help = "event-logger stream <filename> [interval <sec>] "
+    "[files <n>] | off",
+  .function = elog_stream,
+};
+/* *INDENT-ON* */
+
 #endif /* CLIB_UNIX */
 
 static void
@@ -855,11 +1090,16 @@ elog_show_buffer_internal (vlib_main_t * vm, u32 n_events_to_show)
   dt = (em->init_time.cpu - vm->clib_time.init_cpu_time)
     * vm->clib_time.seconds_per_clock;
 
+  elog_merge_thread_rings (em, 0);
   es = elog_peek_events (em);
   vlib_cli_output (vm, "%d of %d events in buffer, logger %s", vec_len (es),
 		   em->event_ring_size,
 		   em->n_total_events < em->n_total_events_disable_limit ?
 		   "running" : "stopped");
+  if (em->thread_rings)
+    vlib_cli_output (vm, "per-thread rings of %d events, %lld lost",
+		     em->thread_ring_size,
+		     elog_thread_rings_lost_events (em));
   vec_foreach (e, es)
   {
     vlib_cli_output (vm, "%18.9f: %U",
@@ -1082,7 +1322,8 @@ dispatch_pcap_trace (vlib_main_t * vm,
 	  string_count++;
 
 	  /* Is this packet traced? */
-	  if (PREDICT_FALSE (b->flags & VLIB_BUFFER_IS_TRACED))
+	  if (PREDICT_FALSE (b->flags & VLIB_BUFFER_IS_TRACED)
+	      && tm->sample_enable == 0)
 	    {
 	      vlib_trace_header_t **h
 		= pool_elt_at_index (tm->trace_buffer_pool,
@@ -1232,6 +1473,9 @@ dispatch_node (vlib_main_t * vm,
 				      pmc_delta[0] /* PMC0 */ ,
 				      pmc_delta[1] /* PMC1 */ );
 
+  if (PREDICT_FALSE (nm->histograms != 0) && n)
+    vlib_node_histogram_update (nm, node->node_index, t - last_time_stamp, n);
+
   /* When in interrupt mode and vector rate crosses threshold switch to
      polling mode. */
   if (PREDICT_FALSE ((dispatch_state == VLIB_NODE_STATE_INTERRUPT)
@@ -1749,6 +1993,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  vlib_rcu_quiescent_state (vm);
 	  if (PREDICT_FALSE (vm->check_frame_queues +
 			     frame_queue_check_counter))
 	    {
@@ -1772,6 +2017,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 	  if (PREDICT_FALSE (vec_len (vm->worker_thread_main_loop_callbacks)))
 	    clib_call_callbacks (vm->worker_thread_main_loop_callbacks, vm);
 	}
+      else if (PREDICT_FALSE (vec_len (vlib_rcu_main.pending) > 0))
+	vlib_rcu_poll (vm);
 
       /* Process pre-input nodes. */
       vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
@@ -1957,6 +2204,9 @@ vlib_main_configure (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "elog-post-mortem-dump"))
 	vm->elog_post_mortem_dump = 1;
+      else if (unformat (input, "elog-per-thread-events %u",
+			 &vm->elog_thread_ring_size))
+	;
       else
 	return unformat_parse_error (input);
     }
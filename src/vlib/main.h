@@ -199,6 +199,15 @@ typedef struct vlib_main_t
   int elog_trace_graph_circuit;
   u32 elog_trace_graph_circuit_node_index;
 
+  /* Per-thread event rings, events per thread or 0 if disabled */
+  u32 elog_thread_ring_size;
+
+  /* Streaming export of the event log in chunk files */
+  u8 *elog_stream_file;
+  f64 elog_stream_interval;
+  u32 elog_stream_n_files;
+  u32 elog_stream_seq;
+
   /* Node call and return event types. */
   elog_event_type_t *node_call_elog_event_types;
   elog_event_type_t *node_return_elog_event_types;
@@ -242,6 +251,9 @@ typedef struct vlib_main_t
   /* debugging */
   volatile int parked_at_barrier;
 
+  /* Last RCU epoch this (worker) thread passed a quiescent state in */
+  volatile u64 rcu_quiescent_epoch;
+
   /* Attempt to do a post-mortem elog dump */
   int elog_post_mortem_dump;
 
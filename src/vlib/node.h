@@ -693,6 +693,18 @@ vlib_timing_wheel_data_get_index (u32 d)
   return d / 2;
 }
 
+/* Log2 histograms of clocks per call and vectors per call.
+   Bucket i counts calls with min_log2 (value) == i, the last bucket
+   also takes everything above it. */
+#define VLIB_NODE_HIST_N_CLOCK_BUCKETS 32
+#define VLIB_NODE_HIST_N_VECTOR_BUCKETS 10
+
+typedef struct
+{
+  u64 clocks[VLIB_NODE_HIST_N_CLOCK_BUCKETS];
+  u64 vectors[VLIB_NODE_HIST_N_VECTOR_BUCKETS];
+} vlib_node_histogram_t;
+
 typedef struct
 {
   /* Public nodes. */
@@ -765,6 +777,10 @@ typedef struct
 
   /* Node index from error code */
   u32 *node_by_error;
+
+  /* Per-node dispatch histograms indexed by node index,
+     zero unless enabled with vlib_node_histogram_enable_disable. */
+  vlib_node_histogram_t *histograms;
 } vlib_node_main_t;
 
 typedef u16 vlib_error_t;
@@ -523,6 +523,8 @@ clear_node_runtime (vlib_main_t * vm,
 	}
       /* Note: input/output rates computed using vlib_global_main */
       nm->time_last_runtime_stats_clear = vlib_time_now (vm);
+
+      vec_zero (nm->histograms);
     }
 
   vlib_worker_thread_barrier_release (vm);
@@ -540,6 +542,243 @@ VLIB_CLI_COMMAND (clear_node_runtime_command, static) = {
 };
 /* *INDENT-ON* */
 
+void
+vlib_node_histogram_enable_disable (vlib_main_t * vm, int enable)
+{
+  vlib_node_main_t *nm;
+  int i;
+
+  vlib_worker_thread_barrier_sync (vm);
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      if (vlib_mains[i] == 0)
+	continue;
+      nm = &vlib_mains[i]->node_main;
+      if (enable)
+	{
+	  vec_validate (nm->histograms, vec_len (nm->nodes) - 1);
+	  vec_zero (nm->histograms);
+	}
+      else
+	vec_free (nm->histograms);
+    }
+
+  vlib_worker_thread_barrier_release (vm);
+}
+
+f64
+vlib_node_histogram_percentile (u64 * buckets, u32 n_buckets,
+				f64 percentile)
+{
+  u64 total = 0, sum = 0;
+  f64 target, lo, hi;
+  u32 i;
+
+  for (i = 0; i < n_buckets; i++)
+    total += buckets[i];
+
+  if (total == 0)
+    return 0;
+
+  target = (f64) total * percentile / 100.0;
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      if (buckets[i] && (f64) (sum + buckets[i]) >= target)
+	break;
+      sum += buckets[i];
+    }
+
+  if (i == n_buckets)
+    i = n_buckets - 1;
+
+  /* Bucket i holds values in [2^i, 2^(i+1)), bucket 0 also holds 0 */
+  lo = i ? (f64) (1ULL << i) : 0;
+  hi = (f64) (1ULL << (i + 1));
+
+  return lo + (hi - lo) * (target - sum) / (f64) buckets[i];
+}
+
+static u8 *
+format_vlib_node_histogram_buckets (u8 * s, va_list * args)
+{
+  u64 *buckets = va_arg (*args, u64 *);
+  u32 n_buckets = va_arg (*args, u32);
+  u32 indent = format_get_indent (s);
+  u32 i, n = 0;
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      if (buckets[i] == 0)
+	continue;
+      if (n++)
+	s = format (s, "\n%U", format_white_space, indent);
+      if (i == n_buckets - 1)
+	s = format (s, "%12llu+%11s %llu", 1ULL << i, "", buckets[i]);
+      else
+	s = format (s, "%12llu-%-11llu %llu", i ? 1ULL << i : 0,
+		    (1ULL << (i + 1)) - 1, buckets[i]);
+    }
+  return s;
+}
+
+static clib_error_t *
+show_node_histogram (vlib_main_t * vm,
+		     unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_node_histogram_t **hist_dups = 0, *h;
+  vlib_main_t **stat_vms = 0, *stat_vm;
+  u32 node_index = ~0, thread_index = ~0;
+  vlib_node_t *n;
+  u64 calls;
+  int i, j, b;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "thread %u", &thread_index))
+	;
+      else if (unformat (input, "%U", unformat_vlib_node, vm, &node_index))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (vm->node_main.histograms == 0)
+    return clib_error_return (0, "node histograms are not enabled, "
+			      "use 'set runtime histogram on'");
+
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      stat_vm = vlib_mains[i];
+      if (stat_vm && (thread_index == ~0 || thread_index == i))
+	vec_add1 (stat_vms, stat_vm);
+    }
+
+  vlib_worker_thread_barrier_sync (vm);
+  for (j = 0; j < vec_len (stat_vms); j++)
+    vec_add1 (hist_dups, vec_dup (stat_vms[j]->node_main.histograms));
+  vlib_worker_thread_barrier_release (vm);
+
+  for (j = 0; j < vec_len (stat_vms); j++)
+    {
+      stat_vm = stat_vms[j];
+
+      if (vec_len (vlib_mains) > 1)
+	{
+	  vlib_worker_thread_t *w =
+	    vlib_worker_threads + stat_vm->thread_index;
+	  if (j > 0)
+	    vlib_cli_output (vm, "---------------");
+	  vlib_cli_output (vm, "Thread %d %s", stat_vm->thread_index,
+			   w->name);
+	}
+
+      vlib_cli_output (vm, "%-30s%12s%10s%10s%10s%8s%8s%8s", "Name",
+		       "Calls", "Clk p50", "Clk p90", "Clk p99",
+		       "Vec p50", "Vec p90", "Vec p99");
+
+      vec_foreach (h, hist_dups[j])
+	{
+	  i = h - hist_dups[j];
+	  if (node_index != ~0 && node_index != i)
+	    continue;
+
+	  calls = 0;
+	  for (b = 0; b < VLIB_NODE_HIST_N_VECTOR_BUCKETS; b++)
+	    calls += h->vectors[b];
+	  if (calls == 0 && node_index == ~0)
+	    continue;
+
+	  n = vlib_get_node (stat_vm, i);
+	  vlib_cli_output
+	    (vm, "%-30v%12llu%10.3e%10.3e%10.3e%8.1f%8.1f%8.1f", n->name,
+	     calls,
+	     vlib_node_histogram_percentile
+	     (h->clocks, VLIB_NODE_HIST_N_CLOCK_BUCKETS, 50),
+	     vlib_node_histogram_percentile
+	     (h->clocks, VLIB_NODE_HIST_N_CLOCK_BUCKETS, 90),
+	     vlib_node_histogram_percentile
+	     (h->clocks, VLIB_NODE_HIST_N_CLOCK_BUCKETS, 99),
+	     vlib_node_histogram_percentile
+	     (h->vectors, VLIB_NODE_HIST_N_VECTOR_BUCKETS, 50),
+	     vlib_node_histogram_percentile
+	     (h->vectors, VLIB_NODE_HIST_N_VECTOR_BUCKETS, 90),
+	     vlib_node_histogram_percentile
+	     (h->vectors, VLIB_NODE_HIST_N_VECTOR_BUCKETS, 99));
+
+	  if (node_index != ~0)
+	    {
+	      vlib_cli_output (vm, "  clocks per call:\n    %U",
+			       format_vlib_node_histogram_buckets, h->clocks,
+			       VLIB_NODE_HIST_N_CLOCK_BUCKETS);
+	      vlib_cli_output (vm, "  vectors per call:\n    %U",
+			       format_vlib_node_histogram_buckets, h->vectors,
+			       VLIB_NODE_HIST_N_VECTOR_BUCKETS);
+	    }
+	}
+      vec_free (hist_dups[j]);
+    }
+
+  vec_free (hist_dups);
+  vec_free (stat_vms);
+  return 0;
+}
+
+/*?
+ * Display per-node histograms of clocks per call and vectors per call
+ * with estimated percentiles. Percentiles are interpolated within the
+ * log2 buckets, so they are accurate to within a factor of two.
+ * When a node is given, the raw bucket counts are shown as well.
+ *
+ * @cliexpar
+ * @cliexcmd{show runtime histogram ip4-lookup thread 1}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_node_histogram_command, static) = {
+  .path = "show runtime histogram",
+  .short_help = "show runtime histogram [<node-name>] [thread <n>]",
+  .function = show_node_histogram,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_node_histogram (vlib_main_t * vm,
+		    unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  int enable;
+
+  if (unformat (input, "on") || unformat (input, "enable"))
+    enable = 1;
+  else if (unformat (input, "off") || unformat (input, "disable"))
+    enable = 0;
+  else
+    return clib_error_return (0, "expected on|off");
+
+  vlib_node_histogram_enable_disable (vm, enable);
+  return 0;
+}
+
+/*?
+ * Enable or disable log2 histograms of clocks per call and vectors per
+ * call for every node on every thread. The cost is two counter
+ * increments per node dispatch. Histograms are cleared by
+ * 'clear runtime' and exported in the stats segment under
+ * /sys/node/clocks_histogram and /sys/node/vectors_histogram.
+ *
+ * @cliexpar
+ * @cliexcmd{set runtime histogram on}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_node_histogram_command, static) = {
+  .path = "set runtime histogram",
+  .short_help = "set runtime histogram on|off",
+  .function = set_node_histogram,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 show_node (vlib_main_t * vm, unformat_input_t * input,
 	   vlib_cli_command_t * cmd)
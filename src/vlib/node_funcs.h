@@ -1134,6 +1134,14 @@ void vlib_start_process (vlib_main_t * vm, uword process_index);
 /* Sync up runtime and main node stats. */
 void vlib_node_sync_stats (vlib_main_t * vm, vlib_node_t * n);
 
+/* Enable/disable per-node clocks and vector size histograms on all
+   threads. Enabling clears any previously collected data. */
+void vlib_node_histogram_enable_disable (vlib_main_t * vm, int enable);
+
+/* Estimate a percentile (0-100) from log2 histogram buckets. */
+f64 vlib_node_histogram_percentile (u64 * buckets, u32 n_buckets,
+				    f64 percentile);
+
 /* Node graph initialization function. */
 clib_error_t *vlib_node_main_init (vlib_main_t * vm);
 
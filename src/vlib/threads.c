@@ -36,6 +36,7 @@ vl (void *p)
 
 vlib_worker_thread_t *vlib_worker_threads;
 vlib_thread_main_t vlib_thread_main;
+vlib_rcu_main_t vlib_rcu_main;
 
 /*
  * Barrier tracing can be enabled on a normal build to collect information
@@ -1586,6 +1587,152 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
 }
 
+/*
+ * RCU style publish/quiesce.
+ *
+ * The main thread publishes an update with ordinary (atomic) stores
+ * and then either waits for a grace period with vlib_rcu_synchronize,
+ * or queues the reclamation of the old state with vlib_rcu_call. A
+ * grace period has elapsed once every worker has reported a quiescent
+ * state (see vlib_rcu_quiescent_state) for an epoch at least as new as
+ * the one opened after the update. Workers are never stopped.
+ */
+
+/*
+ * No worker can hold a reference if there are no workers,
+ * or if they are all parked at a barrier we hold.
+ */
+static_always_inline int
+vlib_rcu_all_quiescent (void)
+{
+  return (vec_len (vlib_mains) < 2
+	  || vlib_worker_threads[0].recursion_level > 0);
+}
+
+static u64
+vlib_rcu_min_quiescent_epoch (void)
+{
+  u64 epoch = ~0ULL;
+  int i;
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    epoch = clib_min (epoch,
+		      clib_atomic_load_acq_n
+		      (&vlib_mains[i]->rcu_quiescent_epoch));
+
+  return epoch;
+}
+
+void
+vlib_rcu_synchronize (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  f64 t_entry, now, deadline;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (vlib_rcu_all_quiescent ())
+    return;
+
+  t_entry = now = vlib_time_now (vm);
+  deadline = now + BARRIER_SYNC_TIMEOUT;
+
+  /*
+   * Full memory barrier: any worker which sees the new epoch
+   * also sees everything published before it.
+   */
+  epoch = clib_atomic_add_fetch (&rm->epoch, 1);
+
+  while (vlib_rcu_min_quiescent_epoch () < epoch)
+    {
+      if ((now = vlib_time_now (vm)) > deadline)
+	{
+	  fformat (stderr, "%s: worker thread deadlock\n", __FUNCTION__);
+	  os_panic ();
+	}
+      CLIB_PAUSE ();
+    }
+
+  rm->n_synchronize++;
+  rm->synchronize_time_total += now - t_entry;
+  rm->synchronize_time_max = clib_max (rm->synchronize_time_max,
+				       now - t_entry);
+}
+
+void
+vlib_rcu_call (vlib_rcu_callback_fn_t * fn, void *arg)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_callback_t *cb;
+  void *oldheap;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (vlib_rcu_all_quiescent ())
+    {
+      rm->n_callbacks++;
+      fn (arg);
+      return;
+    }
+
+  /* callers may be running on a private heap */
+  oldheap = clib_mem_set_heap (vlib_global_main.heap_base);
+  vec_add2 (rm->pending, cb, 1);
+  clib_mem_set_heap (oldheap);
+
+  cb->fn = fn;
+  cb->arg = arg;
+  /* the update is already published, the next grace period covers it */
+  cb->epoch = rm->epoch + 1;
+  rm->n_deferred_callbacks++;
+}
+
+/*
+ * Run the deferred callbacks whose grace period has elapsed.
+ * Called from the main thread's main loop while callbacks are pending.
+ */
+void
+vlib_rcu_poll (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_callback_t *cb;
+  u32 n_ready, n_pending;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  n_pending = vec_len (rm->pending);
+  if (0 == n_pending)
+    return;
+
+  if (vlib_rcu_all_quiescent ())
+    n_ready = n_pending;
+  else
+    {
+      /* open the grace period the newest callback is waiting for */
+      if (rm->epoch < rm->pending[n_pending - 1].epoch)
+	clib_atomic_add_fetch (&rm->epoch, 1);
+
+      epoch = vlib_rcu_min_quiescent_epoch ();
+      for (n_ready = 0; n_ready < n_pending; n_ready++)
+	if (rm->pending[n_ready].epoch > epoch)
+	  break;
+    }
+
+  if (0 == n_ready)
+    return;
+
+  /* callbacks may defer more work, so run them from a private vector */
+  vec_add (rm->processing, rm->pending, n_ready);
+  vec_delete (rm->pending, n_ready, 0);
+
+  vec_foreach (cb, rm->processing) cb->fn (cb->arg);
+
+  rm->n_callbacks += vec_len (rm->processing);
+  vec_reset_length (rm->processing);
+}
+
 /*
  * Check the frame queue to see if any frames are available.
  * If so, pull the packets off the frames and put them to
@@ -173,6 +173,38 @@ typedef struct
   uword data;
 } vlib_process_signal_event_mt_args_t;
 
+typedef void (vlib_rcu_callback_fn_t) (void *arg);
+
+typedef struct
+{
+  vlib_rcu_callback_fn_t *fn;
+  void *arg;
+  /* grace period which must elapse before fn can be called */
+  u64 epoch;
+} vlib_rcu_callback_t;
+
+typedef struct
+{
+  /* Grace period counter, written by the main thread only */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u64 epoch;
+
+  /* main thread only from here */
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  /* Deferred callbacks, in epoch order */
+  vlib_rcu_callback_t *pending;
+  vlib_rcu_callback_t *processing;
+
+  /* stats */
+  u64 n_synchronize;
+  u64 n_callbacks;
+  u64 n_deferred_callbacks;
+  f64 synchronize_time_total;
+  f64 synchronize_time_max;
+} vlib_rcu_main_t;
+
+extern vlib_rcu_main_t vlib_rcu_main;
+
 /* Called early, in thread 0's context */
 clib_error_t *vlib_thread_init (vlib_main_t * vm);
 
@@ -209,6 +241,10 @@ void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 void vlib_worker_thread_initial_barrier_sync_and_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 
+void vlib_rcu_synchronize (vlib_main_t * vm);
+void vlib_rcu_call (vlib_rcu_callback_fn_t * fn, void *arg);
+void vlib_rcu_poll (vlib_main_t * vm);
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -497,6 +533,20 @@ vlib_worker_thread_barrier_check (void)
     }
 }
 
+/*
+ * Report a quiescent state: the calling worker holds no references
+ * obtained during its previous main loop iteration. Called once per
+ * iteration, next to the barrier check.
+ */
+static_always_inline void
+vlib_rcu_quiescent_state (vlib_main_t * vm)
+{
+  u64 epoch = clib_atomic_load_acq_n (&vlib_rcu_main.epoch);
+
+  if (PREDICT_FALSE (vm->rcu_quiescent_epoch != epoch))
+    clib_atomic_store_rel_n (&vm->rcu_quiescent_epoch, epoch);
+}
+
 always_inline vlib_main_t *
 vlib_get_worker_vlib_main (u32 worker_index)
 {
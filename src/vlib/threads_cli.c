@@ -92,6 +92,53 @@ VLIB_CLI_COMMAND (show_threads_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_vlib_rcu_fn (vlib_main_t * vm,
+		  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  int i;
+
+  vlib_cli_output (vm, "epoch %llu, %u callbacks pending",
+		   rm->epoch, vec_len (rm->pending));
+  vlib_cli_output (vm, "callbacks: %llu run, %llu deferred",
+		   rm->n_callbacks, rm->n_deferred_callbacks);
+  vlib_cli_output (vm, "synchronize: %llu calls, avg %.2fus, max %.2fus",
+		   rm->n_synchronize,
+		   rm->n_synchronize ?
+		   1e6 * rm->synchronize_time_total / rm->n_synchronize : 0.0,
+		   1e6 * rm->synchronize_time_max);
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    vlib_cli_output (vm, "  %-20s quiescent epoch %llu",
+		     vlib_worker_threads[i].name,
+		     vlib_mains[i]->rcu_quiescent_epoch);
+
+  return 0;
+}
+
+/*?
+ * Display the state of the RCU publish/quiesce facility: the current
+ * grace period epoch, deferred callback counts and, for each worker,
+ * the last epoch in which it reported a quiescent state.
+ *
+ * @cliexpar
+ * @cliexstart{show vlib rcu}
+ * epoch 1042, 0 callbacks pending
+ * callbacks: 3120 run, 3120 deferred
+ * synchronize: 12 calls, avg 4.31us, max 11.02us
+ *   vpp_wk_0             quiescent epoch 1042
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_vlib_rcu_command, static) = {
+  .path = "show vlib rcu",
+  .short_help = "show vlib rcu",
+  .function = show_vlib_rcu_fn,
+  .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
 /*
  * Trigger threads to grab frame queue trace data
  */
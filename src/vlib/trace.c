@@ -37,6 +37,7 @@
  *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <fcntl.h>
 #include <vlib/vlib.h>
 #include <vlib/threads.h>
 
@@ -127,6 +128,10 @@ clear_trace_buffer (void)
       if (! pool_is_free_index (tm->trace_buffer_pool, i))
         vec_free (tm->trace_buffer_pool[i]);
     pool_free (tm->trace_buffer_pool);
+
+    if (tm->samples)
+      clib_memset (tm->samples, 0, vec_bytes (tm->samples));
+    tm->sample_head = 0;
   }));
   /* *INDENT-ON* */
 }
@@ -405,6 +410,13 @@ cli_add_trace_buffer (vlib_main_t * vm,
       goto done;
     }
 
+  if (vm->trace_main.sample_enable)
+    {
+      error = clib_error_create ("sampled trace enabled, disable it with "
+				 "'set interface trace-sample ... off'");
+      goto done;
+    }
+
   if (filter)
     {
       if (vlib_enable_disable_pkt_trace_filter (1 /* enable */ ))
@@ -554,6 +566,225 @@ VLIB_CLI_COMMAND (clear_trace_cli,static) = {
 };
 /* *INDENT-ON* */
 
+/**
+ * Enable or disable sampling of 1 in interval packets received on
+ * sw_if_index. Sampled packets leave a compact record in each node
+ * they pass, see "show trace sample".
+ */
+int
+vlib_trace_sample_enable_disable (u32 sw_if_index, u32 interval)
+{
+  vlib_trace_main_t *tm;
+  u32 i;
+
+  /* full trace and sampling share the buffer trace handle */
+  if (interval && vlib_get_main ()->trace_main.trace_enable)
+    return -1;
+
+  if (vnet_trace_dummy == 0)
+    vec_validate_aligned (vnet_trace_dummy, 2048, CLIB_CACHE_LINE_BYTES);
+
+  /* *INDENT-OFF* */
+  foreach_vlib_main ((
+    {
+      tm = &this_vlib_main->trace_main;
+      vec_validate (tm->sample_interval_by_sw_if_index, sw_if_index);
+      vec_validate (tm->sample_countdown_by_sw_if_index, sw_if_index);
+      tm->sample_interval_by_sw_if_index[sw_if_index] = interval;
+      tm->sample_countdown_by_sw_if_index[sw_if_index] = interval;
+
+      if (interval && tm->samples == 0)
+	vec_validate_aligned (tm->samples,
+			      VLIB_TRACE_SAMPLE_DEFAULT_RING_SIZE - 1,
+			      CLIB_CACHE_LINE_BYTES);
+
+      tm->sample_enable = 0;
+      vec_foreach_index (i, tm->sample_interval_by_sw_if_index)
+	if (tm->sample_interval_by_sw_if_index[i])
+	  tm->sample_enable = 1;
+    }));
+  /* *INDENT-ON* */
+
+  return 0;
+}
+
+static int
+trace_sample_cmp (void *a1, void *a2)
+{
+  vlib_trace_sample_t *s1 = a1;
+  vlib_trace_sample_t *s2 = a2;
+
+  if (s1->sample != s2->sample)
+    return s1->sample < s2->sample ? -1 : 1;
+  if (s1->time != s2->time)
+    return s1->time < s2->time ? -1 : 1;
+  return 0;
+}
+
+/* Records of all threads, sorted by sample and time */
+static vlib_trace_sample_t *
+trace_sample_collect (void)
+{
+  vlib_trace_sample_t *samples = 0, *s;
+
+  /* *INDENT-OFF* */
+  foreach_vlib_main ((
+    {
+      vec_foreach (s, this_vlib_main->trace_main.samples)
+	if (s->time)
+	  vec_add1 (samples, s[0]);
+    }));
+  /* *INDENT-ON* */
+
+  vec_sort_with_function (samples, trace_sample_cmp);
+  return samples;
+}
+
+typedef struct
+{
+  u64 n_hops;
+  u64 sum_clocks;
+  u64 max_clocks;
+} trace_sample_node_stats_t;
+
+/* Dump file: header, node names as <u32 length><bytes>, records */
+typedef struct
+{
+  u8 magic[4];
+  u32 version;
+  u32 n_nodes;
+  u32 n_records;
+  f64 clocks_per_second;
+} trace_sample_file_header_t;
+
+static clib_error_t *
+trace_sample_dump (vlib_main_t * vm, char *file_name,
+		   vlib_trace_sample_t * samples)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  trace_sample_file_header_t *h;
+  clib_error_t *error = 0;
+  u8 *d = 0;
+  u32 i, len;
+  int fd;
+
+  vec_validate (d, sizeof (*h) - 1);
+  h = (trace_sample_file_header_t *) d;
+  clib_memcpy_fast (h->magic, "VTSP", sizeof (h->magic));
+  h->version = 1;
+  h->n_nodes = vec_len (nm->nodes);
+  h->n_records = vec_len (samples);
+  h->clocks_per_second = vm->clib_time.clocks_per_second;
+
+  for (i = 0; i < vec_len (nm->nodes); i++)
+    {
+      len = vec_len (nm->nodes[i]->name);
+      vec_add (d, (u8 *) & len, sizeof (len));
+      vec_append (d, nm->nodes[i]->name);
+    }
+
+  vec_add (d, (u8 *) samples, vec_bytes (samples));
+
+  fd = open (file_name, O_CREAT | O_TRUNC | O_WRONLY, 0664);
+  if (fd < 0)
+    {
+      error = clib_error_return_unix (0, "failed to open `%s'", file_name);
+      goto done;
+    }
+
+  if (write (fd, d, vec_len (d)) != vec_len (d))
+    error = clib_error_return_unix (0, "write `%s'", file_name);
+
+  close (fd);
+
+done:
+  vec_free (d);
+  return error;
+}
+
+static clib_error_t *
+cli_show_trace_sample (vlib_main_t * vm,
+		       unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  trace_sample_node_stats_t *stats = 0, *st;
+  vlib_trace_sample_t *samples, *s;
+  clib_error_t *error = 0;
+  u64 n_paths = 0, path_clocks = 0;
+  u8 *file_name = 0;
+  u32 i;
+
+  while (unformat_check_input (input) != (uword) UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "dump %U", unformat_vlib_tmpfile, &file_name))
+	;
+      else
+	return clib_error_create ("expected 'dump FILE', got `%U'",
+				  format_unformat_error, input);
+    }
+
+  samples = trace_sample_collect ();
+
+  if (file_name)
+    {
+      error = trace_sample_dump (vm, (char *) file_name, samples);
+      if (error == 0)
+	vlib_cli_output (vm, "Wrote %u records to %s", vec_len (samples),
+			 file_name);
+      goto done;
+    }
+
+  /* time between consecutive records of a sample is charged to the
+     node of the earlier record */
+  vec_validate (stats, vec_len (vm->node_main.nodes) - 1);
+  for (i = 0; i < vec_len (samples); i++)
+    {
+      u64 delta;
+
+      s = samples + i;
+      if (i + 1 == vec_len (samples) || s[1].sample != s[0].sample)
+	continue;
+
+      delta = s[1].time - s[0].time;
+      st = stats + s->node_index;
+      st->n_hops++;
+      st->sum_clocks += delta;
+      st->max_clocks = clib_max (st->max_clocks, delta);
+
+      path_clocks += delta;
+      if (i == 0 || s[-1].sample != s[0].sample)
+	n_paths++;
+    }
+
+  vlib_cli_output (vm, "%u records, %llu sampled paths, avg path %.2f "
+		   "clocks", vec_len (samples), n_paths,
+		   n_paths ? (f64) path_clocks / n_paths : 0);
+  vlib_cli_output (vm, "%-40s%12s%16s%16s", "Node", "Samples",
+		   "Avg Clocks", "Max Clocks");
+
+  vec_foreach (st, stats)
+  {
+    if (st->n_hops == 0)
+      continue;
+    vlib_cli_output (vm, "%-40U%12llu%16.2f%16llu", format_vlib_node_name,
+		     vm, st - stats, st->n_hops,
+		     (f64) st->sum_clocks / st->n_hops, st->max_clocks);
+  }
+
+done:
+  vec_free (samples);
+  vec_free (stats);
+  vec_free (file_name);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_trace_sample_cli,static) = {
+  .path = "show trace sample",
+  .short_help = "show trace sample [dump FILE]",
+  .function = cli_show_trace_sample,
+};
+/* *INDENT-ON* */
+
 /* Dummy function to get us linked in. */
 void
 vlib_trace_cli_reference (void)
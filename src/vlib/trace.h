@@ -57,6 +57,28 @@ typedef struct
   u8 data[0];
 } vlib_trace_header_t;
 
+/* Sampled trace record. One per node a sampled packet passes through,
+   consecutive records of the same sample give per-node cycles. */
+typedef struct
+{
+  /* CPU time stamp of the node dispatch. */
+  u64 time;
+
+  /* Sample id, trace handle of the buffer
+     (thread << 24 | VLIB_TRACE_SAMPLE_HANDLE_BIT | sequence). */
+  u32 sample;
+
+  /* Node which generated this record. */
+  u32 node_index;
+} vlib_trace_sample_t;
+
+#define VLIB_TRACE_SAMPLE_DEFAULT_RING_SIZE (64 << 10)
+
+/* Set in the trace index of sampled buffers, full trace pool indices
+   stay below it. Keeps a buffer sampled before sampling was turned off
+   from being taken for one with a full trace. */
+#define VLIB_TRACE_SAMPLE_HANDLE_BIT (1 << 23)
+
 typedef struct
 {
   /* Current number of traces in buffer. */
@@ -108,10 +130,26 @@ typedef struct
   /* a callback to enable customized addition of a new trace */
   vlib_add_trace_callback_t *add_trace_callback;
 
+  /* sampled trace: set when any interface is sampled */
+  u32 sample_enable;
+
+  /* next sample sequence number */
+  u32 sample_sequence;
+
+  /* per rx interface sampling interval (0 = off) and countdown */
+  u32 *sample_interval_by_sw_if_index;
+  u32 *sample_countdown_by_sw_if_index;
+
+  /* ring of sample records, power of 2 sized, oldest overwritten */
+  vlib_trace_sample_t *samples;
+  u32 sample_head;
+
 } vlib_trace_main_t;
 
 format_function_t format_vlib_trace;
 
+int vlib_trace_sample_enable_disable (u32 sw_if_index, u32 interval);
+
 #endif /* included_vlib_trace_h */
 
 /*
@@ -51,6 +51,49 @@ vlib_validate_trace (vlib_trace_main_t * tm, vlib_buffer_t * b)
 
 void vlib_add_handoff_trace (vlib_main_t * vm, vlib_buffer_t * b);
 
+/* Sampled trace: only node and time are recorded, node trace data
+   goes to the dummy buffer */
+always_inline void *
+vlib_add_trace_sample (vlib_main_t * vm, vlib_node_runtime_t * r,
+		       vlib_buffer_t * b, u32 n_data_bytes)
+{
+  vlib_trace_main_t *tm = &vm->trace_main;
+  vlib_trace_sample_t *s;
+
+  s = tm->samples + (tm->sample_head++ & (vec_len (tm->samples) - 1));
+  s->time = vm->cpu_time_last_node_dispatch;
+  s->sample = b->trace_handle;
+  s->node_index = r->node_index;
+
+  ASSERT (vec_len (vnet_trace_dummy) >= n_data_bytes);
+  return vnet_trace_dummy;
+}
+
+/* Mark every n-th buffer received on sw_if_index as sampled. Marks the
+   node as traced so the flag propagates to the next frames. */
+always_inline void
+vlib_trace_sample_buffer (vlib_main_t * vm, vlib_node_runtime_t * r,
+			  vlib_buffer_t * b, u32 sw_if_index)
+{
+  vlib_trace_main_t *tm = &vm->trace_main;
+  u32 *countdown;
+
+  if (sw_if_index >= vec_len (tm->sample_interval_by_sw_if_index) ||
+      tm->sample_interval_by_sw_if_index[sw_if_index] == 0)
+    return;
+
+  countdown = tm->sample_countdown_by_sw_if_index + sw_if_index;
+  if (PREDICT_TRUE (--countdown[0] != 0))
+    return;
+
+  countdown[0] = tm->sample_interval_by_sw_if_index[sw_if_index];
+  b->flags |= VLIB_BUFFER_IS_TRACED;
+  b->trace_handle = vlib_buffer_make_trace_handle
+    (vm->thread_index, VLIB_TRACE_SAMPLE_HANDLE_BIT |
+     (tm->sample_sequence++ & (VLIB_TRACE_SAMPLE_HANDLE_BIT - 1)));
+  r->flags |= VLIB_NODE_FLAG_TRACE;
+}
+
 always_inline void *
 vlib_add_trace (vlib_main_t * vm,
 		vlib_node_runtime_t * r, vlib_buffer_t * b, u32 n_data_bytes)
@@ -64,6 +107,17 @@ vlib_add_trace (vlib_main_t * vm,
   if (PREDICT_FALSE ((b->flags & VLIB_BUFFER_IS_TRACED) == 0))
     return vnet_trace_dummy;
 
+  if (PREDICT_FALSE (tm->sample_enable))
+    return vlib_add_trace_sample (vm, r, b, n_data_bytes);
+
+  /* Sampled before sampling was disabled, there is no trace to add to */
+  if (PREDICT_FALSE (vlib_buffer_get_trace_index (b) &
+		     VLIB_TRACE_SAMPLE_HANDLE_BIT))
+    {
+      b->flags &= ~VLIB_BUFFER_IS_TRACED;
+      return vnet_trace_dummy;
+    }
+
   if (PREDICT_FALSE (tm->add_trace_callback != 0))
     {
       return tm->add_trace_callback ((struct vlib_main_t *) vm,
@@ -164,6 +218,12 @@ vlib_trace_buffer (vlib_main_t * vm,
   vlib_trace_next_frame (vm, r, next_index);
 
   pool_get (tm->trace_buffer_pool, h);
+  if (PREDICT_FALSE (h - tm->trace_buffer_pool >=
+		     VLIB_TRACE_SAMPLE_HANDLE_BIT))
+    {
+      pool_put (tm->trace_buffer_pool, h);
+      return;
+    }
 
   do
     {
@@ -57,6 +57,9 @@ typedef struct vl_api_registration_
   int last_queue_head;
   int unanswered_pings;
 
+  /** Replies are being collected into a msg_batch reply */
+  u8 batch_capture;
+
   /** shared memory only: pointer to client input queue */
   svm_queue_t *vl_input_queue;
   svm_region_t *vlib_rp;
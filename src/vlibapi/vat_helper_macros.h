@@ -54,7 +54,7 @@ do {                                                            \
     socket_client_main_t *scm = vam->socket_client_main;	\
     vam->result_ready = 0;                                      \
     if (scm && scm->socket_enable)                                     \
-      mp = vl_socket_client_msg_alloc (sizeof(*mp));		\
+      mp = vl_socket_client_msg_alloc (sizeof(*mp) + n);	\
     else                                                        \
       mp = vl_msg_api_alloc_as_if_client(sizeof(*mp) + n);      \
     clib_memset (mp, 0, sizeof (*mp));                               \
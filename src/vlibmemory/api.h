@@ -30,10 +30,15 @@ void vl_api_force_rpc_call_main_thread (void *fp, u8 * data, u32 data_length);
 u16 vl_client_get_first_plugin_msg_id (const char *plugin_name);
 void vl_api_send_pending_rpc_requests (vlib_main_t * vm);
 u8 *vl_api_serialize_message_table (api_main_t * am, u8 * vector);
+int vl_api_batch_capture_reply (vl_api_registration_t * rp, u8 * elem);
 
 always_inline void
 vl_api_send_msg (vl_api_registration_t * rp, u8 * elem)
 {
+  if (PREDICT_FALSE (rp->batch_capture)
+      && vl_api_batch_capture_reply (rp, elem))
+    return;
+
   if (PREDICT_FALSE (rp->registration_type > REGISTRATION_TYPE_SHMEM))
     {
       vl_socket_api_send (rp, elem);
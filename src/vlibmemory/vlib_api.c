@@ -142,9 +142,255 @@ vl_api_api_versions_t_handler (vl_api_api_versions_t * mp)
   vl_api_send_msg (reg, (u8 *) rmp);
 }
 
+/*
+ * Message batches. Each message in a batch is dispatched to its handler
+ * as if it had been received on its own, but the batch takes the worker
+ * barrier (if needed at all) once, and the replies to the messages are
+ * folded into a single msg_batch_reply.
+ */
+
+/* Upper bound on the number of messages in one batch */
+#define VL_API_MSG_BATCH_MAX 65536
+
+/* Common header of request and reply messages */
+/* *INDENT-OFF* */
+typedef CLIB_PACKED (struct
+{
+  u16 _vl_msg_id;
+  u32 client_index;
+  u32 context;
+}) vl_api_batch_msg_hdr_t;
+
+typedef CLIB_PACKED (struct
+{
+  u16 _vl_msg_id;
+  u32 context;
+  i32 retval;
+}) vl_api_batch_reply_hdr_t;
+/* *INDENT-ON* */
+
+typedef struct
+{
+  /* Context of the message being dispatched, network byte order */
+  u32 context;
+
+  /* Retval of its reply, network byte order */
+  i32 retval;
+
+  u8 replied;
+} vl_api_batch_state_t;
+
+static vl_api_batch_state_t vl_api_batch_state;
+
+static int
+vl_api_batch_msg_name_ends_with (api_main_t * am, u16 id, const char *sfx)
+{
+  const char *name;
+  uword len, sfx_len = strlen (sfx);
+
+  if (id >= vec_len (am->msg_names) || am->msg_names[id] == 0)
+    return 0;
+
+  name = am->msg_names[id];
+  len = strlen (name);
+
+  return (len > sfx_len && !strcmp (name + len - sfx_len, sfx));
+}
+
+static int
+vl_api_batch_msg_is_reply (api_main_t * am, u16 id)
+{
+  return vl_api_batch_msg_name_ends_with (am, id, "_reply");
+}
+
+/*
+ * Called from vl_api_send_msg while a batch is being dispatched for the
+ * registration. Swallows the reply to the message being dispatched and
+ * records its retval; anything else goes out as usual.
+ */
+int
+vl_api_batch_capture_reply (vl_api_registration_t * rp, u8 * elem)
+{
+  vl_api_batch_state_t *bs = &vl_api_batch_state;
+  vl_api_batch_reply_hdr_t *rmp = (vl_api_batch_reply_hdr_t *) elem;
+  api_main_t *am = vlibapi_get_main ();
+
+  if (bs->replied || rmp->context != bs->context)
+    return 0;
+
+  if (!vl_api_batch_msg_is_reply (am, clib_net_to_host_u16 (rmp->_vl_msg_id)))
+    return 0;
+
+  bs->retval = rmp->retval;
+  bs->replied = 1;
+  vl_msg_api_free (elem);
+
+  return 1;
+}
+
+static int
+vl_api_batch_msg_is_batchable (api_main_t * am, u16 id)
+{
+  if (id >= vec_len (am->msg_handlers) || am->msg_handlers[id] == 0)
+    return 0;
+
+  /* Nor batches of batches, nor anything that changes the registration */
+  switch (id)
+    {
+    case VL_API_MSG_BATCH:
+    case VL_API_MEMCLNT_CREATE:
+    case VL_API_MEMCLNT_DELETE:
+    case VL_API_SOCKCLNT_CREATE:
+    case VL_API_SOCKCLNT_DELETE:
+    case VL_API_SOCK_INIT_SHM:
+      return 0;
+    default:
+      break;
+    }
+
+  return 1;
+}
+
+static void
+vl_api_msg_batch_t_handler (vl_api_msg_batch_t * mp)
+{
+  api_main_t *am = vlibapi_get_main ();
+  vl_api_batch_state_t *bs = &vl_api_batch_state;
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_node_runtime_t *node;
+  vl_api_msg_batch_reply_t *rmp;
+  vl_api_batch_msg_hdr_t *hdr;
+  vl_api_registration_t *reg;
+  u8 *(*handler) (void *, void *, void *);
+  u32 n_msgs, data_len, msg_len, offset, len, i, n_processed = 0;
+  int is_mp_safe = 1;
+  int rv = 0;
+  void *msg;
+  u16 id;
+
+  reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!reg)
+    return;
+
+  n_msgs = clib_net_to_host_u32 (mp->n_msgs);
+  data_len = clib_net_to_host_u32 (mp->data_len);
+  msg_len = vl_msg_api_get_msg_length (mp);
+
+  if (n_msgs > VL_API_MSG_BATCH_MAX || msg_len < sizeof (*mp)
+      || data_len > msg_len - sizeof (*mp))
+    {
+      n_msgs = 0;
+      rv = -7;			/* VNET_API_ERROR_INVALID_VALUE */
+      goto out;
+    }
+
+  /* Validate the framing before anything gets dispatched */
+  for (i = 0, offset = 0; i < n_msgs; i++)
+    {
+      if (data_len - offset < sizeof (u32))
+	break;
+      len = clib_net_to_host_u32 (*(u32 *) (mp->data + offset));
+      offset += sizeof (u32);
+      if (len < sizeof (*hdr) || len > data_len - offset)
+	break;
+
+      hdr = (vl_api_batch_msg_hdr_t *) (mp->data + offset);
+      id = clib_net_to_host_u16 (hdr->_vl_msg_id);
+      if (!vl_api_batch_msg_is_batchable (am, id)
+	  || len < am->api_trace_cfg[id].size)
+	break;
+
+      is_mp_safe &= am->is_mp_safe[id];
+      offset += len;
+    }
+
+  if (i < n_msgs)
+    {
+      n_msgs = 0;
+      rv = -7;			/* VNET_API_ERROR_INVALID_VALUE */
+      goto out;
+    }
+
+  if (!is_mp_safe)
+    {
+      vl_msg_api_barrier_trace_context ("msg_batch");
+      vl_msg_api_barrier_sync ();
+    }
+
+  node = vlib_node_get_runtime (vm, vl_api_clnt_node.index);
+  reg->batch_capture = 1;
+
+  rmp = vl_msg_api_alloc (sizeof (*rmp) + n_msgs * sizeof (rmp->retvals[0]));
+  clib_memset (rmp, 0, sizeof (*rmp) + n_msgs * sizeof (rmp->retvals[0]));
+
+  for (i = 0, offset = 0; i < n_msgs; i++)
+    {
+      len = clib_net_to_host_u32 (*(u32 *) (mp->data + offset));
+      offset += sizeof (u32);
+
+      /* Handlers expect a message buffer of their own */
+      msg = vl_msg_api_alloc (len);
+      clib_memcpy_fast (msg, mp->data + offset, len);
+      offset += len;
+
+      hdr = msg;
+      hdr->client_index = mp->client_index;
+      id = clib_net_to_host_u16 (hdr->_vl_msg_id);
+
+      bs->context = hdr->context;
+      bs->retval = 0;
+      bs->replied = 0;
+
+      handler = (void *) am->msg_handlers[id];
+      (*handler) (msg, vm, node);
+
+      /* Dumps answer with details only. Anything else which has not
+         replied yet does so later, from outside the batch, which the
+         batch cannot report on */
+      if (!bs->replied && !vl_api_batch_msg_name_ends_with (am, id, "_dump"))
+	/* VNET_API_ERROR_UNSUPPORTED */
+	bs->retval = clib_host_to_net_u32 (-126);
+
+      if (!am->message_bounce[id])
+	vl_msg_api_free (msg);
+
+      rmp->retvals[i] = bs->retval;
+      n_processed++;
+
+      if (bs->retval != 0)
+	{
+	  if (rv == 0)
+	    rv = clib_net_to_host_u32 (bs->retval);
+	  if (mp->stop_on_error)
+	    break;
+	}
+    }
+
+  reg->batch_capture = 0;
+
+  if (!is_mp_safe)
+    vl_msg_api_barrier_release ();
+
+  goto send;
+
+out:
+  rmp = vl_msg_api_alloc (sizeof (*rmp));
+  clib_memset (rmp, 0, sizeof (*rmp));
+
+send:
+  rmp->_vl_msg_id = ntohs (VL_API_MSG_BATCH_REPLY);
+  rmp->context = mp->context;
+  rmp->retval = ntohl (rv);
+  rmp->n_processed = htonl (n_processed);
+  /* Only the messages dispatched have a retval */
+  rmp->n_msgs = htonl (n_processed);
+  vl_api_send_msg (reg, (u8 *) rmp);
+}
+
 #define foreach_vlib_api_msg				\
 _(GET_FIRST_MSG_ID, get_first_msg_id)			\
-_(API_VERSIONS, api_versions)
+_(API_VERSIONS, api_versions)				\
+_(MSG_BATCH, msg_batch)
 
 /*
  * vl_api_init
@@ -173,6 +419,9 @@ vlib_api_init (void)
   foreach_vlib_api_msg;
 #undef _
 
+  /* Takes the barrier itself, if anything in the batch needs it */
+  vlibapi_get_main ()->is_mp_safe[VL_API_MSG_BATCH] = 1;
+
   return 0;
 }
 
@@ -62,7 +62,32 @@ adj_poison (ip_adjacency_t * adj)
 ip_adjacency_t *
 adj_alloc (fib_protocol_t proto)
 {
+    vlib_main_t *vm = vlib_get_main();
     ip_adjacency_t *adj;
+    u8 need_barrier_sync = 0;
+
+    ASSERT (vm->thread_index == 0);
+
+    /*
+     * the workers index the pool and the counters directly, so they can
+     * only move while none of them are looking.
+     */
+    pool_get_aligned_will_expand (adj_pool, need_barrier_sync,
+                                  CLIB_CACHE_LINE_BYTES);
+    if (!need_barrier_sync)
+    {
+        pool_header_t *ph = pool_header(adj_pool);
+        adj_index_t ai = vec_len(adj_pool);
+
+        /* pool_get hands out the most recently freed index first */
+        if (vec_len(ph->free_indices))
+            ai = ph->free_indices[vec_len(ph->free_indices) - 1];
+        need_barrier_sync =
+            vlib_validate_combined_counter_will_expand(&adjacency_counters,
+                                                       ai);
+    }
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync (vm);
 
     pool_get_aligned(adj_pool, adj, CLIB_CACHE_LINE_BYTES);
 
@@ -74,6 +99,10 @@ adj_alloc (fib_protocol_t proto)
                                    adj_get_index(adj));
     vlib_zero_combined_counter(&adjacency_counters,
                                adj_get_index(adj));
+
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release (vm);
+
     fib_node_init(&adj->ia_node,
                   FIB_NODE_TYPE_ADJ);
 
@@ -229,6 +258,27 @@ adj_recursive_loop_detect (adj_index_t ai,
     return (0);
 }
 
+/*
+ * adj_free
+ *
+ * called once packets in flight can no longer be using the adj.
+ */
+static void
+adj_free (void *arg)
+{
+    ip_adjacency_t *adj;
+
+    adj = adj_get(pointer_to_uword(arg));
+
+    if (IP_LOOKUP_NEXT_MIDCHAIN == adj->lookup_next_index)
+        dpo_reset(&adj->sub_type.midchain.next_dpo);
+
+    fib_node_deinit(&adj->ia_node);
+    ASSERT(0 == vec_len(adj->ia_delegates));
+    vec_free(adj->ia_delegates);
+    pool_put(adj_pool, adj);
+}
+
 /*
  * adj_last_lock_gone
  *
@@ -237,20 +287,21 @@ adj_recursive_loop_detect (adj_index_t ai,
 static void
 adj_last_lock_gone (ip_adjacency_t *adj)
 {
-    vlib_main_t * vm = vlib_get_main();
-
     ASSERT(0 == fib_node_list_get_size(adj->ia_node.fn_children));
     ADJ_DBG(adj, "last-lock-gone");
 
     adj_delegate_adj_deleted(adj);
 
-    vlib_worker_thread_barrier_sync (vm);
-
+    /*
+     * Remove the adj from the DBs so the control plane can no longer find
+     * it. The data-plane does not use these DBs (or reads them via a
+     * bihash), so the workers need not be stopped. Packets in flight
+     * may still be switched through the adj, so it is freed only once
+     * they are done.
+     */
     switch (adj->lookup_next_index)
     {
     case IP_LOOKUP_NEXT_MIDCHAIN:
-        dpo_reset(&adj->sub_type.midchain.next_dpo);
-        /* FALL THROUGH */
     case IP_LOOKUP_NEXT_ARP:
     case IP_LOOKUP_NEXT_REWRITE:
     case IP_LOOKUP_NEXT_BCAST:
@@ -283,12 +334,7 @@ adj_last_lock_gone (ip_adjacency_t *adj)
 	break;
     }
 
-    vlib_worker_thread_barrier_release(vm);
-
-    fib_node_deinit(&adj->ia_node);
-    ASSERT(0 == vec_len(adj->ia_delegates));
-    vec_free(adj->ia_delegates);
-    pool_put(adj_pool, adj);
+    vlib_rcu_call(adj_free, uword_to_pointer(adj_get_index(adj), void *));
 }
 
 u32
@@ -332,6 +332,57 @@ adj_nbr_update_rewrite (adj_index_t adj_index,
     }
 }
 
+/**
+ * Does the update leave everything the data-plane reads from the adj as is
+ */
+static int
+adj_nbr_rewrite_is_unchanged (const ip_adjacency_t *adj,
+                              ip_lookup_next_t adj_next_index,
+                              u32 this_node,
+                              u32 next_index,
+                              const u8 *rewrite)
+{
+    if (adj->lookup_next_index != adj_next_index ||
+        adj->ia_node_index != this_node ||
+        adj->rewrite_header.next_index != next_index ||
+        adj->rewrite_header.data_bytes != vec_len(rewrite))
+        return (0);
+
+    return (0 == vec_len(rewrite) ||
+            0 == memcmp(adj->rewrite_header.data, rewrite,
+                        vec_len(rewrite)));
+}
+
+static void
+adj_nbr_rewrite_apply (ip_adjacency_t *adj,
+                       ip_lookup_next_t adj_next_index,
+                       u32 this_node,
+                       u32 next_index,
+                       u8 *rewrite)
+{
+    adj->lookup_next_index = adj_next_index;
+    adj->ia_node_index = this_node;
+
+    if (NULL != rewrite)
+    {
+	/*
+	 * new rewrite provided.
+	 * fill in the adj's rewrite string.
+	 */
+	vnet_rewrite_set_data_internal(&adj->rewrite_header,
+				       sizeof(adj->rewrite_data),
+				       rewrite,
+				       vec_len(rewrite));
+	vec_free(rewrite);
+    }
+    else
+    {
+	vnet_rewrite_clear_data_internal(&adj->rewrite_header,
+					 sizeof(adj->rewrite_data));
+    }
+    adj->rewrite_header.next_index = next_index;
+}
+
 /**
  * adj_nbr_update_rewrite_internal
  *
@@ -349,7 +400,7 @@ adj_nbr_update_rewrite_internal (ip_adjacency_t *adj,
     ip_adjacency_t *walk_adj;
     adj_index_t walk_ai, ai;
     vlib_main_t * vm;
-    u32 old_next;
+    u32 old_next, next_index;
     int do_walk;
 
     vm = vlib_get_main();
@@ -455,42 +506,64 @@ adj_nbr_update_rewrite_internal (ip_adjacency_t *adj,
     }
 
     /*
-     * If we are just updating the MAC string of the adj (which we also can't
-     * do atomically), then we need to stop packets switching through the adj.
-     * We can't do that on a per-adj basis, so it's all the packets.
-     * If we are updating the type, and we walked back to the children above,
-     * then this barrier serves to flush the queues/frames.
+     * Build the VLIB graph arc first. Adding a new arc stops the workers
+     * itself, the rest of the update may not need to.
      */
-    vlib_worker_thread_barrier_sync(vm);
-
-    adj->lookup_next_index = adj_next_index;
-    adj->ia_node_index = this_node;
+    next_index = vlib_node_add_next(vm, this_node, next_node);
 
-    if (NULL != rewrite)
+    if (adj_nbr_rewrite_is_unchanged(adj, adj_next_index, this_node,
+                                     next_index, rewrite))
     {
-	/*
-	 * new rewrite provided.
-	 * fill in the adj's rewrite string, and build the VLIB graph arc.
-	 */
-	vnet_rewrite_set_data_internal(&adj->rewrite_header,
-				       sizeof(adj->rewrite_data),
-				       rewrite,
-				       vec_len(rewrite));
-	vec_free(rewrite);
+        /*
+         * e.g. a neighbour refresh with the same MAC. Nothing the
+         * data-plane sees changes, so there is nothing to synchronise.
+         */
+        vec_free(rewrite);
     }
-    else
+    else if (do_walk &&
+             old_next != adj_next_index &&
+             ai == walk_ai)
     {
-	vnet_rewrite_clear_data_internal(&adj->rewrite_header,
-					 sizeof(adj->rewrite_data));
+        if (IP_LOOKUP_NEXT_REWRITE == old_next)
+        {
+            /*
+             * A complete adj is becoming incomplete. The walk above
+             * restacked its children, so no new packets are switched
+             * through it, but those already on their way to the rewrite
+             * node may still read the rewrite string. Wait for them to
+             * clear the workers before it is replaced.
+             */
+            vlib_rcu_synchronize(vm);
+        }
+        /*
+         * else an incomplete adj is being completed. The ARP/ND nodes do
+         * not read the rewrite string, and no packet reaches the rewrite
+         * node before the walk below restacks the children on it, so the
+         * update need only be visible before that walk.
+         */
+        adj_nbr_rewrite_apply(adj, adj_next_index, this_node,
+                              next_index, rewrite);
+        CLIB_MEMORY_STORE_BARRIER();
     }
-    adj->rewrite_header.next_index = vlib_node_add_next(vlib_get_main(),
-                                                        this_node,
-                                                        next_node);
+    else
+    {
+        /*
+         * If we are just updating the MAC string of the adj (which we also
+         * can't do atomically), then we need to stop packets switching
+         * through the adj. We can't do that on a per-adj basis, so it's all
+         * the packets. The same goes for an MPLS adj, whose data-plane
+         * children were not walked.
+         */
+        vlib_worker_thread_barrier_sync(vm);
 
-    /*
-     * done with the rewrite update - let the workers loose.
-     */
-    vlib_worker_thread_barrier_release(vm);
+        adj_nbr_rewrite_apply(adj, adj_next_index, this_node,
+                              next_index, rewrite);
+
+        /*
+         * done with the rewrite update - let the workers loose.
+         */
+        vlib_worker_thread_barrier_release(vm);
+    }
 
     if (do_walk &&
         (old_next != adj->lookup_next_index) &&
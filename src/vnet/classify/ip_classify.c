@@ -127,11 +127,13 @@ ip_classify_inline (vlib_main_t * vm,
 
       t1 = pool_elt_at_index (vcm->tables, table_index1);
 
-      vnet_buffer (b0)->l2_classify.hash = vnet_classify_hash_packet (t0, h0);
+      vnet_buffer (b0)->l2_classify.hash =
+	vnet_classify_hash_packet_inline (t0, h0);
 
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
 
-      vnet_buffer (b1)->l2_classify.hash = vnet_classify_hash_packet (t1, h1);
+      vnet_buffer (b1)->l2_classify.hash =
+	vnet_classify_hash_packet_inline (t1, h1);
 
       vnet_classify_prefetch_bucket (t1, vnet_buffer (b1)->l2_classify.hash);
 
@@ -162,7 +164,8 @@ ip_classify_inline (vlib_main_t * vm,
       table_index0 = cd0->cd_table_index;
 
       t0 = pool_elt_at_index (vcm->tables, table_index0);
-      vnet_buffer (b0)->l2_classify.hash = vnet_classify_hash_packet (t0, h0);
+      vnet_buffer (b0)->l2_classify.hash =
+	vnet_classify_hash_packet_inline (t0, h0);
 
       vnet_buffer (b0)->l2_classify.table_index = table_index0;
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
@@ -231,7 +234,7 @@ ip_classify_inline (vlib_main_t * vm,
 	      hash0 = vnet_buffer (b0)->l2_classify.hash;
 	      t0 = pool_elt_at_index (vcm->tables, table_index0);
 
-	      e0 = vnet_classify_find_entry (t0, h0, hash0, now);
+	      e0 = vnet_classify_find_entry_inline (t0, h0, hash0, now);
 	      if (e0)
 		{
 		  vnet_buffer (b0)->l2_classify.opaque_index
@@ -243,32 +246,23 @@ ip_classify_inline (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
+		  e0 = vnet_classify_find_chain_entry_inline (vcm, &t0, h0,
+							      hash0, now);
+		  if (e0)
 		    {
-		      if (t0->next_table_index != ~0)
-			t0 = pool_elt_at_index (vcm->tables,
-						t0->next_table_index);
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, h0);
-		      e0 = vnet_classify_find_entry (t0, h0, hash0, now);
-		      if (e0)
-			{
-			  vnet_buffer (b0)->l2_classify.opaque_index
-			    = e0->opaque_index;
-			  vlib_buffer_advance (b0, e0->advance);
-			  next0 = (e0->next_index < node->n_next_nodes) ?
-			    e0->next_index : next0;
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
+		      vnet_buffer (b0)->l2_classify.opaque_index
+			= e0->opaque_index;
+		      vlib_buffer_advance (b0, e0->advance);
+		      next0 = (e0->next_index < node->n_next_nodes) ?
+			e0->next_index : next0;
+		      hits++;
+		      chain_hits++;
+		    }
+		  else
+		    {
+		      next0 = (t0->miss_next_index < n_next) ?
+			t0->miss_next_index : next0;
+		      misses++;
 		    }
 		}
 	    }
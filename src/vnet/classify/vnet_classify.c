@@ -749,6 +749,37 @@ format_classify_table (u8 * s, va_list * args)
   return s;
 }
 
+static int
+vnet_classify_table_mask_equal (vnet_classify_table_t * t0,
+				vnet_classify_table_t * t1)
+{
+  if (t0->match_n_vectors != t1->match_n_vectors ||
+      t0->skip_n_vectors != t1->skip_n_vectors ||
+      t0->current_data_flag != t1->current_data_flag ||
+      t0->current_data_offset != t1->current_data_offset)
+    return 0;
+
+  return !memcmp (t0->mask, t1->mask, t0->match_n_vectors * sizeof (u32x4));
+}
+
+/*
+ * Set the next table in the chain. Lookups reuse the packet hash on
+ * chained tables with the same mask, so remember whether the masks match.
+ */
+void
+vnet_classify_set_next_table (vnet_classify_main_t * cm,
+			      vnet_classify_table_t * t,
+			      u32 next_table_index)
+{
+  t->next_table_same_mask = 0;
+  if (next_table_index != ~0
+      && !pool_is_free_index (cm->tables, next_table_index))
+    t->next_table_same_mask =
+      vnet_classify_table_mask_equal (t, pool_elt_at_index (cm->tables,
+							    next_table_index));
+  t->next_table_index = next_table_index;
+}
+
 int
 vnet_classify_add_del_table (vnet_classify_main_t * cm,
 			     u8 * mask,
@@ -763,7 +794,7 @@ vnet_classify_add_del_table (vnet_classify_main_t * cm,
 			     i16 current_data_offset,
 			     int is_add, int del_chain)
 {
-  vnet_classify_table_t *t;
+  vnet_classify_table_t *t, *pt;
 
   if (is_add)
     {
@@ -780,18 +811,27 @@ vnet_classify_add_del_table (vnet_classify_main_t * cm,
 
 	  t = vnet_classify_new_table (cm, mask, nbuckets, memory_size,
 				       skip, match);
-	  t->next_table_index = next_table_index;
 	  t->miss_next_index = miss_next_index;
 	  t->current_data_flag = current_data_flag;
 	  t->current_data_offset = current_data_offset;
+	  vnet_classify_set_next_table (cm, t, next_table_index);
 	  *table_index = t - cm->tables;
+
+	  /* table index may be reused, refresh tables chained to it */
+	  /* *INDENT-OFF* */
+	  pool_foreach (pt, cm->tables,
+	  ({
+	    if (pt->next_table_index == *table_index)
+	      vnet_classify_set_next_table (cm, pt, *table_index);
+	  }));
+	  /* *INDENT-ON* */
 	}
       else			/* update */
 	{
 	  vnet_classify_main_t *cm = &vnet_classify_main;
 	  t = pool_elt_at_index (cm->tables, *table_index);
 
-	  t->next_table_index = next_table_index;
+	  vnet_classify_set_next_table (cm, t, next_table_index);
 	}
       return 0;
     }
@@ -1887,9 +1927,9 @@ classify_filter_command_fn (vlib_main_t * vm,
       t = pool_elt_at_index (cm->tables, set->table_indices[i]);
 
       if ((i + 1) < vec_len (set->table_indices))
-	t->next_table_index = set->table_indices[i + 1];
+	vnet_classify_set_next_table (cm, t, set->table_indices[i + 1]);
       else
-	t->next_table_index = ~0;
+	vnet_classify_set_next_table (cm, t, ~0);
     }
 
 found_table:
@@ -158,6 +158,9 @@ typedef struct
   /* Index of next table to try */
   u32 next_table_index;
 
+  /* Next table uses the same mask, packet hash can be reused */
+  u8 next_table_same_mask;
+
   /* Miss next index, return if next_table_index = 0 */
   u32 miss_next_index;
 
@@ -227,7 +230,16 @@ vnet_classify_hash_packet_inline (vnet_classify_table_t * t, u8 * h)
 
   ASSERT (t);
   mask = t->mask;
-#ifdef CLIB_HAVE_VEC128
+#if defined(CLIB_HAVE_VEC512)
+  u32x4u *data = (u32x4u *) h;
+  /* first 4 vectors in one go */
+  u16 load_mask = pow2_mask (clib_min (t->match_n_vectors, 4) * 4);
+  u32x16 x = u32x16_mask_load_zero (data + t->skip_n_vectors, load_mask) &
+    u32x16_mask_load_zero (mask, load_mask);
+  xor_sum.as_u32x4 = u32x16_xor_reduce_u32x4 (x);
+  if (PREDICT_FALSE (t->match_n_vectors == 5))
+    xor_sum.as_u32x4 ^= data[4 + t->skip_n_vectors] & mask[4];
+#elif defined(CLIB_HAVE_VEC128)
   u32x4u *data = (u32x4u *) h;
   xor_sum.as_u32x4 = data[0 + t->skip_n_vectors] & mask[0];
   switch (t->match_n_vectors)
@@ -365,11 +377,13 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 {
   vnet_classify_entry_t *v;
   u32x4 *mask, *key;
+#if !defined(CLIB_HAVE_VEC512)
   union
   {
     u32x4 as_u32x4;
     u64 as_u64[2];
   } result __attribute__ ((aligned (sizeof (u32x4))));
+#endif
   vnet_classify_bucket_t *b;
   u32 value_index;
   u32 bucket_index;
@@ -396,7 +410,33 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
 
   v = vnet_classify_entry_at_index (t, v, value_index);
 
-#ifdef CLIB_HAVE_VEC128
+#if defined(CLIB_HAVE_VEC512)
+  u32x4u *data = (u32x4u *) h;
+  /* mask packet data once, compare first 4 key vectors in one go */
+  u16 load_mask = pow2_mask (clib_min (t->match_n_vectors, 4) * 4);
+  u32x16 masked = u32x16_mask_load_zero (data + t->skip_n_vectors,
+					 load_mask) &
+    u32x16_mask_load_zero (mask, load_mask);
+  u32x4 masked4 = { };
+  if (PREDICT_FALSE (t->match_n_vectors == 5))
+    masked4 = data[4 + t->skip_n_vectors] & mask[4];
+  for (i = 0; i < limit; i++)
+    {
+      key = v->key;
+      if (u32x16_is_all_zero (masked ^ u32x16_mask_load_zero (key, load_mask))
+	  && (PREDICT_TRUE (t->match_n_vectors < 5)
+	      || u32x4_is_all_zero (masked4 ^ key[4])))
+	{
+	  if (PREDICT_TRUE (now))
+	    {
+	      v->hits++;
+	      v->last_heard = now;
+	    }
+	  return (v);
+	}
+      v = vnet_classify_entry_at_index (t, v, 1);
+    }
+#elif defined(CLIB_HAVE_VEC128)
   u32x4u *data = (u32x4u *) h;
   for (i = 0; i < limit; i++)
     {
@@ -492,6 +532,36 @@ vnet_classify_find_entry_inline (vnet_classify_table_t * t,
   return 0;
 }
 
+/*
+ * Continue lookup in the table chain after a miss in table *tp. Chained
+ * tables which use the same mask share the packet hash, so a chain of N
+ * tables costs one hash per distinct mask rather than one per table.
+ * On return *tp is the table which matched, or the last table in the chain.
+ */
+static inline vnet_classify_entry_t *
+vnet_classify_find_chain_entry_inline (vnet_classify_main_t * cm,
+				       vnet_classify_table_t ** tp,
+				       u8 * h, u64 hash, f64 now)
+{
+  vnet_classify_table_t *t = *tp;
+  vnet_classify_entry_t *e = 0;
+  u8 same_mask;
+
+  while (t->next_table_index != ~0)
+    {
+      same_mask = t->next_table_same_mask;
+      t = pool_elt_at_index (cm->tables, t->next_table_index);
+      if (!same_mask)
+	hash = vnet_classify_hash_packet_inline (t, h);
+      e = vnet_classify_find_entry_inline (t, h, hash, now);
+      if (e)
+	break;
+    }
+
+  *tp = t;
+  return e;
+}
+
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t * cm,
 						u8 * mask, u32 nbuckets,
 						u32 memory_size,
@@ -506,6 +576,10 @@ int vnet_classify_add_del_session (vnet_classify_main_t * cm,
 				   i32 advance,
 				   u8 action, u32 metadata, int is_add);
 
+void vnet_classify_set_next_table (vnet_classify_main_t * cm,
+				   vnet_classify_table_t * t,
+				   u32 next_table_index);
+
 int vnet_classify_add_del_table (vnet_classify_main_t * cm,
 				 u8 * mask,
 				 u32 nbuckets,
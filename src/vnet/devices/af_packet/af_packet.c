@@ -36,6 +36,19 @@
 
 af_packet_main_t af_packet_main;
 
+/*
+ * TPACKET_V3 rx blocks are retired to user space when full or after
+ * AF_PACKET_RX_BLOCK_TIMEOUT ms, a block must fit a full GSO packet when
+ * virtio-net headers are enabled.
+ */
+#define AF_PACKET_RX_BLOCK_SIZE		(1 << 17)
+#define AF_PACKET_RX_FRAME_SIZE		2048
+#define AF_PACKET_RX_BLOCK_NR		80
+#define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
+					 (AF_PACKET_RX_BLOCK_SIZE / \
+					  AF_PACKET_RX_FRAME_SIZE))
+#define AF_PACKET_RX_BLOCK_TIMEOUT	1
+
 #define AF_PACKET_TX_FRAMES_PER_BLOCK	1024
 #define AF_PACKET_TX_FRAME_SIZE	 	(2048 * 5)
 #define AF_PACKET_TX_BLOCK_NR		1
@@ -44,18 +57,17 @@ af_packet_main_t af_packet_main;
 #define AF_PACKET_TX_BLOCK_SIZE	 	(AF_PACKET_TX_FRAME_SIZE * \
 					 AF_PACKET_TX_FRAMES_PER_BLOCK)
 
-#define AF_PACKET_RX_FRAMES_PER_BLOCK	1024
-#define AF_PACKET_RX_FRAME_SIZE	 	(2048 * 5)
-#define AF_PACKET_RX_BLOCK_NR		1
-#define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
-					 AF_PACKET_RX_FRAMES_PER_BLOCK)
-#define AF_PACKET_RX_BLOCK_SIZE		(AF_PACKET_RX_FRAME_SIZE * \
-					 AF_PACKET_RX_FRAMES_PER_BLOCK)
+/* tx frames must fit a 64k GSO packet and its virtio-net header */
+#define AF_PACKET_GSO_TX_FRAME_SIZE	(1 << 17)
+#define AF_PACKET_GSO_TX_FRAME_NR	128
+
+/* kernel limit on the number of sockets in a fanout group */
+#define AF_PACKET_MAX_QUEUES		256
 
 /*defined in net/if.h but clashes with dpdk headers */
 unsigned int if_nametoindex (const char *ifname);
 
-typedef struct tpacket_req tpacket_req_t;
+typedef struct tpacket_req3 tpacket_req3_t;
 
 static u32
 af_packet_eth_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hi,
@@ -92,14 +104,12 @@ af_packet_fd_read_ready (clib_file_t * uf)
 {
   af_packet_main_t *apm = &af_packet_main;
   vnet_main_t *vnm = vnet_get_main ();
-  u32 idx = uf->private_data;
+  u32 idx = uf->private_data >> 16;
+  u16 qid = uf->private_data & 0xffff;
   af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, idx);
 
-  apm->pending_input_bitmap =
-    clib_bitmap_set (apm->pending_input_bitmap, idx, 1);
-
   /* Schedule the rx node */
-  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, 0);
+  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, qid);
 
   return 0;
 }
@@ -124,16 +134,18 @@ is_bridge (const u8 * host_if_name)
 }
 
 static int
-create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
-		       tpacket_req_t * tx_req, int *fd, u8 ** ring)
+create_packet_v3_sock (int host_if_index, tpacket_req3_t * rx_req,
+		       tpacket_req3_t * tx_req, af_packet_if_flags_t flags,
+		       int *fd, u8 ** ring)
 {
   af_packet_main_t *apm = &af_packet_main;
   int ret;
   struct sockaddr_ll sll;
-  int ver = TPACKET_V2;
-  socklen_t req_sz = sizeof (struct tpacket_req);
+  int ver = TPACKET_V3;
+  socklen_t req_sz = sizeof (struct tpacket_req3);
   u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr +
     tx_req->tp_block_size * tx_req->tp_block_nr;
+  int opt = 1;
 
   if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
     {
@@ -167,7 +179,6 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
-  int opt = 1;
   if (setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt)) < 0)
     {
       vlib_log_debug (apm->log_class,
@@ -177,6 +188,29 @@ create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
       goto error;
     }
 
+  /* must be set before the rings are configured */
+  if ((flags & AF_PACKET_IF_FLAG_CKSUM_GSO) &&
+      setsockopt (*fd, SOL_PACKET, PACKET_VNET_HDR, &opt, sizeof (opt)) < 0)
+    {
+      vlib_log_debug (apm->log_class,
+		      "Failed to set packet vnet hdr option: %s (errno %d)",
+		      strerror (errno), errno);
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
+  /* tx frames go straight to the driver, skipping the host qdisc */
+  if ((flags & AF_PACKET_IF_FLAG_QDISC_BYPASS) &&
+      setsockopt (*fd, SOL_PACKET, PACKET_QDISC_BYPASS, &opt,
+		  sizeof (opt)) < 0)
+    {
+      vlib_log_debug (apm->log_class,
+		      "Failed to set packet qdisc bypass option: %s (errno %d)",
+		      strerror (errno), errno);
+      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto error;
+    }
+
   if (setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz) < 0)
     {
       vlib_log_debug (apm->log_class,
@@ -216,17 +250,81 @@ error:
   return ret;
 }
 
+/*
+ * Join the socket to the interface fanout group. The first socket asks
+ * the kernel for an unused group id so that several VPP instances, or
+ * several interfaces, never end up in the same group.
+ */
+static int
+af_packet_fanout_join (af_packet_if_t * apif, af_packet_queue_t * q)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  int val, type = PACKET_FANOUT_HASH;
+  socklen_t len = sizeof (val);
+
+  if (q->queue_id == 0)
+    {
+      val = (type | PACKET_FANOUT_FLAG_UNIQUEID) << 16;
+      if (setsockopt (q->fd, SOL_PACKET, PACKET_FANOUT, &val, len) < 0
+	  || getsockopt (q->fd, SOL_PACKET, PACKET_FANOUT, &val, &len) < 0)
+	goto error;
+      apif->fanout_group_id = val & 0xffff;
+      return 0;
+    }
+
+  val = apif->fanout_group_id | (type << 16);
+  if (setsockopt (q->fd, SOL_PACKET, PACKET_FANOUT, &val, len) < 0)
+    goto error;
+
+  return 0;
+
+error:
+  vlib_log_debug (apm->log_class,
+		  "Failed to join packet fanout group: %s (errno %d)",
+		  strerror (errno), errno);
+  return VNET_API_ERROR_SYSCALL_ERROR_1;
+}
+
+static void
+af_packet_queue_free (af_packet_if_t * apif, af_packet_queue_t * q)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  u32 ring_sz;
+
+  if (q->clib_file_index != ~0)
+    {
+      clib_file_del (&file_main, file_main.file_pool + q->clib_file_index);
+      q->clib_file_index = ~0;
+    }
+  else if (q->fd >= 0)
+    close (q->fd);
+  q->fd = -1;
+
+  if (q->rx_ring)
+    {
+      ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
+	apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
+      if (munmap (q->rx_ring, ring_sz))
+	vlib_log_warn (apm->log_class,
+		       "Host interface %s could not free rx/tx ring",
+		       apif->host_if_name);
+    }
+  q->rx_ring = NULL;
+  q->tx_ring = NULL;
+
+  clib_spinlock_free (&q->lockp);
+}
+
 int
-af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
-		     u32 * sw_if_index)
+af_packet_create_if (vlib_main_t * vm, af_packet_create_if_arg_t * arg)
 {
   af_packet_main_t *apm = &af_packet_main;
-  int ret, fd = -1, fd2 = -1;
-  struct tpacket_req *rx_req = 0;
-  struct tpacket_req *tx_req = 0;
+  int ret, fd2 = -1;
+  struct tpacket_req3 *rx_req = 0;
+  struct tpacket_req3 *tx_req = 0;
   struct ifreq ifr;
-  u8 *ring = 0;
   af_packet_if_t *apif = 0;
+  af_packet_queue_t *q;
   u8 hw_addr[6];
   clib_error_t *error;
   vnet_sw_interface_t *sw;
@@ -237,28 +335,44 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   uword if_index;
   u8 *host_if_name_dup = 0;
   int host_if_index = -1;
+  u16 num_queues = arg->num_queues ? arg->num_queues : 1;
+  u16 i;
 
-  p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
+  p = mhash_get (&apm->if_index_by_host_if_name, arg->host_if_name);
   if (p)
     {
       apif = vec_elt_at_index (apm->interfaces, p[0]);
-      *sw_if_index = apif->sw_if_index;
+      arg->sw_if_index = apif->sw_if_index;
       return VNET_API_ERROR_IF_ALREADY_EXISTS;
     }
 
-  host_if_name_dup = vec_dup (host_if_name);
+  if (num_queues > AF_PACKET_MAX_QUEUES)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  host_if_name_dup = vec_dup (arg->host_if_name);
 
   vec_validate (rx_req, 0);
   rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
   rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
   rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
   rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+  rx_req->tp_retire_blk_tov = AF_PACKET_RX_BLOCK_TIMEOUT;
 
   vec_validate (tx_req, 0);
-  tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
-  tx_req->tp_frame_size = AF_PACKET_TX_FRAME_SIZE;
-  tx_req->tp_block_nr = AF_PACKET_TX_BLOCK_NR;
-  tx_req->tp_frame_nr = AF_PACKET_TX_FRAME_NR;
+  if (arg->flags & AF_PACKET_IF_FLAG_CKSUM_GSO)
+    {
+      tx_req->tp_block_size = AF_PACKET_GSO_TX_FRAME_SIZE;
+      tx_req->tp_frame_size = AF_PACKET_GSO_TX_FRAME_SIZE;
+      tx_req->tp_block_nr = AF_PACKET_GSO_TX_FRAME_NR;
+      tx_req->tp_frame_nr = AF_PACKET_GSO_TX_FRAME_NR;
+    }
+  else
+    {
+      tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
+      tx_req->tp_frame_size = AF_PACKET_TX_FRAME_SIZE;
+      tx_req->tp_block_nr = AF_PACKET_TX_BLOCK_NR;
+      tx_req->tp_frame_nr = AF_PACKET_TX_FRAME_NR;
+    }
 
   /*
    * make sure host side of interface is 'UP' before binding AF_PACKET
@@ -273,13 +387,13 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       goto error;
     }
 
-  clib_memcpy (ifr.ifr_name, (const char *) host_if_name,
-	       vec_len (host_if_name));
+  clib_memcpy (ifr.ifr_name, (const char *) arg->host_if_name,
+	       vec_len (arg->host_if_name));
   if (ioctl (fd2, SIOCGIFINDEX, &ifr) < 0)
     {
       vlib_log_debug (apm->log_class,
 		      "Failed to retrieve the interface (%s) index: %s (errno %d)",
-		      host_if_name, strerror (errno), errno);
+		      arg->host_if_name, strerror (errno), errno);
       ret = VNET_API_ERROR_INVALID_INTERFACE;
       goto error;
     }
@@ -313,48 +427,64 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       fd2 = -1;
     }
 
-  ret = create_packet_v2_sock (host_if_index, rx_req, tx_req, &fd, &ring);
-
-  if (ret != 0)
-    goto error;
-
-  ret = is_bridge (host_if_name);
-
-  if (ret == 0)			/* is a bridge, ignore state */
-    host_if_index = -1;
-
   /* So far everything looks good, let's create interface */
-  pool_get (apm->interfaces, apif);
+  pool_get_zero (apm->interfaces, apif);
   if_index = apif - apm->interfaces;
 
-  apif->host_if_index = host_if_index;
-  apif->fd = fd;
-  apif->rx_ring = ring;
-  apif->tx_ring = ring + rx_req->tp_block_size * rx_req->tp_block_nr;
   apif->rx_req = rx_req;
   apif->tx_req = tx_req;
   apif->host_if_name = host_if_name_dup;
   apif->per_interface_next_index = ~0;
-  apif->next_tx_frame = 0;
-  apif->next_rx_frame = 0;
+  apif->is_qdisc_bypass_enabled =
+    (arg->flags & AF_PACKET_IF_FLAG_QDISC_BYPASS) != 0;
+  apif->is_cksum_gso_enabled =
+    (arg->flags & AF_PACKET_IF_FLAG_CKSUM_GSO) != 0;
 
-  if (tm->n_vlib_mains > 1)
-    clib_spinlock_init (&apif->lockp);
+  vec_validate_aligned (apif->queues, num_queues - 1, CLIB_CACHE_LINE_BYTES);
+  vec_foreach (q, apif->queues)
+  {
+    q->fd = -1;
+    q->clib_file_index = ~0;
+  }
 
+  vec_foreach (q, apif->queues)
   {
+    q->queue_id = q - apif->queues;
+    ret = create_packet_v3_sock (host_if_index, rx_req, tx_req, arg->flags,
+				 &q->fd, &q->rx_ring);
+    if (ret != 0)
+      goto error_queues;
+
+    q->tx_ring = q->rx_ring + rx_req->tp_block_size * rx_req->tp_block_nr;
+
+    if (num_queues > 1 && (ret = af_packet_fanout_join (apif, q)) != 0)
+      goto error_queues;
+
+    /* a tx queue is shared by the threads it is mapped to */
+    if (num_queues < tm->n_vlib_mains)
+      clib_spinlock_init (&q->lockp);
+
     clib_file_t template = { 0 };
     template.read_function = af_packet_fd_read_ready;
-    template.file_descriptor = fd;
-    template.private_data = if_index;
+    template.file_descriptor = q->fd;
+    template.private_data = (if_index << 16) | q->queue_id;
     template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
-    template.description = format (0, "%U", format_af_packet_device_name,
-				   if_index);
-    apif->clib_file_index = clib_file_add (&file_main, &template);
+    template.description = format (0, "%U queue %u",
+				   format_af_packet_device_name, if_index,
+				   q->queue_id);
+    q->clib_file_index = clib_file_add (&file_main, &template);
   }
 
+  ret = is_bridge (arg->host_if_name);
+
+  if (ret == 0)			/* is a bridge, ignore state */
+    host_if_index = -1;
+
+  apif->host_if_index = host_if_index;
+
   /*use configured or generate random MAC address */
-  if (hw_addr_set)
-    clib_memcpy (hw_addr, hw_addr_set, 6);
+  if (arg->hw_addr)
+    clib_memcpy (hw_addr, arg->hw_addr, 6);
   else
     {
       f64 now = vlib_time_now (vm);
@@ -373,13 +503,11 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (error)
     {
-      clib_memset (apif, 0, sizeof (*apif));
-      pool_put (apm->interfaces, apif);
       vlib_log_err (apm->log_class, "Unable to register interface: %U",
 		    format_clib_error, error);
       clib_error_free (error);
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
-      goto error;
+      goto error_queues;
     }
 
   sw = vnet_get_hw_sw_interface (vnm, apif->hw_if_index);
@@ -388,23 +516,33 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_hw_interface_set_input_node (vnm, apif->hw_if_index,
 				    af_packet_input_node.index);
 
-  vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, 0,	/* queue */
-				      ~0 /* any cpu */ );
+  for (i = 0; i < num_queues; i++)
+    vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, i,	/* queue */
+					~0 /* any cpu */ );
 
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  if (apif->is_cksum_gso_enabled)
+    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO |
+      VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
 
-  vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, 0,
-				 VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
+  for (i = 0; i < num_queues; i++)
+    vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, i,
+				   VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
 
   mhash_set_mem (&apm->if_index_by_host_if_name, host_if_name_dup, &if_index,
 		 0);
-  if (sw_if_index)
-    *sw_if_index = apif->sw_if_index;
+  arg->sw_if_index = apif->sw_if_index;
 
   return 0;
 
+error_queues:
+  vec_foreach (q, apif->queues) af_packet_queue_free (apif, q);
+  vec_free (apif->queues);
+  clib_memset (apif, 0, sizeof (*apif));
+  pool_put (apm->interfaces, apif);
+
 error:
   if (fd2 > -1)
     {
@@ -423,9 +561,9 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   vnet_main_t *vnm = vnet_get_main ();
   af_packet_main_t *apm = &af_packet_main;
   af_packet_if_t *apif;
+  af_packet_queue_t *q;
   uword *p;
   uword if_index;
-  u32 ring_sz;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p == NULL)
@@ -439,38 +577,25 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
 
   /* bring down the interface */
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index, 0);
-  vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, 0);
+  vec_foreach (q, apif->queues)
+    vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index,
+					 q->queue_id);
 
   /* clean up */
-  if (apif->clib_file_index != ~0)
-    {
-      clib_file_del (&file_main, file_main.file_pool + apif->clib_file_index);
-      apif->clib_file_index = ~0;
-    }
-  else
-    close (apif->fd);
-
-  ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
-    apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
-  if (munmap (apif->rx_ring, ring_sz))
-    vlib_log_warn (apm->log_class,
-		   "Host interface %s could not free rx/tx ring",
-		   host_if_name);
-  apif->rx_ring = NULL;
-  apif->tx_ring = NULL;
-  apif->fd = -1;
+  vec_foreach (q, apif->queues) af_packet_queue_free (apif, q);
+  vec_free (apif->queues);
 
   vec_free (apif->rx_req);
   apif->rx_req = NULL;
   vec_free (apif->tx_req);
   apif->tx_req = NULL;
 
+  mhash_unset (&apm->if_index_by_host_if_name, host_if_name, &if_index);
+
   vec_free (apif->host_if_name);
   apif->host_if_name = NULL;
   apif->host_if_index = -1;
 
-  mhash_unset (&apm->if_index_by_host_if_name, host_if_name, &if_index);
-
   ethernet_delete_interface (vnm, apif->hw_if_index);
 
   pool_put (apm->interfaces, apif);
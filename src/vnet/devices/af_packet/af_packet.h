@@ -27,26 +27,51 @@ typedef struct
   u8 host_if_name[64];
 } af_packet_if_detail_t;
 
+typedef enum
+{
+  AF_PACKET_IF_FLAG_QDISC_BYPASS = (1 << 0),
+  AF_PACKET_IF_FLAG_CKSUM_GSO = (1 << 1),
+} af_packet_if_flags_t;
+
+/*
+ * One PACKET socket per queue, rx and tx rings share a single mapping.
+ * All the sockets of an interface are in the same fanout group, the
+ * kernel spreads received flows across them.
+ */
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_spinlock_t lockp;
-  u8 *host_if_name;
-  int host_if_index;
   int fd;
-  struct tpacket_req *rx_req;
-  struct tpacket_req *tx_req;
   u8 *rx_ring;
   u8 *tx_ring;
-  u32 hw_if_index;
-  u32 sw_if_index;
   u32 clib_file_index;
+  u16 queue_id;
+
+  /* TPACKET_V3 rx block walk */
+  u32 next_rx_block;
+  u32 num_rx_pkts;
+  u32 rx_frame_offset;
 
-  u32 next_rx_frame;
   u32 next_tx_frame;
+} af_packet_queue_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u8 *host_if_name;
+  int host_if_index;
+  struct tpacket_req3 *rx_req;
+  struct tpacket_req3 *tx_req;
+  af_packet_queue_t *queues;
+  u32 hw_if_index;
+  u32 sw_if_index;
+  u16 fanout_group_id;
 
   u32 per_interface_next_index;
   u8 is_admin_up;
+  u8 is_qdisc_bypass_enabled;
+  u8 is_cksum_gso_enabled;
 } af_packet_if_t;
 
 typedef struct
@@ -54,9 +79,6 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   af_packet_if_t *interfaces;
 
-  /* bitmap of pending rx interfaces */
-  uword *pending_input_bitmap;
-
   /* rx buffer cache */
   u32 **rx_buffers;
 
@@ -71,8 +93,18 @@ extern af_packet_main_t af_packet_main;
 extern vnet_device_class_t af_packet_device_class;
 extern vlib_node_registration_t af_packet_input_node;
 
-int af_packet_create_if (vlib_main_t * vm, u8 * host_if_name,
-			 u8 * hw_addr_set, u32 * sw_if_index);
+typedef struct
+{
+  u8 *host_if_name;
+  u8 *hw_addr;
+  u16 num_queues;
+  af_packet_if_flags_t flags;
+
+  /* return */
+  u32 sw_if_index;
+} af_packet_create_if_arg_t;
+
+int af_packet_create_if (vlib_main_t * vm, af_packet_create_if_arg_t * arg);
 int af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name);
 int af_packet_set_l4_cksum_offload (vlib_main_t * vm, u32 sw_if_index,
 				    u8 set);
@@ -44,6 +44,7 @@
 
 #define foreach_vpe_api_msg                                          \
 _(AF_PACKET_CREATE, af_packet_create)                                \
+_(AF_PACKET_CREATE_V2, af_packet_create_v2)                          \
 _(AF_PACKET_DELETE, af_packet_delete)                                \
 _(AF_PACKET_SET_L4_CKSUM_OFFLOAD, af_packet_set_l4_cksum_offload)    \
 _(AF_PACKET_DUMP, af_packet_dump)
@@ -53,23 +54,55 @@ vl_api_af_packet_create_t_handler (vl_api_af_packet_create_t * mp)
 {
   vlib_main_t *vm = vlib_get_main ();
   vl_api_af_packet_create_reply_t *rmp;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
   int rv = 0;
-  u8 *host_if_name = NULL;
-  u32 sw_if_index;
 
-  host_if_name = format (0, "%s", mp->host_if_name);
-  vec_add1 (host_if_name, 0);
+  clib_memset (arg, 0, sizeof (*arg));
 
-  rv = af_packet_create_if (vm, host_if_name,
-			    mp->use_random_hw_addr ? 0 : mp->hw_addr,
-			    &sw_if_index);
+  arg->host_if_name = format (0, "%s", mp->host_if_name);
+  vec_add1 (arg->host_if_name, 0);
+  arg->hw_addr = mp->use_random_hw_addr ? 0 : mp->hw_addr;
 
-  vec_free (host_if_name);
+  rv = af_packet_create_if (vm, arg);
+
+  vec_free (arg->host_if_name);
 
   /* *INDENT-OFF* */
   REPLY_MACRO2(VL_API_AF_PACKET_CREATE_REPLY,
   ({
-    rmp->sw_if_index = clib_host_to_net_u32(sw_if_index);
+    rmp->sw_if_index = clib_host_to_net_u32(arg->sw_if_index);
+  }));
+  /* *INDENT-ON* */
+}
+
+static void
+vl_api_af_packet_create_v2_t_handler (vl_api_af_packet_create_v2_t * mp)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vl_api_af_packet_create_v2_reply_t *rmp;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
+  u32 flags = clib_net_to_host_u32 (mp->flags);
+  int rv = 0;
+
+  clib_memset (arg, 0, sizeof (*arg));
+
+  arg->host_if_name = format (0, "%s", mp->host_if_name);
+  vec_add1 (arg->host_if_name, 0);
+  arg->hw_addr = mp->use_random_hw_addr ? 0 : mp->hw_addr;
+  arg->num_queues = clib_net_to_host_u16 (mp->num_queues);
+  if (flags & AF_PACKET_API_FLAG_QDISC_BYPASS)
+    arg->flags |= AF_PACKET_IF_FLAG_QDISC_BYPASS;
+  if (flags & AF_PACKET_API_FLAG_CKSUM_GSO)
+    arg->flags |= AF_PACKET_IF_FLAG_CKSUM_GSO;
+
+  rv = af_packet_create_if (vm, arg);
+
+  vec_free (arg->host_if_name);
+
+  /* *INDENT-OFF* */
+  REPLY_MACRO2(VL_API_AF_PACKET_CREATE_V2_REPLY,
+  ({
+    rmp->sw_if_index = clib_host_to_net_u32(arg->sw_if_index);
   }));
   /* *INDENT-ON* */
 }
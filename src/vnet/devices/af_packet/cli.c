@@ -44,10 +44,9 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 			     vlib_cli_command_t * cmd)
 {
   unformat_input_t _line_input, *line_input = &_line_input;
-  u8 *host_if_name = NULL;
+  af_packet_create_if_arg_t _arg, *arg = &_arg;
   u8 hwaddr[6];
-  u8 *hw_addr_ptr = 0;
-  u32 sw_if_index;
+  u32 num_queues;
   int r;
   clib_error_t *error = NULL;
 
@@ -55,14 +54,22 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   if (!unformat_user (input, unformat_line_input, line_input))
     return 0;
 
+  clib_memset (arg, 0, sizeof (*arg));
+
   while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
     {
-      if (unformat (line_input, "name %s", &host_if_name))
+      if (unformat (line_input, "name %s", &arg->host_if_name))
 	;
       else
 	if (unformat
 	    (line_input, "hw-addr %U", unformat_ethernet_address, hwaddr))
-	hw_addr_ptr = hwaddr;
+	arg->hw_addr = hwaddr;
+      else if (unformat (line_input, "num-queues %u", &num_queues))
+	arg->num_queues = num_queues;
+      else if (unformat (line_input, "qdisc-bypass"))
+	arg->flags |= AF_PACKET_IF_FLAG_QDISC_BYPASS;
+      else if (unformat (line_input, "cksum-gso"))
+	arg->flags |= AF_PACKET_IF_FLAG_CKSUM_GSO;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -71,13 +78,13 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	}
     }
 
-  if (host_if_name == NULL)
+  if (arg->host_if_name == NULL)
     {
       error = clib_error_return (0, "missing host interface name");
       goto done;
     }
 
-  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, &sw_if_index);
+  r = af_packet_create_if (vm, arg);
 
   if (r == VNET_API_ERROR_SYSCALL_ERROR_1)
     {
@@ -97,11 +104,17 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       goto done;
     }
 
+  if (r == VNET_API_ERROR_INVALID_VALUE)
+    {
+      error = clib_error_return (0, "Invalid number of queues");
+      goto done;
+    }
+
   vlib_cli_output (vm, "%U\n", format_vnet_sw_if_index_name, vnet_get_main (),
-		   sw_if_index);
+		   arg->sw_if_index);
 
 done:
-  vec_free (host_if_name);
+  vec_free (arg->host_if_name);
   unformat_free (line_input);
 
   return error;
@@ -119,6 +132,16 @@ done:
  *
  * - <b>hw-addr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
+ * - <b>num-queues <n></b> - Number of PACKET sockets, each one is an rx
+ * and tx queue. The kernel spreads received flows across the sockets with
+ * a fanout group. Defaults to 1.
+ * - <b>qdisc-bypass</b> - Send tx frames straight to the driver, skipping
+ * the host interface qdisc. Host tc shaping and taps on the interface do
+ * not see these frames, and they are dropped rather than queued when the
+ * device queue is busy.
+ * - <b>cksum-gso</b> - Exchange virtio-net headers with the kernel so that
+ * TCP/UDP checksums and TCP segmentation are left to the kernel, and
+ * GSO packets are received as is.
  *
  * @cliexpar
  * Example of how to create a host interface tied to one side of an
@@ -132,7 +155,8 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (af_packet_create_command, static) = {
   .path = "create host-interface",
-  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>]",
+  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>] "
+    "[num-queues <n>] [qdisc-bypass] [cksum-gso]",
   .function = af_packet_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -18,6 +18,7 @@
  */
 
 #include <linux/if_packet.h>
+#include <linux/virtio_net.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
@@ -27,6 +28,7 @@
 #include <vlib/unix/unix.h>
 #include <vnet/ip/ip.h>
 #include <vnet/ethernet/ethernet.h>
+#include <vnet/gso/gso.h>
 
 #include <vnet/devices/af_packet/af_packet.h>
 
@@ -34,7 +36,8 @@
 _(FRAME_NOT_READY, "tx frame not ready")              \
 _(TXRING_EAGAIN,   "tx sendto temporary failure")     \
 _(TXRING_FATAL,    "tx sendto fatal failure")         \
-_(TXRING_OVERRUN,  "tx ring overrun")
+_(TXRING_OVERRUN,  "tx ring overrun")                 \
+_(FRAME_TOO_BIG,   "tx packet larger than tx frame")
 
 typedef enum
 {
@@ -67,7 +70,25 @@ format_af_packet_device_name (u8 * s, va_list * args)
 static u8 *
 format_af_packet_device (u8 * s, va_list * args)
 {
-  s = format (s, "Linux PACKET socket interface");
+  u32 dev_instance = va_arg (*args, u32);
+  CLIB_UNUSED (int verbose) = va_arg (*args, int);
+  af_packet_main_t *apm = &af_packet_main;
+  af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, dev_instance);
+  u32 indent = format_get_indent (s);
+
+  s = format (s, "Linux PACKET socket interface v3");
+  s = format (s, "\n%Uqueues %u", format_white_space, indent,
+	      vec_len (apif->queues));
+  if (vec_len (apif->queues) > 1)
+    s = format (s, " fanout-group %u", apif->fanout_group_id);
+  if (apif->is_qdisc_bypass_enabled)
+    s = format (s, " qdisc-bypass");
+  if (apif->is_cksum_gso_enabled)
+    s = format (s, " cksum-gso");
+  s = format (s, "\n%Urx block-size %u block-nr %u tx frame-size %u "
+	      "frame-nr %u", format_white_space, indent,
+	      apif->rx_req->tp_block_size, apif->rx_req->tp_block_nr,
+	      apif->tx_req->tp_frame_size, apif->tx_req->tp_frame_nr);
   return s;
 }
 
@@ -78,6 +99,56 @@ format_af_packet_tx_trace (u8 * s, va_list * args)
   return s;
 }
 
+static_always_inline void
+fill_vnet_hdr (vlib_buffer_t * b, struct virtio_net_hdr *vnet_hdr)
+{
+  gso_header_offset_t gho;
+  int is_ip6 = (b->flags & VNET_BUFFER_F_IS_IP6) != 0;
+
+  clib_memset (vnet_hdr, 0, sizeof (*vnet_hdr));
+
+  if (!(b->flags & (VNET_BUFFER_F_GSO | VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+		    VNET_BUFFER_F_OFFLOAD_UDP_CKSUM |
+		    VNET_BUFFER_F_OFFLOAD_IP_CKSUM)))
+    return;
+
+  if (!(b->flags & (VNET_BUFFER_F_IS_IP4 | VNET_BUFFER_F_IS_IP6)))
+    return;
+
+  gho = vnet_gso_header_offset_parser (b, is_ip6);
+
+  /* the kernel does not compute ip4 header checksums */
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM)
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (vlib_buffer_get_current (b) +
+					    gho.l3_hdr_offset);
+      ip4->checksum = ip4_header_checksum (ip4);
+    }
+
+  if (b->flags & VNET_BUFFER_F_GSO)
+    {
+      vnet_hdr->gso_type = is_ip6 ? VIRTIO_NET_HDR_GSO_TCPV6 :
+	VIRTIO_NET_HDR_GSO_TCPV4;
+      vnet_hdr->gso_size = vnet_buffer2 (b)->gso_size;
+      vnet_hdr->hdr_len = gho.l4_hdr_offset + gho.l4_hdr_sz;
+      vnet_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      vnet_hdr->csum_start = gho.l4_hdr_offset;
+      vnet_hdr->csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+    }
+  else if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    {
+      vnet_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      vnet_hdr->csum_start = gho.l4_hdr_offset;
+      vnet_hdr->csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+    }
+  else if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
+    {
+      vnet_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      vnet_hdr->csum_start = gho.l4_hdr_offset;
+      vnet_hdr->csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+    }
+}
+
 VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 						  vlib_node_runtime_t * node,
 						  vlib_frame_t * frame)
@@ -89,15 +160,20 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
   vnet_interface_output_runtime_t *rd = (void *) node->runtime_data;
   af_packet_if_t *apif =
     pool_elt_at_index (apm->interfaces, rd->dev_instance);
-  clib_spinlock_lock_if_init (&apif->lockp);
-  int block = 0;
-  u32 block_size = apif->tx_req->tp_block_size;
+  af_packet_queue_t *q = vec_elt_at_index (apif->queues,
+					   vm->thread_index %
+					   vec_len (apif->queues));
+  clib_spinlock_lock_if_init (&q->lockp);
   u32 frame_size = apif->tx_req->tp_frame_size;
   u32 frame_num = apif->tx_req->tp_frame_nr;
-  u8 *block_start = apif->tx_ring + block * block_size;
-  u32 tx_frame = apif->next_tx_frame;
-  struct tpacket2_hdr *tph;
+  u8 *block_start = q->tx_ring;
+  u32 tx_frame = q->next_tx_frame;
+  u32 hdr_sz = TPACKET_ALIGN (sizeof (struct tpacket3_hdr));
+  u32 vnet_hdr_sz =
+    apif->is_cksum_gso_enabled ? sizeof (struct virtio_net_hdr) : 0;
+  struct tpacket3_hdr *tph;
   u32 frame_not_ready = 0;
+  u32 too_big = 0;
 
   while (n_left > 0)
     {
@@ -108,7 +184,7 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
       u32 bi = buffers[0];
       buffers++;
 
-      tph = (struct tpacket2_hdr *) (block_start + tx_frame * frame_size);
+      tph = (struct tpacket3_hdr *) (block_start + tx_frame * frame_size);
 
       if (PREDICT_FALSE
 	  (tph->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)))
@@ -117,19 +193,30 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 	  goto next;
 	}
 
+      b0 = vlib_get_buffer (vm, bi);
+      if (PREDICT_FALSE (hdr_sz + vnet_hdr_sz +
+			 vlib_buffer_length_in_chain (vm, b0) > frame_size))
+	{
+	  too_big++;
+	  continue;
+	}
+
+      if (vnet_hdr_sz)
+	fill_vnet_hdr (b0, (struct virtio_net_hdr *) ((u8 *) tph + hdr_sz));
+
       do
 	{
 	  b0 = vlib_get_buffer (vm, bi);
 	  len = b0->current_length;
-	  clib_memcpy_fast ((u8 *) tph +
-			    TPACKET_ALIGN (sizeof (struct tpacket2_hdr)) +
-			    offset, vlib_buffer_get_current (b0), len);
+	  clib_memcpy_fast ((u8 *) tph + hdr_sz + vnet_hdr_sz + offset,
+			    vlib_buffer_get_current (b0), len);
 	  offset += len;
 	}
       while ((bi =
 	      (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ? b0->next_buffer : 0));
 
-      tph->tp_len = tph->tp_snaplen = offset;
+      tph->tp_len = tph->tp_snaplen = vnet_hdr_sz + offset;
+      tph->tp_next_offset = 0;
       tph->tp_status = TP_STATUS_SEND_REQUEST;
       n_sent++;
     next:
@@ -144,9 +231,9 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 
   if (PREDICT_TRUE (n_sent))
     {
-      apif->next_tx_frame = tx_frame;
+      q->next_tx_frame = tx_frame;
 
-      if (PREDICT_FALSE (sendto (apif->fd, NULL, 0,
+      if (PREDICT_FALSE (sendto (q->fd, NULL, 0,
 				 MSG_DONTWAIT, NULL, 0) == -1))
 	{
 	  /* Uh-oh, drop & move on, but count whether it was fatal or not.
@@ -160,12 +247,16 @@ VNET_DEVICE_CLASS_TX_FN (af_packet_device_class) (vlib_main_t * vm,
 	}
     }
 
-  clib_spinlock_unlock_if_init (&apif->lockp);
+  clib_spinlock_unlock_if_init (&q->lockp);
 
   if (PREDICT_FALSE (frame_not_ready))
     vlib_error_count (vm, node->node_index,
 		      AF_PACKET_TX_ERROR_FRAME_NOT_READY, frame_not_ready);
 
+  if (PREDICT_FALSE (too_big))
+    vlib_error_count (vm, node->node_index,
+		      AF_PACKET_TX_ERROR_FRAME_TOO_BIG, too_big);
+
   if (PREDICT_FALSE (frame_not_ready + n_sent == frame_num))
     vlib_error_count (vm, node->node_index, AF_PACKET_TX_ERROR_TXRING_OVERRUN,
 		      n_left);
@@ -18,6 +18,7 @@
  */
 
 #include <linux/if_packet.h>
+#include <linux/virtio_net.h>
 
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
@@ -50,8 +51,10 @@ typedef struct
 {
   u32 next_index;
   u32 hw_if_index;
-  int block;
-  struct tpacket2_hdr tph;
+  u16 queue_id;
+  u8 is_cksum_gso_enabled;
+  struct tpacket3_hdr tph;
+  struct virtio_net_hdr vnet_hdr;
 } af_packet_input_trace_t;
 
 static u8 *
@@ -62,12 +65,12 @@ format_af_packet_input_trace (u8 * s, va_list * args)
   af_packet_input_trace_t *t = va_arg (*args, af_packet_input_trace_t *);
   u32 indent = format_get_indent (s);
 
-  s = format (s, "af_packet: hw_if_index %d next-index %d",
-	      t->hw_if_index, t->next_index);
+  s = format (s, "af_packet: hw_if_index %d rx-queue %u next-index %d",
+	      t->hw_if_index, t->queue_id, t->next_index);
 
   s =
     format (s,
-	    "\n%Utpacket2_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
+	    "\n%Utpacket3_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
 	    "\n%Usec 0x%x nsec 0x%x vlan %U"
 #ifdef TP_STATUS_VLAN_TPID_VALID
 	    " vlan_tpid %u"
@@ -82,11 +85,21 @@ format_af_packet_input_trace (u8 * s, va_list * args)
 	    t->tph.tp_net,
 	    format_white_space, indent + 4,
 	    t->tph.tp_sec,
-	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.tp_vlan_tci
+	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.hv1.tp_vlan_tci
 #ifdef TP_STATUS_VLAN_TPID_VALID
-	    , t->tph.tp_vlan_tpid
+	    , t->tph.hv1.tp_vlan_tpid
 #endif
     );
+
+  if (t->is_cksum_gso_enabled)
+    s = format (s, "\n%Uvnet_hdr:\n%Uflags 0x%02x gso_type 0x%02x hdr_len %u"
+		"\n%Ugso_size %u csum_start %u csum_offset %u",
+		format_white_space, indent + 2,
+		format_white_space, indent + 4,
+		t->vnet_hdr.flags, t->vnet_hdr.gso_type, t->vnet_hdr.hdr_len,
+		format_white_space, indent + 4,
+		t->vnet_hdr.gso_size, t->vnet_hdr.csum_start,
+		t->vnet_hdr.csum_offset);
   return s;
 }
 
@@ -173,27 +186,67 @@ mark_tcp_udp_cksum_calc (vlib_buffer_t * b)
     }
 }
 
+static_always_inline void
+fill_gso_buffer_flags (vlib_buffer_t * b, struct virtio_net_hdr *vnet_hdr)
+{
+  tcp_header_t *tcp;
+
+  /* the kernel only aggregates tcp, l4 offsets come from the csum path */
+  if (!(b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM))
+    return;
+
+  if (vnet_hdr->gso_type == VIRTIO_NET_HDR_GSO_TCPV4 ||
+      vnet_hdr->gso_type == VIRTIO_NET_HDR_GSO_TCPV6)
+    {
+      tcp = (tcp_header_t *) (vlib_buffer_get_current (b) +
+			      vnet_buffer (b)->l4_hdr_offset);
+      vnet_buffer2 (b)->gso_size = vnet_hdr->gso_size;
+      vnet_buffer2 (b)->gso_l4_hdr_sz = tcp_header_bytes (tcp);
+      b->flags |= VNET_BUFFER_F_GSO;
+    }
+}
+
+static_always_inline struct tpacket_block_desc *
+af_packet_rx_block (af_packet_if_t * apif, af_packet_queue_t * q)
+{
+  return (struct tpacket_block_desc *) (q->rx_ring + q->next_rx_block *
+					 apif->rx_req->tp_block_size);
+}
+
+static_always_inline int
+af_packet_rx_block_is_ready (struct tpacket_block_desc *bd)
+{
+  /* pairs with the kernel store when the block is retired */
+  return __atomic_load_n (&bd->hdr.bh1.block_status,
+			  __ATOMIC_ACQUIRE) & TP_STATUS_USER;
+}
+
+/*
+ * TPACKET_V3: the kernel fills whole blocks of variable sized frames and
+ * hands them over when full or when the block timer expires. A block is
+ * returned to the kernel once all of its packets are copied out, the
+ * position inside a partially consumed block is kept in the queue.
+ */
 always_inline uword
 af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
-			   vlib_frame_t * frame, af_packet_if_t * apif)
+			   vlib_frame_t * frame, af_packet_if_t * apif,
+			   af_packet_queue_t * q)
 {
   af_packet_main_t *apm = &af_packet_main;
-  struct tpacket2_hdr *tph;
+  struct tpacket_block_desc *bd;
+  struct tpacket3_hdr *tph;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-  u32 block = 0;
-  u32 rx_frame;
   u32 n_free_bufs;
   u32 n_rx_packets = 0;
   u32 n_rx_bytes = 0;
   u32 *to_next = 0;
-  u32 block_size = apif->rx_req->tp_block_size;
-  u32 frame_size = apif->rx_req->tp_frame_size;
-  u32 frame_num = apif->rx_req->tp_frame_nr;
-  u8 *block_start = apif->rx_ring + block * block_size;
+  u32 block_nr = apif->rx_req->tp_block_nr;
+  u32 num_pkts = q->num_rx_pkts;
+  u32 frame_offset = q->rx_frame_offset;
   uword n_trace = vlib_get_trace_count (vm, node);
   u32 thread_index = vm->thread_index;
   u32 n_buffer_bytes = vlib_buffer_get_default_data_size (vm);
-  u32 min_bufs = apif->rx_req->tp_frame_size / n_buffer_bytes;
+  u8 out_of_buffers = 0;
 
   n_free_bufs = vec_len (apm->rx_buffers[thread_index]);
   if (PREDICT_FALSE (n_free_bufs < VLIB_FRAME_SIZE))
@@ -206,21 +259,41 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       _vec_len (apm->rx_buffers[thread_index]) = n_free_bufs;
     }
 
-  rx_frame = apif->next_rx_frame;
-  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
-  while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs))
+  bd = af_packet_rx_block (apif, q);
+  while (af_packet_rx_block_is_ready (bd))
     {
       vlib_buffer_t *b0 = 0, *first_b0 = 0;
       u32 next0 = next_index;
 
+      if (num_pkts == 0)
+	{
+	  num_pkts = bd->hdr.bh1.num_pkts;
+	  frame_offset = bd->hdr.bh1.offset_to_first_pkt;
+	}
+
       u32 n_left_to_next;
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs) &&
-	     n_left_to_next)
+      while (num_pkts && n_left_to_next)
 	{
+	  tph = (struct tpacket3_hdr *) ((u8 *) bd + frame_offset);
 	  u32 data_len = tph->tp_snaplen;
 	  u32 offset = 0;
 	  u32 bi0 = 0, first_bi0 = 0, prev_bi0;
+	  u32 vlan_len0 = (tph->tp_status & TP_STATUS_VLAN_VALID) ?
+	    sizeof (ethernet_vlan_header_t) : 0;
+	  struct virtio_net_hdr *vnet_hdr0 = 0;
+
+	  /* a GSO packet may need many buffers, leave it for the next run */
+	  if (PREDICT_FALSE ((data_len + vlan_len0 + n_buffer_bytes - 1) /
+			     n_buffer_bytes > n_free_bufs))
+	    {
+	      out_of_buffers = 1;
+	      break;
+	    }
+
+	  if (apif->is_cksum_gso_enabled)
+	    vnet_hdr0 = (struct virtio_net_hdr *) ((u8 *) tph + tph->tp_mac -
+						   sizeof (*vnet_hdr0));
 
 	  while (data_len)
 	    {
@@ -251,11 +324,14 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      ethernet_vlan_header_t *vlan =
 			(ethernet_vlan_header_t *) (eth + 1);
 		      vlan->priority_cfi_and_id =
-			clib_host_to_net_u16 (tph->tp_vlan_tci);
+			clib_host_to_net_u16 (tph->hv1.tp_vlan_tci);
 		      vlan->type = eth->type;
 		      eth->type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
 		      vlan_len = sizeof (ethernet_vlan_header_t);
 		      bytes_copied = sizeof (ethernet_header_t);
+		      /* keep room for the tag in the first buffer */
+		      if (bytes_to_copy + vlan_len > n_buffer_bytes)
+			bytes_to_copy -= vlan_len;
 		    }
 		}
 	      clib_memcpy_fast (((u8 *) vlib_buffer_get_current (b0)) +
@@ -274,7 +350,14 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		  vnet_buffer (b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
 		  first_bi0 = bi0;
 		  first_b0 = vlib_get_buffer (vm, first_bi0);
-		  if (tph->tp_status & TP_STATUS_CSUMNOTREADY)
+		  if (vnet_hdr0)
+		    {
+		      if (vnet_hdr0->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)
+			mark_tcp_udp_cksum_calc (first_b0);
+		      if (vnet_hdr0->gso_type != VIRTIO_NET_HDR_GSO_NONE)
+			fill_gso_buffer_flags (first_b0, vnet_hdr0);
+		    }
+		  else if (tph->tp_status & TP_STATUS_CSUMNOTREADY)
 		    mark_tcp_udp_cksum_calc (first_b0);
 		}
 	      else
@@ -319,7 +402,12 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = apif->hw_if_index;
-	      clib_memcpy_fast (&tr->tph, tph, sizeof (struct tpacket2_hdr));
+	      tr->queue_id = q->queue_id;
+	      tr->is_cksum_gso_enabled = apif->is_cksum_gso_enabled;
+	      clib_memcpy_fast (&tr->tph, tph, sizeof (struct tpacket3_hdr));
+	      if (vnet_hdr0)
+		clib_memcpy_fast (&tr->vnet_hdr, vnet_hdr0,
+				  sizeof (struct virtio_net_hdr));
 	    }
 
 	  /* enque and take next packet */
@@ -327,15 +415,27 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 					   n_left_to_next, first_bi0, next0);
 
 	  /* next packet */
-	  tph->tp_status = TP_STATUS_KERNEL;
-	  rx_frame = (rx_frame + 1) % frame_num;
-	  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
+	  num_pkts--;
+	  frame_offset += tph->tp_next_offset;
 	}
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+      if (out_of_buffers)
+	break;
+
+      if (num_pkts == 0)
+	{
+	  /* block done, give it back to the kernel */
+	  __atomic_store_n (&bd->hdr.bh1.block_status, TP_STATUS_KERNEL,
+			    __ATOMIC_RELEASE);
+	  q->next_rx_block = (q->next_rx_block + 1) % block_nr;
+	  bd = af_packet_rx_block (apif, q);
+	}
     }
 
-  apif->next_rx_frame = rx_frame;
+  q->num_rx_pkts = num_pkts;
+  q->rx_frame_offset = frame_offset;
 
   vlib_increment_combined_counter
     (vnet_get_main ()->interface_main.combined_sw_if_counters
@@ -358,9 +458,20 @@ VLIB_NODE_FN (af_packet_input_node) (vlib_main_t * vm,
   foreach_device_and_queue (dq, rt->devices_and_queues)
   {
     af_packet_if_t *apif;
+    af_packet_queue_t *q;
     apif = vec_elt_at_index (apm->interfaces, dq->dev_instance);
-    if (apif->is_admin_up)
-      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif);
+    q = vec_elt_at_index (apif->queues, dq->queue_id);
+    if (!apif->is_admin_up)
+      continue;
+
+    n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif, q);
+
+    /* the socket is edge triggered, do not leave retired blocks behind */
+    if (dq->mode != VNET_HW_INTERFACE_RX_MODE_POLLING &&
+	af_packet_rx_block_is_ready (af_packet_rx_block (apif, q)))
+      vnet_device_input_set_interrupt_pending (vnet_get_main (),
+					       apif->hw_if_index,
+					       dq->queue_id);
   }
 
   return n_rx_packets;
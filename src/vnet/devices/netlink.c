@@ -207,6 +207,42 @@ vnet_netlink_set_link_mtu (int ifindex, int mtu)
   return vnet_netlink_msg_send (&m);
 }
 
+clib_error_t *
+vnet_netlink_set_link_xdp_fd (int ifindex, int fd, u32 flags)
+{
+  vnet_netlink_msg_t m;
+  struct ifinfomsg ifmsg = { 0 };
+  struct rtattr *rta;
+  u8 *nest = 0, *p;
+
+  ifmsg.ifi_family = AF_UNSPEC;
+  ifmsg.ifi_index = ifindex;
+
+  vnet_netlink_msg_init (&m, RTM_SETLINK, NLM_F_REQUEST,
+			 &ifmsg, sizeof (struct ifinfomsg));
+
+  /* IFLA_XDP is a nested attribute: { IFLA_XDP_FD, IFLA_XDP_FLAGS } */
+  vec_add2 (nest, p, RTA_SPACE (sizeof (int)));
+  rta = (struct rtattr *) p;
+  rta->rta_type = IFLA_XDP_FD;
+  rta->rta_len = RTA_LENGTH (sizeof (int));
+  clib_memcpy (RTA_DATA (rta), &fd, sizeof (int));
+
+  if (flags)
+    {
+      vec_add2 (nest, p, RTA_SPACE (sizeof (u32)));
+      rta = (struct rtattr *) p;
+      rta->rta_type = IFLA_XDP_FLAGS;
+      rta->rta_len = RTA_LENGTH (sizeof (u32));
+      clib_memcpy (RTA_DATA (rta), &flags, sizeof (u32));
+    }
+
+  vnet_netlink_msg_add_rtattr (&m, IFLA_XDP | NLA_F_NESTED, nest,
+			       vec_len (nest));
+  vec_free (nest);
+  return vnet_netlink_msg_send (&m);
+}
+
 clib_error_t *
 vnet_netlink_add_ip4_addr (int ifindex, void *addr, int pfx_len)
 {
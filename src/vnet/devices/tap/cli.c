@@ -104,6 +104,9 @@ tap_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       unformat_free (line_input);
     }
 
+  if (args.num_rx_queues < 1)
+    return clib_error_return (0, "number of rx queues must be >= 1");
+
   if (ip_addr_set && args.host_bridge)
     return clib_error_return (0, "Please specify either host ip address or "
 			      "host bridge");
@@ -130,7 +133,8 @@ VLIB_CLI_COMMAND (tap_create_command, static) = {
     "[host-bridge <bridge-name>] [host-ip4-addr <ip4addr/mask>] "
     "[host-ip6-addr <ip6-addr>] [host-ip4-gw <ip4-addr>] "
     "[host-ip6-gw <ip6-addr>] [host-mac-addr <host-mac-address>] "
-    "[host-if-name <name>] [host-mtu-size <size>] [no-gso|gso|csum-offload]",
+    "[host-if-name <name>] [host-mtu-size <size>] [num-rx-queues <n>] "
+    "[no-gso|gso|csum-offload]",
   .function = tap_create_command_fn,
 };
 /* *INDENT-ON* */
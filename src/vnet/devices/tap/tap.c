@@ -86,6 +86,10 @@ open_netns_fd (char *netns)
 
 #define TAP_MAX_INSTANCE 1024
 
+/* with gso the host also hands over its GRO coalesced segments as is,
+   including the ECN marked ones */
+#define TAP_GSO_OFFLOAD (TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 | TUN_F_TSO_ECN)
+
 static void
 tap_free (vlib_main_t * vm, virtio_if_t * vif)
 {
@@ -100,12 +104,12 @@ tap_free (vlib_main_t * vm, virtio_if_t * vif)
     virtio_vring_free_rx (vm, vif, RX_QUEUE (i));
   vec_foreach_index (i, vif->txq_vrings)
     virtio_vring_free_tx (vm, vif, TX_QUEUE (i));
+  vec_foreach_index (i, vif->tap_fds) if (vif->tap_fds[i] != -1)
+    close (vif->tap_fds[i]);
   /* *INDENT-ON* */
 
-  if (vif->tap_fd != -1)
-    close (vif->tap_fd);
-
   vec_free (vif->vhost_fds);
+  vec_free (vif->tap_fds);
   vec_free (vif->rxq_vrings);
   vec_free (vif->txq_vrings);
   vec_free (vif->host_if_name);
@@ -136,7 +140,7 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   virtio_if_t *vif = 0;
   clib_error_t *err = 0;
   unsigned int tap_features;
-  int tfd, vfd, nfd = -1;
+  int tfd, qfd, vfd, nfd = -1;
   char *host_if_name = 0;
   unsigned int offload = 0;
   u16 num_q_pairs;
@@ -174,12 +178,13 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
     ethernet_mac_address_generate (args->host_mac_addr.bytes);
   clib_memcpy (vif->host_mac_addr, args->host_mac_addr.bytes, 6);
 
-  if ((vif->tap_fd = tfd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
+  if ((tfd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
     {
       args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
       args->error = clib_error_return_unix (0, "open '/dev/net/tun'");
       goto error;
     }
+  vec_add1 (vif->tap_fds, tfd);
   tap_log_dbg (vif, "open tap fd %d", tfd);
 
   _IOCTL (tfd, TUNGETFEATURES, &tap_features);
@@ -207,7 +212,7 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   hdrsz = sizeof (struct virtio_net_hdr_v1);
   if (args->tap_flags & TAP_FLAG_GSO)
     {
-      offload = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
+      offload = TAP_GSO_OFFLOAD;
       vif->gso_enabled = 1;
     }
   else if (args->tap_flags & TAP_FLAG_CSUM_OFFLOAD)
@@ -220,6 +225,22 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   tap_log_dbg (vif, "TUNSETIFF fd %d name %s flags 0x%x", tfd,
 	       ifr.ifr_ifrn.ifrn_name, ifr.ifr_flags);
 
+  /* attach one more tap queue per additional rx queue, the kernel spreads
+     host traffic over them and each one gets its own vhost-net worker */
+  for (i = 1; i < vif->num_rxqs; i++)
+    {
+      if ((qfd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK)) < 0)
+	{
+	  args->rv = VNET_API_ERROR_SYSCALL_ERROR_2;
+	  args->error = clib_error_return_unix (0, "open '/dev/net/tun'");
+	  goto error;
+	}
+      vec_add1 (vif->tap_fds, qfd);
+      _IOCTL (qfd, TUNSETIFF, (void *) &ifr);
+      tap_log_dbg (vif, "TUNSETIFF fd %d name %s flags 0x%x queue %u", qfd,
+		   ifr.ifr_ifrn.ifrn_name, ifr.ifr_flags, i);
+    }
+
   vif->ifindex = if_nametoindex (ifr.ifr_ifrn.ifrn_name);
   tap_log_dbg (vif, "ifindex %d", vif->ifindex);
 
@@ -228,20 +249,26 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
   else
     host_if_name = (char *) args->host_if_name;
 
-  if (fcntl (tfd, F_SETFL, O_NONBLOCK) < 0)
-    {
-      err = clib_error_return_unix (0, "fcntl(tfd, F_SETFL, O_NONBLOCK)");
-      tap_log_err (vif, "set nonblocking: %U", format_clib_error, err);
-      goto error;
-    }
+  vec_foreach_index (i, vif->tap_fds)
+  {
+    int sndbuf = INT_MAX;
+    qfd = vif->tap_fds[i];
+
+    if (fcntl (qfd, F_SETFL, O_NONBLOCK) < 0)
+      {
+	err = clib_error_return_unix (0, "fcntl(qfd, F_SETFL, O_NONBLOCK)");
+	tap_log_err (vif, "set nonblocking: %U", format_clib_error, err);
+	goto error;
+      }
 
-  tap_log_dbg (vif, "TUNSETVNETHDRSZ: fd %d vnet_hdr_sz %u", tfd, hdrsz);
-  _IOCTL (tfd, TUNSETVNETHDRSZ, &hdrsz);
+    tap_log_dbg (vif, "TUNSETVNETHDRSZ: fd %d vnet_hdr_sz %u", qfd, hdrsz);
+    _IOCTL (qfd, TUNSETVNETHDRSZ, &hdrsz);
 
-  i = INT_MAX;
-  tap_log_dbg (vif, "TUNSETSNDBUF: fd %d sndbuf %d", tfd, i);
-  _IOCTL (tfd, TUNSETSNDBUF, &i);
+    tap_log_dbg (vif, "TUNSETSNDBUF: fd %d sndbuf %d", qfd, sndbuf);
+    _IOCTL (qfd, TUNSETSNDBUF, &sndbuf);
+  }
 
+  /* offloads are per device, set through the first queue */
   tap_log_dbg (vif, "TUNSETOFFLOAD: fd %d offload 0x%lx", tfd, offload);
   _IOCTL (tfd, TUNSETOFFLOAD, offload);
 
@@ -556,7 +583,8 @@ tap_create_if (vlib_main_t * vm, tap_create_if_args_t * args)
 			fd, file.index, file.fd);
       _IOCTL (fd, VHOST_SET_VRING_KICK, &file);
 
-      file.fd = tfd;
+      /* tx queues beyond the rx ones share a tap queue */
+      file.fd = vif->tap_fds[qp % vec_len (vif->tap_fds)];
       virtio_log_debug (vif, "VHOST_NET_SET_BACKEND fd %d index %u tap_fd %d",
 			fd, file.index, file.fd);
       _IOCTL (fd, VHOST_NET_SET_BACKEND, &file);
@@ -695,7 +723,7 @@ tap_csum_offload_enable_disable (vlib_main_t * vm, u32 sw_if_index,
   const unsigned int csum_offload_on = TUN_F_CSUM;
   const unsigned int csum_offload_off = 0;
   unsigned int offload = enable_disable ? csum_offload_on : csum_offload_off;
-  _IOCTL (vif->tap_fd, TUNSETOFFLOAD, offload);
+  _IOCTL (vif->tap_fds[0], TUNSETOFFLOAD, offload);
   vif->gso_enabled = 0;
   vif->csum_offload_enabled = enable_disable ? 1 : 0;
 
@@ -747,10 +775,10 @@ tap_gso_enable_disable (vlib_main_t * vm, u32 sw_if_index, int enable_disable)
 
   vif = pool_elt_at_index (mm->interfaces, hw->dev_instance);
 
-  const unsigned int gso_on = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
+  const unsigned int gso_on = TAP_GSO_OFFLOAD;
   const unsigned int gso_off = 0;
   unsigned int offload = enable_disable ? gso_on : gso_off;
-  _IOCTL (vif->tap_fd, TUNSETOFFLOAD, offload);
+  _IOCTL (vif->tap_fds[0], TUNSETOFFLOAD, offload);
   vif->gso_enabled = enable_disable ? 1 : 0;
   vif->csum_offload_enabled = 0;
   if (enable_disable)
@@ -72,6 +72,49 @@ format_virtio_tx_trace (u8 * s, va_list * args)
   return s;
 }
 
+/* completed buffers are only reclaimed when the ring fills up past this
+   point, so they are freed in few large batches instead of a small chunk
+   on every call */
+#define VIRTIO_TX_RECLAIM_THRESHOLD(vring) ((vring)->size / 2)
+
+/* number of used elements, starting at the one at index last, which
+   complete consecutive descriptors starting with slot */
+static_always_inline u16
+virtio_used_run_length (virtio_vring_t * vring, u16 last, u16 slot,
+			u16 n_left)
+{
+  struct vring_used_elem *used = vring->used->ring;
+  u16 sz = vring->size;
+  u16 mask = sz - 1;
+  u16 n = 1;
+
+  while (n < n_left)
+    {
+#ifdef CLIB_HAVE_VEC256
+      /* 4 elements at once, unless the used ring or the slots wrap */
+      if (n + 4 <= n_left && ((last + n) & mask) + 4 <= sz &&
+	  slot + n + 4 <= sz)
+	{
+	  const u32x8 id_mask = { ~0, 0, ~0, 0, ~0, 0, ~0, 0 };
+	  const u32x8 ids = { 0, 0, 1, 0, 2, 0, 3, 0 };
+	  u32x8 e = u32x8_load_unaligned (used + ((last + n) & mask));
+	  u32x8 expected = (u32x8_splat (slot + n) & id_mask) + ids;
+
+	  if (u32x8_is_equal (e & id_mask, expected))
+	    {
+	      n += 4;
+	      continue;
+	    }
+	}
+#endif
+      if (used[(last + n) & mask].id != ((slot + n) & mask))
+	break;
+      n++;
+    }
+
+  return n;
+}
+
 static_always_inline void
 virtio_free_used_device_desc (vlib_main_t * vm, virtio_vring_t * vring)
 {
@@ -84,34 +127,17 @@ virtio_free_used_device_desc (vlib_main_t * vm, virtio_vring_t * vring)
   if (n_left == 0)
     return;
 
+  /* descriptors are mostly completed in order, free them by runs of
+     consecutive slots, wrapping around the end of the ring */
   while (n_left)
     {
-      struct vring_used_elem *e = &vring->used->ring[last & mask];
-      u16 slot, n_buffers;
-      slot = n_buffers = e->id;
+      u16 slot = vring->used->ring[last & mask].id;
+      u16 n_buffers = virtio_used_run_length (vring, last, slot, n_left);
 
-      while (e->id == n_buffers)
-	{
-	  n_left--;
-	  last++;
-	  n_buffers++;
-	  if (n_left == 0)
-	    break;
-	  e = &vring->used->ring[last & mask];
-	}
-      vlib_buffer_free_from_ring (vm, vring->buffers, slot,
-				  sz, (n_buffers - slot));
-      used -= (n_buffers - slot);
-
-      if (n_left > 0)
-	{
-	  slot = e->id;
-
-	  vlib_buffer_free (vm, &vring->buffers[slot], 1);
-	  used--;
-	  last++;
-	  n_left--;
-	}
+      vlib_buffer_free_from_ring (vm, vring->buffers, slot, sz, n_buffers);
+      used -= n_buffers;
+      last += n_buffers;
+      n_left -= n_buffers;
     }
   vring->desc_in_use = used;
   vring->last_used_idx = last;
@@ -322,8 +348,9 @@ virtio_interface_tx_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       (vring->last_kick_avail_idx != vring->avail->idx))
     virtio_kick (vm, vring, vif);
 
-  /* free consumed buffers */
-  virtio_free_used_device_desc (vm, vring);
+  /* free consumed buffers, in batches */
+  if (vring->desc_in_use + n_left > VIRTIO_TX_RECLAIM_THRESHOLD (vring))
+    virtio_free_used_device_desc (vm, vring);
 
   used = vring->desc_in_use;
   next = vring->desc_next;
@@ -29,7 +29,9 @@
 
 #include <linux/if_arp.h>
 #include <linux/if_tun.h>
+#include <linux/mempolicy.h>
 
+#include <vppinfra/linux/syscall.h>
 #include <vlib/vlib.h>
 #include <vlib/unix/unix.h>
 
@@ -70,6 +72,21 @@ get_huge_page_size (int fd)
   return s.f_bsize;
 }
 
+static u64
+vhost_user_user_addr_to_guest_phys (vhost_user_intf_t * vui, uword addr)
+{
+  int i;
+  for (i = 0; i < vui->nregions; i++)
+    {
+      if ((vui->regions[i].userspace_addr <= addr) &&
+	  ((vui->regions[i].userspace_addr + vui->regions[i].memory_size) >
+	   addr))
+	return vui->regions[i].guest_phys_addr + addr -
+	  vui->regions[i].userspace_addr;
+    }
+  return 0;
+}
+
 static void
 unmap_all_mem_regions (vhost_user_intf_t * vui)
 {
@@ -106,6 +123,7 @@ unmap_all_mem_regions (vhost_user_intf_t * vui)
 	}
     }
   vui->nregions = 0;
+  vui->numa_node = ~0;
 
   for (q = 0; q < VHOST_VRING_MAX_N; q++)
     {
@@ -153,6 +171,82 @@ vhost_user_tx_thread_placement (vhost_user_intf_t * vui)
     }
 }
 
+/**
+ * @brief Numa node of the largest guest memory region, where most of the
+ * guest buffers live
+ */
+static u32
+vhost_user_mem_numa_node (vhost_user_intf_t * vui)
+{
+  u64 max_size = 0;
+  void *addr = 0;
+  int i, node;
+
+  for (i = 0; i < vui->nregions; i++)
+    if (vui->regions[i].memory_size > max_size)
+      {
+	max_size = vui->regions[i].memory_size;
+	addr = vui->region_mmap_addr[i];
+      }
+
+  if (addr == 0 ||
+      get_mempolicy (&node, 0, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) < 0)
+    return ~0;
+
+  return node;
+}
+
+/**
+ * @brief Pick the thread polling a new rx queue: among the workers local
+ * to the guest memory, if any, the one with the fewest vhost-user queues,
+ * then with the lowest measured vhost-user-input vectors per call.
+ * Returns ~0 for the default round-robin placement.
+ */
+u32
+vhost_user_rx_thread_select (vhost_user_intf_t * vui)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  u32 best = ~0, best_n_queues = ~0, best_load = ~0;
+  u32 thread_index;
+  int numa_local = 0;
+
+  if (vum->round_robin_placement || tm->n_vlib_mains == 1)
+    return ~0;
+
+  for (thread_index = 1; thread_index < tm->n_vlib_mains; thread_index++)
+    if (vlib_mains[thread_index]->numa_node == vui->numa_node)
+      numa_local = 1;
+
+  for (thread_index = 1; thread_index < tm->n_vlib_mains; thread_index++)
+    {
+      vlib_main_t *vm = vlib_mains[thread_index];
+      vnet_device_input_runtime_t *rt;
+      vlib_node_runtime_t *node;
+      u32 n_queues, load = 0;
+
+      if (numa_local && vm->numa_node != vui->numa_node)
+	continue;
+
+      rt = vlib_node_get_runtime_data (vm, vhost_user_input_node.index);
+      n_queues = vec_len (rt->devices_and_queues);
+      node = vlib_node_get_runtime (vm, vhost_user_input_node.index);
+      if (node->calls_since_last_overflow)
+	load = node->vectors_since_last_overflow /
+	  node->calls_since_last_overflow;
+
+      if (n_queues < best_n_queues ||
+	  (n_queues == best_n_queues && load < best_load))
+	{
+	  best = thread_index;
+	  best_n_queues = n_queues;
+	  best_load = load;
+	}
+    }
+
+  return best;
+}
+
 /**
  * @brief Unassign existing interface/queue to thread mappings and re-assign
  * new interface/queue to thread mappings
@@ -169,7 +263,8 @@ vhost_user_rx_thread_placement (vhost_user_intf_t * vui, u32 qid)
   // Assign new queue mappings for the interface
   vnet_hw_interface_set_input_node (vnm, vui->hw_if_index,
 				    vhost_user_input_node.index);
-  vnet_hw_interface_assign_rx_thread (vnm, vui->hw_if_index, q, ~0);
+  vnet_hw_interface_assign_rx_thread (vnm, vui->hw_if_index, q,
+				      vhost_user_rx_thread_select (vui));
   if (txvq->mode == VNET_HW_INTERFACE_RX_MODE_UNKNOWN)
     /* Set polling as the default */
     txvq->mode = VNET_HW_INTERFACE_RX_MODE_POLLING;
@@ -285,6 +380,10 @@ vhost_user_vring_init (vhost_user_intf_t * vui, u32 qid)
   vring->callfd_idx = ~0;
   vring->errfd = -1;
   vring->qid = -1;
+  vring->int_threshold = vhost_user_main.coalesce_frames;
+  /* packed ring wrap counters start at 1 */
+  vring->avail_wrap_counter = 1;
+  vring->used_wrap_counter = 1;
 
   /*
    * We have a bug with some qemu 2.5, and this may be a fix.
@@ -466,6 +565,8 @@ vhost_user_socket_read (clib_file_t * uf)
 
       if (vui->enable_gso)
 	msg.u64 |= FEATURE_VIRTIO_NET_F_HOST_GUEST_TSO_FEATURE_BITS;
+      if (vui->enable_packed)
+	msg.u64 |= (1ULL << FEAT_VIRTIO_F_RING_PACKED);
 
       msg.size = sizeof (msg.u64);
       vu_log_debug (vui, "if %d msg VHOST_USER_GET_FEATURES - reply "
@@ -571,6 +672,7 @@ vhost_user_socket_read (clib_file_t * uf)
 
 	  vui->nregions++;
 	}
+      vui->numa_node = vhost_user_mem_numa_node (vui);
 
       /*
        * Re-compute desc, used, and avail descriptor table if vring address
@@ -644,18 +746,26 @@ vhost_user_socket_read (clib_file_t * uf)
       vui->vrings[msg.state.index].log_guest_addr = msg.addr.log_guest_addr;
       vui->vrings[msg.state.index].log_used =
 	(msg.addr.flags & (1 << VHOST_VRING_F_LOG)) ? 1 : 0;
+      /* used entries of a packed ring are written in the descriptor table */
+      vui->vrings[msg.state.index].desc_guest_addr =
+	vhost_user_user_addr_to_guest_phys (vui, msg.addr.desc_user_addr);
 
       /* Spec says: If VHOST_USER_F_PROTOCOL_FEATURES has not been negotiated,
          the ring is initialized in an enabled state. */
       if (!(vui->features & (1 << FEAT_VHOST_USER_F_PROTOCOL_FEATURES)))
 	vui->vrings[msg.state.index].enabled = 1;
 
-      vui->vrings[msg.state.index].last_used_idx =
-	vui->vrings[msg.state.index].last_avail_idx =
-	vui->vrings[msg.state.index].used->idx;
+      /*
+       * The packed ring has no used index, its position comes from
+       * VHOST_USER_SET_VRING_BASE only.
+       */
+      if (!vhost_user_is_packed_ring_supported (vui))
+	vui->vrings[msg.state.index].last_used_idx =
+	  vui->vrings[msg.state.index].last_avail_idx =
+	  vui->vrings[msg.state.index].used->idx;
 
       /* tell driver that we don't want interrupts */
-      vui->vrings[msg.state.index].used->flags = VRING_USED_F_NO_NOTIFY;
+      vhost_user_vring_set_notify (vui, &vui->vrings[msg.state.index], 0);
       vlib_worker_thread_barrier_release (vm);
       vhost_user_update_iface_state (vui);
       break;
@@ -765,7 +875,20 @@ vhost_user_socket_read (clib_file_t * uf)
       vu_log_debug (vui, "if %d msg VHOST_USER_SET_VRING_BASE idx %d num %d",
 		    vui->hw_if_index, msg.state.index, msg.state.num);
       vlib_worker_thread_barrier_sync (vm);
-      vui->vrings[msg.state.index].last_avail_idx = msg.state.num;
+      if (vhost_user_is_packed_ring_supported (vui))
+	{
+	  /*
+	   * Packed ring: bits 0-14 are the next available descriptor, bit 15
+	   * the avail wrap counter. All used entries are always written back
+	   * when the data path returns, so the used position is the same.
+	   */
+	  vhost_user_vring_t *vq = &vui->vrings[msg.state.index];
+	  vq->last_avail_idx = vq->last_used_idx = msg.state.num & 0x7fff;
+	  vq->avail_wrap_counter = vq->used_wrap_counter =
+	    (msg.state.num >> 15) & 1;
+	}
+      else
+	vui->vrings[msg.state.index].last_avail_idx = msg.state.num;
       vlib_worker_thread_barrier_release (vm);
       break;
 
@@ -784,6 +907,13 @@ vhost_user_socket_read (clib_file_t * uf)
        * closing the vring also initializes the vring last_avail_idx
        */
       msg.state.num = vui->vrings[msg.state.index].last_avail_idx;
+      if (vhost_user_is_packed_ring_supported (vui))
+	{
+	  /* bits 16-31 carry the used index and used wrap counter */
+	  vhost_user_vring_t *vq = &vui->vrings[msg.state.index];
+	  msg.state.num = vq->last_avail_idx | (vq->avail_wrap_counter << 15) |
+	    ((vq->last_used_idx | (vq->used_wrap_counter << 15)) << 16);
+	}
       msg.flags |= 4;
       msg.size = sizeof (msg.state);
 
@@ -997,6 +1127,7 @@ vhost_user_init (vlib_main_t * vm)
 
   vum->coalesce_frames = 32;
   vum->coalesce_time = 1e-3;
+  vum->coalesce_frames_max = 256;
 
   vec_validate (vum->cpus, tm->n_vlib_mains - 1);
 
@@ -1068,7 +1199,7 @@ vhost_user_send_interrupt_process (vlib_main_t * vm,
 	  /* *INDENT-OFF* */
 	  pool_foreach (vui, vum->vhost_user_interfaces, {
 	      next_timeout = timeout;
-	      for (qid = 0; qid < VHOST_VRING_MAX_N / 2; qid += 2)
+	      for (qid = 0; qid < VHOST_VRING_MAX_N; qid += 2)
 		{
 		  vhost_user_vring_t *rxvq = &vui->vrings[qid];
 		  vhost_user_vring_t *txvq = &vui->vrings[qid + 1];
@@ -1078,7 +1209,7 @@ vhost_user_send_interrupt_process (vlib_main_t * vm,
 		  if (txvq->n_since_last_int)
 		    {
 		      if (now >= txvq->int_deadline)
-			vhost_user_send_call (vm, txvq);
+			vhost_user_send_call (vm, txvq, now);
 		      else
 			next_timeout = txvq->int_deadline - now;
 		    }
@@ -1086,7 +1217,7 @@ vhost_user_send_interrupt_process (vlib_main_t * vm,
 		  if (rxvq->n_since_last_int)
 		    {
 		      if (now >= rxvq->int_deadline)
-			vhost_user_send_call (vm, rxvq);
+			vhost_user_send_call (vm, rxvq, now);
 		      else
 			next_timeout = rxvq->int_deadline - now;
 		    }
@@ -1440,7 +1571,8 @@ vhost_user_vui_init (vnet_main_t * vnm,
 		     vhost_user_intf_t * vui,
 		     int server_sock_fd,
 		     const char *sock_filename,
-		     u64 feature_mask, u32 * sw_if_index, u8 enable_gso)
+		     u64 feature_mask, u32 * sw_if_index, u8 enable_gso,
+		     u8 enable_packed)
 {
   vnet_sw_interface_t *sw;
   int q;
@@ -1470,8 +1602,10 @@ vhost_user_vui_init (vnet_main_t * vnm,
   vui->feature_mask = feature_mask;
   vui->clib_file_index = ~0;
   vui->log_base_addr = 0;
+  vui->numa_node = ~0;
   vui->if_index = vui - vum->vhost_user_interfaces;
   vui->enable_gso = enable_gso;
+  vui->enable_packed = enable_packed;
   /*
    * enable_gso takes precedence over configurable feature mask if there
    * is a clash.
@@ -1519,7 +1653,7 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      u32 * sw_if_index,
 		      u64 feature_mask,
 		      u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
-		      u8 enable_gso)
+		      u8 enable_gso, u8 enable_packed)
 {
   vhost_user_intf_t *vui = NULL;
   u32 sw_if_idx = ~0;
@@ -1560,7 +1694,7 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
   vlib_worker_thread_barrier_release (vm);
 
   vhost_user_vui_init (vnm, vui, server_sock_fd, sock_filename,
-		       feature_mask, &sw_if_idx, enable_gso);
+		       feature_mask, &sw_if_idx, enable_gso, enable_packed);
   vnet_sw_interface_set_mtu (vnm, vui->sw_if_index, 9000);
   vhost_user_rx_thread_placement (vui, 1);
 
@@ -1582,7 +1716,7 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      u8 is_server,
 		      u32 sw_if_index,
 		      u64 feature_mask, u8 renumber, u32 custom_dev_instance,
-		      u8 enable_gso)
+		      u8 enable_gso, u8 enable_packed)
 {
   vhost_user_main_t *vum = &vhost_user_main;
   vhost_user_intf_t *vui = NULL;
@@ -1619,7 +1753,8 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 
   vhost_user_term_if (vui);
   vhost_user_vui_init (vnm, vui, server_sock_fd,
-		       sock_filename, feature_mask, &sw_if_idx, enable_gso);
+		       sock_filename, feature_mask, &sw_if_idx, enable_gso,
+		       enable_packed);
 
   if (renumber)
     vnet_interface_name_renumber (sw_if_idx, custom_dev_instance);
@@ -1646,6 +1781,7 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   u8 *hw = NULL;
   clib_error_t *error = NULL;
   u8 enable_gso = 0;
+  u8 enable_packed = 0;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -1661,6 +1797,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
 	is_server = 1;
       else if (unformat (line_input, "gso"))
 	enable_gso = 1;
+      else if (unformat (line_input, "packed"))
+	enable_packed = 1;
       else if (unformat (line_input, "feature-mask 0x%llx", &feature_mask))
 	;
       else
@@ -1685,7 +1823,7 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   if ((rv = vhost_user_create_if (vnm, vm, (char *) sock_filename,
 				  is_server, &sw_if_index, feature_mask,
 				  renumber, custom_dev_instance, hw,
-				  enable_gso)))
+				  enable_gso, enable_packed)))
     {
       error = clib_error_return (0, "vhost_user_create_if returned %d", rv);
       goto done;
@@ -1871,6 +2009,13 @@ show_vhost_user_command_fn (vlib_main_t * vm,
   vlib_cli_output (vm, "Virtio vhost-user interfaces");
   vlib_cli_output (vm, "Global:\n  coalesce frames %d time %e",
 		   vum->coalesce_frames, vum->coalesce_time);
+  if (vum->coalesce_adaptive)
+    vlib_cli_output (vm, "  adaptive coalescing, max frames %d",
+		     vum->coalesce_frames_max);
+  else
+    vlib_cli_output (vm, "  fixed coalescing");
+  vlib_cli_output (vm, "  rx placement: %s",
+		   vum->round_robin_placement ? "round-robin" : "numa");
   vlib_cli_output (vm, "  Number of rx virtqueues in interrupt mode: %d",
 		   vum->ifq_count);
   vlib_cli_output (vm, "  Number of GSO interfaces: %d", vum->gso_count);
@@ -1884,6 +2029,8 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 		       hw_if_indices[i]);
       if (vui->enable_gso)
 	vlib_cli_output (vm, "  GSO enable");
+      if (vui->enable_packed)
+	vlib_cli_output (vm, "  Packed ring enable");
 
       vlib_cli_output (vm, "virtio_net_hdr_sz %d\n"
 		       " features mask (0x%llx): \n"
@@ -1918,9 +2065,12 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 		       (vui->unix_server_index != ~0) ? "server" : "client",
 		       strerror (vui->sock_errno));
 
+      if (vui->numa_node != ~0)
+	vlib_cli_output (vm, " guest memory numa node %u\n", vui->numa_node);
+
       vlib_cli_output (vm, " rx placement: ");
 
-      for (qid = 1; qid < VHOST_VRING_MAX_N / 2; qid += 2)
+      for (qid = 1; qid < VHOST_VRING_MAX_N; qid += 2)
 	{
 	  vnet_main_t *vnm = vnet_get_main ();
 	  uword thread_index;
@@ -1985,7 +2135,18 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 			   vui->vrings[q].last_avail_idx,
 			   vui->vrings[q].last_used_idx);
 
-	  if (vui->vrings[q].avail && vui->vrings[q].used)
+	  if (vhost_user_is_packed_ring_supported (vui))
+	    {
+	      if (vui->vrings[q].avail_event && vui->vrings[q].used_event)
+		vlib_cli_output (vm,
+				 "  avail wrap %u used wrap %u driver event "
+				 "flags %x device event flags %x\n",
+				 vui->vrings[q].avail_wrap_counter,
+				 vui->vrings[q].used_wrap_counter,
+				 vui->vrings[q].avail_event->flags,
+				 vui->vrings[q].used_event->flags);
+	    }
+	  else if (vui->vrings[q].avail && vui->vrings[q].used)
 	    vlib_cli_output (vm,
 			     "  avail.flags %x avail.idx %d used.flags %x used.idx %d\n",
 			     vui->vrings[q].avail->flags,
@@ -1997,8 +2158,32 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 	  int callfd = UNIX_GET_FD (vui->vrings[q].callfd_idx);
 	  vlib_cli_output (vm, "  kickfd %d callfd %d errfd %d\n",
 			   kickfd, callfd, vui->vrings[q].errfd);
+	  vlib_cli_output (vm, "  calls %lu coalesce frames %u\n",
+			   vui->vrings[q].n_calls,
+			   vui->vrings[q].int_threshold);
 
-	  if (show_descr)
+	  if (show_descr && vhost_user_is_packed_ring_supported (vui))
+	    {
+	      vring_packed_desc_t *desc = vui->vrings[q].packed_desc;
+
+	      vlib_cli_output (vm, "\n  descriptor table:\n");
+	      vlib_cli_output (vm,
+			       "   slot        addr         len  flags  id        user_addr\n");
+	      vlib_cli_output (vm,
+			       "  ===== ================== ===== ====== ===== ==================\n");
+	      for (j = 0; j < vui->vrings[q].qsz_mask + 1; j++)
+		{
+		  u32 mem_hint = 0;
+		  vlib_cli_output (vm,
+				   "  %-5d 0x%016lx %-5d 0x%04x %-5d 0x%016lx\n",
+				   j, desc[j].addr, desc[j].len,
+				   desc[j].flags, desc[j].id,
+				   pointer_to_uword (map_guest_mem
+						     (vui, desc[j].addr,
+						      &mem_hint)));
+		}
+	    }
+	  else if (show_descr)
 	    {
 	      vlib_cli_output (vm, "\n  descriptor table:\n");
 	      vlib_cli_output (vm,
@@ -2073,6 +2258,11 @@ done:
  * in the name to be specified. If instance already exists, name will be used
  * anyway and multiple instances will have the same name. Use with caution.
  *
+ * - <b>packed</b> - Optional flag to offer the packed virtqueue layout
+ * (VIRTIO_F_RING_PACKED). The driver picks packed or split rings during
+ * feature negotiation, eg. qemu with '<em>packed=on</em>' on the
+ * virtio-net device.
+ *
  * @cliexpar
  * Example of how to create a vhost interface with VPP as the client and all features enabled:
  * @cliexstart{create vhost-user socket /var/run/vpp/vhost1.sock}
@@ -2090,7 +2280,8 @@ done:
 VLIB_CLI_COMMAND (vhost_user_connect_command, static) = {
     .path = "create vhost-user",
     .short_help = "create vhost-user socket <socket-filename> [server] "
-    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] [gso]",
+    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] [gso] "
+    "[packed]",
     .function = vhost_user_connect_command_fn,
     .is_mp_safe = 1,
 };
@@ -2256,6 +2447,100 @@ VLIB_CLI_COMMAND (show_vhost_user_command, static) = {
 };
 /* *INDENT-ON* */
 
+/**
+ * @brief Switch between fixed and adaptive call coalescing. The vrings
+ * restart from the coalesce-frames threshold.
+ */
+void
+vhost_user_set_coalesce_adaptive (u8 enable)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vhost_user_intf_t *vui;
+  u32 q;
+
+  vum->coalesce_adaptive = enable;
+
+  /* *INDENT-OFF* */
+  pool_foreach (vui, vum->vhost_user_interfaces, {
+    for (q = 0; q < VHOST_VRING_MAX_N; q++)
+      vui->vrings[q].int_threshold = vum->coalesce_frames;
+  });
+  /* *INDENT-ON* */
+}
+
+static clib_error_t *
+vhost_user_coalesce_command_fn (vlib_main_t * vm,
+				unformat_input_t * input,
+				vlib_cli_command_t * cmd)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  unformat_input_t _line_input, *line_input = &_line_input;
+  clib_error_t *error = 0;
+  u32 frames_max = 0;
+  int enable = -1;
+
+  /* Get a line of input. */
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, "expected adaptive or fixed");
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "adaptive"))
+	enable = 1;
+      else if (unformat (line_input, "fixed"))
+	enable = 0;
+      else if (unformat (line_input, "frames-max %u", &frames_max))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (enable < 0)
+    {
+      error = clib_error_return (0, "expected adaptive or fixed");
+      goto done;
+    }
+  if (frames_max)
+    {
+      if (frames_max < vum->coalesce_frames)
+	{
+	  error = clib_error_return (0, "frames-max below coalesce frames %u",
+				     vum->coalesce_frames);
+	  goto done;
+	}
+      vum->coalesce_frames_max = frames_max;
+    }
+
+  vhost_user_set_coalesce_adaptive (enable);
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+/*?
+ * Select fixed or adaptive guest call coalescing. Fixed coalescing, the
+ * default, calls the guest after coalesce-frames frames or coalesce-time
+ * seconds. Adaptive coalescing lets the frames threshold of each vring
+ * grow towards frames-max while the vring is busy.
+ *
+ * @cliexpar
+ * @cliexcmd{set vhost-user coalesce adaptive frames-max 128}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (vhost_user_coalesce_command, static) = {
+    .path = "set vhost-user coalesce",
+    .short_help = "set vhost-user coalesce {adaptive|fixed} "
+    "[frames-max <n>]",
+    .function = vhost_user_coalesce_command_fn,
+};
+/* *INDENT-ON* */
+
 
 static clib_error_t *
 vhost_user_config (vlib_main_t * vm, unformat_input_t * input)
@@ -2268,6 +2553,13 @@ vhost_user_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "coalesce-time %f", &vum->coalesce_time))
 	;
+      else if (unformat (input, "coalesce-frames-max %d",
+			 &vum->coalesce_frames_max))
+	;
+      else if (unformat (input, "coalesce-adaptive"))
+	vum->coalesce_adaptive = 1;
+      else if (unformat (input, "round-robin-placement"))
+	vum->round_robin_placement = 1;
       else if (unformat (input, "dont-dump-memory"))
 	vum->dont_dump_vhost_user_memory = 1;
       else
@@ -25,6 +25,7 @@
 
 #define VHOST_USER_VRING_NOFD_MASK      0x100
 #define VIRTQ_DESC_F_NEXT               1
+#define VIRTQ_DESC_F_WRITE              2
 #define VIRTQ_DESC_F_INDIRECT           4
 #define VHOST_USER_REPLY_MASK       (0x1 << 2)
 
@@ -45,6 +46,15 @@
 #define VRING_USED_F_NO_NOTIFY  1
 #define VRING_AVAIL_F_NO_INTERRUPT 1
 
+/* packed ring descriptor flags */
+#define VRING_DESC_F_AVAIL (1 << 7)
+#define VRING_DESC_F_USED  (1 << 15)
+
+/* packed ring event suppression flags */
+#define VRING_EVENT_F_ENABLE  0x0
+#define VRING_EVENT_F_DISABLE 0x1
+#define VRING_EVENT_F_DESC    0x2
+
 #define vu_log_debug(dev, f, ...) \
 {                                                                             \
   vlib_log(VLIB_LOG_LEVEL_DEBUG, vhost_user_main.log_default, "%U: " f,       \
@@ -101,7 +111,8 @@ typedef enum
  _ (VIRTIO_F_ANY_LAYOUT, 27)            \
  _ (VIRTIO_F_INDIRECT_DESC, 28)         \
  _ (VHOST_USER_F_PROTOCOL_FEATURES, 30) \
- _ (VIRTIO_F_VERSION_1, 32)
+ _ (VIRTIO_F_VERSION_1, 32)            \
+ _ (VIRTIO_F_RING_PACKED, 34)
 
 typedef enum
 {
@@ -130,12 +141,12 @@ int vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 * sw_if_index, u64 feature_mask,
 			  u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
-			  u8 enable_gso);
+			  u8 enable_gso, u8 enable_packed);
 int vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 sw_if_index, u64 feature_mask,
 			  u8 renumber, u32 custom_dev_instance,
-			  u8 enable_gso);
+			  u8 enable_gso, u8 enable_packed);
 int vhost_user_delete_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  u32 sw_if_index);
 
@@ -223,6 +234,22 @@ typedef struct
     } ring[VHOST_VRING_MAX_SIZE];
 } __attribute ((packed)) vring_used_t;
 
+// packed ring descriptor, the same table carries available and used entries
+typedef struct
+{
+  uint64_t addr;  // packet data buffer address
+  uint32_t len;   // packet data buffer size
+  uint16_t id;    // buffer id
+  uint16_t flags; // (see below)
+} __attribute ((packed)) vring_packed_desc_t;
+
+// packed ring driver and device event suppression areas
+typedef struct
+{
+  uint16_t off_wrap;
+  volatile uint16_t flags;
+} __attribute ((packed)) vring_desc_event_t;
+
 typedef struct
 {
   u8 flags;
@@ -260,22 +287,44 @@ typedef struct
   u16 last_avail_idx;
   u16 last_used_idx;
   u16 n_since_last_int;
-  vring_desc_t *desc;
-  vring_avail_t *avail;
-  vring_used_t *used;
+  union
+  {
+    vring_desc_t *desc;
+    vring_packed_desc_t *packed_desc;
+  };
+  union
+  {
+    vring_avail_t *avail;
+    /* packed ring: driver area, tells whether the driver wants calls */
+    vring_desc_event_t *avail_event;
+  };
+  union
+  {
+    vring_used_t *used;
+    /* packed ring: device area, tells whether we want kicks */
+    vring_desc_event_t *used_event;
+  };
   uword desc_user_addr;
   uword used_user_addr;
   uword avail_user_addr;
   f64 int_deadline;
+  /* frames coalesced before calling the driver, adaptive */
+  u16 int_threshold;
   u8 started;
   u8 enabled;
   u8 log_used;
+  /* packed ring wrap counters, 0 or 1 */
+  u8 avail_wrap_counter;
+  u8 used_wrap_counter;
   //Put non-runtime in a different cache line
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
   int errfd;
   u32 callfd_idx;
   u32 kickfd_idx;
+  u64 n_calls;
   u64 log_guest_addr;
+  /* packed ring: guest physical address of the descriptor table */
+  u64 desc_guest_addr;
 
   /* The rx queue policy (interrupt/adaptive/polling) for this queue */
   u32 mode;
@@ -316,6 +365,8 @@ typedef struct
   u64 region_guest_addr_lo[VHOST_MEMORY_MAX_NREGIONS];
   u64 region_guest_addr_hi[VHOST_MEMORY_MAX_NREGIONS];
   u32 region_mmap_fd[VHOST_MEMORY_MAX_NREGIONS];
+  /* numa node holding most of the guest memory, ~0 if unknown */
+  u32 numa_node;
 
   //Virtual rings
   vhost_user_vring_t vrings[VHOST_VRING_MAX_N];
@@ -332,6 +383,9 @@ typedef struct
   u16 *per_cpu_tx_qid;
 
   u8 enable_gso;
+
+  /* Offer VIRTIO_F_RING_PACKED during feature negotiation */
+  u8 enable_packed;
 } vhost_user_intf_t;
 
 typedef struct
@@ -354,6 +408,19 @@ typedef struct
 #define VHOST_USER_RX_BUFFERS_N (2 * VLIB_FRAME_SIZE + 2)
 #define VHOST_USER_COPY_ARRAY_N (4 * VLIB_FRAME_SIZE)
 
+/*
+ * Max number of merged descriptor chains a packet can use on a packed
+ * ring, enough for a 64kB GSO packet in 1518 bytes guest buffers.
+ */
+#define VHOST_USER_TX_CHAINS_N 64
+
+typedef struct
+{
+  u32 len;
+  u16 id;
+  u16 n_descs;
+} vhost_user_tx_chain_t;
+
 typedef struct
 {
   u32 rx_buffers_len;
@@ -362,6 +429,9 @@ typedef struct
   virtio_net_hdr_mrg_rxbuf_t tx_headers[VLIB_FRAME_SIZE];
   vhost_copy_t copy[VHOST_USER_COPY_ARRAY_N];
 
+  /* packed ring: descriptor chains filled by the packet being sent */
+  vhost_user_tx_chain_t tx_chains[VHOST_USER_TX_CHAINS_N];
+
   /* This is here so it doesn't end-up
    * using stack or registers. */
   vhost_trace_t *current_trace;
@@ -375,6 +445,12 @@ typedef struct
   u32 *show_dev_instance_by_real_dev_instance;
   u32 coalesce_frames;
   f64 coalesce_time;
+  /* adapt the frames threshold of each vring to its load, between
+     coalesce_frames and coalesce_frames_max */
+  u8 coalesce_adaptive;
+  u32 coalesce_frames_max;
+  /* place rx queues on any worker, regardless of numa and load */
+  u8 round_robin_placement;
   int dont_dump_vhost_user_memory;
 
   /** Per-CPU data for vhost-user */
@@ -407,6 +483,8 @@ typedef struct
 
 int vhost_user_dump_ifs (vnet_main_t * vnm, vlib_main_t * vm,
 			 vhost_user_intf_details_t ** out_vuids);
+u32 vhost_user_rx_thread_select (vhost_user_intf_t * vui);
+void vhost_user_set_coalesce_adaptive (u8 enable);
 
 extern vlib_node_registration_t vhost_user_send_interrupt_node;
 extern vnet_device_class_t vhost_user_device_class;
@@ -206,6 +206,16 @@ vhost_user_log_dirty_pages_2 (vhost_user_intf_t * vui,
                              sizeof(vq->used->member), 0); \
   }
 
+static_always_inline void
+vhost_user_log_dirty_packed_desc (vhost_user_intf_t * vui,
+				  vhost_user_vring_t * vq, u16 slot)
+{
+  if (PREDICT_FALSE (vq->log_used))
+    vhost_user_log_dirty_pages_2 (vui, vq->desc_guest_addr +
+				  slot * sizeof (vring_packed_desc_t),
+				  sizeof (vring_packed_desc_t), 0);
+}
+
 static_always_inline u8 *
 format_vhost_trace (u8 * s, va_list * va)
 {
@@ -248,8 +258,42 @@ format_vhost_trace (u8 * s, va_list * va)
   return s;
 }
 
+/*
+ * Adaptive coalescing: the frames threshold doubles while the calls are
+ * triggered by the frames count well before the coalesce time, and halves
+ * when the time limit triggers them. Busy vrings get fewer calls and quiet
+ * ones keep a low latency. The threshold stays below half the ring so that
+ * the driver is not starved.
+ */
 static_always_inline void
-vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq)
+vhost_user_adapt_int_threshold (vhost_user_vring_t * vq, f64 now)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  u32 max = clib_min (vum->coalesce_frames_max, (vq->qsz_mask + 1) / 2);
+  u32 threshold = vq->int_threshold;
+
+  if (now < vq->int_deadline - vum->coalesce_time / 2)
+    threshold = clib_max (threshold * 2, 1);
+  else if (now >= vq->int_deadline)
+    threshold /= 2;
+
+  vq->int_threshold = clib_max (clib_min (threshold, max),
+				vum->coalesce_frames);
+}
+
+/*
+ * Dispatch time of the running node: the coalescing deadlines do not need
+ * a fresh time stamp for each vring.
+ */
+static_always_inline f64
+vhost_user_node_time (vlib_main_t * vm)
+{
+  return vlib_time_now_ticks (vm, vm->cpu_time_last_node_dispatch) +
+    vm->time_offset;
+}
+
+static_always_inline void
+vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq, f64 now)
 {
   vhost_user_main_t *vum = &vhost_user_main;
   u64 x = 1;
@@ -264,8 +308,34 @@ vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq)
       return;
     }
 
+  if (vum->coalesce_adaptive)
+    vhost_user_adapt_int_threshold (vq, now);
+
+  vq->n_calls++;
   vq->n_since_last_int = 0;
-  vq->int_deadline = vlib_time_now (vm) + vum->coalesce_time;
+  vq->int_deadline = now + vum->coalesce_time;
+}
+
+/*
+ * Account n_packets handed to the driver and call it when the frames
+ * threshold is crossed. In adaptive mode, a vring that was not called for
+ * the whole coalesce time is called right away: the first packets after a
+ * quiet period are not delayed. Otherwise the call is left to the
+ * coalescing timer.
+ */
+static_always_inline void
+vhost_user_vring_coalesce_call (vlib_main_t * vm, vhost_user_vring_t * vq,
+				u32 n_packets, f64 now)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+
+  vq->n_since_last_int += n_packets;
+
+  if (vq->n_since_last_int > vq->int_threshold)
+    vhost_user_send_call (vm, vq, now);
+  else if (vum->coalesce_adaptive && vq->n_since_last_int &&
+	   now >= vq->int_deadline)
+    vhost_user_send_call (vm, vq, now);
 }
 
 static_always_inline u8
@@ -274,6 +344,109 @@ vui_is_link_up (vhost_user_intf_t * vui)
   return vui->admin_up && vui->is_ready;
 }
 
+static_always_inline u8
+vhost_user_is_packed_ring_supported (vhost_user_intf_t * vui)
+{
+  return (vui->features & (1ULL << FEAT_VIRTIO_F_RING_PACKED)) ? 1 : 0;
+}
+
+/*
+ * Packed ring: a descriptor is available when its AVAIL bit matches our
+ * avail wrap counter and its USED bit does not.
+ */
+static_always_inline u8
+vhost_user_packed_desc_available (vhost_user_vring_t * vq, u16 idx)
+{
+  u16 flags = clib_atomic_load_acq_n (&vq->packed_desc[idx].flags);
+  u8 avail = (flags & VRING_DESC_F_AVAIL) ? 1 : 0;
+  u8 used = (flags & VRING_DESC_F_USED) ? 1 : 0;
+
+  return (avail == vq->avail_wrap_counter) && (used != avail);
+}
+
+/*
+ * Walk the descriptor chain starting at slot idx of the packed ring.
+ * Returns the number of ring slots it takes and the buffer id, which is
+ * carried by the last descriptor of the chain.
+ */
+static_always_inline u16
+vhost_user_packed_chain (vhost_user_vring_t * vq, u16 idx, u16 * buffer_id)
+{
+  u16 n_descs = 1;
+
+  while ((vq->packed_desc[idx].flags & VIRTQ_DESC_F_NEXT) &&
+	 (n_descs <= vq->qsz_mask))
+    {
+      idx = (idx + 1) & vq->qsz_mask;
+      n_descs++;
+    }
+  *buffer_id = vq->packed_desc[idx].id;
+  return n_descs;
+}
+
+/*
+ * Move to the next descriptor of a packed ring chain. Descriptors of a
+ * chain are contiguous in the ring, or in the indirect table in which case
+ * indirect_n is the number of entries of the table.
+ */
+static_always_inline u8
+vhost_user_packed_desc_next (vring_packed_desc_t * desc_table,
+			     u16 * desc_current, u16 mask, u32 indirect_n)
+{
+  if (indirect_n)
+    {
+      if (*desc_current + 1 >= indirect_n)
+	return 0;
+      *desc_current += 1;
+      return 1;
+    }
+  if (!(desc_table[*desc_current].flags & VIRTQ_DESC_F_NEXT))
+    return 0;
+  *desc_current = (*desc_current + 1) & mask;
+  return 1;
+}
+
+static_always_inline void
+vhost_user_advance_last_avail_idx_packed (vhost_user_vring_t * vq, u16 n)
+{
+  vq->last_avail_idx += n;
+  if (vq->last_avail_idx > vq->qsz_mask)
+    {
+      vq->last_avail_idx -= vq->qsz_mask + 1;
+      vq->avail_wrap_counter ^= 1;
+    }
+}
+
+static_always_inline void
+vhost_user_advance_last_used_idx_packed (vhost_user_vring_t * vq, u16 n)
+{
+  vq->last_used_idx += n;
+  if (vq->last_used_idx > vq->qsz_mask)
+    {
+      vq->last_used_idx -= vq->qsz_mask + 1;
+      vq->used_wrap_counter ^= 1;
+    }
+}
+
+/* Flags of a used descriptor: both AVAIL and USED match the wrap counter */
+static_always_inline u16
+vhost_user_packed_used_flags (vhost_user_vring_t * vq)
+{
+  return vq->used_wrap_counter ? (VRING_DESC_F_AVAIL | VRING_DESC_F_USED) : 0;
+}
+
+/* Tell the driver whether we want to be kicked for new buffers */
+static_always_inline void
+vhost_user_vring_set_notify (vhost_user_intf_t * vui,
+			     vhost_user_vring_t * vq, u8 enable)
+{
+  if (vhost_user_is_packed_ring_supported (vui))
+    vq->used_event->flags =
+      enable ? VRING_EVENT_F_ENABLE : VRING_EVENT_F_DISABLE;
+  else
+    vq->used->flags = enable ? 0 : VRING_USED_F_NO_NOTIFY;
+}
+
 static_always_inline void
 vhost_user_update_gso_interface_count (vhost_user_intf_t * vui, u8 add)
 {
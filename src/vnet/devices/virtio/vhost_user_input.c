@@ -351,6 +351,7 @@ vhost_user_if_input (vlib_main_t * vm,
   u8 feature_arc_idx = fm->device_input_feature_arc_index;
   u32 current_config_index = ~(u32) 0;
   u16 mask = txvq->qsz_mask;
+  f64 now = vhost_user_node_time (vm);
 
   /* The descriptor table is not ready yet */
   if (PREDICT_FALSE (txvq->avail == 0))
@@ -359,13 +360,12 @@ vhost_user_if_input (vlib_main_t * vm,
   {
     /* do we have pending interrupts ? */
     vhost_user_vring_t *rxvq = &vui->vrings[VHOST_VRING_IDX_RX (qid)];
-    f64 now = vlib_time_now (vm);
 
     if ((txvq->n_since_last_int) && (txvq->int_deadline < now))
-      vhost_user_send_call (vm, txvq);
+      vhost_user_send_call (vm, txvq, now);
 
     if ((rxvq->n_since_last_int) && (rxvq->int_deadline < now))
-      vhost_user_send_call (vm, rxvq);
+      vhost_user_send_call (vm, rxvq, now);
   }
 
   /*
@@ -729,13 +729,461 @@ stop:
   /* interrupt (call) handling */
   if ((txvq->callfd_idx != ~0) &&
       !(txvq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
+    vhost_user_vring_coalesce_call (vm, txvq, n_rx_packets, now);
+
+  /* increase rx counters */
+  vlib_increment_combined_counter
+    (vnet_main.interface_main.combined_sw_if_counters
+     + VNET_INTERFACE_COUNTER_RX, vm->thread_index, vui->sw_if_index,
+     n_rx_packets, n_rx_bytes);
+
+  vnet_device_increment_rx_packets (vm->thread_index, n_rx_packets);
+
+done:
+  return n_rx_packets;
+}
+
+static_always_inline void
+vhost_user_rx_trace_packed (vhost_trace_t * t, vhost_user_intf_t * vui,
+			    u16 qid, vhost_user_vring_t * txvq,
+			    u16 desc_current)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vring_packed_desc_t *hdr_desc = 0;
+  virtio_net_hdr_mrg_rxbuf_t *hdr;
+  u16 flags = txvq->packed_desc[desc_current].flags;
+  u32 hint = 0;
+
+  clib_memset (t, 0, sizeof (*t));
+  t->device_index = vui - vum->vhost_user_interfaces;
+  t->qid = qid;
+
+  hdr_desc = &txvq->packed_desc[desc_current];
+  if (flags & VIRTQ_DESC_F_INDIRECT)
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_INDIRECT;
+      /* Header is the first here */
+      hdr_desc = map_guest_mem (vui, txvq->packed_desc[desc_current].addr,
+				&hint);
+    }
+  if (flags & VIRTQ_DESC_F_NEXT)
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SIMPLE_CHAINED;
+  if (!(flags & (VIRTQ_DESC_F_NEXT | VIRTQ_DESC_F_INDIRECT)))
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SINGLE_DESC;
+
+  t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
+
+  if (!hdr_desc || !(hdr = map_guest_mem (vui, hdr_desc->addr, &hint)))
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_MAP_ERROR;
+    }
+  else
+    {
+      u32 len = vui->virtio_net_hdr_sz;
+      memcpy (&t->hdr, hdr, len > hdr_desc->len ? hdr_desc->len : len);
+    }
+}
+
+/**
+ * Packed ring version of vhost_user_rx_discard_packet.
+ * Returns the number of discarded packets.
+ */
+static_always_inline u32
+vhost_user_rx_discard_packet_packed (vlib_main_t * vm,
+				     vhost_user_intf_t * vui,
+				     vhost_user_vring_t * txvq,
+				     u32 discard_max)
+{
+  u32 discarded_packets = 0;
+  u16 desc_head, buffer_id, n_descs;
+
+  while (discarded_packets != discard_max)
+    {
+      if (!vhost_user_packed_desc_available (txvq, txvq->last_avail_idx))
+	break;
+
+      desc_head = txvq->last_avail_idx;
+      n_descs = vhost_user_packed_chain (txvq, desc_head, &buffer_id);
+      txvq->packed_desc[desc_head].id = buffer_id;
+      txvq->packed_desc[desc_head].len = 0;
+      CLIB_MEMORY_STORE_BARRIER ();
+      txvq->packed_desc[desc_head].flags =
+	vhost_user_packed_used_flags (txvq);
+      vhost_user_log_dirty_packed_desc (vui, txvq, desc_head);
+
+      vhost_user_advance_last_avail_idx_packed (txvq, n_descs);
+      vhost_user_advance_last_used_idx_packed (txvq, n_descs);
+      discarded_packets++;
+    }
+
+  return discarded_packets;
+}
+
+/*
+ * Packed ring version of vhost_user_if_input. Used entries overwrite the
+ * head descriptor of each chain, they become visible to the driver when
+ * their flags are written. The flags of the first used entry of a batch are
+ * written last, once the data has been copied, so the driver cannot go
+ * past it before the whole batch is complete.
+ */
+static_always_inline u32
+vhost_user_if_input_packed (vlib_main_t * vm,
+			    vhost_user_main_t * vum,
+			    vhost_user_intf_t * vui,
+			    u16 qid, vlib_node_runtime_t * node,
+			    vnet_hw_interface_rx_mode mode, u8 enable_csum)
+{
+  vhost_user_vring_t *txvq = &vui->vrings[VHOST_VRING_IDX_TX (qid)];
+  vnet_feature_main_t *fm = &feature_main;
+  u16 n_rx_packets = 0;
+  u32 n_rx_bytes = 0;
+  u16 n_left = VLIB_FRAME_SIZE;
+  u32 n_left_to_next, *to_next;
+  u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+  u32 n_trace = vlib_get_trace_count (vm, node);
+  u32 buffer_data_size = vlib_buffer_get_default_data_size (vm);
+  u32 map_hint = 0;
+  vhost_cpu_t *cpu = &vum->cpus[vm->thread_index];
+  u16 copy_len = 0;
+  u8 feature_arc_idx = fm->device_input_feature_arc_index;
+  u32 current_config_index = ~(u32) 0;
+  u16 mask = txvq->qsz_mask;
+  u16 batch_head = 0, batch_flags = 0;
+  u8 batch_pending = 0;
+  f64 now = vhost_user_node_time (vm);
+
+  /* The descriptor table is not ready yet */
+  if (PREDICT_FALSE (txvq->packed_desc == 0))
+    goto done;
+
+  {
+    /* do we have pending interrupts ? */
+    vhost_user_vring_t *rxvq = &vui->vrings[VHOST_VRING_IDX_RX (qid)];
+
+    if ((txvq->n_since_last_int) && (txvq->int_deadline < now))
+      vhost_user_send_call (vm, txvq, now);
+
+    if ((rxvq->n_since_last_int) && (rxvq->int_deadline < now))
+      vhost_user_send_call (vm, rxvq, now);
+  }
+
+  /* See vhost_user_if_input */
+  if (PREDICT_FALSE (mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE))
+    {
+      if ((node->flags &
+	   VLIB_NODE_FLAG_SWITCH_FROM_POLLING_TO_INTERRUPT_MODE) ||
+	  !(node->flags &
+	    VLIB_NODE_FLAG_SWITCH_FROM_INTERRUPT_TO_POLLING_MODE))
+	/* Tell driver we want notification */
+	txvq->used_event->flags = VRING_EVENT_F_ENABLE;
+      else
+	/* Tell driver we don't want notification */
+	txvq->used_event->flags = VRING_EVENT_F_DISABLE;
+    }
+
+  /* nothing to do */
+  if (PREDICT_FALSE (!vhost_user_packed_desc_available (txvq,
+							 txvq->last_avail_idx)))
+    goto done;
+
+  if (PREDICT_FALSE (!vui->admin_up || !(txvq->enabled)))
+    {
+      /* Discard input packet, see vhost_user_if_input */
+      vhost_user_rx_discard_packet_packed (vm, vui, txvq,
+					   VHOST_USER_DOWN_DISCARD_COUNT);
+      goto done;
+    }
+
+  /* See vhost_user_if_input for the buffer allocation strategy */
+  if (PREDICT_FALSE (cpu->rx_buffers_len < n_left + 1 ||
+		     cpu->rx_buffers_len < 40))
+    {
+      u32 curr_len = cpu->rx_buffers_len;
+      cpu->rx_buffers_len +=
+	vlib_buffer_alloc (vm, cpu->rx_buffers + curr_len,
+			   VHOST_USER_RX_BUFFERS_N - curr_len);
+
+      if (PREDICT_FALSE
+	  (cpu->rx_buffers_len < VHOST_USER_RX_BUFFER_STARVATION))
+	{
+	  u32 flush = (n_left + 1 > cpu->rx_buffers_len) ?
+	    n_left + 1 - cpu->rx_buffers_len : 1;
+	  flush = vhost_user_rx_discard_packet_packed (vm, vui, txvq, flush);
+
+	  n_left -= flush;
+	  vlib_increment_simple_counter (vnet_main.
+					 interface_main.sw_if_counters +
+					 VNET_INTERFACE_COUNTER_DROP,
+					 vm->thread_index, vui->sw_if_index,
+					 flush);
+
+	  vlib_error_count (vm, vhost_user_input_node.index,
+			    VHOST_USER_INPUT_FUNC_ERROR_NO_BUFFER, flush);
+	}
+    }
+
+  if (PREDICT_FALSE (vnet_have_features (feature_arc_idx, vui->sw_if_index)))
+    {
+      vnet_feature_config_main_t *cm;
+      cm = &fm->feature_config_mains[feature_arc_idx];
+      current_config_index = vec_elt (cm->config_index_by_sw_if_index,
+				      vui->sw_if_index);
+      vnet_get_config_data (&cm->config_main, &current_config_index,
+			    &next_index, 0);
+    }
+
+  vlib_get_new_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+  if (next_index == VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT)
+    {
+      /* give some hints to ethernet-input */
+      vlib_next_frame_t *nf;
+      vlib_frame_t *f;
+      ethernet_input_frame_t *ef;
+      nf = vlib_node_runtime_get_next_frame (vm, node, next_index);
+      f = vlib_get_frame (vm, nf->frame);
+      f->flags = ETH_INPUT_FRAME_F_SINGLE_SW_IF_IDX;
+
+      ef = vlib_frame_scalar_args (f);
+      ef->sw_if_index = vui->sw_if_index;
+      ef->hw_if_index = vui->hw_if_index;
+      vlib_frame_no_append (f);
+    }
+
+  while (n_left > 0)
+    {
+      vlib_buffer_t *b_head, *b_current;
+      u32 bi_current;
+      u16 desc_head, desc_current, buffer_id, n_descs, used_flags;
+      u32 desc_data_offset, indirect_n = 0;
+      vring_packed_desc_t *desc_table = txvq->packed_desc;
+
+      if (PREDICT_FALSE (cpu->rx_buffers_len <= 1))
+	{
+	  /* Not enough rx_buffers */
+	  n_left = 0;
+	  break;
+	}
+
+      if (!vhost_user_packed_desc_available (txvq, txvq->last_avail_idx))
+	break;
+
+      desc_head = desc_current = txvq->last_avail_idx;
+      n_descs = vhost_user_packed_chain (txvq, desc_head, &buffer_id);
+
+      cpu->rx_buffers_len--;
+      bi_current = cpu->rx_buffers[cpu->rx_buffers_len];
+      b_head = b_current = vlib_get_buffer (vm, bi_current);
+      to_next[0] = bi_current;	//We do that now so we can forget about bi_current
+      to_next++;
+      n_left_to_next--;
+
+      vlib_prefetch_buffer_with_index
+	(vm, cpu->rx_buffers[cpu->rx_buffers_len - 1], LOAD);
+
+      /* The buffer should already be initialized */
+      b_head->total_length_not_including_first_buffer = 0;
+      b_head->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+      if (PREDICT_FALSE (n_trace))
+	{
+	  vlib_trace_buffer (vm, node, next_index, b_head,
+			     /* follow_chain */ 0);
+	  vhost_trace_t *t0 =
+	    vlib_add_trace (vm, node, b_head, sizeof (t0[0]));
+	  vhost_user_rx_trace_packed (t0, vui, qid, txvq, desc_head);
+	  n_trace--;
+	  vlib_set_trace_count (vm, node, n_trace);
+	}
+
+      if (desc_table[desc_current].flags & VIRTQ_DESC_F_INDIRECT)
+	{
+	  indirect_n = desc_table[desc_current].len /
+	    sizeof (vring_packed_desc_t);
+	  if (PREDICT_FALSE (indirect_n == 0 || indirect_n > mask + 1))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_INPUT_FUNC_ERROR_INDIRECT_OVERFLOW,
+				1);
+	      goto out;
+	    }
+	  desc_table = map_guest_mem (vui, desc_table[desc_current].addr,
+				      &map_hint);
+	  desc_current = 0;
+	  if (PREDICT_FALSE (desc_table == 0))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+	      goto out;
+	    }
+	}
+
+      desc_data_offset = vui->virtio_net_hdr_sz;
+
+      if (enable_csum)
+	{
+	  virtio_net_hdr_mrg_rxbuf_t *hdr;
+	  u8 *b_data;
+	  u16 current = desc_current;
+	  u32 data_offset = desc_data_offset;
+
+	  hdr = map_guest_mem (vui, desc_table[desc_current].addr, &map_hint);
+	  if (PREDICT_FALSE (hdr == 0))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+	      goto out;
+	    }
+	  b_data = (u8 *) hdr + data_offset;
+	  if ((data_offset == desc_table[current].len) &&
+	      vhost_user_packed_desc_next (desc_table, &current, mask,
+					   indirect_n))
+	    {
+	      b_data = map_guest_mem (vui, desc_table[current].addr,
+				      &map_hint);
+	      if (PREDICT_FALSE (b_data == 0))
+		{
+		  vlib_error_count (vm, node->node_index,
+				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+		  goto out;
+		}
+	    }
+	  vhost_user_handle_rx_offload (b_head, b_data, &hdr->hdr);
+	}
+
+      while (1)
+	{
+	  /* Get more input if necessary. Or end of packet. */
+	  if (desc_data_offset == desc_table[desc_current].len)
+	    {
+	      if (PREDICT_FALSE (vhost_user_packed_desc_next
+				 (desc_table, &desc_current, mask,
+				  indirect_n)))
+		desc_data_offset = 0;
+	      else
+		goto out;
+	    }
+
+	  /* Get more output if necessary. Or end of packet. */
+	  if (PREDICT_FALSE (b_current->current_length == buffer_data_size))
+	    {
+	      if (PREDICT_FALSE (cpu->rx_buffers_len == 0))
+		{
+		  /* Cancel speculation, the chain stays available */
+		  to_next--;
+		  n_left_to_next++;
+		  vhost_user_input_rewind_buffers (vm, cpu, b_head);
+		  n_left = 0;
+		  goto stop;
+		}
+
+	      /* Get next output */
+	      cpu->rx_buffers_len--;
+	      u32 bi_next = cpu->rx_buffers[cpu->rx_buffers_len];
+	      b_current->next_buffer = bi_next;
+	      b_current->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      bi_current = bi_next;
+	      b_current = vlib_get_buffer (vm, bi_current);
+	    }
+
+	  /* Prepare a copy order executed later for the data */
+	  ASSERT (copy_len < VHOST_USER_COPY_ARRAY_N);
+	  vhost_copy_t *cpy = &cpu->copy[copy_len];
+	  copy_len++;
+	  u32 desc_data_l = desc_table[desc_current].len - desc_data_offset;
+	  cpy->len = buffer_data_size - b_current->current_length;
+	  cpy->len = (cpy->len > desc_data_l) ? desc_data_l : cpy->len;
+	  cpy->dst = (uword) (vlib_buffer_get_current (b_current) +
+			      b_current->current_length);
+	  cpy->src = desc_table[desc_current].addr + desc_data_offset;
+
+	  desc_data_offset += cpy->len;
+
+	  b_current->current_length += cpy->len;
+	  b_head->total_length_not_including_first_buffer += cpy->len;
+	}
+
+    out:
+
+      n_rx_bytes += b_head->total_length_not_including_first_buffer;
+      n_rx_packets++;
+
+      b_head->total_length_not_including_first_buffer -=
+	b_head->current_length;
+
+      /*
+       * Consume the chain and return it as used in its head slot. Only the
+       * id and len of the descriptor are overwritten, the addresses of the
+       * pending copies remain valid.
+       */
+      txvq->packed_desc[desc_head].id = buffer_id;
+      txvq->packed_desc[desc_head].len = 0;
+      used_flags = vhost_user_packed_used_flags (txvq);
+      if (batch_pending)
+	txvq->packed_desc[desc_head].flags = used_flags;
+      else
+	{
+	  batch_head = desc_head;
+	  batch_flags = used_flags;
+	  batch_pending = 1;
+	}
+      vhost_user_log_dirty_packed_desc (vui, txvq, desc_head);
+      vhost_user_advance_last_avail_idx_packed (txvq, n_descs);
+      vhost_user_advance_last_used_idx_packed (txvq, n_descs);
+
+      VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b_head);
+
+      vnet_buffer (b_head)->sw_if_index[VLIB_RX] = vui->sw_if_index;
+      vnet_buffer (b_head)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+      b_head->error = 0;
+
+      if (current_config_index != ~(u32) 0)
+	{
+	  b_head->current_config_index = current_config_index;
+	  vnet_buffer (b_head)->feature_arc_index = feature_arc_idx;
+	}
+
+      n_left--;
+
+      if (PREDICT_FALSE (copy_len >= VHOST_USER_RX_COPY_THRESHOLD))
+	{
+	  if (PREDICT_FALSE (vhost_user_input_copy (vui, cpu->copy,
+						    copy_len, &map_hint)))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+	    }
+	  copy_len = 0;
+
+	  /* give buffers back to driver */
+	  CLIB_MEMORY_STORE_BARRIER ();
+	  txvq->packed_desc[batch_head].flags = batch_flags;
+	  batch_pending = 0;
+	}
+    }
+stop:
+  vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+
+  /* Do the memory copies */
+  if (PREDICT_FALSE (vhost_user_input_copy (vui, cpu->copy, copy_len,
+					    &map_hint)))
     {
-      txvq->n_since_last_int += n_rx_packets;
+      vlib_error_count (vm, node->node_index,
+			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+    }
 
-      if (txvq->n_since_last_int > vum->coalesce_frames)
-	vhost_user_send_call (vm, txvq);
+  /* give buffers back to driver */
+  if (batch_pending)
+    {
+      CLIB_MEMORY_STORE_BARRIER ();
+      txvq->packed_desc[batch_head].flags = batch_flags;
     }
 
+  /* interrupt (call) handling */
+  if ((txvq->callfd_idx != ~0) &&
+      (txvq->avail_event->flags != VRING_EVENT_F_DISABLE))
+    vhost_user_vring_coalesce_call (vm, txvq, n_rx_packets, now);
+
   /* increase rx counters */
   vlib_increment_combined_counter
     (vnet_main.interface_main.combined_sw_if_counters
@@ -766,7 +1214,18 @@ VLIB_NODE_FN (vhost_user_input_node) (vlib_main_t * vm,
       {
 	vui =
 	  pool_elt_at_index (vum->vhost_user_interfaces, dq->dev_instance);
-	if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_CSUM))
+	if (vhost_user_is_packed_ring_supported (vui))
+	  {
+	    if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_CSUM))
+	      n_rx_packets +=
+		vhost_user_if_input_packed (vm, vum, vui, dq->queue_id,
+					    node, dq->mode, 1);
+	    else
+	      n_rx_packets +=
+		vhost_user_if_input_packed (vm, vum, vui, dq->queue_id,
+					    node, dq->mode, 0);
+	  }
+	else if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_CSUM))
 	  n_rx_packets +=
 	    vhost_user_if_input (vm, vum, vui, dq->queue_id, node, dq->mode,
 				 1);
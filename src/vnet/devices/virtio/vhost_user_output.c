@@ -288,6 +288,353 @@ vhost_user_handle_tx_offload (vhost_user_intf_t * vui, vlib_buffer_t * b,
     }
 }
 
+static_always_inline void
+vhost_user_tx_trace_packed (vhost_trace_t * t, vhost_user_intf_t * vui,
+			    u16 qid, vlib_buffer_t * b,
+			    vhost_user_vring_t * rxvq)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  u16 desc_current = rxvq->last_avail_idx;
+  u16 flags = rxvq->packed_desc[desc_current].flags;
+  vring_packed_desc_t *hdr_desc = 0;
+  u32 hint = 0;
+
+  clib_memset (t, 0, sizeof (*t));
+  t->device_index = vui - vum->vhost_user_interfaces;
+  t->qid = qid;
+
+  hdr_desc = &rxvq->packed_desc[desc_current];
+  if (flags & VIRTQ_DESC_F_INDIRECT)
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_INDIRECT;
+      /* Header is the first here */
+      hdr_desc = map_guest_mem (vui, rxvq->packed_desc[desc_current].addr,
+				&hint);
+    }
+  if (flags & VIRTQ_DESC_F_NEXT)
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SIMPLE_CHAINED;
+  if (!(flags & (VIRTQ_DESC_F_NEXT | VIRTQ_DESC_F_INDIRECT)))
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SINGLE_DESC;
+
+  t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
+}
+
+/*
+ * Map the descriptor table of the chain starting at the last available
+ * slot of a packed ring. For indirect descriptors, indirect_n is set to the
+ * number of entries of the indirect table.
+ */
+static_always_inline vring_packed_desc_t *
+vhost_user_tx_packed_desc_table (vhost_user_intf_t * vui,
+				 vhost_user_vring_t * rxvq, u16 * desc_index,
+				 u32 * indirect_n, u32 * map_hint, u8 * error)
+{
+  vring_packed_desc_t *desc = &rxvq->packed_desc[rxvq->last_avail_idx];
+  vring_packed_desc_t *desc_table;
+
+  *desc_index = rxvq->last_avail_idx;
+  *indirect_n = 0;
+  if (PREDICT_TRUE (!(desc->flags & VIRTQ_DESC_F_INDIRECT)))
+    return rxvq->packed_desc;
+
+  *indirect_n = desc->len / sizeof (vring_packed_desc_t);
+  if (PREDICT_FALSE (*indirect_n == 0 || *indirect_n > rxvq->qsz_mask + 1))
+    {
+      *error = VHOST_USER_TX_FUNC_ERROR_INDIRECT_OVERFLOW;
+      return 0;
+    }
+  if (PREDICT_FALSE (!(desc_table = map_guest_mem (vui, desc->addr,
+						   map_hint))))
+    {
+      *error = VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL;
+      return 0;
+    }
+  *desc_index = 0;
+  return desc_table;
+}
+
+/*
+ * Packed ring version of the transmit loop, see vhost_user_if_input_packed
+ * for how used entries are published. The used entries of a packet are
+ * only written once the whole packet has found room in the ring: at packet
+ * boundaries, last_used_idx and last_avail_idx are the same slot and a
+ * partially sent packet is dropped by rewinding last_avail_idx.
+ * Returns the number of packets that could not be sent.
+ */
+static_always_inline u32
+vhost_user_device_class_packed (vlib_main_t * vm, vlib_node_runtime_t * node,
+				vlib_frame_t * frame, vhost_user_intf_t * vui,
+				vhost_user_vring_t * rxvq, u32 qid,
+				u8 * error_p)
+{
+  u32 *buffers = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors;
+  vhost_user_main_t *vum = &vhost_user_main;
+  vhost_cpu_t *cpu = &vum->cpus[vm->thread_index];
+  u32 map_hint = 0;
+  u8 retry = 8;
+  u16 copy_len;
+  u16 tx_headers_len;
+  u16 mask = rxvq->qsz_mask;
+  u16 batch_head = 0, batch_flags = 0;
+  u8 batch_pending = 0;
+  u8 error;
+
+retry:
+  error = VHOST_USER_TX_FUNC_ERROR_NONE;
+  tx_headers_len = 0;
+  copy_len = 0;
+  while (n_left > 0)
+    {
+      vlib_buffer_t *b0, *current_b0;
+      u16 desc_index, desc_len, buffer_id, n_descs, i;
+      vring_packed_desc_t *desc_table;
+      vhost_user_tx_chain_t *chain;
+      uword buffer_map_addr;
+      u32 buffer_len, indirect_n;
+      u16 bytes_left, n_chains = 0;
+
+      if (PREDICT_TRUE (n_left > 1))
+	vlib_prefetch_buffer_with_index (vm, buffers[1], LOAD);
+
+      b0 = vlib_get_buffer (vm, buffers[0]);
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  cpu->current_trace = vlib_add_trace (vm, node, b0,
+					       sizeof (*cpu->current_trace));
+	  vhost_user_tx_trace_packed (cpu->current_trace, vui, qid / 2, b0,
+				      rxvq);
+	}
+
+      if (PREDICT_FALSE (!vhost_user_packed_desc_available
+			 (rxvq, rxvq->last_avail_idx)))
+	{
+	  error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOBUF;
+	  goto done;
+	}
+
+      n_descs = vhost_user_packed_chain (rxvq, rxvq->last_avail_idx,
+					 &buffer_id);
+      desc_table = vhost_user_tx_packed_desc_table (vui, rxvq, &desc_index,
+						    &indirect_n, &map_hint,
+						    &error);
+      if (PREDICT_FALSE (desc_table == 0))
+	goto done;
+
+      desc_len = vui->virtio_net_hdr_sz;
+      buffer_map_addr = desc_table[desc_index].addr;
+      buffer_len = desc_table[desc_index].len;
+
+      {
+	// Get a header from the header array
+	virtio_net_hdr_mrg_rxbuf_t *hdr = &cpu->tx_headers[tx_headers_len];
+	tx_headers_len++;
+	hdr->hdr.flags = 0;
+	hdr->hdr.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+	hdr->num_buffers = 1;	//This is local, no need to check
+
+	/* Guest supports csum offload? */
+	if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM))
+	  vhost_user_handle_tx_offload (vui, b0, &hdr->hdr);
+
+	// Prepare a copy order executed later for the header
+	ASSERT (copy_len < VHOST_USER_COPY_ARRAY_N);
+	vhost_copy_t *cpy = &cpu->copy[copy_len];
+	copy_len++;
+	cpy->len = vui->virtio_net_hdr_sz;
+	cpy->dst = buffer_map_addr;
+	cpy->src = (uword) hdr;
+      }
+
+      buffer_map_addr += vui->virtio_net_hdr_sz;
+      buffer_len -= vui->virtio_net_hdr_sz;
+      bytes_left = b0->current_length;
+      current_b0 = b0;
+      while (1)
+	{
+	  if (buffer_len == 0)
+	    {			//Get new output
+	      if (vhost_user_packed_desc_next (desc_table, &desc_index, mask,
+					       indirect_n))
+		{
+		  //Next one is chained
+		  buffer_map_addr = desc_table[desc_index].addr;
+		  buffer_len = desc_table[desc_index].len;
+		}
+	      else if (vui->virtio_net_hdr_sz == 12)	//MRG is available
+		{
+		  virtio_net_hdr_mrg_rxbuf_t *hdr =
+		    &cpu->tx_headers[tx_headers_len - 1];
+
+		  if (PREDICT_FALSE (n_chains == VHOST_USER_TX_CHAINS_N - 1))
+		    {
+		      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOMRG;
+		      goto done;
+		    }
+
+		  //Move from available to used buffer, written later
+		  chain = &cpu->tx_chains[n_chains++];
+		  chain->id = buffer_id;
+		  chain->len = desc_len;
+		  chain->n_descs = n_descs;
+		  vhost_user_advance_last_avail_idx_packed (rxvq, n_descs);
+		  hdr->num_buffers++;
+		  desc_len = 0;
+
+		  if (PREDICT_FALSE (!vhost_user_packed_desc_available
+				     (rxvq, rxvq->last_avail_idx)))
+		    {
+		      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOBUF;
+		      goto done;
+		    }
+
+		  n_descs = vhost_user_packed_chain (rxvq, rxvq->last_avail_idx,
+						     &buffer_id);
+		  desc_table =
+		    vhost_user_tx_packed_desc_table (vui, rxvq, &desc_index,
+						     &indirect_n, &map_hint,
+						     &error);
+		  if (PREDICT_FALSE (desc_table == 0))
+		    goto done;
+		  buffer_map_addr = desc_table[desc_index].addr;
+		  buffer_len = desc_table[desc_index].len;
+		}
+	      else
+		{
+		  error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOMRG;
+		  goto done;
+		}
+	    }
+
+	  {
+	    ASSERT (copy_len < VHOST_USER_COPY_ARRAY_N);
+	    vhost_copy_t *cpy = &cpu->copy[copy_len];
+	    copy_len++;
+	    cpy->len = bytes_left;
+	    cpy->len = (cpy->len > buffer_len) ? buffer_len : cpy->len;
+	    cpy->dst = buffer_map_addr;
+	    cpy->src = (uword) vlib_buffer_get_current (current_b0) +
+	      current_b0->current_length - bytes_left;
+
+	    bytes_left -= cpy->len;
+	    buffer_len -= cpy->len;
+	    buffer_map_addr += cpy->len;
+	    desc_len += cpy->len;
+	  }
+
+	  // Check if vlib buffer has more data. If not, get more or break.
+	  if (PREDICT_TRUE (!bytes_left))
+	    {
+	      if (PREDICT_FALSE
+		  (current_b0->flags & VLIB_BUFFER_NEXT_PRESENT))
+		{
+		  current_b0 = vlib_get_buffer (vm, current_b0->next_buffer);
+		  bytes_left = current_b0->current_length;
+		}
+	      else
+		{
+		  //End of packet
+		  break;
+		}
+	    }
+	}
+
+      chain = &cpu->tx_chains[n_chains++];
+      chain->id = buffer_id;
+      chain->len = desc_len;
+      chain->n_descs = n_descs;
+      vhost_user_advance_last_avail_idx_packed (rxvq, n_descs);
+
+      //Move from available to used ring, one entry per chain
+      for (i = 0; i < n_chains; i++)
+	{
+	  u16 slot = rxvq->last_used_idx;
+	  u16 used_flags;
+
+	  chain = &cpu->tx_chains[i];
+	  rxvq->packed_desc[slot].id = chain->id;
+	  rxvq->packed_desc[slot].len = chain->len;
+	  used_flags = vhost_user_packed_used_flags (rxvq) |
+	    VIRTQ_DESC_F_WRITE;
+	  if (batch_pending)
+	    rxvq->packed_desc[slot].flags = used_flags;
+	  else
+	    {
+	      batch_head = slot;
+	      batch_flags = used_flags;
+	      batch_pending = 1;
+	    }
+	  vhost_user_log_dirty_packed_desc (vui, rxvq, slot);
+	  vhost_user_advance_last_used_idx_packed (rxvq, chain->n_descs);
+	}
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  cpu->current_trace->hdr = cpu->tx_headers[tx_headers_len - 1];
+	}
+
+      n_left--;			//At the end for error counting when 'goto done' is invoked
+
+      /*
+       * Do the copy periodically to prevent
+       * cpu->copy array overflow and corrupt memory
+       */
+      if (PREDICT_FALSE (copy_len >= VHOST_USER_TX_COPY_THRESHOLD))
+	{
+	  if (PREDICT_FALSE (vhost_user_tx_copy (vui, cpu->copy, copy_len,
+						 &map_hint)))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
+	    }
+	  copy_len = 0;
+
+	  /* give buffers back to driver */
+	  CLIB_MEMORY_BARRIER ();
+	  rxvq->packed_desc[batch_head].flags = batch_flags;
+	  batch_pending = 0;
+	}
+      buffers++;
+    }
+
+done:
+  /* Give back the descriptors taken by a partially sent packet */
+  rxvq->last_avail_idx = rxvq->last_used_idx;
+  rxvq->avail_wrap_counter = rxvq->used_wrap_counter;
+
+  //Do the memory copies
+  if (PREDICT_FALSE (vhost_user_tx_copy (vui, cpu->copy, copy_len,
+					 &map_hint)))
+    {
+      vlib_error_count (vm, node->node_index,
+			VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
+    }
+
+  if (batch_pending)
+    {
+      CLIB_MEMORY_BARRIER ();
+      rxvq->packed_desc[batch_head].flags = batch_flags;
+      batch_pending = 0;
+    }
+
+  /* See VNET_DEVICE_CLASS_TX_FN (vhost_user_device_class) */
+  if (n_left && (error == VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOBUF) && retry)
+    {
+      retry--;
+      goto retry;
+    }
+
+  /* interrupt (call) handling */
+  if ((rxvq->callfd_idx != ~0) &&
+      (rxvq->avail_event->flags != VRING_EVENT_F_DISABLE))
+    vhost_user_vring_coalesce_call (vm, rxvq, frame->n_vectors - n_left,
+				    vhost_user_node_time (vm));
+
+  *error_p = error;
+  return n_left;
+}
+
 VNET_DEVICE_CLASS_TX_FN (vhost_user_device_class) (vlib_main_t * vm,
 						   vlib_node_runtime_t *
 						   node, vlib_frame_t * frame)
@@ -332,6 +679,13 @@ VNET_DEVICE_CLASS_TX_FN (vhost_user_device_class) (vlib_main_t * vm,
   if (PREDICT_FALSE (vui->use_tx_spinlock))
     vhost_user_vring_lock (vui, qid);
 
+  if (vhost_user_is_packed_ring_supported (vui))
+    {
+      n_left = vhost_user_device_class_packed (vm, node, frame, vui, rxvq,
+					       qid, &error);
+      goto done2;
+    }
+
 retry:
   error = VHOST_USER_TX_FUNC_ERROR_NONE;
   tx_headers_len = 0;
@@ -598,13 +952,10 @@ done:
   /* interrupt (call) handling */
   if ((rxvq->callfd_idx != ~0) &&
       !(rxvq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
-    {
-      rxvq->n_since_last_int += frame->n_vectors - n_left;
-
-      if (rxvq->n_since_last_int > vum->coalesce_frames)
-	vhost_user_send_call (vm, rxvq);
-    }
+    vhost_user_vring_coalesce_call (vm, rxvq, frame->n_vectors - n_left,
+				    vhost_user_node_time (vm));
 
+done2:
   vhost_user_vring_unlock (vui, qid);
 
 done3:
@@ -670,10 +1021,10 @@ vhost_user_interface_rx_mode_change (vnet_main_t * vnm, u32 hw_if_index,
 
   txvq->mode = mode;
   if (mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
-    txvq->used->flags = VRING_USED_F_NO_NOTIFY;
+    vhost_user_vring_set_notify (vui, txvq, 0);
   else if ((mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE) ||
 	   (mode == VNET_HW_INTERFACE_RX_MODE_INTERRUPT))
-    txvq->used->flags = 0;
+    vhost_user_vring_set_notify (vui, txvq, 1);
   else
     {
       vu_log_err (vui, "unhandled mode %d changed for if %d queue %d", mode,
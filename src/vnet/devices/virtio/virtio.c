@@ -55,7 +55,8 @@ call_read_ready (clib_file_t * uf)
 
   CLIB_UNUSED (ssize_t size) = read (uf->file_descriptor, &b, sizeof (b));
   if ((qid & 1) == 0)
-    vnet_device_input_set_interrupt_pending (vnm, vif->hw_if_index, qid);
+    vnet_device_input_set_interrupt_pending (vnm, vif->hw_if_index,
+					     RX_QUEUE_ACCESS (qid));
 
   return 0;
 }
@@ -304,7 +305,11 @@ virtio_show (vlib_main_t * vm, u32 * hw_if_indices, u8 show_descr, u32 type)
 	    str = format (str, " %d", vif->vhost_fds[i]);
 	  vlib_cli_output (vm, "  vhost-fds%v", str);
 	  vec_free (str);
-	  vlib_cli_output (vm, "  tap-fd %d", vif->tap_fd);
+	  str = 0;
+	  vec_foreach_index (i, vif->tap_fds)
+	    str = format (str, " %d", vif->tap_fds[i]);
+	  vlib_cli_output (vm, "  tap-fds%v", str);
+	  vec_free (str);
 	}
       vlib_cli_output (vm, "  gso-enabled %d", vif->gso_enabled);
       vlib_cli_output (vm, "  csum-enabled %d", vif->csum_offload_enabled);
@@ -56,7 +56,8 @@
 /* The Host publishes the avail index for which it expects a kick \
  * at the end of the used ring. Guest should ignore the used->flags field. */ \
   _ (VHOST_USER_F_PROTOCOL_FEATURES, 30) \
-  _ (VIRTIO_F_VERSION_1, 32)
+  _ (VIRTIO_F_VERSION_1, 32) \
+  _ (VIRTIO_F_RING_PACKED, 34)
 
 
 #define foreach_virtio_if_flag		\
@@ -149,7 +150,7 @@ typedef struct
   };
   u32 per_interface_next_index;
   int *vhost_fds;
-  int tap_fd;
+  int *tap_fds;
   u32 msix_enabled;
   u32 pci_dev_handle;
   virtio_vring_t *rxq_vrings;
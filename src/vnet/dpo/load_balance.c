@@ -92,7 +92,35 @@ load_balance_get_buckets (load_balance_t *lb)
 static load_balance_t *
 load_balance_alloc_i (void)
 {
+    vlib_main_t *vm = vlib_get_main();
     load_balance_t *lb;
+    u8 need_barrier_sync = 0;
+
+    ASSERT (vm->thread_index == 0);
+
+    /*
+     * Updates to existing load-balances are published without stopping
+     * the workers, but the pool itself (and the counters) can only move
+     * while none of them are looking.
+     */
+    pool_get_aligned_will_expand (load_balance_pool, need_barrier_sync,
+                                  CLIB_CACHE_LINE_BYTES);
+    if (!need_barrier_sync)
+    {
+        pool_header_t *ph = pool_header(load_balance_pool);
+        index_t lbi = vec_len(load_balance_pool);
+
+        /* pool_get hands out the most recently freed index first */
+        if (vec_len(ph->free_indices))
+            lbi = ph->free_indices[vec_len(ph->free_indices) - 1];
+        need_barrier_sync =
+            (vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_to_counters), lbi) ||
+             vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_via_counters), lbi));
+    }
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync (vm);
 
     pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
     clib_memset(lb, 0, sizeof(*lb));
@@ -108,6 +136,9 @@ load_balance_alloc_i (void)
     vlib_zero_combined_counter(&(load_balance_main.lbm_via_counters),
                                load_balance_get_index(lb));
 
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release (vm);
+
     return (lb);
 }
 
@@ -243,6 +274,113 @@ load_balance_create (u32 n_buckets,
     return (load_balance_get_index(load_balance_create_i(n_buckets, lb_proto, fhc)));
 }
 
+/*
+ * Updates to a load-balance are published while the workers are running,
+ * so packets in flight may still be using the buckets being replaced.
+ * The locks those buckets hold are moved to a 'held' vector that is
+ * released once every worker has passed a quiescent state, so the objects
+ * they refer to are never freed under a packet's feet.
+ */
+static void
+load_balance_buckets_free (void *arg)
+{
+    dpo_id_t *buckets = arg, *bucket;
+
+    vec_foreach(bucket, buckets)
+    {
+        dpo_reset(bucket);
+    }
+    vec_free(buckets);
+}
+
+static void
+load_balance_buckets_release (dpo_id_t *held)
+{
+    if (NULL != held)
+    {
+        vlib_rcu_call(load_balance_buckets_free, held);
+    }
+}
+
+/**
+ * Take an extra lock on a bucket that is about to be overwritten in place.
+ */
+static dpo_id_t *
+load_balance_bucket_hold (dpo_id_t *held,
+                          const dpo_id_t *bucket)
+{
+    vec_add1(held, *bucket);
+    dpo_lock(&held[vec_len(held) - 1]);
+
+    return (held);
+}
+
+/**
+ * Move the lock a bucket holds to the held vector and clear the bucket.
+ * The clear is a single u64 write, so packets in flight see either the
+ * old DPO or a drop.
+ */
+static dpo_id_t *
+load_balance_bucket_retire (dpo_id_t *held,
+                            dpo_id_t *bucket)
+{
+    dpo_id_t invalid = DPO_INVALID;
+
+    vec_add1(held, *bucket);
+    *((u64*)bucket) = *(u64*)&invalid;
+
+    return (held);
+}
+
+/**
+ * The out-of-line buckets a load-balance leaves when it shrinks back to
+ * its inline buckets. Packets in flight that read the old number of
+ * buckets still follow lb_buckets, so it keeps pointing at them until
+ * they are released.
+ */
+typedef struct load_balance_outline_t_
+{
+    index_t lbo_lb;
+    dpo_id_t *lbo_buckets;
+} load_balance_outline_t;
+
+static void
+load_balance_outline_free (void *arg)
+{
+    load_balance_outline_t *lbo = arg;
+    load_balance_t *lb;
+
+    /*
+     * the load-balance is destroyed after a later grace period, and it
+     * has its own array if it has grown back out of line since.
+     */
+    lb = load_balance_get(lbo->lbo_lb);
+    if (lb->lb_buckets == lbo->lbo_buckets)
+    {
+        lb->lb_buckets = NULL;
+    }
+    load_balance_buckets_free(lbo->lbo_buckets);
+    clib_mem_free(lbo);
+}
+
+static void
+load_balance_outline_release (load_balance_t *lb)
+{
+    load_balance_outline_t *lbo;
+
+    lbo = clib_mem_alloc(sizeof(*lbo));
+    lbo->lbo_lb = load_balance_get_index(lb);
+    lbo->lbo_buckets = lb->lb_buckets;
+
+    vlib_rcu_call(load_balance_outline_free, lbo);
+}
+
+static void
+load_balance_map_release (void *arg)
+{
+    load_balance_map_unlock(pointer_to_uword(arg));
+}
+
 static inline void
 load_balance_set_bucket_i (load_balance_t *lb,
                            u32 bucket,
@@ -258,14 +396,16 @@ load_balance_set_bucket (index_t lbi,
                          const dpo_id_t *next)
 {
     load_balance_t *lb;
-    dpo_id_t *buckets;
+    dpo_id_t *buckets, *held;
 
     lb = load_balance_get(lbi);
     buckets = load_balance_get_buckets(lb);
 
     ASSERT(bucket < lb->lb_n_buckets);
 
+    held = load_balance_bucket_hold(NULL, &buckets[bucket]);
     load_balance_set_bucket_i(lb, bucket, buckets, next);
+    load_balance_buckets_release(held);
 }
 
 int
@@ -306,6 +446,12 @@ load_balance_set_fib_entry_flags (index_t lbi,
 }
 
 
+static void
+load_balance_urpf_release (void *arg)
+{
+    fib_urpf_list_unlock(pointer_to_uword(arg));
+}
+
 void
 load_balance_set_urpf (index_t lbi,
 		       index_t urpf)
@@ -316,13 +462,19 @@ load_balance_set_urpf (index_t lbi,
     lb = load_balance_get(lbi);
 
     /*
-     * packets in flight we see this change. but it's atomic, so :P
+     * packets in flight see this change. but it's atomic, so :P
+     * Those that read the old list may still be checking against it,
+     * so it is released after a grace period.
      */
+    fib_urpf_list_lock(urpf);
     old = lb->lb_urpf;
     lb->lb_urpf = urpf;
 
-    fib_urpf_list_unlock(old);
-    fib_urpf_list_lock(urpf);
+    if (INDEX_INVALID != old)
+    {
+        vlib_rcu_call(load_balance_urpf_release,
+                      uword_to_pointer(old, void *));
+    }
 }
 
 index_t
@@ -607,9 +759,10 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     u32 sum_of_weights, n_buckets, ii;
     index_t lbmi, old_lbmi;
     load_balance_t *lb;
-    dpo_id_t *tmp_dpo;
+    dpo_id_t *held;
 
     nhs = NULL;
+    held = NULL;
 
     ASSERT(DPO_LOAD_BALANCE == dpo->dpoi_type);
     lb = load_balance_get(dpo->dpoi_index);
@@ -672,8 +825,13 @@ load_balance_multipath_update (const dpo_id_t *dpo,
              * no change in the number of buckets. we can simply fill what
              * is new over what is old.
              */
-            load_balance_fill_buckets(lb, nhs,
-                                      load_balance_get_buckets(lb),
+            dpo_id_t *buckets = load_balance_get_buckets(lb);
+
+            for (ii = 0; ii < n_buckets; ii++)
+            {
+                held = load_balance_bucket_hold(held, &buckets[ii]);
+            }
+            load_balance_fill_buckets(lb, nhs, buckets,
                                       n_buckets, flags);
             lb->lb_map = lbmi;
         }
@@ -690,16 +848,20 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 /*
                  * the new increased number of buckets is crossing the threshold
                  * from the inline storage to out-line. Alloc the outline buckets
-                 * first, then fixup the number. then reset the inlines.
+                 * first, then fixup the number. then retire the inlines.
+                 * Any lb_buckets is from an earlier shrink and is
+                 * released separately.
                  */
-                ASSERT(NULL == lb->lb_buckets);
-                vec_validate_aligned(lb->lb_buckets,
+                dpo_id_t *new_buckets = NULL;
+
+                vec_validate_aligned(new_buckets,
                                      n_buckets - 1,
                                      CLIB_CACHE_LINE_BYTES);
 
                 load_balance_fill_buckets(lb, nhs,
-                                          lb->lb_buckets,
+                                          new_buckets,
                                           n_buckets, flags);
+                lb->lb_buckets = new_buckets;
                 CLIB_MEMORY_BARRIER();
                 load_balance_set_n_buckets(lb, n_buckets);
 
@@ -707,7 +869,8 @@ load_balance_multipath_update (const dpo_id_t *dpo,
 
                 for (ii = 0; ii < LB_NUM_INLINE_BUCKETS; ii++)
                 {
-                    dpo_reset(&lb->lb_buckets_inline[ii]);
+                    held = load_balance_bucket_retire(held,
+                                                      &lb->lb_buckets_inline[ii]);
                 }
             }
             else
@@ -718,8 +881,13 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                      * we are not crossing the threshold and it's still inline buckets.
                      * we can write the new on the old..
                      */
+                    for (ii = 0; ii < lb->lb_n_buckets; ii++)
+                    {
+                        held = load_balance_bucket_hold(held,
+                                                        &lb->lb_buckets_inline[ii]);
+                    }
                     load_balance_fill_buckets(lb, nhs,
-                                              load_balance_get_buckets(lb),
+                                              lb->lb_buckets_inline,
                                               n_buckets, flags);
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
@@ -728,9 +896,10 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 {
                     /*
                      * we are not crossing the threshold. We need a new bucket array to
-                     * hold the increased number of choices.
+                     * hold the increased number of choices. The old array, and
+                     * the locks it holds, go once the workers are done with it.
                      */
-                    dpo_id_t *new_buckets, *old_buckets, *tmp_dpo;
+                    dpo_id_t *new_buckets, *old_buckets;
 
                     new_buckets = NULL;
                     old_buckets = load_balance_get_buckets(lb);
@@ -746,11 +915,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
 
-                    vec_foreach(tmp_dpo, old_buckets)
-                    {
-                        dpo_reset(tmp_dpo);
-                    }
-                    vec_free(old_buckets);
+                    load_balance_buckets_release(old_buckets);
                 }
             }
 
@@ -780,7 +945,8 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                  *   1 - Fill the inline buckets,
                  *   2 - fixup the number (and this point the inline buckets are
                  *       used).
-                 *   3 - free the outline buckets
+                 *   3 - release the outline buckets, once the packets in
+                 *       flight that read the old number are done with them.
                  */
                 load_balance_fill_buckets(lb, nhs,
                                           lb->lb_buckets_inline,
@@ -789,11 +955,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
-                vec_foreach(tmp_dpo, lb->lb_buckets)
-                {
-                    dpo_reset(tmp_dpo);
-                }
-                vec_free(lb->lb_buckets);
+                load_balance_outline_release(lb);
             }
             else
             {
@@ -801,7 +963,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                  * not crossing the threshold.
                  *  1 - update the number to the smaller size
                  *  2 - write the new buckets
-                 *  3 - reset those no longer used.
+                 *  3 - retire those no longer used.
                  */
                 dpo_id_t *buckets;
                 u32 old_n_buckets;
@@ -812,12 +974,16 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
+                for (ii = 0; ii < n_buckets; ii++)
+                {
+                    held = load_balance_bucket_hold(held, &buckets[ii]);
+                }
                 load_balance_fill_buckets(lb, nhs, buckets,
                                           n_buckets, flags);
 
                 for (ii = n_buckets; ii < old_n_buckets; ii++)
                 {
-                    dpo_reset(&buckets[ii]);
+                    held = load_balance_bucket_retire(held, &buckets[ii]);
                 }
             }
         }
@@ -830,7 +996,12 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     vec_free(nhs);
     vec_free(fixed_nhs);
 
-    load_balance_map_unlock(old_lbmi);
+    load_balance_buckets_release(held);
+    if (INDEX_INVALID != old_lbmi)
+    {
+        vlib_rcu_call(load_balance_map_release,
+                      uword_to_pointer(old_lbmi, void *));
+    }
 }
 
 static void
@@ -868,6 +1039,17 @@ load_balance_destroy (load_balance_t *lb)
     pool_put(load_balance_pool, lb);
 }
 
+static void
+load_balance_destroy_deferred (void *arg)
+{
+    load_balance_t *lb;
+
+    lb = load_balance_get(pointer_to_uword(arg));
+
+    ASSERT(0 == lb->lb_locks);
+    load_balance_destroy(lb);
+}
+
 static void
 load_balance_unlock (dpo_id_t *dpo)
 {
@@ -879,7 +1061,12 @@ load_balance_unlock (dpo_id_t *dpo)
 
     if (0 == lb->lb_locks)
     {
-        load_balance_destroy(lb);
+        /*
+         * no more control-plane references, but packets in flight may
+         * still be using the LB, its buckets and its uRPF list.
+         */
+        vlib_rcu_call(load_balance_destroy_deferred,
+                      uword_to_pointer(dpo->dpoi_index, void *));
     }
 }
 
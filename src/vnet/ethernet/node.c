@@ -1122,6 +1122,23 @@ ethernet_input_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      vlib_frame_t * from_frame)
 {
   u32 *from, n_left;
+
+  /* sampled trace, see "set interface trace-sample" */
+  if (PREDICT_FALSE (vm->trace_main.sample_enable))
+    {
+      from = vlib_frame_vector_args (from_frame);
+      n_left = from_frame->n_vectors;
+
+      while (n_left)
+	{
+	  vlib_buffer_t *b0 = vlib_get_buffer (vm, from[0]);
+	  vlib_trace_sample_buffer (vm, node, b0,
+				    vnet_buffer (b0)->sw_if_index[VLIB_RX]);
+	  from += 1;
+	  n_left -= 1;
+	}
+    }
+
   if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)))
     {
       from = vlib_frame_vector_args (from_frame);
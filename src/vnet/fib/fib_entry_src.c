@@ -540,6 +540,50 @@ fib_entry_src_collect_forwarding (fib_node_index_t pl_index,
     return (FIB_PATH_LIST_WALK_CONTINUE);
 }
 
+/**
+ * @brief Can the entry link to the load-balance shared by the users of
+ * its path-list. Not if the source modifies what the paths contribute,
+ * with path extensions or an interposer, nor if the entry's table hashes
+ * differently from the default the shared load-balance uses.
+ */
+static int
+fib_entry_src_can_share_lb (const fib_entry_t *fib_entry,
+                            const fib_entry_src_t *esrc,
+                            fib_forward_chain_type_t fct)
+{
+    const fib_entry_src_vft_t *vft;
+    fib_protocol_t proto;
+
+    if (esrc->fes_entry_flags & (FIB_ENTRY_FLAG_EXCLUSIVE |
+                                 FIB_ENTRY_FLAG_MULTICAST))
+    {
+        return (0);
+    }
+    if (0 != vec_len(esrc->fes_path_exts.fpel_exts))
+    {
+        return (0);
+    }
+
+    vft = fib_entry_src_get_vft(esrc);
+
+    if (NULL != vft->fesv_contribute_interpose &&
+        NULL != vft->fesv_contribute_interpose(esrc, fib_entry))
+    {
+        return (0);
+    }
+
+    proto = dpo_proto_to_fib(fib_forw_chain_type_to_dpo_proto(fct));
+
+    if (fib_entry->fe_prefix.fp_proto != proto ||
+        (fib_table_get_flow_hash_config(fib_entry->fe_fib_index, proto) !=
+         fib_table_get_default_flow_hash_config(proto)))
+    {
+        return (0);
+    }
+
+    return (1);
+}
+
 void
 fib_entry_src_mk_lb (fib_entry_t *fib_entry,
 		     const fib_entry_src_t *esrc,
@@ -572,9 +616,33 @@ fib_entry_src_mk_lb (fib_entry_t *fib_entry,
 
     lb_proto = fib_forw_chain_type_to_dpo_proto(fct);
 
-    fib_path_list_walk(esrc->fes_pl,
-                       fib_entry_src_collect_forwarding,
-                       &ctx);
+    /*
+     * In hierarchical mode the entry's only choice is the load-balance
+     * shared with the other users of the path-list.
+     */
+    if (fib_path_list_is_hierarchical() &&
+        fib_entry_src_can_share_lb(fib_entry, esrc, fct))
+    {
+        load_balance_path_t *nh;
+
+        vec_add2(ctx.next_hops, nh, 1);
+        nh->path_index = FIB_NODE_INDEX_INVALID;
+        nh->path_weight = 1;
+
+        if (!fib_path_list_contribute_shared_forwarding(esrc->fes_pl,
+                                                        fct,
+                                                        &nh->path_dpo))
+        {
+            vec_reset_length(ctx.next_hops);
+        }
+    }
+
+    if (0 == vec_len(ctx.next_hops))
+    {
+        fib_path_list_walk(esrc->fes_pl,
+                           fib_entry_src_collect_forwarding,
+                           &ctx);
+    }
 
     if (esrc->fes_entry_flags & FIB_ENTRY_FLAG_EXCLUSIVE)
     {
@@ -67,6 +67,12 @@ typedef struct fib_path_list_t_ {
      * Hash table of paths. valid only with INDEXED flag
      */
     uword *fpl_db;
+
+    /**
+     * Load-balances shared by all the entries that use this path-list,
+     * indexed by forwarding chain type. Hierarchical mode only.
+     */
+    dpo_id_t *fpl_lbs;
 } fib_path_list_t;
 
 /*
@@ -89,6 +95,16 @@ static uword *fib_path_list_db;
  */
 vlib_log_class_t fib_path_list_logger;
 
+/**
+ * Hierarchical forwarding mode.
+ * The entries using a shared path-list with multiple paths link, through
+ * a single bucket, to a load-balance owned by the path-list. A change in
+ * the resolution of the paths is then repaired in the data-plane with
+ * one in-place update of that load-balance, regardless of the number of
+ * entries using it; i.e. prefix independent convergence.
+ */
+static int fib_path_list_hierarchical;
+
 /*
  * Debug macro
  */
@@ -132,6 +148,7 @@ format_fib_path_list (u8 * s, va_list * args)
     fib_node_index_t *path_index, path_list_index;
     fib_path_list_attribute_t attr;
     fib_path_list_t *path_list;
+    dpo_id_t *dpo;
     u32 indent;
 
     path_list_index = va_arg (*args, fib_node_index_t);
@@ -154,7 +171,16 @@ format_fib_path_list (u8 * s, va_list * args)
 	    }
 	}
     }
-    s = format (s, " %U\n", format_fib_urpf_list, path_list->fpl_urpf);
+    s = format (s, " %U", format_fib_urpf_list, path_list->fpl_urpf);
+    vec_foreach (dpo, path_list->fpl_lbs)
+    {
+        if (dpo_id_is_valid(dpo))
+            s = format (s, " shared-lb:[%U:%d]",
+                        format_fib_forw_chain_type,
+                        (int) (dpo - path_list->fpl_lbs),
+                        dpo->dpoi_index);
+    }
+    s = format (s, "\n");
 
     vec_foreach (path_index, path_list->fpl_paths)
     {
@@ -309,6 +335,22 @@ fib_path_list_db_remove (fib_node_index_t path_list_index)
     FIB_PATH_LIST_DBG(path_list, "DB-removed");
 }
 
+/**
+ * @brief Release the shared load-balances. Users that are stacked on
+ * them keep their own lock until they re-stack.
+ */
+static void
+fib_path_list_reset_shared_lbs (fib_path_list_t *path_list)
+{
+    dpo_id_t *dpo;
+
+    vec_foreach (dpo, path_list->fpl_lbs)
+    {
+        dpo_reset(dpo);
+    }
+    vec_free(path_list->fpl_lbs);
+}
+
 static void
 fib_path_list_destroy (fib_path_list_t *path_list)
 {
@@ -324,6 +366,8 @@ fib_path_list_destroy (fib_path_list_t *path_list)
     vec_free(path_list->fpl_paths);
     fib_urpf_list_unlock(path_list->fpl_urpf);
 
+    fib_path_list_reset_shared_lbs(path_list);
+
     fib_node_deinit(&path_list->fpl_node);
     pool_put(fib_path_list_pool, path_list);
 }
@@ -406,6 +450,80 @@ fib_path_list_mk_lb (fib_path_list_t *path_list,
     vec_free(nhs);
 }
 
+/**
+ * @brief [re]build a shared load-balance.
+ * The same choice of paths an entry would make; the resolved paths of
+ * the best preference.
+ */
+static void
+fib_path_list_mk_shared_lb (fib_path_list_t *path_list,
+                            fib_forward_chain_type_t fct,
+                            dpo_id_t *dpo)
+{
+    fib_node_index_t *path_index;
+    load_balance_path_t *nhs, *nh;
+    dpo_proto_t dproto;
+    u16 preference;
+
+    nhs = NULL;
+    preference = 0xffff;
+    dproto = fib_forw_chain_type_to_dpo_proto(fct);
+
+    vec_foreach (path_index, path_list->fpl_paths)
+    {
+        if (!fib_path_is_resolved(*path_index))
+        {
+            continue;
+        }
+        if (0xffff == preference)
+        {
+            preference = fib_path_get_preference(*path_index);
+        }
+        else if (preference != fib_path_get_preference(*path_index))
+        {
+            break;
+        }
+
+        vec_add2(nhs, nh, 1);
+        nh->path_index = *path_index;
+        nh->path_weight = fib_path_get_weight(*path_index);
+        fib_path_contribute_forwarding(*path_index, fct, &nh->path_dpo);
+    }
+
+    if (!dpo_id_is_valid(dpo))
+    {
+        dpo_set(dpo,
+                DPO_LOAD_BALANCE,
+                dproto,
+                load_balance_create(0,
+                                    dproto,
+                                    load_balance_get_default_flow_hash(dproto)));
+    }
+    load_balance_multipath_update(dpo, nhs, LOAD_BALANCE_FLAG_NONE);
+
+    FIB_PATH_LIST_DBG(path_list, "mk shared lb: %d", dpo->dpoi_index);
+
+    vec_free(nhs);
+}
+
+/**
+ * @brief Update, in place, the shared load-balances
+ */
+static void
+fib_path_list_update_shared_lbs (fib_path_list_t *path_list)
+{
+    fib_forward_chain_type_t fct;
+
+    vec_foreach_index (fct, path_list->fpl_lbs)
+    {
+        if (dpo_id_is_valid(&path_list->fpl_lbs[fct]))
+        {
+            fib_path_list_mk_shared_lb(path_list, fct,
+                                       &path_list->fpl_lbs[fct]);
+        }
+    }
+}
+
 /**
  * @brief [re]build the path list's uRPF list
  */
@@ -476,6 +594,13 @@ fib_path_list_back_walk (fib_node_index_t path_list_index,
 
     fib_path_list_mk_urpf(path_list);
 
+    /*
+     * the shared load-balances are updated before the children are visited,
+     * so all the entries that use them are repaired now, even if the walk
+     * to them is deferred.
+     */
+    fib_path_list_update_shared_lbs(path_list);
+
     FIB_PATH_LIST_DBG(path_list, "bw:%U",
                       format_fib_node_bw_reason, ctx->fnbw_reason);
 
@@ -1237,6 +1362,102 @@ fib_path_list_contribute_forwarding (fib_node_index_t path_list_index,
     }
 }
 
+/*
+ * fib_path_list_contribute_shared_forwarding
+ *
+ * In hierarchical mode, return the load-balance shared by all the users of
+ * this path-list. Returns 0 if the path-list has none to offer.
+ */
+int
+fib_path_list_contribute_shared_forwarding (fib_node_index_t path_list_index,
+                                            fib_forward_chain_type_t fct,
+                                            dpo_id_t *dpo)
+{
+    fib_path_list_t *path_list;
+
+    if (!fib_path_list_hierarchical)
+    {
+        return (0);
+    }
+    if (FIB_FORW_CHAIN_TYPE_UNICAST_IP4 != fct &&
+        FIB_FORW_CHAIN_TYPE_UNICAST_IP6 != fct)
+    {
+        return (0);
+    }
+
+    path_list = fib_path_list_get(path_list_index);
+
+    /*
+     * only lists that can be shared by many entries, and for which
+     * there is a choice to make
+     */
+    if (!(path_list->fpl_flags & FIB_PATH_LIST_FLAG_SHARED) ||
+        vec_len(path_list->fpl_paths) < 2)
+    {
+        return (0);
+    }
+
+    vec_validate(path_list->fpl_lbs, fct);
+
+    if (!dpo_id_is_valid(&path_list->fpl_lbs[fct]))
+    {
+        fib_path_list_mk_shared_lb(path_list, fct, &path_list->fpl_lbs[fct]);
+    }
+    dpo_copy(dpo, &path_list->fpl_lbs[fct]);
+
+    return (1);
+}
+
+int
+fib_path_list_is_hierarchical (void)
+{
+    return (fib_path_list_hierarchical);
+}
+
+void
+fib_path_list_set_hierarchical (int enable)
+{
+    fib_node_back_walk_ctx_t ctx = {
+        .fnbw_reason = FIB_NODE_BW_REASON_FLAG_EVALUATE,
+    };
+    fib_node_index_t *plis, *pli;
+    fib_path_list_t *path_list;
+
+    if (fib_path_list_hierarchical == !!enable)
+    {
+        return;
+    }
+    fib_path_list_hierarchical = !!enable;
+
+    /*
+     * re-stack the users of the lists that [no longer] share.
+     * the walks can create path-lists, so collect first.
+     */
+    plis = NULL;
+    pool_foreach(path_list, fib_path_list_pool,
+    ({
+        if ((path_list->fpl_flags & FIB_PATH_LIST_FLAG_SHARED) &&
+            vec_len(path_list->fpl_paths) > 1)
+        {
+            vec_add1(plis, fib_path_list_get_index(path_list));
+        }
+        /*
+         * nothing uses the shared load-balances once disabled, so
+         * they are no longer updated on each back-walk
+         */
+        if (!enable)
+        {
+            fib_path_list_reset_shared_lbs(path_list);
+        }
+    }));
+
+    vec_foreach (pli, plis)
+    {
+        fib_path_list_back_walk(*pli, &ctx);
+    }
+    vec_free(plis);
+}
+
 /*
  * fib_path_list_get_adj
  *
@@ -1487,3 +1708,41 @@ VLIB_CLI_COMMAND (show_fib_path_list, static) = {
   .function = show_fib_path_list_command,
   .short_help = "show fib path-lists",
 };
+
+static clib_error_t *
+set_fib_hierarchical_command (vlib_main_t * vm,
+                              unformat_input_t * input,
+                              vlib_cli_command_t * cmd)
+{
+    if (unformat (input, "enable"))
+    {
+        fib_path_list_set_hierarchical(1);
+    }
+    else if (unformat (input, "disable"))
+    {
+        fib_path_list_set_hierarchical(0);
+    }
+    else
+    {
+        return clib_error_return(0, "choose enable or disable");
+    }
+    return (NULL);
+}
+
+/*?
+ * Enable or disable hierarchical forwarding. When enabled, all the
+ * IP entries that use the same multi-path path-list share the one
+ * load-balance for the choice between those paths. A change in path
+ * resolution, e.g. the loss of a BGP next-hop, is then repaired in
+ * the data-plane with one update, independent of the number of
+ * prefixes; at the cost of an extra load-balance in the forwarding
+ * chain.
+ *
+ * @cliexpar
+ * @cliexcmd{set fib hierarchical enable}
+ ?*/
+VLIB_CLI_COMMAND (set_fib_hierarchical, static) = {
+  .path = "set fib hierarchical",
+  .function = set_fib_hierarchical_command,
+  .short_help = "set fib hierarchical [enable|disable]",
+};
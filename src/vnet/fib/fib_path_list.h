@@ -148,6 +148,11 @@ extern void fib_path_list_contribute_forwarding(fib_node_index_t path_list_index
 						fib_forward_chain_type_t type,
                                                 fib_path_list_fwd_flags_t flags,
 						dpo_id_t *dpo);
+extern int fib_path_list_contribute_shared_forwarding(fib_node_index_t path_list_index,
+                                                      fib_forward_chain_type_t type,
+                                                      dpo_id_t *dpo);
+extern int fib_path_list_is_hierarchical(void);
+extern void fib_path_list_set_hierarchical(int enable);
 extern void fib_path_list_contribute_urpf(fib_node_index_t path_index,
 					  index_t urpf);
 extern index_t fib_path_list_get_urpf(fib_node_index_t path_list_index);
@@ -15,6 +15,7 @@
 
 #include <vnet/fib/fib_walk.h>
 #include <vnet/fib/fib_node_list.h>
+#include <vpp/stats/stat_segment.h>
 
 vlib_log_class_t fib_walk_logger;
 
@@ -84,6 +85,12 @@ typedef struct fib_walk_t_
      */
     f64 fw_start_time;
 
+    /**
+     * Time the last child was visited, zero until the walk has visited
+     * all of its children.
+     */
+    f64 fw_converged_time;
+
     /**
      * The reasons this walk is occuring.
      * This is a vector ordered in time. The reasons and the front were started
@@ -179,6 +186,7 @@ static u32 history_last_walk_pos;
 typedef struct fib_walk_history_t_ {
     u32 fwh_n_visits;
     f64 fwh_duration;
+    f64 fwh_convergence;
     f64 fwh_completed;
     fib_node_ptr_t fwh_parent;
     fib_walk_flags_t fwh_flags;
@@ -186,6 +194,27 @@ typedef struct fib_walk_history_t_ {
 } fib_walk_history_t;
 static fib_walk_history_t fib_walk_history[HISTORY_N_WALKS];
 
+/**
+ * @brief Convergence time of the walks, from the walk's start to the visit
+ * of its last child. Walks that merged with another, or had no children,
+ * are not counted. The histogram buckets are log2 usec.
+ */
+#define CONVERGENCE_N_BUCKETS 32
+typedef struct fib_walk_convergence_t_ {
+    u64 fwc_n_walks;
+    f64 fwc_last;
+    f64 fwc_max;
+    f64 fwc_total;
+    u64 fwc_hist[CONVERGENCE_N_BUCKETS];
+    /**
+     * stats segment indices of the last, max and number of walks
+     */
+    u32 fwc_stats_last;
+    u32 fwc_stats_max;
+    u32 fwc_stats_n_walks;
+} fib_walk_convergence_t;
+static fib_walk_convergence_t fib_walk_convergence;
+
 static u8* format_fib_walk (u8* s, va_list *ap);
 
 #define FIB_WALK_DBG(_walk, _fmt, _args...)                     \
@@ -247,6 +276,42 @@ fib_walk_queue_get_front (fib_walk_priority_t prio)
     return (wp.fnp_index);
 }
 
+#define USEC 1000000
+
+static void
+fib_walk_convergence_update (f64 convergence)
+{
+    fib_walk_convergence_t *fwc = &fib_walk_convergence;
+    u32 bucket;
+
+    fwc->fwc_n_walks++;
+    fwc->fwc_last = convergence;
+    fwc->fwc_total += convergence;
+    if (convergence > fwc->fwc_max)
+    {
+        fwc->fwc_max = convergence;
+    }
+    bucket = min_log2((u64) (convergence * USEC) | 1);
+    bucket = clib_min(bucket, CONVERGENCE_N_BUCKETS - 1);
+    fwc->fwc_hist[bucket]++;
+
+    if (~0 != fwc->fwc_stats_n_walks)
+    {
+        stat_segment_set_state_counter(fwc->fwc_stats_last,
+                                       fwc->fwc_last * USEC);
+        stat_segment_set_state_counter(fwc->fwc_stats_max,
+                                       fwc->fwc_max * USEC);
+        stat_segment_set_state_counter(fwc->fwc_stats_n_walks,
+                                       fwc->fwc_n_walks);
+    }
+}
+
+u64
+fib_walk_convergence_get_n_walks (void)
+{
+    return (fib_walk_convergence.fwc_n_walks);
+}
+
 static void
 fib_walk_destroy (index_t fwi)
 {
@@ -278,6 +343,12 @@ fib_walk_destroy (index_t fwi)
 	      bucket);
     fib_walk_hist_vists_per_walk[bucket]++;
 
+    if (0 != fwalk->fw_converged_time)
+    {
+        fib_walk_convergence_update(fwalk->fw_converged_time -
+                                    fwalk->fw_start_time);
+    }
+
     /*
      * save stats to the recent history
      */
@@ -289,6 +360,10 @@ fib_walk_destroy (index_t fwi)
     fib_walk_history[history_last_walk_pos].fwh_duration =
 	fib_walk_history[history_last_walk_pos].fwh_completed -
         fwalk->fw_start_time;
+    fib_walk_history[history_last_walk_pos].fwh_convergence =
+	(0 != fwalk->fw_converged_time ?
+         fwalk->fw_converged_time - fwalk->fw_start_time :
+         0);
     fib_walk_history[history_last_walk_pos].fwh_parent =
 	fwalk->fw_parent;
     fib_walk_history[history_last_walk_pos].fwh_flags =
@@ -396,6 +471,11 @@ fib_walk_advance (fib_node_index_t fwi)
 	return (FIB_WALK_ADVANCE_MORE);
     }
 
+    if (0 != fwalk->fw_n_visits)
+    {
+        fwalk->fw_converged_time = vlib_time_now(vlib_get_main());
+    }
+
     return (FIB_WALK_ADVANCE_DONE);
 }
 
@@ -641,6 +721,7 @@ fib_walk_alloc (fib_node_type_t parent_type,
     fwalk->fw_parent.fnp_type = parent_type;
     fwalk->fw_ctx = NULL;
     fwalk->fw_start_time = vlib_time_now(vlib_get_main());
+    fwalk->fw_converged_time = 0;
     fwalk->fw_n_visits = 0;
 
     /*
@@ -943,7 +1024,9 @@ static const fib_node_vft_t fib_walk_vft = {
 void
 fib_walk_module_init (void)
 {
+    fib_walk_convergence_t *fwc = &fib_walk_convergence;
     fib_walk_priority_t prio;
+    clib_error_t *error;
 
     FOR_EACH_FIB_WALK_PRIORITY(prio)
     {
@@ -952,6 +1035,22 @@ fib_walk_module_init (void)
 
     fib_node_register_type(FIB_NODE_TYPE_WALK, &fib_walk_vft);
     fib_walk_logger = vlib_log_register_class("fib", "walk");
+
+    /*
+     * the walks counter is registered last, it being valid means they
+     * all are.
+     */
+    fwc->fwc_stats_n_walks = ~0;
+    error = stat_segment_register_state_counter(
+        (u8 *) "/fib/walk/convergence/last-usec", &fwc->fwc_stats_last);
+    if (!error)
+        error = stat_segment_register_state_counter(
+            (u8 *) "/fib/walk/convergence/max-usec", &fwc->fwc_stats_max);
+    if (!error)
+        error = stat_segment_register_state_counter(
+            (u8 *) "/fib/walk/convergence/walks", &fwc->fwc_stats_n_walks);
+    if (error)
+        clib_error_report(error);
 }
 
 static u8*
@@ -996,7 +1095,6 @@ fib_walk_show (vlib_main_t * vm,
     int more_elts, ii;
     u8 *s = NULL;
 
-#define USEC 1000000
     vlib_cli_output(vm, "FIB Walk Quota = %.2fusec:", quota * USEC);
     vlib_cli_output(vm, "FIB Walk queues:");
 
@@ -1077,6 +1175,24 @@ fib_walk_show (vlib_main_t * vm,
     vlib_cli_output(vm, "  %v", s);
     vec_free(s);
 
+    vlib_cli_output(vm, " Convergence, start to last child visited:");
+    vlib_cli_output(vm, "  walks:%lld", fib_walk_convergence.fwc_n_walks);
+    if (0 != fib_walk_convergence.fwc_n_walks)
+    {
+        vlib_cli_output(vm, "  last:%.2fusec max:%.2fusec avg:%.2fusec",
+                        fib_walk_convergence.fwc_last * USEC,
+                        fib_walk_convergence.fwc_max * USEC,
+                        (fib_walk_convergence.fwc_total * USEC) /
+                        fib_walk_convergence.fwc_n_walks);
+    }
+    for (ii = 0; ii < CONVERGENCE_N_BUCKETS; ii++)
+    {
+	if (0 != fib_walk_convergence.fwc_hist[ii])
+	    s = format(s, "<%lld:%lld ", 1ULL << (ii + 1),
+		       fib_walk_convergence.fwc_hist[ii]);
+    }
+    vlib_cli_output(vm, "  usec %v", s);
+    vec_free(s);
 
     vlib_cli_output(vm, "Brief History (last %d walks):", HISTORY_N_WALKS);
     ii = history_last_walk_pos - 1;
@@ -1090,11 +1206,12 @@ fib_walk_show (vlib_main_t * vm,
             u8 *s = NULL;
             u32 jj;
 
-	    s = format(s, "[@%d]: %s:%d visits:%d duration:%.2f completed:%.2f ",
+	    s = format(s, "[@%d]: %s:%d visits:%d duration:%.2f convergence:%.2f completed:%.2f ",
                        ii, fib_node_type_get_name(fib_walk_history[ii].fwh_parent.fnp_type),
                        fib_walk_history[ii].fwh_parent.fnp_index,
                        fib_walk_history[ii].fwh_n_visits,
                        fib_walk_history[ii].fwh_duration,
+                       fib_walk_history[ii].fwh_convergence,
                        fib_walk_history[ii].fwh_completed);
             if (FIB_WALK_FLAG_SYNC & fib_walk_history[ii].fwh_flags)
                 s = format(s, "sync, ");
@@ -1188,6 +1305,18 @@ fib_walk_clear (vlib_main_t * vm,
     clib_memset(fib_walk_work_time_taken, 0, sizeof(fib_walk_work_time_taken));
     clib_memset(fib_walk_work_nodes_visited, 0, sizeof(fib_walk_work_nodes_visited));
     clib_memset(fib_walk_sleep_lengths, 0, sizeof(fib_walk_sleep_lengths));
+    fib_walk_convergence.fwc_last = 0;
+    fib_walk_convergence.fwc_max = 0;
+    fib_walk_convergence.fwc_total = 0;
+    fib_walk_convergence.fwc_n_walks = 0;
+    clib_memset(fib_walk_convergence.fwc_hist, 0,
+                sizeof(fib_walk_convergence.fwc_hist));
+    if (~0 != fib_walk_convergence.fwc_stats_n_walks)
+    {
+        stat_segment_set_state_counter(fib_walk_convergence.fwc_stats_last, 0);
+        stat_segment_set_state_counter(fib_walk_convergence.fwc_stats_max, 0);
+        stat_segment_set_state_counter(fib_walk_convergence.fwc_stats_n_walks, 0);
+    }
 
     return (NULL);
 }
@@ -112,7 +112,8 @@
   _(2, BUFFER_ADVANCE, "buffer-advance") \
   _(3, REDIRECT_TO_NODE, "redirect-to-node") \
   _(4, REDIRECT_TO_QUEUE, "redirect-to-queue") \
-  _(5, DROP, "drop")
+  _(5, DROP, "drop") \
+  _(6, RSS, "rss")
 
 typedef enum
 {
@@ -188,6 +189,10 @@ typedef struct
   /* queue for VNET_FLOW_ACTION_REDIRECT_TO_QUEUE */
   u32 redirect_queue;
 
+  /* queue group for VNET_FLOW_ACTION_RSS */
+  u32 queue_index;
+  u32 queue_num;
+
   /* buffer offset for VNET_FLOW_ACTION_BUFFER_ADVANCE */
   i32 buffer_advance;
 
@@ -232,6 +237,7 @@ typedef struct
 
 extern vnet_flow_main_t flow_main;
 
+format_function_t format_flow_error;
 format_function_t format_flow_actions;
 format_function_t format_flow_enabled_hw;
 
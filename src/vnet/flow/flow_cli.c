@@ -296,6 +296,7 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
   ip_port_and_mask_t dport = { };
   u16 eth_type;
   bool ethernet_set = false;
+  u32 queue_end = 0;
 
   clib_memset (&flow, 0, sizeof (vnet_flow_t));
   flow.index = ~0;
@@ -370,6 +371,9 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
 	flow.actions |= VNET_FLOW_ACTION_REDIRECT_TO_QUEUE;
       else if (unformat (line_input, "drop"))
 	flow.actions |= VNET_FLOW_ACTION_DROP;
+      else if (unformat (line_input, "rss queues %u to %u",
+			 &flow.queue_index, &queue_end))
+	flow.actions |= VNET_FLOW_ACTION_RSS;
       else if (unformat (line_input, "%U", unformat_vnet_hw_interface, vnm,
 			 &hw_if_index))
 	;
@@ -393,6 +397,13 @@ test_flow (vlib_main_t * vm, unformat_input_t * input,
       if (flow.actions == 0)
 	return clib_error_return (0, "Please specify at least one action");
 
+      if (flow.actions & VNET_FLOW_ACTION_RSS)
+	{
+	  if (queue_end < flow.queue_index)
+	    return clib_error_return (0, "Please specify a valid queue range");
+	  flow.queue_num = queue_end - flow.queue_index + 1;
+	}
+
       /* Adjust the flow type */
       if (ethernet_set == true)
 	outer_type = VNET_FLOW_TYPE_ETHERNET;
@@ -683,6 +694,13 @@ format_flow (u8 * s, va_list * args)
   if (f->actions & VNET_FLOW_ACTION_BUFFER_ADVANCE)
     t = format (t, "%sbuffer-advance %d", t ? ", " : "", f->buffer_advance);
 
+  if (f->actions & VNET_FLOW_ACTION_REDIRECT_TO_QUEUE)
+    t = format (t, "%squeue %u", t ? ", " : "", f->redirect_queue);
+
+  if (f->actions & VNET_FLOW_ACTION_RSS)
+    t = format (t, "%srss queues %u to %u", t ? ", " : "", f->queue_index,
+		f->queue_index + f->queue_num - 1);
+
   if (t)
     {
       s = format (s, "\n%U%v", format_white_space, indent + 4, t);
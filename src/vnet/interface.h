@@ -922,6 +922,11 @@ typedef struct
   u8 drop_enable;
   u32 sw_if_index;
   int filter;
+  /* stream pcapng from per-thread rings instead of buffering */
+  u8 stream;
+  u32 ring_size;
+  u64 rotate_file_size;
+  u32 rotate_n_files;
 } vnet_pcap_dispatch_trace_args_t;
 
 int vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t *);
@@ -1872,6 +1872,65 @@ VLIB_CLI_COMMAND (cmd_set_if_rx_placement,static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_interface_trace_sample (vlib_main_t * vm, unformat_input_t * input,
+			    vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0;
+  u32 interval = ~0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "every %u", &interval))
+	;
+      else if (unformat (input, "off"))
+	interval = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index == ~0)
+    return clib_error_return (0, "please specify an interface...");
+
+  if (interval == ~0)
+    return clib_error_return (0, "please specify 'every <n>' or 'off'...");
+
+  if (vlib_trace_sample_enable_disable (sw_if_index, interval))
+    return clib_error_return (0, "packet trace active, "
+			      "'clear trace' first...");
+
+  return 0;
+}
+
+/*?
+ * Sample 1 in <em>n</em> packets received on an interface. Every node a
+ * sampled packet passes leaves a compact record (node, dispatch time
+ * stamp) in a per-thread ring instead of a full trace, so sampling can
+ * stay on in production. Records of packets handed off to other threads
+ * are matched by sample id.
+ *
+ * Use <b>show trace sample</b> to display per-node clocks, or
+ * <b>show trace sample dump <file></b> to save the raw records for
+ * offline decoding. Cannot be combined with <b>trace add</b>.
+ * Sampling is done in ethernet-input.
+ *
+ * @cliexpar
+ * @cliexstart{set interface trace-sample GigabitEthernet2/0/0 every 1000}
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_interface_trace_sample_command, static) = {
+  .path = "set interface trace-sample",
+  .short_help = "set interface trace-sample <interface> every <n>|off",
+  .function = set_interface_trace_sample,
+};
+/* *INDENT-ON* */
+
 static u8 *
 format_vnet_pcap (u8 * s, va_list * args)
 {
@@ -1907,6 +1966,76 @@ format_vnet_pcap (u8 * s, va_list * args)
 }
 
 
+/* rings are drained every millisecond, 8k slots per thread cover
+   a few Mpps per worker */
+#define PCAP_STREAM_DRAIN_INTERVAL 1e-3
+#define PCAP_STREAM_DEFAULT_RING_SIZE 8192
+
+vlib_node_registration_t pcap_stream_writer_node;
+
+static void
+pcap_stream_counters (pcap_main_t * pm, u64 * n_captured, u64 * n_drops)
+{
+  pcap_ring_t *r;
+
+  *n_captured = *n_drops = 0;
+
+  /* *INDENT-OFF* */
+  vec_foreach (r, pm->rings)
+    {
+      *n_captured += r->n_packets_captured;
+      *n_drops += r->n_drops;
+    }
+  /* *INDENT-ON* */
+}
+
+static uword
+pcap_stream_writer_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+			    vlib_frame_t * f)
+{
+  vnet_pcap_t *pp = &vm->pcap;
+  pcap_main_t *pm = &pp->pcap_main;
+  clib_error_t *error;
+
+  while (1)
+    {
+      if (pm->flags & PCAP_MAIN_STREAM)
+	vlib_process_wait_for_event_or_clock (vm,
+					      PCAP_STREAM_DRAIN_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, 0);
+
+      if (!(pm->flags & PCAP_MAIN_STREAM))
+	continue;
+
+      if ((error = pcap_stream_drain (pm)) == 0)
+	continue;
+
+      /* give up on I/O errors, stop capture */
+      clib_error_report (error);
+      vlib_worker_thread_barrier_sync (vm);
+      pp->pcap_rx_enable = 0;
+      pp->pcap_tx_enable = 0;
+      pp->pcap_drop_enable = 0;
+      pp->filter_classify_table_index = ~0;
+      error = pcap_stream_close (pm);
+      vlib_worker_thread_barrier_release (vm);
+      clib_error_free (error);
+    }
+
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (pcap_stream_writer_node) = {
+  .function = pcap_stream_writer_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "pcap-stream-writer-process",
+};
+/* *INDENT-ON* */
+
 int
 vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
 {
@@ -1920,10 +2049,20 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
     {
       if (pp->pcap_rx_enable || pp->pcap_tx_enable || pp->pcap_drop_enable)
 	{
-	  vlib_cli_output
-	    (vm, "pcap %U dispatch capture enabled: %d of %d pkts...",
-	     format_vnet_pcap, pp, 0 /* print type */ ,
-	     pm->n_packets_captured, pm->n_packets_to_capture);
+	  if (pm->flags & PCAP_MAIN_STREAM)
+	    {
+	      u64 n_captured, n_drops;
+	      pcap_stream_counters (pm, &n_captured, &n_drops);
+	      vlib_cli_output
+		(vm, "pcap %U stream capture enabled: %llu pkts, "
+		 "%llu ring drops...", format_vnet_pcap, pp,
+		 0 /* print type */ , n_captured, n_drops);
+	    }
+	  else
+	    vlib_cli_output
+	      (vm, "pcap %U dispatch capture enabled: %d of %d pkts...",
+	       format_vnet_pcap, pp, 0 /* print type */ ,
+	       pm->n_packets_captured, pm->n_packets_to_capture);
 	  vlib_cli_output (vm, "capture to file %s", pm->file_name);
 	}
       else
@@ -1963,6 +2102,14 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
       if (a->max_bytes_per_pkt < 32 || a->max_bytes_per_pkt > 9000)
 	return VNET_API_ERROR_INVALID_MEMORY_SIZE;
 
+      /* Ring size must be a power of 2 */
+      if (a->stream && (a->ring_size < 64 || !is_pow2 (a->ring_size)))
+	return VNET_API_ERROR_INVALID_VALUE_3;
+
+      /* Rotating into no file would truncate the capture */
+      if (a->stream && a->rotate_file_size && a->rotate_n_files == 0)
+	return VNET_API_ERROR_INVALID_ARGUMENT;
+
       /* Clean up from previous run, if any */
       vec_free (pm->file_name);
       vec_free (pm->pcap_data);
@@ -1982,7 +2129,8 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
 	    stem = format (stem, "tx");
 	  if (a->drop_enable)
 	    stem = format (stem, "drop");
-	  a->filename = format (0, "/tmp/%s.pcap%c", stem, 0);
+	  a->filename = format (0, "/tmp/%s.%s%c", stem,
+				a->stream ? "pcapng" : "pcap", 0);
 	  vec_free (stem);
 	}
 
@@ -1995,6 +2143,26 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
 	pp->filter_classify_table_index = set->table_indices[0];
       else
 	pp->filter_classify_table_index = ~0;
+
+      if (a->stream)
+	{
+	  clib_error_t *error;
+
+	  pm->snaplen = a->max_bytes_per_pkt;
+	  pm->ring_size = a->ring_size;
+	  pm->rotate_file_size = a->rotate_file_size;
+	  pm->rotate_n_files = a->rotate_n_files;
+	  pm->time_offset = unix_time_now () - vlib_time_now (vm);
+
+	  if ((error = pcap_stream_open (pm, vec_len (vlib_mains))))
+	    {
+	      clib_error_report (error);
+	      return VNET_API_ERROR_SYSCALL_ERROR_1;
+	    }
+
+	  vlib_process_signal_event (vm, pcap_stream_writer_node.index, 0,
+				     0);
+	}
       pp->pcap_rx_enable = a->rx_enable;
       pp->pcap_tx_enable = a->tx_enable;
       pp->pcap_drop_enable = a->drop_enable;
@@ -2006,6 +2174,23 @@ vnet_pcap_dispatch_trace_configure (vnet_pcap_dispatch_trace_args_t * a)
       pp->pcap_tx_enable = 0;
       pp->pcap_drop_enable = 0;
       pp->filter_classify_table_index = ~0;
+      if (pm->flags & PCAP_MAIN_STREAM)
+	{
+	  clib_error_t *error;
+	  u64 n_captured, n_drops;
+
+	  pcap_stream_counters (pm, &n_captured, &n_drops);
+	  vlib_cli_output (vm, "Wrote %llu packets (%llu ring drops) to %s, "
+			   "and stop capture...", n_captured, n_drops,
+			   pm->file_name);
+	  /* workers are stopped at the barrier, drain the rest */
+	  if ((error = pcap_stream_close (pm)))
+	    {
+	      clib_error_report (error);
+	      return VNET_API_ERROR_SYSCALL_ERROR_1;
+	    }
+	  return 0;
+	}
       if (pm->n_packets_captured)
 	{
 	  clib_error_t *error;
@@ -2047,6 +2232,10 @@ pcap_trace_command_fn (vlib_main_t * vm,
   int status = 0;
   int filter = 0;
   u32 sw_if_index = ~0;
+  int stream = 0;
+  u32 ring_size = PCAP_STREAM_DEFAULT_RING_SIZE;
+  u32 rotate_size = 0;
+  u32 rotate_files = 0;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -2081,6 +2270,14 @@ pcap_trace_command_fn (vlib_main_t * vm,
 	sw_if_index = 0;
       else if (unformat (line_input, "filter"))
 	filter = 1;
+      else if (unformat (line_input, "stream"))
+	stream = 1;
+      else if (unformat (line_input, "ring-size %u", &ring_size))
+	;
+      else if (unformat (line_input, "rotate-size %u", &rotate_size))
+	;
+      else if (unformat (line_input, "rotate-files %u", &rotate_files))
+	;
       else
 	{
 	  return clib_error_return (0, "unknown input `%U'",
@@ -2100,6 +2297,10 @@ pcap_trace_command_fn (vlib_main_t * vm,
   a->sw_if_index = sw_if_index;
   a->filter = filter;
   a->max_bytes_per_pkt = max_bytes_per_pkt;
+  a->stream = stream;
+  a->ring_size = ring_size;
+  a->rotate_file_size = (u64) rotate_size << 20;
+  a->rotate_n_files = rotate_files;
 
   rv = vnet_pcap_dispatch_trace_configure (a);
 
@@ -2132,6 +2333,14 @@ pcap_trace_command_fn (vlib_main_t * vm,
       return clib_error_return
 	(0, "No classify filter configured, see 'classify filter...'");
 
+    case VNET_API_ERROR_INVALID_VALUE_3:
+      return clib_error_return
+	(0, "Ring size must be a power of 2, at least 64...");
+
+    case VNET_API_ERROR_INVALID_ARGUMENT:
+      return clib_error_return
+	(0, "rotate-size needs rotate-files, at least 1...");
+
     default:
       vlib_cli_output (vm, "WARNING: trace configure returned %d", rv);
       break;
@@ -2181,6 +2390,22 @@ pcap_trace_command_fn (vlib_main_t * vm,
  *   named "/tmp/rx.pcap", "/tmp/tx.pcap", "/tmp/rxandtx.pcap", etc.
  *   Can only be updated if packet capture is off.
  *
+ * - <b>stream</b> - Capture into lock-free per-thread rings which are
+ *   drained in the background into a pcapng file, instead of buffering
+ *   '<em>max</em>' packets in memory. Capture runs until stopped with
+ *   '<em>off</em>'. Packets are dropped from the capture (and counted)
+ *   when a ring is full.
+ *
+ * - <b>ring-size <nn></b> - Slots per thread ring in stream mode, power
+ *   of 2. Defaults to 8192.
+ *
+ * - <b>rotate-size <MB></b> - In stream mode, rotate the file once it grows
+ *   over '<em>MB</em>' megabytes. The current file is renamed to
+ *   '<em>name.1</em>', older files are shifted.
+ *
+ * - <b>rotate-files <nn></b> - Number of rotated files to keep, at least
+ *   1 with '<em>rotate-size</em>'.
+ *
  * - <b>status</b> - Displays the current status and configured attributes
  *   associated with a packet capture. If packet capture is in progress,
  *   '<em>status</em>' also will return the number of packets currently in
@@ -2206,13 +2431,18 @@ pcap_trace_command_fn (vlib_main_t * vm,
  * captured 21 pkts...
  * saved to /tmp/vppTest.pcap...
  * @cliexend
+ * Example of how to stream rx and tx packets into 100MB files, keeping
+ * the last 5 files:
+ * @cliexstart{pcap trace rx tx stream rotate-size 100 rotate-files 5 file rxtx.pcapng}
+ * @cliexend
 ?*/
 /* *INDENT-OFF* */
 
 VLIB_CLI_COMMAND (pcap_tx_trace_command, static) = {
     .path = "pcap trace",
     .short_help =
-    "pcap trace rx tx drop off [max <nn>] [intfc <interface>|any] [file <name>] [status] [max-bytes-per-pkt <nnnn>][filter]",
+    "pcap trace rx tx drop off [max <nn>] [intfc <interface>|any] [file <name>] [status] [max-bytes-per-pkt <nnnn>][filter]\n"
+    "  [stream [ring-size <nn>] [rotate-size <MB>] [rotate-files <nn>]]",
     .function = pcap_trace_command_fn,
 };
 /* *INDENT-ON* */
@@ -66,207 +66,124 @@ static char *vnet_policer_error_strings[] = {
 #undef _
 };
 
+static_always_inline u32
+vnet_policer_index (vnet_policer_main_t * pm, vlib_buffer_t * b,
+		    vnet_policer_index_t which)
+{
+  u32 sw_if_index = vnet_buffer (b)->sw_if_index[VLIB_RX];
+  u32 pi = 0;
+
+  if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
+    pi = pm->policer_index_by_sw_if_index[sw_if_index];
+
+  if (which == VNET_POLICER_INDEX_BY_OPAQUE)
+    pi = vnet_buffer (b)->policer.index;
+
+  if (which == VNET_POLICER_INDEX_BY_EITHER)
+    {
+      pi = vnet_buffer (b)->policer.index;
+      pi = (pi != ~0) ? pi : pm->policer_index_by_sw_if_index[sw_if_index];
+    }
+
+  return pi;
+}
+
 static inline uword
 vnet_policer_inline (vlib_main_t * vm,
 		     vlib_node_runtime_t * node,
 		     vlib_frame_t * frame, vnet_policer_index_t which)
 {
-  u32 n_left_from, *from, *to_next;
-  vnet_policer_next_t next_index;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+  u32 policer_indices[VLIB_FRAME_SIZE], *pi;
+  u32 n_left, *from;
   vnet_policer_main_t *pm = &vnet_policer_main;
   u64 time_in_policer_periods;
   u32 transmitted = 0;
+  u8 act;
 
+  /* one timer read for the whole frame */
   time_in_policer_periods =
     clib_cpu_time_now () >> POLICER_TICKS_PER_PERIOD_SHIFT;
 
   from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
 
-  while (n_left_from > 0)
-    {
-      u32 n_left_to_next;
+  /* first pass: policer lookup for the whole frame */
+  b = bufs;
+  pi = policer_indices;
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-
-      while (n_left_from >= 4 && n_left_to_next >= 2)
+  while (n_left >= 4)
+    {
+      /* Prefetch next iteration. */
+      if (n_left >= 8)
 	{
-	  u32 bi0, bi1;
-	  vlib_buffer_t *b0, *b1;
-	  u32 next0, next1;
-	  u32 sw_if_index0, sw_if_index1;
-	  u32 pi0 = 0, pi1 = 0;
-	  u8 act0, act1;
-
-	  /* Prefetch next iteration. */
-	  {
-	    vlib_buffer_t *b2, *b3;
-
-	    b2 = vlib_get_buffer (vm, from[2]);
-	    b3 = vlib_get_buffer (vm, from[3]);
-
-	    vlib_prefetch_buffer_header (b2, LOAD);
-	    vlib_prefetch_buffer_header (b3, LOAD);
-	  }
-
-	  /* speculatively enqueue b0 and b1 to the current next frame */
-	  to_next[0] = bi0 = from[0];
-	  to_next[1] = bi1 = from[1];
-	  from += 2;
-	  to_next += 2;
-	  n_left_from -= 2;
-	  n_left_to_next -= 2;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  b1 = vlib_get_buffer (vm, bi1);
-
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	  next0 = VNET_POLICER_NEXT_TRANSMIT;
-
-	  sw_if_index1 = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-	  next1 = VNET_POLICER_NEXT_TRANSMIT;
-
-
-	  if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
-	    {
-	      pi0 = pm->policer_index_by_sw_if_index[sw_if_index0];
-	      pi1 = pm->policer_index_by_sw_if_index[sw_if_index1];
-	    }
-
-	  if (which == VNET_POLICER_INDEX_BY_OPAQUE)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi1 = vnet_buffer (b1)->policer.index;
-	    }
-
-	  if (which == VNET_POLICER_INDEX_BY_EITHER)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi0 = (pi0 != ~0) ? pi0 :
-		pm->policer_index_by_sw_if_index[sw_if_index0];
-	      pi1 = vnet_buffer (b1)->policer.index;
-	      pi1 = (pi1 != ~0) ? pi1 :
-		pm->policer_index_by_sw_if_index[sw_if_index1];
-	    }
+	  vlib_prefetch_buffer_header (b[4], LOAD);
+	  vlib_prefetch_buffer_header (b[5], LOAD);
+	  vlib_prefetch_buffer_header (b[6], LOAD);
+	  vlib_prefetch_buffer_header (b[7], LOAD);
+	}
 
-	  act0 = vnet_policer_police (vm, b0, pi0, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
+      pi[0] = vnet_policer_index (pm, b[0], which);
+      pi[1] = vnet_policer_index (pm, b[1], which);
+      pi[2] = vnet_policer_index (pm, b[2], which);
+      pi[3] = vnet_policer_index (pm, b[3], which);
 
-	  act1 = vnet_policer_police (vm, b1, pi1, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
+      b += 4;
+      pi += 4;
+      n_left -= 4;
+    }
 
-	  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next0 = VNET_POLICER_NEXT_DROP;
-	      b0->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
+  while (n_left > 0)
+    {
+      pi[0] = vnet_policer_index (pm, b[0], which);
 
-	  if (PREDICT_FALSE (act1 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next1 = VNET_POLICER_NEXT_DROP;
-	      b1->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
+      b += 1;
+      pi += 1;
+      n_left -= 1;
+    }
 
+  /* second pass: police the frame, the policer state (or per-thread
+     token cache) stays hot across packets of the same policer */
+  n_left = frame->n_vectors;
+  b = bufs;
+  pi = policer_indices;
+  next = nexts;
 
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)))
-	    {
-	      if (b0->flags & VLIB_BUFFER_IS_TRACED)
-		{
-		  vnet_policer_trace_t *t =
-		    vlib_add_trace (vm, node, b0, sizeof (*t));
-		  t->sw_if_index = sw_if_index0;
-		  t->next_index = next0;
-		}
-	      if (b1->flags & VLIB_BUFFER_IS_TRACED)
-		{
-		  vnet_policer_trace_t *t =
-		    vlib_add_trace (vm, node, b1, sizeof (*t));
-		  t->sw_if_index = sw_if_index1;
-		  t->next_index = next1;
-		}
-	    }
+  while (n_left > 0)
+    {
+      act = vnet_policer_police (vm, b[0], pi[0], time_in_policer_periods,
+				 POLICE_CONFORM /* no chaining */ );
 
-	  /* verify speculative enqueues, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, bi1, next0, next1);
+      if (PREDICT_FALSE (act == SSE2_QOS_ACTION_DROP))	/* drop action */
+	{
+	  next[0] = VNET_POLICER_NEXT_DROP;
+	  b[0]->error = node->errors[VNET_POLICER_ERROR_DROP];
 	}
-
-      while (n_left_from > 0 && n_left_to_next > 0)
+      else			/* transmit or mark-and-transmit action */
 	{
-	  u32 bi0;
-	  vlib_buffer_t *b0;
-	  u32 next0;
-	  u32 sw_if_index0;
-	  u32 pi0 = 0;
-	  u8 act0;
-
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-	  next0 = VNET_POLICER_NEXT_TRANSMIT;
-
-	  if (which == VNET_POLICER_INDEX_BY_SW_IF_INDEX)
-	    pi0 = pm->policer_index_by_sw_if_index[sw_if_index0];
-
-	  if (which == VNET_POLICER_INDEX_BY_OPAQUE)
-	    pi0 = vnet_buffer (b0)->policer.index;
-
-	  if (which == VNET_POLICER_INDEX_BY_EITHER)
-	    {
-	      pi0 = vnet_buffer (b0)->policer.index;
-	      pi0 = (pi0 != ~0) ? pi0 :
-		pm->policer_index_by_sw_if_index[sw_if_index0];
-	    }
-
-	  act0 = vnet_policer_police (vm, b0, pi0, time_in_policer_periods,
-				      POLICE_CONFORM /* no chaining */ );
-
-	  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))	/* drop action */
-	    {
-	      next0 = VNET_POLICER_NEXT_DROP;
-	      b0->error = node->errors[VNET_POLICER_ERROR_DROP];
-	    }
-	  else			/* transmit or mark-and-transmit action */
-	    {
-	      transmitted++;
-	    }
-
-	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
-			     && (b0->flags & VLIB_BUFFER_IS_TRACED)))
-	    {
-	      vnet_policer_trace_t *t =
-		vlib_add_trace (vm, node, b0, sizeof (*t));
-	      t->sw_if_index = sw_if_index0;
-	      t->next_index = next0;
-	      t->policer_index = pi0;
-	    }
+	  next[0] = VNET_POLICER_NEXT_TRANSMIT;
+	  transmitted++;
+	}
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next,
-					   bi0, next0);
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
+			 && (b[0]->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  vnet_policer_trace_t *t =
+	    vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->sw_if_index = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
+	  t->next_index = next[0];
+	  t->policer_index = pi[0];
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      b += 1;
+      pi += 1;
+      next += 1;
+      n_left -= 1;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
   vlib_node_increment_counter (vm, node->node_index,
 			       VNET_POLICER_ERROR_TRANSMIT, transmitted);
   return frame->n_vectors;
@@ -578,12 +495,12 @@ policer_classify_inline (vlib_main_t * vm,
       t1 = pool_elt_at_index (vcm->tables, table_index1);
 
       vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
+	vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
 
       vnet_buffer (b1)->l2_classify.hash =
-	vnet_classify_hash_packet (t1, (u8 *) h1);
+	vnet_classify_hash_packet_inline (t1, (u8 *) h1);
 
       vnet_classify_prefetch_bucket (t1, vnet_buffer (b1)->l2_classify.hash);
 
@@ -614,7 +531,7 @@ policer_classify_inline (vlib_main_t * vm,
 
       t0 = pool_elt_at_index (vcm->tables, table_index0);
       vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
+	vnet_classify_hash_packet_inline (t0, (u8 *) h0);
 
       vnet_buffer (b0)->l2_classify.table_index = table_index0;
       vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
@@ -695,7 +612,8 @@ policer_classify_inline (vlib_main_t * vm,
 	    {
 	      hash0 = vnet_buffer (b0)->l2_classify.hash;
 	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	      e0 = vnet_classify_find_entry_inline (t0, (u8 *) h0, hash0,
+						    now);
 
 	      if (e0)
 		{
@@ -713,41 +631,30 @@ policer_classify_inline (vlib_main_t * vm,
 		}
 	      else
 		{
-		  while (1)
+		  e0 = vnet_classify_find_chain_entry_inline (vcm, &t0,
+							      (u8 *) h0,
+							      hash0, now);
+		  if (e0)
 		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			{
-			  t0 = pool_elt_at_index (vcm->tables,
-						  t0->next_table_index);
-			}
-		      else
+		      act0 = vnet_policer_police (vm,
+						  b0,
+						  e0->next_index,
+						  time_in_policer_periods,
+						  e0->opaque_index);
+		      if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
 			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  act0 = vnet_policer_police (vm,
-						      b0,
-						      e0->next_index,
-						      time_in_policer_periods,
-						      e0->opaque_index);
-			  if (PREDICT_FALSE (act0 == SSE2_QOS_ACTION_DROP))
-			    {
-			      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-			      b0->error =
-				node->errors[POLICER_CLASSIFY_ERROR_DROP];
-			    }
-			  hits++;
-			  chain_hits++;
-			  break;
+			  next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
+			  b0->error =
+			    node->errors[POLICER_CLASSIFY_ERROR_DROP];
 			}
+		      hits++;
+		      chain_hits++;
+		    }
+		  else
+		    {
+		      next0 = (t0->miss_next_index < n_next_nodes) ?
+			t0->miss_next_index : next0;
+		      misses++;
 		    }
 		}
 	    }
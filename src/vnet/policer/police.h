@@ -15,6 +15,8 @@
 #ifndef __POLICE_H__
 #define __POLICE_H__
 
+#include <vppinfra/lock.h>
+
 typedef enum
 {
   POLICE_CONFORM = 0,
@@ -53,6 +55,11 @@ typedef enum
 // The 64-bit last_update_time supports a 4Ghz CPU without rollover for 100 years
 //
 // The lock field should be used for a spin-lock on the struct.
+//
+// Hierarchical policing: a policer can have a parent policer (e.g. a per
+// class policer with a per customer aggregate parent). Packets which are
+// not dropped by the child are policed by the parent, color-aware with the
+// child result if the parent is color-aware.
 
 #define POLICER_TICKS_PER_PERIOD_SHIFT 17
 #define POLICER_TICKS_PER_PERIOD       (1 << POLICER_TICKS_PER_PERIOD_SHIFT)
@@ -82,21 +89,40 @@ typedef struct
   u32 extended_bucket;		// MOD
 
   u64 last_update_time;		// MOD
-  u64 pad64;
+  u32 parent_index;		// ~0 if no parent policer
+  u32 pad32;
 
 } policer_read_response_type_st;
 
-static inline policer_result_e
-vnet_police_packet (policer_read_response_type_st * policer,
-		    u32 packet_length,
-		    policer_result_e packet_color, u64 time)
+// Per-thread token cache of a shared policer.
+// Tokens are moved from the shared buckets to the per-thread cache in
+// batches of a fraction of the burst size (see POLICER_CACHE_QUANTUM_SHIFT),
+// so that workers only take the policer lock when their cache runs out,
+// instead of writing the shared cache line for every packet.
+// A thread which could not get tokens from the shared buckets does not retry
+// before the next policer period.
+// What is left in the cache goes back to the shared buckets, within their
+// limits, on each refill, and so do tokens cached for longer than
+// POLICER_CACHE_MAX_AGE periods, so that an idle thread neither holds on to
+// a slice of the burst nor loses it.
+
+#define POLICER_CACHE_QUANTUM_SHIFT 5
+#define POLICER_CACHE_MAX_AGE 16
+
+typedef struct
 {
-  u64 n_periods;
-  u64 current_tokens, extended_tokens;
-  policer_result_e result;
+  u32 current_tokens;
+  u32 extended_tokens;
+  // Low 32 bits of the time in policer periods, enough to tell periods apart
+  u32 last_refill_time;
+  u32 last_starved_time;
+} policer_thread_cache_t;
 
-  // Scale packet length to support a wide range of speeds
-  packet_length = packet_length << policer->scale;
+static inline void
+vnet_police_refill (policer_read_response_type_st * policer, u64 time,
+		    u64 * current_tokens, u64 * extended_tokens)
+{
+  u64 n_periods;
 
   // Compute the number of policer periods that have passed since the last
   // operation.
@@ -117,89 +143,165 @@ vnet_police_packet (policer_read_response_type_st * policer,
   // packet. This constraint on tokens_per_period lets the ucode omit
   // code to dynamically check for or prevent the overflow.
 
-  if (policer->single_rate)
+  // Compute number of tokens for this time period
+  *current_tokens =
+    policer->current_bucket + n_periods * policer->cir_tokens_per_period;
+  *extended_tokens =
+    policer->extended_bucket + n_periods *
+    (policer->single_rate ? policer->cir_tokens_per_period :
+     policer->pir_tokens_per_period);
+  if (*current_tokens > policer->current_limit)
     {
+      *current_tokens = policer->current_limit;
+    }
+  if (*extended_tokens > policer->extended_limit)
+    {
+      *extended_tokens = policer->extended_limit;
+    }
+}
 
-      // Compute number of tokens for this time period
-      current_tokens =
-	policer->current_bucket + n_periods * policer->cir_tokens_per_period;
-      if (current_tokens > policer->current_limit)
-	{
-	  current_tokens = policer->current_limit;
-	}
-
-      extended_tokens =
-	policer->extended_bucket + n_periods * policer->cir_tokens_per_period;
-      if (extended_tokens > policer->extended_limit)
-	{
-	  extended_tokens = policer->extended_limit;
-	}
-
-      // Determine color
-
+// Determine the color of a (scaled) packet given the available tokens,
+// and consume the tokens accordingly.
+static inline policer_result_e
+vnet_police_color (policer_read_response_type_st * policer,
+		   u64 * current_tokens, u64 * extended_tokens,
+		   u32 packet_length, policer_result_e packet_color)
+{
+  if (policer->single_rate)
+    {
       if ((!policer->color_aware || (packet_color == POLICE_CONFORM))
-	  && (current_tokens >= packet_length))
+	  && (*current_tokens >= packet_length))
 	{
-	  policer->current_bucket = current_tokens - packet_length;
-	  policer->extended_bucket = extended_tokens - packet_length;
-	  result = POLICE_CONFORM;
+	  *current_tokens -= packet_length;
+	  *extended_tokens -= (*extended_tokens > packet_length) ?
+	    packet_length : *extended_tokens;
+	  return POLICE_CONFORM;
 	}
       else if ((!policer->color_aware || (packet_color != POLICE_VIOLATE))
-	       && (extended_tokens >= packet_length))
-	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens - packet_length;
-	  result = POLICE_EXCEED;
-	}
-      else
+	       && (*extended_tokens >= packet_length))
 	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens;
-	  result = POLICE_VIOLATE;
+	  *extended_tokens -= packet_length;
+	  return POLICE_EXCEED;
 	}
+      return POLICE_VIOLATE;
+    }
 
+  // Two-rate policer
+  if ((policer->color_aware && (packet_color == POLICE_VIOLATE))
+      || (*extended_tokens < packet_length))
+    {
+      return POLICE_VIOLATE;
     }
-  else
+  else if ((policer->color_aware && (packet_color == POLICE_EXCEED))
+	   || (*current_tokens < packet_length))
     {
-      // Two-rate policer
-
-      // Compute number of tokens for this time period
-      current_tokens =
-	policer->current_bucket + n_periods * policer->cir_tokens_per_period;
-      extended_tokens =
-	policer->extended_bucket + n_periods * policer->pir_tokens_per_period;
-      if (current_tokens > policer->current_limit)
-	{
-	  current_tokens = policer->current_limit;
-	}
-      if (extended_tokens > policer->extended_limit)
-	{
-	  extended_tokens = policer->extended_limit;
-	}
+      *extended_tokens -= packet_length;
+      return POLICE_EXCEED;
+    }
+  *current_tokens -= packet_length;
+  *extended_tokens -= packet_length;
+  return POLICE_CONFORM;
+}
 
-      // Determine color
+static inline policer_result_e
+vnet_police_packet (policer_read_response_type_st * policer,
+		    u32 packet_length,
+		    policer_result_e packet_color, u64 time)
+{
+  u64 current_tokens, extended_tokens;
+  policer_result_e result;
 
-      if ((policer->color_aware && (packet_color == POLICE_VIOLATE))
-	  || (extended_tokens < packet_length))
-	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens;
-	  result = POLICE_VIOLATE;
-	}
-      else if ((policer->color_aware && (packet_color == POLICE_EXCEED))
-	       || (current_tokens < packet_length))
-	{
-	  policer->current_bucket = current_tokens;
-	  policer->extended_bucket = extended_tokens - packet_length;
-	  result = POLICE_EXCEED;
-	}
-      else
-	{
-	  policer->current_bucket = current_tokens - packet_length;
-	  policer->extended_bucket = extended_tokens - packet_length;
-	  result = POLICE_CONFORM;
-	}
+  // Scale packet length to support a wide range of speeds
+  packet_length = packet_length << policer->scale;
+
+  vnet_police_refill (policer, time, &current_tokens, &extended_tokens);
+  result = vnet_police_color (policer, &current_tokens, &extended_tokens,
+			      packet_length, packet_color);
+  policer->current_bucket = current_tokens;
+  policer->extended_bucket = extended_tokens;
+  return result;
+}
+
+// Police a packet using the per-thread token cache of a shared policer.
+// The shared buckets are only accessed, under the policer lock, when the
+// tokens in the cache are not enough to color the packet conform.
+static inline policer_result_e
+vnet_police_packet_cached (policer_read_response_type_st * policer,
+			   policer_thread_cache_t * cache,
+			   u32 packet_length,
+			   policer_result_e packet_color, u64 time)
+{
+  u64 current_tokens, extended_tokens;
+  u64 shared_current, shared_extended, quantum;
+  policer_result_e result;
+
+  // Scale packet length to support a wide range of speeds
+  packet_length = packet_length << policer->scale;
+
+  if ((u32) time - cache->last_refill_time > POLICER_CACHE_MAX_AGE
+      && (cache->current_tokens || cache->extended_tokens))
+    {
+      // Give the expired cache back to the shared buckets
+      while (clib_atomic_test_and_set (&policer->lock))
+	CLIB_PAUSE ();
+      shared_current = policer->current_bucket + cache->current_tokens;
+      if (shared_current > policer->current_limit)
+	shared_current = policer->current_limit;
+      shared_extended = policer->extended_bucket + cache->extended_tokens;
+      if (shared_extended > policer->extended_limit)
+	shared_extended = policer->extended_limit;
+      policer->current_bucket = shared_current;
+      policer->extended_bucket = shared_extended;
+      clib_atomic_release (&policer->lock);
+
+      cache->current_tokens = 0;
+      cache->extended_tokens = 0;
     }
+
+  current_tokens = cache->current_tokens;
+  extended_tokens = cache->extended_tokens;
+  result = vnet_police_color (policer, &current_tokens, &extended_tokens,
+			      packet_length, packet_color);
+
+  if (result != POLICE_CONFORM && cache->last_starved_time != (u32) time)
+    {
+      // Not enough cached tokens, take a batch from the shared buckets
+      cache->last_refill_time = time;
+      while (clib_atomic_test_and_set (&policer->lock))
+	CLIB_PAUSE ();
+      vnet_police_refill (policer, time, &shared_current, &shared_extended);
+
+      shared_current += cache->current_tokens;
+      if (shared_current > policer->current_limit)
+	shared_current = policer->current_limit;
+      shared_extended += cache->extended_tokens;
+      if (shared_extended > policer->extended_limit)
+	shared_extended = policer->extended_limit;
+
+      quantum = policer->current_limit >> POLICER_CACHE_QUANTUM_SHIFT;
+      quantum = quantum > packet_length ? quantum : packet_length;
+      quantum = quantum < shared_current ? quantum : shared_current;
+      shared_current -= quantum;
+      current_tokens = quantum;
+
+      quantum = policer->extended_limit >> POLICER_CACHE_QUANTUM_SHIFT;
+      quantum = quantum > packet_length ? quantum : packet_length;
+      quantum = quantum < shared_extended ? quantum : shared_extended;
+      shared_extended -= quantum;
+      extended_tokens = quantum;
+
+      policer->current_bucket = shared_current;
+      policer->extended_bucket = shared_extended;
+      clib_atomic_release (&policer->lock);
+
+      result = vnet_police_color (policer, &current_tokens, &extended_tokens,
+				  packet_length, packet_color);
+      if (result != POLICE_CONFORM)
+	cache->last_starved_time = time;
+    }
+
+  cache->current_tokens = current_tokens;
+  cache->extended_tokens = extended_tokens;
   return result;
 }
 
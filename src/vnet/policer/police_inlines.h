@@ -16,6 +16,7 @@
 #define __POLICE_INLINES_H__
 
 #include <vnet/policer/police.h>
+#include <vnet/policer/policer.h>
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
 
@@ -55,6 +56,23 @@ vnet_policer_mark (vlib_buffer_t * b, u8 dscp)
     }
 }
 
+static_always_inline policer_result_e
+vnet_policer_police_one (vnet_policer_main_t * pm, u32 thread_index,
+			 policer_read_response_type_st * pol,
+			 u32 policer_index, u32 len,
+			 policer_result_e packet_color,
+			 u64 time_in_policer_periods)
+{
+  if (pm->thread_caches)
+    return vnet_police_packet_cached (pol,
+				      pm->thread_caches[thread_index] +
+				      policer_index, len, packet_color,
+				      time_in_policer_periods);
+
+  return vnet_police_packet (pol, len, packet_color,
+			     time_in_policer_periods);
+}
+
 static_always_inline u8
 vnet_policer_police (vlib_main_t * vm,
 		     vlib_buffer_t * b,
@@ -62,18 +80,39 @@ vnet_policer_police (vlib_main_t * vm,
 		     u64 time_in_policer_periods,
 		     policer_result_e packet_color)
 {
-  u8 act;
+  u8 act, dscp;
   u32 len;
-  u32 col;
+  policer_result_e col, parent_col;
   policer_read_response_type_st *pol;
   vnet_policer_main_t *pm = &vnet_policer_main;
 
   len = vlib_buffer_length_in_chain (vm, b);
   pol = &pm->policers[policer_index];
-  col = vnet_police_packet (pol, len, packet_color, time_in_policer_periods);
+  col = vnet_policer_police_one (pm, vm->thread_index, pol, policer_index,
+				 len, packet_color, time_in_policer_periods);
   act = pol->action[col];
+  dscp = pol->mark_dscp[col];
+
+  /* Hierarchical policing: packets not dropped by the child are policed
+     by the parents, the worst color wins. */
+  while (PREDICT_FALSE (pol->parent_index != ~0)
+	 && act != SSE2_QOS_ACTION_DROP)
+    {
+      policer_index = pol->parent_index;
+      pol = &pm->policers[policer_index];
+      parent_col = vnet_policer_police_one (pm, vm->thread_index, pol,
+					    policer_index, len, col,
+					    time_in_policer_periods);
+      if (parent_col > col)
+	{
+	  col = parent_col;
+	  act = pol->action[col];
+	  dscp = pol->mark_dscp[col];
+	}
+    }
+
   if (PREDICT_TRUE (act == SSE2_QOS_ACTION_MARK_AND_TRANSMIT))
-    vnet_policer_mark (b, pol->mark_dscp[col]);
+    vnet_policer_mark (b, dscp);
 
   return act;
 }
@@ -18,6 +18,26 @@
 
 vnet_policer_main_t vnet_policer_main;
 
+static void
+policer_thread_caches_reset (vnet_policer_main_t * pm, u32 policer_index)
+{
+  policer_thread_cache_t *cache;
+  u32 n_threads = vec_len (vlib_mains);
+  u32 i;
+
+  if (n_threads < 2)
+    return;
+
+  vec_validate (pm->thread_caches, n_threads - 1);
+  for (i = 0; i < n_threads; i++)
+    {
+      vec_validate_aligned (pm->thread_caches[i], policer_index,
+			    CLIB_CACHE_LINE_BYTES);
+      cache = vec_elt_at_index (pm->thread_caches[i], policer_index);
+      clib_memset (cache, 0, sizeof (*cache));
+    }
+}
+
 clib_error_t *
 policer_add_del (vlib_main_t * vm,
 		 u8 * name,
@@ -52,6 +72,15 @@ policer_add_del (vlib_main_t * vm,
 	  vec_free (name);
 	  return clib_error_return (0, "No such policer");
 	}
+      /* detach the children */
+      /* *INDENT-OFF* */
+      pool_foreach (policer, pm->policers,
+      ({
+        if (policer->parent_index == p[0])
+          policer->parent_index = ~0;
+      }));
+      /* *INDENT-ON* */
+      policer_thread_caches_reset (pm, p[0]);
       pool_put_index (pm->policers, p[0]);
       hash_unset_mem (pm->policer_index_by_name, name);
 
@@ -78,6 +107,7 @@ policer_add_del (vlib_main_t * vm,
 
       ASSERT (cp - pm->configs == pp - pm->policer_templates);
 
+      test_policer.parent_index = ~0;
       clib_memcpy (cp, cfg, sizeof (*cp));
       clib_memcpy (pp, &test_policer, sizeof (*pp));
 
@@ -85,6 +115,7 @@ policer_add_del (vlib_main_t * vm,
       pool_get_aligned (pm->policers, policer, CLIB_CACHE_LINE_BYTES);
       policer[0] = pp[0];
       pi = policer - pm->policers;
+      policer_thread_caches_reset (pm, pi);
       hash_set_mem (pm->policer_index_by_name, name, pi);
       *policer_index = pi;
     }
@@ -97,6 +128,34 @@ policer_add_del (vlib_main_t * vm,
   return 0;
 }
 
+clib_error_t *
+policer_set_parent (u32 policer_index, u32 parent_index)
+{
+  vnet_policer_main_t *pm = &vnet_policer_main;
+  policer_read_response_type_st *policer;
+  u32 pi;
+
+  if (pool_is_free_index (pm->policers, policer_index))
+    return clib_error_return (0, "No such policer");
+
+  if (parent_index != ~0)
+    {
+      if (pool_is_free_index (pm->policers, parent_index))
+	return clib_error_return (0, "No such parent policer");
+
+      /* no loop in the hierarchy */
+      for (pi = parent_index; pi != ~0;
+	   pi = pool_elt_at_index (pm->policers, pi)->parent_index)
+	if (pi == policer_index)
+	  return clib_error_return (0, "Policer hierarchy loop");
+    }
+
+  policer = pool_elt_at_index (pm->policers, policer_index);
+  policer->parent_index = parent_index;
+
+  return 0;
+}
+
 u8 *
 format_policer_instance (u8 * s, va_list * va)
 {
@@ -425,8 +484,11 @@ configure_policer_command_fn (vlib_main_t * vm,
 {
   sse2_qos_pol_cfg_params_st c;
   unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_policer_main_t *pm = &vnet_policer_main;
   u8 is_add = 1;
   u8 *name = 0;
+  u8 *parent_name = 0;
+  uword *p = 0;
   u32 pi;
   clib_error_t *error = NULL;
 
@@ -444,6 +506,8 @@ configure_policer_command_fn (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "color-aware"))
 	c.color_aware = 1;
+      else if (unformat (line_input, "parent %s", &parent_name))
+	;
 
 #define _(a) else if (unformat (line_input, "%U", unformat_policer_##a, &c)) ;
       foreach_config_param
@@ -456,9 +520,25 @@ configure_policer_command_fn (vlib_main_t * vm,
 	}
     }
 
+  if (parent_name)
+    {
+      p = hash_get_mem (pm->policer_index_by_name, parent_name);
+      if (p == 0)
+	{
+	  error = clib_error_return (0, "No such parent policer `%s'",
+				     parent_name);
+	  goto done;
+	}
+    }
+
   error = policer_add_del (vm, name, &c, &pi, is_add);
 
+  /* a new policer has no children, so attaching it cannot loop */
+  if (!error && is_add && p)
+    error = policer_set_parent (pi, p[0]);
+
 done:
+  vec_free (parent_name);
   unformat_free (line_input);
 
   return error;
@@ -467,7 +547,7 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (configure_policer_command, static) = {
     .path = "configure policer",
-    .short_help = "configure policer name <name> <params> ",
+    .short_help = "configure policer name <name> <params> [parent <name>]",
     .function = configure_policer_command_fn,
 };
 /* *INDENT-ON* */
@@ -483,6 +563,9 @@ show_policer_command_fn (vlib_main_t * vm,
   u8 *name;
   sse2_qos_pol_cfg_params_st *config;
   policer_read_response_type_st *templ;
+  policer_read_response_type_st *policer;
+  hash_pair_t *pp;
+  uword *pi;
 
   (void) unformat (input, "name %s", &match_name);
 
@@ -499,6 +582,14 @@ show_policer_command_fn (vlib_main_t * vm,
                          name, format_policer_config, config);
         vlib_cli_output (vm, "Template %U",
                          format_policer_instance, templ);
+        pi = hash_get_mem (pm->policer_index_by_name, name);
+        policer = pi ? pool_elt_at_index (pm->policers, pi[0]) : 0;
+        if (policer && policer->parent_index != ~0)
+          hash_foreach_pair (pp, pm->policer_index_by_name,
+          ({
+            if (pp->value[0] == policer->parent_index)
+              vlib_cli_output (vm, "Parent \"%s\"", (u8 *) pp->key);
+          }));
         vlib_cli_output (vm, "-----------");
       }
   }));
@@ -39,6 +39,10 @@ typedef struct
   /* Policer by sw_if_index vector */
   u32 *policer_index_by_sw_if_index;
 
+  /* Per-thread token caches, indexed by policer index.
+     Only used with worker threads. */
+  policer_thread_cache_t **thread_caches;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -95,6 +99,7 @@ clib_error_t *policer_add_del (vlib_main_t * vm,
 			       u8 * name,
 			       sse2_qos_pol_cfg_params_st * cfg,
 			       u32 * policer_index, u8 is_add);
+clib_error_t *policer_set_parent (u32 policer_index, u32 parent_index);
 
 #endif /* __included_policer_h__ */
 
@@ -28,6 +28,7 @@
 #include <assert.h>
 #include <vppinfra/vec.h>
 #include <vppinfra/lock.h>
+#include <vppinfra/vector.h>
 #include <stdatomic.h>
 #include <vpp/stats/stat_segment.h>
 #include <vpp-api/client/stat_client.h>
@@ -490,6 +491,312 @@ stat_segment_version (void)
   return stat_segment_version_r (sm);
 }
 
+/* Add n counters from src to dst */
+static inline void
+stat_sum_counters (counter_t * dst, counter_t * src, uword n)
+{
+  uword i = 0;
+
+#if defined (CLIB_HAVE_VEC256)
+  for (; i + 4 <= n; i += 4)
+    u64x4_store_unaligned (u64x4_load_unaligned (dst + i) +
+			   u64x4_load_unaligned (src + i), dst + i);
+#elif defined (CLIB_HAVE_VEC128)
+  for (; i + 2 <= n; i += 2)
+    u64x2_store_unaligned (u64x2_load_unaligned (dst + i) +
+			   u64x2_load_unaligned (src + i), dst + i);
+#endif
+  for (; i < n; i++)
+    dst[i] += src[i];
+}
+
+/* Number of leading counters equal in a and b */
+static inline uword
+stat_counters_equal_prefix (counter_t * a, counter_t * b, uword n)
+{
+  uword i = 0;
+
+#if defined (CLIB_HAVE_VEC256)
+  for (; i + 4 <= n; i += 4)
+    if (!u64x4_is_equal (u64x4_load_unaligned (a + i),
+			 u64x4_load_unaligned (b + i)))
+      break;
+#elif defined (CLIB_HAVE_VEC128)
+  for (; i + 2 <= n; i += 2)
+    if (!u64x2_is_equal (u64x2_load_unaligned (a + i),
+			 u64x2_load_unaligned (b + i)))
+      break;
+#endif
+  for (; i < n; i++)
+    if (a[i] != b[i])
+      break;
+  return i;
+}
+
+/*
+ * Sum an entry across threads, reading the per-thread vectors in place.
+ * Combined counters are summed as flat packets/bytes pairs.
+ */
+static counter_t *
+snapshot_sum_entry (stat_segment_directory_entry_t * ep, counter_t * sum,
+		    stat_client_main_t * sm)
+{
+  counter_t **vectors;
+  uint64_t *offset_vector;
+  counter_t *cb;
+  uword i, n, old_len, width;
+
+  vec_reset_length (sum);
+
+  switch (ep->type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      vec_validate (sum, 0);
+      clib_memcpy_fast (sum, &ep->value, sizeof (sum[0]));
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      if (ep->offset == 0)
+	break;
+      width = ep->type == STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED ?
+	sizeof (vlib_counter_t) / sizeof (counter_t) : 1;
+      vectors = stat_segment_pointer (sm->shared_header, ep->offset);
+      offset_vector =
+	stat_segment_pointer (sm->shared_header, ep->offset_vector);
+      for (i = 0; i < vec_len (vectors); i++)
+	{
+	  cb = stat_segment_pointer (sm->shared_header, offset_vector[i]);
+	  n = vec_len (cb) * width;
+	  if (n == 0)
+	    continue;
+	  old_len = vec_len (sum);
+	  if (n > old_len)
+	    {
+	      vec_validate (sum, n - 1);
+	      clib_memset (sum + old_len, 0,
+			   (n - old_len) * sizeof (sum[0]));
+	    }
+	  stat_sum_counters (sum, cb, n);
+	}
+      break;
+
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      offset_vector = stat_segment_pointer (sm->shared_header,
+					    sm->shared_header->error_offset);
+      vec_validate (sum, 0);
+      sum[0] = 0;
+      for (i = 0; i < vec_len (offset_vector); i++)
+	{
+	  cb = stat_segment_pointer (sm->shared_header, offset_vector[i]);
+	  sum[0] += cb[ep->index];
+	}
+      break;
+
+    default:
+      /* Name vectors have no deltas */
+      break;
+    }
+  return sum;
+}
+
+static inline counter_t
+stat_counter_delta (counter_t cur, counter_t prev)
+{
+  /* A counter that went backwards was cleared, report it from zero */
+  return cur >= prev ? cur - prev : cur;
+}
+
+static void
+snapshot_add_deltas (stat_segment_snapshot_t * ss, uint32_t stat,
+		     stat_directory_type_t type, bool changed_only)
+{
+  counter_t *cur = ss->sums[stat];
+  counter_t *prev = ss->prev_sums[stat];
+  uword i, n_cur = vec_len (cur), n_prev = vec_len (prev);
+  stat_segment_delta_t *d;
+  counter_t zero[2] = { 0 };
+  counter_t *p;
+
+  switch (type)
+    {
+    case STAT_DIR_TYPE_SCALAR_INDEX:
+      /* Scalars are gauges, report the current value */
+      if (n_cur && (!changed_only || n_prev == 0 || cur[0] != prev[0]))
+	{
+	  vec_add2 (ss->deltas, d, 1);
+	  d->stat = stat;
+	  d->index = 0;
+	  clib_memcpy_fast (&d->scalar_value, cur, sizeof (cur[0]));
+	}
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE:
+    case STAT_DIR_TYPE_ERROR_INDEX:
+      for (i = 0; i < n_cur; i++)
+	{
+	  if (changed_only && i < n_prev)
+	    {
+	      i += stat_counters_equal_prefix (cur + i, prev + i,
+					       clib_min (n_cur, n_prev) - i);
+	      if (i == n_cur)
+		break;
+	    }
+	  p = i < n_prev ? prev + i : zero;
+	  if (changed_only && cur[i] == p[0])
+	    continue;
+	  vec_add2 (ss->deltas, d, 1);
+	  d->stat = stat;
+	  d->index = i;
+	  d->value = stat_counter_delta (cur[i], p[0]);
+	}
+      break;
+
+    case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+      for (i = 0; i < n_cur; i += 2)
+	{
+	  if (changed_only && i < n_prev)
+	    {
+	      /* Skip to the first pair containing a difference */
+	      i += stat_counters_equal_prefix (cur + i, prev + i,
+					       clib_min (n_cur, n_prev) - i);
+	      i &= ~(uword) 1;
+	      if (i >= n_cur)
+		break;
+	    }
+	  p = i < n_prev ? prev + i : zero;
+	  if (changed_only && cur[i] == p[0] && cur[i + 1] == p[1])
+	    continue;
+	  vec_add2 (ss->deltas, d, 1);
+	  d->stat = stat;
+	  d->index = i / 2;
+	  d->combined.packets = stat_counter_delta (cur[i], p[0]);
+	  d->combined.bytes = stat_counter_delta (cur[i + 1], p[1]);
+	}
+      break;
+
+    default:
+      break;
+    }
+}
+
+/*
+ * Read all snapshot stats and compute deltas against the previous poll.
+ * On success *deltas points at a vector owned by the snapshot, valid until
+ * the next call. Returns -1 if the directory changed since the snapshot
+ * was created; the caller must stat_segment_ls again and create a new
+ * snapshot.
+ */
+int
+stat_segment_snapshot_delta_r (stat_segment_snapshot_t * ss,
+			       bool changed_only,
+			       stat_segment_delta_t ** deltas,
+			       stat_client_main_t * sm)
+{
+  stat_segment_directory_entry_t *ep;
+  stat_segment_access_t sa;
+  counter_t *tmp;
+  int i;
+
+  *deltas = 0;
+
+  /* Has directory been update? */
+  if (sm->shared_header->epoch != ss->epoch)
+    return -1;
+
+  /* sum into the previous sums, only swap them in once the read is known
+     to be consistent: a failed read leaves the last sums untouched */
+  stat_segment_access_start (&sa, sm);
+  for (i = 0; i < vec_len (ss->stats); i++)
+    {
+      ep = vec_elt_at_index (sm->directory_vector, ss->stats[i]);
+      ss->prev_sums[i] = snapshot_sum_entry (ep, ss->prev_sums[i], sm);
+    }
+  if (!stat_segment_access_end (&sa, sm))
+    return -1;
+
+  for (i = 0; i < vec_len (ss->stats); i++)
+    {
+      tmp = ss->prev_sums[i];
+      ss->prev_sums[i] = ss->sums[i];
+      ss->sums[i] = tmp;
+    }
+
+  vec_reset_length (ss->deltas);
+  for (i = 0; i < vec_len (ss->stats); i++)
+    {
+      ep = vec_elt_at_index (sm->directory_vector, ss->stats[i]);
+      snapshot_add_deltas (ss, i, ep->type, changed_only);
+    }
+
+  *deltas = ss->deltas;
+  return 0;
+}
+
+int
+stat_segment_snapshot_delta (stat_segment_snapshot_t * ss,
+			     bool changed_only,
+			     stat_segment_delta_t ** deltas)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  return stat_segment_snapshot_delta_r (ss, changed_only, deltas, sm);
+}
+
+/*
+ * Create a snapshot of the stats returned by stat_segment_ls and take
+ * the baseline the first delta is computed against. Returns 0 if there
+ * are no stats to track.
+ */
+stat_segment_snapshot_t *
+stat_segment_snapshot_create_r (uint32_t * stats, stat_client_main_t * sm)
+{
+  stat_segment_snapshot_t *ss;
+  stat_segment_delta_t *deltas;
+
+  if (vec_len (stats) == 0)
+    return 0;
+
+  ss = (stat_segment_snapshot_t *) malloc (sizeof (*ss));
+  clib_memset (ss, 0, sizeof (*ss));
+  ss->stats = vec_dup (stats);
+  ss->epoch = sm->current_epoch;
+  vec_validate (ss->sums, vec_len (stats) - 1);
+  vec_validate (ss->prev_sums, vec_len (stats) - 1);
+
+  if (stat_segment_snapshot_delta_r (ss, false, &deltas, sm) < 0)
+    {
+      stat_segment_snapshot_free (ss);
+      return 0;
+    }
+  return ss;
+}
+
+stat_segment_snapshot_t *
+stat_segment_snapshot_create (uint32_t * stats)
+{
+  stat_client_main_t *sm = &stat_client_main;
+  return stat_segment_snapshot_create_r (stats, sm);
+}
+
+void
+stat_segment_snapshot_free (stat_segment_snapshot_t * ss)
+{
+  int i;
+
+  if (ss == 0)
+    return;
+  for (i = 0; i < vec_len (ss->sums); i++)
+    {
+      vec_free (ss->sums[i]);
+      vec_free (ss->prev_sums[i]);
+    }
+  vec_free (ss->sums);
+  vec_free (ss->prev_sums);
+  vec_free (ss->deltas);
+  vec_free (ss->stats);
+  free (ss);
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -83,6 +83,48 @@ char *stat_segment_index_to_name (uint32_t index);
 uint64_t stat_segment_version (void);
 uint64_t stat_segment_version_r (stat_client_main_t * sm);
 
+/*
+ * Delta snapshots.
+ *
+ * Counters are read in place from the mapped segment, summed across
+ * threads into accumulators owned by the snapshot and compared against
+ * the previous poll. Nothing is allocated once the accumulators have
+ * reached their final size.
+ */
+typedef struct
+{
+  uint32_t stat;		/* Position in the snapshot stats vector */
+  uint32_t index;		/* Counter index within the entry */
+  union
+  {
+    double scalar_value;
+    counter_t value;		/* Simple and error counters */
+    vlib_counter_t combined;
+  };
+} stat_segment_delta_t;
+
+typedef struct
+{
+  uint32_t *stats;		/* Directory indices */
+  uint64_t epoch;		/* Directory epoch the indices are valid for */
+  counter_t **sums;		/* Per stat, thread-summed counters */
+  counter_t **prev_sums;	/* Per stat, sums from the previous poll */
+  stat_segment_delta_t *deltas;	/* Result vector, reused every poll */
+} stat_segment_snapshot_t;
+
+stat_segment_snapshot_t *stat_segment_snapshot_create_r (uint32_t * stats,
+							 stat_client_main_t *
+							 sm);
+stat_segment_snapshot_t *stat_segment_snapshot_create (uint32_t * stats);
+int stat_segment_snapshot_delta_r (stat_segment_snapshot_t * ss,
+				   bool changed_only,
+				   stat_segment_delta_t ** deltas,
+				   stat_client_main_t * sm);
+int stat_segment_snapshot_delta (stat_segment_snapshot_t * ss,
+				 bool changed_only,
+				 stat_segment_delta_t ** deltas);
+void stat_segment_snapshot_free (stat_segment_snapshot_t * ss);
+
 typedef struct
 {
   uint64_t epoch;
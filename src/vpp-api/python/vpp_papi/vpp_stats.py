@@ -85,6 +85,27 @@ uint8_t **stat_segment_string_vector(uint8_t **string_vector, char *string);
 char *stat_segment_index_to_name_r (uint32_t index, stat_client_main_t * sm);
 uint64_t stat_segment_version(void);
 uint64_t stat_segment_version_r(stat_client_main_t *sm);
+typedef struct
+{
+  uint32_t stat;
+  uint32_t index;
+  union
+  {
+    double scalar_value;
+    counter_t value;
+    vlib_counter_t combined;
+  };
+} stat_segment_delta_t;
+
+typedef struct stat_segment_snapshot stat_segment_snapshot_t;
+
+stat_segment_snapshot_t *stat_segment_snapshot_create_r (uint32_t * stats,
+                                                         stat_client_main_t * sm);
+int stat_segment_snapshot_delta_r (stat_segment_snapshot_t * ss,
+                                   bool changed_only,
+                                   stat_segment_delta_t ** deltas,
+                                   stat_client_main_t * sm);
+void stat_segment_snapshot_free (stat_segment_snapshot_t * ss);
 void free(void *ptr);
 """)  # noqa: E501
 
@@ -189,6 +210,83 @@ class VPPStatsClientLoadError(RuntimeError):
     pass
 
 
+class VPPStatsSnapshot(object):
+    """Per-interval deltas of a set of counters, summed across threads.
+
+    Counters are read in place from the stats segment. delta() returns
+    {name: {index: delta}}, combined counters as {'packets', 'bytes'}
+    dicts and scalars as their current value.
+    """
+
+    def __init__(self, stats, patterns):
+        self.stats = stats
+        self.patterns = patterns
+        self.snapshot = ffi.NULL
+        self.names = []
+        self.types = []
+
+    def _rebuild(self):
+        api = self.stats.api
+        if self.snapshot != ffi.NULL:
+            api.stat_segment_snapshot_free(self.snapshot)
+            self.snapshot = ffi.NULL
+        dir = self.stats.ls(self.patterns)
+        if dir == ffi.NULL:
+            raise VPPStatsIOError()
+        client = self.stats.client
+        self.names = []
+        self.types = []
+        for i in range(api.stat_segment_vec_len(dir)):
+            self.names.append(ffi.string(
+                api.stat_segment_index_to_name_r(dir[i], client))
+                .decode('utf-8'))
+            self.types.append(client.directory_vector[dir[i]].type)
+        self.snapshot = api.stat_segment_snapshot_create_r(dir, client)
+        if self.snapshot == ffi.NULL:
+            raise VPPStatsIOError()
+
+    def delta(self, changed_only=True):
+        api = self.stats.api
+        deltas = ffi.new("stat_segment_delta_t **")
+        retries = 0
+        while True:
+            try:
+                if self.snapshot == ffi.NULL:
+                    self._rebuild()
+                    # First poll after a directory change is the baseline
+                    return {}
+                rv = api.stat_segment_snapshot_delta_r(
+                    self.snapshot, changed_only, deltas, self.stats.client)
+                if rv < 0:
+                    self._rebuild()
+                    return {}
+                break
+            except VPPStatsIOError:
+                if retries > 10:
+                    raise
+                retries += 1
+
+        result = {}
+        d = deltas[0]
+        for i in range(api.stat_segment_vec_len(d)):
+            e = d[i]
+            name = self.names[e.stat]
+            type = self.types[e.stat]
+            if type == 1:
+                value = e.scalar_value
+            elif type == 3:
+                value = vlib_counter_dict(e.combined)
+            else:
+                value = e.value
+            result.setdefault(name, {})[e.index] = value
+        return result
+
+    def close(self):
+        if self.snapshot != ffi.NULL:
+            self.stats.api.stat_segment_snapshot_free(self.snapshot)
+            self.snapshot = ffi.NULL
+
+
 class VPPStats(object):
     VPPStatsIOError = VPPStatsIOError
 
@@ -279,6 +377,15 @@ class VPPStats(object):
                     return None
                 retries += 1
 
+    def snapshot(self, patterns):
+        """Return a VPPStatsSnapshot for counters matching patterns.
+           The baseline is taken now, call delta() on it to poll."""
+        if not self.connected:
+            self.connect()
+        s = VPPStatsSnapshot(self, patterns)
+        s.delta()
+        return s
+
     def get_err_counter(self, name):
         """Get an error counter. The errors from each worker thread
            are summed"""
@@ -89,6 +89,8 @@ _(LOG_DUMP, log_dump)                                                   \
 _(SHOW_VPE_SYSTEM_TIME, show_vpe_system_time)				\
 _(GET_F64_ENDIAN_VALUE, get_f64_endian_value)							\
 _(GET_F64_INCREMENT_BY_ONE, get_f64_increment_by_one)					\
+_(NODE_HISTOGRAM_ENABLE_DISABLE, node_histogram_enable_disable)         \
+_(NODE_HISTOGRAM_DUMP, node_histogram_dump)                             \
 
 #define QUOTE_(x) #x
 #define QUOTE(x) QUOTE_(x)
@@ -527,6 +529,92 @@ vl_api_log_dump_t_handler (vl_api_log_dump_t * mp)
 
 }
 
+static void
+vl_api_node_histogram_enable_disable_t_handler
+  (vl_api_node_histogram_enable_disable_t * mp)
+{
+  vl_api_node_histogram_enable_disable_reply_t *rmp;
+  vlib_main_t *vm = vlib_get_main ();
+  int rv = 0;
+
+  vlib_node_histogram_enable_disable (vm, mp->enable);
+
+  REPLY_MACRO (VL_API_NODE_HISTOGRAM_ENABLE_DISABLE_REPLY);
+}
+
+static void
+send_node_histogram_details (vl_api_registration_t * reg, u32 context,
+			     u32 thread_index, vlib_node_t * n,
+			     vlib_node_histogram_t * h)
+{
+  vl_api_node_histogram_details_t *rmp;
+  int i;
+
+  STATIC_ASSERT (ARRAY_LEN (rmp->clocks) == VLIB_NODE_HIST_N_CLOCK_BUCKETS,
+		 "node_histogram_details clocks size mismatch");
+  STATIC_ASSERT (ARRAY_LEN (rmp->vectors) == VLIB_NODE_HIST_N_VECTOR_BUCKETS,
+		 "node_histogram_details vectors size mismatch");
+
+  rmp = vl_msg_api_alloc (sizeof (*rmp));
+  clib_memset (rmp, 0, sizeof (*rmp));
+  rmp->_vl_msg_id = ntohs (VL_API_NODE_HISTOGRAM_DETAILS);
+  rmp->context = context;
+  rmp->thread_index = htonl (thread_index);
+  rmp->node_index = htonl (n->index);
+  clib_memcpy (rmp->node_name, n->name,
+	       clib_min (vec_len (n->name), ARRAY_LEN (rmp->node_name) - 1));
+
+  for (i = 0; i < VLIB_NODE_HIST_N_CLOCK_BUCKETS; i++)
+    rmp->clocks[i] = clib_host_to_net_u64 (h->clocks[i]);
+  for (i = 0; i < VLIB_NODE_HIST_N_VECTOR_BUCKETS; i++)
+    rmp->vectors[i] = clib_host_to_net_u64 (h->vectors[i]);
+
+  vl_api_send_msg (reg, (u8 *) rmp);
+}
+
+static void
+vl_api_node_histogram_dump_t_handler (vl_api_node_histogram_dump_t * mp)
+{
+  vlib_node_histogram_t *h, *histograms;
+  vl_api_registration_t *reg;
+  u32 thread_index, node_index;
+  vlib_main_t *stat_vm;
+  u64 calls;
+  int i, j, b;
+
+  reg = vl_api_client_index_to_registration (mp->client_index);
+  if (reg == 0)
+    return;
+
+  thread_index = ntohl (mp->thread_index);
+  node_index = ntohl (mp->node_index);
+
+  /* API handlers run under the barrier, workers are stopped */
+  for (i = 0; i < vec_len (vlib_mains); i++)
+    {
+      stat_vm = vlib_mains[i];
+      if (stat_vm == 0 || (thread_index != ~0 && thread_index != i))
+	continue;
+
+      histograms = stat_vm->node_main.histograms;
+      vec_foreach (h, histograms)
+      {
+	j = h - histograms;
+	if (node_index != ~0 && node_index != j)
+	  continue;
+
+	calls = 0;
+	for (b = 0; b < VLIB_NODE_HIST_N_VECTOR_BUCKETS; b++)
+	  calls += h->vectors[b];
+	if (calls == 0 && node_index == ~0)
+	  continue;
+
+	send_node_histogram_details (reg, mp->context, i,
+				     vlib_get_node (stat_vm, j), h);
+      }
+    }
+}
+
 static void
 vl_api_show_vpe_system_time_t_handler (vl_api_show_vpe_system_time_t * mp)
 {
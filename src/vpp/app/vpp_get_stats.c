@@ -104,6 +104,91 @@ stat_poll_loop (u8 ** patterns)
     }
 }
 
+/* Print only the counters that changed since the previous second */
+static int
+stat_delta_loop (u8 ** patterns)
+{
+  struct timespec ts, tsrem;
+  stat_segment_snapshot_t *ss = 0;
+  stat_segment_delta_t *deltas, *d;
+  char **names = 0;
+  u32 *stats = 0;
+  f64 heartbeat, prev_heartbeat = 0;
+  int i, lost_connection = 0;
+
+  while (1)
+    {
+      heartbeat = stat_segment_heartbeat ();
+      if (heartbeat > prev_heartbeat)
+	{
+	  prev_heartbeat = heartbeat;
+	  lost_connection = 0;
+	}
+      else
+	lost_connection++;
+      if (lost_connection > 10)
+	{
+	  fformat (stderr, "Lost connection to VPP...\n");
+	  break;
+	}
+
+      if (ss == 0 || stat_segment_snapshot_delta (ss, true, &deltas) < 0)
+	{
+	  /* Directory changed, start over from a new baseline */
+	  stat_segment_snapshot_free (ss);
+	  for (i = 0; i < vec_len (names); i++)
+	    free (names[i]);
+	  vec_reset_length (names);
+	  vec_free (stats);
+	  ss = 0;
+	  /* Nothing matches yet, try again after the sleep */
+	  stats = stat_segment_ls (patterns);
+	  if (stats == 0)
+	    goto retry;
+	  for (i = 0; i < vec_len (stats); i++)
+	    vec_add1 (names, stat_segment_index_to_name (stats[i]));
+	  ss = stat_segment_snapshot_create (stats);
+	}
+      else
+	{
+	  vec_foreach (d, deltas)
+	  {
+	    vlib_counter_t *c = &d->combined;
+	    stat_segment_directory_entry_t *ep =
+	      vec_elt_at_index (stat_client_main.directory_vector,
+				stats[d->stat]);
+	    switch (ep->type)
+	      {
+	      case STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED:
+		fformat (stdout, "[%d]: +%llu packets, +%llu bytes %s\n",
+			 d->index, c->packets, c->bytes, names[d->stat]);
+		break;
+	      case STAT_DIR_TYPE_SCALAR_INDEX:
+		fformat (stdout, "%.2f %s\n", d->scalar_value,
+			 names[d->stat]);
+		break;
+	      default:
+		fformat (stdout, "[%d]: +%llu %s\n", d->index, d->value,
+			 names[d->stat]);
+	      }
+	  }
+	}
+
+    retry:
+      ts.tv_sec = 1;
+      ts.tv_nsec = 0;
+      while (nanosleep (&ts, &tsrem) < 0)
+	ts = tsrem;
+    }
+
+  stat_segment_snapshot_free (ss);
+  for (i = 0; i < vec_len (names); i++)
+    free (names[i]);
+  vec_free (names);
+  vec_free (stats);
+  return -1;
+}
+
 enum stat_client_cmd_e
 {
   STAT_CLIENT_CMD_UNKNOWN,
@@ -111,6 +196,7 @@ enum stat_client_cmd_e
   STAT_CLIENT_CMD_POLL,
   STAT_CLIENT_CMD_DUMP,
   STAT_CLIENT_CMD_TIGHTPOLL,
+  STAT_CLIENT_CMD_DELTA,
 };
 
 int
@@ -148,6 +234,10 @@ main (int argc, char **argv)
 	{
 	  cmd = STAT_CLIENT_CMD_TIGHTPOLL;
 	}
+      else if (unformat (a, "delta"))
+	{
+	  cmd = STAT_CLIENT_CMD_DELTA;
+	}
       else if (unformat (a, "%s", &pattern))
 	{
 	  vec_add1 (patterns, pattern);
@@ -155,7 +245,7 @@ main (int argc, char **argv)
       else
 	{
 	  fformat (stderr,
-		   "%s: usage [socket-name <name>] [ls|dump|poll] <patterns> ...\n",
+		   "%s: usage [socket-name <name>] [ls|dump|poll|delta] <patterns> ...\n",
 		   argv[0]);
 	  exit (1);
 	}
@@ -247,6 +337,13 @@ reconnect:
       goto reconnect;
       break;
 
+    case STAT_CLIENT_CMD_DELTA:
+      stat_delta_loop (patterns);
+      /* We can only exit the delta loop if we lost connection to VPP */
+      stat_segment_disconnect ();
+      goto reconnect;
+      break;
+
     case STAT_CLIENT_CMD_TIGHTPOLL:
       while (1)
 	{
@@ -264,7 +361,7 @@ reconnect:
 
     default:
       fformat (stderr,
-	       "%s: usage [socket-name <name>] [ls|dump|poll] <patterns> ...\n",
+	       "%s: usage [socket-name <name>] [ls|dump|poll|delta] <patterns> ...\n",
 	       argv[0]);
     }
 
@@ -445,6 +445,7 @@ update_node_counters (stat_segment_main_t * sm)
 {
   vlib_main_t **stat_vms = 0;
   vlib_node_t ***node_dups = 0;
+  vlib_node_histogram_t *histograms;
   int i, j;
   stat_segment_shared_header_t *shared_header = sm->shared_header;
   static u32 no_max_nodes = 0;
@@ -473,6 +474,13 @@ update_node_counters (stat_segment_main_t * sm)
 				    [STAT_COUNTER_NODE_CALLS], l - 1);
       stat_validate_counter_vector (&sm->directory_vector
 				    [STAT_COUNTER_NODE_SUSPENDS], l - 1);
+      /* Histograms are flattened, node i bucket b at [i * n_buckets + b] */
+      stat_validate_counter_vector (&sm->directory_vector
+				    [STAT_COUNTER_NODE_CLOCKS_HISTOGRAM],
+				    l * VLIB_NODE_HIST_N_CLOCK_BUCKETS - 1);
+      stat_validate_counter_vector (&sm->directory_vector
+				    [STAT_COUNTER_NODE_VECTORS_HISTOGRAM],
+				    l * VLIB_NODE_HIST_N_VECTOR_BUCKETS - 1);
 
       vec_validate (sm->nodes, l - 1);
       stat_segment_directory_entry_t *ep;
@@ -546,6 +554,34 @@ update_node_counters (stat_segment_main_t * sm)
 	  c[n->index] =
 	    n->stats_total.suspends - n->stats_last_clear.suspends;
 	}
+
+      /* Histograms keep their last values while disabled */
+      histograms = stat_vms[j]->node_main.histograms;
+      if (histograms)
+	{
+	  counter_t **counters;
+	  u32 n_nodes = clib_min (vec_len (histograms), no_max_nodes);
+
+	  counters =
+	    stat_segment_pointer (shared_header,
+				  sm->directory_vector
+				  [STAT_COUNTER_NODE_CLOCKS_HISTOGRAM].offset);
+	  for (i = 0; i < n_nodes; i++)
+	    clib_memcpy_fast (counters[j] +
+			      i * VLIB_NODE_HIST_N_CLOCK_BUCKETS,
+			      histograms[i].clocks,
+			      sizeof (histograms[i].clocks));
+
+	  counters =
+	    stat_segment_pointer (shared_header,
+				  sm->directory_vector
+				  [STAT_COUNTER_NODE_VECTORS_HISTOGRAM].offset);
+	  for (i = 0; i < n_nodes; i++)
+	    clib_memcpy_fast (counters[j] +
+			      i * VLIB_NODE_HIST_N_VECTOR_BUCKETS,
+			      histograms[i].vectors,
+			      sizeof (histograms[i].vectors));
+	}
       vec_free (node_dups[j]);
     }
   vec_free (node_dups);
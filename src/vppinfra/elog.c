@@ -511,6 +511,192 @@ elog_init (elog_main_t * em, u32 n_events)
   em->string_table_hash = hash_create_string (0, sizeof (uword));
 }
 
+void
+elog_enable_thread_rings (elog_main_t * em, u32 n_threads, u32 n_events)
+{
+  elog_thread_ring_t *r;
+
+  elog_disable_thread_rings (em);
+
+  em->thread_ring_size = n_events = max_pow2 (n_events);
+  vec_validate_aligned (em->thread_rings, n_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (r, em->thread_rings)
+    vec_resize_aligned (r->event_ring, n_events, CLIB_CACHE_LINE_BYTES);
+}
+
+void
+elog_disable_thread_rings (elog_main_t * em)
+{
+  elog_thread_ring_t *r;
+
+  if (em->thread_rings == 0)
+    return;
+
+  /* Keep whatever was logged */
+  elog_merge_thread_rings (em, 1 /* flush */ );
+
+  vec_foreach (r, em->thread_rings) vec_free (r->event_ring);
+  vec_free (em->thread_rings);
+  vec_free (em->merge_events);
+  vec_free (em->merge_n_events);
+  em->thread_ring_size = 0;
+}
+
+u64
+elog_thread_rings_lost_events (elog_main_t * em)
+{
+  elog_thread_ring_t *r;
+  u64 n = 0;
+
+  vec_foreach (r, em->thread_rings) n += r->n_lost_events;
+  return n;
+}
+
+/* Collect mergeable events from one ring onto the scratch vector. */
+static u32
+elog_thread_ring_collect (elog_main_t * em, elog_thread_ring_t * r,
+			  u64 time_limit, u64 last)
+{
+  uword mask = em->thread_ring_size - 1;
+  u64 i, n, first, n_lost;
+  elog_event_t *e;
+  u32 n_collected = 0, n_before = vec_len (em->merge_events);
+
+  /* The writer may be filling in the slot after the last published
+     event, which overwrites the oldest one, so only size - 1 events
+     are safe to read */
+  u64 window = em->thread_ring_size - 1;
+
+  n = clib_atomic_load_acq_n (&r->n_total_events);
+  first = r->n_merged_events;
+  last = clib_min (last, n);
+
+  /* Writer lapped us */
+  if (n - first > window)
+    {
+      r->n_lost_events += n - window - first;
+      first = n - window;
+    }
+
+  /* Each ring is in time order, stop at the first event too new to merge */
+  for (i = first; i < last; i++)
+    {
+      e = r->event_ring + (i & mask);
+      if (e->time_cycles >= time_limit)
+	break;
+      vec_add1 (em->merge_events, e[0]);
+      n_collected++;
+    }
+
+  /* Drop whatever the writer may have overwritten while we copied */
+  n = clib_atomic_load_acq_n (&r->n_total_events);
+  if (n - first > window)
+    {
+      n_lost = clib_min (n - window - first, n_collected);
+      vec_delete (em->merge_events, n_lost, n_before);
+      r->n_lost_events += n_lost;
+      n_collected -= n_lost;
+    }
+
+  r->n_merged_events = i;
+  return n_collected;
+}
+
+uword
+elog_merge_thread_rings (elog_main_t * em, int flush)
+{
+  elog_thread_ring_t *r;
+  elog_event_t *e, **heads = 0, **ends = 0, *best;
+  u64 now, time_limit, commit_limit, n, *last = 0;
+  uword n_merged = 0, ei, j, k, n_rings;
+  f64 cps = em->cpu_timer.clocks_per_second;
+
+  if (em->thread_rings == 0)
+    return 0;
+
+  /* Events not yet older than the guard may still be in flight
+     on other threads, leave them for the next merge */
+  now = clib_cpu_time_now ();
+  time_limit = flush ? ~0ULL : now - (u64) (cps * 1e-3);
+  commit_limit = now - (u64) (cps * 10e-3);
+
+  vec_validate (last, vec_len (em->thread_rings) - 1);
+  vec_foreach (r, em->thread_rings)
+  {
+    u64 *l = last + (r - em->thread_rings);
+
+    /* Reading the count first, at most the newest event is uncommitted */
+    n = clib_atomic_load_acq_n (&r->n_total_events);
+    l[0] = flush ? ~0ULL : n;
+    if (flush || n <= r->n_merged_events
+	|| clib_atomic_load_acq_n (&r->n_committed_events) >= n)
+      continue;
+
+    /* Its data may be incomplete until the thread logs again. Hold it
+       back, and newer events of other threads with it, until it is old
+       enough that the thread can no longer be writing it. An idle
+       thread does not stall the merge for longer than that. */
+    e = r->event_ring + ((n - 1) & (em->thread_ring_size - 1));
+    if (e->time_cycles >= commit_limit)
+      {
+	l[0] = n - 1;
+	time_limit = clib_min (time_limit, e->time_cycles);
+      }
+  }
+
+  vec_reset_length (em->merge_events);
+  vec_reset_length (em->merge_n_events);
+  vec_foreach (r, em->thread_rings)
+    vec_add1 (em->merge_n_events,
+	      elog_thread_ring_collect (em, r, time_limit,
+				       last[r - em->thread_rings]));
+  vec_free (last);
+
+  if (vec_len (em->merge_events) == 0)
+    return 0;
+
+  /* K-way merge of the per-ring runs, each already in time order */
+  n_rings = vec_len (em->merge_n_events);
+  vec_validate (heads, n_rings - 1);
+  vec_validate (ends, n_rings - 1);
+  e = em->merge_events;
+  for (j = 0; j < n_rings; j++)
+    {
+      heads[j] = e;
+      e += em->merge_n_events[j];
+      ends[j] = e;
+    }
+
+  while (1)
+    {
+      best = 0;
+      for (j = 0, k = 0; j < n_rings; j++)
+	if (heads[j] < ends[j]
+	    && (best == 0 || heads[j]->time_cycles < best->time_cycles))
+	  {
+	    best = heads[j];
+	    k = j;
+	  }
+      if (best == 0 || !elog_is_enabled (em))
+	break;
+
+      /* Threads without a ring may still log here directly */
+      if (em->lock)
+	ei = clib_atomic_fetch_add (&em->n_total_events, 1);
+      else
+	ei = em->n_total_events++;
+      ei &= em->event_ring_size - 1;
+      em->event_ring[ei] = best[0];
+      heads[k]++;
+      n_merged++;
+    }
+
+  vec_free (heads);
+  vec_free (ends);
+  return n_merged;
+}
+
 /* Returns number of events in ring and start index. */
 static uword
 elog_event_range (elog_main_t * em, uword * lo)
@@ -1086,6 +1272,25 @@ unserialize_elog_time_stamp (serialize_main_t * m, va_list * va)
   unserialize (m, unserialize_64, &st->cpu);
 }
 
+#ifdef CLIB_UNIX
+clib_error_t *
+elog_write_file_and_reset (elog_main_t * em, char *clib_file)
+{
+  clib_error_t *error;
+  int is_enabled;
+
+  elog_lock (em);
+  error = elog_write_file (em, clib_file, 1 /* flush ring */ );
+  is_enabled = elog_is_enabled (em);
+  em->n_total_events = 0;
+  if (!is_enabled)
+    em->n_total_events_disable_limit = 0;
+  elog_unlock (em);
+
+  return error;
+}
+#endif
+
 static char *elog_serialize_magic = "elog v0";
 
 void
@@ -55,6 +55,8 @@
 #include <vppinfra/time.h>	/* for clib_cpu_time_now */
 #include <vppinfra/hash.h>
 #include <vppinfra/mhash.h>
+#include <vppinfra/os.h>
+#include <vppinfra/atomics.h>
 
 typedef struct
 {
@@ -129,6 +131,30 @@ typedef struct
   u64 os_nsec;
 } elog_time_stamp_t;
 
+/** Per-thread event ring. Written only by the owning thread,
+    drained into the main ring by elog_merge_thread_rings. */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /** Events logged by the owning thread, free running. */
+  u64 n_total_events;
+
+  /** Events whose data has been filled in, at most one behind. */
+  u64 n_committed_events;
+
+  /** Power of 2 ring of events. */
+  elog_event_t *event_ring;
+
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+
+  /** Events consumed by the merge. */
+  u64 n_merged_events;
+
+  /** Events overwritten before they were merged. */
+  u64 n_lost_events;
+} elog_thread_ring_t;
+
 typedef struct
 {
   /** Total number of events in buffer. */
@@ -180,6 +206,17 @@ typedef struct
 
   /** Vector of events converted to generic form after collection. */
   elog_event_t *events;
+
+  /** Per-thread rings indexed by os_get_thread_index (),
+      zero unless enabled with elog_enable_thread_rings. */
+  elog_thread_ring_t *thread_rings;
+
+  /** Power of 2 number of elements in each thread ring. */
+  uword thread_ring_size;
+
+  /** Merge scratch vectors. */
+  elog_event_t *merge_events;
+  u32 *merge_n_events;
 } elog_main_t;
 
 /** @brief Return number of events in the event-log buffer
@@ -313,6 +350,27 @@ elog_event_data_inline (elog_main_t * em,
     }
 
   ASSERT (track_index < vec_len (em->tracks));
+
+  if (em->thread_rings)
+    {
+      uword thread_index = os_get_thread_index ();
+      if (PREDICT_TRUE (thread_index < vec_len (em->thread_rings)))
+	{
+	  elog_thread_ring_t *r = em->thread_rings + thread_index;
+
+	  /* Single writer, no atomic increment on a shared line */
+	  ei = r->n_total_events;
+	  /* The caller is done with the previous event's data */
+	  clib_atomic_store_rel_n (&r->n_committed_events, ei);
+	  e = r->event_ring + (ei & (em->thread_ring_size - 1));
+	  e->time_cycles = cpu_time;
+	  e->type = type_index;
+	  e->track = track_index;
+	  clib_atomic_store_rel_n (&r->n_total_events, ei + 1);
+	  return e->data;
+	}
+    }
+
   ASSERT (is_pow2 (vec_len (em->event_ring)));
 
   if (em->lock)
@@ -358,6 +416,27 @@ elog_event_data_not_inline (elog_main_t * em,
   return elog_event_data (em, type, track, cpu_time);
 }
 
+/** @brief Publish the data of the event last logged by this thread
+
+    Only needed with per-thread rings. Events allocated with ELOG_DATA
+    and friends are committed when the thread logs its next event, or
+    merged regardless once they are old enough.
+
+    @param em elog_main_t *
+*/
+always_inline void
+elog_event_commit (elog_main_t * em)
+{
+  uword thread_index = os_get_thread_index ();
+  elog_thread_ring_t *r;
+
+  if (em->thread_rings && thread_index < vec_len (em->thread_rings))
+    {
+      r = em->thread_rings + thread_index;
+      clib_atomic_store_rel_n (&r->n_committed_events, r->n_total_events);
+    }
+}
+
 /** @brief Log a single-datum event
     @param em elog_main_t *
     @param type elog_event_type_t * type
@@ -371,6 +450,7 @@ elog (elog_main_t * em, elog_event_type_t * type, u32 data)
 				       &em->default_track,
 				       clib_cpu_time_now ());
   d[0] = data;
+  elog_event_commit (em);
 }
 
 /** @brief Log a single-datum event, inline version
@@ -386,6 +466,7 @@ elog_inline (elog_main_t * em, elog_event_type_t * type, u32 data)
 				   &em->default_track,
 				   clib_cpu_time_now ());
   d[0] = data;
+  elog_event_commit (em);
 }
 
 /** @brief Log a single-datum event to a specific track, non-inline version
@@ -403,6 +484,7 @@ elog_track (elog_main_t * em, elog_event_type_t * type, elog_track_t * track,
 				       track,
 				       clib_cpu_time_now ());
   d[0] = data;
+  elog_event_commit (em);
 }
 
 /** @brief Log a single-datum event to a specific track
@@ -420,6 +502,7 @@ elog_track_inline (elog_main_t * em, elog_event_type_t * type,
 				   track,
 				   clib_cpu_time_now ());
   d[0] = data;
+  elog_event_commit (em);
 }
 
 always_inline void *
@@ -527,6 +610,35 @@ void unserialize_elog_main (serialize_main_t * m, va_list * va);
 void elog_init (elog_main_t * em, u32 n_events);
 void elog_alloc (elog_main_t * em, u32 n_events);
 
+/** @brief log into per-thread rings instead of the shared ring
+    @param em elog_main_t *
+    @param n_threads number of threads which may log events
+    @param n_events number of events in each thread ring
+    @warning no thread may be logging while rings are enabled or disabled
+*/
+void elog_enable_thread_rings (elog_main_t * em, u32 n_threads,
+			       u32 n_events);
+void elog_disable_thread_rings (elog_main_t * em);
+
+/** @brief move events from the per-thread rings to the main ring
+    in timestamp order
+
+    Events newer than a short guard interval are left in place, so that
+    events from slower threads are not merged out of order. An event
+    whose data may still be being filled in is held back until its
+    thread logs another one or it times out, and only such events delay
+    the merge of other threads' events. Must be called from a single
+    thread.
+
+    @param em elog_main_t *
+    @param flush merge everything, only safe when no thread is logging
+    @return number of events merged
+*/
+uword elog_merge_thread_rings (elog_main_t * em, int flush);
+
+/** @brief total events lost to per-thread ring overruns */
+u64 elog_thread_rings_lost_events (elog_main_t * em);
+
 #ifdef CLIB_UNIX
 always_inline clib_error_t *
 elog_write_file (elog_main_t * em, char *clib_file, int flush_ring)
@@ -558,6 +670,17 @@ elog_read_file (elog_main_t * em, char *clib_file)
   return error;
 }
 
+/** @brief write the main ring to a file and empty it
+
+    Used for streaming export: each chunk is a complete log which can be
+    read by g2 or converted by c2cpel. Threads logging to the main ring
+    would race with the reset, so the caller must stop them, e.g. with
+    the worker barrier. With per-thread rings enabled only the thread
+    calling elog_merge_thread_rings writes the main ring, and no one
+    needs to be stopped if that is also the caller.
+*/
+clib_error_t *elog_write_file_and_reset (elog_main_t * em, char *clib_file);
+
 #endif /* CLIB_UNIX */
 
 #endif /* included_clib_elog_h */
@@ -37,7 +37,9 @@
  *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdio.h>
 #include <sys/fcntl.h>
+#include <vppinfra/format.h>
 #include <vppinfra/pcap.h>
 
 /**
@@ -166,6 +168,271 @@ done:
   return error;
 }
 
+/* pcapng blocks, all fields in host byte order */
+typedef CLIB_PACKED (struct
+{
+  u32 block_type;
+  u32 block_total_length;
+  u32 byte_order_magic;
+  u16 major_version;
+  u16 minor_version;
+  u64 section_length;
+  u32 block_total_length_trailer;
+}) pcapng_section_header_block_t;
+
+typedef CLIB_PACKED (struct
+{
+  u32 block_type;
+  u32 block_total_length;
+  u16 link_type;
+  u16 reserved;
+  u32 snaplen;
+  u32 block_total_length_trailer;
+}) pcapng_interface_description_block_t;
+
+typedef CLIB_PACKED (struct
+{
+  u32 block_type;
+  u32 block_total_length;
+  u32 interface_id;
+  u32 timestamp_high;
+  u32 timestamp_low;
+  u32 captured_length;
+  u32 packet_length;
+  u8 data[0];
+}) pcapng_enhanced_packet_block_t;
+
+static clib_error_t *
+pcap_stream_flush (pcap_main_t * pm)
+{
+  u8 *d = pm->pcap_data;
+  int n_left = vec_len (pm->pcap_data);
+
+  while (n_left > 0)
+    {
+      int n = write (pm->file_descriptor, d, n_left);
+
+      if (n < 0)
+	{
+	  if (unix_error_is_fatal (errno))
+	    return clib_error_return_unix (0, "write `%s'", pm->file_name);
+	  continue;
+	}
+      d += n;
+      n_left -= n;
+    }
+
+  pm->n_bytes_in_file += vec_len (pm->pcap_data);
+  vec_reset_length (pm->pcap_data);
+  return 0;
+}
+
+static clib_error_t *
+pcap_stream_open_file (pcap_main_t * pm)
+{
+  pcapng_section_header_block_t *shb;
+  pcapng_interface_description_block_t *idb;
+  u8 *d;
+
+  pm->file_descriptor =
+    open (pm->file_name, O_CREAT | O_TRUNC | O_WRONLY, 0664);
+  if (pm->file_descriptor < 0)
+    return clib_error_return_unix (0, "failed to open `%s'", pm->file_name);
+
+  pm->flags |= PCAP_MAIN_INIT_DONE;
+  pm->n_bytes_in_file = 0;
+
+  ASSERT (vec_len (pm->pcap_data) == 0);
+  vec_add2 (pm->pcap_data, d, sizeof (*shb) + sizeof (*idb));
+  shb = (void *) d;
+  shb->block_type = PCAPNG_BLOCK_TYPE_SHB;
+  shb->block_total_length = sizeof (*shb);
+  shb->byte_order_magic = PCAPNG_BYTE_ORDER_MAGIC;
+  shb->major_version = 1;
+  shb->minor_version = 0;
+  shb->section_length = ~0ULL;
+  shb->block_total_length_trailer = sizeof (*shb);
+
+  /* single interface, default microsecond timestamp resolution */
+  idb = (void *) (d + sizeof (*shb));
+  idb->block_type = PCAPNG_BLOCK_TYPE_IDB;
+  idb->block_total_length = sizeof (*idb);
+  idb->link_type = pm->packet_type;
+  idb->reserved = 0;
+  idb->snaplen = pm->snaplen;
+  idb->block_total_length_trailer = sizeof (*idb);
+
+  return pcap_stream_flush (pm);
+}
+
+static clib_error_t *
+pcap_stream_rotate (pcap_main_t * pm)
+{
+  clib_error_t *error;
+  u8 *from = 0, *to = 0;
+  u32 i;
+
+  if ((error = pcap_stream_flush (pm)))
+    return error;
+
+  pcap_close (pm);
+
+  /* file -> file.1 -> file.2 ... oldest one is overwritten */
+  for (i = pm->rotate_n_files; i > 0; i--)
+    {
+      vec_reset_length (from);
+      vec_reset_length (to);
+      if (i > 1)
+	from = format (from, "%s.%u%c", pm->file_name, i - 1, 0);
+      else
+	from = format (from, "%s%c", pm->file_name, 0);
+      to = format (to, "%s.%u%c", pm->file_name, i, 0);
+      /* older files may not exist yet */
+      (void) rename ((char *) from, (char *) to);
+    }
+
+  vec_free (from);
+  vec_free (to);
+
+  return pcap_stream_open_file (pm);
+}
+
+static void
+pcap_stream_free_rings (pcap_main_t * pm)
+{
+  pcap_ring_t *r;
+
+  vec_foreach (r, pm->rings) clib_mem_free (r->slots);
+  vec_free (pm->rings);
+  vec_free (pm->pcap_data);
+}
+
+/**
+ * @brief Start streaming capture
+ *
+ * Allocates one capture ring per thread and writes pcapng headers.
+ * Caller sets ring_size, snaplen, rotation parameters and time_offset.
+ *
+ * @return rc - clib_error_t
+ *
+ */
+clib_error_t *
+pcap_stream_open (pcap_main_t * pm, u32 n_threads)
+{
+  clib_error_t *error;
+  pcap_ring_t *r;
+
+  ASSERT (is_pow2 (pm->ring_size));
+
+  pm->slot_size = round_pow2 (sizeof (pcap_ring_slot_t) + pm->snaplen,
+			      CLIB_CACHE_LINE_BYTES);
+  vec_validate_aligned (pm->rings, n_threads - 1, CLIB_CACHE_LINE_BYTES);
+
+  vec_foreach (r, pm->rings)
+    r->slots = clib_mem_alloc_aligned ((uword) pm->ring_size *
+				       pm->slot_size, CLIB_CACHE_LINE_BYTES);
+
+  if ((error = pcap_stream_open_file (pm)))
+    {
+      pcap_stream_free_rings (pm);
+      return error;
+    }
+
+  pm->flags |= PCAP_MAIN_STREAM;
+  return 0;
+}
+
+/**
+ * @brief Move captured packets from the rings to the file
+ *
+ * Called periodically by the consumer, rotates the file when it grows
+ * over rotate_file_size.
+ *
+ * @return rc - clib_error_t
+ *
+ */
+clib_error_t *
+pcap_stream_drain (pcap_main_t * pm)
+{
+  clib_error_t *error = 0;
+  pcap_ring_t *r;
+
+  vec_foreach (r, pm->rings)
+  {
+    u32 tail = r->tail;
+    u32 head = clib_atomic_load_acq_n (&r->head);
+
+    for (; error == 0 && tail != head; tail++)
+      {
+	pcap_ring_slot_t *s;
+	pcapng_enhanced_packet_block_t *epb;
+	u32 n_pad, len;
+	u64 t;
+	u8 *d;
+
+	s = (pcap_ring_slot_t *) (r->slots + (uword) (tail &
+						      (pm->ring_size - 1)) *
+				  pm->slot_size);
+
+	/* without files to rotate into, keep appending */
+	if (pm->rotate_file_size && pm->rotate_n_files &&
+	    pm->n_bytes_in_file + vec_len (pm->pcap_data) >=
+	    pm->rotate_file_size)
+	  if ((error = pcap_stream_rotate (pm)))
+	    break;
+
+	n_pad = round_pow2 (s->n_bytes_captured, 4) - s->n_bytes_captured;
+	len = sizeof (*epb) + s->n_bytes_captured + n_pad + sizeof (u32);
+	vec_add2 (pm->pcap_data, d, len);
+	epb = (void *) d;
+	t = (s->time + pm->time_offset) * 1e6;
+	epb->block_type = PCAPNG_BLOCK_TYPE_EPB;
+	epb->block_total_length = len;
+	epb->interface_id = 0;
+	epb->timestamp_high = t >> 32;
+	epb->timestamp_low = t;
+	epb->captured_length = s->n_bytes_captured;
+	epb->packet_length = s->n_bytes_in_packet;
+	clib_memcpy_fast (epb->data, s->data, s->n_bytes_captured);
+	clib_memset (epb->data + s->n_bytes_captured, 0, n_pad);
+	*(u32 *) (epb->data + s->n_bytes_captured + n_pad) = len;
+      }
+
+    /* hand the slots back to the producer */
+    clib_atomic_store_rel_n (&r->tail, tail);
+
+    if (error)
+      return error;
+  }
+
+  return pcap_stream_flush (pm);
+}
+
+/**
+ * @brief Stop streaming capture
+ *
+ * Drains the rings, closes the file and frees the rings. Producers must
+ * be stopped by the caller.
+ *
+ * @return rc - clib_error_t
+ *
+ */
+clib_error_t *
+pcap_stream_close (pcap_main_t * pm)
+{
+  clib_error_t *error;
+
+  error = pcap_stream_drain (pm);
+  pm->flags &= ~PCAP_MAIN_STREAM;
+
+  if (pm->flags & PCAP_MAIN_INIT_DONE)
+    pcap_close (pm);
+
+  pcap_stream_free_rings (pm);
+
+  return error;
+}
+
 /**
  * @brief Read PCAP file
  *
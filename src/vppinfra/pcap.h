@@ -150,6 +150,49 @@ typedef struct
   u8 data[0];
 } pcap_packet_header_t;
 
+/** pcapng block types and constants, used by the streaming writer */
+#define PCAPNG_BLOCK_TYPE_SHB 0x0a0d0d0a
+#define PCAPNG_BLOCK_TYPE_IDB 0x00000001
+#define PCAPNG_BLOCK_TYPE_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+
+/**
+ * @brief Capture ring slot, one packet
+ */
+typedef struct
+{
+  /** Capture time, seconds */
+  f64 time;
+  /** Number of bytes in actual packet. */
+  u32 n_bytes_in_packet;
+  /** Number of bytes captured in the slot. */
+  u32 n_bytes_captured;
+  /** Packet data follows. */
+  u8 data[0];
+} pcap_ring_slot_t;
+
+/**
+ * @brief Per-thread capture ring
+ *
+ * Single producer (the owning thread) and single consumer (the stream
+ * writer). Head and tail are free running slot counters.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /** Producer index */
+  u32 head;
+  /** Packets dropped on ring full */
+  u32 n_drops;
+  /** Packets captured */
+  u64 n_packets_captured;
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  /** Consumer index */
+  u32 tail;
+  /** Slot memory */
+  u8 *slots;
+} pcap_ring_t;
+
 /**
  * @brief PCAP main state data structure
  */
@@ -173,6 +216,7 @@ typedef struct
   /** flags */
   u32 flags;
 #define PCAP_MAIN_INIT_DONE (1 << 0)
+#define PCAP_MAIN_STREAM (1 << 1)
 
   /** File descriptor for reading/writing. */
   int file_descriptor;
@@ -191,6 +235,25 @@ typedef struct
 
   /** Min/Max Packet bytes */
   u32 min_packet_bytes, max_packet_bytes;
+
+  /** Streaming mode: per-thread rings, slots per ring (power of 2) */
+  pcap_ring_t *rings;
+  u32 ring_size;
+
+  /** Slot stride and max bytes captured per packet */
+  u32 slot_size;
+  u32 snaplen;
+
+  /** Rotate after this many bytes (0 = never), keep n old files.
+      No rotation without at least one old file to keep. */
+  u64 rotate_file_size;
+  u32 rotate_n_files;
+
+  /** Bytes written to the current file */
+  u64 n_bytes_in_file;
+
+  /** Added to capture times to get unix time */
+  f64 time_offset;
 } pcap_main_t;
 
 #define PCAP_DEF_PKT_TO_CAPTURE (100)
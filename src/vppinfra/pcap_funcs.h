@@ -23,6 +23,12 @@ clib_error_t *pcap_write (pcap_main_t * pm);
 /** Read data from file. */
 clib_error_t *pcap_read (pcap_main_t * pm);
 
+/** Streaming capture: allocate rings and open file, drain rings to file,
+    drain and close. */
+clib_error_t *pcap_stream_open (pcap_main_t * pm, u32 n_threads);
+clib_error_t *pcap_stream_drain (pcap_main_t * pm);
+clib_error_t *pcap_stream_close (pcap_main_t * pm);
+
 /** Close the file created by pcap_write function. */
 clib_error_t *pcap_close (pcap_main_t * pm);
 
@@ -54,6 +60,68 @@ pcap_add_packet (pcap_main_t * pm,
   return h->data;
 }
 
+/**
+ * @brief Copy up to n_left bytes of a buffer chain
+ */
+static inline void
+pcap_copy_buffer_chain (struct vlib_main_t *vm, vlib_buffer_t * b, u8 * d,
+			i32 n_left)
+{
+  while (1)
+    {
+      u32 copy_length = clib_min ((u32) n_left, b->current_length);
+      clib_memcpy_fast (d, b->data + b->current_data, copy_length);
+      n_left -= b->current_length;
+      if (n_left <= 0)
+	break;
+      d += b->current_length;
+      ASSERT (b->flags & VLIB_BUFFER_NEXT_PRESENT);
+      b = vlib_get_buffer (vm, b->next_buffer);
+    }
+}
+
+static inline pcap_ring_slot_t *
+pcap_ring_get_slot (pcap_main_t * pm, pcap_ring_t * r, u32 index)
+{
+  return (pcap_ring_slot_t *) (r->slots + (uword) (index &
+						   (pm->ring_size - 1)) *
+			       pm->slot_size);
+}
+
+/**
+ * @brief Add buffer to the calling thread's capture ring
+ *
+ * Lock-free, the packet is dropped (and counted) if the ring is full.
+ */
+static inline void
+pcap_ring_add_buffer (pcap_main_t * pm, struct vlib_main_t *vm,
+		      u32 buffer_index, u32 n_bytes_in_trace)
+{
+  pcap_ring_t *r = vec_elt_at_index (pm->rings, vm->thread_index);
+  vlib_buffer_t *b = vlib_get_buffer (vm, buffer_index);
+  pcap_ring_slot_t *s;
+  u32 head = r->head;
+  u32 n;
+
+  if (PREDICT_FALSE (head - clib_atomic_load_acq_n (&r->tail) >=
+		     pm->ring_size))
+    {
+      r->n_drops++;
+      return;
+    }
+
+  s = pcap_ring_get_slot (pm, r, head);
+  n = vlib_buffer_length_in_chain (vm, b);
+  s->time = vlib_time_now (vm);
+  s->n_bytes_in_packet = n;
+  s->n_bytes_captured = clib_min (clib_min (n_bytes_in_trace, n),
+				  pm->snaplen);
+  pcap_copy_buffer_chain (vm, b, s->data, s->n_bytes_captured);
+  r->n_packets_captured++;
+
+  clib_atomic_store_rel_n (&r->head, head + 1);
+}
+
 /**
  * @brief Add buffer (vlib_buffer_t) to the trace
  *
@@ -68,27 +136,28 @@ pcap_add_buffer (pcap_main_t * pm,
 		 struct vlib_main_t *vm, u32 buffer_index,
 		 u32 n_bytes_in_trace)
 {
-  vlib_buffer_t *b = vlib_get_buffer (vm, buffer_index);
-  u32 n = vlib_buffer_length_in_chain (vm, b);
-  i32 n_left = clib_min (n_bytes_in_trace, n);
-  f64 time_now = vlib_time_now (vm);
+  vlib_buffer_t *b;
+  u32 n;
+  i32 n_left;
+  f64 time_now;
   void *d;
 
+  if (pm->flags & PCAP_MAIN_STREAM)
+    {
+      pcap_ring_add_buffer (pm, vm, buffer_index, n_bytes_in_trace);
+      return;
+    }
+
+  b = vlib_get_buffer (vm, buffer_index);
+  n = vlib_buffer_length_in_chain (vm, b);
+  n_left = clib_min (n_bytes_in_trace, n);
+  time_now = vlib_time_now (vm);
+
   if (PREDICT_TRUE (pm->n_packets_captured < pm->n_packets_to_capture))
     {
       clib_spinlock_lock_if_init (&pm->lock);
       d = pcap_add_packet (pm, time_now, n_left, n);
-      while (1)
-	{
-	  u32 copy_length = clib_min ((u32) n_left, b->current_length);
-	  clib_memcpy_fast (d, b->data + b->current_data, copy_length);
-	  n_left -= b->current_length;
-	  if (n_left <= 0)
-	    break;
-	  d += b->current_length;
-	  ASSERT (b->flags & VLIB_BUFFER_NEXT_PRESENT);
-	  b = vlib_get_buffer (vm, b->next_buffer);
-	}
+      pcap_copy_buffer_chain (vm, b, d, n_left);
       clib_spinlock_unlock_if_init (&pm->lock);
     }
 }
@@ -42,6 +42,137 @@
 #include <vppinfra/serialize.h>
 #include <vppinfra/unix.h>
 
+#ifdef CLIB_UNIX
+#include <pthread.h>
+
+typedef struct
+{
+  elog_main_t *em;
+  u32 thread_index;
+  u32 n_iter;
+  volatile u32 *done;
+} test_elog_thread_args_t;
+
+static void *
+test_elog_thread_fn (void *arg)
+{
+  test_elog_thread_args_t *a = arg;
+  ELOG_TYPE_DECLARE (e) =
+  {
+  .format = "thread %d seq %d",.format_args = "i4i4",};
+  struct
+  {
+    u32 thread, seq;
+  } *d;
+  u32 i;
+
+  os_set_thread_index (a->thread_index);
+  clib_mem_set_per_cpu_heap (clib_per_cpu_mheaps[0]);
+
+  for (i = 0; i < a->n_iter; i++)
+    {
+      d = ELOG_DATA (a->em, e);
+      d->thread = a->thread_index;
+      d->seq = i;
+    }
+  clib_atomic_fetch_add (a->done, 1);
+  return 0;
+}
+
+/* Log from several threads into per-thread rings, merging concurrently,
+   then check the merged log is in time order and loses nothing
+   it does not account for. One more thread logs a single event and
+   goes idle, which must not hold back the merge of the others. */
+static clib_error_t *
+test_elog_thread_rings (elog_main_t * em, u32 n_threads, u32 n_iter,
+			u32 verbose)
+{
+  test_elog_thread_args_t *args = 0, *a;
+  pthread_t *threads = 0;
+  elog_event_t *e, *es;
+  volatile u32 done = 0;
+  u32 *last_seq = 0, n_events, n_merged = 0, n_logged;
+  u64 last_time = 0, n_lost, t;
+  u32 n_paradoxes = 0;
+  struct
+  {
+    u32 thread, seq;
+  } *d;
+  u32 i;
+
+  em->lock = clib_mem_alloc_aligned (CLIB_CACHE_LINE_BYTES,
+				     CLIB_CACHE_LINE_BYTES);
+  em->lock[0] = 0;
+
+  /* Register types and tracks up front from this thread */
+  elog_enable_thread_rings (em, n_threads + 2, 1 << 12);
+
+  vec_validate (args, n_threads);
+  vec_validate (threads, n_threads);
+  for (i = 0; i <= n_threads; i++)
+    {
+      a = args + i;
+      a->em = em;
+      a->thread_index = i + 1;
+      a->n_iter = i < n_threads ? n_iter : 1;
+      a->done = &done;
+      if (pthread_create (threads + i, 0, test_elog_thread_fn, a))
+	return clib_error_return_unix (0, "pthread_create");
+    }
+
+  while (done <= n_threads)
+    n_merged += elog_merge_thread_rings (em, 0);
+
+  for (i = 0; i <= n_threads; i++)
+    pthread_join (threads[i], 0);
+
+  /* Nothing committed the last event of each thread, they are merged
+     without a flush once they time out */
+  t = clib_cpu_time_now () + em->cpu_timer.clocks_per_second * 20e-3;
+  while (clib_cpu_time_now () < t)
+    ;
+  n_merged += elog_merge_thread_rings (em, 0);
+  if (elog_merge_thread_rings (em, 1 /* flush */ ))
+    return clib_error_return (0, "idle thread events left unmerged");
+
+  n_logged = n_threads * n_iter + 1;
+  n_lost = elog_thread_rings_lost_events (em);
+  if (n_merged + n_lost != n_logged)
+    return clib_error_return (0, "merged %u + lost %llu != logged %u",
+			      n_merged, n_lost, n_logged);
+
+  es = elog_peek_events (em);
+  n_events = vec_len (es);
+  vec_validate_init_empty (last_seq, n_threads + 1, ~0);
+  /* A writer preempted between taking its timestamp and publishing
+     the event can still land behind the merge, count those */
+  vec_foreach (e, es)
+  {
+    n_paradoxes += e->time_cycles < last_time;
+    last_time = e->time_cycles;
+    d = (void *) e->data;
+    if (last_seq[d->thread] != ~0 && d->seq <= last_seq[d->thread])
+      return clib_error_return (0, "thread %d sequence %d after %d",
+				d->thread, d->seq, last_seq[d->thread]);
+    last_seq[d->thread] = d->seq;
+  }
+  if (last_seq[n_threads + 1] != 0)
+    return clib_error_return (0, "idle thread event missing");
+
+  if (verbose)
+    fformat (stdout, "%u threads: merged %u, lost %llu, %u in buffer, "
+	     "%u out of time order\n", n_threads, n_merged, n_lost,
+	     n_events, n_paradoxes);
+
+  elog_disable_thread_rings (em);
+  vec_free (es);
+  vec_free (args);
+  vec_free (threads);
+  vec_free (last_seq);
+  return 0;
+}
+#endif /* CLIB_UNIX */
+
 int
 test_elog_main (unformat_input_t * input)
 {
@@ -54,6 +185,7 @@ test_elog_main (unformat_input_t * input)
   u8 *tag, **tags;
   f64 align_tweak;
   f64 *align_tweaks;
+  u32 n_threads = 0;
 
   n_iter = 100;
   max_events = 100000;
@@ -86,6 +218,8 @@ test_elog_main (unformat_input_t * input)
 	;
       else if (unformat (input, "sample-time %f", &min_sample_time))
 	;
+      else if (unformat (input, "thread-rings %d", &n_threads))
+	;
       else if (unformat (input, "align-tweak %f", &align_tweak))
 	vec_add1 (align_tweaks, align_tweak);
       else
@@ -97,6 +231,13 @@ test_elog_main (unformat_input_t * input)
     }
 
 #ifdef CLIB_UNIX
+  if (n_threads)
+    {
+      elog_init (em, max_events);
+      error = test_elog_thread_rings (em, n_threads, n_iter, verbose);
+      goto done;
+    }
+
   if (load_file)
     {
       if ((error = elog_read_file (em, load_file)))
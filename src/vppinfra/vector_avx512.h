@@ -120,6 +120,19 @@ u32x16_min_scalar (u32x16 v)
 				      u32x16_extract_hi (v)));
 }
 
+static_always_inline u32x16
+u32x16_mask_load_zero (void *p, u16 mask)
+{
+  return (u32x16) _mm512_maskz_loadu_epi32 (mask, p);
+}
+
+static_always_inline u32x4
+u32x16_xor_reduce_u32x4 (u32x16 v)
+{
+  u32x8 x = u32x16_extract_lo (v) ^ u32x16_extract_hi (v);
+  return u32x8_extract_lo (x) ^ u32x8_extract_hi (x);
+}
+
 static_always_inline u32x16
 u32x16_insert_lo (u32x16 r, u32x8 v)
 {
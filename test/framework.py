@@ -1105,6 +1105,15 @@ class VppTestCase(unittest.TestCase):
         self.assert_equal(counter_value, expected_value,
                           "error counter `%s'" % counter)
 
+    def get_buffers_used(self):
+        """ Sum of the "Used" column of all buffer pools """
+        used = 0
+        for line in self.vapi.cli("show buffers").splitlines()[1:]:
+            fields = line.split()
+            if len(fields) >= 9 and fields[-1].isdigit():
+                used += int(fields[-1])
+        return used
+
     @classmethod
     def sleep(cls, timeout, remark=None):
 
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+
+import ipaddress
+import os
+import subprocess
+
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, ICMP
+
+from framework import VppTestCase
+
+
+def ip(*args):
+    """ run an iproute2 command, True on success """
+    with open(os.devnull, "w") as devnull:
+        return subprocess.call(["ip"] + list(args),
+                               stdout=devnull, stderr=devnull) == 0
+
+
+def veth_access(vpp_if, host_if):
+    """ creating a veth pair needs root """
+    if os.geteuid() != 0:
+        return False
+    if not ip("link", "add", vpp_if, "type", "veth", "peer", "name",
+              host_if):
+        return False
+    ip("link", "del", vpp_if)
+    return True
+
+
+class TestVethHost(VppTestCase):
+    """ VPP on one end of a veth pair, the Linux host on the other
+
+    pg0 hosts reach the Linux end of the veth through the VPP interface
+    a test creates on the VPP end, which it deletes in delete_interface.
+    """
+
+    vpp_if = None
+    host_if = None
+    vpp_ip4 = None
+    host_ip4 = None
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVethHost, cls).setUpClass()
+        cls.create_pg_interfaces(range(1))
+        for pg in cls.pg_interfaces:
+            pg.admin_up()
+            pg.config_ip4()
+            pg.generate_remote_hosts(16)
+            pg.configure_ipv4_neighbors()
+
+    @classmethod
+    def tearDownClass(cls):
+        for pg in cls.pg_interfaces:
+            pg.unconfig_ip4()
+            pg.admin_down()
+        super(TestVethHost, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestVethHost, self).setUp()
+        self.created = []
+        ip("link", "add", self.vpp_if, "type", "veth", "peer", "name",
+           self.host_if)
+        ip("link", "set", self.vpp_if, "up")
+        ip("link", "set", self.host_if, "up")
+        ip("addr", "add", "%s/24" % self.host_ip4, "dev", self.host_if)
+        pg0_net = ipaddress.ip_network(self.pg0.local_ip4_prefix,
+                                       strict=False)
+        ip("route", "add", str(pg0_net), "via", self.vpp_ip4)
+
+    def tearDown(self):
+        for sw_if_index in self.created:
+            self.delete_interface(sw_if_index)
+        ip("link", "del", self.vpp_if)
+        super(TestVethHost, self).tearDown()
+
+    def delete_interface(self, sw_if_index):
+        raise NotImplementedError
+
+    def config_host_route(self, ifname, rx_mode):
+        """ address the VPP end of the veth and reach the host through it """
+        self.vapi.cli("set interface state %s up" % ifname)
+        self.vapi.cli("set interface ip address %s %s/24" %
+                      (ifname, self.vpp_ip4))
+        self.vapi.cli("set interface rx-mode %s %s" % (ifname, rx_mode))
+
+        # no request lost to ARP resolution in VPP
+        with open("/sys/class/net/%s/address" % self.host_if) as f:
+            host_mac = f.read().strip()
+        self.vapi.cli("set ip neighbor %s %s %s" % (ifname, self.host_ip4,
+                                                    host_mac))
+
+    def ping_host(self, n_pkts, n_hosts=1, payload_len=0):
+        """ ping the host from pg0 hosts, return the echo replies """
+        hosts = self.pg0.remote_hosts[:n_hosts]
+        pkts = []
+        for i in range(n_pkts):
+            host = hosts[i % n_hosts]
+            pkts.append(Ether(dst=self.pg0.local_mac, src=host.mac) /
+                        IP(src=host.ip4, dst=self.host_ip4) /
+                        ICMP(id=1, seq=i) /
+                        Raw(b'\xa5' * payload_len))
+
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        rx = self.pg0.get_capture(n_pkts, timeout=2)
+        for p in rx:
+            self.assertEqual(p[IP].src, self.host_ip4)
+            self.assertEqual(p[ICMP].type, 0)  # echo-reply
+        return rx
@@ -0,0 +1,84 @@
+import re
+import unittest
+
+from framework import VppTestRunner
+from vpp_papi import VppEnum
+from template_veth import TestVethHost, veth_access
+
+VPP_IF = "vpp-afp0"
+HOST_IF = "host-afp0"
+
+
+@unittest.skipUnless(veth_access(VPP_IF, HOST_IF), "Requires root and veth")
+class TestAfPacket(TestVethHost):
+    """ AF_PACKET Test Case """
+
+    vpp_if = VPP_IF
+    host_if = HOST_IF
+    vpp_ip4 = "10.98.98.1"
+    host_ip4 = "10.98.98.2"
+    ifname = "host-%s" % VPP_IF
+
+    def create_af_packet(self, num_queues=1, flags=0):
+        rv = self.vapi.af_packet_create_v2(host_if_name=VPP_IF,
+                                           use_random_hw_addr=True,
+                                           num_queues=num_queues,
+                                           flags=flags)
+        self.assertEqual(rv.retval, 0)
+        self.created.append(rv.sw_if_index)
+        return self.vapi.cli("show hardware-interfaces %s" % self.ifname)
+
+    def delete_interface(self, sw_if_index):
+        self.vapi.af_packet_delete(host_if_name=VPP_IF)
+
+    def test_af_packet_ping_polling(self):
+        """ AF_PACKET ping in polling mode """
+        hw = self.create_af_packet()
+        # tx goes through the host qdisc unless bypass is asked for
+        self.assertNotIn("qdisc-bypass", hw)
+        self.config_host_route(self.ifname, "polling")
+        self.ping_host(16)
+
+    def test_af_packet_ping_interrupt(self):
+        """ AF_PACKET ping in interrupt mode """
+        self.create_af_packet()
+        self.config_host_route(self.ifname, "interrupt")
+        self.ping_host(16)
+
+    def test_af_packet_rx_blocks(self):
+        """ AF_PACKET TPACKET_V3 rx across blocks """
+        hw = self.create_af_packet()
+        m = re.search(r"rx block-size (\d+) block-nr (\d+)", hw)
+        self.assertIsNotNone(m, hw)
+        block_size, block_nr = int(m.group(1)), int(m.group(2))
+        self.config_host_route(self.ifname, "interrupt")
+
+        # a lone packet is handed over when its block times out, a burst
+        # fills and retires several blocks in a row
+        self.ping_host(1)
+        payload_len = 1200
+        n_pkts = 3 * block_size // (payload_len + 100)
+        self.assertLess(n_pkts, block_size * block_nr // 2048)
+        self.ping_host(n_pkts, payload_len=payload_len)
+
+    def test_af_packet_fanout(self):
+        """ AF_PACKET fanout group with qdisc bypass and offloads """
+        flags = VppEnum.vl_api_af_packet_flags_t
+        hw = self.create_af_packet(4,
+                                   flags.AF_PACKET_API_FLAG_QDISC_BYPASS |
+                                   flags.AF_PACKET_API_FLAG_CKSUM_GSO)
+        self.assertIn("queues 4 fanout-group", hw)
+        self.assertIn("qdisc-bypass cksum-gso", hw)
+        self.config_host_route(self.ifname, "interrupt")
+
+        # the replies of several flows are hashed over the sockets
+        self.vapi.cli("trace add af-packet-input 64")
+        self.ping_host(64, n_hosts=16)
+        queues = set(re.findall(r"rx-queue (\d+)",
+                                self.vapi.cli("show trace")))
+        self.assertGreater(len(queues), 1)
+        self.vapi.cli("clear trace")
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
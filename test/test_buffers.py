@@ -27,3 +27,11 @@ class TestBuffers(VppTestCase):
         if error:
             self.logger.critical(error)
             self.assertNotIn('failed', error)
+
+    def test_pool_magazines(self):
+        """ Buffer Pool Magazine Depot """
+        error = self.vapi.cli("test buffer-pool-magazines")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn('failed', error)
@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 
 import binascii
+import re
 import socket
 import unittest
 
@@ -565,5 +566,128 @@ class TestClassifierPBR(TestClassifier):
         # and the table should be gone.
         self.assertFalse(self.verify_vrf(self.pbr_vrfid))
 
+
+class TestClassifierChain(TestClassifier):
+    """ Classifier table chain Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestClassifierChain, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestClassifierChain, cls).tearDownClass()
+
+    @staticmethod
+    def build_byte_mask(offsets, n_bytes):
+        mask = bytearray(n_bytes)
+        for o in offsets:
+            mask[o] = 0xff
+        return mask
+
+    def add_chain_table(self, mask, next_table_index):
+        r = self.vapi.classify_add_del_table(
+            is_add=1,
+            mask=bytes(mask),
+            mask_len=len(mask),
+            match_n_vectors=len(mask) // 16,
+            next_table_index=next_table_index,
+            miss_next_index=0xffffffff)
+        return r.new_table_index
+
+    def add_chain_session(self, table_index, mask, pkt, policer_index):
+        data = bytes(pkt)
+        match = bytes(m & data[i] for i, m in enumerate(mask))
+        self.vapi.classify_add_del_session(
+            is_add=1,
+            table_index=table_index,
+            match=match,
+            match_len=len(match),
+            hit_next_index=policer_index,
+            opaque_index=0)
+
+    def node_variants(self, node):
+        """ node function variants usable on this cpu """
+        out = self.vapi.cli("show node %s" % node)
+        variants = re.findall(r"^\s+(\w+)\s+(\d+)\s+(?:yes)?\s*$", out,
+                              re.MULTILINE)
+        return [name for name, prio in variants if int(prio) < 2 ** 31]
+
+    def test_chain_same_mask(self):
+        """ Table chain with shared masks test
+
+        Test scenario for a chain of policer classify tables:
+            - Tables A and B share a 3 vector mask, the packet hash
+              computed for A is reused for B.
+            - Table C has its own 5 vector mask.
+            - Sessions hit in each table, and misses, give the same
+              results with every node function variant, AVX-512 included
+              when the cpu has it.
+        """
+        node = "ip4-policer-classify"
+        err = "/err/%s/Policer classify " % node
+
+        policer = self.vapi.policer_add_del(b"chain", 10000000, 10000000,
+                                            1000000, 1000000,
+                                            conform_action_type=1,
+                                            exceed_action_type=1,
+                                            violate_action_type=1)
+        pi = policer.policer_index
+
+        # src address at 26, udp dst port at 36, payload byte at 72
+        mask_ab = self.build_byte_mask([26, 27, 28, 29, 36, 37], 48)
+        mask_c = self.build_byte_mask([36, 37, 72], 80)
+
+        pkts = {}
+        for dport in [1000, 2000, 3000, 4000]:
+            pkts[dport] = (Ether(dst=self.pg0.local_mac,
+                                 src=self.pg0.remote_mac) /
+                           IP(src=self.pg0.remote_ip4,
+                              dst=self.pg1.remote_ip4) /
+                           UDP(sport=1234, dport=dport) /
+                           Raw(b'\xab' * 64))
+
+        tc = self.add_chain_table(mask_c, 0xffffffff)
+        tb = self.add_chain_table(mask_ab, tc)
+        ta = self.add_chain_table(mask_ab, tb)
+        self.add_chain_session(ta, mask_ab, pkts[1000], pi)
+        self.add_chain_session(tb, mask_ab, pkts[2000], pi)
+        self.add_chain_session(tc, mask_c, pkts[3000], pi)
+        self.vapi.policer_classify_set_interface(
+            sw_if_index=self.pg0.sw_if_index, ip4_table_index=ta,
+            ip6_table_index=0xffffffff, l2_table_index=0xffffffff,
+            is_add=1)
+
+        variants = self.node_variants(node)
+        self.assertIn("default", variants)
+        n = 10
+        for variant in variants:
+            self.vapi.cli("set node function %s %s" % (node, variant))
+            hits = self.statistics.get_err_counter(err + "hits")
+            chain_hits = self.statistics.get_err_counter(
+                err + "hits after chain walk")
+            misses = self.statistics.get_err_counter(err + "misses")
+
+            stream = [p for p in pkts.values() for i in range(n)]
+            rx = self.send_and_expect(self.pg0, stream, self.pg1)
+            self.assertEqual(len(rx), len(stream), variant)
+
+            # A, B and C hit; B and C after the chain walk; D misses
+            self.assertEqual(self.statistics.get_err_counter(err + "hits"),
+                             hits + 3 * n, variant)
+            self.assertEqual(self.statistics.get_err_counter(
+                err + "hits after chain walk"), chain_hits + 2 * n, variant)
+            self.assertEqual(self.statistics.get_err_counter(err + "misses"),
+                             misses + n, variant)
+
+        self.vapi.policer_classify_set_interface(
+            sw_if_index=self.pg0.sw_if_index, ip4_table_index=ta,
+            ip6_table_index=0xffffffff, l2_table_index=0xffffffff,
+            is_add=0)
+        self.vapi.classify_add_del_table(is_add=0, table_index=ta,
+                                         del_chain=1)
+        self.vapi.policer_add_del(b"chain", 0, 0, 0, 0, is_add=0)
+
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -42,5 +42,26 @@ class TestFIB(VppTestCase):
             self.logger.critical(error)
         self.assertNotIn("Failed", error)
 
+    def test_fib_walk_convergence(self):
+        """ FIB walk convergence time """
+        self.vapi.cli("clear fib walk")
+        self.assertEqual(
+            self.statistics.get_counter("/fib/walk/convergence/walks"), 0)
+
+        error = self.vapi.cli("test fib walk")
+        if error:
+            self.logger.critical(error)
+        self.assertNotIn("Failed", error)
+
+        # every walk that reached its last child is timed
+        n_walks = self.statistics.get_counter("/fib/walk/convergence/walks")
+        self.assertGreater(n_walks, 0)
+        self.assertGreaterEqual(
+            self.statistics.get_counter("/fib/walk/convergence/max-usec"),
+            self.statistics.get_counter("/fib/walk/convergence/last-usec"))
+        walk = self.vapi.cli("sh fib walk")
+        self.assertIn("walks:%d" % n_walks, walk)
+        self.assertIn("convergence:", walk)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
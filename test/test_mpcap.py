@@ -4,7 +4,12 @@ import unittest
 
 from framework import VppTestCase, VppTestRunner, running_extended_tests
 from vpp_ip_route import VppIpTable, VppIpRoute, VppRoutePath
+from vpp_papi_provider import CliFailedCommandError
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from scapy.packet import Raw
 import os
+import struct
 
 
 class TestMpcap(VppTestCase):
@@ -13,9 +18,14 @@ class TestMpcap(VppTestCase):
     @classmethod
     def setUpClass(cls):
         super(TestMpcap, cls).setUpClass()
+        cls.create_pg_interfaces(range(1))
+        cls.pg0.admin_up()
+        cls.pg0.config_ip4()
 
     @classmethod
     def tearDownClass(cls):
+        cls.pg0.unconfig_ip4()
+        cls.pg0.admin_down()
         super(TestMpcap, cls).tearDownClass()
 
     def setUp(self):
@@ -51,5 +61,67 @@ class TestMpcap(VppTestCase):
             self.logger.critical("BUG: file size %d not 2184" % size)
             self.assertNotIn('WrongMPCAPFileSize', 'WrongMPCAPFileSize')
 
+    def count_pcapng_packets(self, path):
+        """ Number of enhanced packet blocks in a pcapng file """
+        with open(path, 'rb') as f:
+            data = f.read()
+        n, offset = 0, 0
+        while offset < len(data):
+            block_type, length = struct.unpack_from('=II', data, offset)
+            self.assertGreater(length, 0)
+            if block_type == 6:
+                n += 1
+            offset += length
+        self.assertEqual(offset, len(data))
+        return n
+
+    def send_udp(self, n_pkts, size):
+        p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+             IP(src=self.pg0.remote_ip4, dst="1.2.3.4") /
+             UDP(sport=1234, dport=1234))
+        p = p / Raw(b'\xa5' * (size - len(p)))
+        self.pg0.add_stream([p] * n_pkts)
+        self.pg_start()
+
+    def test_pcap_stream(self):
+        """ Streaming pcapng capture """
+        path = "/tmp/mpcap_stream.pcapng"
+        self.vapi.cli("pcap trace rx intfc pg0 stream max-bytes-per-pkt 256 "
+                      "file mpcap_stream.pcapng")
+        self.send_udp(100, 128)
+        reply = self.vapi.cli("pcap trace off")
+        self.assertIn("Wrote 100 packets (0 ring drops)", reply)
+        self.assertEqual(self.count_pcapng_packets(path), 100)
+        os.remove(path)
+
+    def test_pcap_stream_rotate(self):
+        """ Streaming pcapng capture with file rotation """
+        path = "/tmp/mpcap_rotate.pcapng"
+
+        # rotating into no file would truncate the capture
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("pcap trace rx intfc pg0 stream rotate-size 1 "
+                          "file mpcap_rotate.pcapng")
+
+        # a little over 1MB, so the file is rotated once
+        n_pkts = 1500
+        self.vapi.cli("pcap trace rx intfc pg0 stream "
+                      "max-bytes-per-pkt 1000 rotate-size 1 rotate-files 2 "
+                      "file mpcap_rotate.pcapng")
+        for i in range(3):
+            self.send_udp(n_pkts // 3, 1000)
+            self.sleep(0.1, "wait for the writer")
+        self.vapi.cli("pcap trace off")
+
+        self.assertFalse(os.path.exists(path + ".2"))
+        n_old = self.count_pcapng_packets(path + ".1")
+        n_new = self.count_pcapng_packets(path)
+        self.assertGreater(n_old, 0)
+        self.assertGreater(n_new, 0)
+        self.assertLessEqual(os.path.getsize(path + ".1"), (1 << 20) + 1100)
+        self.assertEqual(n_old + n_new, n_pkts)
+        os.remove(path)
+        os.remove(path + ".1")
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestPolicer(VppTestCase):
+    """ Policer Test Cases """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestPolicer, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestPolicer, cls).tearDownClass()
+
+    def test_policer_unittest(self):
+        """ Policer thread caches and hierarchy """
+        reply = self.vapi.cli("test vnet policer")
+        self.assertIn("policer cache: 64 packets in burst", reply)
+        self.assertIn("policer hierarchy: ok", reply)
+        self.assertNotIn("test-policer", self.vapi.cli("show policer"))
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
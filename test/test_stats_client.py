@@ -4,6 +4,9 @@ import unittest
 import time
 import psutil
 from vpp_papi.vpp_stats import VPPStats
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
 
 from framework import VppTestCase, VppTestRunner
 
@@ -43,6 +46,37 @@ class StatsClientTestCase(VppTestCase):
                          "ending client side file descriptor count: %s" % (
                              initial_fds, ending_fds))
 
+    def test_snapshot_delta(self):
+        """Test snapshot deltas"""
+
+        self.create_pg_interfaces(range(1))
+        self.pg0.admin_up()
+        self.pg0.config_ip4()
+
+        snapshot = self.statistics.snapshot(['^/if/rx$'])
+        self.assertEqual(snapshot.delta(), {})
+
+        pkts = [(Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) /
+                 IP(src=self.pg0.remote_ip4, dst="10.10.10.10") /
+                 UDP(sport=1234, dport=1234) /
+                 Raw(b'\xa5' * 100)) for i in range(5)]
+        self.send_and_assert_no_replies(self.pg0, pkts)
+
+        d = snapshot.delta()
+        self.assertEqual(list(d.keys()), ['/if/rx'])
+        self.assertEqual(list(d['/if/rx'].keys()), [self.pg0.sw_if_index])
+        self.assertEqual(d['/if/rx'][self.pg0.sw_if_index]['packets'], 5)
+        self.assertEqual(snapshot.delta(), {})
+
+        # All entries, changed or not
+        d = snapshot.delta(changed_only=False)
+        self.assertGreater(len(d['/if/rx']), 1)
+        self.assertEqual(d['/if/rx'][self.pg0.sw_if_index]['packets'], 0)
+        snapshot.close()
+
+        self.pg0.unconfig_ip4()
+        self.pg0.admin_down()
+
     @unittest.skip("Manual only")
     def test_mem_leak(self):
         def loop():
@@ -1,7 +1,13 @@
+import re
 import unittest
 import os
 
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from scapy.packet import Raw
+
 from framework import VppTestCase, VppTestRunner
+from vpp_papi import VppEnum
 from vpp_devices import VppTAPInterface
 
 
@@ -19,6 +25,67 @@ class TestTAP(VppTestCase):
         tap0.add_vpp_config()
         self.assertTrue(tap0.query_vpp_config())
 
+    def test_tap_multi_queue(self):
+        """Create multi-queue TAP interface"""
+        flags = VppEnum.vl_api_tap_flags_t
+        tap0 = VppTAPInterface(self, tap_id=1, num_rx_queues=4,
+                               tap_flags=flags.TAP_FLAG_GSO)
+        tap0.add_vpp_config()
+        self.assertTrue(tap0.query_vpp_config())
+
+        # one tap queue and one vhost-net device per rx queue
+        show = self.vapi.cli("show tap tap1")
+        tap_fds = [line for line in show.splitlines()
+                   if "tap-fds" in line][0]
+        self.assertEqual(len(tap_fds.split()), 5)
+        self.assertIn("gso-enabled 1", show)
+
+        # each rx queue is placed on a thread and can be interrupt driven
+        self.vapi.cli("set interface rx-mode tap1 interrupt")
+        placement = self.vapi.cli("show interface rx-placement")
+        for q in range(4):
+            self.assertIn("tap1 queue %d (interrupt)" % q, placement)
+
+    def test_tap_tx_reclaim(self):
+        """TAP tx ring filled past half its size"""
+        self.create_pg_interfaces(range(1))
+        self.pg0.admin_up()
+        self.pg0.config_ip4()
+        self.pg0.resolve_arp()
+        baseline = self.get_buffers_used()
+
+        tap0 = VppTAPInterface(self, tap_id=2)
+        tap0.add_vpp_config()
+        tap0.admin_up()
+        self.vapi.cli("set interface ip address tap2 10.10.10.1/24")
+        self.vapi.cli("ip neighbor tap2 10.10.10.2 02:fe:00:00:00:02")
+        ring_size = tap0.get_vpp_dump().tx_ring_sz
+
+        # completed tx buffers are reclaimed once the ring is half full,
+        # send several rings worth so that reclaim runs and wraps
+        n_pkts = 3 * ring_size
+        pkts = [(Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+                 IP(src=self.pg0.remote_ip4, dst="10.10.10.2") /
+                 UDP(sport=1234, dport=1234 + i % 64) /
+                 Raw(b'\xa5' * 100)) for i in range(n_pkts)]
+        for i in range(0, n_pkts, ring_size // 4):
+            self.pg0.add_stream(pkts[i:i + ring_size // 4])
+            self.pg_start()
+
+        out = self.vapi.cli("show interface tap2")
+        m = re.search(r"tx packets\s+(\d+)", out)
+        self.assertIsNotNone(m, out)
+        self.assertEqual(int(m.group(1)), n_pkts)
+
+        # the rx ring stays filled, at most a tx ring worth is in flight
+        self.assertLessEqual(self.get_buffers_used(),
+                             baseline + 2 * ring_size)
+
+        # and every buffer comes back with the interface
+        tap0.remove_vpp_config()
+        self.assertEqual(self.get_buffers_used(), baseline)
+        self.pg0.unconfig_ip4()
+
 
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
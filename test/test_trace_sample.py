@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+from vpp_papi_provider import CliFailedCommandError
+
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+
+
+class TestTraceSample(VppTestCase):
+    """ Sampled Packet Trace Test """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestTraceSample, cls).setUpClass()
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestTraceSample, cls).tearDownClass()
+
+    def tearDown(self):
+        self.vapi.cli("set interface trace-sample pg0 off")
+        self.vapi.cli("clear trace")
+        super(TestTraceSample, self).tearDown()
+
+    def send(self, n_pkts):
+        p = (Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac) /
+             IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4) /
+             UDP(sport=1234, dport=1234) /
+             Raw(b'\xa5' * 64))
+        self.pg0.add_stream([p] * n_pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.pg1.get_capture(n_pkts)
+
+    def test_trace_sample(self):
+        """ Sampled trace and show trace sample """
+        self.vapi.cli("set interface trace-sample pg0 every 10")
+        self.send(100)
+
+        reply = self.vapi.cli("show trace sample")
+        self.assertIn("10 sampled paths", reply)
+        self.assertIn("ip4-lookup", reply)
+        self.assertIn("ip4-rewrite", reply)
+
+        reply = self.vapi.cli("show trace sample dump trace_sample.bin")
+        self.assertIn("Wrote", reply)
+
+        # full trace and sampling share the buffer trace handle
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("trace add pg-input 10")
+
+        self.vapi.cli("clear trace")
+        self.assertIn("0 records", self.vapi.cli("show trace sample"))
+
+    def test_trace_after_sample(self):
+        """ Full trace after sampled trace """
+        self.vapi.cli("set interface trace-sample pg0 every 1")
+        self.send(10)
+        self.vapi.cli("set interface trace-sample pg0 off")
+
+        # sampled buffers must not be taken for traced ones
+        self.vapi.cli("trace add pg-input 10")
+        self.send(10)
+        reply = self.vapi.cli("show trace")
+        self.assertEqual(reply.count("Packet "), 10)
+        self.assertIn("ip4-rewrite", reply)
+
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("set interface trace-sample pg0 every 10")
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
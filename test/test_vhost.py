@@ -3,6 +3,7 @@
 import unittest
 
 from framework import VppTestCase, VppTestRunner
+from vpp_papi_provider import CliFailedCommandError
 
 from vpp_vhost_interface import VppVhostInterface
 
@@ -119,5 +120,79 @@ class TesVhostInterface(VppTestCase):
         events = self.vapi.collect_events()
         self.assert_equal(len(events), 0, "number of events")
 
+    def test_vhost_packed(self):
+        """ Vhost User packed ring negotiation test """
+        split_if = VppVhostInterface(self, sock_filename='/tmp/sock1')
+        split_if.add_vpp_config()
+        packed_if = VppVhostInterface(self, sock_filename='/tmp/sock2',
+                                      packed=1)
+        packed_if.add_vpp_config()
+
+        # only the interface created with packed offers the packed ring
+        out = self.vapi.cli("show vhost-user %s" % packed_if.name)
+        self.assertIn("Packed ring enable", out)
+        out = self.vapi.cli("show vhost-user %s" % split_if.name)
+        self.assertNotIn("Packed ring enable", out)
+
+        # the option survives a modify
+        self.vapi.modify_vhost_user_if(sw_if_index=packed_if.sw_if_index,
+                                       sock_filename='/tmp/sock2',
+                                       enable_packed=1)
+        out = self.vapi.cli("show vhost-user %s" % packed_if.name)
+        self.assertIn("Packed ring enable", out)
+        self.vapi.modify_vhost_user_if(sw_if_index=packed_if.sw_if_index,
+                                       sock_filename='/tmp/sock2')
+        out = self.vapi.cli("show vhost-user %s" % packed_if.name)
+        self.assertNotIn("Packed ring enable", out)
+
+        packed_if.remove_vpp_config()
+        split_if.remove_vpp_config()
+
+    def test_vhost_coalesce(self):
+        """ Vhost User fixed and adaptive call coalescing test """
+        vhost_if = VppVhostInterface(self, sock_filename='/tmp/sock1')
+        vhost_if.add_vpp_config()
+
+        # fixed coalescing unless asked for
+        self.assertIn("fixed coalescing", self.vapi.cli("show vhost-user"))
+        reply = self.vapi.cli("test vhost-user coalesce")
+        self.assertIn("vhost-user coalesce: ok", reply)
+
+        self.vapi.cli("set vhost-user coalesce adaptive frames-max 128")
+        out = self.vapi.cli("show vhost-user")
+        self.assertIn("adaptive coalescing, max frames 128", out)
+        self.assertIn("coalesce frames 32", out)
+        self.vapi.cli("set vhost-user coalesce fixed")
+        self.assertIn("fixed coalescing", self.vapi.cli("show vhost-user"))
+
+        for cmd in ["set vhost-user coalesce",
+                    "set vhost-user coalesce adaptive frames-max 1"]:
+            with self.assertRaises(CliFailedCommandError):
+                self.vapi.cli(cmd)
+
+        vhost_if.remove_vpp_config()
+
+
+class TestVhostPlacement(VppTestCase):
+    """Vhost User Rx Queue Placement Test Case
+
+    """
+    worker_config = "workers 2"
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVhostPlacement, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestVhostPlacement, cls).tearDownClass()
+
+    def test_vhost_placement(self):
+        """ Vhost User numa and load aware rx placement test """
+        self.assertIn("rx placement: numa", self.vapi.cli("show vhost-user"))
+        reply = self.vapi.cli("test vhost-user placement")
+        self.assertIn("vhost-user placement: ok", reply)
+
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -110,6 +110,46 @@ class TestVlib(VppTestCase):
                 else:
                     self.logger.info(cmd + " FAIL retval " + str(r.retval))
 
+    def test_vlib_node_histograms(self):
+        """ Vlib per-node dispatch histograms """
+
+        self.vapi.node_histogram_enable_disable(enable=True)
+        self.vapi.cli("loopback create")
+        self.vapi.cli("packet-generator new {\n"
+                      " name histogram\n"
+                      " limit 100\n"
+                      " size 128-128\n"
+                      " interface loop0\n"
+                      " node ethernet-input\n"
+                      " data {\n"
+                      "   IP6: 00:d0:2d:5e:86:85 -> 00:0d:ea:d0:00:00\n"
+                      "   ICMP: db00::1 -> db00::2\n"
+                      "   incrementing 30\n"
+                      "   }\n"
+                      "}\n")
+        self.vapi.cli("packet-generator enable-stream histogram")
+
+        details = self.vapi.node_histogram_dump(thread_index=0)
+        names = [d.node_name for d in details]
+        self.assertIn("ethernet-input", names)
+        for d in details:
+            self.assertEqual(d.thread_index, 0)
+            self.assertEqual(sum(d.clocks), sum(d.vectors))
+            if d.node_name == "ethernet-input":
+                self.assertGreater(sum(d.vectors), 0)
+
+        reply = self.vapi.cli("show runtime histogram ethernet-input")
+        self.assertIn("vectors per call", reply)
+
+        self.vapi.cli("clear runtime")
+        details = self.vapi.node_histogram_dump(thread_index=0)
+        self.assertEqual(len(details), 0)
+
+        self.vapi.node_histogram_enable_disable(enable=False)
+        details = self.vapi.node_histogram_dump()
+        self.assertEqual(len(details), 0)
+        self.vapi.cli("packet-generator delete histogram")
+
     def test_vlib_buffer_c_unittest(self):
         """ Vlib buffer.c Code Coverage Test """
 
@@ -182,5 +222,39 @@ class TestVlib(VppTestCase):
                 else:
                     self.logger.info(cmd + " FAIL retval " + str(r.retval))
 
+
+class TestVlibRcu(VppTestCase):
+    """ Vlib RCU Test Cases """
+    worker_config = "workers 2"
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVlibRcu, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestVlibRcu, cls).tearDownClass()
+
+    def test_vlib_rcu(self):
+        """ Vlib RCU publish/quiesce Test """
+
+        # the test runs in a process, outside of the API barrier
+        reply = self.vapi.cli("test vlib rcu callbacks 1000")
+        self.assertIn("RCU test: started", reply)
+        for i in range(50):
+            reply = self.vapi.cli("test vlib rcu result")
+            if "running" not in reply:
+                break
+            self.sleep(0.1)
+
+        # with the workers running, all but the callback queued under
+        # the barrier waited for a grace period
+        self.assertIn("RCU test: 2001 callbacks, 2000 deferred", reply)
+
+        reply = self.vapi.cli("show vlib rcu")
+        self.assertRegex(reply, r"epoch \d+, 0 callbacks pending")
+        self.assertEqual(reply.count("quiescent epoch"), 2)
+
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
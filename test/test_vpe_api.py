@@ -12,9 +12,11 @@
 #  See the License for the specific language governing permissions and
 #  limitations under the License.
 import datetime
+import struct
 import time
 import unittest
 from framework import VppTestCase
+from vpp_ip_route import VppRoutePath, find_route
 
 enable_print = False
 
@@ -53,3 +55,76 @@ class TestVpeApi(VppTestCase):
             print('\n'.join([str(v) for v in rv]))
             print('%r %s' % (rv.vpe_system_time,
                              rv.vpe_system_time))
+
+    def _batch_msg(self, name, **kwargs):
+        """ Pack one length-prefixed message for a msg_batch """
+        vpp = self.vapi.vpp
+        msgdef = vpp.messages[name]
+        kwargs['_vl_msg_id'] = vpp.transport.get_msg_index(
+            name + '_' + msgdef.crc[2:])
+        kwargs['client_index'] = 0
+        kwargs['context'] = len(self.batch) + 1
+        b = msgdef.pack(kwargs)
+        self.batch.append(struct.pack('>I', len(b)) + b)
+
+    def _batch_route(self, addr, is_add=1, table_id=0):
+        path = VppRoutePath("10.10.10.10", 0xffffffff).encode()
+        self._batch_msg('ip_route_add_del',
+                        is_add=is_add,
+                        route={'table_id': table_id,
+                               'prefix': '%s/32' % addr,
+                               'n_paths': 1,
+                               'paths': [path]})
+
+    def _send_batch(self, stop_on_error=False):
+        data = b''.join(self.batch)
+        rv = self.vapi.msg_batch(stop_on_error=stop_on_error,
+                                 n_msgs=len(self.batch),
+                                 data_len=len(data),
+                                 data=data)
+        self.batch = []
+        return rv
+
+    def test_msg_batch(self):
+        """ Batched API messages """
+        n_routes = 100
+
+        self.batch = []
+        for i in range(n_routes):
+            self._batch_route('11.0.%d.%d' % (i // 256, i % 256))
+        rv = self._send_batch()
+        self.assertEqual(rv.retval, 0)
+        self.assertEqual(rv.n_processed, n_routes)
+        self.assertEqual(rv.retvals, [0] * n_routes)
+        for i in range(n_routes):
+            self.assertTrue(find_route(self, '11.0.%d.%d' %
+                                       (i // 256, i % 256), 32))
+
+        # a route in a table that does not exist fails; the rest of
+        # the batch is skipped when asked to stop on error
+        self._batch_route('11.0.0.0', is_add=0)
+        self._batch_route('12.0.0.0', table_id=1234)
+        self._batch_route('11.0.0.1', is_add=0)
+        with self.vapi.assert_negative_api_retval():
+            rv = self._send_batch(stop_on_error=True)
+        self.assertNotEqual(rv.retval, 0)
+        self.assertEqual(rv.n_processed, 2)
+        self.assertEqual(rv.n_msgs, 2)
+        self.assertEqual(len(rv.retvals), 2)
+        self.assertEqual(rv.retvals[0], 0)
+        self.assertEqual(rv.retvals[1], rv.retval)
+        self.assertFalse(find_route(self, '11.0.0.0', 32))
+        self.assertTrue(find_route(self, '11.0.0.1', 32))
+
+        # batches do not nest
+        self._batch_msg('msg_batch', n_msgs=0, data_len=0, data=b'')
+        with self.vapi.assert_negative_api_retval():
+            rv = self._send_batch()
+        self.assertEqual(rv.retval, -7)
+        self.assertEqual(rv.n_processed, 0)
+
+        for i in range(1, n_routes):
+            self._batch_route('11.0.%d.%d' % (i // 256, i % 256), is_add=0)
+        rv = self._send_batch()
+        self.assertEqual(rv.retval, 0)
+        self.assertFalse(find_route(self, '11.0.0.1', 32))
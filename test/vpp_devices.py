@@ -8,10 +8,13 @@ class VppTAPInterface(VppInterface):
         """TAP id"""
         return self._tap_id
 
-    def __init__(self, test, tap_id=0xffffffff, mac_addr=None):
+    def __init__(self, test, tap_id=0xffffffff, mac_addr=None,
+                 num_rx_queues=1, tap_flags=0):
         self._test = test
         self._tap_id = tap_id
         self._mac_addr = mac_addr
+        self._num_rx_queues = num_rx_queues
+        self._tap_flags = tap_flags
 
     def get_vpp_dump(self):
         dump = self._test.vapi.sw_interface_tap_v2_dump()
@@ -24,7 +27,9 @@ class VppTAPInterface(VppInterface):
         reply = self._test.vapi.tap_create_v2(
             id=self._tap_id,
             use_random_mac=use_random_mac,
-            mac_address=self._mac_addr)
+            mac_address=self._mac_addr,
+            num_rx_queues=self._num_rx_queues,
+            tap_flags=self._tap_flags)
         self.set_sw_if_index(reply.sw_if_index)
         self._test.registry.register(self, self.test.logger)
 
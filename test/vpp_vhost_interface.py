@@ -6,8 +6,8 @@ class VppVhostInterface(VppInterface):
 
     def __init__(self, test, sock_filename, is_server=0, renumber=0,
                  disable_mrg_rxbuf=0, disable_indirect_desc=0, gso=0,
-                 custom_dev_instance=0, use_custom_mac=0, mac_address='',
-                 tag=''):
+                 packed=0, custom_dev_instance=0, use_custom_mac=0,
+                 mac_address='', tag=''):
 
         """ Create VPP Vhost interface """
         super(VppVhostInterface, self).__init__(test)
@@ -17,22 +17,25 @@ class VppVhostInterface(VppInterface):
         self.disable_mrg_rxbuf = disable_mrg_rxbuf
         self.disable_indirect_desc = disable_indirect_desc
         self.gso = gso
+        self.packed = packed
         self.custom_dev_instance = custom_dev_instance
         self.use_custom_mac = use_custom_mac
         self.mac_address = mac_address
         self.tag = tag
 
     def add_vpp_config(self):
-        r = self.test.vapi.create_vhost_user_if(self.is_server,
-                                                self.sock_filename,
-                                                self.renumber,
-                                                self.disable_mrg_rxbuf,
-                                                self.disable_indirect_desc,
-                                                self.gso,
-                                                self.custom_dev_instance,
-                                                self.use_custom_mac,
-                                                self.mac_address,
-                                                self.tag)
+        r = self.test.vapi.create_vhost_user_if(
+            is_server=self.is_server,
+            sock_filename=self.sock_filename,
+            renumber=self.renumber,
+            disable_mrg_rxbuf=self.disable_mrg_rxbuf,
+            disable_indirect_desc=self.disable_indirect_desc,
+            enable_gso=self.gso,
+            enable_packed=self.packed,
+            custom_dev_instance=self.custom_dev_instance,
+            use_custom_mac=self.use_custom_mac,
+            mac_address=self.mac_address,
+            tag=self.tag)
         self.set_sw_if_index(r.sw_if_index)
 
     def remove_vpp_config(self):